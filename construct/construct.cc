@@ -20,6 +20,7 @@
 bool printversion;
 bool cmdline;
 std::vector<std::string> execute;
+std::vector<std::string> tenant;
 bool quietmode;
 bool single;
 bool safemode;
@@ -60,6 +61,7 @@ lgetopt opts[]
 	{ "safe",       &safemode,      lgetopt::BOOL,    "Safe mode; like -single but with even less functionality." },
 	{ "console",    &cmdline,       lgetopt::BOOL,    "Drop to a command line immediately after startup" },
 	{ "execute",    &execute,       lgetopt::STRINGS, "Execute command lines immediately after startup" },
+	{ "tenant",     &tenant,        lgetopt::STRINGS, "Host an additional homeserver <origin>[=servername] in this process" },
 	{ "nolisten",   &nolisten,      lgetopt::BOOL,    "Normal execution but without listening sockets" },
 	{ "nobackfill", &nobackfill,    lgetopt::BOOL,    "Disable initial backfill jobs after startup." },
 	{ "noautoapps", &noautoapps,    lgetopt::BOOL,    "Disable automatic execution of managed child applications." },
@@ -191,9 +193,26 @@ noexcept try
 	opts.bootstrap_vector_path = bootstrap;
 	opts.backfill = !nobackfill;
 	opts.autoapps = !noautoapps;
+
+	// Additional homeservers hosted by this process. These share the database,
+	// caches and federation links of the primary homeserver above.
+	std::vector<struct ircd::m::homeserver::opts> tenant_opts(tenant.size());
+	for(size_t i(0); i < tenant.size(); ++i)
+	{
+		const auto &[origin, server_name]
+		{
+			ircd::split(tenant[i], '=')
+		};
+
+		tenant_opts[i].origin = origin;
+		tenant_opts[i].server_name = server_name?: origin;
+		tenant_opts[i].backfill = false;
+		tenant_opts[i].autoapps = false;
+	}
+
 	const std::function<void (ircd::main_continuation)> homeserver
 	{
-		[&opts](const ircd::main_continuation &main)
+		[&opts, &tenant_opts](const ircd::main_continuation &main)
 		{
 			// Load the matrix module
 			ircd::matrix matrix;
@@ -204,6 +223,12 @@ noexcept try
 				matrix, opts
 			};
 
+			// Construct any tenants after the primary; they go out of service
+			// before it.
+			std::list<construct::homeserver> tenants;
+			for(const auto &opts : tenant_opts)
+				tenants.emplace_back(matrix, opts);
+
 			// Bail for debug/testing purposes.
 			if(nomain)
 				return;
@@ -27,6 +27,8 @@ namespace ircd::allocator
 	template<class T = char, size_t = 512> struct fixed;
 	template<class T = char, size_t L0_SIZE = 512> struct twolevel;
 	template<class T> struct node;
+	struct arena;
+	struct hugetlb;
 
 	size_t rlimit_as();
 	size_t rlimit_data();
@@ -56,6 +58,8 @@ namespace ircd::allocator
 /// interface has different functionality when je::available.
 namespace ircd::allocator::je
 {
+	struct arena;
+
 	extern const bool available;
 }
 
@@ -91,6 +95,71 @@ struct ircd::allocator::profile
 	static thread_local profile this_thread;
 };
 
+/// Dedicated jemalloc arena for a subsystem, keeping its allocations apart
+/// from those of others so long-lived and short-lived objects don't fragment
+/// each other and so the resident memory of each can be observed. Allocations
+/// on the thread are directed to the arena for the lifetime of an instance of
+/// arena::scope. The selection is tracked in `current` so each ctx carries its
+/// own selection across yields rather than leaking it to the next context.
+/// Without jemalloc every arena is the default and scopes have no effect.
+struct ircd::allocator::je::arena
+{
+	struct scope;
+
+	static arena db, json, media;
+	static std::vector<arena *> list;
+	static thread_local unsigned current;
+
+	string_view name;
+	unsigned id {0};
+	uint64_t allocated {0};
+	uint64_t active {0};
+	uint64_t resident {0};
+
+	static void select(const unsigned &id) noexcept;
+	static void refresh() noexcept;
+
+	arena(const string_view &name);
+	arena(arena &&) = delete;
+	arena(const arena &) = delete;
+	~arena() noexcept;
+};
+
+struct ircd::allocator::je::arena::scope
+{
+	unsigned theirs;
+
+  public:
+	scope(const arena &);
+	scope(scope &&) = delete;
+	scope(const scope &) = delete;
+	~scope() noexcept;
+};
+
+/// Region of explicit hugepages (see hugetlbpage(7)) reserved from the
+/// kernel's pool when constructed and carved out by bumping a cursor. The
+/// page size must be one configured on the system (i.e. 2 MiB or 1 GiB) and
+/// the pages must have been reserved by the administrator (vm.nr_hugepages)
+/// or construction throws. Nothing carved out is ever returned to the region;
+/// users are expected to recycle what they carve. An allocation which does
+/// not fit returns nullptr so the user can fall back to normal pages.
+struct ircd::allocator::hugetlb
+{
+	size_t page_size {0};
+	mutable_buffer region;
+	std::atomic<size_t> used {0};
+
+  public:
+	size_t avail() const noexcept;
+	bool has(const void *const &) const noexcept;
+	void *allocate(const size_t &size, const size_t &alignment = 0) noexcept;
+
+	hugetlb(const size_t &page_size, const size_t &size);
+	hugetlb(hugetlb &&) = delete;
+	hugetlb(const hugetlb &) = delete;
+	~hugetlb() noexcept;
+};
+
 /// This object hooks and replaces global ::malloc() and family for the
 /// lifetime of the instance, redirecting those calls to the user's provided
 /// callbacks. This functionality may not be available on all platforms so it
@@ -763,6 +832,111 @@ allocator()
 	return ircd::allocator::twolevel<T, L0_SIZE>::allocator(*this);
 }
 
+/// Region (bump) allocator for memory which lives and dies together, like
+/// everything composed while handling one request. Allocations are carved
+/// sequentially out of large blocks and are never individually released;
+/// all of it is released at once by reset(). After a reset the blocks up to
+/// the retain amount are kept to be reused by the next region, so a client
+/// making requests over a persistent connection stops allocating at all once
+/// its working set has been seen.
+///
+/// Use the arena directly for buffers (in place of unique_buffer) or specify
+/// arena::allocator for std:: containers and strings.
+///
+struct ircd::allocator::arena
+{
+	template<class T = char> struct allocator;
+
+	std::vector<unique_mutable_buffer> blocks;
+	size_t block_size {0};
+	size_t retain {0};
+	size_t cur {0};                    // index of the block being carved
+	size_t pos {0};                    // offset in the block being carved
+	size_t used {0};                   // bytes handed out since reset()
+
+  public:
+	size_t capacity() const noexcept;
+
+	mutable_buffer allocate(const size_t &size, const size_t &align = alignof(std::max_align_t));
+	mutable_buffer operator()(const size_t &size, const size_t &align = alignof(std::max_align_t));
+	void reset() noexcept;
+
+	arena(const size_t &block_size = 64 * 1024UL, const size_t &retain = 256 * 1024UL);
+	arena(arena &&) = default;
+	arena(const arena &) = delete;
+	arena &operator=(arena &&) = default;
+	arena &operator=(const arena &) = delete;
+	~arena() noexcept;
+};
+
+/// The template passed to containers for drawing from an arena. Deallocation
+/// is a no-op; the memory goes back when the arena is reset.
+///
+template<class T>
+struct ircd::allocator::arena::allocator
+{
+	using value_type         = T;
+	using pointer            = T *;
+	using const_pointer      = const T *;
+	using reference          = T &;
+	using const_reference    = const T &;
+	using size_type          = std::size_t;
+	using difference_type    = std::ptrdiff_t;
+
+	arena *s;
+
+  public:
+	template<class U> struct rebind
+	{
+		using other = typename arena::allocator<U>;
+	};
+
+	size_type max_size() const                   { return std::numeric_limits<size_t>::max();      }
+	auto address(reference x) const              { return &x;                                      }
+	auto address(const_reference x) const        { return &x;                                      }
+
+	pointer
+	__attribute__((malloc, returns_nonnull, warn_unused_result))
+	allocate(const size_type &n, const const_pointer &hint = nullptr)
+	{
+		assert(s);
+		return reinterpret_cast<pointer>(data(s->allocate(n * sizeof(T), alignof(T))));
+	}
+
+	void deallocate(const pointer &p, const size_type &n)
+	{
+	}
+
+	template<class U>
+	allocator(const arena::allocator<U> &s) noexcept
+	:s{s.s}
+	{}
+
+	allocator(arena &s) noexcept
+	:s{&s}
+	{}
+
+	allocator(allocator &&) = default;
+	allocator(const allocator &) = default;
+
+	friend bool operator==(const allocator &a, const allocator &b)
+	{
+		return a.s == b.s;
+	}
+
+	friend bool operator!=(const allocator &a, const allocator &b)
+	{
+		return a.s != b.s;
+	}
+};
+
+inline ircd::mutable_buffer
+ircd::allocator::arena::operator()(const size_t &size,
+                                   const size_t &align)
+{
+	return allocate(size, align);
+}
+
 template<class T>
 inline T
 ircd::allocator::set(const string_view &var,
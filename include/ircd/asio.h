@@ -40,6 +40,15 @@ namespace boost
 }
 #endif
 
+// Network I/O is submitted to io_uring rather than the epoll reactor; asio
+// batches the submissions of each pass of the event loop. This must agree
+// across all units, so it is only set here. The epoll_wait(2) hook in
+// ios/epoll.h has no effect in this configuration.
+#if defined(IRCD_USE_ASIO_IOU) && BOOST_VERSION >= 107800
+	#define BOOST_ASIO_HAS_IO_URING
+	#define BOOST_ASIO_DISABLE_EPOLL
+#endif
+
 // Needed for consistent interop with std::system_error
 #include <boost/system/system_error.hpp>
 
@@ -19,12 +19,21 @@ namespace ircd::cbor
 	IRCD_EXCEPTION(error, type_error);
 	IRCD_EXCEPTION(error, parse_error);
 	IRCD_EXCEPTION(parse_error, buffer_underrun);
+	IRCD_EXCEPTION(error, buffer_overrun);
 
 	enum major :uint8_t;
 	enum minor :uint8_t;
 
 	string_view reflect(const enum major &);
 
+	// Transcode JSON into CBOR. Object members are written in canonical
+	// (sorted) order with definite lengths and the shortest heads, so
+	// equivalent JSON always produces the same CBOR.
+	const_buffer encode(const mutable_buffer &out, const string_view &json);
+
+	// Transcode CBOR into JSON. The CBOR produced by encode() is emitted
+	// as canonical JSON.
+	string_view stringify(const mutable_buffer &out, const const_buffer &cbor);
 }
 
 /// RFC7049 Major type codes
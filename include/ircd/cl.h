@@ -32,6 +32,10 @@ namespace ircd::cl
 
 	void flush();
 	void sync();
+
+	// Hashes each input into the next digest_size bytes of the output on the
+	// device; false when there's no device or the batch is below the minimum.
+	bool sha256(const mutable_buffer &out, const vector_view<const const_buffer> &in);
 }
 
 /// cl_event wrapping
@@ -129,4 +133,5 @@ struct ircd::cl::init
 #ifndef IRCD_USE_OPENCL
 inline ircd::cl::init::init() {}
 inline ircd::cl::init::~init() noexcept {}
+inline bool ircd::cl::sha256(const mutable_buffer &, const vector_view<const const_buffer> &) { return false; }
 #endif
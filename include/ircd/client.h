@@ -32,6 +32,7 @@ struct ircd::client
 	struct conf;
 	struct settings;
 	struct request;
+	struct h2c;
 
 	static log::log log;
 	static struct settings settings;
@@ -48,6 +49,7 @@ struct ircd::client
 	static void close_all();
 	static void wait_all();
 	static void spawn();
+	static void resume(std::shared_ptr<client>, std::function<bool (client &)>);
 
 	struct conf *conf {&default_conf};
 	unique_buffer<mutable_buffer> head_buffer;
@@ -61,7 +63,11 @@ struct ircd::client
 	ircd::timer timer;
 	size_t head_length {0};
 	size_t content_consumed {0};
+	bool parked {false};
+	uint32_t stream_id {0};           // nonzero for a stream of an h2 session
+	std::shared_ptr<h2c> h2;          // http/2 session of connection or stream
 	resource::request request;
+	allocator::arena arena;           // request-scoped; reset() after each
 
 	string_view loghead() const;
 	size_t write_all(const net::const_buffers &);
@@ -75,6 +81,7 @@ struct ircd::client
 	bool main();
 	bool async();
 
+	client(std::shared_ptr<h2c>, const uint32_t &stream_id, const const_buffer &request);
 	client(std::shared_ptr<socket>);
 	client(client &&) = delete;
 	client(const client &) = delete;
@@ -112,8 +119,15 @@ struct ircd::client::settings
 {
 	static ircd::conf::item<size_t> stack_size;
 	static ircd::conf::item<size_t> pool_size;
+	static ircd::conf::item<size_t> pool_max;
+	static ircd::conf::item<milliseconds> pool_grow_latency;
 	static ircd::conf::item<size_t> max_client;
 	static ircd::conf::item<size_t> max_client_per_peer;
+	static ircd::conf::item<size_t> http2_streams_max;
+	static ircd::conf::item<size_t> http2_window;
+	static ircd::conf::item<size_t> http2_content_max;
+	static ircd::conf::item<size_t> arena_block_size;
+	static ircd::conf::item<size_t> arena_retain;
 };
 
 struct ircd::client::init
@@ -138,6 +138,9 @@ final
 	void finalize(const mutable_buffer &) override;
 	void update(const const_buffer &) override;
 
+	// Digests of many inputs laid out consecutively in the output.
+	static void batch(const mutable_buffer &out, const vector_view<const const_buffer> &in);
+
 	sha256(const mutable_buffer &, const const_buffer &); // note: finalizes
 	sha256(const const_buffer &); // note: finalizes
 	sha256();
@@ -92,6 +92,7 @@ namespace ircd::ctx
 #include "critical_indicator.h"
 #include "exception_handler.h"
 #include "uninterruptible.h"
+#include "sched.h"
 #include "list.h"
 #include "dock.h"
 #include "latch.h"
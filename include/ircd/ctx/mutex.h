@@ -97,6 +97,11 @@ ircd::ctx::mutex::lock()
 	assert(current);
 	deadlock_assertion();
 
+	const prof::lock::wait profile
+	{
+		this, m, locked()
+	};
+
 	q.wait([this]() noexcept
 	{
 		return !locked();
@@ -119,6 +124,11 @@ ircd::ctx::mutex::try_lock_until(const time_point &tp)
 	assert(current);
 	deadlock_assertion();
 
+	prof::lock::wait profile
+	{
+		this, m, locked()
+	};
+
 	const bool success
 	{
 		q.wait_until(tp, [this]() noexcept
@@ -130,6 +140,7 @@ ircd::ctx::mutex::try_lock_until(const time_point &tp)
 	if(likely(success))
 		m = current;
 
+	profile.acquired = success;
 	return success;
 }
 
@@ -22,7 +22,9 @@ namespace ircd::ctx
 struct ircd::ctx::pool
 {
 	struct opts;
+	struct stats;
 	using closure = std::function<void ()>;
+	using job = std::pair<closure, steady_point>;
 
 	static const string_view default_name;
 	static const opts default_opts;
@@ -31,11 +33,16 @@ struct ircd::ctx::pool
 	const opts *opt {&default_opts};
 	size_t running {0};
 	size_t working {0};
+	size_t grown {0};
 	dock q_max;
-	queue<closure> q;
+	queue<job> q;
 	std::vector<context> ctxs;
+	std::unique_ptr<struct stats> stats;
 
-	void work();
+	bool behind() const;
+	bool grow();
+	void reap();
+	bool work();
 	void main() noexcept;
 
   public:
@@ -114,6 +121,56 @@ struct ircd::ctx::pool::opts
 
 	/// Scheduler priority nice value for contexts in this pool.
 	int8_t nice {0};
+
+	/// Upper bound for the number of contexts when the pool grows on demand.
+	/// When the pool has no available context and the oldest job in the queue
+	/// has waited longer than grow_latency, one more context is spawned, up
+	/// to this limit. The default of 0 disables growth; the pool's size is
+	/// then only what is set by the control panel.
+	size_t ctxs_max {0};
+
+	/// Queue wait time after which the pool grows (see: ctxs_max). A value
+	/// of zero grows the pool as soon as a job has to queue at all.
+	milliseconds grow_latency {50ms};
+
+	/// Contexts spawned by growth exit after idling this long, shrinking the
+	/// pool back toward the size set by the control panel. A value of zero
+	/// retains grown contexts until the pool is resized.
+	milliseconds idle_timeout {30s};
+
+	/// Register an ircd::stats set for this pool under ircd.ctx.pool.<name>.
+	/// The pool's name must be unique among pools which enable this.
+	bool stats {false};
+};
+
+struct ircd::ctx::pool::stats
+{
+	using value_type = uint64_t;
+	using item = ircd::stats::item<value_type *>;
+
+	value_type value[13];
+	size_t items;
+
+  public:
+	item jobs;
+	item active;
+	item idle;
+	item grown;
+	item shrunk;
+	item wait_total;
+	item wait_last;
+	item wait_max;
+	item wait_1ms;
+	item wait_10ms;
+	item wait_100ms;
+	item wait_1s;
+	item wait_inf;
+
+	stats(pool &);
+	stats() = delete;
+	stats(const stats &) = delete;
+	stats &operator=(const stats &) = delete;
+	~stats() noexcept;
 };
 
 template<class F,
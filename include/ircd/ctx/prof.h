@@ -34,6 +34,7 @@ namespace ircd::ctx::prof
 
 	ulong cycles() noexcept;
 	string_view reflect(const event &);
+	void account(const event &, const uint64_t &val = 1) noexcept;
 
 	// totals
 	const ticker &get() noexcept;
@@ -67,6 +68,90 @@ namespace ircd::ctx::prof::settings
 	extern conf::item<ulong> slice_assertion;   // abort() when exceeded (not a signal, must yield)
 }
 
+/// Lock contention profiling. When enabled, each wait to acquire a mutex or
+/// shared_mutex which was already held is recorded for that lock: the count,
+/// total and longest wait, and the names of the contexts which held it while
+/// others waited. Locks given a name with a label are aggregated under that
+/// name; others are identified by their address. Uncontended acquisitions are
+/// not recorded.
+namespace ircd::ctx::prof::lock
+{
+	struct point;
+	struct label;
+	struct wait;
+	using closure = util::function_bool<const point &>;
+
+	bool for_each(const closure &);
+	void clear() noexcept;
+
+	extern conf::item<bool> enable;
+}
+
+/// Profile of waits on one lock (or all locks with the same label).
+struct ircd::ctx::prof::lock::point
+{
+	const void *lock {nullptr};        // last lock recorded
+	std::string name;
+	uint64_t waits {0};
+	uint64_t timeouts {0};
+	nanoseconds total {0ns};
+	nanoseconds max {0ns};
+	std::string max_holder;
+	std::string max_waiter;
+	std::map<std::string, uint64_t, std::less<>> holders;
+};
+
+/// Names a lock for the profile while this object exists; this is declared
+/// next to the lock it names.
+struct ircd::ctx::prof::lock::label
+{
+	const void *lock;
+
+	label(const void *lock, const string_view &name);
+	label(label &&) = delete;
+	label(const label &) = delete;
+	~label() noexcept;
+};
+
+/// Measures a wait to acquire a lock; only active when profiling is enabled
+/// and the lock is held by another at the start of the wait.
+struct ircd::ctx::prof::lock::wait
+{
+	const void *lock {nullptr};
+	steady_point started;
+	bool acquired {true};
+	char holder[48];
+
+	static void start(wait &, const void *const &lock, const ctx *const &holder) noexcept;
+	static void record(const wait &) noexcept;
+
+  public:
+	wait(const void *const &lock, const ctx *const &holder, const bool &contended) noexcept;
+	wait(wait &&) = delete;
+	wait(const wait &) = delete;
+	~wait() noexcept;
+};
+
+inline
+ircd::ctx::prof::lock::wait::wait(const void *const &lock,
+                                  const ctx *const &holder,
+                                  const bool &contended)
+noexcept
+{
+	if(likely(!contended || !enable))
+		return;
+
+	start(*this, lock, holder);
+}
+
+inline
+ircd::ctx::prof::lock::wait::~wait()
+noexcept
+{
+	if(unlikely(lock))
+		record(*this);
+}
+
 /// Profiling events for marking. These are currently used internally at the
 /// appropriate point to mark(): the user of ircd::ctx has no reason to mark()
 /// these events; this interface is not quite developed for general use yet.
@@ -83,6 +168,13 @@ enum class ircd::ctx::prof::event
 	INTERRUPT,     // Current context detects interruption
 	TERMINATE,     // Current context detects termination
 	CYCLES,        // monotonic counter (rdtsc)
+	DB_READS,      // Values read from the database
+	DB_BYTES,      // Bytes of values read from the database
+	DB_PREFETCH,   // Prefetches of the database requested
+	NET_READ,      // Bytes read from sockets
+	NET_WRITE,     // Bytes written to sockets
+	ALLOCS,        // Allocations (when allocator::profile is built)
+	ALLOC_BYTES,   // Bytes allocated (when allocator::profile is built)
 
 	_NUM_
 };
@@ -30,6 +30,7 @@ class ircd::ctx::queue
 	size_t empty() const;
 	size_t size() const;
 	size_t waiting() const;
+	const T &front() const;
 
 	// Consumer interface; waits for item and std::move() it off the queue
 	template<class time_point> T pop_until(time_point&&);
@@ -142,7 +143,7 @@ ircd::ctx::queue<T, A>::pop_for(const duration &dur)
 
 	assert(!q.empty());
 	auto ret(std::move(q.front()));
-	q.pop();
+	q.pop_front();
 	return ret;
 }
 
@@ -170,10 +171,20 @@ ircd::ctx::queue<T, A>::pop_until(time_point&& tp)
 
 	assert(!q.empty());
 	auto ret(std::move(q.front()));
-	q.pop();
+	q.pop_front();
 	return ret;
 }
 
+template<class T,
+         class A>
+const T &
+ircd::ctx::queue<T, A>::front()
+const
+{
+	assert(!q.empty());
+	return q.front();
+}
+
 template<class T,
          class A>
 size_t
@@ -0,0 +1,93 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_CTX_SCHED_H
+
+namespace ircd::ctx
+{
+	enum class sched :int8_t;
+
+	sched sched_class(const ctx &) noexcept;
+	int8_t nice(ctx &, const sched &) noexcept;
+}
+
+namespace ircd::ctx {
+inline namespace this_ctx
+{
+	struct priority;
+}}
+
+/// Scheduling classes. These are expressed as nice-values so any context
+/// can be placed in a class with nice(); the class is the sign of the value.
+///
+/// A background context which is resumed while any interactive context is
+/// queued to resume defers itself once more so the interactive contexts run
+/// first. Every other combination is scheduled in the order of the ios queue.
+enum class ircd::ctx::sched
+:int8_t
+{
+	INTERACTIVE   = -10,   ///< Client requests; latency sensitive.
+	FEDERATION    = 0,     ///< Federation ingest; the default for contexts.
+	BACKGROUND    = 10,    ///< Bulk work: backfill, fetch, rebuilds etc.
+};
+
+/// An instance of priority places the current context in a scheduling
+/// class for the scope, restoring its prior nice-value afterward.
+struct ircd::ctx::this_ctx::priority
+{
+	int8_t theirs;
+
+	priority(const sched &) noexcept;
+	priority(priority &&) = delete;
+	priority(const priority &) = delete;
+	~priority() noexcept;
+};
+
+inline
+ircd::ctx::this_ctx::priority::priority(const sched &ours)
+noexcept
+:theirs
+{
+	nice(cur())
+}
+{
+	nice(cur(), ours);
+}
+
+inline
+ircd::ctx::this_ctx::priority::~priority()
+noexcept
+{
+	nice(cur(), theirs);
+}
+
+inline int8_t
+ircd::ctx::nice(ctx &ctx,
+                const sched &sched)
+noexcept
+{
+	return nice(ctx, int8_t(sched));
+}
+
+inline ircd::ctx::sched
+ircd::ctx::sched_class(const ctx &ctx)
+noexcept
+{
+	const auto &val
+	{
+		nice(ctx)
+	};
+
+	return
+		val < 0? sched::INTERACTIVE:
+		val > 0? sched::BACKGROUND:
+		         sched::FEDERATION;
+}
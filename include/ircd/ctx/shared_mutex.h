@@ -274,6 +274,11 @@ inline void
 ircd::ctx::shared_mutex::lock_upgrade()
 {
 	assert(current);
+	const prof::lock::wait profile
+	{
+		this, u, !can_lock_upgrade()
+	};
+
 	q.wait([this]
 	{
 		return can_lock_upgrade();
@@ -285,6 +290,11 @@ ircd::ctx::shared_mutex::lock_upgrade()
 inline void
 ircd::ctx::shared_mutex::lock_shared()
 {
+	const prof::lock::wait profile
+	{
+		this, u, !can_lock_shared()
+	};
+
 	q.wait([this]
 	{
 		return can_lock_shared();
@@ -297,6 +307,11 @@ inline void
 ircd::ctx::shared_mutex::lock()
 {
 	assert(current);
+	const prof::lock::wait profile
+	{
+		this, u, !can_lock()
+	};
+
 	q.wait([this]
 	{
 		return can_lock();
@@ -332,6 +347,11 @@ inline bool
 ircd::ctx::shared_mutex::try_lock_upgrade_until(time_point&& tp)
 {
 	assert(current);
+	prof::lock::wait profile
+	{
+		this, u, !this->can_lock_upgrade()
+	};
+
 	const bool can_lock_upgrade
 	{
 		q.wait_until(tp, [this]
@@ -343,6 +363,7 @@ ircd::ctx::shared_mutex::try_lock_upgrade_until(time_point&& tp)
 	if(can_lock_upgrade)
 		u = current;
 
+	profile.acquired = can_lock_upgrade;
 	return can_lock_upgrade;
 }
 
@@ -351,6 +372,11 @@ inline bool
 ircd::ctx::shared_mutex::try_lock_shared_until(time_point&& tp)
 {
 	assert(current);
+	prof::lock::wait profile
+	{
+		this, u, !this->can_lock_shared()
+	};
+
 	const bool can_lock_shared
 	{
 		q.wait_until(tp, [this]
@@ -362,6 +388,7 @@ ircd::ctx::shared_mutex::try_lock_shared_until(time_point&& tp)
 	if(can_lock_shared)
 		++s;
 
+	profile.acquired = can_lock_shared;
 	return can_lock_shared;
 }
 
@@ -370,6 +397,11 @@ inline bool
 ircd::ctx::shared_mutex::try_lock_until(time_point&& tp)
 {
 	assert(current);
+	prof::lock::wait profile
+	{
+		this, u, !this->can_lock()
+	};
+
 	const bool can_lock
 	{
 		q.wait_until(tp, [this]
@@ -384,6 +416,7 @@ ircd::ctx::shared_mutex::try_lock_until(time_point&& tp)
 		s = std::numeric_limits<decltype(s)>::min();
 	}
 
+	profile.acquired = can_lock;
 	return can_lock;
 }
 
@@ -18,6 +18,7 @@ namespace ircd::db
 	using columns = vector_view<column>;
 	using keys = vector_view<const string_view>;
 	using bufs = vector_view<mutable_buffer>;
+	using read_closure = std::function<void (const size_t &, const string_view &, const bool &)>;
 
 	// Information about a column
 	uint32_t id(const column &) noexcept;
@@ -70,6 +71,11 @@ namespace ircd::db
 	uint64_t read(const columns &, const keys &, const bufs &, const gopts & = {});
 	uint64_t read(column &, const keys &, const bufs &, const gopts & = {});
 
+	// [GET] Parallel query of any number of keys; the closure is called for
+	// each key in order with its position, value and existential. The value
+	// is only valid for the duration of the call. Returns number found.
+	size_t read(const columns &, const keys &, const read_closure &, const gopts & = {});
+
 	// [SET] Write data to the db
 	void write(column &, const string_view &key, const const_buffer &value, const sopts & = {});
 
@@ -19,8 +19,13 @@ namespace ircd::db
 	extern conf::item<std::string> open_recover;
 	extern conf::item<bool> open_repair;
 	extern conf::item<bool> open_slave;
+	extern conf::item<std::string> open_slave_path;
+	extern conf::item<size_t> open_warmup;
 	extern conf::item<bool> auto_compact;
 	extern conf::item<bool> auto_deletion;
+	extern conf::item<size_t> memtable_hugetlb;
+	extern conf::item<size_t> backup_rate;
+	extern conf::item<size_t> backup_buffer;
 
 	// General information
 	const std::string &name(const database &);
@@ -35,6 +40,10 @@ namespace ircd::db
 	options getopt(const database &);
 	log::level loglevel(const database &);
 
+	// Write stall conditions; number of columns delayed or stopped.
+	size_t delayed(const database &);
+	size_t stopped(const database &);
+
 	// Property information interface
 	using prop_int = uint64_t;
 	using prop_str = std::string;
@@ -51,6 +60,7 @@ namespace ircd::db
 	void setopt(database &, const string_view &key, const string_view &val);
 	void fdeletions(database &, const bool &enable, const bool &force = false);
 	uint64_t checkpoint(database &);
+	uint64_t backup(database &, const string_view &dir);
 	void bgcancel(database &, const bool &blocking = true);
 	void bgcontinue(database &);
 	void bgpause(database &);
@@ -124,10 +134,14 @@ struct ircd::db::database
 	std::unordered_map<string_view, std::shared_ptr<column>> column_names;
 	std::unique_ptr<rocksdb::DB> d;
 	ctx::mutex write_mutex;
+	ctx::dock sync_dock;
+	uint64_t sync_sequence {0}; // latest sequence made durable by a group sync
+	bool syncing {false};
 	std::vector<std::shared_ptr<column>> column_index; // indexed by cfid
 	std::list<std::shared_ptr<column>> columns; // active only
 	std::string uuid;
 	std::unique_ptr<rocksdb::Checkpoint> checkpointer;
+	std::unique_ptr<context> warmup;
 	std::vector<std::string> errors;
 
 	operator std::shared_ptr<database>()         { return shared_from_this();                      }
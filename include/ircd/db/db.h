@@ -59,6 +59,7 @@ namespace ircd::db
 #include "txn.h"
 #include "prefetcher.h"
 #include "stats.h"
+#include "trace.h"
 
 //
 // Misc utils
@@ -131,4 +131,47 @@ struct ircd::db::descriptor
 	{
 		8192
 	};
+
+	/// Tiered placement of table files. When a path is given, files are kept
+	/// in the database directory until they reach `size` bytes; the oldest
+	/// and largest files of the bottom levels spill to `path` (relative paths
+	/// are rooted in the database directory). When `size` is zero a default
+	/// is chosen from the device holding the database directory. See
+	/// `cf_paths` in rocksdb/options.h.
+	struct tier
+	{
+		std::string path;
+		size_t size {0};
+	}
+	tier;
+
+	/// Compression dictionary. When `size` is non-zero a dictionary of up to
+	/// that many bytes is stored with each table file. For zstd it is trained
+	/// from up to `train` bytes of samples; otherwise raw samples are used.
+	struct compression_dict
+	{
+		size_t size {0};
+		size_t train {0};
+	}
+	compression_dict;
+
+	/// Partitioned (two-level) index and filter blocks. The partitions are
+	/// `meta_block_size` and enter the cache as they are needed rather than
+	/// whole for each table file.
+	bool meta_block_partition {true};
+
+	/// Pin the top-level index of the partitioned index and filter in the
+	/// cache for the life of each table reader so point lookups never miss
+	/// on it. Only the partitions themselves compete for the cache.
+	bool meta_block_pin {false};
+
+	/// Build a ribbon filter in lieu of a bloom filter. The ribbon filter
+	/// has the false positive rate of a bloom filter of `bloom_bits` while
+	/// using about 30% less memory, at more CPU when generating tables.
+	bool bloom_ribbon {false};
+
+	/// User given merge operator. When set, the column accepts op::MERGE
+	/// deltas which are combined with the existing value by this closure,
+	/// allowing values to be updated without reading them first.
+	db::merge_closure merger {};
 };
@@ -21,15 +21,21 @@ struct ircd::db::prefetcher
 	struct ticker;
 	struct request;
 	using closure = std::function<bool (request &)>;
+	using pending_key = std::tuple<const database *, uint32_t, string_view>;
+
+	static conf::item<size_t> batch_max;
 
 	ctx::dock dock;
 	std::deque<request> queue;
+	std::set<pending_key> pending;     // unfinished requests in the queue
 	std::unique_ptr<ticker> ticker;
 	ctx::context context;
 	size_t request_workers {0};
 
 	size_t wait_pending();
-	void request_handle(request &);
+	void request_finish(request &) noexcept;
+	void request_handle(request &, database::column &, std::unique_ptr<rocksdb::Iterator> &);
+	void request_handle(const vector_view<request *> &);
 	size_t request_cleanup() noexcept;
 	void request_worker();
 	void handle();
@@ -84,6 +90,8 @@ struct ircd::db::prefetcher::ticker
 	item<uint64_t> fetches;    ///< Incremented before actual database operation
 	item<uint64_t> fetched;    ///< Incremented after actual database operation
 	item<uint64_t> cancels;    ///< Count of canceled operations
+	item<uint64_t> dedups;     ///< Queries coalesced into a pending request
+	item<uint64_t> batches;    ///< Database operations on one column by one worker
 
 	// throughput totals
 	item<uint64_t> fetched_bytes_key;    ///< Total bytes of key data received
@@ -28,6 +28,8 @@ namespace ircd::db
 /// from when it's acquired.
 struct ircd::db::database::snapshot
 {
+	struct pin;
+
 	std::shared_ptr<const rocksdb::Snapshot> s;
 
   public:
@@ -40,3 +42,25 @@ struct ircd::db::database::snapshot
 	snapshot() = default;
 	~snapshot() noexcept;
 };
+
+/// Pins a snapshot of a database to the current context. While this object
+/// is in scope, reads of the database made by the context which don't specify
+/// their own snapshot observe the database as of the pin; iterators don't
+/// encounter keys written after it. Reads made on behalf of the context by
+/// other contexts (i.e. prefetches) are not affected. Iterators obtained
+/// under the pin must not outlive it.
+struct ircd::db::database::snapshot::pin
+:instance_list<pin>
+{
+	database *d {nullptr};
+	const ctx::ctx *c {nullptr};
+	snapshot s;
+
+  public:
+	static const rocksdb::Snapshot *get(const database &) noexcept;
+
+	pin(database &);
+	pin(const pin &) = delete;
+	pin &operator=(const pin &) = delete;
+	~pin() noexcept;
+};
@@ -0,0 +1,48 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_DB_TRACE_H
+
+/// Opt-in tracing of read latency. When enabled, reads are attributed to
+/// the column, the operation and the name of the calling context, which
+/// usually identifies the subsystem behind the query. Reads slower than a
+/// threshold are logged with a prefix of their key and whether they were
+/// satisfied by the memtable, the block cache or the disk.
+namespace ircd::db::trace
+{
+	struct point;
+	using closure = std::function<bool (const point &)>;
+
+	extern conf::item<bool> enable;
+	extern conf::item<microseconds> slow;
+	extern log::log log;
+
+	bool for_each(const closure &);
+	void clear() noexcept;
+}
+
+/// Latencies of one operation on one column by contexts of one name.
+/// Buckets are powers of two microseconds as in stats::histogram.
+struct ircd::db::trace::point
+{
+	std::string column;
+	string_view op;
+	std::string ctx;
+	std::array<uint64_t, stats::histogram::BUCKETS> bucket {{0}};
+	uint64_t count {0};
+	nanoseconds sum {0ns};
+	nanoseconds max {0ns};
+	uint64_t memtable {0};
+	uint64_t cache {0};
+	uint64_t disk {0};
+
+	microseconds percentile(const double &) const noexcept;
+};
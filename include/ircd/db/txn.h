@@ -28,6 +28,10 @@ namespace ircd::db
 
 	string_view debug(const mutable_buffer &out, const txn &, const ulong &fmt = 0);
 	string_view debug(const mutable_buffer &out, database &, const rocksdb::WriteBatch &, const ulong &fmt = 0);
+
+	// Commit several transactions to the same database as one batch; all
+	// succeed or all fail. The transactions are applied in the given order.
+	void commit(const vector_view<txn *> &, const sopts & = {});
 }
 
 struct ircd::db::txn
@@ -63,6 +63,7 @@ struct ircd::fs::dev::blk
 	std::string scheduler;
 	bool rotational {false};
 	bool merges {false};
+	int numa_node {-1};
 
 	blk(const ulong &id);
 	blk() = default;
@@ -42,6 +42,9 @@ namespace ircd::http
 	const_buffer writechunk(const mutable_buffer &, const uint32_t &size);
 	bool has(const headers &, const string_view &key);
 	bool has(const vector_view<const header> &, const string_view &key);
+
+	// Lifetime of a response from Cache-Control or Expires; -1 if absent.
+	seconds freshness(const headers &) noexcept;
 }
 
 /// HTTP Status classifications.
@@ -323,6 +326,8 @@ struct ircd::http::request::head
 	string_view range;
 	string_view if_range;
 	string_view forwarded_for;
+	string_view accept_encoding;
+	string_view if_none_match;
 	size_t content_length {0};
 
 	string_view uri;       // full view of (path, query, fragmet)
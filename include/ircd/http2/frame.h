@@ -21,6 +21,7 @@ struct ircd::http2::frame
 	struct header;
 	struct settings;
 	enum type :uint8_t;
+	enum class flag :uint8_t;
 
 	static string_view reflect(const type &);
 };
@@ -32,6 +33,13 @@ struct ircd::http2::frame::header
 	uint8_t flags;
 	uint32_t            : 1;
 	uint32_t stream_id  : 31;
+
+	// network byte order
+	const_buffer write(const mutable_buffer &) const;
+
+	header(const enum type &, const uint8_t &flags, const uint32_t &stream_id, const size_t &len);
+	explicit header(const const_buffer &); // network byte order
+	header() = default;
 }
 __attribute__((packed));
 
@@ -49,3 +57,13 @@ enum ircd::http2::frame::type
 	WINDOW_UPDATE  = 0x8,
 	CONTINUATION   = 0x9,
 };
+
+enum class ircd::http2::frame::flag
+:uint8_t
+{
+	END_STREAM     = 0x01,
+	ACK            = 0x01,
+	END_HEADERS    = 0x04,
+	PADDED         = 0x08,
+	PRIORITY       = 0x20,
+};
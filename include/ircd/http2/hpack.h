@@ -0,0 +1,39 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_HTTP2_HPACK_H
+
+/// RFC 7541 header compression. The decoder is complete; the encoder emits
+/// literals without indexing so it never requires a dynamic table of its own
+/// (references into the static table are still made).
+namespace ircd::http2::hpack
+{
+	struct table;
+	using closure = std::function<void (const string_view &, const string_view &)>;
+
+	extern const std::pair<string_view, string_view> static_table[61];
+
+	string_view huffman_decode(const mutable_buffer &out, const const_buffer &in);
+	const_buffer encode(const mutable_buffer &out, const string_view &name, const string_view &value);
+	void decode(table &, const const_buffer &block, const closure &);
+}
+
+/// Dynamic table of the decoder.
+struct ircd::http2::hpack::table
+{
+	std::deque<std::pair<std::string, std::string>> entries;
+	size_t size {0};
+	size_t max {4096};
+
+	std::pair<string_view, string_view> at(const size_t &index) const;
+	void insert(const string_view &name, const string_view &value);
+	void resize(const size_t &max);
+};
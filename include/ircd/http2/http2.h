@@ -15,9 +15,11 @@
 namespace ircd::http2
 {
 	extern const string_view connection_preface;
+	extern const string_view alpn;
 }
 
 #include "error.h"
 #include "frame.h"
 #include "settings.h"
 #include "stream.h"
+#include "hpack.h"
@@ -60,6 +60,8 @@ namespace ircd::info
 	extern const size_t page_size;
 	extern const size_t thp_size;
 	extern const string_view thp_enable;
+	extern const string_view numa_online;
+	extern const size_t numa_nodes;
 	extern const size_t total_ram;
 	extern const size_t total_swap;
 
@@ -124,6 +126,7 @@ namespace ircd::info::hardware::x86
 	extern const string_view vendor;
 	extern const bool sse, sse2, sse3, ssse3, sse4a, sse4_1, sse4_2;
 	extern const bool avx, avx2, avx512f;
+	extern const bool sha;
 	extern const bool tsc, tsc_constant;
 };
 
@@ -32,4 +32,11 @@ namespace ircd::ios::empt
 	extern stats::item<uint64_t *> load_med;
 	extern stats::item<uint64_t *> load_high;
 	extern stats::item<uint64_t *> load_stall;
+
+	extern conf::item<milliseconds> load_interval;
+	extern conf::item<uint64_t> load_ratio;
+
+	// Load level over the last interval; 0 for none, 1 for low, 2 for med,
+	// 3 for high and 4 for stall. Consumers use this to shed optional work.
+	uint load() noexcept;
 }
@@ -121,6 +121,9 @@ namespace ircd
 	// Diagnostic Mode Options
 	extern conf::item<std::string> diagnostic;
 
+	// Main thread placement
+	extern conf::item<std::string> affinity;
+
 	// Restart-Assist
 	extern conf::item<std::string> restart;
 
@@ -39,6 +39,7 @@ namespace ircd::json
 #include "strung.h"
 #include "tuple/tuple.h"
 #include "stack.h"
+#include "scanner.h"
 
 // Convenience toolset for higher level operations.
 namespace ircd::json
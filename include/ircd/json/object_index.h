@@ -0,0 +1,51 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_JSON_OBJECT_INDEX_H
+
+/// Members of a json::object collected by a single iteration so repeated
+/// lookups into the same object don't parse it again each time. The values
+/// are still views into the object; the index is only valid for the life of
+/// that string. Members beyond the capacity are found by a lookup into the
+/// object itself.
+///
+/// This is for the case where a handful of keys are looked up many times,
+/// e.g. the content of an event matched against a user's push rules.
+struct ircd::json::object::index
+{
+	static constexpr const size_t max {32};
+
+	json::object object;
+	std::array<member, max> members;
+	uint count {0};
+	bool partial {false};
+
+	bool has(const string_view &key) const;
+	string_view get(const string_view &key, const string_view &def = {}) const;
+	string_view operator[](const string_view &key) const;
+
+	index(const json::object &);
+	index() = default;
+};
+
+inline ircd::string_view
+ircd::json::object::index::operator[](const string_view &key)
+const
+{
+	return get(key);
+}
+
+inline bool
+ircd::json::object::index::has(const string_view &key)
+const
+{
+	return get(key).data() != nullptr;
+}
@@ -0,0 +1,70 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_JSON_SCANNER_H
+
+namespace ircd::json
+{
+	struct scanner;
+}
+
+/// Incremental tokenizer for JSON which arrives in pieces. This finds each
+/// object element of the arrays which are member values of objects at a
+/// target depth (1 being the top-level object) and presents each to the
+/// user as soon as it has been completely received, without waiting for the
+/// rest of the input. Only structure is tracked here; the elements are not
+/// validated, which is left to the user parsing them (i.e m::event).
+///
+/// The input must be the same contiguous buffer each time, grown by what
+/// has been received since the last call (i.e. the second argument of the
+/// server::in::progress callback). Scanning resumes where it left off.
+///
+struct ircd::json::scanner
+{
+	using closure = std::function<bool (const string_view &key, const json::object &)>;
+
+	static constexpr const uint &depth_max
+	{
+		64
+	};
+
+	uint target {1};                   // depth of the object with the arrays
+	uint depth {0};                    // current depth; 1 inside the top
+	uint64_t object {0};               // depth bit set when object, else array
+	size_t pos {0};                    // bytes of input consumed
+	size_t key[2] {0, 0};              // offsets of the last key at target
+	size_t element {-1UL};             // offset of the element being received
+	bool quote {false};
+	bool escape {false};
+	bool expect_key {false};
+	bool complete {false};             // the top-level value has closed
+
+  public:
+	bool done() const noexcept;
+	size_t operator()(const string_view &input, const closure &);
+
+	scanner(const uint &target = 1);
+};
+
+inline
+ircd::json::scanner::scanner(const uint &target)
+:target{target}
+{
+	assert(target > 0);
+	assert(target + 2 < depth_max);
+}
+
+inline bool
+ircd::json::scanner::done()
+const noexcept
+{
+	return complete;
+}
@@ -14,6 +14,8 @@
 namespace ircd::json
 {
 	struct strung;
+
+	template<class... T> string_view stringify(allocator::arena &, T&&... t);
 }
 
 /// Interface around an allocated std::string of JSON. This is not a
@@ -65,3 +67,25 @@ ircd::json::strung::strung(T&&... t)
 	})
 }
 {}
+
+/// Alternative to json::strung which stringifies into memory drawn from an
+/// arena rather than allocating an std::string. The result is valid until
+/// the arena is reset; for a client::arena that is the end of the request.
+template<class... T>
+inline ircd::string_view
+ircd::json::stringify(allocator::arena &arena,
+                      T&&... t)
+{
+	const mutable_buffer buf
+	{
+		arena(serialized(std::forward<T>(t)...), 1)
+	};
+
+	const auto sv
+	{
+		stringify(mutable_buffer{buf}, std::forward<T>(t)...)
+	};
+
+	debug_valid_output(sv, ircd::size(buf));
+	return sv;
+}
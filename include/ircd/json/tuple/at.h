@@ -82,9 +82,9 @@ template<class tuple,
          class function,
          size_t i>
 constexpr typename std::enable_if<i == size<tuple>(), void>::type
-at(tuple &t,
-   const string_view &name,
-   function&& f)
+_at(tuple &t,
+    const size_t &idx,
+    function&& f)
 noexcept
 {}
 
@@ -92,23 +92,40 @@ template<class tuple,
          class function,
          size_t i = 0>
 inline typename std::enable_if<i < size<tuple>(), void>::type
+_at(tuple &t,
+    const size_t &idx,
+    function&& f)
+{
+	if(idx == i)
+		return f(val<i>(t));
+
+	_at<tuple, function, i + 1>(t, idx, std::forward<function>(f));
+}
+
+template<class tuple,
+         class function>
+inline enable_if_tuple<tuple, void>
 at(tuple &t,
    const string_view &name,
    function&& f)
 {
-	if(indexof<tuple>(name) == i)
-		return f(val<i>(t));
+	// The name is resolved to its index once up front rather than compared
+	// again at each step of the dispatch.
+	const size_t idx
+	{
+		indexof<tuple>(name)
+	};
 
-	at<tuple, function, i + 1>(t, name, std::forward<function>(f));
+	_at<tuple, function>(t, idx, std::forward<function>(f));
 }
 
 template<class tuple,
          class function,
          size_t i>
 constexpr typename std::enable_if<i == size<tuple>(), void>::type
-at(const tuple &t,
-   const string_view &name,
-   function&& f)
+_at(const tuple &t,
+    const size_t &idx,
+    function&& f)
 noexcept
 {}
 
@@ -116,14 +133,29 @@ template<class tuple,
          class function,
          size_t i = 0>
 inline typename std::enable_if<i < size<tuple>(), void>::type
+_at(const tuple &t,
+    const size_t &idx,
+    function&& f)
+{
+	if(idx == i)
+		return f(val<i>(t));
+
+	_at<tuple, function, i + 1>(t, idx, std::forward<function>(f));
+}
+
+template<class tuple,
+         class function>
+inline enable_if_tuple<tuple, void>
 at(const tuple &t,
    const string_view &name,
    function&& f)
 {
-	if(indexof<tuple>(name) == i)
-		return f(val<i>(t));
+	const size_t idx
+	{
+		indexof<tuple>(name)
+	};
 
-	at<tuple, function, i + 1>(t, name, std::forward<function>(f));
+	_at<tuple, function>(t, idx, std::forward<function>(f));
 }
 
 template<class R,
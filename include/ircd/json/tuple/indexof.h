@@ -80,10 +80,82 @@ noexcept
 	return indexof<tuple, i + 1>(name);
 }
 
+/// Compile-time perfect hash of the keys of a tuple. The modulus is the
+/// smallest one (up to a bound) for which every key's name_hash() lands in
+/// its own slot, so a runtime name resolves to its index with one hash and
+/// one string comparison regardless of the number of keys. If no modulus is
+/// found within the bound the table is unused and lookups fall back to the
+/// linear scan.
+template<class tuple>
+struct _key_table
+{
+	static constexpr const size_t keys
+	{
+		size<tuple>()
+	};
+
+	static constexpr const size_t slots_max
+	{
+		keys * 8 + 1
+	};
+
+	static_assert
+	(
+		keys < 256, "uint8_t slot values cannot index this many keys"
+	);
+
+	std::array<name_hash_t, keys> hash {0};
+	std::array<string_view, keys> name;
+	std::array<uint8_t, slots_max> slot {0};
+	size_t mod {0};
+
+	template<size_t... i>
+	constexpr _key_table(std::index_sequence<i...>) noexcept;
+
+	static const _key_table value;
+};
+
+template<class tuple>
+template<size_t... i>
+constexpr
+_key_table<tuple>::_key_table(std::index_sequence<i...>)
+noexcept
+:hash
+{
+	name_hash(key<tuple, i>())...
+}
+,name
+{
+	string_view{key<tuple, i>()}...
+}
+{
+	for(size_t m(keys); m < slots_max && !mod; ++m)
+	{
+		bool collision {false};
+		for(size_t j(0); j < m; ++j)
+			slot[j] = keys;
+
+		for(size_t j(0); j < keys && !collision; ++j)
+		{
+			collision = slot[hash[j] % m] != keys;
+			slot[hash[j] % m] = j;
+		}
+
+		mod = !collision? m : 0;
+	}
+}
+
+template<class tuple>
+constexpr const _key_table<tuple>
+_key_table<tuple>::value
+{
+	std::make_index_sequence<size<tuple>()>()
+};
+
 template<class tuple,
          size_t i>
 constexpr typename std::enable_if<i == size<tuple>(), size_t>::type
-indexof(const string_view &name)
+_indexof(const string_view &name)
 noexcept
 {
 	return size<tuple>();
@@ -92,13 +164,44 @@ noexcept
 template<class tuple,
          size_t i = 0>
 inline constexpr typename std::enable_if<i < size<tuple>(), size_t>::type
-indexof(const string_view &name)
+_indexof(const string_view &name)
 noexcept
 {
 	if(name == key<tuple, i>())
 		return i;
 
-	return indexof<tuple, i + 1>(name);
+	return _indexof<tuple, i + 1>(name);
+}
+
+template<class tuple>
+inline size_t
+indexof(const string_view &name)
+noexcept
+{
+	constexpr const auto &table
+	{
+		_key_table<tuple>::value
+	};
+
+	if constexpr(!table.mod)
+		return _indexof<tuple>(name);
+
+	const auto hash
+	{
+		name_hash(name)
+	};
+
+	const size_t i
+	{
+		table.slot[hash % table.mod]
+	};
+
+	const bool match
+	{
+		i < table.keys && table.hash[i] == hash && table.name[i] == name
+	};
+
+	return match? i : table.keys;
 }
 
 } // namespace json
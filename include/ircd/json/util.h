@@ -36,6 +36,9 @@ namespace ircd::json
 	void valid(const string_view &);
 	std::string why(const string_view &);
 
+	// True if the input is already what stringify() would produce for it.
+	bool canonical(const string_view &) noexcept;
+
 	struct stats extern stats;
 }
 
@@ -26,6 +26,7 @@ namespace ircd::log
 	struct mark;
 	struct console_quiet;
 	struct hook;
+	struct async;
 
 	struct critical;
 	struct error;
@@ -157,6 +158,16 @@ struct ircd::log::console_quiet
 	~console_quiet();
 };
 
+/// Scope device for the writer thread. While an instance exists and
+/// ircd.log.async.enable is set, the messages composed on the main thread are
+/// queued for the writer with its flushes batched; otherwise they are written
+/// by the main thread. This is tied to the main context by ircd::main().
+struct ircd::log::async
+{
+	async();
+	~async() noexcept;
+};
+
 #if RB_LOG_LEVEL >= 7
 struct ircd::log::debug
 {
@@ -24,10 +24,14 @@ namespace ircd::m::dbs
 	extern conf::item<bool> prefetch_enable;
 	extern conf::item<size_t> mem_write_buffer_size;
 	extern conf::item<size_t> sst_write_buffer_size;
+	extern conf::item<size_t> stall_pending_max;
 
 	// Database instance
 	extern std::shared_ptr<db::database> events;
 
+	// Write backpressure indicator for admission control
+	bool stalled() noexcept;
+
 	// [SET (txn)] Basic write suite
 	size_t prefetch(const event &, const write_opts &);
 	size_t write(db::txn &, const event &, const write_opts &);
@@ -53,12 +57,23 @@ namespace ircd::m::dbs::appendix
 #include "event_sender.h"           // sender | event_idx || hostpart | localpart, event_idx
 #include "event_type.h"             // type | event_idx
 #include "event_state.h"            // state_key, type, room_id, depth, event_idx
+#include "event_chain.h"            // event_idx => chain, seq, cover[] || chain, ~seq
+#include "event_relates.h"          // event_idx => (count, latest, rel_type, key)[]
+#include "room_idx.h"               // room_id => room_idx
 #include "room_events.h"            // room_id | depth, event_idx
 #include "room_type.h"              // room_id | type, depth, event_idx
 #include "room_state.h"             // room_id | type, state_key => event_idx
 #include "room_state_space.h"       // room_id | type, state_key, depth, event_idx
 #include "room_joined.h"            // room_id | origin, member => event_idx
 #include "room_head.h"              // room_id | event_id => event_idx
+#include "room_counts.h"            // room_id => int64_t[]
+#include "room_heroes.h"            // room_id => (+|-)user_id\0...
+#include "room_unread.h"            // user_room_id | room_id => int64_t[]
+#include "room_search.h"            // room_id | term, ~bucket => varint[]
+#include "room_threads.h"           // room_id | root_idx => event_idx
+#include "device_inbox.h"           // user_id | device_id, sequence, n => message
+#include "device_one_time_key.h"    // user_id | device_id, algorithm, name => key
+#include "user_room_keys.h"         // user_id | version, room_id, session_id => session
 
 /// Options that affect the dbs::write() of an event to the transaction.
 struct ircd::m::dbs::write_opts
@@ -188,12 +203,44 @@ enum ircd::m::dbs::appendix::index
 
 	/// Take branch to handle room redaction events.
 	ROOM_REDACT,
+
+	/// Involves room_counts table. Counts of events and bytes are merged
+	/// for events entering the room's timeline (ROOM_EVENTS); membership
+	/// counts are merged for changes to the present state (ROOM_JOINED).
+	ROOM_COUNTS,
+
+	/// Involves room_heroes table. Joined and invited members are merged
+	/// into a bounded list for changes to the present state (ROOM_JOINED).
+	ROOM_HEROES,
+
+	/// Involves room_idx table. The room is interned when this is its create
+	/// event and the first event of the room being written.
+	ROOM_IDX,
+
+	/// Involves room_unread table. Push notifications written to a user's
+	/// room increment the counters for the room notified; a present read
+	/// receipt (ROOM_STATE) resets them.
+	ROOM_UNREAD,
+
+	/// Involves event_chain table. State events are placed in the chain
+	/// cover of the auth DAG from the records of their auth_events.
+	EVENT_CHAIN,
+
+	/// Involves room_search table. Terms of the content body, name and
+	/// topic are merged into the posting lists of the room.
+	ROOM_SEARCH,
+
+	/// Involves event_relates table. Relations are aggregated into their
+	/// parent when the M_RELATES reference is made (EVENT_REFS) and removed
+	/// by redaction (ROOM_REDACT). Thread replies also involve room_threads.
+	EVENT_RELATES,
 };
 
 struct ircd::m::dbs::init
 {
 	std::string our_dbpath;
 	std::string their_dbpath;
+	ctx::context warmup;
 
   public:
 	init(const string_view &servername, std::string dbopts = {});
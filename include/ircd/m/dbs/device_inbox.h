@@ -0,0 +1,51 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_DEVICE_INBOX_H
+
+namespace ircd::m::dbs
+{
+	/// Position of a message in the queue of a device: the vm::sequence
+	/// which was next when the message was queued, and a tie-breaker which
+	/// orders messages queued at the same sequence.
+	using device_inbox_pos = std::pair<event::idx, uint64_t>;
+
+	/// Deleting through this position deletes everything queued.
+	constexpr device_inbox_pos device_inbox_pos_max
+	{
+		-1UL, -2UL
+	};
+
+	using device_inbox_closure = std::function<bool (const device_inbox_pos &, const json::object &)>;
+
+	constexpr size_t DEVICE_INBOX_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 + id::MAX_SIZE + 1 + sizeof(event::idx) + sizeof(uint64_t)
+	};
+
+	string_view device_inbox_key(const mutable_buffer &out, const id::user &, const string_view &device_id, const device_inbox_pos &);
+	bool device_inbox_for_each(const id::user &, const string_view &device_id, const device_inbox_closure &);
+	device_inbox_pos device_inbox_put(db::txn &, const id::user &, const string_view &device_id, const json::object &message);
+	void device_inbox_del(const id::user &, const string_view &device_id, const device_inbox_pos &through);
+
+	// user_id | device_id, sequence, n => message
+	extern db::column device_inbox;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> device_inbox__comp;
+	extern conf::item<size_t> device_inbox__block__size;
+	extern conf::item<size_t> device_inbox__meta_block__size;
+	extern conf::item<size_t> device_inbox__cache__size;
+	extern conf::item<size_t> device_inbox__cache_comp__size;
+	extern const db::descriptor device_inbox;
+}
@@ -0,0 +1,43 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_DEVICE_ONE_TIME_KEY_H
+
+namespace ircd::m::dbs
+{
+	using device_one_time_key_closure = std::function<void (const string_view &algorithm, const string_view &name, const string_view &key)>;
+	using device_one_time_key_count_closure = std::function<bool (const string_view &algorithm, const int64_t &count)>;
+
+	constexpr size_t DEVICE_ONE_TIME_KEY_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 + id::MAX_SIZE + 1 + 128 + 1 + 128
+	};
+
+	bool device_one_time_key_count(const id::user &, const string_view &device_id, const device_one_time_key_count_closure &);
+	bool device_one_time_key_put(db::txn &, const id::user &, const string_view &device_id, const string_view &algorithm, const string_view &name, const string_view &key);
+	bool device_one_time_key_pop(const id::user &, const string_view &device_id, const string_view &algorithm, const device_one_time_key_closure &);
+	void device_one_time_key_del(const id::user &, const string_view &device_id);
+
+	// user_id | device_id, algorithm, name => key
+	// user_id | device_id, "", algorithm => int64_t
+	extern db::column device_one_time_key;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> device_one_time_key__comp;
+	extern conf::item<size_t> device_one_time_key__block__size;
+	extern conf::item<size_t> device_one_time_key__meta_block__size;
+	extern conf::item<size_t> device_one_time_key__cache__size;
+	extern conf::item<size_t> device_one_time_key__cache_comp__size;
+	extern const db::merge_closure device_one_time_key__merge;
+	extern const db::descriptor device_one_time_key;
+}
@@ -0,0 +1,59 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_EVENT_CHAIN_H
+
+namespace ircd::m::dbs
+{
+	/// Position of a state event in the chain cover of the auth DAG: the
+	/// chain_id and the sequence number within that chain. Every event in a
+	/// chain reaches all events in the same chain with a lower sequence.
+	using event_chain_pos = std::pair<uint64_t, uint64_t>;
+
+	/// The auth chain of an event as the highest sequence it reaches in each
+	/// chain, sorted by chain_id. An event (chain, seq) is in the auth chain
+	/// iff the cover's sequence for that chain is at least seq.
+	using event_chain_cover = std::vector<event_chain_pos>;
+
+	using event_chain_closure = std::function<bool (const uint64_t &seq, const event::idx &)>;
+
+	constexpr size_t EVENT_CHAIN_KEY_MAX_SIZE
+	{
+		1 + 8 + 8
+	};
+
+	string_view event_chain_key(const mutable_buffer &out, const event::idx &);
+	string_view event_chain_key(const mutable_buffer &out, const uint64_t &chain, const uint64_t &seq);
+
+	bool event_chain_get(event_chain_pos &, event_chain_cover &, const event::idx &);
+	bool event_chain_for_each(const uint64_t &chain, const uint64_t &hi, const uint64_t &lo, const event_chain_closure &);
+	bool event_chain_for_each(const event_chain_cover &hi, const event_chain_cover &lo, const event::closure_idx_bool &);
+	bool event_chain_auth(event_chain_cover &, const event::idx &);
+	event_chain_cover &event_chain_merge(event_chain_cover &, const event_chain_cover &);
+	size_t event_chain_rebuild();
+
+	void _index_event_chain(db::txn &, const event &, const write_opts &);
+
+	// 'e' event_idx => chain_id, seq, complete, cover[]
+	// 'c' chain_id, ~seq => event_idx
+	extern db::column event_chain;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> event_chain__comp;
+	extern conf::item<size_t> event_chain__block__size;
+	extern conf::item<size_t> event_chain__meta_block__size;
+	extern conf::item<size_t> event_chain__cache__size;
+	extern conf::item<size_t> event_chain__cache_comp__size;
+	extern conf::item<bool> event_chain__rebuild;
+	extern const db::descriptor event_chain;
+}
@@ -44,6 +44,8 @@ namespace ircd::m::dbs::desc
 	extern conf::item<size_t> content__cache__size;
 	extern conf::item<size_t> content__cache_comp__size;
 	extern conf::item<size_t> content__file__size__max;
+	extern conf::item<std::string> content__tier__path;
+	extern conf::item<size_t> content__tier__size;
 	extern const db::descriptor content;
 
 	extern conf::item<std::string> depth__comp;
@@ -37,6 +37,8 @@ namespace ircd::m::dbs::desc
 	extern conf::item<size_t> event_horizon__meta_block__size;
 	extern conf::item<size_t> event_horizon__cache__size;
 	extern conf::item<size_t> event_horizon__cache_comp__size;
+	extern conf::item<size_t> event_horizon__bloom__bits;
+	extern conf::item<bool> event_horizon__bloom__ribbon;
 	extern const db::prefix_transform event_horizon__pfx;
 	extern const db::descriptor event_horizon;
 }
@@ -18,13 +18,30 @@ namespace ircd::m::dbs
 	extern db::column event_idx;       // event_id => event_idx
 }
 
+/// Negative cache of event_id's recently found absent from event_idx. Every
+/// write to event_idx clears the event_id and advances the generation; a
+/// miss is only recorded when the generation observed before the query is
+/// still current afterward.
+namespace ircd::m::dbs::event_idx_absent
+{
+	extern conf::item<size_t> max;
+	extern conf::item<seconds> ttl;
+	extern uint64_t generation;
+
+	bool test(const string_view &event_id);
+	bool set(const string_view &event_id, const uint64_t &generation);
+	bool clear(const string_view &event_id);
+}
+
 namespace ircd::m::dbs::desc
 {
 	extern conf::item<std::string> event_idx__comp;
 	extern conf::item<size_t> event_idx__block__size;
 	extern conf::item<size_t> event_idx__meta_block__size;
+	extern conf::item<bool> event_idx__meta_block__pin;
 	extern conf::item<size_t> event_idx__cache__size;
 	extern conf::item<size_t> event_idx__cache_comp__size;
 	extern conf::item<size_t> event_idx__bloom__bits;
+	extern conf::item<bool> event_idx__bloom__ribbon;
 	extern const db::descriptor event_idx;
 }
@@ -28,5 +28,9 @@ namespace ircd::m::dbs::desc
 	extern conf::item<size_t> event_json__cache_comp__size;
 	extern conf::item<size_t> event_json__bloom__bits;
 	extern conf::item<size_t> event_json__file__size__max;
+	extern conf::item<std::string> event_json__tier__path;
+	extern conf::item<size_t> event_json__tier__size;
+	extern conf::item<size_t> event_json__comp__dict__size;
+	extern conf::item<size_t> event_json__comp__dict__train;
 	extern const db::descriptor event_json;
 }
@@ -0,0 +1,60 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_EVENT_RELATES_H
+
+namespace ircd::m::dbs
+{
+	/// One aggregation of the relations to an event in event_relates.
+	struct event_relates_value
+	{
+		int64_t count {0};          // relations presently counted
+		event::idx latest {0};      // greatest event_idx of the relations
+	};
+
+	using event_relates_closure = std::function<bool (const string_view &rel_type, const string_view &key, const event_relates_value &)>;
+
+	/// The rel_type and key of an aggregation are each limited to this size;
+	/// relations exceeding it are not aggregated.
+	constexpr size_t EVENT_RELATES_PART_MAX_SIZE
+	{
+		255
+	};
+
+	/// Distinct aggregations held for one event; relations with a new
+	/// (rel_type, key) beyond this are not aggregated.
+	constexpr size_t EVENT_RELATES_ENTRIES_MAX
+	{
+		512
+	};
+
+	bool event_relates_for_each(const event::idx &, const event_relates_closure &);
+	bool event_relates_get(event_relates_value &, const event::idx &, const string_view &rel_type, const string_view &key = {});
+	size_t event_relates_rebuild();
+
+	void _index_event_relates(db::txn &, const event &, const write_opts &, const event::idx &parent);
+	void _index_event_relates_redact(db::txn &, const event::idx &target, const write_opts &);
+
+	// event_idx => (int64_t, event_idx, rel_type, key)[]
+	extern db::column event_relates;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> event_relates__comp;
+	extern conf::item<size_t> event_relates__block__size;
+	extern conf::item<size_t> event_relates__meta_block__size;
+	extern conf::item<size_t> event_relates__cache__size;
+	extern conf::item<size_t> event_relates__cache_comp__size;
+	extern conf::item<bool> event_relates__rebuild;
+	extern const db::merge_closure event_relates__merge;
+	extern const db::descriptor event_relates;
+}
@@ -0,0 +1,51 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_COUNTS_H
+
+namespace ircd::m::dbs
+{
+	/// Slots of the counter vector for a room in room_counts.
+	enum room_counts_slot :uint8_t
+	{
+		ROOM_COUNTS_EVENTS,         // events in the room's timeline
+		ROOM_COUNTS_BYTES_JSON,     // bytes of event JSON
+		ROOM_COUNTS_JOIN,           // present state membership counts...
+		ROOM_COUNTS_INVITE,
+		ROOM_COUNTS_LEAVE,
+		ROOM_COUNTS_BAN,
+		ROOM_COUNTS_KNOCK,
+		_ROOM_COUNTS_NUM
+	};
+
+	using room_counts_vector = std::array<int64_t, _ROOM_COUNTS_NUM>;
+
+	int room_counts_membership(const string_view &membership) noexcept;
+	bool room_counts_get(room_counts_vector &, const id::room &);
+	size_t room_counts_rebuild();
+
+	void _index_room_counts(db::txn &, const event &, const write_opts &);
+
+	// room_id => int64_t[]
+	extern db::column room_counts;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> room_counts__comp;
+	extern conf::item<size_t> room_counts__block__size;
+	extern conf::item<size_t> room_counts__meta_block__size;
+	extern conf::item<size_t> room_counts__cache__size;
+	extern conf::item<size_t> room_counts__cache_comp__size;
+	extern conf::item<bool> room_counts__rebuild;
+	extern const db::merge_closure room_counts__merge;
+	extern const db::descriptor room_counts;
+}
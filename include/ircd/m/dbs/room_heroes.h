@@ -0,0 +1,38 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_HEROES_H
+
+namespace ircd::m::dbs
+{
+	using room_heroes_closure = std::function<bool (const id::user &)>;
+
+	bool room_heroes_for_each(const id::room &, const room_heroes_closure &);
+	size_t room_heroes_rebuild();
+
+	void _index_room_heroes(db::txn &, const event &, const write_opts &);
+
+	// room_id => (+|-)user_id\0...
+	extern db::column room_heroes;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<size_t> room_heroes__max;
+	extern conf::item<std::string> room_heroes__comp;
+	extern conf::item<size_t> room_heroes__block__size;
+	extern conf::item<size_t> room_heroes__meta_block__size;
+	extern conf::item<size_t> room_heroes__cache__size;
+	extern conf::item<size_t> room_heroes__cache_comp__size;
+	extern conf::item<bool> room_heroes__rebuild;
+	extern const db::merge_closure room_heroes__merge;
+	extern const db::descriptor room_heroes;
+}
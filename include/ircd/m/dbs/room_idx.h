@@ -0,0 +1,53 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_IDX_H
+
+namespace ircd::m::dbs
+{
+	/// Leading byte of a key prefix carrying a room_idx in lieu of the room_id
+	/// string. It can never begin a room_id, which always starts with a sigil.
+	constexpr const char ROOM_KEY_IDX
+	{
+		'\x01'
+	};
+
+	constexpr size_t ROOM_KEY_IDX_SIZE
+	{
+		1 + 8
+	};
+
+	string_view room_key(const mutable_buffer &out, const id::room &, const event::idx &room_idx);
+	string_view room_key(const mutable_buffer &out, const id::room &);
+	string_view room_key(const string_view &key, const char &sep = '\0');
+	bool room_key_has(const string_view &key, const char &sep = '\0');
+
+	event::idx room_idx_get(const id::room &);
+	size_t room_idx_rebuild();
+
+	event::idx _room_idx(const db::txn &, const event &, const write_opts &);
+	void _index_room_idx(db::txn &, const event &, const write_opts &);
+
+	// room_id => room_idx
+	extern db::column room_idx;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> room_idx__comp;
+	extern conf::item<size_t> room_idx__block__size;
+	extern conf::item<size_t> room_idx__meta_block__size;
+	extern conf::item<size_t> room_idx__cache__size;
+	extern conf::item<size_t> room_idx__cache_comp__size;
+	extern conf::item<size_t> room_idx__bloom__bits;
+	extern conf::item<bool> room_idx__rebuild;
+	extern const db::descriptor room_idx;
+}
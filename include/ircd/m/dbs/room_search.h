@@ -0,0 +1,59 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_SEARCH_H
+
+namespace ircd::m::dbs
+{
+	using room_search_term_closure = std::function<bool (const string_view &)>;
+
+	/// Postings of a term are split into buckets of this many event_idx, so
+	/// no single value grows without bound for a common term.
+	constexpr const size_t ROOM_SEARCH_BUCKET_SHIFT
+	{
+		12
+	};
+
+	constexpr size_t ROOM_SEARCH_TERM_MAX_SIZE
+	{
+		64
+	};
+
+	constexpr size_t ROOM_SEARCH_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 + ROOM_SEARCH_TERM_MAX_SIZE + 1 + 8
+	};
+
+	bool room_search_terms(const string_view &text, const room_search_term_closure &);
+	string_view room_search_key(const mutable_buffer &out, const string_view &room_key, const string_view &term, const event::idx &);
+	bool room_search_for_each(const id::room &, const vector_view<const string_view> &terms, const event::idx &from, const event::closure_idx_bool &);
+	event::idx room_search_floor();
+	void room_search_floor(const event::idx &);
+	size_t room_search_rebuild();
+
+	void _index_room_search(db::txn &, const event &, const write_opts &);
+
+	// room_id | term, ~bucket => varint[]
+	extern db::column room_search;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> room_search__comp;
+	extern conf::item<size_t> room_search__block__size;
+	extern conf::item<size_t> room_search__meta_block__size;
+	extern conf::item<size_t> room_search__cache__size;
+	extern conf::item<size_t> room_search__cache_comp__size;
+	extern conf::item<size_t> room_search__terms__max;
+	extern conf::item<bool> room_search__rebuild;
+	extern const db::merge_closure room_search__merge;
+	extern const db::descriptor room_search;
+}
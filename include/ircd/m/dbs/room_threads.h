@@ -0,0 +1,41 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_THREADS_H
+
+namespace ircd::m::dbs
+{
+	using room_threads_closure = std::function<bool (const event::idx &root, const event::idx &latest)>;
+
+	constexpr size_t ROOM_THREADS_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 + sizeof(event::idx)
+	};
+
+	string_view room_threads_key(const mutable_buffer &out, const id::room &, const event::idx &root);
+	bool room_threads_for_each(const id::room &, const room_threads_closure &);
+
+	void _index_room_threads(db::txn &, const event &, const write_opts &, const event::idx &root);
+
+	// room_id | root_idx => event_idx
+	extern db::column room_threads;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> room_threads__comp;
+	extern conf::item<size_t> room_threads__block__size;
+	extern conf::item<size_t> room_threads__meta_block__size;
+	extern conf::item<size_t> room_threads__cache__size;
+	extern conf::item<size_t> room_threads__cache_comp__size;
+	extern const db::merge_closure room_threads__merge;
+	extern const db::descriptor room_threads;
+}
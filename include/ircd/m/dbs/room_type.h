@@ -35,9 +35,18 @@ namespace ircd::m::dbs
 	              const uint64_t &depth       = -1,
 	              const event::idx &          = -1);
 
+	string_view
+	room_type_key(const mutable_buffer &out,
+	              const id::room &,
+	              const event::idx &room_idx,
+	              const string_view &type,
+	              const uint64_t &depth,
+	              const event::idx &);
+
 	void _index_room_type(db::txn &,  const event &, const write_opts &);
 
 	// room_id | type, depth, event_idx
+	// room_idx | type, depth, event_idx
 	extern db::domain room_type;
 }
 
@@ -0,0 +1,50 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_UNREAD_H
+
+namespace ircd::m::dbs
+{
+	/// Slots of the counter vector for a user in a room in room_unread.
+	enum room_unread_slot :uint8_t
+	{
+		ROOM_UNREAD_RESET,          // nonzero when counting from a receipt
+		ROOM_UNREAD_NOTIFICATIONS,  // unread push notifications
+		ROOM_UNREAD_HIGHLIGHTS,     // unread push highlights
+		_ROOM_UNREAD_NUM
+	};
+
+	using room_unread_vector = std::array<int64_t, _ROOM_UNREAD_NUM>;
+
+	constexpr size_t ROOM_UNREAD_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 + id::MAX_SIZE
+	};
+
+	string_view room_unread_key(const mutable_buffer &out, const id::room &user_room, const id::room &);
+	bool room_unread_get(room_unread_vector &, const id::room &user_room, const id::room &);
+
+	void _index_room_unread(db::txn &, const event &, const write_opts &);
+
+	// user_room_id | room_id => int64_t[]
+	extern db::column room_unread;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> room_unread__comp;
+	extern conf::item<size_t> room_unread__block__size;
+	extern conf::item<size_t> room_unread__meta_block__size;
+	extern conf::item<size_t> room_unread__cache__size;
+	extern conf::item<size_t> room_unread__cache_comp__size;
+	extern const db::merge_closure room_unread__merge;
+	extern const db::descriptor room_unread;
+}
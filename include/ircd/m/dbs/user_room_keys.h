@@ -0,0 +1,47 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_USER_ROOM_KEYS_H
+
+namespace ircd::m::dbs
+{
+	using user_room_keys_closure = std::function<bool (const id::room &, const string_view &session_id, const json::object &session)>;
+	using user_room_keys_session_closure = std::function<void (const json::object &session)>;
+
+	constexpr size_t USER_ROOM_KEYS_SESSION_MAX_SIZE
+	{
+		255
+	};
+
+	constexpr size_t USER_ROOM_KEYS_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 + sizeof(event::idx) + id::MAX_SIZE + 1 + USER_ROOM_KEYS_SESSION_MAX_SIZE
+	};
+
+	string_view user_room_keys_key(const mutable_buffer &out, const id::user &, const event::idx &version, const id::room & = {}, const string_view &session_id = {});
+	bool user_room_keys_for_each(const id::user &, const event::idx &version, const id::room &, const user_room_keys_closure &);
+	bool user_room_keys_get(const id::user &, const event::idx &version, const id::room &, const string_view &session_id, const user_room_keys_session_closure &);
+	bool user_room_keys_put(db::txn &, const id::user &, const event::idx &version, const id::room &, const string_view &session_id, const json::object &session);
+	void user_room_keys_del(const id::user &, const event::idx &version, const id::room & = {}, const string_view &session_id = {});
+
+	// user_id | version, room_id, session_id => session
+	extern db::column user_room_keys;
+}
+
+namespace ircd::m::dbs::desc
+{
+	extern conf::item<std::string> user_room_keys__comp;
+	extern conf::item<size_t> user_room_keys__block__size;
+	extern conf::item<size_t> user_room_keys__meta_block__size;
+	extern conf::item<size_t> user_room_keys__cache__size;
+	extern conf::item<size_t> user_room_keys__cache_comp__size;
+	extern const db::descriptor user_room_keys;
+}
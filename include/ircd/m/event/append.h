@@ -16,6 +16,7 @@ namespace ircd::m
 {
 	struct room;
 	struct event_filter;
+	struct compiled_filter;
 };
 
 /// Used when transmitting events to clients. This tries to hide and provide
@@ -46,11 +47,14 @@ struct ircd::m::event::append::opts
 	const int64_t *room_depth {nullptr};
 	const event::keys *keys {nullptr};
 	const m::event_filter *event_filter {nullptr};
+	const m::compiled_filter *compiled_filter {nullptr};
 	long age {std::numeric_limits<long>::min()};
 	bool query_txnid {true};
 	bool query_prev_state {true};
 	bool query_redacted {true};
 	bool query_visible {false};
+	bool query_relations {true};
+	bool cache {false};
 };
 
 inline
@@ -18,7 +18,8 @@
 ///
 /// This evaluation does not throw or stop when a check fails: instead it
 /// collects the failures allowing the user to further determine how to proceed
-/// at their own discretion.
+/// at their own discretion. When only the outcome matters, check() stops at
+/// the first failure instead.
 ///
 struct ircd::m::event::conforms
 {
@@ -40,8 +41,11 @@ struct ircd::m::event::conforms
 	conforms() = default;
 	conforms(const event &);
 	conforms(const event &, const uint64_t &skip);
+	conforms(const event &, const uint64_t &skip, const uint &format);
 
 	static code reflect(const string_view &);
+	static uint format(const string_view &room_version) noexcept;
+	static bool check(const event &, const uint64_t &skip, const uint &format);
 };
 
 namespace ircd::m
@@ -87,6 +91,7 @@ enum ircd::m::event::conforms::code
 	MISMATCH_EVENT_ID,                 ///< event.event_id isn't the right hash.
 	MISSING_HASHES,                    ///< no hashes or recognized algorithm
 	MISMATCH_HASHES,                   ///< hashes don't match expected
+	INVALID_UTF8,                      ///< event contains invalid utf-8
 
 	_NUM_
 };
@@ -19,6 +19,9 @@ namespace ircd::m
 {
 	bool event_id(std::nothrow_t, const event::idx &, const event::id::closure &);
 
+	// Parallel query; out[i] is empty when in[i] is not found. Returns found.
+	size_t event_id(std::nothrow_t, const vector_view<event::id::buf> &out, const vector_view<const event::idx> &in);
+
 	[[nodiscard]] event::id event_id(std::nothrow_t, const event::idx &, event::id::buf &);
 	event::id event_id(const event::idx &, event::id::buf &);
 
@@ -18,6 +18,14 @@ namespace ircd::m
 	bool seek(std::nothrow_t, event::fetch &, const event::id &);
 	void seek(event::fetch &, const event::idx &);
 	void seek(event::fetch &, const event::id &);
+
+	// Bulk seek; all events are queried together; returns number valid.
+	size_t seek(std::nothrow_t, const vector_view<event::fetch> &, const vector_view<const event::idx> &);
+
+	// Bulk seek of the full events into the buffer; the events refer into
+	// the buffer, which must outlive them; events not found are left empty
+	// (no event_id); returns number valid.
+	size_t seek(std::nothrow_t, const vector_view<event> &, const vector_view<const event::idx> &, std::string &buf);
 }
 
 /// Event Fetcher (local).
@@ -38,10 +46,23 @@ namespace ircd::m
 /// determined automatically by default, but can be configured further with
 /// the options structure.
 ///
+/// Many events can be fetched at once with the bulk seek(), which conducts
+/// the queries for all of them together rather than one event at a time.
+/// Data from a bulk seek() is copied into the fetch instead of referenced.
+/// Iterations needing whole events can instead use the bulk seek() into
+/// plain m::event's and one buffer for all of them; this avoids the cells
+/// and buffers of an event::fetch for each event.
+///
+/// Events fetched in full (the default keys selection) are kept parsed in a
+/// bounded cache by event_idx; a fetch of a cached event refers to the shared
+/// entry rather than the database. The cache must be invalidated by anything
+/// which erases or rewrites the JSON of an existing event.
+///
 struct ircd::m::event::fetch
 :event
 {
 	struct opts;
+	struct cache_entry;
 
 	using keys = event::keys;
 	using view_closure = std::function<void (const string_view &)>;
@@ -50,18 +71,26 @@ struct ircd::m::event::fetch
 
 	const opts *fopts {&default_opts};
 	idx event_idx {0};
+	std::shared_ptr<const cache_entry> _cached;
 	std::array<db::cell, event::size()> cell;
 	db::cell _json;
 	db::row row;
 	bool valid;
 	id::buf event_id_buf;
+	std::string _buf;
 
 	static bool should_seek_json(const opts &);
+	static bool should_cache(const opts &);
 	static string_view key(const event::idx *const &);
+	bool assign_from_cache();
 	bool assign_from_row(const string_view &key);
 	bool assign_from_json(const string_view &key);
+	bool assign_from_source(const json::object &source);
 
   public:
+	static void invalidate(const idx &) noexcept;
+	static void invalidate() noexcept;
+
 	explicit fetch(std::nothrow_t, const idx &, const id &, const opts & = default_opts);
 	fetch(std::nothrow_t, const idx &, const opts & = default_opts);
 	fetch(std::nothrow_t, const id &, const opts & = default_opts);
@@ -14,6 +14,7 @@
 namespace ircd::m::events
 {
 	struct range;
+	struct rebuild;
 	using closure = std::function<bool (const event::idx &, const event &)>;
 
 	// Iterate events in range
@@ -25,7 +26,11 @@ namespace ircd::m::events
 
 	// util
 	void dump__file(const string_view &filename);
-	void rebuild();
+
+	// JSON-lines (one event per line); the range is divided among files
+	// named by the prefix and a partition number which are written at once.
+	size_t dump__jsonl(const string_view &prefix, const range &, const size_t &parts = 0);
+	size_t load__jsonl(const string_view &filename);
 }
 
 /// Interface to the types of all events known to this server.
@@ -98,6 +103,7 @@ namespace ircd::m::events::content
 {
 	using closure = std::function<bool (const event::idx &, const json::object &)>;
 
+	bool for_each(const event::idx &start, const closure &);
 	bool for_each(const closure &);
 }
 
@@ -128,6 +134,55 @@ struct ircd::m::events::range
 	{}
 };
 
+/// Rebuild of tables derived from the events. The event_idx space is divided
+/// into partitions which are processed concurrently by a pool of bounded
+/// size; each partition writes into its own db::txn which is committed
+/// whenever it grows past a threshold. When the rebuild is named, the point
+/// below which every partition has completed is recorded as it advances; a
+/// rebuild of the same name later resumes from there.
+///
+/// The closure indexes one event into the txn and returns the number of
+/// entries it wrote (for reporting); it is called concurrently for events of
+/// different partitions.
+struct ircd::m::events::rebuild
+{
+	struct opts;
+	using closure = std::function<size_t (db::txn &, const event::idx &, const event &)>;
+
+	static conf::item<size_t> concurrency;
+	static conf::item<size_t> partition;
+	static conf::item<size_t> txn_max;
+
+	event::idx resumed {0};            // first event_idx of this run
+	size_t visited {0};                // events visited
+	size_t indexed {0};                // total of the closure's returns
+	size_t commits {0};                // txns committed
+
+	rebuild(const opts &, const closure &);
+	rebuild();                         // type and sender tables
+};
+
+struct ircd::m::events::rebuild::opts
+{
+	/// Names the rebuild for checkpointing; empty to always start over.
+	string_view name;
+
+	/// Keys of each event fetched for the closure.
+	const event::fetch::opts *fopts {nullptr};
+
+	/// Range of event_idx [start, stop) to rebuild; the stop is bounded by
+	/// the retired sequence when the rebuild starts.
+	event::idx start {0};
+	event::idx stop {-1UL};
+
+	/// Number of partitions processed at once; zero for the conf default.
+	size_t concurrency {0};
+
+	/// Run the workers at background scheduling and IO priority so the
+	/// server remains responsive while the rebuild runs.
+	bool background {true};
+};
+
 inline bool
 ircd::m::events::origin::for_each(const closure_name &closure)
 {
@@ -45,6 +45,8 @@ namespace ircd::m::fed
 	bool linked(const string_view &server_name);
 	bool exists(const string_view &server_name);
 	bool avail(const string_view &server_name);
+	system_point backoff(const string_view &server_name);
+	microseconds rtt(const string_view &server_name);
 
 	// Control panel
 	bool prelink(const string_view &server_name);
@@ -46,6 +46,8 @@ struct ircd::m::fed::request::opts
 
 	/// The lower-level server::in structure used by server:: when receiving
 	/// data; providing anything here is optional and will override things.
+	/// Setting only in.sink with dynamic keeps the head buffer automatic and
+	/// streams the content to the sink rather than buffering all of it.
 	server::in in;
 
 	/// The lower-level server::request::opts configuration to attach to
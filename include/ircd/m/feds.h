@@ -148,6 +148,11 @@ struct ircd::m::feds::opts
 	/// link estab. The main request loop will then have fewer hazards.
 	bool prelink {true};
 
+	/// When non-zero, the remaining requests of this operation are cancelled
+	/// once this many remotes have responded successfully; the operation then
+	/// finishes in the latency of the fastest servers. Zero waits for all.
+	size_t quorum {0};
+
 	// Default construction is inline by member; this is defined to impose
 	// noexcept over `milliseconds timeout` which we guarantee won't throw.
 	opts() noexcept {}
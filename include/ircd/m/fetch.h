@@ -51,10 +51,12 @@ namespace ircd::m::fetch
 	string_view reflect(const op &);
 	bool for_each(const std::function<bool (request &)> &);
 	bool exists(const opts &);
+	bool inflight(const event::id &);
 	size_t count();
 
 	// Primary operations
 	ctx::future<result> start(opts);
+	bool wait(const event::id &, const milliseconds &timeout);
 }
 
 enum class ircd::m::fetch::op
@@ -189,7 +191,7 @@ struct ircd::m::fetch::request
 	string_view origin;
 
 	/// HTTP heads and scratch buffer for server::request
-	unique_buffer<mutable_buffer> buf;
+	server::pooled_buffer buf;
 
 	/// Our future for the server::request. Since we make
 	std::unique_ptr<server::request> future;
@@ -200,6 +202,18 @@ struct ircd::m::fetch::request
 	/// Error pointer state for an attempt. This is cleared each attempt.
 	std::exception_ptr eptr;
 
+	/// Time after which a hedged attempt may be made to a second server
+	/// while the current attempt is still outstanding. Zero when the current
+	/// attempt is not eligible for a hedge or one was already considered.
+	system_point hedge_at;
+
+	/// State for the hedged attempt; these mirror origin, buf and future. If
+	/// the hedge responds first it is swapped into their place; the remaining
+	/// attempt is then either canceled or promoted if the winner fails.
+	string_view hedge_origin;
+	server::pooled_buffer hedge_buf;
+	std::unique_ptr<server::request> hedge;
+
 	/// Buffer backing for opts
 	m::event::id::buf event_id;
 	m::room::id::buf room_id;
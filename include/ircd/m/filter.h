@@ -18,9 +18,11 @@ namespace ircd::m
 	struct event_filter;
 	struct room_event_filter;
 	struct state_filter;
+	struct compiled_filter;
 
 	bool match(const event_filter &, const event &) noexcept;
 	bool match(const room_event_filter &, const event &) noexcept;
+	bool match(const compiled_filter &, const event &) noexcept;
 }
 
 /// 5.1 "Filter" we use event_filter here
@@ -125,3 +127,70 @@ struct ircd::m::filter
 
 	static std::string get(const string_view &urle_id_or_json, const m::user &);
 };
+
+/// Compiled form of an event_filter, room_event_filter or state_filter for
+/// matching many events. Each list is sorted for binary search with the
+/// patterns ending in '*' kept as prefixes (and any other wildcard pattern
+/// kept aside for globular matching); a mask records which lists are present
+/// so an absent criterion costs a single test. The strings view the filter's
+/// JSON which must outlive this.
+struct ircd::m::compiled_filter
+{
+	struct set;
+
+	enum flag :uint
+	{
+		TYPES          = 0x0001,
+		NOT_TYPES      = 0x0002,
+		SENDERS        = 0x0004,
+		NOT_SENDERS    = 0x0008,
+		ROOMS          = 0x0010,
+		NOT_ROOMS      = 0x0020,
+		CONTAINS_URL   = 0x0040,
+		LAZY_LOAD      = 0x0080,
+		REDUNDANT      = 0x0100,
+	};
+
+	uint flags {0};
+	long limit {0};
+
+	bool has(const flag &f) const noexcept
+	{
+		return flags & f;
+	}
+
+	struct set
+	{
+		std::vector<string_view> exact;
+		std::vector<string_view> prefix;
+		std::vector<string_view> glob;
+
+		bool has(const string_view &) const noexcept;
+
+		set(const json::array &, const bool &patterns = false);
+		set() = default;
+	}
+	types, not_types, senders, not_senders, rooms, not_rooms;
+
+	compiled_filter(const event_filter &);
+	compiled_filter(const room_event_filter &);
+	compiled_filter(const state_filter &);
+	compiled_filter() = default;
+};
+
+/// A user's filter parsed and compiled once; see user::filter::compile().
+/// Not movable: the compiled members view the content string in place.
+struct ircd::m::user::filter::cached
+{
+	std::string content;
+	m::filter filter;
+	compiled_filter timeline;
+	compiled_filter state;
+	compiled_filter ephemeral;
+	compiled_filter account_data;
+	compiled_filter presence;
+
+	cached(std::string content);
+	cached(cached &&) = delete;
+	cached(const cached &) = delete;
+};
@@ -47,8 +47,12 @@ struct ircd::m::homeserver
 	struct cert;
 	struct opts;
 	struct conf;
+	struct stats;
 
-	/// Internal state; use m::my().
+	/// Internal state; use m::my(). The first homeserver constructed in the
+	/// process is the primary; any others are tenants which share the
+	/// primary's database, caches and federation links, and do not own the
+	/// process-wide subsystems or global configuration.
 	static homeserver *primary;
 
 	/// Options from the user.
@@ -67,6 +71,9 @@ struct ircd::m::homeserver
 	/// Configuration
 	std::unique_ptr<struct conf> conf;
 
+	/// Statistics specific to this homeserver.
+	std::unique_ptr<struct stats> stats;
+
 	/// Requested modules.
 	struct modules
 	:std::vector<string_view>
@@ -77,6 +84,7 @@ struct ircd::m::homeserver
 	modules;
 
 	void bootstrap();
+	void tenant();
 
 	homeserver(const struct opts *const &);
 	~homeserver() noexcept;
@@ -135,6 +143,20 @@ struct ircd::m::homeserver::conf
 	conf(const struct opts &);
 };
 
+struct ircd::m::homeserver::stats
+{
+	/// Events originating from this homeserver committed to the database.
+	ircd::stats::item<uint64_t> events;
+
+	/// Client requests authenticated as users of this homeserver.
+	ircd::stats::item<uint64_t> requests;
+
+	/// Counts the events.
+	hookfn<vm::eval &> event_committed;
+
+	stats(const struct opts &);
+};
+
 struct ircd::m::homeserver::opts
 {
 	/// Network name. This is the mxid hostpart (i.e @user:origin).
@@ -23,6 +23,12 @@ namespace ircd::m::init::backfill
 	void init(), fini() noexcept;
 }
 
+/// Internal use only; do not call
+namespace ircd::m::init::horizon
+{
+	void init(), fini() noexcept;
+}
+
 /// Internal use only; do not call
 struct ircd::m::init::modules
 {
@@ -74,5 +74,6 @@ struct ircd::m::keys::cache
 	static bool for_each(const string_view &server, const closure_bool &);
 	static bool has(const string_view &server, const string_view &key_id);
 	static bool get(const string_view &server, const string_view &key_id, const closure &);
+	static bool get(const string_view &server, const string_view &key_id, ed25519::pk &);
 	static size_t set(const json::object &keys);
 };
@@ -106,6 +106,7 @@ struct ircd::m::matrix
 {
 	static const std::vector<string_view> module_names;
 	static const std::vector<string_view> module_names_optional;
+	static const std::vector<std::pair<string_view, string_view>> module_names_lazy;
 
 	std::string module_path
 	{
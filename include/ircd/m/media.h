@@ -23,19 +23,24 @@ namespace ircd::m::media::file
 	room::id room_id(room::id::buf &out, const mxc &);
 	room::id::buf room_id(const mxc &);
 
+	size_t read(const room &, const pair<size_t> &range, const closure &);
 	size_t read(const room &, const closure &);
 	size_t write(const room &, const user::id &, const const_buffer &content, const string_view &content_type);
+	size_t purge(const room &);
 
 	room::id::buf
 	download(const mxc &,
 	         const m::user::id &,
 	         const string_view &remote = {});
 
+	using progress = std::function<void (const http::response::head &, const const_buffer &)>;
+
 	std::pair<http::response::head, unique_buffer<mutable_buffer>>
 	download(const mutable_buffer &head_buf,
 	         const mxc &mxc,
 	         string_view remote = {},
-	         server::request::opts *const opts = nullptr);
+	         server::request::opts *const opts = nullptr,
+	         const progress & = {});
 
 	m::room
 	download(const mxc &mxc,
@@ -48,6 +53,8 @@ namespace ircd::m::media::block
 {
 	using closure = std::function<void (const const_buffer &)>;
 
+	uint64_t refs(const string_view &hash);
+	bool unref(const string_view &hash);
 	bool prefetch(const string_view &hash);
 	bool get(const string_view &hash, const closure &);
 	const_buffer get(const mutable_buffer &out, const string_view &hash);
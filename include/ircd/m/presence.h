@@ -33,11 +33,23 @@ struct ircd::m::edu::m_presence
 struct ircd::m::presence
 :edu::m_presence
 {
+	struct cell;
+
 	using closure = std::function<void (const json::object &)>;
 	using closure_event = std::function<void (const m::event &)>;
+	using closure_cell_bool = std::function<bool (const id::user &, const cell &)>;
+
+	static conf::item<size_t> cells_max;
 
 	static bool valid_state(const string_view &state);
 
+	// In-memory table
+	static bool complete(const event::idx &since);
+	static bool for_each(const event::idx &since, const closure_cell_bool &);
+	static bool get(std::nothrow_t, const user &, cell &);
+	static void note(const m::event &, const event::idx &);
+	static void clear() noexcept;
+
 	static bool prefetch(const user &);
 	static event::idx get(std::nothrow_t, const user &);
 	static event::idx get(const user &);
@@ -52,3 +64,17 @@ struct ircd::m::presence
 	using edu::m_presence::m_presence;
 	presence(const user &, const mutable_buffer &);
 };
+
+/// Compact in-memory presence of one user. Sync decides from this whether a
+/// user's presence is sent at all; the content is only fetched (by the
+/// event_idx) for the users actually being sent.
+struct ircd::m::presence::cell
+{
+	event::idx event_idx {0};        // ircd.presence in the user's room
+	time_t last_active {0};          // absolute ms
+	int8_t state {-1};               // index into the valid states
+	bool currently_active {false};
+	bool status_msg {false};
+
+	bool offline() const noexcept;
+};
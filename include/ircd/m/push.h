@@ -18,6 +18,7 @@ namespace ircd::m::push
 	struct rules;
 	struct pusher;
 	struct match;
+	struct program;
 	struct request;
 
 	IRCD_M_EXCEPTION(m::error, error, http::INTERNAL_SERVER_ERROR)
@@ -40,12 +41,17 @@ struct ircd::m::push::request
 {
 	static conf::item<bool> enable;
 	static conf::item<seconds> timeout;
+	static conf::item<size_t> gateway_max;
+	static conf::item<size_t> devices_max;
 	static ctx::mutex mutex;
 	static ctx::dock dock;
 	static uint64_t id_ctr;
 
 	uint64_t id {++id_ctr};
 	event::idx event_idx {0};
+	steady_point started {now<steady_point>()};
+	size_t devices {0};
+	bool canceled {false};
 	rfc3986::uri url;
 	json::object content;
 	server::request req;
@@ -70,6 +76,108 @@ struct ircd::m::push::match
 struct ircd::m::push::match::opts
 {
 	m::id::user user_id;
+
+	/// Optional index of the event's content; when given, lookups into the
+	/// content are made against it instead of parsing the content again.
+	const json::object::index *content {nullptr};
+};
+
+/// Ruleset of a user compiled for evaluation. Rules are flattened in order
+/// of priority without those disabled; conditions are parsed, patterns are
+/// classified, and the user's display name is resolved once. Programs are
+/// cached by user until the user's rules or profile change.
+struct ircd::m::push::program
+{
+	struct cond;
+	struct rule;
+	struct memo;
+
+	static conf::item<size_t> cache_max;
+	static std::map<std::string, std::shared_ptr<const program>, std::less<>> cache;
+	static uint64_t cache_gen;
+
+	std::string user_id;
+	std::string displayname;
+	std::vector<rule> rules;
+
+	const rule *operator()(memo &) const;
+
+	program(const id::user &);
+
+	static std::shared_ptr<const program> get(const id::user &);
+	static void invalidate(const id::user &);
+};
+
+/// Values of the event computed at most once and shared by the programs of
+/// every user evaluated for it.
+struct ircd::m::push::program::memo
+{
+	const m::event &event;
+	const json::object::index *content {nullptr};
+	std::map<std::string, string_view, std::less<>> values;
+	std::map<std::string, bool, std::less<>> permitted;
+	std::vector<int8_t> results;
+	std::optional<size_t> members;
+
+	string_view value(const string_view &key);
+	bool permission(const string_view &key);
+	size_t member_count();
+	int8_t &result(const uint32_t &slot);
+
+	memo(const m::event &, const json::object::index *const & = nullptr);
+};
+
+struct ircd::m::push::program::cond
+{
+	enum kind :uint8_t
+	{
+		EVENT_MATCH,
+		ROOM_MEMBER_COUNT,
+		CONTAINS_USER_MXID,
+		STATE_KEY_USER_MXID,
+		CONTAINS_DISPLAY_NAME,
+		SENDER_NOTIFICATION_PERMISSION,
+		ROOM_ID,
+		SENDER,
+		UNKNOWN,
+	};
+
+	enum glob :uint8_t
+	{
+		GLOB,           ///< globular_imatch
+		EXACT,          ///< no wildcards; case-insensitive equality
+		ANY,            ///< "*" matches any non-empty value
+	};
+
+	static conf::item<size_t> slots_max;
+	static std::map<std::string, uint32_t, std::less<>> slots;
+
+	enum kind kind {UNKNOWN};
+	enum glob glob {GLOB};
+	uint32_t slot {-1U};
+	std::string key;
+	std::string pattern;
+	ulong val {0};
+
+	bool eval(const program &, memo &) const;
+	bool operator()(const program &, memo &) const;
+
+	cond(const push::cond &);
+	cond(const enum kind &, const string_view &key, const string_view &pattern);
+};
+
+struct ircd::m::push::program::rule
+{
+	std::string scope;
+	std::string kind;
+	std::string rule_id;
+	event::idx rule_idx {0};
+	std::string actions;
+	bool notify {false};
+	bool highlight {false};
+	std::vector<cond> conds;
+
+	push::path path() const;
 };
 
 /// 13.13.1 I'm your pusher, baby.
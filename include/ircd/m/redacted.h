@@ -16,14 +16,20 @@ namespace ircd::m
 	struct redacted;
 }
 
+/// Whether an event has been redacted. This is answered from a bitmap of
+/// all redacted event::idx held in memory once it has been built from the
+/// redactions in the database; until then each query seeks event::refs.
 struct ircd::m::redacted
 :boolean
 {
+	static conf::item<bool> bitmap_enable;
+
 	redacted(const event::idx &);
 	redacted(const event::id &);
 	explicit redacted(const event &);
 
 	static bool prefetch(const event::idx &);
+	static void rebuild();
 };
 
 inline
@@ -42,17 +48,6 @@ ircd::m::redacted::redacted(const event::id &event_id)
 }
 {}
 
-inline
-ircd::m::redacted::redacted(const event::idx &event_idx)
-:boolean
-{
-	event_idx?
-		event::refs(event_idx).has(dbs::ref::M_ROOM_REDACTION):
-		false
-}
-{
-}
-
 inline bool
 ircd::m::redacted::prefetch(const event::idx &event_idx)
 {
@@ -47,7 +47,9 @@ struct ircd::m::room::aliases::cache
 	static string_view make_key(const mutable_buffer &, const alias &);
 	static event::idx getidx(const alias &); // nothrow
 	static milliseconds age(const event::idx &); // nothrow
+	static seconds ttl(const event::idx &); // nothrow
 	static bool expired(const event::idx &); // nothrow
+	static void refresh(const alias &); // nothrow
 
   public:
 	static system_point expires(const alias &);
@@ -64,7 +66,7 @@ struct ircd::m::room::aliases::cache
 	static id::buf get(std::nothrow_t, const alias &);
 	static id::buf get(const alias &);
 
-	static bool set(const alias &, const id &);
+	static bool set(const alias &, const id &, const seconds &ttl = seconds(-1));
 
 	static bool del(const alias &);
 };
@@ -71,8 +71,12 @@ struct ircd::m::room::auth::chain
 {
 	using closure = event::closure_idx_bool;
 
+	static conf::item<bool> cover;
+
 	event::idx idx;
 
+	bool for_each_walk(const closure &) const;
+
   public:
 	bool for_each(const closure &) const;
 	bool has(const string_view &type) const;
@@ -95,6 +99,7 @@ class ircd::m::room::auth::hookdata
 	const event *auth_join_rules {nullptr};
 	const event *auth_member_target {nullptr};
 	const event *auth_member_sender {nullptr};
+	event::idx auth_power_idx {0};      // of auth_power when known
 
 	bool allow {false};
 	std::exception_ptr fail;
@@ -43,9 +43,16 @@ struct ircd::m::room::head
 	struct fetch;
 	struct generate;
 	using closure = std::function<bool (const event::idx &, const event::id &)>;
+	using list = std::vector<std::pair<int64_t, event::idx>>;
+
+	static conf::item<bool> cache_enable;
+	static conf::item<size_t> cache_rooms_max;
+	static conf::item<size_t> reduce_threshold;
+	static conf::item<size_t> reduce_rounds;
 
 	m::room room;
 
+	list sorted() const;
 	bool for_each(const closure &) const;
 	bool has(const event::id &) const;
 	size_t count() const;
@@ -58,4 +65,8 @@ struct ircd::m::room::head
 	static void modify(const event::id &, const db::op &, const bool &);
 	static size_t rebuild(const head &);
 	static size_t reset(const head &);
+	static size_t reduce(const head &);
+
+	// drop the cached heads of the room; called for writes bypassing the vm.
+	static void invalidate(const id &) noexcept;
 };
@@ -77,4 +77,12 @@ struct ircd::m::room::head::fetch::opts
 
 	/// When true, results may include events this server already has executed.
 	bool existing {false};
+
+	/// When non-zero, stop after this many servers have responded.
+	size_t quorum {0};
+
+	/// When non-zero, stop once this many servers in a row have reported no
+	/// head which wasn't already reported by another server or already
+	/// exists here. Requires unique=true.
+	size_t converge {0};
 };
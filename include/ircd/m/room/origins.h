@@ -19,9 +19,17 @@ struct ircd::m::room::origins
 {
 	using closure = std::function<void (const string_view &)>;
 	using closure_bool = std::function<bool (const string_view &)>;
+	using list = std::vector<std::string>;
+
+	static conf::item<bool> cache_enable;
+	static conf::item<size_t> cache_rooms_max;
+	static conf::item<size_t> cache_origins_min;
 
 	m::room room;
 
+	std::shared_ptr<const list> cached() const;
+	bool for_each_walk(const closure_bool &view) const;
+
   public:
 	bool for_each(const closure_bool &view) const;
 	void for_each(const closure &view) const;
@@ -37,6 +45,9 @@ struct ircd::m::room::origins
 	string_view random(const mutable_buffer &buf, const closure_bool &proffer = nullptr) const;
 	bool random(const closure &, const closure_bool &proffer = nullptr) const;
 
+	// drop the cached list of origins; called for changes to the membership.
+	static void invalidate(const id &) noexcept;
+
 	origins(const m::room &room)
 	:room{room}
 	{}
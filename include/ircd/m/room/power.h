@@ -44,17 +44,20 @@ struct ircd::m::room::power
 {
 	struct grant;
 	struct revoke;
+	struct table;
 	using closure = std::function<bool (const string_view &, const int64_t &)>;
 
 	static conf::item<int64_t> default_creator_level;
 	static conf::item<int64_t> default_power_level;
 	static conf::item<int64_t> default_event_level;
 	static conf::item<int64_t> default_user_level;
+	static conf::item<size_t> cache_max;
 
 	m::room room;
 	event::idx power_event_idx {0};
 	json::object power_event_content;
 	m::id::user room_creator_id;
+	std::shared_ptr<const table> power_table;
 
 	static bool is_level(const json::string &) noexcept;
 	static int64_t as_level(const json::string &);
@@ -93,13 +96,14 @@ struct ircd::m::room::power
 	int64_t level_event(const string_view &type, const string_view &state_key) const;
 	int64_t level_event(const string_view &type) const;
 	int64_t level_user(const m::id::user &) const;
+	int64_t level_notification(const string_view &key) const;
 
 	// all who attain great power and riches make use of either force or fraud"
 	bool operator()(const m::id::user &, const string_view &prop, const string_view &type = {}, const string_view &state_key = {}) const;
 
 	explicit power(const json::object &power_event_content, const m::id::user &room_creator_id);
 	explicit power(const m::event &power_event, const m::id::user &room_creator_id);
-	explicit power(const m::event &power_event, const m::event &create_event);
+	explicit power(const m::event &power_event, const m::event &create_event, const event::idx &power_event_idx = 0);
 	power(const m::room &, const event::idx &power_event_idx);
 	power(const m::room &);
 	power() = default;
@@ -107,6 +111,27 @@ struct ircd::m::room::power
 	using compose_closure = std::function<void (const string_view &, json::stack::object &)>;
 	static json::object compose_content(const mutable_buffer &out, const compose_closure &);
 	static json::object default_content(const mutable_buffer &out, const m::id::user &creator);
+
+	// Parsed levels of the power_levels event at the event_idx, shared from a
+	// cache; the content is fetched if not given. Null if not found.
+	static std::shared_ptr<const table> compile(const event::idx &, const json::object &content = {});
+};
+
+/// Parsed power levels content. Every integer level of the content is copied
+/// out once so queries don't parse the JSON; the first of any duplicate key
+/// is kept like json::object::get().
+struct ircd::m::room::power::table
+{
+	using map = std::map<std::string, int64_t, std::less<>>;
+
+	map levels;                        // top-level i.e "ban", "users_default"
+	map events;
+	map users;
+	map notifications;
+
+	static const int64_t *find(const map &, const string_view &key) noexcept;
+
+	table(const json::object &content);
 };
 
 struct ircd::m::room::power::grant
@@ -185,6 +185,8 @@ struct ircd::m::room
 	static event::idx index(const id &, std::nothrow_t);
 	static event::idx index(const id &);
 
+	static conf::item<size_t> purge_txn_events;
+	static size_t purge(const room &, const int64_t &before_ts); // cuidado!
 	static size_t purge(const room &); // cuidado!
 };
 
@@ -192,6 +194,7 @@ struct ircd::m::room
 #include "state.h"
 #include "state_space.h"
 #include "state_history.h"
+#include "state_resolve.h"
 #include "state_fetch.h"
 #include "members.h"
 #include "origins.h"
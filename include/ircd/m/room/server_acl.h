@@ -31,11 +31,13 @@ struct ircd::m::room::server_acl
 {
 	using closure_bool = std::function<bool (const string_view &)>;
 	using view_closure = std::function<void (const json::object &)>;
+	struct compiled;
 
 	static conf::item<bool> enable_write;  // request origin / event origin
 	static conf::item<bool> enable_read;   // request origin
 	static conf::item<bool> enable_fetch;  // request destination / event origin
 	static conf::item<bool> enable_send;   // request destination
+	static conf::item<size_t> cache_max;   // compiled ACL's kept by event_idx
 
 	m::room room;
 	event::idx event_idx {0};
@@ -70,6 +72,9 @@ struct ircd::m::room::server_acl
 	server_acl(const m::room &);
 	server_acl() = default;
 
+	// Compiled form of the ACL content at the event_idx; null if not found.
+	static std::shared_ptr<const compiled> compile(const event::idx &);
+
 	static bool check(const m::id::room &, const net::hostport &server);
 };
 
@@ -26,6 +26,7 @@ struct ircd::m::room::state
 	struct history;
 	struct rebuild;
 	struct fetch;
+	struct resolve;
 
 	using closure = std::function<void (const string_view &, const string_view &, const event::idx &)>;
 	using closure_bool = std::function<bool (const string_view &, const string_view &, const event::idx &)>;
@@ -63,6 +64,9 @@ struct ircd::m::room::state
 	bool for_each(const event::closure_bool &view) const;
 	void for_each(const event::closure &) const;
 
+	// Iterate the state skipping over every cell of one type
+	bool for_each_except(const string_view &type, const closure_bool &view) const;
+
 	// Counting / Statistics
 	size_t count(const string_view &type) const;
 	size_t count() const;
@@ -51,4 +51,7 @@ struct ircd::m::room::state::fetch::opts
 
 	/// When true, results may include events this server already has executed.
 	bool existing {false};
+
+	/// When non-zero, stop after this many servers have responded.
+	size_t quorum {0};
 };
@@ -19,6 +19,8 @@ struct ircd::m::room::state::history
 {
 	using closure = std::function<bool (const string_view &, const string_view &, const int64_t &, const event::idx &)>;
 
+	static conf::item<size_t> step_max;
+
 	state::space space;
 	event::idx event_idx {0};
 	int64_t bound {-1};
@@ -0,0 +1,38 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_ROOM_STATE_RESOLVE_H
+
+/// State resolution (room version 2 and later) of several sets of state for
+/// a room. The result of construction is the resolved state map.
+///
+/// The auth difference of the sets is computed from the chain cover index
+/// (dbs::event_chain) with one comparison for each chain rather than by
+/// walking every auth chain. When the index is incomplete for any event in
+/// the sets the auth chains are walked instead.
+///
+struct ircd::m::room::state::resolve
+{
+	using cell = std::pair<std::string, std::string>;
+	using state_map = std::map<cell, event::idx, std::less<>>;
+	using state_maps = vector_view<const state_map>;
+
+	static conf::item<bool> chain_cover;
+
+	m::room room;
+	state_map state;
+	size_t conflicted {0};
+	size_t auth_difference {0};
+	size_t rejected {0};
+
+	resolve(const m::room &, const state_maps &);
+	resolve(const m::room::id &, const vector_view<const event::id> &);
+};
@@ -18,4 +18,6 @@ struct ircd::m::room::stats
 
 	static size_t bytes_total_compressed(const m::room &);
 	static size_t bytes_total(const m::room &);
+
+	static size_t events(const m::room &);
 };
@@ -13,6 +13,7 @@
 
 namespace ircd::m::search
 {
+	struct batch;
 	struct query;
 	struct result;
 	struct room_events;
@@ -50,10 +51,27 @@ struct ircd::m::search::room_events
 	using super_type::tuple;
 };
 
+/// Position from which a search resumes; the next_batch token encodes it.
+/// Rooms are searched in turn; in each the index is intersected (INDEX)
+/// before the events which predate it are scanned (SCAN). The operator's
+/// search of all rooms ends with one scan of every event (SCAN_ALL).
+struct ircd::m::search::batch
+{
+	enum phase :uint8_t
+	{
+		INDEX, SCAN, SCAN_ALL,
+	};
+
+	size_t room {0};
+	enum phase phase {INDEX};
+	uint64_t pos {-1UL};      // event_idx; or depth for SCAN
+	size_t skip {0};          // visited at pos; results of a ranked window
+};
+
 struct ircd::m::search::query
 {
 	user::id user_id;
-	size_t batch {-1UL};
+	search::batch batch;
 	search::room_events room_events;
 	room_event_filter filter;
 	string_view search_term;
@@ -73,4 +91,5 @@ struct ircd::m::search::result
 	size_t count {0};
 	event::idx event_idx {0UL};
 	long rank {0L};
+	search::batch next;
 };
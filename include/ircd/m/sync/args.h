@@ -24,6 +24,7 @@ struct ircd::m::sync::args
 	static conf::item<milliseconds> timeout_max;
 	static conf::item<milliseconds> timeout_min;
 	static conf::item<milliseconds> timeout_default;
+	static conf::item<milliseconds> timeout_shed;
 
 	/// 6.2.1 The ID of a filter created using the filter API or a filter JSON object
 	/// encoded as a string. The server will detect whether it is an ID or a JSON object
@@ -68,8 +68,8 @@ struct ircd::m::sync::data
 	/// User's rooms interface convenience.
 	const m::user::rooms user_rooms;
 
-	/// Buffer for supplied or fetched filter.
-	const std::string filter_buf;
+	/// Supplied or fetched filter, parsed and compiled (null if none).
+	const std::shared_ptr<const user::filter::cached> filters;
 
 	/// Structured parse of the above filter.
 	const m::filter filter;
@@ -113,6 +113,10 @@ struct ircd::m::sync::data
 	     const sync::args *const &args = nullptr,
 	     const device::id &device_id = {});
 
+	/// Fork of the parent's state for a handler running concurrently with
+	/// it, which writes to its own json::stack. The parent must outlive this.
+	data(const data &parent, json::stack &out);
+
 	data(data &&) = delete;
 	data(const data &) = delete;
 	~data() noexcept;
@@ -34,9 +34,15 @@ struct ircd::m::sync::item
 {
 	using handle = std::function<bool (data &)>;
 
+	struct account;
+
 	std::string conf_name[2];
 	conf::item<bool> enable;
 	conf::item<bool> stats_debug;
+	ircd::stats::item<uint64_t> stats_calls;   // handler invocations (either mode)
+	ircd::stats::item<uint64_t> stats_cycles;  // cycles on the calling ctx (inclusive of children)
+	ircd::stats::item<uint64_t> stats_yields;  // ctx yields, i.e. blocking reads
+	ircd::stats::item<uint64_t> stats_bytes;   // output appended to the json::stack
 	handle _polylog;
 	handle _linear;
 	json::strung feature;
@@ -15,6 +15,7 @@ struct ircd::m::user::devices
 {
 	using closure = std::function<void (const event::idx &, const string_view &)>;
 	using closure_bool = std::function<bool (const event::idx &, const string_view &)>;
+	using closure_change_bool = std::function<bool (const event::idx &, const m::id::user &)>;
 
 	m::user user;
 
@@ -33,6 +34,19 @@ struct ircd::m::user::devices
 
 	bool del(const string_view &id) const;
 
+	// In-memory stream of device list changes
+	static conf::item<size_t> changes_max;
+	static bool changes_complete(const event::idx &since);
+	static bool for_each_change(const event::idx &since, const closure_change_bool &);
+	static bool changes(const m::event &);
+	static void note(const m::event &, const event::idx &);
+	static void clear() noexcept;
+
+	// Cached device lists of remote users
+	static conf::item<seconds> tracked_max_age;
+	static bool tracked(const m::user &);
+	static bool resync(const json::object &user_devices_response);
+
 	///TODO: XXX junk
 	static std::map<std::string, long> count_one_time_keys(const m::user &, const string_view &);
 	static bool update(const device_list_update &);
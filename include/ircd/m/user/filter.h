@@ -13,6 +13,8 @@
 
 struct ircd::m::user::filter
 {
+	struct cached;
+
 	using closure_bool = std::function<bool (const string_view &, const json::object &)>;
 	using closure = std::function<void (const string_view &, const json::object &)>;
 
@@ -21,6 +23,7 @@ struct ircd::m::user::filter
 	static bool for_each(const m::user &, const closure_bool &);
 	static bool get(std::nothrow_t, const m::user &, const string_view &id, const closure &);
 	static string_view set(const mutable_buffer &idbuf, const m::user &, const json::object &);
+	static std::shared_ptr<const cached> compile(const m::user &, const string_view &urle_id_or_json);
 
   public:
 	bool for_each(const closure_bool &) const;
@@ -16,6 +16,9 @@ struct ircd::m::user::tokens
 	using closure = std::function<void (const event::idx &, const string_view &)>;
 	using closure_bool = std::function<bool (const event::idx &, const string_view &)>;
 
+	static conf::item<size_t> cache_max;
+	static conf::item<seconds> cache_ttl;
+
 	static string_view generate(const mutable_buffer &out);
 	static id::device::buf device(std::nothrow_t, const string_view &token);
 	static id::device::buf device(const string_view &token);
@@ -13,8 +13,40 @@
 
 namespace ircd::m
 {
+	struct visibility;
+
 	// The mxid argument is a string_view because it may be empty when no
 	// authentication is supplied (m::id cannot be empty because that's
 	// considered an invalid mxid). In that case the test is for public vis.
 	bool visible(const event &, const string_view &mxid);
 }
+
+/// Visibility of the events of one room to one mxid, for checking many
+/// events. The history_visibility and the user's membership are collected
+/// once over the depths of the room into a list of intervals; each event is
+/// then tested by a binary search on its depth rather than querying the state
+/// of the room at the event. Results equal visible(event, mxid) as far as the
+/// state at an event is the state at its depth; on a fork of the room the
+/// interval may differ from the branch the event is on.
+struct ircd::m::visibility
+{
+	/// The state from this depth until the next point. Values are the first
+	/// letter of the history_visibility and the membership, or zero.
+	struct point
+	{
+		int64_t depth {0};
+		char history_visibility {'s'};
+		char membership {0};
+	};
+
+	m::room::id room_id;
+	string_view mxid;
+	std::vector<point> points;
+	bool unrestricted {false};   // user is an oper
+	bool present {false};        // user is joined or invited now
+	bool origin {false};         // node is joined now
+
+	bool operator()(const event &) const;
+
+	visibility(const m::room::id &, const string_view &mxid);
+};
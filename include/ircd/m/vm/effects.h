@@ -0,0 +1,30 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_VM_EFFECTS_H
+
+/// Deferred EFFECTS phase. When enabled, the effect hooks for events in
+/// public rooms are called by a pool of contexts after the eval has retired
+/// rather than by the evaluator. Effects for the events of one room are
+/// called in the order they were evaluated.
+namespace ircd::m::vm::effects
+{
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> queue_max;
+	extern conf::item<size_t> pool_size;
+	extern ctx::dock dock;
+	extern size_t queued;         // waiting in a room's queue
+	extern size_t running;        // being called by the pool
+
+	bool defer(const eval &, const event &);  // false to call them directly
+	void call(eval &, const event &);         // conducts the EFFECTS phase
+	void fini();                              // drains the queue; stops pool
+}
@@ -22,8 +22,12 @@ namespace ircd::m::vm
 	string_view loghead(const mutable_buffer &, const eval &);
 	string_view loghead(const eval &);    // single tls buffer
 
+	size_t prefetch_refs(const vector_view<const event> &, const dbs::write_opts &);
 	size_t prefetch_refs(const eval &);
 	size_t fetch_keys(const eval &);
+	size_t verify_pdus(const vector_view<bool> &, const vector_view<const event> &);
+	size_t verify_pdus(const vector_view<bool> &, const eval &);
+	size_t hash_pdus(const vector_view<sha256::buf> &, const vector_view<const event> &);
 }
 
 /// Event Evaluation Device
@@ -55,6 +59,8 @@ struct ircd::m::vm::eval
 	size_t faulted {0};
 
 	vector_view<const m::event> pdus;
+	vector_view<const bool> verified;
+	vector_view<const sha256::buf> hashes;
 	const json::iov *issue {nullptr};
 	const event *event_ {nullptr};
 	string_view room_id;
@@ -63,6 +69,8 @@ struct ircd::m::vm::eval
 	string_view room_version;
 	hook::base *hook {nullptr};
 	vm::phase phase {vm::phase(0)};
+	std::array<uint64_t, num_of<vm::phase>()> phase_cycles {{0}};
+	std::array<nanoseconds, num_of<vm::phase>()> phase_time {{0ns}};
 	bool room_internal {false};
 
   public:
@@ -18,6 +18,7 @@ namespace ircd::m::vm
 
 	extern const opts default_opts;
 	extern const copts default_copts;
+	extern const copts record_copts;
 }
 
 /// Evaluation Options
@@ -94,6 +95,13 @@ struct ircd::m::vm::opts
 	/// without any reordering before eval.
 	bool ordered {false};
 
+	/// Bulk-load mode for large imports, e.g. migrations and big joins. Array
+	/// inputs are taken in larger windows ordered by room and depth rather
+	/// than by event_id. The NOTIFY and EFFECTS phases are skipped, writes
+	/// bypass the journal, and the database is flushed once after the array
+	/// input is exhausted.
+	bool bulk {false};
+
 	/// If the input event has a reference to already-strung json we can use
 	/// that directly when writing to the DB. When this is false we will
 	/// re-stringify the event internally either from a referenced source or
@@ -105,6 +113,16 @@ struct ircd::m::vm::opts
 	/// perform a parallel/mass fetch before proceeding with the evals.
 	bool mfetch_keys {true};
 
+	/// Whether to verify the signatures of all events in an input vector in
+	/// one batch before proceeding with the evals. Events which do not pass
+	/// the batch are verified again individually in their VERIFY phase.
+	bool mverify {true};
+
+	/// Whether to compute the reference hashes of all events without an
+	/// event_id in an input vector in one batch, from which each event_id is
+	/// made when its eval reaches the point of needing it.
+	bool mhash {true};
+
 	/// Whether to launch prefetches for all event_id's (found at standard
 	/// locations) from the input vector, in addition to some other related
 	/// local db prefetches. Disabled by default because it operates prior
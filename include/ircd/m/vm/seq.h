@@ -21,6 +21,7 @@ namespace ircd::m::vm::sequence
 
 	const uint64_t &get(const eval &);
 	uint64_t get(id::event::buf &); // [GET]
+	uint64_t refresh();             // [SET] secondary (slave) catch-up
 
 	uint64_t max();
 	uint64_t min();
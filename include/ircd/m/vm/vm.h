@@ -28,6 +28,7 @@ namespace ircd::m::vm
 #include "opts.h"
 #include "eval.h"
 #include "seq.h"
+#include "effects.h"
 
 namespace ircd::m::vm
 {
@@ -38,5 +39,7 @@ namespace ircd::m::vm
 
 struct ircd::m::vm::init
 {
+	context refresher;
+
 	init(), ~init() noexcept;
 };
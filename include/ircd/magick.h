@@ -15,6 +15,7 @@
 namespace ircd::magick
 {
 	IRCD_EXCEPTION(ircd::error, error)
+	IRCD_EXCEPTION(error, busy)
 
 	struct job;
 	struct crop;
@@ -31,12 +31,14 @@ struct ircd::net::acceptor
 	static log::log log;
 	static ios::descriptor accept_desc;
 	static ios::descriptor handshake_desc;
+	static conf::item<size_t> accepting_max;
 	static conf::item<size_t> handshaking_max;
 	static conf::item<size_t> handshaking_max_per_peer;
 	static conf::item<milliseconds> timeout;
 	static conf::item<std::string> ssl_curve_list;
 	static conf::item<std::string> ssl_cipher_list;
 	static conf::item<std::string> ssl_cipher_blacklist;
+	static conf::item<bool> http2_enable;
 
 	net::listener *listener_;
 	std::string name;
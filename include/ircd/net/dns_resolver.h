@@ -23,6 +23,7 @@ namespace ircd::net::dns
 	using answers_callback = std::function<void (std::exception_ptr, const tag &, const answers &)>;
 
 	constexpr const size_t MAX_COUNT {64};
+	constexpr const size_t BATCH_MAX {16};  // datagrams per syscall
 
 	uint16_t resolver_call(const hostport &, const opts &);
 }
@@ -69,12 +70,13 @@ struct ircd::net::dns::resolver
 	void handle_reply(const ipport &, const header &, const const_buffer &body);
 	void handle(const ipport &, const mutable_buffer &);
 	void handle_interrupt(ctx::ctx *const &) noexcept;
-	std::tuple<net::ipport, mutable_buffer> recv_recv(const mutable_buffer &);
+	size_t recv_recv(const mutable_buffer &, const vector_view<net::ipport> &, const vector_view<mutable_buffer> &);
 	void recv_worker();
 	ctx::context recv_context;
 
 	// submission
 	void send_query(const ip::udp::endpoint &, tag &);
+	size_t send_queries(const vector_view<tag *> &);
 	void queue_query(tag &);
 	void send_query(tag &);
 	void submit(tag &);
@@ -86,7 +88,7 @@ struct ircd::net::dns::resolver
 	ctx::context timeout_context;
 
 	// sendq
-	void flush(const uint16_t &);
+	void flush(const vector_view<tag *> &);
 	void sendq_work();
 	void sendq_clear();
 	void sendq_worker();
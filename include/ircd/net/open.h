@@ -36,6 +36,7 @@ namespace ircd::net
 struct ircd::net::open_opts
 {
 	static conf::item<milliseconds> default_connect_timeout;
+	static conf::item<milliseconds> default_race_delay;
 	static conf::item<milliseconds> default_handshake_timeout;
 	static conf::item<bool> default_verify_certificate;
 	static conf::item<bool> default_allow_self_signed;
@@ -58,9 +59,18 @@ struct ircd::net::open_opts
 	/// hostport is not given; required if so.
 	net::ipport ipport;
 
+	/// An alternate resolved IP and port, usually of the other address
+	/// family. When given, a connection to it is raced against the one to
+	/// ipport (RFC 8305) and whichever connects first is kept.
+	net::ipport ipport_alt;
+
 	/// The duration allowed for the TCP connection.
 	milliseconds connect_timeout { default_connect_timeout };
 
+	/// The delay after starting the connection to ipport before the one to
+	/// ipport_alt is started; it starts at once if the first fails.
+	milliseconds race_delay { default_race_delay };
+
 	/// Pointer to a sock_opts structure which will be applied to this socket
 	/// if given. Defaults to null; no application is made.
 	const sock_opts *sopts { nullptr };
@@ -113,6 +123,11 @@ struct ircd::net::open_opts
 
 	/// Option to allow expired certificates.
 	bool allow_expired { default_allow_expired };
+
+	/// Application protocols offered in the ClientHello, in order of
+	/// preference. The protocol selected by the server is found in the
+	/// socket's alpn afterward, or is empty. Storage must outlive the open().
+	vector_view<const string_view> alpn;
 };
 
 /// Constructor intended to provide implicit conversions (no-brackets required)
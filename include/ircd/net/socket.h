@@ -21,6 +21,9 @@ namespace ircd::net
 	extern conf::item<std::string> ssl_curve_list;
 	extern conf::item<std::string> ssl_cipher_list;
 	extern conf::item<std::string> ssl_cipher_blacklist;
+	extern conf::item<bool> ssl_session_cache_enable;
+	extern conf::item<size_t> ssl_session_cache_max;
+	extern std::map<std::string, std::string, std::less<>> ssl_session_cache;
 	extern asio::ssl::context sslv23_client;
 }
 
@@ -32,6 +35,7 @@ struct ircd::net::socket
 	struct io;
 	struct stat;
 	struct xfer;
+	struct race;
 
 	using endpoint = ip::tcp::endpoint;
 	using wait_type = ip::tcp::socket::wait_type;
@@ -53,6 +57,7 @@ struct ircd::net::socket
 	static stats::item<uint64_t> total_calls_in;
 	static stats::item<uint64_t> total_calls_out;
 	static ios::descriptor desc_connect;
+	static ios::descriptor desc_race;
 	static ios::descriptor desc_handshake;
 	static ios::descriptor desc_disconnect;
 	static ios::descriptor desc_timeout;
@@ -75,6 +80,8 @@ struct ircd::net::socket
 	void handle_disconnect(std::shared_ptr<socket>, eptr_handler, error_code) noexcept;
 	void handle_handshake(std::weak_ptr<socket>, eptr_handler, error_code) noexcept;
 	void handle_connect(std::weak_ptr<socket>, const open_opts &, eptr_handler, error_code) noexcept;
+	void handle_race(std::weak_ptr<socket>, std::shared_ptr<race>, const bool &alt, error_code) noexcept;
+	void race_alt(std::weak_ptr<socket>, std::shared_ptr<race>);
 	void handle_timeout(std::weak_ptr<socket>, ec_handler, error_code) noexcept;
 	void handle_ready(std::weak_ptr<socket>, ready, ec_handler, error_code) noexcept;
 
@@ -116,6 +123,7 @@ struct ircd::net::socket
 	void disconnect(const close_opts &, eptr_handler);
 	void handshake(const open_opts &, eptr_handler);
 	void connect(const endpoint &, const open_opts &, eptr_handler);
+	void connect(const endpoint &, const endpoint &alt, const open_opts &, eptr_handler);
 	bool cancel() noexcept;
 
 	socket(asio::ssl::context & = sslv23_client);
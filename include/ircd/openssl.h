@@ -142,6 +142,15 @@ namespace ircd::openssl
 	string_view server_name(const SSL &); // provided by client
 	void server_name(SSL &, const string_view &); // set by client
 
+	// Session suite (client resumption)
+	const_buffer get_session(const mutable_buffer &out, const SSL &); // DER
+	bool set_session(SSL &, const const_buffer &der);
+	bool session_reused(const SSL &);
+
+	// ALPN suite (client)
+	void set_alpn(SSL &, const vector_view<const string_view> &protos);
+	string_view get_alpn(const SSL &);
+
 	// Header version; library version
 	extern const info::versions version_api, version_abi;
 	extern const info::versions libressl_version_api;
@@ -46,3 +46,4 @@ namespace ircd::prof
 #include "times.h"
 #include "system.h"
 #include "psi.h"
+#include "sampler.h"
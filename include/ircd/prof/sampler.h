@@ -0,0 +1,35 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_PROF_SAMPLER_H
+
+/// Sampling profiler of the main thread. The kernel samples the instruction
+/// pointer at a low frequency into a ring; the ring is drained at the end of
+/// every ios handler (including every ctx slice) so each sample is attributed
+/// to the context or handler which was running. The frames above the sampled
+/// function can be supplied by the upper layers with the label closure (i.e.
+/// the vm phase of the current context). The result is exported as folded
+/// stacks for flame graph tools.
+namespace ircd::prof::sampler
+{
+	using label_closure = std::function<string_view (const mutable_buffer &)>;
+	using folded_closure = std::function<bool (const string_view &stack, const uint64_t &count)>;
+
+	bool for_each(const folded_closure &);
+	void drain(const string_view &frame) noexcept;
+	void clear() noexcept;
+	void stop() noexcept;
+	void start(const uint32_t &freq = 0);
+
+	extern bool active;
+	extern uint64_t samples, lost;
+	extern label_closure label;
+}
@@ -20,6 +20,8 @@ struct ircd::resource::method
 
 	static conf::item<seconds> default_timeout;
 	static conf::item<size_t> default_payload_max;
+	static conf::item<uint> shed_level;
+	static conf::item<seconds> shed_retry;
 	static ctx::dock idle_dock;
 
 	struct resource *resource;
@@ -38,6 +40,10 @@ struct ircd::resource::method
   public:
 	response operator()(client &, const http::request::head &, const string_view &content_partial);
 
+	// Admission control for optional work (see SHEDDABLE); shed() throws 503.
+	static bool shedding() noexcept;
+	[[noreturn]] static void shed();
+
 	method(struct resource &, const string_view &name, handler, struct opts);
 	method(struct resource &, const string_view &name, handler);
 	~method() noexcept;
@@ -52,6 +58,7 @@ enum ircd::resource::method::flag
 	CONTENT_DISCRETION    = 0x08,
 	DELAYED_ACK           = 0x10,
 	DELAYED_RESPONSE      = 0x20,
+	SHEDDABLE             = 0x40,   ///< 503 when the server is overloaded
 };
 
 struct ircd::resource::method::opts
@@ -68,6 +75,10 @@ struct ircd::resource::method::opts
 	/// MIME type; first part is the Registry (i.e application) and second
 	/// part is the format (i.e json). Empty value means nothing rejected.
 	std::pair<string_view, string_view> mime;
+
+	/// Tokens taken from the requestor's rate limit by each request; 0 is
+	/// automatic. (see: m::resource)
+	uint cost {0};
 };
 
 struct ircd::resource::method::stats
@@ -79,6 +90,8 @@ struct ircd::resource::method::stats
 	item timeouts;            ///< The method's timeout was exceeded.
 	item completions;         ///< The handler returned without throwing.
 	item internal_errors;     ///< The handler threw a very bad exception.
+	item shed;                ///< Refused by admission control.
+	ircd::stats::histogram latency; ///< Duration of the method's requests.
 
 	stats(method &);
 };
@@ -29,9 +29,12 @@ struct ircd::resource
 	struct request;
 	struct response;
 	struct redirect;
+	struct route;
 
 	static log::log log;
 	static std::map<string_view, resource *, iless> resources;
+	static route routes;
+	static std::multimap<std::string, std::string, iless> lazy;
 
 	string_view path;
 	std::unique_ptr<const struct opts> opts;
@@ -55,6 +58,7 @@ struct ircd::resource
 	resource() = default;
 	~resource() noexcept;
 
+	static bool load(const string_view &path);
 	static resource &find(const string_view &path);
 };
 
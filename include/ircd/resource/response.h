@@ -27,7 +27,9 @@
 /// response HTTP head to the client. The developer has the option to manually
 /// write the content to the client's socket following the transmission of the
 /// head. It is still advised for semantic reasons that the resource::response
-/// object which transmitted the head still be returned from the handler.
+/// object which transmitted the head still be returned from the handler. The
+/// first part of the content may be given to be sent in the same write as the
+/// head; the remainder of content_length is then written by the developer.
 ///
 /// Note that handlers can always throw an exception, and the resource
 /// framework will facilitate the response there.
@@ -39,7 +41,10 @@ struct ircd::resource::response
 	static const size_t HEAD_BUF_SZ;
 	static conf::item<std::string> access_control_allow_origin;
 
-	response(client &, const http::code &, const string_view &content_type, const size_t &content_length, const string_view &headers = {});
+	static const_buffer head(const mutable_buffer &, client &, const http::code &, const string_view &content_type, const size_t &content_length, const string_view &headers = {});
+	static void log_head(const client &, const http::code &, const string_view &content_type, const size_t &content_length, const size_t &wrote_head, const std::exception_ptr & = {});
+
+	response(client &, const http::code &, const string_view &content_type, const size_t &content_length, const string_view &headers = {}, const const_buffer &content = {});
 	response(client &, const string_view &str, const string_view &content_type, const http::code &, const vector_view<const http::header> &);
 	response(client &, const string_view &str, const string_view &content_type, const http::code & = http::OK, const string_view &headers = {});
 	response(client &, const json::object &str, const http::code & = http::OK);
@@ -80,22 +85,37 @@ struct ircd::resource::response
 /// best suited for use by json::stack. A developer wishing to conduct chunked
 /// encoding with some other content has the option of setting a zero buffer
 /// size on construction.
+/// When the client offers it in Accept-Encoding a JSON response is streamed
+/// through a compressor (see chunked::encoder); the Content-Encoding is then
+/// added to the head and every write() takes plain content as usual.
 ///
 struct ircd::resource::response::chunked
 :resource::response
 {
 	struct json;
+	struct encoder;
 
 	static conf::item<size_t> default_buffer_size;
+	static conf::item<size_t> buffers_max;
+	static conf::item<size_t> buffer_min;
+	static stats::item<uint64_t> buffers_count;
+	static stats::item<uint64_t> buffers_bytes;
+	static stats::item<uint64_t> buffers_reduced;
+	static stats::item<uint64_t> slow_writes;
+
+	static size_t reserve(const size_t &buffer_size);
 
 	client *c {nullptr};
 	unique_mutable_buffer _buf;
 	mutable_buffer buf;
+	std::string head;             // response head not yet sent
+	std::unique_ptr<encoder> enc; // content-encoding (if negotiated)
 	size_t flushed {0};
 	size_t wrote {0};
 	uint count {0};
 	bool finished {false};
 
+	size_t _write(const const_buffer &chunk, const bool &ignore_empty);
 	size_t write(const const_buffer &chunk, const bool &ignore_empty = true);
 	const_buffer flush(const const_buffer &);
 	bool finish(const bool psh = false);
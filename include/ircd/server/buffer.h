@@ -0,0 +1,125 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_SERVER_BUFFER_H
+
+namespace ircd::server
+{
+	struct buffer_pool;
+	struct pooled_buffer;
+}
+
+/// Size-classed cache of allocations for request heads and the scratch of
+/// tags. Sizes are rounded up to a power of two from 4 KiB; allocations
+/// released back to their class are kept for the next acquisition, up to
+/// cache_max bytes in total. Larger allocations are never cached.
+struct ircd::server::buffer_pool
+{
+	static constexpr const size_t CLASS_MIN {12}; // log2 4 KiB
+	static constexpr const size_t CLASSES {8};    // .. 512 KiB
+
+	static conf::item<size_t> cache_max;
+	static stats::item<uint64_t> cache_hits;
+	static stats::item<uint64_t> cache_misses;
+	static stats::item<uint64_t> cache_bytes;
+	static stats::item<uint64_t> live_bytes;
+	static std::array<std::vector<void *>, CLASSES> cache;
+
+	static size_t class_of(const size_t &size) noexcept;
+	static size_t class_size(const size_t &size) noexcept;
+
+	static void *acquire(const size_t &size);
+	static void release(void *, const size_t &size) noexcept;
+	static void clear() noexcept;
+};
+
+/// Like unique_buffer, but the allocation comes from and is returned to the
+/// buffer_pool. The buffer spans exactly the requested size even though the
+/// allocation behind it may be larger.
+struct ircd::server::pooled_buffer
+:mutable_buffer
+{
+	explicit operator bool() const;
+	bool operator!() const;
+
+	pooled_buffer() = default;
+	explicit pooled_buffer(const size_t &size);
+	explicit pooled_buffer(const const_buffer &);
+	pooled_buffer(pooled_buffer &&) noexcept;
+	pooled_buffer(const pooled_buffer &) = delete;
+	pooled_buffer &operator=(pooled_buffer &&) & noexcept;
+	pooled_buffer &operator=(const pooled_buffer &) = delete;
+	~pooled_buffer() noexcept;
+};
+
+inline
+ircd::server::pooled_buffer::pooled_buffer(const size_t &size)
+:mutable_buffer
+{
+	size?
+		reinterpret_cast<char *>(buffer_pool::acquire(size)):
+		nullptr,
+	size
+}
+{}
+
+inline
+ircd::server::pooled_buffer::pooled_buffer(const const_buffer &src)
+:pooled_buffer
+{
+	ircd::buffer::size(src)
+}
+{
+	copy(*this, src);
+}
+
+inline
+ircd::server::pooled_buffer::pooled_buffer(pooled_buffer &&other)
+noexcept
+:mutable_buffer
+{
+	other
+}
+{
+	static_cast<mutable_buffer &>(other) = mutable_buffer{};
+}
+
+inline ircd::server::pooled_buffer &
+ircd::server::pooled_buffer::operator=(pooled_buffer &&other)
+& noexcept
+{
+	this->~pooled_buffer();
+	static_cast<mutable_buffer &>(*this) = other;
+	static_cast<mutable_buffer &>(other) = mutable_buffer{};
+	return *this;
+}
+
+inline
+ircd::server::pooled_buffer::~pooled_buffer()
+noexcept
+{
+	if(data(*this))
+		buffer_pool::release(data(*this), ircd::buffer::size(*this));
+}
+
+inline bool
+ircd::server::pooled_buffer::operator!()
+const
+{
+	return this->mutable_buffer::empty();
+}
+
+inline ircd::server::pooled_buffer::operator
+bool()
+const
+{
+	return !this->mutable_buffer::empty();
+}
@@ -21,8 +21,13 @@ namespace ircd::server
 ///
 struct ircd::server::link
 {
+	struct h2c;
+
 	static conf::item<size_t> tag_max_default;
 	static conf::item<size_t> tag_commit_max_default;
+	static conf::item<bool> http2_enable;
+	static conf::item<size_t> http2_streams_max;
+	static conf::item<size_t> http2_window;
 	static uint64_t ids;
 
 	uint64_t id {++ids};                         ///< unique identifier of link.
@@ -39,13 +44,14 @@ struct ircd::server::link
 	bool op_write {false};                       ///< async operation state
 	bool op_read {false};                        ///< async operation state
 	bool exclude {false};                        ///< link is excluded
+	std::unique_ptr<h2c> h2;                     ///< http/2 session if negotiated
 
 	template<class F> size_t accumulate_tags(F&&) const;
 
 	void discard_read();
 	const_buffer read(const mutable_buffer &buf);
 	const_buffer process_read_next(const const_buffer &, tag &, bool &done);
-	bool process_read(const_buffer &, unique_buffer<mutable_buffer> &);
+	bool process_read(const_buffer &, pooled_buffer &);
 	void handle_readable_success();
 	void handle_readable(const error_code &) noexcept;
 	void wait_readable();
@@ -28,6 +28,7 @@ struct ircd::server::peer
 	static conf::item<size_t> link_min_default;
 	static conf::item<size_t> link_max_default;
 	static conf::item<seconds> error_clear_default;
+	static conf::item<seconds> error_clear_min;
 	static conf::item<seconds> remote_ttl_min;
 	static conf::item<seconds> remote_ttl_max;
 	static conf::item<bool> enable_ipv6;
@@ -42,6 +43,7 @@ struct ircd::server::peer
 	uint64_t id {++ids};
 	std::string hostcanon;        // hostname:service[:port]
 	net::ipport remote;
+	net::ipport remote_alt;       // other family raced against remote
 	system_point remote_expires;
 	net::open_opts open_opts;
 	std::list<link> links;
@@ -50,7 +52,19 @@ struct ircd::server::peer
 	size_t write_bytes {0};
 	size_t read_bytes {0};
 	size_t tag_done {0};
-	bool op_resolve {false};
+	microseconds rtt {0};         // moving average of request latency
+	stats::histogram latency;     // distribution of request latency
+	size_t err_streak {0};        // consecutive failures since last success
+	std::string res_host;         // target of the address queries in flight
+	net::ipport res_addr[2];      // answers for res_host: [0] AAAA, [1] A
+	time_t res_ttl[2] {0};
+	std::exception_ptr res_err;   // reason the A query found no address
+	uint8_t res_done {0};         // answered for res_host: 0x01 AAAA, 0x02 A
+	uint8_t res_ok {0};           // answered with an address (same bits)
+	bool res_srv {false};         // SRV query in flight
+	bool res_concluded {false};   // remote was set from the answers
+	bool race_v4 {false};         // the A address won the last race
+	uint8_t op_resolve {0};       // count of DNS queries in flight
 	bool op_fini {false};
 
 	template<class F> size_t accumulate_links(F&&) const;
@@ -61,7 +75,10 @@ struct ircd::server::peer
 	void handle_resolve_A(const hostport &, const json::array &);
 	void handle_resolve_AAAA(const hostport &, const json::array &);
 	void handle_resolve_SRV(const hostport &, const json::array &);
+	void handle_resolve();
+	void set_remote();
 	void resolve(const hostport &, const net::dns::opts &);
+	void resolve_addr(const hostport &);
 	void resolve();
 
 	void cleanup_canceled();
@@ -123,6 +140,7 @@ struct ircd::server::peer
 	// Error related
 	bool err_has() const;
 	string_view err_msg() const;
+	system_point err_expires() const;
 	template<class... A> void err_set(A&&...);
 	bool err_clear();
 	bool err_check();
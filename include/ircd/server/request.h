@@ -76,6 +76,20 @@ struct ircd::server::in
 	/// however the first time it is invoked it is safe to view the in.head
 	std::function<void (const_buffer, const_buffer)> progress;
 
+	/// The sink closure is an optional alternative to accumulating the whole
+	/// content in memory; it only applies with the dynamic feature (see
+	/// below). Content is passed to the sink as it is received, and the
+	/// buffer is only valid for the duration of the call. For a response
+	/// with a content-length the dynamic buffer is only a window of
+	/// request::opts::sink_window bytes reused for every read; for a chunked
+	/// response each chunk is released after it is sunk. The socket is not
+	/// read again until the sink returns, so a slow consumer pushes back on
+	/// the remote through the transport rather than by buffering here. The
+	/// sink must not yield the ircd::ctx; throwing from the sink errors the
+	/// link. When the request completes in.content and in.chunks are empty
+	/// and the progress closure can't view all content received so far.
+	std::function<void (const_buffer)> sink;
+
 	/// The dynamic buffer is a convenience that allows for the content buffer
 	/// to be allocated on demand once the head is received and the length is
 	/// known. To use dynamic, set the content buffer to nothing (i.e default
@@ -181,6 +195,12 @@ struct ircd::server::request::opts
 	/// when false an overflow is an error and an exception is set so the
 	/// user does not process incomplete content.
 	bool truncate_content {false};
+
+	/// Only applies when using dynamic content allocation with an in.sink;
+	/// this is the size of the window allocated to receive content which is
+	/// then handed off to the sink. Larger windows mean fewer calls into the
+	/// sink at the cost of more memory held for the duration of the request.
+	size_t sink_window {64_KiB};
 };
 
 inline
@@ -29,6 +29,7 @@ namespace ircd::server
 	extern conf::item<bool> enable;
 }
 
+#include "buffer.h"
 #include "tag.h"
 #include "request.h"
 #include "link.h"
@@ -50,6 +51,8 @@ namespace ircd::server
 	// const utils
 	string_view errmsg(const net::hostport &) noexcept;
 	bool errant(const net::hostport &) noexcept;
+	system_point backoff(const net::hostport &) noexcept; // errant until
+	microseconds rtt(const net::hostport &) noexcept;
 	bool exists(const net::hostport &) noexcept;
 	bool linked(const net::hostport &) noexcept;
 	bool avail(const net::hostport &) noexcept; // exists() && !errant()
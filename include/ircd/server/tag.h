@@ -39,11 +39,13 @@ struct ircd::server::tag
 		size_t chunk_read {0};         // content read after last chunk head
 		size_t chunk_length {0};       // -1 for chunk header mode
 		http::code status {(http::code)0};
+		bool sink {false};             // content is windowed to in.sink
+		steady_point started {now<steady_point>()};
 	}
 	state;
 	ctx::promise<http::code> p;
 	server::request *request {nullptr};
-	unique_buffer<mutable_buffer> cancellation;
+	pooled_buffer cancellation;
 
 	void set_exception(std::exception_ptr);
 	template<class T, class... args> void set_exception(args&&...);
@@ -67,6 +69,7 @@ struct ircd::server::tag
 	const_buffer read_chunk_dynamic_head(const const_buffer &, bool &done, const uint8_t = 0);
 	const_buffer read_chunk_content(const const_buffer &, bool &done);
 	const_buffer read_chunk_head(const const_buffer &, bool &done, const uint8_t = 0);
+	const_buffer read_content_sink(const const_buffer &, bool &done);
 	const_buffer read_content(const const_buffer &, bool &done);
 	const_buffer read_head(const const_buffer &, bool &done, link &);
 
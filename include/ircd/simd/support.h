@@ -126,3 +126,20 @@ namespace ircd::simd::support
 		#endif
 	};
 }
+
+//
+// Function multi-versioning. Generic (package) builds only target the
+// baseline instruction set, where the wide vector types are emulated with
+// several narrower registers. Kernels which benefit from wider registers can
+// be marked `[[IRCD_SIMD_CLONES]]` and the compiler emits a clone for each
+// target below; the loader selects one (ifunc) by the host's cpuid. Only mark
+// functions taking buffers or scalars; vector arguments by value differ in
+// ABI between the clones.
+//
+
+#if defined(RB_GENERIC) && defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+	#define IRCD_SIMD_CLONES \
+		gnu::target_clones("default", "avx2", "arch=skylake-avx512")
+#else
+	#define IRCD_SIMD_CLONES
+#endif
@@ -72,8 +72,12 @@ namespace ircd::stats
 	template<> struct item<milliseconds>;
 	template<> struct item<seconds>;
 
+	// Distribution item
+	struct histogram;
+
 	extern const size_t NAME_MAX_LEN;
 	extern std::vector<item<void> *> items;
+	extern std::vector<histogram *> histograms;
 
 	string_view string(const mutable_buffer &, const item<void> &);
 	std::ostream &operator<<(std::ostream &, const item<void> &);
@@ -341,3 +345,58 @@ struct ircd::stats::item<ircd::seconds>
 	using int_item<seconds>::int_item;
 	using int_item<seconds>::operator=;
 };
+
+/// Distribution of durations in fixed log-scale buckets. Bucket i counts the
+/// samples up to 2^i microseconds and the last bucket counts the remainder.
+///
+/// Histograms are collected apart from the items because several can share a
+/// name; each is distinguished by the 'labels' feature, an object of strings
+/// (i.e. one histogram for each resource method). Recording a sample does not
+/// allocate.
+struct ircd::stats::histogram
+{
+	static constexpr const size_t BUCKETS
+	{
+		25
+	};
+
+	json::strung feature;
+	json::string name;
+	json::object labels;
+	std::array<uint64_t, BUCKETS> bucket {{0}};
+	uint64_t count {0};
+	nanoseconds sum {0ns};
+
+  public:
+	// Access features
+	string_view operator[](const string_view &key) const noexcept;
+
+	void operator()(const nanoseconds &) noexcept;
+
+	histogram() = default;
+	histogram(const json::members &);
+	histogram(histogram &&) = delete;
+	histogram(const histogram &) = delete;
+	~histogram() noexcept;
+};
+
+inline void
+ircd::stats::histogram::operator()(const nanoseconds &val)
+noexcept
+{
+	const uint64_t us
+	{
+		(uint64_t(std::max(val.count(), 0L)) + 999) / 1000
+	};
+
+	const size_t pos
+	{
+		us > 1?
+			std::min(size_t(64 - __builtin_clzl(us - 1)), BUCKETS - 1):
+			0UL
+	};
+
+	++bucket[pos];
+	++count;
+	sum += val;
+}
@@ -33,6 +33,19 @@ namespace ircd::sys
 	         size_t bufmax = 32>
 	R get(const string_view &path, const R &def = 0);
 
+	// Iterate the numbers of a cpulist(7) string i.e. "0-3,8,10-11"
+	using cpulist_closure = std::function<bool (const uint &)>;
+	bool cpulist(const string_view &list, const cpulist_closure &);
+
+	// CPU affinity of the calling thread from a cpulist; returns count set.
+	size_t affinity(const string_view &cpulist);
+
+	// NUMA node of the CPU the calling thread is on; -1 if unknown.
+	int numa_node() noexcept;
+
+	// Prefer new pages of the range be placed on node; false if unavailable.
+	bool numa_prefer(const mutable_buffer &, const int &node) noexcept;
+
 	extern log::log log;
 }
 
@@ -28,6 +28,9 @@ namespace ircd::utf8
 
 	// Decode utf-8 string into char32_t unicode codepoints
 	u32x16 decode(const u8x16 string) noexcept;
+
+	// Validate utf-8 string (well-formed, shortest form, no surrogates)
+	bool valid(const string_view &) noexcept;
 }
 
 /// Unicode Transformation Format (16-bit)
@@ -369,6 +369,219 @@ noexcept
 {
 }
 
+//
+// allocator::arena
+//
+
+ircd::allocator::arena::arena(const size_t &block_size,
+                              const size_t &retain)
+:block_size{block_size}
+,retain{retain}
+{
+	assert(block_size > 0);
+}
+
+ircd::allocator::arena::~arena()
+noexcept
+{
+}
+
+void
+ircd::allocator::arena::reset()
+noexcept
+{
+	// Keep blocks up to the retain amount for the next region; everything
+	// else goes back to the system here in one shot.
+	size_t kept(0);
+	const auto it
+	{
+		std::remove_if(begin(blocks), end(blocks), [this, &kept]
+		(const auto &block)
+		{
+			if(kept + size(block) > retain)
+				return true;
+
+			kept += size(block);
+			return false;
+		})
+	};
+
+	blocks.erase(it, end(blocks));
+	cur = 0;
+	pos = 0;
+	used = 0;
+}
+
+ircd::mutable_buffer
+ircd::allocator::arena::allocate(const size_t &size,
+                                 const size_t &align)
+{
+	assert(align > 0 && (align & (align - 1)) == 0);
+
+	// Carve from the current block, moving on to any blocks retained from
+	// prior regions when it's exhausted. An oversized request doesn't abandon
+	// the remainder of the current block.
+	const bool oversize(size > block_size);
+	for(; cur < blocks.size(); ++cur, pos = 0)
+	{
+		const mutable_buffer &block(blocks[cur]);
+		const auto start
+		{
+			align_up(data(block) + pos, align)
+		};
+
+		const size_t off(start - data(block));
+		if(likely(off + size <= ircd::size(block)))
+		{
+			pos = off + size;
+			used += size;
+			return mutable_buffer
+			{
+				start, size
+			};
+		}
+
+		if(oversize)
+			break;
+	}
+
+	// Oversized requests get a dedicated block inserted behind the current
+	// block so carving resumes where it left off; otherwise the new block
+	// becomes the current block.
+	const auto it
+	{
+		blocks.emplace(begin(blocks) + cur, unique_mutable_buffer
+		{
+			std::max(size, block_size),
+			std::max(align, alignof(std::max_align_t))
+		})
+	};
+
+	if(oversize)
+		++cur;
+	else
+		pos = size;
+
+	used += size;
+	return mutable_buffer
+	{
+		data(*it), size
+	};
+}
+
+size_t
+ircd::allocator::arena::capacity()
+const noexcept
+{
+	return std::accumulate(begin(blocks), end(blocks), size_t(0), []
+	(const size_t &ret, const auto &block)
+	{
+		return ret + size(block);
+	});
+}
+
+//
+// allocator::hugetlb
+//
+
+ircd::allocator::hugetlb::hugetlb(const size_t &page_size,
+                                  const size_t &size)
+:page_size
+{
+	page_size
+}
+,region{[this, &size]
+() -> mutable_buffer
+{
+	#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+	if(unlikely(!is_powerof2(this->page_size) || this->page_size < info::page_size))
+		throw std::invalid_argument
+		{
+			"hugetlb page size must be a power of two larger than the page size."
+		};
+
+	const size_t len
+	{
+		pad_to(size, this->page_size)
+	};
+
+	// The page size is encoded as its log2 in the high bits of the flags.
+	// Without MAP_NORESERVE the full length is reserved from the pool here
+	// and faults later cannot fail.
+	const int flags
+	{
+		MAP_PRIVATE
+		| MAP_ANONYMOUS
+		| MAP_HUGETLB
+		| (__builtin_ctzl(this->page_size) << MAP_HUGE_SHIFT)
+	};
+
+	void *const ptr
+	{
+		::mmap(nullptr, len, PROT_READ | PROT_WRITE, flags, -1, 0)
+	};
+
+	if(unlikely(ptr == MAP_FAILED))
+		throw_system_error(errno);
+
+	return mutable_buffer
+	{
+		reinterpret_cast<char *>(ptr), len
+	};
+	#else
+	throw std::system_error
+	{
+		make_error_code(std::errc::not_supported)
+	};
+	#endif
+}()}
+{
+}
+
+ircd::allocator::hugetlb::~hugetlb()
+noexcept
+{
+	if(data(region))
+		syscall(::munmap, data(region), ircd::size(region));
+}
+
+void *
+ircd::allocator::hugetlb::allocate(const size_t &size,
+                                   const size_t &alignment_)
+noexcept
+{
+	const size_t alignment
+	{
+		std::max(alignment_, size_t(info::page_size))
+	};
+
+	assert(is_powerof2(alignment));
+	size_t cur(used.load(std::memory_order_relaxed)), off; do
+	{
+		off = pad_to(cur, alignment);
+		if(off + size > ircd::size(region))
+			return nullptr;
+	}
+	while(!used.compare_exchange_weak(cur, off + size, std::memory_order_relaxed));
+
+	return data(region) + off;
+}
+
+bool
+ircd::allocator::hugetlb::has(const void *const &ptr)
+const noexcept
+{
+	const auto p(reinterpret_cast<const char *>(ptr));
+	return p >= begin(region) && p < end(region);
+}
+
+size_t
+ircd::allocator::hugetlb::avail()
+const noexcept
+{
+	return ircd::size(region) - std::min(used.load(), ircd::size(region));
+}
+
 //
 // allocator::profile
 //
@@ -21,6 +21,8 @@ namespace ircd::allocator::je
 
 	extern info::versions malloc_version_api;
 	extern info::versions malloc_version_abi;
+
+	static size_t arena_stat(const unsigned &id, const string_view &key) noexcept;
 }
 
 #if defined(IRCD_ALLOCATOR_USE_JEMALLOC)
@@ -185,3 +187,189 @@ noexcept
 {
 }
 #endif
+
+//
+// arena
+//
+
+decltype(ircd::allocator::je::arena::list)
+ircd::allocator::je::arena::list;
+
+thread_local unsigned
+ircd::allocator::je::arena::current;
+
+/// Reads and iterators of the databases; memtables, table readers and the
+/// buffers RocksDB keeps for longer than a request.
+decltype(ircd::allocator::je::arena::db)
+ircd::allocator::je::arena::db
+{
+	"db"
+};
+
+/// Request handling and response building; short-lived JSON garbage.
+decltype(ircd::allocator::je::arena::json)
+ircd::allocator::je::arena::json
+{
+	"json"
+};
+
+/// Media transfer, thumbnailing and their large buffers.
+decltype(ircd::allocator::je::arena::media)
+ircd::allocator::je::arena::media
+{
+	"media"
+};
+
+ircd::allocator::je::arena::arena(const string_view &name)
+:name
+{
+	name
+}
+,id{[]
+() -> unsigned
+{
+	#if defined(IRCD_ALLOCATOR_JEMALLOC)
+	if(available) try
+	{
+		return allocator::get<unsigned>("arenas.create");
+	}
+	catch(...)
+	{
+		return 0U;
+	}
+	#endif
+
+	return 0U;
+}()}
+{
+	list.emplace_back(this);
+}
+
+ircd::allocator::je::arena::~arena()
+noexcept
+{
+	// The arena itself is not destroyed; memory from it may still be live.
+	list.erase(std::remove(begin(list), end(list), this), end(list));
+}
+
+void
+ircd::allocator::je::arena::select(const unsigned &id)
+noexcept
+{
+	if(id == current)
+		return;
+
+	#if defined(IRCD_ALLOCATOR_JEMALLOC)
+	static size_t mib[2], miblen;
+	if(unlikely(!miblen))
+	{
+		size_t len(2);
+		if(::mallctlnametomib("thread.arena", mib, &len) != 0)
+			return;
+
+		miblen = len;
+	}
+
+	unsigned val(id);
+	if(::mallctlbymib(mib, miblen, nullptr, nullptr, &val, sizeof(val)) != 0)
+		return;
+	#endif
+
+	current = id;
+}
+
+/// Samples the statistics of every arena into its counters. The counters are
+/// registered as ircd.allocator.arena.<name>.<stat> on the first call.
+void
+ircd::allocator::je::arena::refresh()
+noexcept
+{
+	#if defined(IRCD_ALLOCATOR_JEMALLOC)
+	if(!available)
+		return;
+
+	uint64_t epoch(1);
+	size_t len(sizeof(epoch));
+	if(::mallctl("epoch", &epoch, &len, &epoch, len) != 0)
+		return;
+
+	for(auto *const arena : list)
+	{
+		if(!arena->id)
+			continue;
+
+		arena->allocated = arena_stat(arena->id, "small.allocated") + arena_stat(arena->id, "large.allocated");
+		arena->active = arena_stat(arena->id, "pactive") * info::page_size;
+		arena->resident = arena_stat(arena->id, "resident");
+	}
+
+	static std::vector<std::unique_ptr<stats::item<uint64_t *>>> items;
+	if(likely(!items.empty()))
+		return;
+
+	try
+	{
+		for(auto *const arena : list)
+			for(auto *const val : {&arena->allocated, &arena->active, &arena->resident})
+				items.emplace_back(std::make_unique<stats::item<uint64_t *>>(val, json::members
+				{
+					{ "name", fmt::bsprintf<64>
+					{
+						"ircd.allocator.arena.%s.%s",
+						arena->name,
+						val == &arena->allocated? "allocated":
+						val == &arena->active? "active":
+						"resident",
+					}}
+				}));
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			"Failed to register allocator arena statistics :%s",
+			e.what(),
+		};
+	}
+	#endif
+}
+
+size_t
+ircd::allocator::je::arena_stat(const unsigned &id,
+                                const string_view &key)
+noexcept
+{
+	#if defined(IRCD_ALLOCATOR_JEMALLOC)
+	const fmt::bsprintf<96> name
+	{
+		"stats.arenas.%u.%s", id, key
+	};
+
+	size_t ret(0), len(sizeof(ret));
+	if(::mallctl(name.buf, &ret, &len, nullptr, 0) != 0)
+		return 0;
+
+	return ret;
+	#else
+	return 0;
+	#endif
+}
+
+//
+// arena::scope
+//
+
+ircd::allocator::je::arena::scope::scope(const arena &arena)
+:theirs
+{
+	current
+}
+{
+	select(arena.id);
+}
+
+ircd::allocator::je::arena::scope::~scope()
+noexcept
+{
+	select(theirs);
+}
@@ -18,17 +18,22 @@ namespace ircd::b64
 
 	extern const u8
 	encode_permute_tab[64],
-	encode_shift_ctrl[64],
 	decode_permute_tab[64],
 	decode_permute_tab_le[64];
 
-	extern const i32
-	decode_tab[256];
+	[[gnu::always_inline]]
+	static inline u8x64 decode_dict(const u8x64 block, u8x64 &err) noexcept;
 
-	static u8x64 decode_block(const u8x64 block, i64x8 &err) noexcept;
+	[[gnu::always_inline]]
+	static inline u8x64 decode_block(const u8x64 block, i64x8 &err) noexcept;
 
 	template<const dictionary &>
-	static u8x64 encode_block(const u8x64 block) noexcept;
+	[[gnu::always_inline]]
+	static inline u8x64 encode_dict(const u8x64 sextets) noexcept;
+
+	template<const dictionary &>
+	[[gnu::always_inline]]
+	static inline u8x64 encode_block(const u8x64 block) noexcept;
 }
 #pragma GCC visibility pop
 
@@ -62,44 +67,6 @@ alignas(64)
 	'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '_',
 };
 
-decltype(ircd::b64::decode_tab)
-ircd::b64::decode_tab
-alignas(64)
-{
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 7
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 15
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 23
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 31
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 39
-	0x40, 0x40, 0x40,   62,   63,   62, 0x40,   63, // 47
-	  52,   53,   54,   55,   56,   57,   58,   59, // 55
-	  60,   61, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 63
-	0x40,    0,    1,    2,    3,    4,    5,    6, // 71
-	   7,    8,    9,   10,   11,   12,   13,   14, // 79
-	  15,   16,   17,   18,   19,   20,   21,   22, // 87
-	  23,   24,   25, 0x40, 0x40, 0x40, 0x40,   63, // 95
-	0x40,   26,   27,   28,   29,   30,   31,   32, // 103
-	  33,   34,   35,   36,   37,   38,   39,   40, // 111
-	  41,   42,   43,   44,   45,   46,   47,   48, // 119
-	  49,   50,   51, 0x40, 0x40, 0x40, 0x40, 0x40, // 127
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, // 255
-};
-
 decltype(ircd::b64::decode_permute_tab)
 ircd::b64::decode_permute_tab
 alignas(64)
@@ -136,20 +103,6 @@ alignas(64)
 	42 + 1,   42 + 0,   42 + 2,   42 + 1,   45 + 1,   45 + 0,   45 + 2,   45 + 1,
 };
 
-/// For vpmultishiftqb
-decltype(ircd::b64::encode_shift_ctrl)
-ircd::b64::encode_shift_ctrl
-alignas(64)
-{
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-	(10 +  0),  ( 4 +  0),  (22 +  0),  (16 +  0),  (10 + 32),  ( 4 + 32),  (22 + 32),  (16 + 32),
-};
 
 /// Encoding in to base64 at out. Out must be 1.33+ larger than in
 /// padding is not present in the returned view.
@@ -192,6 +145,7 @@ template ircd::string_view ircd::b64::encode<ircd::b64::urlsafe>(const mutable_b
 
 /// Encoding in to base64 at out. Out must be 1.33+ larger than in.
 template<const ircd::b64::dictionary &dict>
+[[IRCD_SIMD_CLONES]]
 ircd::string_view
 ircd::b64::encode_unpadded(const mutable_buffer &out,
                            const const_buffer &in)
@@ -217,9 +171,10 @@ noexcept
 		std::min(res_len, size(out))
 	};
 
-	u8x64 block {0};
+	// Full blocks load 64 bytes for each 48 consumed, so the last block is
+	// left to the remainder loop unless 16 more bytes are readable.
 	size_t i(0), j(0);
-	for(; i < size(in) / 48 && i < out_len / 64; ++i)
+	for(; i * 48 + 64 <= size(in) && i < out_len / 64; ++i)
 	{
 		// Destination is indexed at 64 byte stride
 		const auto di
@@ -233,13 +188,15 @@ noexcept
 			reinterpret_cast<const u512x1_u *__restrict__>(src + (i * 48))
 		};
 
-		block = *si;
-		block = encode_block<dict>(block);
-		*di = block;
+		const u8x64 block(*si);
+		*di = encode_block<dict>(block);
 	}
 
 	for(; i * 48 < size(in) && i * 64 < out_len; ++i)
 	{
+		// The remainder must trail with nulls.
+		u8x64 block {0};
+
 		#if !defined(__AVX__)
 		#pragma clang loop unroll_count(2)
 		#endif
@@ -282,27 +239,62 @@ noexcept
 	for(k = 0; k < 64; ++k)
 		_perm[k] = in[encode_permute_tab[k]];
 
-	// TODO: currently does not achieve vpmultshiftqb on avx512vbmi
-	u64x8 sh[8], perm(_perm);
-	for(i = 0; i < 8; ++i)
-		for(j = 0; j < 8; ++j)
-			sh[i][j] = perm[i] >> encode_shift_ctrl[i * 8 + j];
-
-	// TODO: not needed if vpmultishiftqb is emitted.
-	for(i = 0; i < 8; ++i)
-		for(j = 0; j < 8; ++j)
-			sh[i][j] &= 0x3f;
+	// Each 32-bit lane now holds one input triple {a, b, c} as bytes
+	// {b, a, c, b}; as 16-bit halves that is ab and bc. Each sextet of the
+	// triple is a uniform shift and mask of one half into its output byte.
+	const u32x16 perm(_perm);
+	const u32x16 ab(perm & 0xffff), bc(perm >> 16);
+	const u32x16 sextets
+	{
+		0
+		| (((ab >> 10) & 0x3f) << 0)
+		| (((ab >> 4) & 0x3f) << 8)
+		| (((bc >> 6) & 0x3f) << 16)
+		| (((bc >> 0) & 0x3f) << 24)
+	};
 
-	u32x8 res[8];
-	for(i = 0; i < 8; ++i)
-		for(j = 0; j < 8; ++j)
-			res[i][j] = dict[sh[i][j]];
+	return encode_dict<dict>(u8x64(sextets));
+}
 
-	u8x64 ret;
-	for(i = 0, k = 0; i < 8; ++i)
-		for(j = 0; j < 8; ++j)
-			ret[k++] = res[i][j];
+/// Translates 64 sextets into their characters. Rather than gathering each
+/// from the dictionary, the contiguous ranges of the alphabet are offset
+/// with lane-wise comparisons; only the last two characters, which differ
+/// between dictionaries, are blended in from it.
+template<const ircd::b64::dictionary &dict>
+ircd::u8x64
+ircd::b64::encode_dict(const u8x64 idx)
+noexcept
+{
+	const u8x64 is_lower
+	(
+		idx >= 26
+	);
+
+	const u8x64 is_digit
+	(
+		idx >= 52
+	);
+
+	const u8x64 is_62
+	(
+		idx == 62
+	);
+
+	const u8x64 is_63
+	(
+		idx == 63
+	);
+
+	u8x64 ret
+	{
+		idx + 'A'
+	};
 
+	ret += is_lower & u8('a' - 'A' - 26);
+	ret += is_digit & u8('0' - 'a' - 26);
+	ret &= ~(is_62 | is_63);
+	ret |= is_62 & u8(dict[62]);
+	ret |= is_63 & u8(dict[63]);
 	return ret;
 }
 
@@ -312,6 +304,7 @@ noexcept
 
 /// Decode base64 from in to the buffer at out; out can be 75% of the size
 /// of in.
+[[IRCD_SIMD_CLONES]]
 ircd::const_buffer
 ircd::b64::decode(const mutable_buffer &out,
                   const string_view &in)
@@ -341,10 +334,12 @@ ircd::b64::decode(const mutable_buffer &out,
 		std::min(decode_size(in_len), size(out))
 	};
 
+	// Full blocks store 64 bytes for each 48 produced, so the last block is
+	// left to the remainder loop unless 16 more bytes are writable.
 	i64x8 err {0};
 	u8x64 block {0};
 	size_t i(0), j(0);
-	for(; i < in_len / 64 && i < out_len / 48; ++i)
+	for(; i < in_len / 64 && i * 48 + 64 <= size(out); ++i)
 	{
 		// Destination is indexed at 48 byte stride
 		const auto di
@@ -399,17 +394,16 @@ noexcept
 {
 	size_t i, j;
 
+	u8x64 _err;
+	const u8x64 sextets
+	{
+		decode_dict(block, _err)
+	};
+
 	i32x16 vals[4];
 	for(i = 0; i < 4; ++i)
 		for(j = 0; j < 16; ++j)
-			vals[i][j] = block[i * 16 + j],
-			vals[i][j] = decode_tab[vals[i][j]];
-
-	u8x64 _err;
-	i32x16 errs;
-	for(i = 0; i < 4; ++i)
-		for(j = 0, errs = vals[i] >= 64; j < 16; ++j)
-			_err[i * 16 + j] = errs[j];
+			vals[i][j] = sextets[i * 16 + j];
 
 	u16x32 al, ah;
 	for(i = 0; i < 4; ++i)
@@ -432,3 +426,49 @@ noexcept
 	err |= i64x8(_err);
 	return ret;
 }
+
+/// Translates 64 characters of any of the dictionaries into their sextets,
+/// the inverse of encode_dict(). Lanes not in any dictionary are set in err.
+ircd::u8x64
+ircd::b64::decode_dict(const u8x64 in,
+                       u8x64 &__restrict__ err)
+noexcept
+{
+	const u8x64 is_upper
+	(
+		in >= 'A' && in <= 'Z'
+	);
+
+	const u8x64 is_lower
+	(
+		in >= 'a' && in <= 'z'
+	);
+
+	const u8x64 is_digit
+	(
+		in >= '0' && in <= '9'
+	);
+
+	const u8x64 is_62
+	(
+		in == '+' || in == '-'
+	);
+
+	const u8x64 is_63
+	(
+		in == '/' || in == '_' || in == ','
+	);
+
+	const u8x64 ret
+	{
+		0
+		| (is_upper & u8x64(in - 'A'))
+		| (is_lower & u8x64(in - 'a' + 26))
+		| (is_digit & u8x64(in - '0' + 52))
+		| (is_62 & 62)
+		| (is_63 & 63)
+	};
+
+	err = ~(is_upper | is_lower | is_digit | is_62 | is_63);
+	return ret;
+}
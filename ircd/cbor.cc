@@ -108,3 +108,517 @@ ircd::cbor::reflect(const enum major &major)
 
 	return "??????";
 }
+
+//
+// transcoding
+//
+
+namespace ircd::cbor
+{
+	constexpr uint depth_max {128};
+
+	static void put(mutable_buffer &, const const_buffer &);
+	static void put(mutable_buffer &, const uint8_t &major, const uint64_t &val);
+	static void encode_string(mutable_buffer &, const json::string &);
+	static void encode_number(mutable_buffer &, const string_view &);
+	static void encode_value(mutable_buffer &, const string_view &, const uint &depth);
+
+	static const_buffer take(const_buffer &, const size_t &);
+	static uint64_t head(const_buffer &, uint8_t &major, uint8_t &minor);
+	static void stringify_string(mutable_buffer &, const string_view &);
+	static void stringify_value(mutable_buffer &, const_buffer &, const uint &depth);
+}
+
+ircd::const_buffer
+ircd::cbor::encode(const mutable_buffer &buf,
+                   const string_view &json)
+{
+	mutable_buffer out{buf};
+	encode_value(out, json, 0);
+	return const_buffer
+	{
+		data(buf), data(out)
+	};
+}
+
+void
+ircd::cbor::encode_value(mutable_buffer &out,
+                         const string_view &value,
+                         const uint &depth)
+{
+	if(unlikely(depth >= depth_max))
+		throw error
+		{
+			"Exceeded maximum depth of %u.",
+			depth_max,
+		};
+
+	switch(json::type(value))
+	{
+		case json::OBJECT:
+		{
+			const json::object object
+			{
+				value
+			};
+
+			std::vector<json::object::member> members
+			(
+				begin(object), end(object)
+			);
+
+			// Canonical JSON orders members by the codepoints of the
+			// unescaped key; UTF-8 preserves that order bytewise.
+			std::sort(begin(members), end(members), []
+			(const auto &a, const auto &b)
+			{
+				const json::string key[2]
+				{
+					a.first, b.first
+				};
+
+				if(likely(!has(key[0], '\\') && !has(key[1], '\\')))
+					return key[0] < key[1];
+
+				thread_local char buf[2][4_KiB];
+				return string_view(unescape(buf[0], key[0])) < string_view(unescape(buf[1], key[1]));
+			});
+
+			put(out, major::OBJECT, members.size());
+			for(const auto &[key, val] : members)
+			{
+				encode_string(out, key);
+				encode_value(out, val, depth + 1);
+			}
+
+			return;
+		}
+
+		case json::ARRAY:
+		{
+			const json::array array
+			{
+				value
+			};
+
+			put(out, major::ARRAY, array.count());
+			for(const string_view &val : array)
+				encode_value(out, val, depth + 1);
+
+			return;
+		}
+
+		case json::STRING:
+			encode_string(out, value);
+			return;
+
+		case json::NUMBER:
+			encode_number(out, value);
+			return;
+
+		case json::LITERAL:
+		{
+			const uint8_t minor
+			{
+				value == "true"? minor::TRUE:
+				value == "false"? minor::FALSE:
+				minor::NUL
+			};
+
+			put(out, major::PRIMITIVE, minor);
+			return;
+		}
+	}
+}
+
+void
+ircd::cbor::encode_string(mutable_buffer &out,
+                          const json::string &string)
+{
+	// The unescaped text is never longer than its JSON form, so it's written
+	// after room for the largest head and then moved up behind the actual.
+	if(unlikely(size(out) < size(string) + 9))
+		throw buffer_overrun
+		{
+			"Insufficient buffer for string of %zu bytes.",
+			size(string),
+		};
+
+	const const_buffer text
+	{
+		unescape(out + 9, string)
+	};
+
+	char head_buf[9];
+	mutable_buffer head{head_buf};
+	put(head, major::STRING, size(text));
+	const size_t head_len(data(head) - head_buf);
+	memmove(data(out) + head_len, data(text), size(text));
+	memcpy(data(out), head_buf, head_len);
+	consume(out, head_len + size(text));
+}
+
+void
+ircd::cbor::encode_number(mutable_buffer &out,
+                          const string_view &number)
+{
+	const bool floating
+	{
+		number.find_first_of(".eE") != number.npos
+	};
+
+	if(floating)
+	{
+		const uint64_t val
+		{
+			htobe64(byte_view<uint64_t>{byte_view<string_view>{lex_cast<double>(number)}})
+		};
+
+		const uint8_t head[1]
+		{
+			uint8_t(major::PRIMITIVE << 5 | minor::F64)
+		};
+
+		put(out, const_buffer{reinterpret_cast<const char *>(head), 1});
+		put(out, const_buffer{reinterpret_cast<const char *>(&val), sizeof(val)});
+		return;
+	}
+
+	const int64_t val
+	{
+		lex_cast<int64_t>(number)
+	};
+
+	if(val < 0)
+		put(out, major::NEGATIVE, uint64_t(-1L - val));
+	else
+		put(out, major::POSITIVE, uint64_t(val));
+}
+
+void
+ircd::cbor::put(mutable_buffer &out,
+                const uint8_t &major,
+                const uint64_t &val)
+{
+	const uint8_t minor
+	{
+		val < 24? uint8_t(val):
+		val <= 0xffUL? uint8_t(minor::U8):
+		val <= 0xffffUL? uint8_t(minor::U16):
+		val <= 0xffffffffUL? uint8_t(minor::U32):
+		uint8_t(minor::U64)
+	};
+
+	const uint64_t be
+	{
+		htobe64(val)
+	};
+
+	const size_t len
+	{
+		_length(major << 5 | minor) - 1
+	};
+
+	char head[9];
+	head[0] = major << 5 | minor;
+	memcpy(head + 1, reinterpret_cast<const char *>(&be) + 8 - len, len);
+	put(out, const_buffer{head, 1 + len});
+}
+
+void
+ircd::cbor::put(mutable_buffer &out,
+                const const_buffer &in)
+{
+	if(unlikely(size(in) > size(out)))
+		throw buffer_overrun
+		{
+			"Insufficient buffer for %zu more bytes.",
+			size(in),
+		};
+
+	consume(out, copy(out, in));
+}
+
+ircd::string_view
+ircd::cbor::stringify(const mutable_buffer &buf,
+                      const const_buffer &cbor)
+{
+	mutable_buffer out{buf};
+	const_buffer in{cbor};
+	stringify_value(out, in, 0);
+	if(unlikely(!empty(in)))
+		throw parse_error
+		{
+			"%zu bytes trailing the item.",
+			size(in),
+		};
+
+	return string_view
+	{
+		data(buf), data(out)
+	};
+}
+
+void
+ircd::cbor::stringify_value(mutable_buffer &out,
+                            const_buffer &in,
+                            const uint &depth)
+{
+	if(unlikely(depth >= depth_max))
+		throw parse_error
+		{
+			"Exceeded maximum depth of %u.",
+			depth_max,
+		};
+
+	uint8_t major, minor;
+	const uint64_t val
+	{
+		head(in, major, minor)
+	};
+
+	switch(major)
+	{
+		case major::POSITIVE:
+		{
+			char buf[24];
+			put(out, lex_cast(val, buf));
+			return;
+		}
+
+		case major::NEGATIVE:
+		{
+			char buf[24];
+			put(out, "-"_sv);
+			put(out, val == -1UL? "18446744073709551616"_sv: lex_cast(val + 1, buf));
+			return;
+		}
+
+		case major::BINARY:
+		case major::STRING:
+			stringify_string(out, take(in, val));
+			return;
+
+		case major::ARRAY:
+			put(out, "["_sv);
+			for(uint64_t i(0); i < val; ++i)
+			{
+				if(i)
+					put(out, ","_sv);
+
+				stringify_value(out, in, depth + 1);
+			}
+
+			put(out, "]"_sv);
+			return;
+
+		case major::OBJECT:
+			put(out, "{"_sv);
+			for(uint64_t i(0); i < val; ++i)
+			{
+				if(i)
+					put(out, ","_sv);
+
+				uint8_t key_major, key_minor;
+				const uint64_t key_len
+				{
+					head(in, key_major, key_minor)
+				};
+
+				if(unlikely(key_major != major::STRING))
+					throw type_error
+					{
+						"Object key must be a STRING not %s.",
+						reflect(cbor::major(key_major)),
+					};
+
+				stringify_string(out, take(in, key_len));
+				put(out, ":"_sv);
+				stringify_value(out, in, depth + 1);
+			}
+
+			put(out, "}"_sv);
+			return;
+
+		case major::TAG:
+			stringify_value(out, in, depth + 1);
+			return;
+
+		case major::PRIMITIVE:
+			break;
+
+		default:
+			__builtin_unreachable();
+	}
+
+	switch(minor)
+	{
+		case minor::FALSE:
+			put(out, "false"_sv);
+			return;
+
+		case minor::TRUE:
+			put(out, "true"_sv);
+			return;
+
+		case minor::NUL:
+		case minor::UD:
+			put(out, "null"_sv);
+			return;
+
+		case minor::F16:
+		{
+			// IEEE754 half-precision; expanded by hand (RFC7049 Appendix D)
+			const int exp((val >> 10) & 0x1f), mant(val & 0x3ff);
+			const double mag
+			{
+				exp == 0? std::ldexp(mant, -24):
+				exp != 31? std::ldexp(mant + 1024, exp - 25):
+				mant == 0? INFINITY: NAN
+			};
+
+			char buf[64];
+			put(out, lex_cast(val & 0x8000? -mag: mag, buf));
+			return;
+		}
+
+		case minor::F32:
+		{
+			char buf[64];
+			const uint32_t bits(val);
+			const float f
+			{
+				byte_view<float>{byte_view<string_view>{bits}}
+			};
+
+			put(out, lex_cast(double(f), buf));
+			return;
+		}
+
+		case minor::F64:
+		{
+			char buf[64];
+			const double d
+			{
+				byte_view<double>{byte_view<string_view>{val}}
+			};
+
+			put(out, lex_cast(d, buf));
+			return;
+		}
+
+		default:
+			throw type_error
+			{
+				"Unsupported simple value (%lu).",
+				val,
+			};
+	}
+}
+
+void
+ircd::cbor::stringify_string(mutable_buffer &out,
+                             const string_view &text)
+{
+	// Canonical JSON escapes only the quote, the backslash and the control
+	// characters; everything else is emitted as its UTF-8.
+	static const char hex[]
+	{
+		"0123456789abcdef"
+	};
+
+	put(out, "\""_sv);
+	for(const char &c : text)
+	{
+		const char *esc; switch(c)
+		{
+			case '"':   esc = "\\\"";   break;
+			case '\\':  esc = "\\\\";   break;
+			case '\b':  esc = "\\b";    break;
+			case '\f':  esc = "\\f";    break;
+			case '\n':  esc = "\\n";    break;
+			case '\r':  esc = "\\r";    break;
+			case '\t':  esc = "\\t";    break;
+			default:
+			{
+				if(likely(uint8_t(c) >= 0x20))
+				{
+					put(out, const_buffer{&c, 1});
+					continue;
+				}
+
+				const char u[6]
+				{
+					'\\', 'u', '0', '0', hex[uint8_t(c) >> 4], hex[uint8_t(c) & 0x0f]
+				};
+
+				put(out, const_buffer{u, sizeof(u)});
+				continue;
+			}
+		}
+
+		put(out, string_view{esc});
+	}
+
+	put(out, "\""_sv);
+}
+
+uint64_t
+ircd::cbor::head(const_buffer &in,
+                 uint8_t &major,
+                 uint8_t &minor)
+{
+	const const_buffer lead
+	{
+		take(in, 1)
+	};
+
+	major = _major(lead[0]);
+	minor = _minor(lead[0]);
+	if(unlikely(minor == minor::STREAM))
+		throw type_error
+		{
+			"Indefinite length %s is not supported.",
+			reflect(cbor::major(major)),
+		};
+
+	const size_t len
+	{
+		_length(lead[0]) - 1
+	};
+
+	if(!len)
+		return minor;
+
+	const const_buffer following
+	{
+		take(in, len)
+	};
+
+	uint64_t ret(0);
+	for(size_t i(0); i < len; ++i)
+		ret = ret << 8 | uint8_t(following[i]);
+
+	return ret;
+}
+
+ircd::const_buffer
+ircd::cbor::take(const_buffer &in,
+                 const size_t &len)
+{
+	if(unlikely(len > size(in)))
+		throw buffer_underrun
+		{
+			"Need %zu more bytes; have %zu.",
+			len,
+			size(in),
+		};
+
+	const const_buffer ret
+	{
+		data(in), len
+	};
+
+	consume(in, len);
+	return ret;
+}
@@ -56,6 +56,20 @@ namespace ircd::cl
 	static void handle_notify(const char *, const void *, size_t, void *) noexcept;
 }
 
+// SHA-256 batch kernel
+namespace ircd::cl
+{
+	extern conf::item<bool> sha256_enable;
+	extern conf::item<size_t> sha256_batch_min;
+	extern const string_view sha256_source;
+
+	static std::optional<code> sha256_code;
+	static std::optional<kern> sha256_kern;
+	static std::mutex sha256_mutex;
+
+	static bool sha256_init();
+}
+
 decltype(ircd::cl::log)
 ircd::cl::log
 {
@@ -209,6 +223,8 @@ noexcept
 		sync();
 	}
 
+	sha256_kern.reset();
+	sha256_code.reset();
 	for(size_t i(0); i < PLATFORM_MAX; ++i)
 		for(size_t j(0); j < DEVICE_MAX; ++j)
 			if(queue[i][j])
@@ -258,6 +274,260 @@ ircd::cl::flush()
 	);
 }
 
+//
+// sha256
+//
+
+decltype(ircd::cl::sha256_enable)
+ircd::cl::sha256_enable
+{
+	{ "name",      "ircd.cl.sha256.enable" },
+	{ "default",   true                    },
+};
+
+decltype(ircd::cl::sha256_batch_min)
+ircd::cl::sha256_batch_min
+{
+	{ "name",      "ircd.cl.sha256.batch.min" },
+	{ "default",   512L                       },
+	{ "description",
+
+	R"(
+	The fewest inputs worth a trip to the device; smaller batches are cheaper
+	to hash on the host than to transfer and launch.
+	)"},
+};
+
+/// Each work-item hashes one message. The messages are packed end to end in
+/// msg; idx holds an (offset, length) pair for each of them.
+decltype(ircd::cl::sha256_source)
+ircd::cl::sha256_source
+{R"(
+__constant uint K[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROTR(x, n) rotate((uint)(x), (uint)(32 - (n)))
+
+__kernel void
+ircd_sha256(__global const uchar *const msg,
+            __global const uint *const idx,
+            __global uchar *const out)
+{
+	const uint i = get_global_id(0);
+	const uint off = idx[i * 2 + 0];
+	const uint len = idx[i * 2 + 1];
+	const ulong bits = (ulong)len * 8;
+	const uint blocks = (len + 9 + 63) / 64;
+	const uint end = blocks * 64;
+
+	uint h[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+
+	uint w[64];
+	for(uint b = 0; b < blocks; ++b)
+	{
+		for(uint t = 0; t < 16; ++t)
+		{
+			uint word = 0;
+			for(uint k = 0; k < 4; ++k)
+			{
+				const uint p = b * 64 + t * 4 + k;
+				const uint c =
+					p < len? msg[off + p]:
+					p == len? 0x80:
+					p >= end - 8? (uint)(bits >> ((end - 1 - p) * 8)) & 0xff:
+					0;
+
+				word = (word << 8) | c;
+			}
+
+			w[t] = word;
+		}
+
+		for(uint t = 16; t < 64; ++t)
+		{
+			const uint s0 = ROTR(w[t - 15], 7) ^ ROTR(w[t - 15], 18) ^ (w[t - 15] >> 3);
+			const uint s1 = ROTR(w[t - 2], 17) ^ ROTR(w[t - 2], 19) ^ (w[t - 2] >> 10);
+			w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+		}
+
+		uint a = h[0], b_ = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+		for(uint t = 0; t < 64; ++t)
+		{
+			const uint S1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+			const uint ch = (e & f) ^ (~e & g);
+			const uint t1 = hh + S1 + ch + K[t] + w[t];
+			const uint S0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+			const uint maj = (a & b_) ^ (a & c) ^ (b_ & c);
+			const uint t2 = S0 + maj;
+			hh = g; g = f; f = e; e = d + t1;
+			d = c; c = b_; b_ = a; a = t1 + t2;
+		}
+
+		h[0] += a; h[1] += b_; h[2] += c; h[3] += d;
+		h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+	}
+
+	for(uint k = 0; k < 8; ++k)
+	{
+		out[i * 32 + k * 4 + 0] = (uchar)(h[k] >> 24);
+		out[i * 32 + k * 4 + 1] = (uchar)(h[k] >> 16);
+		out[i * 32 + k * 4 + 2] = (uchar)(h[k] >> 8);
+		out[i * 32 + k * 4 + 3] = (uchar)(h[k]);
+	}
+}
+)"};
+
+/// The inputs are packed into one transfer with their index; the digests
+/// come back in a single read. Any failure leaves the batch to the host.
+bool
+ircd::cl::sha256(const mutable_buffer &out,
+                 const vector_view<const const_buffer> &in)
+try
+{
+	static const auto &digest_size
+	{
+		crh::sha256::digest_size
+	};
+
+	if(!primary || !sha256_enable || in.size() < size_t(sha256_batch_min))
+		return false;
+
+	size_t total(0);
+	for(const auto &buf : in)
+		total += ircd::size(buf);
+
+	if(unlikely(total > std::numeric_limits<uint32_t>::max()))
+		return false;
+
+	const unique_mutable_buffer msg
+	{
+		std::max(total, 1UL)
+	};
+
+	const unique_mutable_buffer idx
+	{
+		in.size() * 2 * sizeof(uint32_t)
+	};
+
+	const auto _idx
+	{
+		reinterpret_cast<uint32_t *>(ircd::data(idx))
+	};
+
+	for(size_t i(0), off(0); i < in.size(); off += ircd::size(in[i]), ++i)
+	{
+		_idx[i * 2 + 0] = off;
+		_idx[i * 2 + 1] = ircd::size(in[i]);
+		memcpy(ircd::data(msg) + off, ircd::data(in[i]), ircd::size(in[i]));
+	}
+
+	const mutable_buffer digests
+	{
+		ircd::data(out), in.size() * digest_size
+	};
+
+	data msg_data
+	{
+		const_buffer{msg}
+	};
+
+	data idx_data
+	{
+		const_buffer{idx}
+	};
+
+	data out_data
+	{
+		ircd::size(digests), true, true
+	};
+
+	kern::range range;
+	range.global[0] = in.size();
+	{
+		// The arguments are bound to the kernel until it's enqueued; offload
+		// threads may be doing the same. The lock is not held while waiting.
+		std::unique_lock lock
+		{
+			sha256_mutex
+		};
+
+		if(unlikely(!sha256_kern) && !sha256_init())
+			return false;
+
+		sha256_kern->arg(0, msg_data);
+		sha256_kern->arg(1, idx_data);
+		sha256_kern->arg(2, out_data);
+
+		const exec kernel
+		{
+			*sha256_kern, range
+		};
+
+		const exec read
+		{
+			out_data, digests
+		};
+
+		flush();
+		lock.unlock();
+	}
+
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "SHA-256 batch of %zu :%s",
+		in.size(),
+		e.what(),
+	};
+
+	return false;
+}
+
+bool
+ircd::cl::sha256_init()
+try
+{
+	sha256_code.emplace(sha256_source);
+	sha256_code->build();
+	sha256_kern.emplace(*sha256_code, "ircd_sha256");
+
+	log::debug
+	{
+		log, "SHA-256 batch kernel built.",
+	};
+
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "SHA-256 batch kernel unavailable :%s",
+		e.what(),
+	};
+
+	sha256_kern.reset();
+	sha256_code.reset();
+	sha256_enable.set("false");
+	return false;
+}
+
 //
 // exec
 //
@@ -289,7 +559,7 @@ try
 		dim,
 		work.offset.data(),
 		work.global.data(),
-		work.local.data(),
+		work.local[0]? work.local.data(): nullptr,
 		dependencies,
 		dependency,
 		reinterpret_cast<cl_event *>(&this->handle)
@@ -365,13 +635,13 @@ try
 
 	call
 	(
-		clEnqueueReadBuffer,
+		clEnqueueWriteBuffer,
 		q,
 		cl_mem(data.handle),
 		blocking,
 		0UL, //offset,
 		ircd::size(buf),
-		mutable_cast(ircd::data(buf)),
+		ircd::data(buf),
 		dependencies,
 		dependency,
 		reinterpret_cast<cl_event *>(&this->handle)
@@ -533,19 +803,11 @@ catch(const std::exception &e)
 	return;
 }
 
-namespace ircd::cl
-{
-	static void
-	handle_built(cl_program program, void *priv)
-	{
-		ircd::always_assert(false);
-	}
-}
-
 void
 ircd::cl::code::build(const string_view &opts)
 try
 {
+	// Without a notify callback the build completes before returning.
 	const uint num_devices {0};
 	const cl_device_id *const device_list {nullptr};
 	call
@@ -555,7 +817,7 @@ try
 		num_devices,
 		device_list,
 		opts.c_str(),
-		&cl::handle_built,
+		nullptr,
 		nullptr
 	);
 }
@@ -699,7 +961,14 @@ noexcept try
 		cl_event(this->handle)
 	};
 
-	if(likely(handle))
+	// Off the ircd thread (i.e. an offload thread) there's no ctx to yield;
+	// that thread simply blocks until the work is complete.
+	if(likely(handle) && !ctx::current)
+	{
+		call(clWaitForEvents, 1U, &handle);
+		call(clReleaseEvent, cl_event(handle));
+	}
+	else if(likely(handle))
 	{
 		struct handle_event_data hdata;
 		call(clSetEventCallback, handle, CL_COMPLETE, &cl::handle_event, &hdata);
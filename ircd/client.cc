@@ -46,6 +46,78 @@ ircd::client::settings::pool_size
 	}
 };
 
+ircd::conf::item<size_t>
+ircd::client::settings::pool_max
+{
+	{
+		{ "name",     "ircd.client.pool_max"  },
+		{ "default",  256L                    },
+		{ "description",
+		R"(
+		Upper bound for the request pool when it grows on demand beyond its
+		pool_size. Growth occurs when all contexts are occupied and requests
+		have queued longer than pool_grow_latency; e.g. a few slow requests
+		occupying the pool. The added contexts exit after idling. Setting this
+		to zero or below pool_size disables growth.
+		)"},
+	}, []
+	{
+		using client = ircd::client;
+		client::pool_opts.ctxs_max = client::settings::pool_max;
+	}
+};
+
+ircd::conf::item<ircd::milliseconds>
+ircd::client::settings::pool_grow_latency
+{
+	{
+		{ "name",     "ircd.client.pool_grow_latency"  },
+		{ "default",  50L                              },
+	}, []
+	{
+		using client = ircd::client;
+		client::pool_opts.grow_latency = client::settings::pool_grow_latency;
+	}
+};
+
+ircd::conf::item<size_t>
+ircd::client::settings::http2_streams_max
+{
+	{ "name",     "ircd.client.http2.streams.max" },
+	{ "default",  32L                             },
+};
+
+ircd::conf::item<size_t>
+ircd::client::settings::http2_window
+{
+	{ "name",     "ircd.client.http2.window" },
+	{ "default",  ssize_t(1_MiB)             },
+};
+
+ircd::conf::item<size_t>
+ircd::client::settings::http2_content_max
+{
+	{ "name",     "ircd.client.http2.content.max" },
+	{ "default",  ssize_t(128_MiB)                },
+	{ "help",     "Request content is received entirely before dispatch; its limit." },
+};
+
+ircd::conf::item<size_t>
+ircd::client::settings::arena_block_size
+{
+	{ "name",     "ircd.client.arena.block_size" },
+	{ "default",  ssize_t(64_KiB)                },
+	{ "help",     "Size of each block the request arena carves allocations from." },
+};
+
+ircd::conf::item<size_t>
+ircd::client::settings::arena_retain
+{
+	{ "name",     "ircd.client.arena.retain" },
+	{ "default",  ssize_t(512_KiB)           },
+	{ "help",     "Arena blocks kept by a client between requests for reuse." },
+};
+
 /// Linkage for the default settings
 decltype(ircd::client::settings)
 ircd::client::settings
@@ -92,6 +164,16 @@ ircd::client::pool_opts
 {
 	size_t(settings.stack_size),
 	size_t(settings.pool_size),
+	-1,     // No hard limit
+	0,      // Soft limit at any queued
+	true,   // Yield before hitting soft limit
+	true,   // Warn when soft limit exceeded
+	0,      // ionice
+	int8_t(ctx::sched::INTERACTIVE),
+	size_t(settings.pool_max),
+	milliseconds(settings.pool_grow_latency),
+	30s,    // Grown contexts exit after idling
+	true,   // Register stats
 };
 
 /// The pool of request contexts. When a client makes a request it does so by acquiring
@@ -112,6 +194,77 @@ decltype(ircd::client::ctr)
 ircd::client::ctr
 {};
 
+/// HTTP/2 session of a connection which negotiated h2 with ALPN. The
+/// connection's client reads frames in bursts from the request pool like the
+/// wakeup of any other client. Each complete request is translated into
+/// HTTP/1.1 and dispatched to the pool as a client of its own stream; the
+/// HTTP/1.1 response it writes is translated back into frames. Streams share
+/// the socket under the mutex; the dock notifies flow control updates.
+struct ircd::client::h2c
+{
+	struct stream
+	{
+		std::weak_ptr<ircd::client> owner;
+		std::string request;                   // translated head; then content
+		size_t head_size {0};
+		size_t recv_unacked {0};
+		ssize_t send_window {0};
+		bool dispatched {false};
+
+		std::string head;                      // response head until complete
+		std::string line;                      // response chunk head
+		size_t length {size_t(-1)};            // response content remaining
+		size_t chunk {0};                      // response chunk remaining
+		uint8_t crlf {0};                      // response chunk terminator
+		bool head_sent {false};
+		bool chunked {false};
+		bool trailer {false};
+		bool ended {false};                    // END_STREAM sent
+	};
+
+	std::shared_ptr<net::socket> sock;
+	net::ipport remote;
+	net::ipport local;
+	http2::hpack::table table;
+	std::map<uint32_t, stream> streams;
+	std::string in;                            // partial frame received
+	std::string out;                           // frames from the reader
+	std::string block;                         // header block being received
+	uint32_t block_id {0};
+	bool block_end {false};
+	bool settings_sent {false};
+	bool preface {false};
+	bool goaway {false};
+	uint32_t last_id {0};
+	size_t recv_unacked {0};
+	ssize_t send_window {65535};
+	ssize_t initial_window {65535};
+	size_t max_frame {16384};
+	ctx::mutex mutex;
+	ctx::dock dock;
+
+	stream &find(const client &);
+	void send(const string_view &);
+	bool wait(const client &, std::string &out);
+	void write_data(const client &, std::string &out, const const_buffer &, const bool &end);
+	size_t write_head(const client &, std::string &out, const const_buffer &);
+	size_t write_chunked(const client &, std::string &out, const const_buffer &);
+	void dispatch(client &conn, const uint32_t &id);
+	void handle_head(client &conn, const uint32_t &id, const bool &end);
+	void handle_headers(client &conn, const http2::frame::header &, const const_buffer &);
+	void handle_data(client &conn, const http2::frame::header &, const const_buffer &);
+	void handle_settings(const http2::frame::header &, const const_buffer &);
+	void handle_frame(client &conn, const http2::frame::header &, const const_buffer &);
+
+  public:
+	bool active() const;
+	void finish(client &, const bool &reset);
+	size_t write(client &, const net::const_buffers &);
+	bool main(client &conn);
+
+	h2c(std::shared_ptr<net::socket>, const net::ipport &remote, const net::ipport &local);
+};
+
 // Linkage for the container of all active clients for iteration purposes.
 template<>
 decltype(ircd::util::instance_multimap<ircd::net::ipport, ircd::client, ircd::net::ipport::cmp_ip>::map)
@@ -154,6 +307,64 @@ ircd::client::spawn()
 	pool.add(size_t(settings.pool_size));
 }
 
+/// Resume a client parked by its request handler. The closure is executed
+/// on a context from the request pool to complete the response. If it returns
+/// true the client goes back to async mode for its next request (unless it
+/// was parked again); otherwise the client is disconnected.
+void
+ircd::client::resume(std::shared_ptr<client> client,
+                     std::function<bool (ircd::client &)> closure)
+{
+	assert(client);
+	assert(client->parked);
+	auto handler{[client(std::move(client)), closure(std::move(closure))]
+	{
+		assert(ctx::current);
+		assert(!client->reqctx);
+		client->reqctx = ctx::current;
+		client->parked = false;
+		client->ready_count++;
+		const unwind reset{[&client]
+		{
+			assert(client->reqctx == ctx::current);
+			client->reqctx = nullptr;
+			if(client::pool.avail() <= 1)
+				client::dock.notify_all();
+		}};
+
+		bool ret {false}; try
+		{
+			ret = closure(*client);
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "%s resume :%s",
+				client->loghead(),
+				e.what()
+			};
+
+			client->parked = false;
+			client->close(net::dc::RST, net::close_ignore);
+			return;
+		}
+
+		if(client->parked)
+			return;
+
+		if(!ret)
+		{
+			client->close(net::dc::SSL_NOTIFY).wait();
+			return;
+		}
+
+		client->async();
+	}};
+
+	pool(std::move(handler));
+}
+
 void
 ircd::client::wait_all()
 {
@@ -299,6 +510,14 @@ ircd::read(client &client,
            char *&start,
            char *const &stop)
 {
+	// The request of a stream was received entirely before dispatch; the
+	// parser wanting more here means it's truncated.
+	if(unlikely(client.stream_id))
+		throw http::error
+		{
+			http::BAD_REQUEST
+		};
+
 	assert(client.sock);
 	auto &sock(*client.sock);
 	const mutable_buffer buf
@@ -355,15 +574,26 @@ namespace ircd
 bool
 ircd::client::async()
 {
+	// The response of a stream is complete; there is no next request.
+	if(stream_id)
+	{
+		assert(h2);
+		h2->finish(*this, false);
+		return false;
+	}
+
 	assert(bool(this->sock));
 	assert(bool(this->conf));
 	auto &sock(*this->sock);
 	if(unlikely(sock.fini))
 		return false;
 
+	// An http/2 connection is not idle while any of its streams are active.
 	const auto &timeout
 	{
-		conf->async_timeout
+		h2 && h2->active()?
+			seconds(-1):
+			conf->async_timeout
 	};
 
 	const net::wait_opts opts
@@ -453,6 +683,11 @@ try
 		return;
 	}
 
+	// The request handler parked the client to complete the response later
+	// with client::resume(); it must not be put back into async mode here.
+	if(client->parked)
+		return;
+
 	#ifdef RB_DEBUG
 	char buf[64];
 	log::debug
@@ -579,7 +814,7 @@ bool
 ircd::handle_ec_timeout(client &client)
 try
 {
-	assert(bool(client.sock));
+	assert(bool(client.sock) || client.stream_id);
 	log::debug
 	{
 		client::log, "%s disconnecting after inactivity timeout",
@@ -643,8 +878,51 @@ ircd::client::client(std::shared_ptr<socket> sock)
 {
 	net::local_ipport(*this->sock)
 }
+,arena
+{
+	settings.arena_block_size, settings.arena_retain
+}
+{
+	assert(size(head_buffer) >= 8_KiB);
+}
+
+/// Constructs the client of a stream of an http/2 session. The request was
+/// received and translated to HTTP/1.1 which is copied into the head buffer
+/// as if it had been read off a socket.
+ircd::client::client(std::shared_ptr<h2c> h2,
+                     const uint32_t &stream_id,
+                     const const_buffer &request)
+:instance_multimap
+{
+	net::ipport{h2->remote}
+}
+,head_buffer
+{
+	std::max(size(request), size_t(conf->header_max_size))
+}
+,local
+{
+	h2->local
+}
+,head_length
+{
+	copy(head_buffer, request)
+}
+,stream_id
+{
+	stream_id
+}
+,h2
+{
+	std::move(h2)
+}
+,arena
+{
+	settings.arena_block_size, settings.arena_retain
+}
 {
 	assert(size(head_buffer) >= 8_KiB);
+	assert(head_length == size(request));
 }
 
 ircd::client::~client()
@@ -691,12 +969,43 @@ bool
 ircd::client::main()
 try
 {
+	const string_view alpn
+	{
+		sock? sock->alpn: "",
+		sock? strnlen(sock->alpn, sizeof(sock->alpn)): 0
+	};
+
+	// The connection becomes an http/2 session at its first wakeup; its
+	// requests are each dispatched as a client for their stream.
+	if(!h2 && alpn == http2::alpn)
+		h2 = std::make_shared<h2c>(sock, remote(*this), local);
+
+	if(h2 && !stream_id)
+		return h2->main(*this);
+
+	// The request of a stream is already in the head buffer.
 	parse::buffer pb{head_buffer};
+	pb.read += stream_id? head_length: 0;
 	parse::capstan pc{pb, read_closure(*this)}; do
 	{
 		if(!handle_request(pc))
 			return false;
 
+		// The handler parked this client; nothing more is read until the
+		// response is completed under client::resume().
+		if(unlikely(parked))
+		{
+			if(pc.unparsed())
+				log::dwarning
+				{
+					log, "%s parked with %zu bytes of a pipelined request discarded",
+					loghead(),
+					pc.unparsed(),
+				};
+
+			return true;
+		}
+
 		// After the request, the head and content has been read off the socket
 		// and the capstan has advanced to the end of the content. The catch is
 		// that reading off the socket could have read too much, bleeding into
@@ -762,7 +1071,9 @@ try
 	// will block this request context below. The timeout limits that.
 	net::scope_timeout timeout
 	{
-		*sock, conf->request_timeout
+		sock?
+			net::scope_timeout{*sock, conf->request_timeout}:
+			net::scope_timeout{}
 	};
 
 	// This is the first read off the wire. The headers are entirely read and
@@ -799,6 +1110,49 @@ try
 		}
 	};
 
+	// Everything the handler drew from the arena is released when this
+	// request is complete, including when it completes with an error.
+	const unwind release_arena{[this]
+	{
+		arena.reset();
+	}};
+
+	// Resources consumed by this context for the request.
+	const ctx::prof::ticker started
+	{
+		ctx::prof::get(ctx::cur())
+	};
+
+	const unwind log_cost{[this, &started, &head]
+	{
+		const auto &ticker
+		{
+			ctx::prof::get(ctx::cur())
+		};
+
+		const auto ticks{[&ticker, &started](const ctx::prof::event &event)
+		{
+			return ticker.event.at(uint8_t(event)) - started.event.at(uint8_t(event));
+		}};
+
+		log::debug
+		{
+			resource::log, "%s HTTP %s `%s' cost cycles:%lu yields:%lu db:%lu/%lu prefetch:%lu net:%lu/%lu allocs:%lu/%lu",
+			loghead(),
+			head.method,
+			head.path,
+			ticks(ctx::prof::event::CYCLES) + ctx::prof::cur_slice_cycles(),
+			ticks(ctx::prof::event::YIELD),
+			ticks(ctx::prof::event::DB_READS),
+			ticks(ctx::prof::event::DB_BYTES),
+			ticks(ctx::prof::event::DB_PREFETCH),
+			ticks(ctx::prof::event::NET_READ),
+			ticks(ctx::prof::event::NET_WRITE),
+			ticks(ctx::prof::event::ALLOCS),
+			ticks(ctx::prof::event::ALLOC_BYTES),
+		};
+	}};
+
 	bool ret
 	{
 		resource_request(head)
@@ -823,7 +1177,7 @@ catch(const std::system_error &e)
 	if(e.code() != operation_canceled)
 		throw;
 
-	if(!sock || sock->fini)
+	if(!stream_id && (!sock || sock->fini))
 		return false;
 
 	const ctx::exception_handler eh;
@@ -850,7 +1204,7 @@ catch(const http::error &e)
 		e.content
 	};
 
-	if(!sock || sock->fini)
+	if(!stream_id && (!sock || sock->fini))
 		return false;
 
 	const ctx::exception_handler eh;
@@ -915,7 +1269,7 @@ catch(const http::error &e)
 			e.content
 		};
 
-	if(!sock || sock->fini)
+	if(!stream_id && (!sock || sock->fini))
 		return false;
 
 	resource::response
@@ -956,7 +1310,7 @@ catch(const std::exception &e)
 		e.what()
 	};
 
-	if(!sock || sock->fini)
+	if(!stream_id && (!sock || sock->fini))
 		return false;
 
 	resource::response
@@ -999,6 +1353,14 @@ ircd::client::discard_unconsumed(const http::request::head &head)
 ircd::ctx::future<void>
 ircd::client::close(const net::close_opts &opts)
 {
+	// Closing a stream resets it unless its response was complete.
+	if(stream_id)
+	{
+		assert(h2);
+		h2->finish(*this, true);
+		return ctx::already;
+	}
+
 	return likely(sock) && !sock->fini?
 		net::close(*sock, opts):
 		ctx::already;
@@ -1008,6 +1370,13 @@ void
 ircd::client::close(const net::close_opts &opts,
                     net::close_callback callback)
 {
+	if(stream_id)
+	{
+		assert(h2);
+		h2->finish(*this, true);
+		return callback({});
+	}
+
 	if(!sock)
 		return;
 
@@ -1020,6 +1389,12 @@ ircd::client::close(const net::close_opts &opts,
 size_t
 ircd::client::write_all(const net::const_buffers &bufs)
 {
+	if(stream_id)
+	{
+		assert(h2);
+		return h2->write(*this, bufs);
+	}
+
 	if(unlikely(!sock))
 		throw std::system_error
 		{
@@ -1048,6 +1423,8 @@ const
 
 	const string_view alpn
 	{
+		stream_id?
+			http2::alpn:
 		sock?
 			sock->alpn:
 			nullptr
@@ -1066,3 +1443,1019 @@ const
 		request_count,
 	};
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// client::h2c
+//
+
+namespace ircd
+{
+	static void h2_frame(std::string &out, const http2::frame::type &, const uint8_t &flags, const uint32_t &id, const const_buffer &payload = {});
+	static void h2_uint32(char *const &, const uint32_t &);
+	static uint32_t h2_uint32(const char *const &);
+}
+
+ircd::client::h2c::h2c(std::shared_ptr<net::socket> sock,
+                       const net::ipport &remote,
+                       const net::ipport &local)
+:sock{std::move(sock)}
+,remote{remote}
+,local{local}
+{
+}
+
+/// Read and handle all frames available on the connection without blocking.
+/// Requests completed here are dispatched to the pool as their own clients.
+bool
+ircd::client::h2c::main(client &conn)
+try
+{
+	using code = http2::frame::settings::code;
+
+	if(!settings_sent)
+	{
+		const size_t window
+		{
+			std::clamp(size_t(settings::http2_window), 65535UL, 0x7fffffffUL)
+		};
+
+		char param[3][6];
+		param[0][0] = 0;
+		param[0][1] = code::MAX_CONCURRENT_STREAMS;
+		h2_uint32(param[0] + 2, size_t(settings::http2_streams_max));
+		param[1][0] = 0;
+		param[1][1] = code::ENABLE_PUSH;
+		h2_uint32(param[1] + 2, 0);
+		param[2][0] = 0;
+		param[2][1] = code::INITIAL_WINDOW_SIZE;
+		h2_uint32(param[2] + 2, window);
+		h2_frame(out, http2::frame::type::SETTINGS, 0, 0, const_buffer{param[0], sizeof(param)});
+
+		char inc[4];
+		h2_uint32(inc, window - 65535);
+		if(window > 65535)
+			h2_frame(out, http2::frame::type::WINDOW_UPDATE, 0, 0, inc);
+
+		settings_sent = true;
+	}
+
+	char buf[16_KiB];
+	for(size_t got; (got = net::read_one(*sock, mutable_buffer{buf})); )
+	{
+		in.append(buf, got);
+		if(!preface)
+		{
+			if(size(in) < size(http2::connection_preface))
+				continue;
+
+			if(unlikely(!startswith(in, http2::connection_preface)))
+				throw http2::error
+				{
+					http2::error::PROTOCOL_ERROR, "Invalid connection preface"
+				};
+
+			in.erase(0, size(http2::connection_preface));
+			preface = true;
+		}
+
+		size_t pos(0);
+		while(size(in) - pos >= sizeof(http2::frame::header))
+		{
+			const http2::frame::header header
+			{
+				const_buffer{in.data() + pos, sizeof(http2::frame::header)}
+			};
+
+			// We never raise SETTINGS_MAX_FRAME_SIZE from its default.
+			if(unlikely(header.len > 16384))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "%s frame of %u bytes exceeds maximum",
+					http2::frame::reflect(header.type),
+					uint(header.len),
+				};
+
+			if(size(in) - pos - sizeof(header) < header.len)
+				break;
+
+			const const_buffer payload
+			{
+				in.data() + pos + sizeof(header), header.len
+			};
+
+			handle_frame(conn, header, payload);
+			pos += sizeof(header) + header.len;
+		}
+
+		in.erase(0, pos);
+	}
+
+	send(out);
+	out.clear();
+	return true;
+}
+catch(const http2::error &e)
+{
+	log::derror
+	{
+		log, "%s http/2 :%s",
+		conn.loghead(),
+		e.what(),
+	};
+
+	char payload[8];
+	h2_uint32(payload, last_id);
+	h2_uint32(payload + 4, e.code);
+	h2_frame(out, http2::frame::type::GOAWAY, 0, 0, payload);
+	send(out);
+	out.clear();
+	return false;
+}
+
+void
+ircd::client::h2c::handle_frame(client &conn,
+                                const http2::frame::header &header,
+                                const const_buffer &payload)
+{
+	using type = http2::frame::type;
+
+	if(unlikely(block_id && header.type != type::CONTINUATION))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Expected CONTINUATION on stream %u; got %s",
+			block_id,
+			http2::frame::reflect(header.type),
+		};
+
+	switch(header.type)
+	{
+		case type::DATA:
+			handle_data(conn, header, payload);
+			break;
+
+		case type::HEADERS:
+		case type::CONTINUATION:
+			handle_headers(conn, header, payload);
+			break;
+
+		case type::SETTINGS:
+			handle_settings(header, payload);
+			break;
+
+		case type::PING:
+		{
+			if(unlikely(header.stream_id || size(payload) != 8))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "Invalid PING"
+				};
+
+			if(!(header.flags & uint8_t(http2::frame::flag::ACK)))
+				h2_frame(out, type::PING, uint8_t(http2::frame::flag::ACK), 0, payload);
+
+			break;
+		}
+
+		case type::WINDOW_UPDATE:
+		{
+			if(unlikely(size(payload) != 4))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "Invalid WINDOW_UPDATE"
+				};
+
+			const ssize_t inc
+			{
+				h2_uint32(data(payload)) & 0x7fffffffU
+			};
+
+			auto *const window
+			{
+				!header.stream_id?
+					&send_window:
+				streams.count(header.stream_id)?
+					&streams.at(header.stream_id).send_window:
+					nullptr
+			};
+
+			if(unlikely(!inc || (window && *window + inc > 0x7fffffffL)))
+				throw http2::error
+				{
+					http2::error::FLOW_CONTROL_ERROR, "Invalid window increment %zd on stream %u",
+					inc,
+					uint(header.stream_id),
+				};
+
+			if(window)
+				*window += inc;
+
+			dock.notify_all();
+			break;
+		}
+
+		// The stream's client finds its stream gone at its next write. It is
+		// not interrupted because that would cancel the shared socket.
+		case type::RST_STREAM:
+		{
+			if(unlikely(size(payload) != 4))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "Invalid RST_STREAM"
+				};
+
+			streams.erase(header.stream_id);
+			dock.notify_all();
+			break;
+		}
+
+		case type::GOAWAY:
+			goaway = true;
+			break;
+
+		case type::PUSH_PROMISE:
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "PUSH_PROMISE from client"
+			};
+
+		default:
+			break;
+	}
+}
+
+void
+ircd::client::h2c::handle_settings(const http2::frame::header &header,
+                                   const const_buffer &payload)
+{
+	using code = http2::frame::settings::code;
+
+	if(unlikely(header.stream_id))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "SETTINGS on stream %u",
+			uint(header.stream_id),
+		};
+
+	if(header.flags & uint8_t(http2::frame::flag::ACK))
+		return;
+
+	if(unlikely(size(payload) % 6))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "Invalid SETTINGS of %zu bytes",
+			size(payload),
+		};
+
+	for(size_t i(0); i < size(payload); i += 6)
+	{
+		const auto *const param
+		{
+			data(payload) + i
+		};
+
+		const uint16_t id
+		(
+			uint16_t(uint8_t(param[0])) << 8 | uint8_t(param[1])
+		);
+
+		const uint32_t value
+		{
+			h2_uint32(param + 2)
+		};
+
+		switch(id)
+		{
+			case code::INITIAL_WINDOW_SIZE:
+			{
+				if(unlikely(value > 0x7fffffffU))
+					throw http2::error
+					{
+						http2::error::FLOW_CONTROL_ERROR, "Initial window size %u too large",
+						value,
+					};
+
+				// The change applies to the windows of all open streams.
+				for(auto &[id, stream] : streams)
+					stream.send_window += ssize_t(value) - initial_window;
+
+				initial_window = value;
+				dock.notify_all();
+				break;
+			}
+
+			case code::MAX_FRAME_SIZE:
+			{
+				if(unlikely(value < 16384 || value > 16777215))
+					throw http2::error
+					{
+						http2::error::PROTOCOL_ERROR, "Invalid max frame size %u",
+						value,
+					};
+
+				max_frame = value;
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	h2_frame(out, http2::frame::type::SETTINGS, uint8_t(http2::frame::flag::ACK), 0);
+}
+
+void
+ircd::client::h2c::handle_headers(client &conn,
+                                  const http2::frame::header &header,
+                                  const const_buffer &payload)
+{
+	using flag = http2::frame::flag;
+
+	if(header.type == http2::frame::type::CONTINUATION)
+	{
+		if(unlikely(!block_id || header.stream_id != block_id))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Unexpected CONTINUATION on stream %u",
+				uint(header.stream_id),
+			};
+
+		block.append(data(payload), size(payload));
+	}
+	else
+	{
+		const_buffer fragment{payload};
+		size_t pad(0);
+		if(header.flags & uint8_t(flag::PADDED) && !empty(fragment))
+		{
+			pad = uint8_t(fragment[0]);
+			consume(fragment, 1);
+		}
+
+		if(header.flags & uint8_t(flag::PRIORITY))
+			consume(fragment, std::min(size(fragment), 5UL));
+
+		if(unlikely(!header.stream_id || pad > size(fragment)))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Invalid HEADERS on stream %u",
+				uint(header.stream_id),
+			};
+
+		block.assign(data(fragment), size(fragment) - pad);
+		block_id = header.stream_id;
+		block_end = header.flags & uint8_t(flag::END_STREAM);
+	}
+
+	if(!(header.flags & uint8_t(flag::END_HEADERS)))
+		return;
+
+	const auto id{block_id};
+	block_id = 0;
+	handle_head(conn, id, block_end);
+}
+
+/// Translate a complete header block into the head of an HTTP/1.1 request.
+/// The content-length is added when the request is dispatched.
+void
+ircd::client::h2c::handle_head(client &conn,
+                               const uint32_t &id,
+                               const bool &eos)
+{
+	std::string method, path, authority, fields;
+	fields.reserve(size(block) * 2);
+
+	// The block is decoded regardless of the stream for the table.
+	http2::hpack::decode(table, string_view{block}, [&]
+	(const string_view &name, const string_view &value)
+	{
+		if(name == ":method")
+			method = value;
+		else if(name == ":path")
+			path = value;
+		else if(name == ":authority" || (name == "host" && authority.empty()))
+			authority = value;
+		else if(startswith(name, ':')
+		|| name == "host"
+		|| name == "content-length"
+		|| name == "connection"
+		|| name == "transfer-encoding")
+			return;
+		else
+		{
+			fields.append(data(name), size(name));
+			fields.append(": ");
+			fields.append(data(value), size(value));
+			fields.append("\r\n");
+		}
+	});
+
+	block.clear();
+	const auto it
+	{
+		streams.find(id)
+	};
+
+	// Trailers end the request.
+	if(it != end(streams))
+	{
+		if(unlikely(!eos || it->second.dispatched))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Unexpected HEADERS on stream %u", id
+			};
+
+		dispatch(conn, id);
+		return;
+	}
+
+	if(unlikely(id % 2 == 0))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Invalid stream %u from client", id
+		};
+
+	// Stream was already closed, perhaps refused by us.
+	if(id <= last_id)
+		return;
+
+	last_id = id;
+	const auto refuse
+	{
+		goaway || streams.size() >= size_t(settings::http2_streams_max)?
+			http2::error::REFUSED_STREAM:
+		empty(method) || empty(path)?
+			http2::error::PROTOCOL_ERROR:
+			http2::error::NO_ERROR
+	};
+
+	if(refuse != http2::error::NO_ERROR)
+	{
+		char payload[4];
+		h2_uint32(payload, refuse);
+		h2_frame(out, http2::frame::type::RST_STREAM, 0, id, payload);
+		return;
+	}
+
+	auto &stream
+	{
+		streams[id]
+	};
+
+	stream.send_window = initial_window;
+	stream.request.append(method).append(" ").append(path).append(" HTTP/1.1\r\n");
+	if(!empty(authority))
+		stream.request.append("host: ").append(authority).append("\r\n");
+
+	stream.request.append(fields);
+	stream.head_size = size(stream.request);
+	if(eos)
+		dispatch(conn, id);
+}
+
+void
+ircd::client::h2c::handle_data(client &conn,
+                               const http2::frame::header &header,
+                               const const_buffer &payload)
+{
+	// Flow control accounts for the entire payload including padding.
+	recv_unacked += size(payload);
+
+	const_buffer content{payload};
+	size_t pad(0);
+	if(header.flags & uint8_t(http2::frame::flag::PADDED) && !empty(content))
+	{
+		pad = uint8_t(content[0]);
+		consume(content, 1);
+	}
+
+	if(unlikely(!header.stream_id || pad > size(content)))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Invalid DATA on stream %u",
+			uint(header.stream_id),
+		};
+
+	const size_t window
+	{
+		std::clamp(size_t(settings::http2_window), 65535UL, 0x7fffffffUL)
+	};
+
+	const auto it
+	{
+		streams.find(header.stream_id)
+	};
+
+	if(it != end(streams) && !it->second.dispatched)
+	{
+		auto &stream{it->second};
+		const size_t content_size
+		{
+			size(stream.request) - stream.head_size + size(content) - pad
+		};
+
+		stream.recv_unacked += size(payload);
+		if(unlikely(content_size > size_t(settings::http2_content_max)))
+		{
+			char payload[4];
+			h2_uint32(payload, http2::error::CANCEL);
+			h2_frame(out, http2::frame::type::RST_STREAM, 0, header.stream_id, payload);
+			streams.erase(it);
+		}
+		else if(header.flags & uint8_t(http2::frame::flag::END_STREAM))
+		{
+			stream.request.append(data(content), size(content) - pad);
+			dispatch(conn, header.stream_id);
+		}
+		else
+		{
+			stream.request.append(data(content), size(content) - pad);
+			if(stream.recv_unacked >= window / 2)
+			{
+				char inc[4];
+				h2_uint32(inc, stream.recv_unacked);
+				h2_frame(out, http2::frame::type::WINDOW_UPDATE, 0, header.stream_id, inc);
+				stream.recv_unacked = 0;
+			}
+		}
+	}
+
+	if(recv_unacked >= window / 2)
+	{
+		char inc[4];
+		h2_uint32(inc, recv_unacked);
+		h2_frame(out, http2::frame::type::WINDOW_UPDATE, 0, 0, inc);
+		recv_unacked = 0;
+	}
+}
+
+/// The request of the stream is complete; it is dispatched to the request
+/// pool as a client of its own.
+void
+ircd::client::h2c::dispatch(client &conn,
+                            const uint32_t &id)
+{
+	auto &stream
+	{
+		streams.at(id)
+	};
+
+	char buf[64];
+	const string_view length
+	{
+		fmt::sprintf
+		{
+			buf, "content-length: %zu\r\n\r\n",
+			size(stream.request) - stream.head_size
+		}
+	};
+
+	stream.request.insert(stream.head_size, data(length), size(length));
+	const auto client
+	{
+		std::make_shared<ircd::client>(conn.h2, id, string_view{stream.request})
+	};
+
+	stream.request = {};
+	stream.dispatched = true;
+	stream.owner = client;
+	client::pool(std::bind(ircd::handle_client_requests, client));
+}
+
+/// Translate the HTTP/1.1 response written by the stream's client.
+size_t
+ircd::client::h2c::write(client &client,
+                         const net::const_buffers &bufs)
+{
+	size_t ret(0);
+	std::string out;
+	for(const auto &buf : bufs)
+	{
+		const_buffer in{buf};
+		ret += size(buf);
+		while(!empty(in))
+		{
+			auto &stream
+			{
+				find(client)
+			};
+
+			if(stream.ended)
+				break;
+
+			if(!stream.head_sent)
+			{
+				consume(in, write_head(client, out, in));
+				continue;
+			}
+
+			if(stream.chunked)
+			{
+				consume(in, write_chunked(client, out, in));
+				continue;
+			}
+
+			const size_t len
+			{
+				std::min(size(in), stream.length)
+			};
+
+			const bool last
+			{
+				stream.length != size_t(-1) && stream.length == len
+			};
+
+			if(stream.length != size_t(-1))
+				stream.length -= len;
+
+			write_data(client, out, const_buffer{data(in), len}, last);
+			consume(in, len);
+		}
+	}
+
+	send(out);
+	return ret;
+}
+
+size_t
+ircd::client::h2c::write_head(const client &client,
+                              std::string &out,
+                              const const_buffer &in)
+{
+	auto &stream
+	{
+		find(client)
+	};
+
+	const size_t prev
+	{
+		size(stream.head)
+	};
+
+	stream.head.append(data(in), size(in));
+	const auto pos
+	{
+		stream.head.find("\r\n\r\n", prev >= 3? prev - 3: 0)
+	};
+
+	if(pos == std::string::npos)
+		return size(in);
+
+	stream.head.resize(pos + 2);
+	const auto &[line, fields]
+	{
+		split(string_view{stream.head}, "\r\n"_sv)
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		size(stream.head) * 2 + 64
+	};
+
+	mutable_buffer cur{buf};
+	const auto add{[&cur]
+	(const string_view &name, const string_view &value)
+	{
+		consume(cur, size(http2::hpack::encode(cur, name, value)));
+	}};
+
+	bool chunked(false);
+	size_t length(-1);
+	add(":status", token(line, ' ', 1));
+	tokens(fields, "\r\n"_sv, [&add, &chunked, &length]
+	(const string_view &field)
+	{
+		const auto &[name, value_](split(field, ':'));
+		const auto value(strip(value_, ' '));
+		if(iequals(name, "transfer-encoding"_sv))
+			chunked |= has(value, "chunked"_sv);
+
+		if(iequals(name, "transfer-encoding"_sv)
+		|| iequals(name, "connection"_sv)
+		|| iequals(name, "keep-alive"_sv)
+		|| iequals(name, "proxy-connection"_sv)
+		|| iequals(name, "upgrade"_sv))
+			return;
+
+		if(iequals(name, "content-length"_sv))
+			length = lex_cast<size_t>(value);
+
+		char lower[128];
+		if(unlikely(size(name) > sizeof(lower)))
+			throw http2::error
+			{
+				"Header name of %zu bytes is too long", size(name)
+			};
+
+		add(tolower(lower, name), value);
+	});
+
+	const string_view block
+	{
+		data(buf), size(buf) - size(cur)
+	};
+
+	const bool eos
+	{
+		!chunked && length == 0
+	};
+
+	size_t off(0); do
+	{
+		const size_t len(std::min(size(block) - off, max_frame));
+		const uint8_t flags
+		(
+			(off + len == size(block)? uint8_t(http2::frame::flag::END_HEADERS): 0U) |
+			(!off && eos? uint8_t(http2::frame::flag::END_STREAM): 0U)
+		);
+
+		h2_frame
+		(
+			out,
+			off? http2::frame::type::CONTINUATION: http2::frame::type::HEADERS,
+			flags,
+			client.stream_id,
+			const_buffer{data(block) + off, len}
+		);
+
+		off += len;
+	}
+	while(off < size(block));
+
+	stream.head_sent = true;
+	stream.chunked = chunked;
+	stream.length = chunked? size_t(-1): length;
+	stream.ended = eos;
+	stream.head = {};
+	return pos + 4 - prev;
+}
+
+/// Chunked response content is unframed into DATA.
+size_t
+ircd::client::h2c::write_chunked(const client &client,
+                                 std::string &out,
+                                 const const_buffer &in)
+{
+	auto &stream
+	{
+		find(client)
+	};
+
+	if(stream.crlf)
+	{
+		const size_t len(std::min(size_t(stream.crlf), size(in)));
+		stream.crlf -= len;
+		return len;
+	}
+
+	if(stream.chunk)
+	{
+		const size_t len(std::min(stream.chunk, size(in)));
+		stream.chunk -= len;
+		stream.crlf = stream.chunk? 0: 2;
+		write_data(client, out, const_buffer{data(in), len}, false);
+		return len;
+	}
+
+	const string_view str
+	{
+		data(in), size(in)
+	};
+
+	const auto nl
+	{
+		str.find('\n')
+	};
+
+	const size_t len
+	{
+		nl == string_view::npos? size(str): nl + 1
+	};
+
+	stream.line.append(data(str), len);
+	if(nl == string_view::npos)
+		return len;
+
+	if(stream.trailer)
+	{
+		const bool eos(stream.line == "\r\n");
+		stream.line.clear();
+		if(eos)
+			write_data(client, out, const_buffer{}, true);
+
+		return len;
+	}
+
+	stream.chunk = std::strtoul(stream.line.c_str(), nullptr, 16);
+	stream.trailer = !stream.chunk;
+	stream.line.clear();
+	return len;
+}
+
+/// Frame content into DATA within the flow control windows; waits for the
+/// remote to open them.
+void
+ircd::client::h2c::write_data(const client &client,
+                              std::string &out,
+                              const const_buffer &buf,
+                              const bool &eos)
+{
+	const_buffer rem{buf}; do
+	{
+		if(!empty(rem) && !wait(client, out))
+			throw std::system_error
+			{
+				make_error_code(std::errc::timed_out)
+			};
+
+		auto &stream
+		{
+			find(client)
+		};
+
+		const size_t len
+		{
+			std::min
+			({
+				size(rem),
+				size_t(std::max(send_window, 0L)),
+				size_t(std::max(stream.send_window, 0L)),
+				max_frame,
+			})
+		};
+
+		const bool last
+		{
+			eos && len == size(rem)
+		};
+
+		const uint8_t flags
+		{
+			last? uint8_t(http2::frame::flag::END_STREAM): uint8_t(0)
+		};
+
+		h2_frame(out, http2::frame::type::DATA, flags, client.stream_id, const_buffer{data(rem), len});
+		send_window -= len;
+		stream.send_window -= len;
+		stream.ended |= last;
+		consume(rem, len);
+		if(size(out) >= 64_KiB)
+		{
+			send(out);
+			out.clear();
+		}
+	}
+	while(!empty(rem));
+}
+
+/// Wait for the windows of the connection and the stream to open; false on
+/// timeout; throws if the stream is gone.
+bool
+ircd::client::h2c::wait(const client &client,
+                        std::string &out)
+{
+	const auto open{[this, &client]
+	{
+		const auto it(streams.find(client.stream_id));
+		return it == end(streams) || (send_window > 0 && it->second.send_window > 0);
+	}};
+
+	if(open())
+		return true;
+
+	send(out);
+	out.clear();
+	const bool ret
+	{
+		dock.wait_for(seconds(client.conf->request_timeout), open)
+	};
+
+	find(client);
+	return ret;
+}
+
+/// Called when the stream's client is finished with its response, or when
+/// it is closed. An incomplete response is reset.
+void
+ircd::client::h2c::finish(client &client,
+                          const bool &reset)
+try
+{
+	const auto it
+	{
+		streams.find(client.stream_id)
+	};
+
+	if(it == end(streams))
+		return;
+
+	std::string out;
+	auto &stream{it->second};
+	const bool complete
+	{
+		!reset && stream.head_sent && !stream.chunked && stream.length == size_t(-1)
+	};
+
+	if(!stream.ended && complete)
+		h2_frame(out, http2::frame::type::DATA, uint8_t(http2::frame::flag::END_STREAM), client.stream_id);
+
+	char payload[4];
+	h2_uint32(payload, reset? http2::error::CANCEL: http2::error::INTERNAL_ERROR);
+	if(!stream.ended && !complete)
+		h2_frame(out, http2::frame::type::RST_STREAM, 0, client.stream_id, payload);
+
+	streams.erase(it);
+	dock.notify_all();
+	send(out);
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s finishing stream :%s",
+		client.loghead(),
+		e.what(),
+	};
+}
+
+void
+ircd::client::h2c::send(const string_view &out)
+{
+	if(empty(out))
+		return;
+
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	net::write_all(*sock, const_buffer{out});
+}
+
+ircd::client::h2c::stream &
+ircd::client::h2c::find(const client &client)
+{
+	const auto it
+	{
+		streams.find(client.stream_id)
+	};
+
+	if(unlikely(it == end(streams)))
+		throw std::system_error
+		{
+			make_error_code(std::errc::connection_reset)
+		};
+
+	return it->second;
+}
+
+bool
+ircd::client::h2c::active()
+const
+{
+	return !streams.empty();
+}
+
+void
+ircd::h2_frame(std::string &out,
+               const http2::frame::type &type,
+               const uint8_t &flags,
+               const uint32_t &id,
+               const const_buffer &payload)
+{
+	char buf[sizeof(http2::frame::header)];
+	const http2::frame::header header
+	{
+		type, flags, id, size(payload)
+	};
+
+	const const_buffer head
+	{
+		header.write(buf)
+	};
+
+	out.append(data(head), size(head));
+	out.append(data(payload), size(payload));
+}
+
+uint32_t
+ircd::h2_uint32(const char *const &buf)
+{
+	const auto *const p
+	{
+		reinterpret_cast<const uint8_t *>(buf)
+	};
+
+	return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+void
+ircd::h2_uint32(char *const &buf,
+                const uint32_t &val)
+{
+	buf[0] = char(val >> 24);
+	buf[1] = char(val >> 16);
+	buf[2] = char(val >> 8);
+	buf[3] = char(val);
+}
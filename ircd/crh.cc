@@ -41,3 +41,224 @@ ircd::crh::hash::finalize(const mutable_buffer &b)
 {
 	digest(b);
 }
+
+//
+// sha256 multi-buffer
+//
+
+namespace ircd::crh
+{
+	static void sha256_pad(u8 (&)[64], const const_buffer &, const size_t &block, const size_t &blocks) noexcept;
+	static void sha256_x8(const mutable_buffer (&)[8], const const_buffer (&)[8]) noexcept;
+
+	extern const u32 sha256_k[64];
+	extern const u32 sha256_h0[8];
+}
+
+decltype(ircd::crh::sha256_k)
+ircd::crh::sha256_k
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+decltype(ircd::crh::sha256_h0)
+ircd::crh::sha256_h0
+{
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+/// Large batches may be offloaded to an OpenCL device. Otherwise inputs are
+/// hashed eight at a time, one per lane, unless the host has the SHA
+/// extensions: the single-buffer path of the library uses them and is then
+/// the faster one. Inputs are grouped by length so the lanes of a group
+/// finish together.
+void
+ircd::crh::sha256::batch(const mutable_buffer &out,
+                         const vector_view<const const_buffer> &in)
+{
+	if(unlikely(size(out) < in.size() * digest_size))
+		throw error
+		{
+			"Output buffer of %zu bytes insufficient for %zu digests.",
+			size(out),
+			in.size(),
+		};
+
+	if(cl::sha256(out, in))
+		return;
+
+	const auto digest{[&out](const size_t &i)
+	{
+		return mutable_buffer
+		{
+			data(out) + i * digest_size, digest_size
+		};
+	}};
+
+	const bool lanes
+	{
+		in.size() >= 8 && !info::hardware::x86::sha
+	};
+
+	if(!lanes)
+	{
+		for(size_t i(0); i < in.size(); ++i)
+			sha256
+			{
+				digest(i), in[i]
+			};
+
+		return;
+	}
+
+	std::vector<uint32_t> idx(in.size());
+	std::iota(begin(idx), end(idx), 0U);
+	std::sort(begin(idx), end(idx), [&in]
+	(const auto &a, const auto &b)
+	{
+		return size(in[a]) < size(in[b]);
+	});
+
+	size_t i(0);
+	for(; i + 8 <= idx.size(); i += 8)
+	{
+		mutable_buffer dst[8];
+		const_buffer src[8];
+		for(size_t j(0); j < 8; ++j)
+		{
+			dst[j] = digest(idx[i + j]);
+			src[j] = in[idx[i + j]];
+		}
+
+		sha256_x8(dst, src);
+	}
+
+	for(; i < idx.size(); ++i)
+		sha256
+		{
+			digest(idx[i]), in[idx[i]]
+		};
+}
+
+/// Eight messages in lock-step; the lanes of messages with fewer blocks are
+/// masked out of the state update once they're complete.
+[[IRCD_SIMD_CLONES]]
+void
+ircd::crh::sha256_x8(const mutable_buffer (&out)[8],
+                     const const_buffer (&in)[8])
+noexcept
+{
+	static const auto ror{[](const u32x8 &x, const uint n)
+	{
+		return (x >> n) | (x << (32 - n));
+	}};
+
+	size_t blocks[8], max_blocks(0);
+	for(size_t l(0); l < 8; ++l)
+	{
+		blocks[l] = (size(in[l]) + 9 + 63) / 64;
+		max_blocks = std::max(max_blocks, blocks[l]);
+	}
+
+	u32x8 h[8];
+	for(size_t k(0); k < 8; ++k)
+		h[k] = u32x8{0} + sha256_h0[k];
+
+	for(size_t b(0); b < max_blocks; ++b)
+	{
+		u32x8 active {0};
+		alignas(64) u8 block[8][64];
+		for(size_t l(0); l < 8; ++l)
+		{
+			active[l] = b < blocks[l]? -1U: 0U;
+			sha256_pad(block[l], in[l], b, blocks[l]);
+		}
+
+		u32x8 w[64];
+		for(size_t t(0); t < 16; ++t)
+			for(size_t l(0); l < 8; ++l)
+			{
+				u32 word;
+				memcpy(&word, block[l] + t * 4, sizeof(word));
+				w[t][l] = __builtin_bswap32(word);
+			}
+
+		for(size_t t(16); t < 64; ++t)
+		{
+			const u32x8 s0(ror(w[t - 15], 7) ^ ror(w[t - 15], 18) ^ (w[t - 15] >> 3));
+			const u32x8 s1(ror(w[t - 2], 17) ^ ror(w[t - 2], 19) ^ (w[t - 2] >> 10));
+			w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+		}
+
+		u32x8 v[8];
+		for(size_t k(0); k < 8; ++k)
+			v[k] = h[k];
+
+		for(size_t t(0); t < 64; ++t)
+		{
+			const u32x8 S1(ror(v[4], 6) ^ ror(v[4], 11) ^ ror(v[4], 25));
+			const u32x8 ch((v[4] & v[5]) ^ (~v[4] & v[6]));
+			const u32x8 t1(v[7] + S1 + ch + sha256_k[t] + w[t]);
+			const u32x8 S0(ror(v[0], 2) ^ ror(v[0], 13) ^ ror(v[0], 22));
+			const u32x8 maj((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+			v[7] = v[6];
+			v[6] = v[5];
+			v[5] = v[4];
+			v[4] = v[3] + t1;
+			v[3] = v[2];
+			v[2] = v[1];
+			v[1] = v[0];
+			v[0] = t1 + S0 + maj;
+		}
+
+		for(size_t k(0); k < 8; ++k)
+			h[k] += v[k] & active;
+	}
+
+	for(size_t l(0); l < 8; ++l)
+		for(size_t k(0); k < 8; ++k)
+		{
+			const u32 word
+			{
+				__builtin_bswap32(h[k][l])
+			};
+
+			memcpy(data(out[l]) + k * 4, &word, sizeof(word));
+		}
+}
+
+/// Composes the block'th 64 bytes of the padded message; past the last
+/// block the content is irrelevant and left zero.
+void
+ircd::crh::sha256_pad(u8 (&block)[64],
+                      const const_buffer &in,
+                      const size_t &b,
+                      const size_t &blocks)
+noexcept
+{
+	const size_t len(size(in)), off(b * 64);
+	memset(block, 0x00, sizeof(block));
+	if(off < len)
+		memcpy(block, data(in) + off, std::min(len - off, 64UL));
+
+	if(len >= off && len < off + 64)
+		block[len - off] = 0x80;
+
+	if(b + 1 == blocks)
+	{
+		const uint64_t bits
+		{
+			__builtin_bswap64(uint64_t(len) * 8)
+		};
+
+		memcpy(block + 56, &bits, sizeof(bits));
+	}
+}
@@ -8,6 +8,7 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_SYS_MMAN_H
 #include "ctx.h"
 
 /// Dedicated log facility for the ircd::ctx subsystem.
@@ -73,6 +74,26 @@ ircd::ctx::ctx::spawning;
 decltype(ircd::ctx::ctx::adjoindre)
 ircd::ctx::ctx::adjoindre;
 
+/// Number of interactive contexts which have been woken and are waiting in
+/// the ios queue to resume. See ctx::sched.
+[[gnu::visibility("hidden")]]
+decltype(ircd::ctx::sched_queued_interactive)
+ircd::ctx::sched_queued_interactive;
+
+/// Highest stack usage observed by any context at the time it finished.
+decltype(ircd::ctx::stack_peak)
+ircd::ctx::stack_peak
+{
+	{ "name", "ircd.ctx.stack.peak" },
+};
+
+decltype(ircd::ctx::sched_defer)
+ircd::ctx::sched_defer
+{
+	{ "name",     "ircd.ctx.sched.defer" },
+	{ "default",  true                   },
+};
+
 /// Internal context struct ctor
 ircd::ctx::ctx::ctx(const string_view &name,
                     const ircd::ctx::stack &stack,
@@ -97,6 +118,9 @@ ircd::ctx::ctx::~ctx()
 noexcept
 {
 	assert(yc == nullptr); // Check that the context isn't active.
+
+	if(queued_interactive)
+		--sched_queued_interactive;
 }
 
 /// Internal wrapper for asio::spawn; never call directly.
@@ -174,6 +198,17 @@ noexcept try
 	const unwind atexit{[this]
 	{
 		adjoindre.notify_all();
+		stack_peak = std::max(uint64_t(stack_peak), uint64_t(stack.peak));
+		if(unlikely(~flags & context::STACK_EXEMPT && prof::stack_exceeded_warning(stack.peak)))
+			log::dwarning
+			{
+				prof::watchdog, "ctx('%s' id:%u) stack peak %zu of %zu bytes",
+				name,
+				id,
+				stack.peak,
+				stack.max,
+			};
+
 		stack.at = 0;
 		notes = 0;
 		this->yc = nullptr;
@@ -313,6 +348,25 @@ ircd::ctx::ctx::wait()
 	assert(current == this);
 	assert(notes == 1);  // notes = 1; set by continuation dtor on wakeup
 
+	if(queued_interactive)
+	{
+		queued_interactive = false;
+		assert(sched_queued_interactive > 0);
+		--sched_queued_interactive;
+	}
+
+	// A background context resuming ahead of queued interactive contexts
+	// goes once more to the back of the ios queue; they run first.
+	if(nice > 0 && sched_queued_interactive && bool(sched_defer))
+		continuation
+		{
+			continuation::false_predicate, continuation::noop_interruptor, []
+			(auto &yield)
+			{
+				boost::asio::post(ios::get(), yield);
+			}
+		};
+
 	return true;
 }
 
@@ -355,6 +409,12 @@ noexcept try
 		};
 	}
 
+	if(nice < 0 && !queued_interactive)
+	{
+		queued_interactive = true;
+		++sched_queued_interactive;
+	}
+
 	alarm.cancel();
 	return true;
 }
@@ -532,29 +592,125 @@ noexcept
 
 namespace ircd::ctx
 {
+	struct signal_node;
+
+	static void signal_drain() noexcept;
+
 	[[gnu::visibility("hidden")]]
 	extern ios::descriptor signal_desc;
+
+	[[gnu::visibility("hidden")]]
+	extern std::atomic<signal_node *> signal_head;
+
+	extern stats::item<uint64_t> signal_count;
+	extern stats::item<uint64_t> signal_drains;
 }
 
+/// Element of the completion list for signal(). Nodes are pushed by any
+/// thread and the whole list is taken by the main thread at once, so there
+/// is no ABA hazard and no lock on either side.
+struct ircd::ctx::signal_node
+{
+	std::function<void ()> func;
+	signal_node *next {nullptr};
+};
+
 decltype(ircd::ctx::signal_desc)
 ircd::ctx::signal_desc
 {
 	"ircd.ctx.signal"
 };
 
+decltype(ircd::ctx::signal_head)
+ircd::ctx::signal_head
+{
+	nullptr
+};
+
+decltype(ircd::ctx::signal_count)
+ircd::ctx::signal_count
+{
+	{ "name", "ircd.ctx.signal.count" },
+};
+
+decltype(ircd::ctx::signal_drains)
+ircd::ctx::signal_drains
+{
+	{ "name", "ircd.ctx.signal.drains" },
+};
+
 /// Executes `func` sometime between executions of `ctx` with thread-safety
 /// so `func` and `ctx` are never executed concurrently no matter how many
 /// threads the io_service has available to execute events on.
+///
+/// The function is pushed to a lock-free list; only the push which finds
+/// the list empty posts to the ios, and that one handler drains everything
+/// pushed until it runs. Completions from other threads (i.e ctx::ole) are
+/// thus batched into one ios event rather than contending on the ios queue
+/// for each of them.
 void
 ircd::ctx::signal(ctx &ctx,
                   std::function<void ()> func)
 {
+	auto *const node
+	{
+		new signal_node
+		{
+			std::move(func)
+		}
+	};
+
+	node->next = signal_head.load(std::memory_order_relaxed);
+	while(!signal_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+
+	if(node->next)
+		return;
+
 	ios::dispatch
 	{
-		signal_desc, ios::defer, std::move(func)
+		signal_desc, ios::defer, signal_drain
 	};
 }
 
+void
+ircd::ctx::signal_drain()
+noexcept
+{
+	auto *node
+	{
+		signal_head.exchange(nullptr, std::memory_order_acquire)
+	};
+
+	// The list was pushed as a stack; reverse it to execute in order.
+	signal_node *prev {nullptr};
+	while(node)
+	{
+		auto *const next(node->next);
+		node->next = prev;
+		prev = node;
+		node = next;
+	}
+
+	++signal_drains;
+	for(node = prev; node; ++signal_count) try
+	{
+		const std::unique_ptr<signal_node> ptr
+		{
+			node
+		};
+
+		node = node->next;
+		ptr->func();
+	}
+	catch(const std::exception &e)
+	{
+		log::critical
+		{
+			log, "ctx::signal: %s", e.what()
+		};
+	}
+}
+
 /// Marks `ctx` for termination. Terminate is similar to interrupt() but the
 /// exception thrown is ctx::terminate which does not participate in the
 /// std::exception hierarchy. Project code is unlikely to catch this.
@@ -1392,6 +1548,9 @@ ircd::ctx::pool::pool(const string_view &name,
 :name{name}
 ,opt{&opt}
 {
+	if(this->opt->stats)
+		stats = std::make_unique<struct stats>(*this);
+
 	// Can't spawn contexts when the ios isn't available. This may be the
 	// case for some static instances of pool: initial_ctxs value is ignored.
 	if(ircd::ios::available())
@@ -1438,6 +1597,8 @@ ircd::ctx::pool::min(const size_t &num)
 void
 ircd::ctx::pool::set(const size_t &num)
 {
+	reap();
+	grown = 0;
 	if(size() > num)
 		del(size() - num);
 	else
@@ -1465,6 +1626,7 @@ void
 ircd::ctx::pool::add(const size_t &num)
 {
 	assert(opt);
+	reap();
 	for(size_t i(0); i < num; ++i)
 	{
 		ctxs.emplace_back(name, opt->stack_size, context::POST, std::bind(&pool::main, this));
@@ -1492,6 +1654,12 @@ ircd::ctx::pool::operator()(closure closure)
 			opt->queue_max_soft
 		};
 
+	// Spawn another context rather than letting this job wait behind a
+	// queue which isn't moving; a submitter that would otherwise block on
+	// the soft limit is also relieved by this.
+	if(opt->ctxs_max && behind())
+		grow();
+
 	if(current && opt->queue_max_soft >= 0 && opt->queue_max_blocking)
 		q_max.wait([this]
 		{
@@ -1511,7 +1679,70 @@ ircd::ctx::pool::operator()(closure closure)
 			opt->queue_max_hard
 		};
 
-	q.push(std::move(closure));
+	q.push(job
+	{
+		std::move(closure), now<steady_point>()
+	});
+}
+
+/// True when no context is available to take a job and the oldest job in
+/// the queue has waited at least the grow_latency.
+bool
+ircd::ctx::pool::behind()
+const
+{
+	assert(opt);
+	if(avail() > 0)
+		return false;
+
+	if(q.empty())
+		return opt->grow_latency <= 0ms;
+
+	const auto waited
+	{
+		now<steady_point>() - q.front().second
+	};
+
+	return waited >= opt->grow_latency;
+}
+
+/// Spawn one context beyond the set size of the pool, up to the ctxs_max.
+/// Nothing is done if a context was already spawned which hasn't started
+/// running yet, since it will take the next job.
+bool
+ircd::ctx::pool::grow()
+{
+	assert(opt);
+	reap();
+	if(size() >= opt->ctxs_max)
+		return false;
+
+	if(size() > running)
+		return false;
+
+	add(1);
+	++grown;
+	if(stats)
+		++stats->grown;
+
+	return true;
+}
+
+/// Remove the contexts which have exited on their own after idling; this is
+/// how the pool shrinks after having grown.
+void
+ircd::ctx::pool::reap()
+{
+	const auto it
+	{
+		std::remove_if(begin(ctxs), end(ctxs), []
+		(const auto &context)
+		{
+			return context.joined();
+		})
+	};
+
+	ctxs.erase(it, end(ctxs));
 }
 
 bool
@@ -1539,7 +1770,8 @@ noexcept try
 
 	q_max.notify();
 	while(!termination(cur()))
-		work();
+		if(!work())
+			break;
 }
 catch(const interrupted &e)
 {
@@ -1556,15 +1788,37 @@ catch(const terminated &e)
 //	};
 }
 
-void
+/// Take one job from the queue and execute it. Returns false when this
+/// context should exit because it idled past the timeout while the pool is
+/// larger than its set size.
+bool
 ircd::ctx::pool::work()
 try
 {
-	const auto func
+	assert(opt);
+	const bool shrinkable
 	{
-		q.pop()
+		grown && opt->idle_timeout > 0ms
 	};
 
+	job job;
+	if(shrinkable) try
+	{
+		job = q.pop_for(opt->idle_timeout);
+	}
+	catch(const timeout &)
+	{
+		if(!grown)
+			return true;
+
+		--grown;
+		if(stats)
+			++stats->shrunk;
+
+		return false;
+	}
+	else job = q.pop();
+
 	const scope_count working
 	{
 		this->working
@@ -1574,19 +1828,51 @@ try
 	noexcept
 	{
 		q_max.notify();
+		if(stats)
+		{
+			stats->active = this->working - 1;
+			stats->idle = this->avail() + 1;
+		}
 	}};
 
+	const auto waited
+	{
+		duration_cast<microseconds>(now<steady_point>() - job.second)
+	};
+
+	if(stats)
+	{
+		const auto us(waited.count());
+		++stats->jobs;
+		stats->active = this->working;
+		stats->idle = this->avail();
+		stats->wait_total += us;
+		stats->wait_last = us;
+		stats->wait_max = std::max(uint64_t(stats->wait_max), uint64_t(us));
+		++(us <= 1000L? stats->wait_1ms:
+		   us <= 10000L? stats->wait_10ms:
+		   us <= 100000L? stats->wait_100ms:
+		   us <= 1000000L? stats->wait_1s:
+		                   stats->wait_inf);
+	}
+
+	// The queue is still backed up after this job waited too long; another
+	// context is added so the remainder doesn't wait behind the same jobs.
+	if(opt->ctxs_max && !q.empty() && behind())
+		grow();
+
 	// Execute the user's function
-	func();
+	job.first();
 
 	// Check for latent interruption to this ctx. If there's anything pending
 	// it's best to get rid of it sooner rather than later.
 	interruption_point();
+	return true;
 }
 catch(const interrupted &e)
 {
 	// Interrupt is stopped here so this ctx can be reused for a new job.
-	return;
+	return true;
 }
 catch(const std::exception &e)
 {
@@ -1600,6 +1886,8 @@ catch(const std::exception &e)
 		ircd::ctx::id(cur()),
 		e.what()
 	};
+
+	return true;
 }
 
 void
@@ -1617,6 +1905,131 @@ ircd::ctx::debug_stats(const pool &pool)
 	};
 }
 
+//
+// pool::stats
+//
+
+namespace ircd::ctx
+{
+	static thread_local char pool_stats_name_buf[128];
+	static string_view pool_stats_name(const pool &, const string_view &key);
+}
+
+ircd::string_view
+ircd::ctx::pool_stats_name(const pool &p,
+                           const string_view &key)
+{
+	return fmt::sprintf
+	{
+		pool_stats_name_buf, "ircd.ctx.pool.%s.%s",
+		p.name,
+		key,
+	};
+}
+
+ircd::ctx::pool::stats::stats(pool &p)
+:value{0}
+,items{0}
+,jobs
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "jobs") },
+	},
+}
+,active
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "active") },
+	},
+}
+,idle
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "idle") },
+	},
+}
+,grown
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "grown") },
+	},
+}
+,shrunk
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "shrunk") },
+	},
+}
+,wait_total
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_total") },
+	},
+}
+,wait_last
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_last") },
+	},
+}
+,wait_max
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_max") },
+	},
+}
+,wait_1ms
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_1ms") },
+	},
+}
+,wait_10ms
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_10ms") },
+	},
+}
+,wait_100ms
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_100ms") },
+	},
+}
+,wait_1s
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_1s") },
+	},
+}
+,wait_inf
+{
+	value + items++,
+	{
+		{ "name", pool_stats_name(p, "wait_inf") },
+	},
+}
+{
+	assert(items <= (sizeof(value) / sizeof(value[0])));
+}
+
+ircd::ctx::pool::stats::~stats()
+noexcept
+{
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // ctx_prof.h
@@ -1625,6 +2038,7 @@ ircd::ctx::debug_stats(const pool &pool)
 namespace ircd::ctx::prof
 {
 	thread_local ticker _total;                // Totals kept for all contexts.
+	thread_local allocator::profile _alloc;    // Allocator counters at slice start.
 
 	static void check_stack();
 	static void check_slice();
@@ -1703,6 +2117,22 @@ ircd::ctx::prof::mark(const event &e)
 	}
 }
 
+/// Accumulate a resource consumed by the current context; no-op outside
+/// of a context (i.e. on other threads). Totals for all contexts are
+/// maintained as well.
+void
+ircd::ctx::prof::account(const event &e,
+                         const uint64_t &val)
+noexcept
+{
+	assert(uint8_t(e) < num_of<event>());
+	if(!current)
+		return;
+
+	_total.event[uint8_t(e)] += val;
+	current->profile.event[uint8_t(e)] += val;
+}
+
 void
 ircd::ctx::prof::inc_ticker(const event &e)
 noexcept
@@ -1758,6 +2188,10 @@ ircd::ctx::prof::slice_enter()
 noexcept
 {
 	ios::handler::enter(&ctx::ios_handler);
+	_alloc = allocator::profile::this_thread;
+
+	// Restore the arena selected by any allocator scope open on this stack.
+	allocator::je::arena::select(cur().arena);
 }
 
 void
@@ -1783,6 +2217,19 @@ noexcept
 	c.stack.peak = std::max(c.stack.at, c.stack.peak);
 
 	_total.event.at(pos) += last_slice;
+
+	const auto &alloc
+	{
+		allocator::profile::this_thread
+	};
+
+	account(event::ALLOCS, alloc.alloc_count - _alloc.alloc_count);
+	account(event::ALLOC_BYTES, alloc.alloc_bytes - _alloc.alloc_bytes);
+
+	// The arena selection belongs to this context; the next one starts from
+	// the default arena.
+	c.arena = allocator::je::arena::current;
+	allocator::je::arena::select(0);
 }
 
 #ifndef NDEBUG
@@ -1969,12 +2416,166 @@ ircd::ctx::prof::reflect(const event &e)
 		case event::INTERRUPT:   return "INTERRUPT";
 		case event::TERMINATE:   return "TERMINATE";
 		case event::CYCLES:      return "CYCLES";
+		case event::DB_READS:    return "DB_READS";
+		case event::DB_BYTES:    return "DB_BYTES";
+		case event::DB_PREFETCH: return "DB_PREFETCH";
+		case event::NET_READ:    return "NET_READ";
+		case event::NET_WRITE:   return "NET_WRITE";
+		case event::ALLOCS:      return "ALLOCS";
+		case event::ALLOC_BYTES: return "ALLOC_BYTES";
 		case event::_NUM_:       break;
 	}
 
 	return "?????";
 }
 
+//
+// prof::lock
+//
+
+namespace ircd::ctx::prof::lock
+{
+	extern std::map<std::string, point, std::less<>> points;
+	extern std::map<const void *, std::string> labels;
+}
+
+decltype(ircd::ctx::prof::lock::enable)
+ircd::ctx::prof::lock::enable
+{
+	{ "name",     "ircd.ctx.prof.lock.enable" },
+	{ "default",  false                       },
+	{ "persist",  false                       },
+	{ "description",
+
+	R"(
+	Record contended waits on each ctx::mutex and ctx::shared_mutex: count,
+	total and longest wait, and which contexts held the lock. The record is
+	viewed and cleared from the console with `ctx lock`.
+	)"},
+};
+
+decltype(ircd::ctx::prof::lock::points)
+ircd::ctx::prof::lock::points;
+
+decltype(ircd::ctx::prof::lock::labels)
+ircd::ctx::prof::lock::labels;
+
+bool
+ircd::ctx::prof::lock::for_each(const closure &closure)
+{
+	for(const auto &[lock, point] : points)
+		if(!closure(point))
+			return false;
+
+	return true;
+}
+
+void
+ircd::ctx::prof::lock::clear()
+noexcept
+{
+	points.clear();
+}
+
+//
+// prof::lock::label
+//
+
+ircd::ctx::prof::lock::label::label(const void *const lock,
+                                    const string_view &name)
+:lock{lock}
+{
+	labels[lock] = name;
+}
+
+ircd::ctx::prof::lock::label::~label()
+noexcept
+{
+	labels.erase(lock);
+}
+
+//
+// prof::lock::wait
+//
+
+void
+ircd::ctx::prof::lock::wait::start(wait &wait,
+                                   const void *const &lock,
+                                   const ctx *const &holder)
+noexcept
+{
+	// The holder's name is copied now because it may be gone by the time
+	// the wait is over.
+	strlcpy(wait.holder, holder? name(*holder): "<shared>"_sv);
+	wait.started = now<steady_point>();
+	wait.lock = lock;
+}
+
+void
+ircd::ctx::prof::lock::wait::record(const wait &wait)
+noexcept try
+{
+	const nanoseconds elapsed
+	{
+		now<steady_point>() - wait.started
+	};
+
+	// Labeled locks are recorded by name so all instances of the same lock
+	// (i.e. one per request) are aggregated; others by address.
+	char addrbuf[32];
+	const auto label(labels.find(wait.lock));
+	const string_view key
+	{
+		label != end(labels)?
+			string_view{label->second}:
+			fmt::sprintf
+			{
+				addrbuf, "%p", wait.lock
+			}
+	};
+
+	auto it
+	{
+		points.lower_bound(key)
+	};
+
+	if(it == end(points) || it->first != key)
+	{
+		point p;
+		p.name = key;
+		it = points.emplace_hint(it, std::string(key), std::move(p));
+	}
+
+	const string_view holder
+	{
+		wait.holder
+	};
+
+	auto &p(it->second);
+	p.lock = wait.lock;
+	++p.waits;
+	p.timeouts += !wait.acquired;
+	p.total += elapsed;
+
+	auto hit(p.holders.lower_bound(holder));
+	if(hit == end(p.holders) || hit->first != holder)
+		hit = p.holders.emplace_hint(hit, std::string(holder), 0UL);
+
+	++hit->second;
+	if(elapsed <= p.max)
+		return;
+
+	p.max = elapsed;
+	p.max_holder = holder;
+	p.max_waiter = current?
+		name(*current):
+		"*"_sv;
+}
+catch(...)
+{
+	// Profiling must not affect the lock.
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // ctx/promise.h
@@ -3184,13 +3785,99 @@ ircd::ctx::stack::allocator
 {
 	using stack_context = boost::coroutines::stack_context;
 
+	static conf::item<size_t> cache_max;
+	static conf::item<bool> guard_enable;
+	static conf::item<size_t> hugetlb_page;
+	static conf::item<size_t> hugetlb_size;
+	static stats::item<uint64_t> cache_hits;
+	static stats::item<uint64_t> cache_misses;
+	static stats::item<uint64_t> cache_bytes;
+	static std::multimap<size_t, void *> cache;
+	static std::unique_ptr<ircd::allocator::hugetlb> hugetlb;
+
 	mutable_buffer &buf;
 	bool owner {false};
+	size_t guard {0};
+
+	static ircd::allocator::hugetlb *hugetlb_region() noexcept;
+	static void *acquire(const size_t &size, const size_t &guard);
+	static void release(void *, const size_t &size, const size_t &guard) noexcept;
 
 	void allocate(stack_context &, size_t size);
 	void deallocate(stack_context &);
 };
 
+decltype(ircd::ctx::stack::allocator::cache_max)
+ircd::ctx::stack::allocator::cache_max
+{
+	{ "name",     "ircd.ctx.stack.cache.max" },
+	{ "default",  long(64_MiB)               },
+};
+
+decltype(ircd::ctx::stack::allocator::guard_enable)
+ircd::ctx::stack::allocator::guard_enable
+{
+	{ "name",     "ircd.ctx.stack.guard" },
+	{ "default",  true                   },
+};
+
+decltype(ircd::ctx::stack::allocator::hugetlb_page)
+ircd::ctx::stack::allocator::hugetlb_page
+{
+	{ "name",     "ircd.ctx.stack.hugetlb.page" },
+	{ "default",  0L                            },
+	{ "persist",  false                         },
+	{ "description",
+
+	R"(
+	Size of the explicit hugepages stacks are carved from (i.e. 2097152);
+	zero disables. The pages must be reserved on the system beforehand (see
+	vm.nr_hugepages). Stacks from hugepages have no guard page. Set in the
+	environment; it is read when the first stack is allocated.
+	)"},
+};
+
+decltype(ircd::ctx::stack::allocator::hugetlb_size)
+ircd::ctx::stack::allocator::hugetlb_size
+{
+	{ "name",     "ircd.ctx.stack.hugetlb.size" },
+	{ "default",  long(64_MiB)                  },
+	{ "persist",  false                         },
+	{ "description",
+
+	R"(
+	Bytes of hugepages reserved for stacks when enabled. This memory is never
+	returned to the system; stacks carved from it are always cached for reuse
+	after their context finishes. Normal pages are used after it is exhausted.
+	)"},
+};
+
+decltype(ircd::ctx::stack::allocator::cache_hits)
+ircd::ctx::stack::allocator::cache_hits
+{
+	{ "name", "ircd.ctx.stack.cache.hits" },
+};
+
+decltype(ircd::ctx::stack::allocator::cache_misses)
+ircd::ctx::stack::allocator::cache_misses
+{
+	{ "name", "ircd.ctx.stack.cache.misses" },
+};
+
+decltype(ircd::ctx::stack::allocator::cache_bytes)
+ircd::ctx::stack::allocator::cache_bytes
+{
+	{ "name", "ircd.ctx.stack.cache.bytes" },
+};
+
+/// Stacks released by finished contexts are retained here for reuse by
+/// the next spawn of the same size. Keyed by the size including the guard.
+decltype(ircd::ctx::stack::allocator::cache)
+ircd::ctx::stack::allocator::cache;
+
+decltype(ircd::ctx::stack::allocator::hugetlb)
+ircd::ctx::stack::allocator::hugetlb;
+
 void
 ircd::ctx::stack::allocator::allocate(stack_context &c,
                                       size_t size)
@@ -3200,14 +3887,27 @@ ircd::ctx::stack::allocator::allocate(stack_context &c,
 		info::page_size
 	};
 
-	unique_mutable_buffer umb
+	const bool owner
+	{
+		null(this->buf)
+	};
+
+	// The lowest page of a stack we allocate is made inaccessible so an
+	// overflow faults rather than writing into the adjacent allocation. The
+	// protection can't be applied to part of a hugepage.
+	const size_t guard
 	{
-		null(this->buf)? size: 0, alignment
+		owner && guard_enable && !hugetlb_page? size_t(alignment): 0UL
 	};
 
-	const mutable_buffer &buf
+	const mutable_buffer buf
 	{
-		umb? umb: this->buf
+		owner?
+			mutable_buffer
+			{
+				reinterpret_cast<char *>(acquire(size, guard)) + guard, size
+			}:
+			this->buf
 	};
 
 	c.size = ircd::size(buf);
@@ -3218,8 +3918,9 @@ ircd::ctx::stack::allocator::allocate(stack_context &c,
 		c.valgrind_stack_id = vg::stack::add(buf);
 	#endif
 
-	this->owner = bool(umb);
-	this->buf = umb? umb.release(): this->buf;
+	this->owner = owner;
+	this->guard = guard;
+	this->buf = buf;
 }
 
 void
@@ -3232,13 +3933,140 @@ ircd::ctx::stack::allocator::deallocate(stack_context &c)
 		vg::stack::del(c.valgrind_stack_id);
 	#endif
 
+	if(!owner)
+		return;
+
 	const auto base
 	{
-		(reinterpret_cast<uintptr_t>(c.sp) - c.size)
-		& boolmask<uintptr_t>(owner)
+		reinterpret_cast<char *>(c.sp) - c.size - guard
+	};
+
+	release(base, c.size, guard);
+}
+
+void *
+ircd::ctx::stack::allocator::acquire(const size_t &size,
+                                     const size_t &guard)
+{
+	static const auto &alignment
+	{
+		info::page_size
+	};
+
+	const auto it
+	{
+		cache.find(size + guard)
+	};
+
+	if(it != end(cache))
+	{
+		void *const ret(it->second);
+		cache.erase(it);
+		cache_bytes -= !hugetlb || !hugetlb->has(ret)? size + guard: 0UL;
+		++cache_hits;
+		return ret;
+	}
+
+	if(auto *const region{hugetlb_region()}; region)
+		if(void *const ret{region->allocate(size + guard, alignment)}; ret)
+		{
+			++cache_misses;
+			return ret;
+		}
+
+	unique_mutable_buffer umb
+	{
+		size + guard, alignment
+	};
+
+	if(guard)
+		sys::call(::mprotect, data(umb), guard, PROT_NONE);
+
+	++cache_misses;
+	return data(umb.release());
+}
+
+void
+ircd::ctx::stack::allocator::release(void *const ptr,
+                                     const size_t &size,
+                                     const size_t &guard)
+noexcept try
+{
+	static const auto &page_size
+	{
+		info::page_size
+	};
+
+	// Stacks on hugepages are always kept; they can't go anywhere else and
+	// their pages aren't given back while cached.
+	if(hugetlb && hugetlb->has(ptr))
+	{
+		cache.emplace(size + guard, ptr);
+		return;
+	}
+
+	if(uint64_t(cache_bytes) + size + guard <= size_t(cache_max))
+	{
+		// Return the pages to the system while the stack is cached; only the
+		// top page where the next context's base frame lands is retained.
+		// The remainder will be faulted in zeroed as the next context grows.
+		#if defined(MADV_DONTNEED)
+		if(likely(size > page_size))
+			sys::call(::madvise, reinterpret_cast<char *>(ptr) + guard, size - page_size, MADV_DONTNEED);
+		#endif
+
+		cache.emplace(size + guard, ptr);
+		cache_bytes += size + guard;
+		return;
+	}
+
+	if(guard)
+		sys::call(::mprotect, ptr, guard, PROT_READ | PROT_WRITE);
+
+	std::free(ptr);
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Failed to release stack %p size:%zu guard:%zu :%s",
+		ptr,
+		size,
+		guard,
+		e.what(),
 	};
+}
+
+/// The region is reserved on first use; a failure is logged once and stacks
+/// are allocated from normal pages thereafter.
+ircd::allocator::hugetlb *
+ircd::ctx::stack::allocator::hugetlb_region()
+noexcept
+{
+	static bool tried;
+	if(likely(hugetlb || tried || !hugetlb_page))
+		return hugetlb.get();
+
+	tried = true;
+	try
+	{
+		hugetlb = std::make_unique<ircd::allocator::hugetlb>
+		(
+			size_t(hugetlb_page), size_t(hugetlb_size)
+		);
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "Failed to reserve %zu bytes of %zu byte hugepages for stacks :%s",
+			size_t(hugetlb_size),
+			size_t(hugetlb_page),
+			e.what(),
+		};
+	}
 
-	std::free(reinterpret_cast<void *>(base));
+	return hugetlb.get();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
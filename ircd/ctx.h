@@ -23,6 +23,13 @@ namespace ircd::ctx::prof
 	static void mark(const event &);
 }
 
+namespace ircd::ctx
+{
+	extern size_t sched_queued_interactive;
+	extern conf::item<bool> sched_defer;
+	extern stats::item<uint64_t> stack_peak;
+}
+
 /// Internal context implementation
 ///
 struct ircd::ctx::ctx
@@ -42,6 +49,8 @@ struct ircd::ctx::ctx
 	int8_t nice {0};                             // Scheduling priority nice-value
 	int8_t ionice {0};                           // IO priority nice-value (defaults for fs::opts)
 	int32_t notes {0};                           // norm: 0 = asleep; 1 = awake; inc by others; dec by self
+	bool queued_interactive {false};             // counted in sched_queued_interactive
+	unsigned arena {0};                          // allocator arena selected while asleep
 	boost::asio::deadline_timer alarm;           // acting semaphore (64B)
 	boost::asio::yield_context *yc {nullptr};    // boost interface
 	continuation *cont {nullptr};                // valid when asleep; invalid when awake
@@ -13,6 +13,7 @@
 namespace ircd::ctx::ole
 {
 	extern conf::item<size_t> thread_max;
+	extern conf::item<std::string> affinity;
 	std::mutex mutex;
 	std::condition_variable cond;
 	std::deque<offload::function> queue;
@@ -31,6 +32,20 @@ ircd::ctx::ole::thread_max
 	{ "default",  int64_t(1)                 },
 };
 
+decltype(ircd::ctx::ole::affinity)
+ircd::ctx::ole::affinity
+{
+	{ "name",     "ircd.ctx.ole.affinity" },
+	{ "default",  string_view{}           },
+	{ "description",
+
+	R"(
+	CPU affinity of the offload threads as a cpulist(7) string (i.e. "8-15").
+	Empty inherits the affinity of the main thread. Applied when each thread
+	starts.
+	)"},
+};
+
 ircd::ctx::ole::init::init()
 {
 	assert(threads.empty());
@@ -62,15 +77,20 @@ ircd::ctx::ole::offload::offload(const opts &opts,
                                  const function &func)
 {
 	assert(current);
-	assert(opts.concurrency == 1); // not yet implemented
+	assert(opts.concurrency >= 1);
+	const size_t concurrency
+	{
+		std::max(opts.concurrency, 1UL)
+	};
 
 	// Prepare the offload package on our stack here. These objects will
-	// remain here for the duration of the offload.
-	latch latch{1};
-	std::exception_ptr eptr;
+	// remain here for the duration of the offload. Each thread is given its
+	// own exception slot so no synchronization is required between them.
+	latch latch{concurrency};
+	std::vector<std::exception_ptr> eptr(concurrency);
 	auto *const context(current);
-	auto closure{[&func, &latch, &eptr, &context]
-	() noexcept
+	const auto closure{[&func, &latch, &context]
+	(std::exception_ptr &eptr) noexcept
 	{
 		try
 		{
@@ -101,16 +121,23 @@ ircd::ctx::ole::offload::offload(const opts &opts,
 	// capable of throwing an interrupt that was received during this scope.
 	const uninterruptible uninterruptible;
 
-	ole::push(std::move(closure));       // scope address required for clang-7
+	for(size_t i(0); i < concurrency; ++i)
+		ole::push([&closure, &eptr = eptr.at(i)]
+		{
+			closure(eptr);
+		});
+
 	latch.wait();
 
 	// Don't throw any exception if there is a pending interrupt for this ctx.
 	// Two exceptions will be thrown in that case and if there's an interrupt
 	// we don't care about eptr anyway.
 	if(likely(!interruption_requested()))
-		if(unlikely(eptr))
-			std::rethrow_exception(eptr);
+		for(size_t i(0); i < concurrency; ++i)
+			if(unlikely(eptr.at(i)))
+				std::rethrow_exception(eptr.at(i));
 }
+
 void
 ircd::ctx::ole::push(offload::function &&func)
 {
@@ -130,6 +157,15 @@ void
 ircd::ctx::ole::worker()
 noexcept try
 {
+	if(string_view(affinity)) try
+	{
+		sys::affinity(affinity);
+	}
+	catch(const std::system_error &)
+	{
+		// The worker carries on unpinned.
+	}
+
 	while(1)
 	{
 		const auto func
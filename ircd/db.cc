@@ -121,6 +121,7 @@ try
 	request_pool();
 	test_direct_io();
 	test_hw_crc32();
+	compaction::init();
 }
 catch(const std::exception &e)
 {
@@ -136,6 +137,8 @@ catch(const std::exception &e)
 ircd::db::init::~init()
 noexcept
 {
+	compaction::fini();
+
 	delete prefetcher;
 	prefetcher = nullptr;
 
@@ -440,6 +443,268 @@ ircd::db::perf_level()
 	return rocksdb::GetPerfLevel();
 }
 
+//
+// trace
+//
+
+namespace ircd::db::trace
+{
+	enum source :uint8_t;
+
+	using point_id = std::tuple<const database::column *, string_view, std::string>;
+
+	static string_view reflect(const source &);
+
+	extern uint perf_level_prior;
+	extern std::map<point_id, point, std::less<>> points;
+}
+
+enum ircd::db::trace::source
+:uint8_t
+{
+	UNKNOWN,
+	MEMTABLE,
+	CACHE,
+	DISK,
+};
+
+decltype(ircd::db::trace::log)
+ircd::db::trace::log
+{
+	"db.trace"
+};
+
+decltype(ircd::db::trace::perf_level_prior)
+ircd::db::trace::perf_level_prior;
+
+decltype(ircd::db::trace::points)
+ircd::db::trace::points;
+
+decltype(ircd::db::trace::enable)
+ircd::db::trace::enable
+{
+	{
+		{ "name",     "ircd.db.trace.enable" },
+		{ "default",  false                  },
+		{ "description",
+
+		R"(
+		Record the latency of reads for each column, operation and name of the
+		calling context, and log reads slower than ircd.db.trace.slow. This
+		raises the rocksdb perf level to count block reads while enabled.
+		)"},
+	}, []
+	{
+		if(enable && perf_level() < rocksdb::PerfLevel::kEnableCount)
+		{
+			perf_level_prior = perf_level();
+			perf_level(rocksdb::PerfLevel::kEnableCount);
+		}
+		else if(!enable && perf_level_prior)
+		{
+			perf_level(perf_level_prior);
+			perf_level_prior = 0;
+		}
+	}
+};
+
+decltype(ircd::db::trace::slow)
+ircd::db::trace::slow
+{
+	{ "name",     "ircd.db.trace.slow" },
+	{ "default",  10000L               },
+	{ "description",
+
+	R"(
+	Microseconds after which a traced read is logged as slow. 0 disables the
+	slow-read log while leaving the latency record enabled.
+	)"},
+};
+
+bool
+ircd::db::trace::for_each(const closure &closure)
+{
+	for(const auto &[key, point] : points)
+		if(!closure(point))
+			return false;
+
+	return true;
+}
+
+void
+ircd::db::trace::clear()
+noexcept
+{
+	points.clear();
+}
+
+void
+ircd::db::trace::record(database::column &c,
+                        const string_view &op,
+                        const string_view &key,
+                        const nanoseconds &dur,
+                        const uint8_t &source_)
+{
+	const auto from
+	{
+		static_cast<source>(source_)
+	};
+
+	const string_view ctx_name
+	{
+		ctx::current?
+			ctx::name(*ctx::current):
+			"*"_sv
+	};
+
+	const auto point_key
+	{
+		std::make_tuple(static_cast<const database::column *>(&c), op, std::string(ctx_name))
+	};
+
+	auto it
+	{
+		points.lower_bound(point_key)
+	};
+
+	if(it == end(points) || it->first != point_key)
+	{
+		point p;
+		p.column = fmt::snstringf
+		{
+			128, "%s:%s", db::name(*c.d), db::name(c)
+		};
+
+		p.op = op;
+		p.ctx = ctx_name;
+		it = points.emplace_hint(it, point_key, std::move(p));
+	}
+
+	auto &p(it->second);
+	const uint64_t us
+	{
+		(uint64_t(std::max(dur.count(), 0L)) + 999) / 1000
+	};
+
+	const size_t pos
+	{
+		us > 1?
+			std::min(size_t(64 - __builtin_clzl(us - 1)), p.bucket.size() - 1):
+			0UL
+	};
+
+	++p.bucket[pos];
+	++p.count;
+	p.sum += dur;
+	p.max = std::max(p.max, dur);
+	p.memtable += from == MEMTABLE;
+	p.cache += from == CACHE;
+	p.disk += from == DISK;
+
+	if(!slow.count() || dur < microseconds(slow))
+		return;
+
+	char pbuf[48], kbuf[65];
+	log::dwarning
+	{
+		log, "[%s] %s %s from '%s' in %s key:%s",
+		p.column,
+		op,
+		reflect(from),
+		ctx_name,
+		pretty(pbuf, dur, 1),
+		u2a(kbuf, const_buffer(key.substr(0, sizeof(kbuf) / 2))),
+	};
+}
+
+ircd::string_view
+ircd::db::trace::reflect(const source &source)
+{
+	switch(source)
+	{
+		case UNKNOWN:     return "UNKNOWN";
+		case MEMTABLE:    return "MEMTABLE";
+		case CACHE:       return "CACHE";
+		case DISK:        return "DISK";
+	}
+
+	return "?????";
+}
+
+//
+// trace::point
+//
+
+ircd::microseconds
+ircd::db::trace::point::percentile(const double &pct)
+const noexcept
+{
+	const uint64_t rank
+	{
+		uint64_t(std::ceil(count * std::clamp(pct, 0.0, 1.0)))
+	};
+
+	uint64_t sum(0);
+	for(size_t i(0); i < bucket.size(); ++i)
+		if((sum += bucket[i]) >= rank && sum)
+			return microseconds(1UL << i);
+
+	return duration_cast<microseconds>(max);
+}
+
+//
+// trace::sample
+//
+
+ircd::db::trace::sample::sample(database::column &c,
+                                const string_view &op,
+                                const string_view &key)
+:c{c}
+,op{op}
+,key{key}
+,active{bool(enable)}
+,timer{ircd::timer::nostart}
+{
+	if(likely(!active))
+		return;
+
+	const auto *const pc(rocksdb::get_perf_context());
+	block_read = pc? pc->block_read_count: 0;
+	cache_hit = pc? pc->block_cache_hit_count: 0;
+	timer.cont();
+}
+
+ircd::db::trace::sample::~sample()
+noexcept
+{
+	if(likely(!active))
+		return;
+
+	const auto elapsed
+	{
+		timer.at<nanoseconds>()
+	};
+
+	const auto *const pc(rocksdb::get_perf_context());
+	const bool counted
+	{
+		pc && perf_level() >= rocksdb::PerfLevel::kEnableCount
+	};
+
+	const source from
+	{
+		!counted?
+			UNKNOWN:
+		pc->block_read_count > block_read?
+			DISK:
+		pc->block_cache_hit_count > cache_hit?
+			CACHE:
+			MEMTABLE
+	};
+
+	record(c, op, key, elapsed, from);
+}
+
 //
 // ticker
 //
@@ -542,6 +807,20 @@ ircd::db::histogram_max
 decltype(ircd::db::prefetcher)
 ircd::db::prefetcher;
 
+decltype(ircd::db::prefetcher::batch_max)
+ircd::db::prefetcher::batch_max
+{
+	{ "name",     "ircd.db.prefetch.batch.max" },
+	{ "default",  32L                          },
+	{ "description",
+
+	R"(
+	Maximum number of queued requests for the same column taken together by
+	one request worker. These are sorted by key and conducted on the same
+	iterator so neighboring keys are read in the same span.
+	)"}
+};
+
 //
 // db::prefetcher
 //
@@ -592,6 +871,20 @@ ircd::db::prefetcher::operator()(column &c,
 
 	assert(ticker);
 	ticker->queries++;
+
+	// Coalesce with any request for the same key which hasn't finished yet;
+	// the key is truncated to match the request's buffer for the lookup.
+	const pending_key pending_query
+	{
+		std::addressof(d), db::id(c), trunc(key, sizeof(request::key_buf))
+	};
+
+	if(pending.count(pending_query))
+	{
+		ticker->dedups++;
+		return false;
+	}
+
 	if(db::cached(c, key, opts))
 	{
 		ticker->rejects++;
@@ -600,7 +893,9 @@ ircd::db::prefetcher::operator()(column &c,
 
 	queue.emplace_back(d, c, key);
 	queue.back().snd = now<steady_point>();
+	pending.emplace(queue.back().d, queue.back().cid, string_view(queue.back()));
 	ticker->request++;
+	ctx::prof::account(ctx::prof::event::DB_PREFETCH);
 
 	// Branch here based on whether it's not possible to directly dispatch
 	// a db::request worker. If all request workers are busy we notify our own
@@ -667,7 +962,7 @@ ircd::db::prefetcher::cancel(const closure &closure)
 			continue;
 
 		// cancel by precociously setting the finish time.
-		request.fin = now<steady_point>();
+		request_finish(request);
 		++canceled;
 	}
 
@@ -750,28 +1045,61 @@ ircd::db::prefetcher::request_worker()
 
 	// Find the first request in the queue which does not have its req
 	// timestamp sent.
+	const auto unsent{[]
+	(const auto &request)
+	{
+		return
+			request.req == steady_point::min() &&
+			request.fin == steady_point::min();
+	}};
+
 	auto request
 	{
-		std::find_if(begin(queue), end(queue), []
-		(const auto &request)
-		{
-			return request.req == steady_point::min();
-		})
+		std::find_if(begin(queue), end(queue), unsent)
 	};
 
 	if(request == end(queue))
 		return;
 
+	// Take any other unsent requests for the same column into this batch.
+	// Pointers to deque elements remain valid while the queue grows at the
+	// back and is cleaned up at the front.
+	const size_t max
+	{
+		std::clamp(size_t(batch_max), 1UL, 128UL)
+	};
+
+	size_t num(0);
+	struct request *batch[max];
+	batch[num++] = std::addressof(*request);
+	for(auto it(std::next(request)); it != end(queue) && num < max; ++it)
+		if(unsent(*it) && it->d == request->d && it->cid == request->cid)
+			batch[num++] = std::addressof(*it);
+
+	std::sort(batch, batch + num, []
+	(const auto *const &a, const auto *const &b)
+	{
+		return string_view(*a) < string_view(*b);
+	});
+
 	assert(ticker);
-	assert(request->fin == steady_point::min());
-	request->req = now<steady_point>();
-	ticker->last_snd_req = duration_cast<microseconds>(request->req - request->snd);
-	static_cast<microseconds &>(ticker->accum_snd_req) += ticker->last_snd_req;
+	const auto req
+	{
+		now<steady_point>()
+	};
 
-	ticker->fetches++;
-	request_handle(*request);
-	assert(request->fin != steady_point::min());
-	ticker->fetched++;
+	for(size_t i(0); i < num; ++i)
+	{
+		assert(batch[i]->fin == steady_point::min());
+		batch[i]->req = req;
+		ticker->last_snd_req = duration_cast<microseconds>(req - batch[i]->snd);
+		static_cast<microseconds &>(ticker->accum_snd_req) += ticker->last_snd_req;
+	}
+
+	ticker->batches++;
+	ticker->fetches += num;
+	request_handle(vector_view<struct request *>(batch, num));
+	ticker->fetched += num;
 
 	#ifdef IRCD_DB_DEBUG_PREFETCH
 	log::debug
@@ -802,27 +1130,66 @@ noexcept
 }
 
 void
-ircd::db::prefetcher::request_handle(request &request)
-try
+ircd::db::prefetcher::request_finish(request &request)
+noexcept
 {
-	assert(request.d);
+	request.fin = now<steady_point>();
+	pending.erase(pending_key
+	{
+		request.d, request.cid, string_view(request)
+	});
+}
+
+void
+ircd::db::prefetcher::request_handle(const vector_view<request *> &batch)
+{
+	assert(!batch.empty());
+	assert(batch.front()->d);
 	db::column column
 	{
-		(*request.d)[request.cid]
+		(*batch.front()->d)[batch.front()->cid]
 	};
 
+	// Requests remaining in the batch when an exception propagates (i.e. an
+	// interruption) must still be finished for the queue to clean up.
+	const unwind finish{[this, &batch]
+	{
+		for(auto *const &request : batch)
+			if(request->fin == steady_point::min())
+				request_finish(*request);
+	}};
+
+	// The batch is sorted by key so the same iterator seeks forward.
+	std::unique_ptr<rocksdb::Iterator> it;
+	for(auto *const &request : batch)
+	{
+		assert(request->d == batch.front()->d);
+		assert(request->cid == batch.front()->cid);
+		request_handle(*request, column, it);
+	}
+}
+
+void
+ircd::db::prefetcher::request_handle(request &request,
+                                     database::column &column,
+                                     std::unique_ptr<rocksdb::Iterator> &it)
+try
+{
 	const string_view key
 	{
 		request
 	};
 
-	const auto it
+	static const auto opts
 	{
-		seek(column, key, gopts{})
+		make_opts(gopts{})
 	};
 
+	seek(column, key, opts, it);
+	assert(it);
+
 	const ctx::critical_assertion ca;
-	request.fin = now<steady_point>();
+	request_finish(request);
 	ticker->last_req_fin = duration_cast<microseconds>(request.fin - request.req);
 	static_cast<microseconds &>(ticker->accum_req_fin) += ticker->last_req_fin;
 	const bool lte
@@ -857,7 +1224,7 @@ try
 catch(const std::exception &e)
 {
 	assert(request.d);
-	request.fin = now<steady_point>();
+	request_finish(request);
 
 	log::error
 	{
@@ -869,7 +1236,7 @@ catch(const std::exception &e)
 }
 catch(...)
 {
-	request.fin = now<steady_point>();
+	request_finish(request);
 	throw;
 }
 
@@ -987,6 +1354,14 @@ ircd::db::prefetcher::ticker::ticker()
 {
 	{ "name", "ircd.db.prefetch.cancels" },
 }
+,dedups
+{
+	{ "name", "ircd.db.prefetch.dedups" },
+}
+,batches
+{
+	{ "name", "ircd.db.prefetch.batches" },
+}
 ,fetched_bytes_key
 {
 	{ "name", "ircd.db.prefetch.fetched_bytes_key" },
@@ -1360,6 +1735,65 @@ ircd::db::txn::operator()(database &d,
 	this->state = state::COMMITTED;
 }
 
+void
+ircd::db::commit(const vector_view<txn *> &txns,
+                 const sopts &opts)
+{
+	if(txns.empty())
+		return;
+
+	if(txns.size() == 1)
+		return (*txns[0])(opts);
+
+	assert(bool(txns[0]->d));
+	database &d
+	{
+		*txns[0]->d
+	};
+
+	// The WriteBatch representation is a 12 byte header (8 byte sequence,
+	// 4 byte little-endian count) followed by the records; batches are
+	// concatenated by appending records and summing the count.
+	static const size_t header_size
+	{
+		8 + 4
+	};
+
+	size_t bytes(0), count(0);
+	for(const auto *const txn : txns)
+	{
+		assert(txn && txn->wb);
+		assert(txn->d == &d);
+		assert(txn->state == txn::state::BUILD);
+		assert(txn->wb->GetDataSize() >= header_size);
+		bytes += txn->wb->GetDataSize() - header_size;
+		count += txn->wb->Count();
+	}
+
+	std::string rep;
+	rep.reserve(header_size + bytes);
+	rep.append(txns[0]->wb->Data(), 0, header_size);
+	for(const auto *const txn : txns)
+		rep.append(txn->wb->Data(), header_size, std::string::npos);
+
+	assert(count <= std::numeric_limits<uint32_t>::max());
+	for(size_t i(0); i < 4; ++i)
+		rep[8 + i] = char((count >> (i * 8)) & 0xff);
+
+	rocksdb::WriteBatch batch
+	{
+		std::move(rep)
+	};
+
+	assert(size_t(batch.Count()) == count);
+	for(auto *const txn : txns)
+		txn->state = txn::state::COMMIT;
+
+	commit(d, batch, opts);
+	for(auto *const txn : txns)
+		txn->state = txn::state::COMMITTED;
+}
+
 void
 ircd::db::txn::clear()
 {
@@ -1851,14 +2285,22 @@ ircd::db::row::row(database &d,
 	using std::end;
 	using std::begin;
 
-	if(!opts.snapshot)
+	const auto pin
+	{
+		database::snapshot::pin::get(d)
+	};
+
+	if(!opts.snapshot && !pin)
 		opts.snapshot = database::snapshot(d);
 
-	const rocksdb::ReadOptions options
+	rocksdb::ReadOptions options
 	{
 		make_opts(opts)
 	};
 
+	if(!options.snapshot)
+		options.snapshot = pin;
+
 	assert(buf.size() >= colnames.size());
 	const size_t request_count
 	{
@@ -1936,6 +2378,11 @@ ircd::db::_make_iterators(database &d,
 
 	std::vector<Iterator *> ret;
 	const ctx::stack_usage_assertion sua;
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::db
+	};
+
 	throw_on_error
 	{
 		d.d->NewIterators(opts, handles, &ret)
@@ -2929,6 +3376,63 @@ ircd::db::read(const columns &c,
 	return ret;
 }
 
+size_t
+ircd::db::read(const columns &c,
+               const keys &key,
+               const read_closure &closure,
+               const gopts &gopts)
+{
+	// Number of operations submitted to the database in one MultiGet. This
+	// bounds the stack used by _read() for arbitrarily large queries.
+	static const size_t batch_max
+	{
+		128
+	};
+
+	if(c.empty())
+		return 0UL;
+
+	const auto opts
+	{
+		make_opts(gopts)
+	};
+
+	size_t ret(0);
+	for(size_t i(0); i < key.size(); i += batch_max)
+	{
+		const size_t num
+		{
+			std::min(key.size() - i, batch_max)
+		};
+
+		_read_op op[num];
+		for(size_t j(0); j < num; ++j)
+			op[j] =
+			{
+				c[std::min(c.size() - 1, i + j)], key[i + j]
+			};
+
+		size_t j(i);
+		_read({op, num}, opts, [&closure, &ret, &j]
+		(column &, const column::delta &d, const rocksdb::Status &s)
+		{
+			const bool found
+			{
+				s.ok()
+			};
+
+			if(closure)
+				closure(j, std::get<column::delta::VAL>(d), found);
+
+			ret += found;
+			++j;
+			return true;
+		});
+	}
+
+	return ret;
+}
+
 std::string
 ircd::db::read(column &column,
                const string_view &key,
@@ -4501,6 +5005,38 @@ ircd::db::commit(database &d,
 	commit(d, batch, opts);
 }
 
+namespace ircd::db
+{
+	static void commit_sync(database &, const uint64_t &sequence);
+}
+
+decltype(ircd::db::wal_sync_window)
+ircd::db::wal_sync_window
+{
+	{ "name",     "ircd.db.wal.sync.window" },
+	{ "default",  0L                        },
+	{ "description",
+
+	R"(
+	Microseconds a commit requiring synchronization (FSYNC) waits for other
+	such commits to join it before the write-ahead log is synchronized once
+	for all of them. Commits arriving while a synchronization is in progress
+	join the next one regardless; zero adds no wait beyond that.
+	)"},
+};
+
+decltype(ircd::db::wal_sync_groups)
+ircd::db::wal_sync_groups
+{
+	{ "name", "ircd.db.wal.sync.groups" },
+};
+
+decltype(ircd::db::wal_sync_commits)
+ircd::db::wal_sync_commits
+{
+	{ "name", "ircd.db.wal.sync.commits" },
+};
+
 void
 ircd::db::commit(database &d,
                  rocksdb::WriteBatch &batch,
@@ -4510,13 +5046,37 @@ ircd::db::commit(database &d,
 	ircd::timer timer;
 	#endif
 
-	const std::lock_guard lock{d.write_mutex};
+	// Synchronized commits are written without synchronization and then
+	// wait for a group synchronization of the log covering their write. The
+	// write is visible to readers before it's durable.
+	const bool group_sync
+	{
+		opts.sync && !opts.disableWAL
+	};
+
+	auto wopts(opts);
+	wopts.sync &= !group_sync;
+
 	const ctx::uninterruptible ui;
 	const ctx::stack_usage_assertion sua;
-	throw_on_error
+	uint64_t seq(0);
 	{
-		d.d->Write(opts, &batch)
-	};
+		const std::lock_guard lock{d.write_mutex};
+		const allocator::je::arena::scope arena
+		{
+			allocator::je::arena::db
+		};
+
+		throw_on_error
+		{
+			d.d->Write(wopts, &batch)
+		};
+
+		seq = sequence(d);
+	}
+
+	if(group_sync)
+		commit_sync(d, seq);
 
 	#ifdef RB_DEBUG
 	char dbuf[192];
@@ -4531,6 +5091,53 @@ ircd::db::commit(database &d,
 	#endif
 }
 
+/// Returns when the log has been synchronized past `sequence`. The first
+/// commit to arrive leads the group: it waits the window for others to
+/// write, then synchronizes the log once for all writes made so far.
+/// Commits arriving while the leader is synchronizing wait for it and lead
+/// the next group if the synchronization did not cover their write.
+void
+ircd::db::commit_sync(database &d,
+                      const uint64_t &sequence)
+{
+	++wal_sync_commits;
+	while(d.sync_sequence < sequence)
+	{
+		if(d.syncing)
+		{
+			d.sync_dock.wait([&d]
+			{
+				return !d.syncing;
+			});
+
+			continue;
+		}
+
+		d.syncing = true;
+		const unwind release{[&d]
+		{
+			d.syncing = false;
+			d.sync_dock.notify_all();
+		}};
+
+		if(size_t(wal_sync_window))
+			ctx::sleep(microseconds(size_t(wal_sync_window)));
+
+		const auto covered
+		{
+			db::sequence(d)
+		};
+
+		throw_on_error
+		{
+			d.d->SyncWAL()
+		};
+
+		d.sync_sequence = std::max(d.sync_sequence, covered);
+		++wal_sync_groups;
+	}
+}
+
 ircd::string_view
 ircd::db::debug(const mutable_buffer &buf,
                 const rocksdb::WriteBatch &batch)
@@ -4635,16 +5242,27 @@ ircd::db::_seek(database::column &c,
 
 	rocksdb::ColumnFamilyHandle *const &cf(c);
 	database &d(*c.d);
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::db
+	};
 
-	#ifdef RB_DEBUG_DB_SEEK
-	const ircd::timer timer;
-	#endif
+	std::optional<rocksdb::ReadOptions> _ropts;
+	const trace::sample sample
+	{
+		c, "get", key
+	};
 
+	const ircd::timer timer;
 	const rocksdb::Status ret
 	{
-		d.d->Get(ropts, cf, slice(key), &s)
+		d.d->Get(pinned(d, ropts, _ropts), cf, slice(key), &s)
 	};
 
+	c.stats->get_latency(timer.at<nanoseconds>());
+	ctx::prof::account(ctx::prof::event::DB_READS);
+	ctx::prof::account(ctx::prof::event::DB_BYTES, ret.ok()? s.size(): 0UL);
+
 	#ifdef RB_DEBUG_DB_SEEK
 	log::debug
 	{
@@ -4786,9 +5404,27 @@ ircd::db::_seek(const vector_view<_read_op> &op,
 	#endif
 
 	#ifdef IRCD_DB_HAS_MULTIGET_BATCHED
-	d.d->MultiGet(ropts, num, cf, key, val.data(), ret.data());
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::db
+	};
+
+	std::optional<rocksdb::ReadOptions> _ropts;
+	const trace::sample sample
+	{
+		std::get<column>(mutable_cast(op[0])), "multiget", std::get<1>(op[0])
+	};
+
+	d.d->MultiGet(pinned(d, ropts, _ropts), num, cf, key, val.data(), ret.data());
 	#endif
 
+	size_t bytes(0);
+	for(size_t i(0); i < num; ++i)
+		bytes += ret[i].ok()? val[i].size(): 0UL;
+
+	ctx::prof::account(ctx::prof::event::DB_READS, num);
+	ctx::prof::account(ctx::prof::event::DB_BYTES, bytes);
+
 	#ifdef RB_DEBUG_DB_SEEK
 	log::debug
 	{
@@ -4842,10 +5478,15 @@ ircd::db::seek(database::column &c,
 	if(!it)
 	{
 		const ctx::uninterruptible::nothrow ui;
+		const allocator::je::arena::scope arena
+		{
+			allocator::je::arena::db
+		};
 
 		database &d(*c.d);
 		rocksdb::ColumnFamilyHandle *const &cf(c);
-		it.reset(d.d->NewIterator(opts, cf));
+		std::optional<rocksdb::ReadOptions> _opts;
+		it.reset(d.d->NewIterator(pinned(d, opts, _opts), cf));
 	}
 
 	return _seek(c, p, opts, *it);
@@ -4865,6 +5506,16 @@ try
 	const ircd::timer timer;
 	#endif
 
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::db
+	};
+
+	const trace::sample sample
+	{
+		c, "seek", p
+	};
+
 	_seek_(it, p);
 
 	#ifdef RB_DEBUG_DB_SEEK
@@ -4917,6 +5568,11 @@ try
 	};
 	#endif
 
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::db
+	};
+
 	_seek_(it, p);
 
 	#ifdef RB_DEBUG_DB_SEEK
@@ -5256,6 +5912,22 @@ ircd::db::read_checksum
 	{ "default",  false                   }
 };
 
+decltype(ircd::db::read_readahead_adaptive)
+ircd::db::read_readahead_adaptive
+{
+	{ "name",     "ircd.db.read.readahead.adaptive" },
+	{ "default",  true                              },
+	{ "description",
+
+	R"(
+	Ignore the fixed readahead sizes requested for iterators and let the
+	readahead of each iterator grow while it reads sequentially and reset when
+	it seeks elsewhere. RocksDB does this for buffered reads; for direct reads
+	the windows of ircd.db.env.readahead adapt instead. When disabled each
+	iterator reads ahead by its fixed size (i.e. ircd.m.events.*.readahead).
+	)"},
+};
+
 namespace ircd::db
 {
 	static const rocksdb::ReadOptions default_read_options;
@@ -5263,6 +5935,29 @@ namespace ircd::db
 
 /// Convert our options structure into RocksDB's options structure.
 [[gnu::hot]]
+/// Substitutes the snapshot pinned by the current context for the database
+/// when the options don't have their own; a copy is made only in that case.
+const rocksdb::ReadOptions &
+ircd::db::pinned(const database &d,
+                 const rocksdb::ReadOptions &opts,
+                 std::optional<rocksdb::ReadOptions> &buf)
+{
+	if(opts.snapshot)
+		return opts;
+
+	const auto snapshot
+	{
+		database::snapshot::pin::get(d)
+	};
+
+	if(likely(!snapshot))
+		return opts;
+
+	buf.emplace(opts);
+	buf->snapshot = snapshot;
+	return *buf;
+}
+
 rocksdb::ReadOptions
 ircd::db::make_opts(const gopts &opts)
 {
@@ -5280,7 +5975,7 @@ ircd::db::make_opts(const gopts &opts)
 	assume(ret.prefix_same_as_start == false);
 
 	ret.snapshot = opts.snapshot;
-	ret.readahead_size = opts.readahead;
+	ret.readahead_size = !read_readahead_adaptive? opts.readahead: 0UL;
 
 	// slice* for exclusive upper bound. when prefixes are used this value must
 	// have the same prefix because ordering is not guaranteed between prefixes
@@ -72,7 +72,11 @@ namespace ircd::db
 	// state
 	extern log::log rog;
 	extern conf::item<bool> enable_wal;
+	extern conf::item<size_t> wal_sync_window;
+	extern stats::item<uint64_t> wal_sync_groups;
+	extern stats::item<uint64_t> wal_sync_commits;
 	extern conf::item<bool> read_checksum;
+	extern conf::item<bool> read_readahead_adaptive;
 	extern conf::item<size_t> request_pool_size;
 	extern conf::item<size_t> request_pool_stack_size;
 	extern ctx::pool::opts request_pool_opts;
@@ -95,6 +99,7 @@ namespace ircd::db
 	// Frequently used get options and set options are separate from the string/map system
 	rocksdb::WriteOptions make_opts(const sopts &);
 	rocksdb::ReadOptions make_opts(const gopts &);
+	const rocksdb::ReadOptions &pinned(const database &, const rocksdb::ReadOptions &, std::optional<rocksdb::ReadOptions> &);
 
 	// Database options creator
 	static bool optstr_find_and_remove(std::string &optstr, const std::string &what);
@@ -146,8 +151,39 @@ namespace ircd::db
 	std::shared_ptr<const database::column> shared_from(const database::column &);
 	std::shared_ptr<database::column> shared_from(database::column &);
 }
+
+/// Scheduling of automatic compaction around peak hours.
+namespace ircd::db::compaction
+{
+	void init(), fini() noexcept;
+}
+
+namespace ircd::db::trace
+{
+	struct sample;
+
+	void record(database::column &, const string_view &op, const string_view &key, const nanoseconds &, const uint8_t &source);
+}
 #pragma GCC visibility pop
 
+/// Scope of a traced read; inert unless tracing is enabled. The source of
+/// the result is deduced from the perf counters advanced during the scope.
+struct [[gnu::visibility("hidden")]]
+ircd::db::trace::sample
+{
+	database::column &c;
+	string_view op;
+	string_view key;
+	bool active {false};
+	uint64_t block_read {0};
+	uint64_t cache_hit {0};
+	ircd::timer timer;
+
+	sample(database::column &, const string_view &op, const string_view &key);
+	sample(const sample &) = delete;
+	~sample() noexcept;
+};
+
 #ifdef IRCD_DB_HAS_ALLOCATOR
 /// Dynamic memory
 struct [[gnu::visibility("hidden")]]
@@ -159,6 +195,11 @@ ircd::db::database::allocator final
 	static const bool mlock_enabled;
 	static size_t mlock_current;
 	static unsigned cache_arena;
+	static conf::item<size_t> cache_hugetlb_page;
+	static conf::item<size_t> cache_hugetlb_size;
+	static std::unique_ptr<ircd::allocator::hugetlb> cache_hugetlb;
+	static conf::item<bool> cache_numa;
+	static int cache_numa_node;
 
 	database *d {nullptr};
 	database::column *c {nullptr};
@@ -329,6 +370,7 @@ ircd::db::database::stats final
 	ircd::stats::item<uint64_t> get_referenced;
 	ircd::stats::item<uint64_t> multiget_copied;
 	ircd::stats::item<uint64_t> multiget_referenced;
+	ircd::stats::histogram get_latency;
 
 	string_view make_name(const string_view &ticker_name) const; // tls buffer
 
@@ -514,6 +556,7 @@ ircd::db::database::rate_limiter
 	}
 	requests[IOPriority::IO_TOTAL];
 	int64_t bytes_per_second {1_GiB};
+	steady_point next;                 // pacing of IO_LOW requests
 
 	bool IsRateLimited(OpType) noexcept override;
 	int64_t GetBytesPerSecond() const noexcept override;
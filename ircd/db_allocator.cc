@@ -40,6 +40,7 @@ namespace ircd::db
 	static bool cache_arena_handle_purge_forced(extent_hooks_t *, void *, size_t, size_t, size_t, uint) noexcept;
 	static bool cache_arena_handle_split(extent_hooks_t *, void *, size_t, size_t, size_t, bool, uint) noexcept;
 	static bool cache_arena_handle_merge(extent_hooks_t *, void *, size_t, void *, size_t, bool, uint) noexcept;
+	static bool cache_arena_hugetlb(const void *) noexcept;
 	thread_local extent_hooks_t *their_cache_arena_hooks, cache_arena_hooks;
 	#endif
 }
@@ -81,11 +82,114 @@ ircd::db::database::allocator::mlock_current;
 decltype(ircd::db::database::allocator::cache_arena)
 ircd::db::database::allocator::cache_arena;
 
+decltype(ircd::db::database::allocator::cache_hugetlb_page)
+ircd::db::database::allocator::cache_hugetlb_page
+{
+	{ "name",     "ircd.db.allocator.hugetlb.page" },
+	{ "default",  0L                               },
+	{ "persist",  false                            },
+	{ "description",
+
+	R"(
+	Size of the explicit hugepages backing the block cache arena (i.e. 2097152
+	or 1073741824); zero disables. The pages must be reserved on the system
+	(see vm.nr_hugepages) before startup. Requires jemalloc. Set in the
+	environment; it is read once when the databases are initialized.
+	)"},
+};
+
+decltype(ircd::db::database::allocator::cache_hugetlb_size)
+ircd::db::database::allocator::cache_hugetlb_size
+{
+	{ "name",     "ircd.db.allocator.hugetlb.size" },
+	{ "default",  long(1_GiB)                      },
+	{ "persist",  false                            },
+	{ "description",
+
+	R"(
+	Bytes of hugepages reserved for the block cache arena when enabled. This
+	memory is never returned to the system. The cache arena falls back to
+	normal pages after it is exhausted.
+	)"},
+};
+
+/// Region of explicit hugepages from which the cache arena's extents are
+/// carved when configured. Extents from here are retained by jemalloc when
+/// deallocated and recycled for the arena's later allocations.
+decltype(ircd::db::database::allocator::cache_hugetlb)
+ircd::db::database::allocator::cache_hugetlb;
+
+decltype(ircd::db::database::allocator::cache_numa)
+ircd::db::database::allocator::cache_numa
+{
+	{ "name",     "ircd.db.allocator.numa" },
+	{ "default",  true                     },
+	{ "persist",  false                    },
+	{ "description",
+
+	R"(
+	Prefer placing the block cache arena on the NUMA node of the main thread
+	which performs all reads. Only has effect on systems with more than one
+	node. Read once when the databases are initialized.
+	)"},
+};
+
+/// NUMA node preferred for the cache arena's extents, or -1 for no preference.
+decltype(ircd::db::database::allocator::cache_numa_node)
+ircd::db::database::allocator::cache_numa_node
+{
+	-1
+};
+
 void
 ircd::db::database::allocator::init()
 {
 	#ifdef IRCD_DB_USE_JEMALLOC
 	cache_arena = ircd::allocator::get<unsigned>("arenas.create");
+	cache_numa_node = cache_numa && info::numa_nodes > 1?
+		sys::numa_node():
+		-1;
+
+	if(cache_numa_node >= 0)
+		log::info
+		{
+			log, "Cache arena:%u prefers NUMA node %d of %zu",
+			cache_arena,
+			cache_numa_node,
+			info::numa_nodes,
+		};
+
+	if(cache_hugetlb_page) try
+	{
+		cache_hugetlb = std::make_unique<ircd::allocator::hugetlb>
+		(
+			size_t(cache_hugetlb_page), size_t(cache_hugetlb_size)
+		);
+
+		// The region is reserved but not yet faulted in; the policy applies
+		// to the pages as they are first touched.
+		if(cache_numa_node >= 0)
+			sys::numa_prefer(cache_hugetlb->region, cache_numa_node);
+
+		log::info
+		{
+			log, "Cache arena:%u reserved %zu hugepages of %zu KiB",
+			cache_arena,
+			size(cache_hugetlb->region) / cache_hugetlb->page_size,
+			cache_hugetlb->page_size / 1024,
+		};
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "Cache arena:%u failed to reserve %zu bytes of %zu byte hugepages :%s",
+			cache_arena,
+			size_t(cache_hugetlb_size),
+			size_t(cache_hugetlb_page),
+			e.what(),
+		};
+	}
 
 	char extent_hooks_keybuf[32];
 	const string_view cache_arena_hooks_key{fmt::sprintf
@@ -125,9 +229,21 @@ noexcept
 			keybuf, "arena.%u.destroy", cache_arena
 		}));
 	}
+
+	cache_hugetlb.reset();
 	#endif
 }
 
+#ifdef IRCD_DB_USE_JEMALLOC
+bool
+ircd::db::cache_arena_hugetlb(const void *const ptr)
+noexcept
+{
+	return database::allocator::cache_hugetlb
+	&& database::allocator::cache_hugetlb->has(ptr);
+}
+#endif
+
 #ifdef IRCD_DB_USE_JEMALLOC
 void *
 ircd::db::cache_arena_handle_alloc(extent_hooks_t *const hooks,
@@ -158,11 +274,25 @@ noexcept
 	};
 	#endif
 
+	// Fresh hugepages are zeroed by the kernel and always committed. Requests
+	// to extend at a specific address and those not fitting in the region go
+	// to the default hooks.
+	if(database::allocator::cache_hugetlb && !new_addr)
+		if(void *const ret{database::allocator::cache_hugetlb->allocate(size, alignment)}; ret)
+		{
+			*zero = true;
+			*commit = true;
+			return ret;
+		}
+
 	void *const ret
 	{
 		their_hooks.alloc(hooks, new_addr, size, alignment, zero, commit, arena_ind)
 	};
 
+	if(ret && database::allocator::cache_numa_node >= 0)
+		sys::numa_prefer(mutable_buffer{reinterpret_cast<char *>(ret), size}, database::allocator::cache_numa_node);
+
 	// This feature is only enabled when RLIMIT_MEMLOCK is unlimited. We don't
 	// want to deal with any limit at all.
 	#if defined(HAVE_MLOCK2) && defined(MLOCK_ONFAULT)
@@ -201,6 +331,10 @@ noexcept
 	};
 	#endif
 
+	// Opt out so jemalloc retains hugepage extents for reuse.
+	if(cache_arena_hugetlb(ptr))
+		return true;
+
 	const bool ret
 	{
 		their_hooks.dalloc(hooks, ptr, size, committed, arena_ind)
@@ -243,6 +377,10 @@ noexcept
 	};
 	#endif
 
+	// Hugepages are released with the whole region.
+	if(cache_arena_hugetlb(ptr))
+		return;
+
 	#if defined(HAVE_MLOCK2)
 	if(database::allocator::mlock_current)
 	{
@@ -282,6 +420,9 @@ noexcept
 	};
 	#endif
 
+	if(cache_arena_hugetlb(ptr))
+		return false;
+
 	return their_hooks.commit(hooks, ptr, size, offset, length, arena_ind);
 }
 #endif
@@ -312,6 +453,11 @@ noexcept
 	};
 	#endif
 
+	// Hugepages can't be decommitted or purged in part; refusing keeps them
+	// committed and in the arena.
+	if(cache_arena_hugetlb(ptr))
+		return true;
+
 	return their_hooks.decommit(hooks, ptr, size, offset, length, arena_ind);
 }
 #endif
@@ -342,6 +488,11 @@ noexcept
 	};
 	#endif
 
+	// Hugepages can't be decommitted or purged in part; refusing keeps them
+	// committed and in the arena.
+	if(cache_arena_hugetlb(ptr))
+		return true;
+
 	return their_hooks.purge_lazy(hooks, ptr, size, offset, length, arena_ind);
 }
 #endif
@@ -372,6 +523,11 @@ noexcept
 	};
 	#endif
 
+	// Hugepages can't be decommitted or purged in part; refusing keeps them
+	// committed and in the arena.
+	if(cache_arena_hugetlb(ptr))
+		return true;
+
 	return their_hooks.purge_forced(hooks, ptr, size, offset, length, arena_ind);
 }
 #endif
@@ -404,6 +560,9 @@ noexcept
 	};
 	#endif
 
+	if(cache_arena_hugetlb(ptr))
+		return false;
+
 	return their_hooks.split(hooks, ptr, size, size_a, size_b, committed, arena_ind);
 }
 #endif
@@ -436,6 +595,17 @@ noexcept
 	};
 	#endif
 
+	// Extents within the region are contiguous in the one mapping; they must
+	// never be merged with extents from outside of it.
+	const bool hugetlb[2]
+	{
+		cache_arena_hugetlb(addr_a),
+		cache_arena_hugetlb(addr_b),
+	};
+
+	if(hugetlb[0] || hugetlb[1])
+		return !(hugetlb[0] && hugetlb[1]);
+
 	return their_hooks.merge(hooks, addr_a, size_a, addr_b, size_b, committed, arena_ind);
 }
 #endif
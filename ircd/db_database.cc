@@ -10,6 +10,12 @@
 
 #include "db.h"
 
+namespace ircd::db
+{
+	static void warmup(database &);
+	static size_t backup_copy(const string_view &src, const string_view &dst, const size_t &size);
+}
+
 /// Conf item determines the recovery mode to use when opening any database.
 ///
 /// "absolute" - The default and is the same for an empty value. This means
@@ -81,6 +87,17 @@ ircd::db::auto_deletion
 	{ "persist",  false                   },
 };
 
+/// Conf item sets the size of the explicit hugepages RocksDB allocates the
+/// memtable arenas from; zero disables. RocksDB falls back to normal pages
+/// for an arena block when a hugepage allocation fails.
+decltype(ircd::db::memtable_hugetlb)
+ircd::db::memtable_hugetlb
+{
+	{ "name",     "ircd.db.memtable.hugetlb" },
+	{ "default",  0L                         },
+	{ "persist",  false                      },
+};
+
 /// Conf item dictates whether databases will be opened in slave mode; this
 /// is a recent feature of RocksDB which may not be available. It allows two
 /// instances of a database, so long as only one is not opened as a slave.
@@ -92,6 +109,126 @@ ircd::db::open_slave
 	{ "persist",  false                },
 };
 
+/// Directory where a slave (secondary) keeps its own info log; each database
+/// opened as a slave uses a subdirectory of its name so that several can be
+/// opened by the same instance.
+decltype(ircd::db::open_slave_path)
+ircd::db::open_slave_path
+{
+	{ "name",     "ircd.db.open.slave.path" },
+	{ "default",  "/tmp/slave"              },
+	{ "persist",  false                     },
+};
+
+/// Conf item sets the number of table files opened concurrently in the
+/// background after a database opens, so their readers (index and filter
+/// blocks) are loaded before the requests which need them; zero disables.
+decltype(ircd::db::open_warmup)
+ircd::db::open_warmup
+{
+	{ "name",     "ircd.db.open.warmup" },
+	{ "default",  4L                    },
+	{ "persist",  false                 },
+};
+
+/// Conf item limits the bytes per second read and written by a backup, so
+/// the copy does not starve the database of the device; zero is unlimited.
+decltype(ircd::db::backup_rate)
+ircd::db::backup_rate
+{
+	{ "name",     "ircd.db.backup.rate" },
+	{ "default",  long(64_MiB)          },
+};
+
+/// Conf item sets the size of the buffer a backup copies files through.
+decltype(ircd::db::backup_buffer)
+ircd::db::backup_buffer
+{
+	{ "name",     "ircd.db.backup.buffer" },
+	{ "default",  long(4_MiB)             },
+};
+
+/// Opens the reader of every live table file through the table cache, up to
+/// open_warmup at a time in db::request workers. RocksDB otherwise only opens
+/// a handful upfront and the rest one at a time as the first reads hit them.
+void
+ircd::db::warmup(database &d)
+try
+{
+	std::vector<rocksdb::LiveFileMetaData> files;
+	d.d->GetLiveFilesMetaData(&files);
+
+	std::deque<ctx::future<void>> pending;
+	const unwind drain{[&pending]
+	{
+		const ctx::uninterruptible::nothrow ui;
+		for(auto &future : pending)
+			future.wait();
+	}};
+
+	const ircd::timer timer;
+	size_t count(0);
+	for(const auto &file : files)
+	{
+		const auto cfid
+		{
+			d.cfid(std::nothrow, file.column_family_name)
+		};
+
+		if(cfid < 0 || !d.column_index.at(cfid))
+			continue;
+
+		while(pending.size() >= std::max(size_t(open_warmup), 1UL))
+		{
+			pending.front().wait();
+			pending.pop_front();
+		}
+
+		database::column &c(*d.column_index.at(cfid));
+		pending.emplace_back(db::request.async([&d, &c, &file]
+		{
+			const rocksdb::Range range
+			{
+				file.smallestkey, file.largestkey
+			};
+
+			rocksdb::TablePropertiesCollection props;
+			d.d->GetPropertiesOfTablesInRange(c, &range, 1, &props);
+		}));
+
+		++count;
+	}
+
+	while(!pending.empty())
+	{
+		pending.front().wait();
+		pending.pop_front();
+	}
+
+	char tmbuf[48];
+	log::info
+	{
+		log, "[%s] Warmed up %zu of %zu table files in %s",
+		d.name,
+		count,
+		files.size(),
+		pretty(tmbuf, timer.at<microseconds>(), true),
+	};
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "[%s] Table warmup :%s",
+		d.name,
+		e.what(),
+	};
+}
+
 void
 ircd::db::sync(database &d)
 {
@@ -442,6 +579,222 @@ ircd::db::checkpoint(database &d)
 	return seqnum;
 }
 
+/// Writes an incremental backup of this database under the directory
+/// specified, returning the sequence number it was taken at. Table files
+/// are immutable and named uniquely for the life of the database, so each
+/// is copied into `dir/shared/` only once and shared by every backup after.
+/// The rest (manifest, options and write-ahead logs) are copied into
+/// `dir/<sequence>/` along with a SHARED listing of the tables it consists
+/// of; a database is restored by copying both into an empty directory.
+///
+/// Nothing is flushed and no lock is held while copying; the write-ahead
+/// logs carry what is not yet in the tables. File deletions are disabled
+/// for the duration so the listed files remain. This yields the calling
+/// ircd::ctx throughout and is limited by the ircd.db.backup.rate.
+uint64_t
+ircd::db::backup(database &d,
+                 const string_view &dir)
+{
+	fdeletions(d, false);
+	const unwind deletions{[&d]
+	{
+		fdeletions(d, true);
+	}};
+
+	uint64_t msz(0);
+	std::vector<std::string> live;
+	std::vector<std::unique_ptr<rocksdb::LogFile>> logs;
+	const auto seqnum{[&d, &live, &msz, &logs]
+	{
+		const std::lock_guard lock{d.write_mutex};
+		const ctx::uninterruptible::nothrow ui;
+		live = files(d, msz);
+		throw_on_error
+		{
+			d.d->GetSortedWalFiles(logs)
+		};
+
+		return sequence(d);
+	}()};
+
+	const std::string shared_dir
+	{
+		fs::path_string(fs::path_views{dir, "shared"})
+	};
+
+	const std::string private_dir
+	{
+		fs::path_string(fs::path_views{dir, lex_cast(seqnum)})
+	};
+
+	const std::string src_dir
+	{
+		db::path(name(d))
+	};
+
+	fs::mkdir(shared_dir);
+	fs::mkdir(private_dir);
+
+	const ircd::timer timer;
+	size_t copied(0), shared(0);
+	std::string listing;
+	for(const auto &file : live)
+	{
+		const string_view filename
+		{
+			lstrip(file, '/')
+		};
+
+		const std::string src
+		{
+			fs::path_string(fs::path_views{src_dir, filename})
+		};
+
+		const bool is_manifest
+		{
+			startswith(filename, "MANIFEST-")
+		};
+
+		if(endswith(filename, ".sst"))
+		{
+			const std::string dst
+			{
+				fs::path_string(fs::path_views{shared_dir, filename})
+			};
+
+			const size_t size
+			{
+				fs::size(src)
+			};
+
+			if(!fs::exists(dst) || fs::size(dst) != size)
+				copied += backup_copy(src, dst, size);
+			else
+				++shared;
+
+			listing += filename;
+			listing += '\n';
+			continue;
+		}
+
+		const std::string dst
+		{
+			fs::path_string(fs::path_views{private_dir, filename})
+		};
+
+		copied += backup_copy(src, dst, is_manifest? msz : fs::size(src));
+	}
+
+	// The logs are copied up to their size when listed; anything written
+	// after is not part of this backup.
+	for(const auto &log : logs)
+	{
+		if(log->Type() != rocksdb::kAliveLogFile)
+			continue;
+
+		const string_view filename
+		{
+			lstrip(log->PathName(), '/')
+		};
+
+		const std::string src
+		{
+			fs::path_string(fs::path_views{src_dir, filename})
+		};
+
+		const std::string dst
+		{
+			fs::path_string(fs::path_views{private_dir, filename})
+		};
+
+		copied += backup_copy(src, dst, log->SizeFileBytes());
+	}
+
+	const std::string listing_path
+	{
+		fs::path_string(fs::path_views{private_dir, "SHARED"})
+	};
+
+	fs::write(listing_path, const_buffer{listing});
+
+	char pbuf[2][48];
+	log::info
+	{
+		log, "[%s] Backup at sequence %lu in `%s' complete; %zu files, %zu tables already shared, %s copied in %s",
+		name(d),
+		seqnum,
+		private_dir,
+		live.size() + logs.size(),
+		shared,
+		pretty(pbuf[0], iec(copied)),
+		pretty(pbuf[1], timer.at<microseconds>(), true),
+	};
+
+	return seqnum;
+}
+
+size_t
+ircd::db::backup_copy(const string_view &src,
+                      const string_view &dst,
+                      const size_t &size)
+{
+	const std::string tmp
+	{
+		std::string{dst} + ".tmp"
+	};
+
+	const fs::fd in
+	{
+		src, std::ios::in
+	};
+
+	const fs::fd out
+	{
+		tmp, std::ios::out
+	};
+
+	const unique_mutable_buffer buf
+	{
+		size_t(backup_buffer)
+	};
+
+	const ircd::timer timer;
+	size_t off(0);
+	while(off < size)
+	{
+		const mutable_buffer chunk
+		{
+			data(buf), std::min(ircd::size(buf), size - off)
+		};
+
+		const const_buffer read
+		{
+			fs::read(in, chunk, fs::read_opts(off))
+		};
+
+		if(unlikely(empty(read)))
+			break;
+
+		fs::write(out, read, fs::write_opts(off));
+		off += ircd::size(read);
+
+		// Sleep until the average rate of this copy is within the limit.
+		const size_t rate(backup_rate);
+		const auto elapsed(timer.at<milliseconds>());
+		const milliseconds due
+		{
+			rate? long(off * 1000 / rate): 0L
+		};
+
+		if(due > elapsed)
+			ctx::sleep(due - elapsed);
+	}
+
+	fs::sync(out);
+	fs::rename(tmp, dst);
+	return off;
+}
+
 /// This wraps RocksDB's "File Deletions" which means after RocksDB
 /// compresses some file it then destroys the uncompressed version;
 /// setting this to false will disable that and retain both versions.
@@ -565,6 +918,26 @@ ircd::db::file_count(const database &d)
 	});
 }
 
+size_t
+ircd::db::delayed(const database &d)
+{
+	return std::count_if(begin(d.columns), end(d.columns), []
+	(const auto &colptr)
+	{
+		return colptr->stall == rocksdb::WriteStallCondition::kDelayed;
+	});
+}
+
+size_t
+ircd::db::stopped(const database &d)
+{
+	return std::count_if(begin(d.columns), end(d.columns), []
+	(const auto &colptr)
+	{
+		return colptr->stall == rocksdb::WriteStallCondition::kStopped;
+	});
+}
+
 /// Get the list of WAL (Write Ahead Log) files.
 std::vector<std::string>
 ircd::db::wals(const database &cd)
@@ -915,7 +1288,8 @@ try
 		fs::support::rlimit_nofile():
 		-1;
 
-	// MUST be 0 or std::threads are spawned in rocksdb.
+	// MUST be 0 or std::threads are spawned in rocksdb. Tables are opened
+	// concurrently by db::warmup() instead.
 	opts->max_file_opening_threads = 0;
 
 	opts->max_background_jobs = 16;
@@ -1148,11 +1522,18 @@ try
 
 	// Open DB into ptr
 	rocksdb::DB *ptr;
+	const std::string slave_path
+	{
+		slave?
+			fs::path_string(fs::path_views{string_view(open_slave_path), this->name}):
+			std::string{}
+	};
+
 	if(slave)
 		throw_on_error
 		{
 			#ifdef IRCD_DB_HAS_SECONDARY
-			rocksdb::DB::OpenAsSecondary(*opts, path, "/tmp/slave", columns, &handles, &ptr)
+			rocksdb::DB::OpenAsSecondary(*opts, path, slave_path, columns, &handles, &ptr)
 			#else
 			rocksdb::Status::NotSupported(slice("Slave mode not supported by this RocksDB"_sv))
 			#endif
@@ -1277,6 +1658,12 @@ try
 		columns.size(),
 		d->GetLatestSequenceNumber()
 	};
+
+	if(size_t(open_warmup) && !slave)
+		warmup = std::make_unique<context>("db.warmup", 256_KiB, context::POST, [this]
+		{
+			db::warmup(*this);
+		});
 }
 catch(const error &e)
 {
@@ -1322,6 +1709,9 @@ noexcept try
 		path
 	};
 
+	// Interrupts and joins the warmup; it waits for its pending reads.
+	warmup.reset(nullptr);
+
 	if(likely(prefetcher))
 	{
 		const size_t canceled
@@ -1626,6 +2016,11 @@ ircd::db::describe(const database::column &c)
 // database::column
 //
 
+namespace ircd::db
+{
+	static std::vector<rocksdb::DbPath> make_tier_paths(const database &, const descriptor &);
+}
+
 ircd::db::database::column::column(database &d,
                                    db::descriptor &descriptor)
 :rocksdb::ColumnFamilyDescriptor
@@ -1734,6 +2129,11 @@ ircd::db::database::column::column(database &d,
 		ulong(4_MiB)
 	);
 
+	// Arena blocks are rounded up to a multiple of the hugepage size by
+	// RocksDB; a block smaller than one hugepage would waste the remainder.
+	if(size_t(db::memtable_hugetlb) && this->options.arena_block_size >= size_t(db::memtable_hugetlb))
+		this->options.memtable_huge_page_size = size_t(db::memtable_hugetlb);
+
 	// Conf item can be set to disable automatic compactions. For developers
 	// and debugging; good for valgrind.
 	this->options.disable_auto_compactions = !bool(db::auto_compact);
@@ -1818,6 +2218,16 @@ ircd::db::database::column::column(database &d,
 	this->options.periodic_compaction_seconds = this->descriptor->compaction_period.count();
 	#endif
 
+	// Merge operator for op::MERGE deltas.
+	if(this->descriptor->merger)
+		this->options.merge_operator = std::make_shared<struct database::mergeop>(this->d, this->descriptor->merger);
+
+	// Tiered placement of table files.
+	#ifdef IRCD_DB_HAS_CF_PATHS
+	if(!this->descriptor->tier.path.empty())
+		this->options.cf_paths = make_tier_paths(d, *this->descriptor);
+	#endif
+
 	// Compression
 	const auto &[_compression_algos, _compression_opts]
 	{
@@ -1833,6 +2243,16 @@ ircd::db::database::column::column(database &d,
 	if(this->options.compression == rocksdb::kZSTD)
 		this->options.compression_opts.level = -3;
 
+	// Dictionary compression; a dictionary is trained from samples of each
+	// compaction's output and stored with the table file.
+	if(this->options.compression != rocksdb::kNoCompression)
+		this->options.compression_opts.max_dict_bytes = this->descriptor->compression_dict.size;
+
+	#ifdef IRCD_DB_HAS_ZSTD_TRAIN
+	if(this->options.compression == rocksdb::kZSTD && this->options.compression_opts.max_dict_bytes)
+		this->options.compression_opts.zstd_max_train_bytes = this->descriptor->compression_dict.train;
+	#endif
+
 	// Bottommost compression
 	this->options.bottommost_compression = this->options.compression;
 	this->options.bottommost_compression_opts = this->options.compression_opts;
@@ -1849,7 +2269,10 @@ ircd::db::database::column::column(database &d,
 	else
 		table_opts.format_version = 4; // RocksDB >= 5.16.x compat only; otherwise use 3.
 
-	table_opts.index_type = rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+	table_opts.index_type = this->descriptor->meta_block_partition?
+		rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch:
+		rocksdb::BlockBasedTableOptions::kBinarySearch;
+
 	table_opts.read_amp_bytes_per_bit = 8;
 
 	// Delta encoding is always used (option ignored) for table
@@ -1883,9 +2306,9 @@ ircd::db::database::column::column(database &d,
 	// better to use pre-read except in the case of a massive database.
 	table_opts.cache_index_and_filter_blocks = true;
 	table_opts.cache_index_and_filter_blocks_with_high_priority = true;
-	table_opts.pin_top_level_index_and_filter = false;
+	table_opts.pin_top_level_index_and_filter = this->descriptor->meta_block_pin;
 	table_opts.pin_l0_filter_and_index_blocks_in_cache = false;
-	table_opts.partition_filters = true;
+	table_opts.partition_filters = this->descriptor->meta_block_partition;
 
 	// Setup the cache for assets.
 	const auto &cache_size(this->descriptor->cache_size);
@@ -1907,6 +2330,11 @@ ircd::db::database::column::column(database &d,
 
 	// Setup the bloom filter.
 	const auto &bloom_bits(this->descriptor->bloom_bits);
+	#ifdef IRCD_DB_HAS_RIBBON
+	if(bloom_bits && this->descriptor->bloom_ribbon)
+		table_opts.filter_policy.reset(rocksdb::NewRibbonFilterPolicy(bloom_bits));
+	else
+	#endif
 	if(bloom_bits)
 		table_opts.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloom_bits, false));
 
@@ -1937,6 +2365,89 @@ noexcept
 {
 }
 
+/// Generate the cf_paths for a tiered column. The first path is the
+/// database directory holding the hot tier and the second is the bulk tier
+/// given by the descriptor. When the descriptor leaves the size of the hot
+/// tier unspecified it is an eighth of the device holding the database; if
+/// that device is itself rotational the column is not tiered.
+std::vector<rocksdb::DbPath>
+ircd::db::make_tier_paths(const database &d,
+                          const descriptor &desc)
+{
+	const std::string cold_path
+	{
+		fs::is_relative(desc.tier.path)?
+			fs::path_string(fs::path_views{d.path, desc.tier.path}):
+			desc.tier.path
+	};
+
+	size_t hot_size
+	{
+		desc.tier.size
+	};
+
+	if(!hot_size) try
+	{
+		const fs::fd fd
+		{
+			d.path, std::ios::in
+		};
+
+		const fs::dev::blk blk
+		{
+			fs::device(fd)
+		};
+
+		if(blk.rotational)
+		{
+			log::warning
+			{
+				log, "[%s] '%s' database directory is on a rotational device; not tiering to `%s'",
+				d.name,
+				desc.name,
+				cold_path,
+			};
+
+			return {};
+		}
+
+		hot_size = blk.sectors * fs::dev::blk::SECTOR_SIZE / 8;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "[%s] '%s' cannot determine hot tier size for `%s' :%s",
+			d.name,
+			desc.name,
+			d.path,
+			e.what(),
+		};
+
+		return {};
+	}
+
+	if(!ircd::write_avoid && !fs::is_dir(cold_path))
+		fs::mkdir(cold_path);
+
+	char pbuf[48];
+	log::info
+	{
+		log, "[%s] '%s' tiered storage %s in `%s' then `%s'",
+		d.name,
+		desc.name,
+		pretty(pbuf, iec(hot_size)),
+		d.path,
+		cold_path,
+	};
+
+	return std::vector<rocksdb::DbPath>
+	{
+		{ d.path,    hot_size                              },
+		{ cold_path, std::numeric_limits<uint64_t>::max()  },
+	};
+}
+
 ircd::db::database::column::operator
 database &()
 {
@@ -2136,6 +2647,50 @@ noexcept
 {
 }
 
+//
+// snapshot::pin
+//
+
+template<>
+decltype(ircd::util::instance_list<ircd::db::database::snapshot::pin>::allocator)
+ircd::util::instance_list<ircd::db::database::snapshot::pin>::allocator
+{};
+
+template<>
+decltype(ircd::util::instance_list<ircd::db::database::snapshot::pin>::list)
+ircd::util::instance_list<ircd::db::database::snapshot::pin>::list
+{
+	allocator
+};
+
+ircd::db::database::snapshot::pin::pin(database &d)
+:d{&d}
+,c{ctx::current}
+,s{d}
+{
+}
+
+ircd::db::database::snapshot::pin::~pin()
+noexcept
+{
+}
+
+const rocksdb::Snapshot *
+ircd::db::database::snapshot::pin::get(const database &d)
+noexcept
+{
+	// Pins are few and short-lived; nothing to search most of the time.
+	if(likely(list.empty()))
+		return nullptr;
+
+	// The most recent pin of the context takes precedence.
+	for(auto it(rbegin(list)); it != rend(list); ++it)
+		if((*it)->c == ctx::current && (*it)->d == &d)
+			return (*it)->s;
+
+	return nullptr;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // database::logger
@@ -2358,6 +2913,16 @@ ircd::db::database::stats::stats(database *const &d,
 	{ "name", make_name("multiget.referenced")                          },
 	{ "desc", "Number of DB::MultiGet() results adhering to zero-copy." },
 }
+,get_latency
+{
+	{ "name",    "ircd.db.get.latency"                                  },
+	{ "desc",    "Duration of DB::Get() for each column."               },
+	{ "labels",  json::members
+	{
+		{ "database",  string_view{db::name(*d)}                        },
+		{ "column",    c? string_view{db::name(*c)}: "db"_sv            },
+	}},
+}
 {
 	assert(item.size() == ticker.size());
 	for(size_t i(0); i < item.size(); ++i)
@@ -3495,6 +4060,37 @@ noexcept
 		while(++i < prio);
 	}
 
+	// Compaction IO is paced to the rate set by the compaction scheduler;
+	// the default rate is unlimited. Flushes and other IO are not paced.
+	if(prio == IOPriority::IO_LOW && bytes_per_second < int64_t(1_GiB) && ctx::current)
+	{
+		const auto now
+		{
+			ircd::now<steady_point>()
+		};
+
+		const nanoseconds cost
+		{
+			int64_t(bytes) * 1000000000L / std::max(bytes_per_second, 1L)
+		};
+
+		const auto start
+		{
+			std::max(next, now)
+		};
+
+		next = start + cost;
+		if(start > now) try
+		{
+			const ctx::uninterruptible::nothrow ui;
+			ctx::sleep(std::min(duration_cast<milliseconds>(start - now), milliseconds(1000)));
+		}
+		catch(...)
+		{
+			// The job is unwound at its next opportunity; not from within.
+		}
+	}
+
 	//assert(stats);
 	//stats->recordTick(rocksdb::Tickers::RATE_LIMIT_DELAY_MILLIS, 0);
 	//stats->recordTick(rocksdb::Tickers::NUMBER_RATE_LIMITER_DRAINS, 0);
@@ -3553,6 +4149,317 @@ noexcept
 	return false;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// db/compaction.h
+//
+
+namespace ircd::db::compaction
+{
+	static bool offpeak();
+	static void handle(database &, const bool &offpeak);
+	static void worker();
+
+	extern std::unique_ptr<ctx::context> context;
+	extern std::set<std::string, std::less<>> suspended;
+	extern std::map<const database *, std::pair<uint64_t, nanoseconds>> observed;
+	extern conf::item<bool> enable;
+	extern conf::item<std::string> window;
+	extern conf::item<std::string> lazy;
+	extern conf::item<size_t> lazy_pending_max;
+	extern conf::item<size_t> rate_max;
+	extern conf::item<size_t> rate_min;
+	extern conf::item<microseconds> latency_target;
+	extern conf::item<seconds> interval;
+}
+
+decltype(ircd::db::compaction::enable)
+ircd::db::compaction::enable
+{
+	{ "name",     "ircd.db.compact.sched.enable" },
+	{ "default",  true                           },
+};
+
+decltype(ircd::db::compaction::window)
+ircd::db::compaction::window
+{
+	{ "name",     "ircd.db.compact.sched.window" },
+	{ "default",  "1-6"                          },
+	{ "description",
+
+	R"(
+	Off-peak window of local time in hours as "start-stop" (i.e. "22-6"),
+	during which compaction is neither paced nor suspended. An empty value
+	has no off-peak window.
+	)"},
+};
+
+decltype(ircd::db::compaction::lazy)
+ircd::db::compaction::lazy
+{
+	{ "name",     "ircd.db.compact.sched.lazy" },
+	{ "default",  "_event_json"                },
+	{ "description",
+
+	R"(
+	Space separated names of columns for which automatic compaction is
+	suspended outside of the off-peak window. Other columns are compacted
+	as soon as rocksdb schedules it (subject to the pacing of all compaction
+	IO). A lazy column is compacted anyway when its pending compaction bytes
+	exceed ircd.db.compact.sched.lazy.pending_max.
+	)"},
+};
+
+decltype(ircd::db::compaction::lazy_pending_max)
+ircd::db::compaction::lazy_pending_max
+{
+	{ "name",     "ircd.db.compact.sched.lazy.pending_max" },
+	{ "default",  long(16_GiB)                             },
+};
+
+decltype(ircd::db::compaction::rate_max)
+ircd::db::compaction::rate_max
+{
+	{ "name",     "ircd.db.compact.sched.rate.max" },
+	{ "default",  long(256_MiB)                    },
+	{ "description",
+
+	R"(
+	Bytes per second of compaction IO permitted outside of the off-peak
+	window while foreground reads are meeting the latency target.
+	)"},
+};
+
+decltype(ircd::db::compaction::rate_min)
+ircd::db::compaction::rate_min
+{
+	{ "name",     "ircd.db.compact.sched.rate.min" },
+	{ "default",  long(8_MiB)                      },
+};
+
+decltype(ircd::db::compaction::latency_target)
+ircd::db::compaction::latency_target
+{
+	{ "name",     "ircd.db.compact.sched.latency.target" },
+	{ "default",  2000L                                  },
+	{ "description",
+
+	R"(
+	Microseconds of mean foreground read latency above which compaction IO
+	outside the off-peak window is slowed down; it recovers gradually while
+	the latency is below.
+	)"},
+};
+
+decltype(ircd::db::compaction::interval)
+ircd::db::compaction::interval
+{
+	{ "name",     "ircd.db.compact.sched.interval" },
+	{ "default",  15L                              },
+};
+
+decltype(ircd::db::compaction::context)
+ircd::db::compaction::context;
+
+decltype(ircd::db::compaction::suspended)
+ircd::db::compaction::suspended;
+
+decltype(ircd::db::compaction::observed)
+ircd::db::compaction::observed;
+
+void
+ircd::db::compaction::init()
+{
+	if(!enable)
+		return;
+
+	context = std::make_unique<ctx::context>
+	(
+		"db.compact.sched",
+		256_KiB,
+		&worker,
+		ctx::context::POST
+	);
+}
+
+void
+ircd::db::compaction::fini()
+noexcept
+{
+	context.reset(nullptr);
+}
+
+void
+ircd::db::compaction::worker()
+try
+{
+	while(1)
+	{
+		ctx::sleep(seconds(interval));
+		if(!db::auto_compact)
+			continue;
+
+		const bool offpeak
+		{
+			compaction::offpeak()
+		};
+
+		for(auto *const &d : database::list)
+			if(likely(!d->slave && !d->read_only))
+				handle(*d, offpeak);
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const ctx::terminated &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Compaction scheduler :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::db::compaction::handle(database &d,
+                             const bool &offpeak)
+{
+	assert(d.rate_limiter);
+	auto &limiter(*d.rate_limiter);
+
+	// Mean latency of foreground reads since the last interval.
+	uint64_t total_count(0);
+	nanoseconds total_sum(0ns);
+	for(const auto &c : d.columns)
+	{
+		total_count += c->stats->get_latency.count;
+		total_sum += c->stats->get_latency.sum;
+	}
+
+	auto &[count, sum](observed[&d]);
+	const uint64_t reads(total_count - std::min(count, total_count));
+	const nanoseconds elapsed(total_sum - std::min(sum, total_sum));
+	count = total_count;
+	sum = total_sum;
+
+	const bool slow
+	{
+		reads >= 64 &&
+		elapsed / reads > microseconds(latency_target)
+	};
+
+	// Off-peak is unlimited. Otherwise multiplicative decrease while the
+	// reads are slow and additive increase while they aren't.
+	const int64_t rate
+	{
+		offpeak?
+			int64_t(1_GiB):
+		slow?
+			std::max(std::min(limiter.bytes_per_second, int64_t(rate_max)) / 2, int64_t(rate_min)):
+			std::min(std::min(limiter.bytes_per_second, int64_t(rate_max)) + int64_t(rate_max) / 8, int64_t(rate_max))
+	};
+
+	if(rate != limiter.bytes_per_second)
+		limiter.SetBytesPerSecond(rate);
+
+	const string_view &lazy_columns
+	{
+		lazy
+	};
+
+	for(const auto &c : d.columns) try
+	{
+		assert(c);
+		const auto &colname(db::name(*c));
+		if(!token_exists(lazy_columns, ' ', colname))
+			continue;
+
+		db::column column(*c);
+		const auto pending
+		{
+			property<prop_int>(column, "rocksdb.estimate-pending-compaction-bytes")
+		};
+
+		const bool suspend
+		{
+			!offpeak && pending < size_t(lazy_pending_max)
+		};
+
+		const auto key
+		{
+			fmt::snstringf
+			{
+				256, "%s:%s", db::name(d), colname
+			}
+		};
+
+		const auto it(suspended.find(key));
+		if(suspend == (it != end(suspended)))
+			continue;
+
+		setopt(column, "disable_auto_compactions", suspend? "true": "false");
+		if(suspend)
+			suspended.emplace(key);
+		else
+			suspended.erase(it);
+
+		char pbuf[48];
+		log::info
+		{
+			log, "[%s] '%s' automatic compaction %s; pending %s",
+			db::name(d),
+			colname,
+			suspend? "suspended"_sv: "resumed"_sv,
+			pretty(pbuf, iec(pending)),
+		};
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "[%s] '%s' compaction scheduling :%s",
+			db::name(d),
+			db::name(*c),
+			e.what(),
+		};
+	}
+}
+
+bool
+ircd::db::compaction::offpeak()
+{
+	const string_view &hours
+	{
+		window
+	};
+
+	if(!hours)
+		return false;
+
+	const auto &[start_, stop_]
+	{
+		split(hours, '-')
+	};
+
+	const auto start(lex_cast<uint>(start_) % 24);
+	const auto stop(lex_cast<uint>(stop_) % 24);
+
+	struct tm lt;
+	const time_t now(std::time(nullptr));
+	localtime_r(&now, &lt);
+	const uint hour(lt.tm_hour);
+
+	return start <= stop?
+		hour >= start && hour < stop:
+		hour >= start || hour < stop;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // database::sst
@@ -3224,6 +3224,66 @@ ircd::db::database::env::random_access_file::default_opts{[]
 	return ret;
 }()};
 
+decltype(ircd::db::database::env::random_access_file::mmap_enable)
+ircd::db::database::env::random_access_file::mmap_enable
+{
+	{ "name",     "ircd.db.env.mmap.enable" },
+	{ "default",  false                     },
+	{ "description",
+
+	R"(
+	Serve reads of large table files from a memory map of the file rather
+	than reading into RocksDB's scratch buffers. The result points directly
+	into the page cache. This is only sensible when the files fit in RAM;
+	a page fault stalls the whole thread. Applies to files opened after the
+	item is set.
+	)"},
+};
+
+decltype(ircd::db::database::env::random_access_file::mmap_min)
+ircd::db::database::env::random_access_file::mmap_min
+{
+	{ "name",     "ircd.db.env.mmap.min" },
+	{ "default",  long(64_MiB)           },
+	{ "description",
+
+	R"(
+	Minimum size of a table file to be memory mapped when mmap is enabled.
+	The largest files are those in the bottom level which are immutable
+	until compacted away; smaller files are churned by compaction.
+	)"},
+};
+
+decltype(ircd::db::database::env::random_access_file::mmap_populate)
+ircd::db::database::env::random_access_file::mmap_populate
+{
+	{ "name",     "ircd.db.env.mmap.populate" },
+	{ "default",  false                       },
+	{ "description",
+
+	R"(
+	Fault the whole file into memory when it is mapped, moving the cost of
+	page faults to the opening of the file.
+	)"},
+};
+
+bool
+ircd::db::database::env::random_access_file::mmap_eligible(const std::string &name)
+noexcept try
+{
+	if(!bool(mmap_enable))
+		return false;
+
+	if(!endswith(name, ".sst"))
+		return false;
+
+	return fs::size(name) >= size_t(mmap_min);
+}
+catch(const std::exception &e)
+{
+	return false;
+}
+
 ircd::db::database::env::random_access_file::random_access_file(database *const &d,
                                                                 const std::string &name,
                                                                 const EnvOptions &env_opts)
@@ -3232,16 +3292,27 @@ try
 {
 	*d
 }
-,opts{[&env_opts]
+,opts{[&env_opts, &name]
 {
+	// Direct IO is incompatible with the map, which reads through the page
+	// cache by nature.
 	fs::fd::opts ret{default_opts};
-	ret.direct = env_opts.use_direct_reads;
+	ret.direct = env_opts.use_direct_reads && !mmap_eligible(name);
 	return ret;
 }()}
 ,fd
 {
 	name, this->opts
 }
+,map{[this, &name]
+{
+	if(this->opts.direct || !mmap_eligible(name))
+		return fs::map{};
+
+	fs::map::opts ret{this->opts};
+	ret.populate = bool(mmap_populate);
+	return fs::map{fd, ret};
+}()}
 ,_buffer_align
 {
 	opts.direct?
@@ -3319,7 +3390,10 @@ noexcept try
 	// Note RocksDB does not call our prefetch() when using direct IO.
 	assert(!this->opts.direct);
 
-	fs::prefetch(fd, length, offset);
+	if(!empty(map) && offset < size(map))
+		fs::prefetch(map, std::min(length, size(map) - offset), fs::opts(offset));
+	else if(empty(map))
+		fs::prefetch(fd, length, offset);
 	return Status::OK();
 }
 catch(const std::system_error &e)
@@ -3350,6 +3424,14 @@ noexcept try
 	assert(req);
 	const ctx::uninterruptible::nothrow ui;
 
+	if(!empty(map))
+	{
+		for(size_t i(0); i < num; ++i)
+			req[i].status = Read(req[i].offset, req[i].len, &req[i].result, req[i].scratch);
+
+		return Status::OK();
+	}
+
 	fs::read_op op[num];
 	mutable_buffer buf[num];
 	fs::read_opts opts[num];
@@ -3483,6 +3565,22 @@ const noexcept try
 	};
 	#endif
 
+	// Mapped files return a view of the map; scratch is not used.
+	if(!empty(map))
+	{
+		const size_t pos
+		{
+			std::min(size_t(offset), size(map))
+		};
+
+		*result = slice(const_buffer
+		{
+			data(map) + pos, std::min(length, size(map) - pos)
+		});
+
+		return Status::OK();
+	}
+
 	fs::read_opts opts;
 	opts.offset = offset;
 	opts.priority = ionice;
@@ -3493,12 +3591,27 @@ const noexcept try
 		scratch, length
 	};
 
+	if(this->opts.direct && size_t(readahead::size))
+	{
+		if(unlikely(!ra))
+			ra = std::make_unique<readahead>(mutable_cast(*this));
+
+		if(const auto read{ra->take(offset, buf)}; !empty(read))
+		{
+			*result = slice(read);
+			return Status::OK();
+		}
+	}
+
 	assert(!this->opts.direct || buffer::aligned(buf, _buffer_align));
 	const auto read
 	{
 		fs::read(fd, buf, opts)
 	};
 
+	if(ra)
+		ra->observe(offset, size(read));
+
 	*result = slice(read);
 	return Status::OK();
 }
@@ -3616,6 +3729,32 @@ noexcept
 		reflect(pattern)
 	};
 	#endif
+
+	#if defined(HAVE_POSIX_MADVISE)
+	if(!empty(map)) try
+	{
+		const int advice
+		{
+			pattern == AccessPattern::RANDOM?      POSIX_MADV_RANDOM:
+			pattern == AccessPattern::SEQUENTIAL?  POSIX_MADV_SEQUENTIAL:
+			pattern == AccessPattern::WILLNEED?    POSIX_MADV_WILLNEED:
+			                                       POSIX_MADV_NORMAL
+		};
+
+		fs::advise(map, advice, size(map));
+	}
+	catch(const std::exception &e)
+	{
+		log::derror
+		{
+			log, "[%s] rfile:%p hint %s :%s",
+			d.name,
+			this,
+			reflect(pattern),
+			e.what(),
+		};
+	}
+	#endif
 }
 
 bool
@@ -3637,6 +3776,389 @@ const noexcept
 	return ret;
 }
 
+//
+// random_access_file::readahead
+//
+
+decltype(ircd::db::database::env::random_access_file::readahead::size)
+ircd::db::database::env::random_access_file::readahead::size
+{
+	{ "name",     "ircd.db.env.readahead.size" },
+	{ "default",  long(256_KiB)                },
+	{ "description",
+
+	R"(
+	Maximum bytes of each asynchronous readahead window for sequential direct
+	reads of table files (i.e. iterator range scans). Two windows are kept for
+	each file being scanned. Zero disables.
+	)"},
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead::min)
+ircd::db::database::env::random_access_file::readahead::min
+{
+	{ "name",     "ircd.db.env.readahead.min" },
+	{ "default",  long(32_KiB)                },
+	{ "description",
+
+	R"(
+	Minimum bytes of each readahead window. Windows start at this length and
+	grow toward ircd.db.env.readahead.size while they are consumed entirely;
+	they shrink back when they go unused.
+	)"},
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead::trigger)
+ircd::db::database::env::random_access_file::readahead::trigger
+{
+	{ "name",     "ircd.db.env.readahead.trigger" },
+	{ "default",  2L                              },
+	{ "description",
+
+	R"(
+	Number of consecutive sequential reads of a file before readahead starts.
+	)"},
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead::hits)
+ircd::db::database::env::random_access_file::readahead::hits
+{
+	{ "name", "ircd.db.env.readahead.hits" },
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead::misses)
+ircd::db::database::env::random_access_file::readahead::misses
+{
+	{ "name", "ircd.db.env.readahead.misses" },
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead::launches)
+ircd::db::database::env::random_access_file::readahead::launches
+{
+	{ "name", "ircd.db.env.readahead.launches" },
+};
+
+decltype(ircd::db::database::env::random_access_file::readahead::wasted)
+ircd::db::database::env::random_access_file::readahead::wasted
+{
+	{ "name", "ircd.db.env.readahead.wasted" },
+};
+
+ircd::db::database::env::random_access_file::readahead::readahead(random_access_file &file)
+:file{file}
+{
+}
+
+ircd::db::database::env::random_access_file::readahead::~readahead()
+noexcept
+{
+	// The workers write into the windows; they must finish first.
+	const ctx::uninterruptible::nothrow ui;
+	for(auto &w : win)
+	{
+		if(w.pending.valid()) try
+		{
+			w.valid = const_buffer
+			{
+				data(w.buf), w.pending.get()
+			};
+		}
+		catch(const std::exception &)
+		{
+			w.valid = {};
+		}
+
+		w.pending = ctx::future<size_t>{};
+		retire(w);
+	}
+}
+
+/// Copies the read from a window covering it, waiting for the window to
+/// complete if it's in flight. Returns an empty buffer if no window covers
+/// the read; the caller reads from the device instead.
+ircd::const_buffer
+ircd::db::database::env::random_access_file::readahead::take(const uint64_t &offset,
+                                                           const mutable_buffer &buf)
+noexcept
+{
+	const auto it
+	{
+		std::find_if(begin(win), end(win), [&offset, &buf]
+		(const auto &w)
+		{
+			return w.covers(offset, ircd::size(buf));
+		})
+	};
+
+	if(it == end(win))
+		return {};
+
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	auto &w(*it);
+	if(w.pending.valid())
+	{
+		size_t got(0); try
+		{
+			got = w.pending.get();
+		}
+		catch(const std::exception &)
+		{
+			got = 0;
+		}
+
+		w.pending = ctx::future<size_t>{};
+		w.valid = const_buffer
+		{
+			data(w.buf), got
+		};
+	}
+
+	// The window may have been replaced or come up short while waiting.
+	if(!w.covers(offset, ircd::size(buf)))
+	{
+		++misses;
+		return {};
+	}
+
+	const size_t copied
+	{
+		copy(buf, w.valid + (offset - w.offset))
+	};
+
+	assert(copied == ircd::size(buf));
+	w.used += copied;
+	++hits;
+
+	advance(offset, copied);
+	ahead();
+	return const_buffer
+	{
+		data(buf), copied
+	};
+}
+
+/// Observes a read from the device; starts readahead when the reads have
+/// become sequential.
+void
+ircd::db::database::env::random_access_file::readahead::observe(const uint64_t &offset,
+                                                              const size_t &length)
+noexcept
+{
+	advance(offset, length);
+	ahead();
+}
+
+void
+ircd::db::database::env::random_access_file::readahead::advance(const uint64_t &offset,
+                                                              const size_t &length)
+noexcept
+{
+	run =
+		offset == tail?
+			std::max(run, 0) + 1:
+
+		offset + length == head?
+			std::min(run, 0) - 1:
+
+		0;
+
+	head = offset;
+	tail = offset + length;
+}
+
+/// Keeps a window in flight or completed beyond the last read in the
+/// direction of the scan. When a window already covers what the scan wants
+/// next the window beyond that is launched into the other.
+void
+ircd::db::database::env::random_access_file::readahead::ahead()
+noexcept
+{
+	if(uint32_t(std::abs(run)) < size_t(trigger))
+		return;
+
+	const bool forward
+	{
+		run > 0
+	};
+
+	if(!forward && head == 0)
+		return;
+
+	const uint64_t want
+	{
+		forward? tail: head - 1
+	};
+
+	const auto it
+	{
+		std::find_if(begin(win), end(win), [&want](const auto &w)
+		{
+			return w.covers(want, 1);
+		})
+	};
+
+	if(it == end(win))
+	{
+		for(auto &w : win)
+			if(!w.pending.valid())
+				if(launch(w, forward, forward? tail: head))
+					break;
+
+		return;
+	}
+
+	// Nothing can be said about the window beyond until this one completes;
+	// a short forward window means the end of the file was reached.
+	auto &w(*it);
+	auto &other(win[it == begin(win)]);
+	if(w.pending.valid() || other.pending.valid())
+		return;
+
+	if(forward && ircd::size(w.valid) < w.span)
+		return;
+
+	if(!forward && w.offset == 0)
+		return;
+
+	const uint64_t from
+	{
+		forward? w.offset + ircd::size(w.valid): w.offset
+	};
+
+	if(!other.covers(forward? from: from - 1, 1))
+		launch(other, forward, from);
+}
+
+/// Reads the window following (forward) or preceding (!forward) the offset
+/// `from` in a worker. The window it replaces is retired first.
+bool
+ircd::db::database::env::random_access_file::readahead::launch(window &w,
+                                                             const bool &forward,
+                                                             const uint64_t &from)
+noexcept try
+{
+	assert(!w.pending.valid());
+	const auto &align
+	{
+		file._buffer_align
+	};
+
+	if(from % align != 0)
+		return false;
+
+	// Don't make the scanning context wait for a worker to read ahead for it.
+	if(db::request.wouldblock())
+		return false;
+
+	retire(w);
+	const size_t max
+	{
+		pad_to(size_t(size), align)
+	};
+
+	length = pad_to(std::clamp(length, std::min(pad_to(size_t(min), align), max), max), align);
+	if(ircd::size(w.buf) < length)
+		w.buf = unique_mutable_buffer
+		{
+			length, align
+		};
+
+	w.offset = forward? from: from - std::min(from, uint64_t(length));
+	w.span = forward? length: from - w.offset;
+	w.valid = {};
+	w.used = 0;
+	w.pending = db::request.async([this, &w]
+	() -> size_t
+	{
+		fs::read_opts opts;
+		opts.offset = w.offset;
+		opts.priority = file.ionice;
+		opts.aio = file.aio;
+		opts.all = false;
+		const mutable_buffer buf
+		{
+			data(w.buf), w.span
+		};
+
+		try
+		{
+			return ircd::size(fs::read(file.fd, buf, opts));
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &)
+		{
+			return 0UL;
+		}
+	});
+
+	++launches;
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "[%s] rfile:%p readahead from:%zu :%s",
+		file.d.name,
+		&file,
+		from,
+		e.what(),
+	};
+
+	return false;
+}
+
+/// Accounts for a completed window before it's replaced. The length of the
+/// next window doubles if this one was consumed entirely and halves if most
+/// of it went unused.
+void
+ircd::db::database::env::random_access_file::readahead::retire(window &w)
+noexcept
+{
+	assert(!w.pending.valid());
+	const size_t valid
+	{
+		ircd::size(w.valid)
+	};
+
+	if(!valid)
+		return;
+
+	const size_t unused
+	{
+		valid - std::min(w.used, valid)
+	};
+
+	wasted += unused;
+	if(!unused)
+		length *= 2;
+	else if(unused > valid / 2)
+		length /= 2;
+
+	w.valid = {};
+	w.used = 0;
+}
+
+bool
+ircd::db::database::env::random_access_file::readahead::window::covers(const uint64_t &offset,
+                                                                     const size_t &length)
+const noexcept
+{
+	const size_t extent
+	{
+		pending.valid()? span: ircd::size(valid)
+	};
+
+	return offset >= this->offset && offset + length <= this->offset + extent;
+}
+
 //
 // random_rw_file
 //
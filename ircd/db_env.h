@@ -123,17 +123,26 @@ struct [[gnu::visibility("hidden")]]
 ircd::db::database::env::random_access_file final
 :rocksdb::RandomAccessFile
 {
+	struct readahead;
+
 	using Status = rocksdb::Status;
 	using Slice = rocksdb::Slice;
 
 	static const fs::fd::opts default_opts;
+	static conf::item<bool> mmap_enable;
+	static conf::item<size_t> mmap_min;
+	static conf::item<bool> mmap_populate;
+
+	static bool mmap_eligible(const std::string &name) noexcept;
 
 	database &d;
 	fs::fd::opts opts;
 	fs::fd fd;
+	fs::map map;                       // only when reads are served from mmap
 	size_t _buffer_align;
 	int8_t ionice {0};
 	bool aio;
+	mutable std::unique_ptr<readahead> ra;
 
 	bool use_direct_io() const noexcept override;
 	size_t GetRequiredBufferAlignment() const noexcept override;
@@ -150,6 +159,63 @@ ircd::db::database::env::random_access_file final
 	~random_access_file() noexcept;
 };
 
+/// Asynchronous readahead for direct reads. RocksDB only calls Prefetch()
+/// without direct IO; with direct IO an iterator crossing into a new block
+/// reads it synchronously. When the reads of a file are observed to be
+/// sequential the next window is read by a db::request worker while the
+/// caller processes what it has; reads covered by a window are copied from
+/// it instead of going to the device. Two windows alternate so the one ahead
+/// is in flight while the current one is consumed. Window buffers are only
+/// allocated once the file is scanned.
+///
+/// Descending scans (i.e. backward pagination) are followed by windows
+/// preceding the reads. The window length adapts to the scan: it doubles
+/// each time a window is consumed entirely and halves each time most of a
+/// window goes unused.
+struct [[gnu::visibility("hidden")]]
+ircd::db::database::env::random_access_file::readahead
+{
+	struct window
+	{
+		uint64_t offset {0};
+		size_t span {0};                   // bytes requested into buf
+		size_t used {0};                   // bytes copied out of valid
+		unique_mutable_buffer buf;         // window
+		const_buffer valid;                // completed portion of the window
+		ctx::future<size_t> pending;       // read in flight into buf
+
+		bool covers(const uint64_t &offset, const size_t &length) const noexcept;
+	};
+
+	static conf::item<size_t> size;
+	static conf::item<size_t> min;
+	static conf::item<size_t> trigger;
+	static stats::item<uint64_t> hits;
+	static stats::item<uint64_t> misses;
+	static stats::item<uint64_t> launches;
+	static stats::item<uint64_t> wasted;
+
+	random_access_file &file;
+	uint64_t head {0};                 // offset of the last read
+	uint64_t tail {0};                 // offset following the last read
+	int32_t run {0};                   // consecutive sequential reads; <0 descending
+	size_t length {0};                 // length of the next window
+	ctx::mutex mutex;
+	std::array<window, 2> win;
+
+	void retire(window &) noexcept;
+	bool launch(window &, const bool &forward, const uint64_t &from) noexcept;
+	void ahead() noexcept;
+	void advance(const uint64_t &offset, const size_t &length) noexcept;
+	const_buffer take(const uint64_t &offset, const mutable_buffer &) noexcept;
+	void observe(const uint64_t &offset, const size_t &length) noexcept;
+
+	readahead(random_access_file &);
+	readahead(readahead &&) = delete;
+	readahead(const readahead &) = delete;
+	~readahead() noexcept;
+};
+
 struct [[gnu::visibility("hidden")]]
 ircd::db::database::env::random_rw_file final
 :rocksdb::RandomRWFile
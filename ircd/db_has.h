@@ -8,6 +8,16 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#if ROCKSDB_MAJOR > 5 \
+|| (ROCKSDB_MAJOR == 5 && ROCKSDB_MINOR >= 11)
+	#define IRCD_DB_HAS_ZSTD_TRAIN
+#endif
+
+#if ROCKSDB_MAJOR > 5 \
+|| (ROCKSDB_MAJOR == 5 && ROCKSDB_MINOR >= 14)
+	#define IRCD_DB_HAS_CF_PATHS
+#endif
+
 #if ROCKSDB_MAJOR > 5 \
 || (ROCKSDB_MAJOR == 5 && ROCKSDB_MINOR >= 18)
 	#define IRCD_DB_HAS_ALLOCATOR
@@ -72,3 +82,8 @@
 || (ROCKSDB_MAJOR == 6 && ROCKSDB_MINOR == 10 && ROCKSDB_PATCH >= 0)
 	#define IRCD_DB_HAS_MULTIGET_DIRECT
 #endif
+
+#if ROCKSDB_MAJOR > 6 \
+|| (ROCKSDB_MAJOR == 6 && ROCKSDB_MINOR >= 20)
+	#define IRCD_DB_HAS_RIBBON
+#endif
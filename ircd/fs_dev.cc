@@ -201,6 +201,11 @@ ircd::fs::dev::blk::blk(const ulong &id)
 {
 	!sysfs<bool>(id, "queue/nomerges", true)
 }
+,numa_node
+{
+	// Partitions and namespaces report the node of their controller.
+	sysfs<int>(id, "device/numa_node", sysfs<int>(id, "device/device/numa_node", -1))
+}
 {
 }
 
@@ -19,6 +19,10 @@ __attribute__((visibility("hidden")))
 	extern const std::unordered_map<ircd::http::code, ircd::string_view> reason;
 
 	[[noreturn]] void throw_error(const qi::expectation_failure<const char *> &, const bool &internal = false);
+
+	template<class block_t> static u64x2 line_block(const block_t, const block_t) noexcept;
+	static bool line_scan(const char *&start, const char *const &stop, string_view &ret) noexcept;
+	static bool header_split(const string_view &line, header &ret) noexcept;
 }}
 
 BOOST_FUSION_ADAPT_STRUCT
@@ -389,49 +393,73 @@ void
 ircd::http::assign(request::head &head,
                    const header &header)
 {
-	char buf[64];
-	const auto &[key_, val] {header};
-	assert(size(key_) <= sizeof(buf));
-	const auto &key
-	{
-		tolower(buf, key_)
-	};
-
-	if(key == "content-length"_sv)
-		head.content_length = parser.content_length(val);
-
-	else if(key == "host"_sv)
-		head.host = val;
-
-	else if(key == "expect"_sv)
-		head.expect = val;
-
-	else if(key == "te"_sv)
-		head.te = val;
-
-	else if(key == "authorization"_sv)
-		head.authorization = val;
-
-	else if(key == "connection"_sv)
-		head.connection = val;
-
-	else if(key == "content-type"_sv)
-		head.content_type = val;
-
-	else if(key == "user-agent"_sv)
-		head.user_agent = val;
-
-	else if(key == "upgrade"_sv)
-		head.upgrade = val;
-
-	else if(key == "range"_sv)
-		head.range = val;
-
-	else if(key == "if-range"_sv)
-		head.if_range = val;
-
-	else if(key == "x-forwarded-for"_sv)
-		head.forwarded_for = val;
+	const auto &[key, val] {header};
+
+	// Dispatch on the length first so each header is compared against at
+	// most a few names without a lowercase copy.
+	switch(size(key))
+	{
+		case 2:
+			if(iequals(key, "te"_sv))
+				head.te = val;
+			break;
+
+		case 4:
+			if(iequals(key, "host"_sv))
+				head.host = val;
+			break;
+
+		case 5:
+			if(iequals(key, "range"_sv))
+				head.range = val;
+			break;
+
+		case 6:
+			if(iequals(key, "expect"_sv))
+				head.expect = val;
+			break;
+
+		case 7:
+			if(iequals(key, "upgrade"_sv))
+				head.upgrade = val;
+			break;
+
+		case 8:
+			if(iequals(key, "if-range"_sv))
+				head.if_range = val;
+			break;
+
+		case 10:
+			if(iequals(key, "connection"_sv))
+				head.connection = val;
+			else if(iequals(key, "user-agent"_sv))
+				head.user_agent = val;
+			break;
+
+		case 12:
+			if(iequals(key, "content-type"_sv))
+				head.content_type = val;
+			break;
+
+		case 13:
+			if(iequals(key, "authorization"_sv))
+				head.authorization = val;
+			else if(iequals(key, "if-none-match"_sv))
+				head.if_none_match = val;
+			break;
+
+		case 14:
+			if(iequals(key, "content-length"_sv))
+				head.content_length = parser.content_length(val);
+			break;
+
+		case 15:
+			if(iequals(key, "x-forwarded-for"_sv))
+				head.forwarded_for = val;
+			else if(iequals(key, "accept-encoding"_sv))
+				head.accept_encoding = val;
+			break;
+	}
 }
 
 ircd::http::response::response(window_buffer &out,
@@ -586,40 +614,41 @@ void
 ircd::http::assign(response::head &head,
                    const header &header)
 {
-	char buf[96];
-	const auto &[key_, val] {header};
-	assert(size(key_) <= sizeof(buf));
-	if(unlikely(size(key_) > sizeof(buf)))
-		throw error
-		{
-			REQUEST_HEADER_FIELDS_TOO_LARGE
-		};
-
-	const auto &key
-	{
-		tolower(buf, key_)
-	};
-
-	if(key == "content-length"_sv)
-		head.content_length = parser.content_length(val);
-
-	else if(key == "content-type"_sv)
-		head.content_type = val;
-
-	else if(key == "content-range"_sv)
-		head.content_range = val;
-
-	else if(key == "accept-range"_sv)
-		head.content_range = val;
-
-	else if(key == "transfer-encoding"_sv)
-		head.transfer_encoding = val;
-
-	else if(key == "server"_sv)
-		head.server = val;
-
-	else if(key == "location"_sv)
-		head.location = val;
+	const auto &[key, val] {header};
+	switch(size(key))
+	{
+		case 6:
+			if(iequals(key, "server"_sv))
+				head.server = val;
+			break;
+
+		case 8:
+			if(iequals(key, "location"_sv))
+				head.location = val;
+			break;
+
+		case 12:
+			if(iequals(key, "content-type"_sv))
+				head.content_type = val;
+			else if(iequals(key, "accept-range"_sv))
+				head.content_range = val;
+			break;
+
+		case 13:
+			if(iequals(key, "content-range"_sv))
+				head.content_range = val;
+			break;
+
+		case 14:
+			if(iequals(key, "content-length"_sv))
+				head.content_length = parser.content_length(val);
+			break;
+
+		case 17:
+			if(iequals(key, "transfer-encoding"_sv))
+				head.transfer_encoding = val;
+			break;
+	}
 }
 
 ircd::http::response::chunk::chunk(parse::capstan &pc)
@@ -667,6 +696,91 @@ ircd::http::has(const headers &headers,
 	return headers.has(key);
 }
 
+/// The freshness lifetime of a response for a shared cache (RFC 7234 4.2.1).
+/// Zero when the response must not be reused without revalidation and -1
+/// when the headers give no explicit lifetime; the caller then applies its
+/// own default.
+ircd::seconds
+ircd::http::freshness(const headers &headers)
+noexcept try
+{
+	long max_age(-1), s_maxage(-1);
+	bool no_cache(false);
+	tokens(headers["cache-control"], ',', [&](const string_view &directive)
+	{
+		const auto &[key, val]
+		{
+			split(strip(directive, ' '), '=')
+		};
+
+		if(iequals(key, "no-store"_sv) || iequals(key, "no-cache"_sv) || iequals(key, "private"_sv))
+			no_cache = true;
+		else if(iequals(key, "s-maxage"_sv))
+			s_maxage = lex_castable<long>(unquote(val))? lex_cast<long>(unquote(val)): 0L;
+		else if(iequals(key, "max-age"_sv))
+			max_age = lex_castable<long>(unquote(val))? lex_cast<long>(unquote(val)): 0L;
+	});
+
+	if(no_cache)
+		return seconds(0);
+
+	if(s_maxage >= 0)
+		return seconds(s_maxage);
+
+	if(max_age >= 0)
+		return seconds(max_age);
+
+	const string_view expires
+	{
+		headers["expires"]
+	};
+
+	if(!expires)
+		return seconds(-1);
+
+	const auto parse{[](const string_view &date) -> time_t
+	{
+		char buf[64];
+		strlcpy(buf, date);
+		struct tm tm {0};
+		const char *const end
+		{
+			::strptime(buf, "%a, %d %b %Y %H:%M:%S", &tm)
+		};
+
+		return end? ::timegm(&tm): 0;
+	}};
+
+	// An invalid date (i.e. "0") means already expired.
+	const time_t expiry
+	{
+		parse(expires)
+	};
+
+	// The lifetime is relative to the origin's Date header when it has one
+	// to avoid depending on the agreement of our clocks.
+	const time_t date
+	{
+		headers["date"]?
+			parse(headers["date"]):
+			0L
+	};
+
+	const time_t base
+	{
+		date?: ircd::time()
+	};
+
+	return seconds
+	{
+		std::max(expiry - base, time_t(0))
+	};
+}
+catch(...)
+{
+	return seconds(-1);
+}
+
 //
 // headers::headers
 //
@@ -786,6 +900,11 @@ try
 	if(line.empty())
 		return;
 
+	// Well-formed headers are split without the grammar; anything else is
+	// left to the grammar to accept or report.
+	if(likely(header_split(line, *this)))
+		return;
+
 	const char *start(line.data());
 	const char *const stop(line.data() + line.size());
 	parser(start, stop, grammar, *this);
@@ -860,6 +979,9 @@ ircd::http::line::line(parse::capstan &pc)
 	string_view ret;
 	pc([&ret](const char *&start, const char *const &stop)
 	{
+		if(likely(line_scan(start, stop, ret)))
+			return true;
+
 		if(!parser(start, stop, grammar, ret))
 		{
 			ret = {};
@@ -873,6 +995,142 @@ ircd::http::line::line(parse::capstan &pc)
 {
 }
 
+/// Vectorized equivalent of the line grammar for the input it accepts: on
+/// true the start is advanced past the CRLF and ret is the line without
+/// leading whitespace. False leaves everything untouched when no CRLF was
+/// found in the input or it's preceded by an illegal character; the grammar
+/// then makes the determination.
+bool
+ircd::http::line_scan(const char *&start,
+                      const char *const &stop,
+                      string_view &ret)
+noexcept
+{
+	#if defined(__AVX__) || defined(__clang__)
+		using block_t = u8x32;
+	#else
+		using block_t = u8x16;
+	#endif
+
+	const u64x2 max
+	{
+		0, size_t(std::distance(start, stop))
+	};
+
+	const auto count
+	{
+		simd::for_each<block_t>(start, max, line_block<block_t>)
+	};
+
+	if(count[0] != 1)
+		return false;
+
+	string_view content
+	{
+		start, count[1]
+	};
+
+	while(!content.empty() && (content.front() == ' ' || content.front() == '\t'))
+		content.pop_front();
+
+	ret = !content.empty()? content: string_view{};
+	start += count[1] + 2;
+	return true;
+}
+
+/// Result [0] is 1 at a CRLF, 2 at an illegal character; [1] is the number
+/// of characters preceding it. A CR at the end of the input consumes nothing
+/// without a result so the line is incomplete.
+template<class block_t>
+ircd::u64x2
+ircd::http::line_block(const block_t block,
+                       const block_t block_mask)
+noexcept
+{
+	const block_t is_special
+	(
+		(block == '\r') | (block == '\n') | (block == '\0')
+	);
+
+	if(likely(simd::all(~is_special)))
+		return u64x2
+		{
+			0, sizeof(block)
+		};
+
+	const u64 regular_prefix_count
+	{
+		simd::lzcnt(is_special | ~block_mask) / 8
+	};
+
+	if(likely(regular_prefix_count))
+		return u64x2
+		{
+			0, regular_prefix_count
+		};
+
+	if(block[0] == '\r' && !block_mask[1])
+		return u64x2
+		{
+			0, 0
+		};
+
+	const bool crlf
+	{
+		block[0] == '\r' && block[1] == '\n'
+	};
+
+	return u64x2
+	{
+		crlf? 1UL: 2UL, 0
+	};
+}
+
+/// Splits a line into a header as the header grammar would; false if the
+/// line is not plainly `key *ws : *ws value`.
+bool
+ircd::http::header_split(const string_view &line,
+                         header &ret)
+noexcept
+{
+	const auto colon
+	{
+		line.find(':')
+	};
+
+	if(unlikely(colon == line.npos))
+		return false;
+
+	string_view key
+	{
+		line.substr(0, colon)
+	};
+
+	string_view val
+	{
+		line.substr(colon + 1)
+	};
+
+	while(!key.empty() && (key.back() == ' ' || key.back() == '\t'))
+		key.pop_back();
+
+	while(!val.empty() && (val.front() == ' ' || val.front() == '\t'))
+		val.pop_front();
+
+	const bool valid
+	{
+		!key.empty() && !val.empty()
+		&& key.find_first_of(" \t") == key.npos
+	};
+
+	if(unlikely(!valid))
+		return false;
+
+	ret.first = key;
+	ret.second = val;
+	return true;
+}
+
 //
 // query::string
 //
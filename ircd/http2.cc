@@ -14,6 +14,12 @@ ircd::http2::connection_preface
 	"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
 };
 
+decltype(ircd::http2::alpn)
+ircd::http2::alpn
+{
+	"h2"
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // stream.h
@@ -91,6 +97,663 @@ static_assert
     sizeof(ircd::http2::frame::header) == 9
 );
 
+ircd::http2::frame::header::header(const enum type &type,
+                                   const uint8_t &flags,
+                                   const uint32_t &stream_id,
+                                   const size_t &len)
+:len(len)
+,type{type}
+,flags{flags}
+,stream_id(stream_id)
+{
+	assert(len < (1UL << 24));
+	assert(stream_id < (1UL << 31));
+}
+
+ircd::http2::frame::header::header(const const_buffer &buf)
+{
+	if(unlikely(ircd::size(buf) < sizeof(header)))
+		throw error
+		{
+			error::FRAME_SIZE_ERROR, "Frame header requires %zu bytes; have %zu",
+			sizeof(header),
+			ircd::size(buf),
+		};
+
+	const auto *const p
+	{
+		reinterpret_cast<const uint8_t *>(ircd::data(buf))
+	};
+
+	len = uint32_t(p[0]) << 16 | uint32_t(p[1]) << 8 | uint32_t(p[2]);
+	type = (enum type)p[3];
+	flags = p[4];
+	stream_id = uint32_t(p[5] & 0x7f) << 24 | uint32_t(p[6]) << 16 | uint32_t(p[7]) << 8 | uint32_t(p[8]);
+}
+
+ircd::const_buffer
+ircd::http2::frame::header::write(const mutable_buffer &buf)
+const
+{
+	if(unlikely(ircd::size(buf) < sizeof(header)))
+		throw error
+		{
+			"Insufficient buffer of %zu bytes for frame header",
+			ircd::size(buf),
+		};
+
+	auto *const p
+	{
+		reinterpret_cast<uint8_t *>(ircd::data(buf))
+	};
+
+	p[0] = uint8_t(len >> 16);
+	p[1] = uint8_t(len >> 8);
+	p[2] = uint8_t(len);
+	p[3] = uint8_t(type);
+	p[4] = flags;
+	p[5] = uint8_t(stream_id >> 24) & 0x7f;
+	p[6] = uint8_t(stream_id >> 16);
+	p[7] = uint8_t(stream_id >> 8);
+	p[8] = uint8_t(stream_id);
+	return const_buffer
+	{
+		ircd::data(buf), sizeof(header)
+	};
+}
+
+ircd::string_view
+ircd::http2::frame::reflect(const type &type)
+{
+	switch(type)
+	{
+		case type::DATA:            return "DATA";
+		case type::HEADERS:         return "HEADERS";
+		case type::PRIORITY:        return "PRIORITY";
+		case type::RST_STREAM:      return "RST_STREAM";
+		case type::SETTINGS:        return "SETTINGS";
+		case type::PUSH_PROMISE:    return "PUSH_PROMISE";
+		case type::PING:            return "PING";
+		case type::GOAWAY:          return "GOAWAY";
+		case type::WINDOW_UPDATE:   return "WINDOW_UPDATE";
+		case type::CONTINUATION:    return "CONTINUATION";
+	}
+
+	return "??????";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// hpack.h
+//
+
+namespace ircd::http2::hpack
+{
+	struct huffman_node;
+
+	static uint64_t read_int(const uint8_t *&, const uint8_t *const &, const uint &prefix);
+	static void write_int(uint8_t *&, const uint8_t *const &, uint64_t, const uint &prefix, const uint8_t &flags);
+	static string_view read_str(const uint8_t *&, const uint8_t *const &, std::string &);
+	static void write_str(uint8_t *&, const uint8_t *const &, const string_view &);
+	static std::vector<huffman_node> huffman_tree();
+
+	extern const std::pair<uint32_t, uint8_t> huffman_code[257];
+	extern const std::vector<huffman_node> huffman;
+}
+
+/// Node of the huffman decoding tree; a negative child is a leaf of symbol
+/// (-child - 1), zero is an invalid code since the root is never a child.
+struct ircd::http2::hpack::huffman_node
+{
+	int16_t child[2] {0, 0};
+};
+
+/// RFC 7541 Appendix A
+decltype(ircd::http2::hpack::static_table)
+ircd::http2::hpack::static_table
+{
+	{ ":authority",                   ""               },
+	{ ":method",                      "GET"            },
+	{ ":method",                      "POST"           },
+	{ ":path",                        "/"              },
+	{ ":path",                        "/index.html"    },
+	{ ":scheme",                      "http"           },
+	{ ":scheme",                      "https"          },
+	{ ":status",                      "200"            },
+	{ ":status",                      "204"            },
+	{ ":status",                      "206"            },
+	{ ":status",                      "304"            },
+	{ ":status",                      "400"            },
+	{ ":status",                      "404"            },
+	{ ":status",                      "500"            },
+	{ "accept-charset",               ""               },
+	{ "accept-encoding",              "gzip, deflate"  },
+	{ "accept-language",              ""               },
+	{ "accept-ranges",                ""               },
+	{ "accept",                       ""               },
+	{ "access-control-allow-origin",  ""               },
+	{ "age",                          ""               },
+	{ "allow",                        ""               },
+	{ "authorization",                ""               },
+	{ "cache-control",                ""               },
+	{ "content-disposition",          ""               },
+	{ "content-encoding",             ""               },
+	{ "content-language",             ""               },
+	{ "content-length",               ""               },
+	{ "content-location",             ""               },
+	{ "content-range",                ""               },
+	{ "content-type",                 ""               },
+	{ "cookie",                       ""               },
+	{ "date",                         ""               },
+	{ "etag",                         ""               },
+	{ "expect",                       ""               },
+	{ "expires",                      ""               },
+	{ "from",                         ""               },
+	{ "host",                         ""               },
+	{ "if-match",                     ""               },
+	{ "if-modified-since",            ""               },
+	{ "if-none-match",                ""               },
+	{ "if-range",                     ""               },
+	{ "if-unmodified-since",          ""               },
+	{ "last-modified",                ""               },
+	{ "link",                         ""               },
+	{ "location",                     ""               },
+	{ "max-forwards",                 ""               },
+	{ "proxy-authenticate",           ""               },
+	{ "proxy-authorization",          ""               },
+	{ "range",                        ""               },
+	{ "referer",                      ""               },
+	{ "refresh",                      ""               },
+	{ "retry-after",                  ""               },
+	{ "server",                       ""               },
+	{ "set-cookie",                   ""               },
+	{ "strict-transport-security",    ""               },
+	{ "transfer-encoding",            ""               },
+	{ "user-agent",                   ""               },
+	{ "vary",                         ""               },
+	{ "via",                          ""               },
+	{ "www-authenticate",             ""               },
+};
+
+/// RFC 7541 Appendix B; (code, bits) indexed by symbol; 256 is EOS.
+decltype(ircd::http2::hpack::huffman_code)
+ircd::http2::hpack::huffman_code
+{
+	{0x00001ff8, 13}, {0x007fffd8, 23}, {0x0fffffe2, 28}, {0x0fffffe3, 28},
+	{0x0fffffe4, 28}, {0x0fffffe5, 28}, {0x0fffffe6, 28}, {0x0fffffe7, 28},
+	{0x0fffffe8, 28}, {0x00ffffea, 24}, {0x3ffffffc, 30}, {0x0fffffe9, 28},
+	{0x0fffffea, 28}, {0x3ffffffd, 30}, {0x0fffffeb, 28}, {0x0fffffec, 28},
+	{0x0fffffed, 28}, {0x0fffffee, 28}, {0x0fffffef, 28}, {0x0ffffff0, 28},
+	{0x0ffffff1, 28}, {0x0ffffff2, 28}, {0x3ffffffe, 30}, {0x0ffffff3, 28},
+	{0x0ffffff4, 28}, {0x0ffffff5, 28}, {0x0ffffff6, 28}, {0x0ffffff7, 28},
+	{0x0ffffff8, 28}, {0x0ffffff9, 28}, {0x0ffffffa, 28}, {0x0ffffffb, 28},
+	{0x00000014,  6}, {0x000003f8, 10}, {0x000003f9, 10}, {0x00000ffa, 12},
+	{0x00001ff9, 13}, {0x00000015,  6}, {0x000000f8,  8}, {0x000007fa, 11},
+	{0x000003fa, 10}, {0x000003fb, 10}, {0x000000f9,  8}, {0x000007fb, 11},
+	{0x000000fa,  8}, {0x00000016,  6}, {0x00000017,  6}, {0x00000018,  6},
+	{0x00000000,  5}, {0x00000001,  5}, {0x00000002,  5}, {0x00000019,  6},
+	{0x0000001a,  6}, {0x0000001b,  6}, {0x0000001c,  6}, {0x0000001d,  6},
+	{0x0000001e,  6}, {0x0000001f,  6}, {0x0000005c,  7}, {0x000000fb,  8},
+	{0x00007ffc, 15}, {0x00000020,  6}, {0x00000ffb, 12}, {0x000003fc, 10},
+	{0x00001ffa, 13}, {0x00000021,  6}, {0x0000005d,  7}, {0x0000005e,  7},
+	{0x0000005f,  7}, {0x00000060,  7}, {0x00000061,  7}, {0x00000062,  7},
+	{0x00000063,  7}, {0x00000064,  7}, {0x00000065,  7}, {0x00000066,  7},
+	{0x00000067,  7}, {0x00000068,  7}, {0x00000069,  7}, {0x0000006a,  7},
+	{0x0000006b,  7}, {0x0000006c,  7}, {0x0000006d,  7}, {0x0000006e,  7},
+	{0x0000006f,  7}, {0x00000070,  7}, {0x00000071,  7}, {0x00000072,  7},
+	{0x000000fc,  8}, {0x00000073,  7}, {0x000000fd,  8}, {0x00001ffb, 13},
+	{0x0007fff0, 19}, {0x00001ffc, 13}, {0x00003ffc, 14}, {0x00000022,  6},
+	{0x00007ffd, 15}, {0x00000003,  5}, {0x00000023,  6}, {0x00000004,  5},
+	{0x00000024,  6}, {0x00000005,  5}, {0x00000025,  6}, {0x00000026,  6},
+	{0x00000027,  6}, {0x00000006,  5}, {0x00000074,  7}, {0x00000075,  7},
+	{0x00000028,  6}, {0x00000029,  6}, {0x0000002a,  6}, {0x00000007,  5},
+	{0x0000002b,  6}, {0x00000076,  7}, {0x0000002c,  6}, {0x00000008,  5},
+	{0x00000009,  5}, {0x0000002d,  6}, {0x00000077,  7}, {0x00000078,  7},
+	{0x00000079,  7}, {0x0000007a,  7}, {0x0000007b,  7}, {0x00007ffe, 15},
+	{0x000007fc, 11}, {0x00003ffd, 14}, {0x00001ffd, 13}, {0x0ffffffc, 28},
+	{0x000fffe6, 20}, {0x003fffd2, 22}, {0x000fffe7, 20}, {0x000fffe8, 20},
+	{0x003fffd3, 22}, {0x003fffd4, 22}, {0x003fffd5, 22}, {0x007fffd9, 23},
+	{0x003fffd6, 22}, {0x007fffda, 23}, {0x007fffdb, 23}, {0x007fffdc, 23},
+	{0x007fffdd, 23}, {0x007fffde, 23}, {0x00ffffeb, 24}, {0x007fffdf, 23},
+	{0x00ffffec, 24}, {0x00ffffed, 24}, {0x003fffd7, 22}, {0x007fffe0, 23},
+	{0x00ffffee, 24}, {0x007fffe1, 23}, {0x007fffe2, 23}, {0x007fffe3, 23},
+	{0x007fffe4, 23}, {0x001fffdc, 21}, {0x003fffd8, 22}, {0x007fffe5, 23},
+	{0x003fffd9, 22}, {0x007fffe6, 23}, {0x007fffe7, 23}, {0x00ffffef, 24},
+	{0x003fffda, 22}, {0x001fffdd, 21}, {0x000fffe9, 20}, {0x003fffdb, 22},
+	{0x003fffdc, 22}, {0x007fffe8, 23}, {0x007fffe9, 23}, {0x001fffde, 21},
+	{0x007fffea, 23}, {0x003fffdd, 22}, {0x003fffde, 22}, {0x00fffff0, 24},
+	{0x001fffdf, 21}, {0x003fffdf, 22}, {0x007fffeb, 23}, {0x007fffec, 23},
+	{0x001fffe0, 21}, {0x001fffe1, 21}, {0x003fffe0, 22}, {0x001fffe2, 21},
+	{0x007fffed, 23}, {0x003fffe1, 22}, {0x007fffee, 23}, {0x007fffef, 23},
+	{0x000fffea, 20}, {0x003fffe2, 22}, {0x003fffe3, 22}, {0x003fffe4, 22},
+	{0x007ffff0, 23}, {0x003fffe5, 22}, {0x003fffe6, 22}, {0x007ffff1, 23},
+	{0x03ffffe0, 26}, {0x03ffffe1, 26}, {0x000fffeb, 20}, {0x0007fff1, 19},
+	{0x003fffe7, 22}, {0x007ffff2, 23}, {0x003fffe8, 22}, {0x01ffffec, 25},
+	{0x03ffffe2, 26}, {0x03ffffe3, 26}, {0x03ffffe4, 26}, {0x07ffffde, 27},
+	{0x07ffffdf, 27}, {0x03ffffe5, 26}, {0x00fffff1, 24}, {0x01ffffed, 25},
+	{0x0007fff2, 19}, {0x001fffe3, 21}, {0x03ffffe6, 26}, {0x07ffffe0, 27},
+	{0x07ffffe1, 27}, {0x03ffffe7, 26}, {0x07ffffe2, 27}, {0x00fffff2, 24},
+	{0x001fffe4, 21}, {0x001fffe5, 21}, {0x03ffffe8, 26}, {0x03ffffe9, 26},
+	{0x0ffffffd, 28}, {0x07ffffe3, 27}, {0x07ffffe4, 27}, {0x07ffffe5, 27},
+	{0x000fffec, 20}, {0x00fffff3, 24}, {0x000fffed, 20}, {0x001fffe6, 21},
+	{0x003fffe9, 22}, {0x001fffe7, 21}, {0x001fffe8, 21}, {0x007ffff3, 23},
+	{0x003fffea, 22}, {0x003fffeb, 22}, {0x01ffffee, 25}, {0x01ffffef, 25},
+	{0x00fffff4, 24}, {0x00fffff5, 24}, {0x03ffffea, 26}, {0x007ffff4, 23},
+	{0x03ffffeb, 26}, {0x07ffffe6, 27}, {0x03ffffec, 26}, {0x03ffffed, 26},
+	{0x07ffffe7, 27}, {0x07ffffe8, 27}, {0x07ffffe9, 27}, {0x07ffffea, 27},
+	{0x07ffffeb, 27}, {0x0ffffffe, 28}, {0x07ffffec, 27}, {0x07ffffed, 27},
+	{0x07ffffee, 27}, {0x07ffffef, 27}, {0x07fffff0, 27}, {0x03ffffee, 26},
+	{0x3fffffff, 30},
+};
+
+decltype(ircd::http2::hpack::huffman)
+ircd::http2::hpack::huffman
+{
+	huffman_tree()
+};
+
+std::vector<ircd::http2::hpack::huffman_node>
+ircd::http2::hpack::huffman_tree()
+{
+	std::vector<huffman_node> ret(1);
+	for(size_t sym(0); sym < 257; ++sym)
+	{
+		const auto &[code, bits]
+		{
+			huffman_code[sym]
+		};
+
+		size_t node(0);
+		for(int i(bits - 1); i > 0; --i)
+		{
+			const bool bit(code & (1U << i));
+			if(!ret[node].child[bit])
+			{
+				ret[node].child[bit] = int16_t(ret.size());
+				ret.emplace_back();
+			}
+
+			node = ret[node].child[bit];
+		}
+
+		ret[node].child[code & 1] = -int16_t(sym + 1);
+	}
+
+	return ret;
+}
+
+ircd::string_view
+ircd::http2::hpack::huffman_decode(const mutable_buffer &out,
+                                   const const_buffer &in)
+{
+	size_t node(0), len(0), pad(0);
+	for(const uint8_t byte : in)
+		for(int i(7); i >= 0; --i)
+		{
+			const bool bit(byte & (1U << i));
+			const int16_t next
+			{
+				huffman[node].child[bit]
+			};
+
+			pad = bit? pad + 1: 8;
+			if(unlikely(!next))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "Invalid huffman code"
+				};
+
+			if(next > 0)
+			{
+				node = next;
+				continue;
+			}
+
+			const uint sym(-next - 1);
+			if(unlikely(sym == 256))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "Huffman EOS in string literal"
+				};
+
+			if(unlikely(len >= size(out)))
+				throw error
+				{
+					error::COMPRESSION_ERROR, "Huffman string exceeds %zu bytes", size(out)
+				};
+
+			out[len++] = char(sym);
+			node = 0;
+			pad = 0;
+		}
+
+	// The remainder must be a strict prefix of EOS (all ones) shorter than
+	// one octet.
+	if(unlikely(pad >= 8))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "Invalid huffman padding"
+		};
+
+	return string_view
+	{
+		data(out), len
+	};
+}
+
+void
+ircd::http2::hpack::decode(table &table,
+                           const const_buffer &block,
+                           const closure &closure)
+{
+	const auto *p
+	{
+		reinterpret_cast<const uint8_t *>(data(block))
+	};
+
+	const auto *const e
+	{
+		p + size(block)
+	};
+
+	std::string namebuf, valbuf;
+	while(p < e)
+	{
+		const uint8_t op(*p);
+
+		// Indexed header field
+		if(op & 0x80)
+		{
+			const auto &[name, value]
+			{
+				table.at(read_int(p, e, 7))
+			};
+
+			closure(name, value);
+			continue;
+		}
+
+		// Dynamic table size update
+		if((op & 0xe0) == 0x20)
+		{
+			table.resize(read_int(p, e, 5));
+			continue;
+		}
+
+		// Literal header field; with incremental indexing or without (never).
+		const bool indexing((op & 0xc0) == 0x40);
+		const size_t index
+		{
+			read_int(p, e, indexing? 6: 4)
+		};
+
+		if(index)
+			namebuf = std::string{table.at(index).first};
+
+		const string_view name
+		{
+			index?
+				string_view{namebuf}:
+				read_str(p, e, namebuf)
+		};
+
+		const string_view value
+		{
+			read_str(p, e, valbuf)
+		};
+
+		closure(name, value);
+		if(indexing)
+			table.insert(name, value);
+	}
+}
+
+ircd::const_buffer
+ircd::http2::hpack::encode(const mutable_buffer &buf,
+                           const string_view &name,
+                           const string_view &value)
+{
+	auto *p
+	{
+		reinterpret_cast<uint8_t *>(data(buf))
+	};
+
+	const auto *const e
+	{
+		p + size(buf)
+	};
+
+	size_t name_index(0);
+	for(size_t i(0); i < 61; ++i)
+	{
+		if(static_table[i].first != name)
+			continue;
+
+		if(static_table[i].second == value)
+		{
+			write_int(p, e, i + 1, 7, 0x80);
+			return const_buffer
+			{
+				data(buf), size_t(std::distance(reinterpret_cast<uint8_t *>(data(buf)), p))
+			};
+		}
+
+		name_index = name_index?: i + 1;
+	}
+
+	write_int(p, e, name_index, 4, 0x00);
+	if(!name_index)
+		write_str(p, e, name);
+
+	write_str(p, e, value);
+	return const_buffer
+	{
+		data(buf), size_t(std::distance(reinterpret_cast<uint8_t *>(data(buf)), p))
+	};
+}
+
+uint64_t
+ircd::http2::hpack::read_int(const uint8_t *&p,
+                             const uint8_t *const &e,
+                             const uint &prefix)
+{
+	if(unlikely(p >= e))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "Truncated integer"
+		};
+
+	const uint8_t mask((1U << prefix) - 1);
+	uint64_t ret(*p++ & mask);
+	if(ret < mask)
+		return ret;
+
+	for(uint shift(0); shift < 56; shift += 7)
+	{
+		if(unlikely(p >= e))
+			throw error
+			{
+				error::COMPRESSION_ERROR, "Truncated integer"
+			};
+
+		const uint8_t byte(*p++);
+		ret += uint64_t(byte & 0x7f) << shift;
+		if(!(byte & 0x80))
+			return ret;
+	}
+
+	throw error
+	{
+		error::COMPRESSION_ERROR, "Integer overflow"
+	};
+}
+
+void
+ircd::http2::hpack::write_int(uint8_t *&p,
+                              const uint8_t *const &e,
+                              uint64_t val,
+                              const uint &prefix,
+                              const uint8_t &flags)
+{
+	const uint8_t mask((1U << prefix) - 1);
+	const auto check{[&p, &e]
+	{
+		if(unlikely(p >= e))
+			throw error
+			{
+				"Insufficient buffer to encode header"
+			};
+	}};
+
+	check();
+	if(val < mask)
+	{
+		*p++ = flags | uint8_t(val);
+		return;
+	}
+
+	*p++ = flags | mask;
+	for(val -= mask; val >= 0x80; val >>= 7)
+	{
+		check();
+		*p++ = uint8_t(val & 0x7f) | 0x80;
+	}
+
+	check();
+	*p++ = uint8_t(val);
+}
+
+ircd::string_view
+ircd::http2::hpack::read_str(const uint8_t *&p,
+                             const uint8_t *const &e,
+                             std::string &buf)
+{
+	const bool huff
+	{
+		p < e && (*p & 0x80)
+	};
+
+	const size_t len
+	{
+		read_int(p, e, 7)
+	};
+
+	if(unlikely(len > size_t(e - p)))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "String literal of %zu bytes exceeds block",
+			len,
+		};
+
+	const const_buffer in
+	{
+		reinterpret_cast<const char *>(p), len
+	};
+
+	p += len;
+	if(!huff)
+	{
+		buf.assign(data(in), size(in));
+		return buf;
+	}
+
+	// Huffman codes are at least five bits.
+	buf.resize(len * 8 / 5 + 1);
+	const string_view decoded
+	{
+		huffman_decode(mutable_buffer{buf}, in)
+	};
+
+	buf.resize(size(decoded));
+	return buf;
+}
+
+void
+ircd::http2::hpack::write_str(uint8_t *&p,
+                              const uint8_t *const &e,
+                              const string_view &str)
+{
+	write_int(p, e, size(str), 7, 0x00);
+	if(unlikely(size(str) > size_t(e - p)))
+		throw error
+		{
+			"Insufficient buffer to encode header"
+		};
+
+	p = std::copy(begin(str), end(str), p);
+}
+
+//
+// hpack::table
+//
+
+std::pair<ircd::string_view, ircd::string_view>
+ircd::http2::hpack::table::at(const size_t &index)
+const
+{
+	if(likely(index > 0 && index <= 61))
+		return static_table[index - 1];
+
+	if(likely(index > 61 && index - 62 < entries.size()))
+	{
+		const auto &[name, value]
+		{
+			entries.at(index - 62)
+		};
+
+		return { name, value };
+	}
+
+	throw error
+	{
+		error::COMPRESSION_ERROR, "Header index %zu out of range", index
+	};
+}
+
+void
+ircd::http2::hpack::table::insert(const string_view &name_,
+                                  const string_view &value_)
+{
+	// The arguments may refer to an entry about to be evicted.
+	std::string name(name_), value(value_);
+	const size_t entry_size
+	{
+		ircd::size(name) + ircd::size(value) + 32
+	};
+
+	while(!entries.empty() && size + entry_size > max)
+	{
+		const auto &back(entries.back());
+		size -= ircd::size(back.first) + ircd::size(back.second) + 32;
+		entries.pop_back();
+	}
+
+	if(entry_size > max)
+		return;
+
+	entries.emplace_front(std::move(name), std::move(value));
+	size += entry_size;
+}
+
+void
+ircd::http2::hpack::table::resize(const size_t &max)
+{
+	// The table size may not exceed what we advertised in our settings.
+	if(unlikely(max > 4096))
+		throw error
+		{
+			error::COMPRESSION_ERROR, "Dynamic table size %zu exceeds settings", max
+		};
+
+	this->max = max;
+	while(!entries.empty() && size > max)
+	{
+		const auto &back(entries.back());
+		size -= ircd::size(back.first) + ircd::size(back.second) + 32;
+		entries.pop_back();
+	}
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 //
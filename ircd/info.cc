@@ -159,6 +159,15 @@ ircd::info::dump_cpu_info()
 		pretty(pbuf[5], iec(total_swap)),
 	};
 
+	if(numa_nodes > 1)
+		log::info
+		{
+			log::star, "NUMA nodes %zu online %s; main thread on node %d",
+			numa_nodes,
+			numa_online,
+			sys::numa_node(),
+		};
+
 	if(!ircd::debugmode)
 		return;
 
@@ -274,6 +283,7 @@ ircd::info::dump_cpu_info_x86()
 	append("avx", hardware::x86::avx, simd::support::avx);
 	append("avx2", hardware::x86::avx2, simd::support::avx2);
 	append("avx512f", hardware::x86::avx512f, simd::support::avx512f);
+	append("sha", hardware::x86::sha, -1);
 	append("constant_tsc", hardware::x86::tsc_constant, -1);
 
 	log::info
@@ -482,13 +492,19 @@ ircd::info::hardware::x86::avx
 decltype(ircd::info::hardware::x86::avx2)
 ircd::info::hardware::x86::avx2
 {
-	bool(features & (uint128_t(1) << (32 + 5)))
+	bool(extended_features & (uint128_t(1) << (32 + 5)))
 };
 
 decltype(ircd::info::hardware::x86::avx512f)
 ircd::info::hardware::x86::avx512f
 {
-	bool(features & (uint128_t(1) << (32 + 16)))
+	bool(extended_features & (uint128_t(1) << (32 + 16)))
+};
+
+decltype(ircd::info::hardware::x86::sha)
+ircd::info::hardware::x86::sha
+{
+	bool(extended_features & (uint128_t(1) << (32 + 29)))
 };
 
 decltype(ircd::info::hardware::x86::tsc)
@@ -1004,7 +1020,7 @@ ircd::info::dump_sys_info()
 	log::logf
 	{
 		log::star, log::DEBUG,
-		"page_size=%zu iov_max=%zd aio_max=%zd aio_reqprio_max=%zd memlock_limit=%s clock_source=%s thp=%s:%zu",
+		"page_size=%zu iov_max=%zd aio_max=%zd aio_reqprio_max=%zd memlock_limit=%s clock_source=%s thp=%s:%zu numa=%zu:%s",
 		page_size,
 		iov_max,
 		aio_max,
@@ -1013,6 +1029,8 @@ ircd::info::dump_sys_info()
 		clock_source,
 		between(thp_enable, '[', ']'),
 		thp_size,
+		numa_nodes,
+		numa_online,
 	};
 	//#endif
 }
@@ -1169,6 +1187,26 @@ ircd::info::thp_enable
 		string_view{}
 };
 
+static char ircd_info_numa_online_buf[64];
+decltype(ircd::info::numa_online)
+ircd::info::numa_online
+{
+	sys::get(ircd_info_numa_online_buf, "devices/system/node/online")
+};
+
+decltype(ircd::info::numa_nodes)
+ircd::info::numa_nodes{[]
+{
+	size_t ret(0);
+	sys::cpulist(numa_online, [&ret](const uint &)
+	{
+		++ret;
+		return true;
+	});
+
+	return std::max(ret, 1UL);
+}()};
+
 //
 // System information
 //
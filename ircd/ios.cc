@@ -237,6 +237,67 @@ ircd::ios::empt::load_stall
 	}
 };
 
+/// Period over which the load counters are compared to determine the load
+/// level reported by load().
+decltype(ircd::ios::empt::load_interval)
+ircd::ios::empt::load_interval
+{
+	{ "name",      "ircd.ios.empt.load.interval" },
+	{ "default",   1000L                         },
+};
+
+/// Percentage of the calls in an interval which must have reported a level's
+/// threshold for load() to report that level.
+decltype(ircd::ios::empt::load_ratio)
+ircd::ios::empt::load_ratio
+{
+	{ "name",      "ircd.ios.empt.load.ratio" },
+	{ "default",   25L                        },
+};
+
+/// The level is computed from the difference in the counters since the last
+/// interval elapsed; otherwise the last level is returned. No level is
+/// reported when there were no calls, i.e. the embedder doesn't support this.
+uint
+ircd::ios::empt::load()
+noexcept
+{
+	static uint ret;
+	static uint64_t last[9];
+	static steady_point last_time;
+
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	if(now - last_time < milliseconds(load_interval))
+		return ret;
+
+	const auto delta{[](const uint64_t &i)
+	{
+		return stats[i] - last[i];
+	}};
+
+	const uint64_t calls(delta(2));
+	const uint64_t ratio(load_ratio);
+	const auto over{[&calls, &ratio, &delta](const uint64_t &i)
+	{
+		return calls && delta(i) * 100 >= calls * ratio;
+	}};
+
+	ret =
+		over(8)? 4:
+		over(7)? 3:
+		over(6)? 2:
+		over(5)? 1:
+		0;
+
+	std::copy(std::begin(stats), std::end(stats), std::begin(last));
+	last_time = now;
+	return ret;
+}
+
 //
 // descriptor
 //
@@ -486,6 +547,10 @@ noexcept
 	stats.slice_last = handler->ts - slice_start;
 	stats.slice_total += stats.slice_last;
 
+	// Samples taken during the slice are attributed to it.
+	if(unlikely(prof::sampler::active))
+		prof::sampler::drain(ctx::current? ctx::name(*ctx::current): descriptor.name);
+
 	if constexpr(profile::history)
 	{
 		assert(descriptor.history_pos < descriptor.history.size());
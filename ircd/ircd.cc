@@ -161,6 +161,27 @@ ircd::diagnostic
 	{ "persist",  false                 },
 };
 
+/// CPU affinity of the main thread as a cpulist(7) string (i.e. "0-7,16-23").
+/// All contexts run on this thread, including the RocksDB env pools, so this
+/// places them as well. Empty leaves the affinity inherited from the process.
+decltype(ircd::affinity)
+ircd::affinity
+{
+	{
+		{ "name",     "ircd.affinity"      },
+		{ "default",  string_view{}        },
+		{ "persist",  false                },
+	}, []
+	{
+		// Otherwise applied by init() on the main thread.
+		if(run::level == run::level::HALT)
+			return;
+
+		if(string_view(affinity))
+			sys::affinity(affinity);
+	}
+};
+
 /// Main context pointer placement.
 decltype(ircd::main_context)
 ircd::main_context;
@@ -188,6 +209,11 @@ try
 	// Setup the core event loop system starting with the user's supplied ios.
 	ios::init(std::move(executor));
 
+	// Pin the main thread before anything allocates for it; first-touch
+	// places its memory on the node of these CPUs.
+	if(string_view(affinity))
+		sys::affinity(affinity);
+
 	// The log is available. but it is console-only until conf opens files.
 	log::init();
 	log::mark("DEADSTART"); // 6600
@@ -364,6 +390,7 @@ noexcept try
 	// also occur in ircd::init() or static initialization itself if either are
 	// more appropriate.
 
+	log::async _log_;        // Log writer thread
 	fs::init _fs_;           // Local filesystem
 	cl::init _cl_;           // OpenCL
 	magic::init _magic_;     // libmagic
@@ -185,6 +185,12 @@ ircd::json::parser
 		,"name"
 	};
 
+	// structural scan of a container; only the bracketing and the bounds
+	// of strings are checked, not the content.
+	struct structure_state;
+	template<class block_t> static u64x2 structure_block(structure_state &, const block_t, const block_t) noexcept;
+	const custom_parser<1> structure{};
+
 	// recursion depth
 	_r1_type depth;
 	[[noreturn]] static void throws_exceeded();
@@ -224,6 +230,15 @@ ircd::json::parser
 		,"value"
 	};
 
+	// value for iteration; containers are scanned rather than parsed, their
+	// content is parsed when it is iterated in turn. The grammar takes over
+	// when the scan fails to report the error.
+	const rule<> value_scan
+	{
+		((&object_begin | &array_begin) >> structure) | value(0)
+		,"value"
+	};
+
 	template<class gen,
 	         class... attr>
 	bool operator()(const char *&start, const char *const &stop, gen&&, attr&&...) const;
@@ -551,6 +566,171 @@ const
 	return ok;
 }
 
+struct ircd::json::parser::structure_state
+{
+	u64 open[2] {0, 0};     // bit per level; set for array, clear for object
+	uint depth {0};
+	bool string {false};
+};
+
+/// The input covers everything from the alleged start of a container to the
+/// end of whatever the user provided. The extent of the container is found
+/// by a vectorized scan for its structural characters; the iterator is
+/// advanced past its closing character iff successful.
+template<>
+template<class iterator,
+         class context,
+         class skipper,
+         class attr>
+inline bool
+ircd::json::custom_parser<1>::parse(iterator &__restrict__ start,
+                                    const iterator &__restrict__ stop,
+                                    context &g,
+                                    const skipper &,
+                                    attr &)
+const
+{
+	#if defined(__AVX__) || defined(__clang__)
+		using block_t = u8x32;
+	#else
+		using block_t = u8x16;
+	#endif
+
+	assert(start <= stop);
+	const size_t input_max
+	{
+		size_t(std::distance(start, stop))
+	};
+
+	const bool input_valid
+	{
+		input_max >= 2 && (start[0] == '{' || start[0] == '[')
+	};
+
+	const u64x2 max
+	{
+		0, input_max & boolmask<u64>(input_valid)
+	};
+
+	json::parser::structure_state state;
+	const auto each_block{[&state]
+	(const block_t block, const block_t block_mask) noexcept
+	{
+		return json::parser::structure_block<block_t>(state, block, block_mask);
+	}};
+
+	const auto count
+	{
+		simd::for_each<block_t>(start, max, each_block)
+	};
+
+	// The scan stops on the closing character without consuming it.
+	const bool ok
+	{
+		count[0] == 1
+	};
+
+	start += (count[1] + 1) & boolmask<u64>(ok);
+	return ok;
+}
+
+/// Result [0] is 1 at the end of the container or 2 on error; [1] is the
+/// number of characters consumed.
+template<class block_t>
+inline ircd::u64x2
+ircd::json::parser::structure_block(structure_state &state,
+                                    const block_t block,
+                                    const block_t block_mask)
+noexcept
+{
+	assert(block_mask[0] == 0xff);
+	const block_t is_quote
+	(
+		block == '"'
+	);
+
+	const block_t is_esc
+	(
+		block == '\\'
+	);
+
+	const block_t is_struct
+	(
+		(block == '{') | (block == '}') | (block == '[') | (block == ']')
+	);
+
+	// Within a string only the quote and escape are significant.
+	const block_t is_special
+	(
+		is_quote | (state.string? is_esc: is_struct)
+	);
+
+	const u64 regular_prefix_count
+	{
+		simd::lzcnt(is_special | ~block_mask) / 8
+	};
+
+	if(likely(regular_prefix_count))
+		return u64x2
+		{
+			0, regular_prefix_count
+		};
+
+	static const u64x2 error
+	{
+		2, 0
+	};
+
+	const uint lvl(state.depth % 128);
+	switch(block[0])
+	{
+		case '\\':
+			if(unlikely(!block_mask[1]))
+				return error;
+
+			return u64x2{0, 2};
+
+		case '"':
+			state.string = !state.string;
+			return u64x2{0, 1};
+
+		case '{':
+		case '[':
+			if(unlikely(state.depth + 1 >= json::object::max_recursion_depth))
+				return error;
+
+			state.open[lvl / 64] &= ~(1UL << (lvl % 64));
+			state.open[lvl / 64] |= u64(block[0] == '[') << (lvl % 64);
+			state.depth++;
+			return u64x2{0, 1};
+
+		case '}':
+		case ']':
+		{
+			if(unlikely(!state.depth))
+				return error;
+
+			const uint top(--state.depth % 128);
+			const bool is_array
+			{
+				bool(state.open[top / 64] & (1UL << (top % 64)))
+			};
+
+			if(unlikely(is_array != (block[0] == ']')))
+				return error;
+
+			if(!state.depth)
+				return u64x2{1, 0};
+
+			return u64x2{0, 1};
+		}
+
+		default:
+			assert(0);
+			return error;
+	}
+}
+
 template<class block_t>
 inline ircd::u64x2
 ircd::json::parser::string_content_block(const block_t block,
@@ -1373,6 +1553,34 @@ ircd::json::stack::object::append(const json::object &object)
 		};
 }
 
+/// Append the members of an object which was already printed, copying its
+/// bytes verbatim rather than parsing and printing each member again. The
+/// input is trusted to be canonical JSON from a prior json::stack or print.
+void
+ircd::json::stack::object::splice(const json::object &object)
+{
+	assert(s->opened());
+	assert(cm == nullptr);
+	s->rethrow_exception();
+
+	const string_view &in(object);
+	assert(in.size() >= 2);
+	assert(in.front() == '{' && in.back() == '}');
+	const string_view members
+	{
+		in.substr(1, in.size() - 2)
+	};
+
+	if(members.empty())
+		return;
+
+	if(mc)
+		s->append(',');
+
+	s->append(members);
+	mc++;
+}
+
 #if defined(__GNUC__) && !defined(__clang__)
 __attribute__((optimize("no-lifetime-dse")))
 #endif
@@ -2074,6 +2282,127 @@ ircd::json::_prev(chase &c)
 	else return false;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// json/scanner.h
+//
+
+size_t
+ircd::json::scanner::operator()(const string_view &input,
+                                const closure &closure)
+{
+	const auto is_object{[this](const uint &depth)
+	{
+		return bool(object & (1UL << depth));
+	}};
+
+	size_t ret(0);
+	for(; pos < size(input); ++pos)
+	{
+		const char &c(input[pos]);
+		if(quote)
+		{
+			if(escape)
+				escape = false;
+			else if(c == '\\')
+				escape = true;
+			else if(c == '"')
+			{
+				quote = false;
+				if(depth == target && expect_key)
+					key[1] = pos;
+			}
+
+			continue;
+		}
+
+		switch(c)
+		{
+			case '"':
+				quote = true;
+				if(depth == target && expect_key)
+					key[0] = pos + 1;
+
+				continue;
+
+			case '{':
+			case '[':
+				if(unlikely(depth + 1 >= depth_max))
+					throw recursion_limit
+					{
+						"Exceeded maximum depth of %u at offset %zu.",
+						depth_max,
+						pos,
+					};
+
+				++depth;
+				object &= ~(1UL << depth);
+				object |= uint64_t(c == '{') << depth;
+				if(depth == target)
+					expect_key = c == '{';
+
+				// An object element of an array which is a member value of
+				// an object at the target depth begins here.
+				if(depth == target + 2 && c == '{')
+					if(is_object(target) && !is_object(target + 1))
+						element = pos;
+
+				continue;
+
+			case '}':
+			case ']':
+			{
+				if(unlikely(!depth))
+					throw parse_error
+					{
+						"Unbalanced '%c' at offset %zu.",
+						c,
+						pos,
+					};
+
+				complete = --depth == 0;
+				if(depth != target + 1 || element == -1UL)
+					continue;
+
+				const string_view name
+				{
+					input.data() + key[0], input.data() + key[1]
+				};
+
+				const json::object value
+				{
+					input.substr(element, pos + 1 - element)
+				};
+
+				++ret;
+				element = -1UL;
+				if(likely(closure(name, value)))
+					continue;
+
+				++pos;
+				return ret;
+			}
+
+			case ':':
+				if(depth == target)
+					expect_key = false;
+
+				continue;
+
+			case ',':
+				if(depth == target)
+					expect_key = true;
+
+				continue;
+
+			default:
+				continue;
+		}
+	}
+
+	return ret;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // json/iov.h
@@ -2581,7 +2910,7 @@ namespace ircd::json
 decltype(ircd::json::object_member)
 ircd::json::object_member
 {
-	parser.name >> parser.ws >> parser.name_sep >> parser.ws >> raw[parser.value(0)]
+	parser.name >> parser.ws >> parser.name_sep >> parser.ws >> raw[parser.value_scan]
 	,"object member"
 };
 
@@ -2787,6 +3116,56 @@ const
 	});
 }
 
+//
+// object::index
+//
+
+ircd::json::object::index::index(const json::object &object)
+:object
+{
+	object
+}
+{
+	for(const auto &member : object)
+	{
+		if(unlikely(count >= members.size()))
+		{
+			partial = true;
+			break;
+		}
+
+		members[count++] = member;
+	}
+}
+
+ircd::string_view
+ircd::json::object::index::get(const string_view &key,
+                               const string_view &def)
+const
+{
+	const auto end
+	{
+		std::begin(members) + count
+	};
+
+	const auto it
+	{
+		std::find_if(std::begin(members), end, [&key]
+		(const auto &member)
+		{
+			return member.first == key;
+		})
+	};
+
+	if(it != end)
+		return it->second;
+
+	if(unlikely(partial))
+		return object.get(key, def);
+
+	return def;
+}
+
 ircd::json::object::const_iterator
 ircd::json::object::find(const string_view &key)
 const
@@ -2977,7 +3356,7 @@ ircd::json::array::max_recursion_depth
 decltype(ircd::json::array_value)
 ircd::json::array_value
 {
-	raw[parser.value(0)]
+	raw[parser.value_scan]
 	,"array element"
 };
 
@@ -3568,16 +3947,53 @@ ircd::json::string_unescape_utf16(u8x16 &block,
 		encoded_sparse
 	);
 
+	// The decoder's lanes can't distinguish an absent second sequence from
+	// \u0000 or from a lone surrogate it masked, so the input decides. A pair
+	// outputs lane[0] alone but consumes both sequences; a second sequence
+	// which is itself a surrogate is left for the next iteration to pair.
+	const u8x16 input
+	(
+		block & block_mask
+	);
+
+	const bool paired
+	{
+		length[0] >= 4
+	};
+
+	const bool second
+	{
+		input[6] == '\\'
+		&& input[7] == 'u'
+		&& std::isxdigit(input[8])
+		&& std::isxdigit(input[9])
+		&& std::isxdigit(input[10])
+		&& std::isxdigit(input[11])
+	};
+
+	// U+D800 through U+DFFF; any hex digit from '8' sorts above '7' in ASCII.
+	const bool second_surrogate
+	{
+		second
+		&& (input[8] | 0x20) == 'd'
+		&& input[9] >= '8'
+	};
+
+	const bool deuce
+	{
+		!paired && second && !second_surrogate
+	};
+
 	size_t di(0), i(0);
-	for(; i < 2 && length[i] > 0; ++i)
+	for(; i < 1U + deuce; ++i)
 		for(size_t j(0); j < length[i]; ++j)
 			block[di++] = encoded[i * 4 + j];
 
-	assert(di == length[0] + length[1]);
+	assert(di == length[0] + (deuce? length[1]: 0));
 	assert(i >= 1 && i <= 2);
 	return u64x2
 	{
-		di, 6U * i
+		di, 6U * (1U + (paired || deuce))
 	};
 }
 
@@ -4859,7 +5275,7 @@ ircd::json::valid(const string_view &s,
 noexcept try
 {
 	const char *start(begin(s)), *const stop(end(s));
-	return parser(start, stop, validation);
+	return parser(start, stop, validation) && utf8::valid(s);
 }
 catch(...)
 {
@@ -4877,6 +5293,112 @@ ircd::json::valid(const string_view &s)
 	};
 
 	assert(ret);
+	if(unlikely(!utf8::valid(s)))
+		throw parse_error
+		{
+			"Invalid UTF-8 in JSON input."
+		};
+}
+
+/// Conservative single-pass test whether valid JSON input is byte-for-byte
+/// what stringify() would generate for it: no insignificant whitespace, the
+/// keys of every object in strictly ascending order, and strings with only
+/// those escapes stringify() preserves. A false result only means the input
+/// must be canonized before it can stand in for the canonical form; some
+/// inputs (e.g. those with \u escapes) are rejected even if they would pass
+/// through unchanged. The input is not validated here.
+bool
+ircd::json::canonical(const string_view &s)
+noexcept
+{
+	// Input deeper than the parser accepts (object::max_recursion_depth)
+	// is never considered canonical.
+	static constexpr const size_t depth_max
+	{
+		96
+	};
+
+	// The last key seen by each object open on the stack.
+	std::array<string_view, depth_max + 1> last;
+	std::array<bool, depth_max + 1> object {false};
+	size_t depth(0);
+	bool key(false);
+
+	for(const char *p(begin(s)), *const e(end(s)); p < e; ++p) switch(*p)
+	{
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+			return false;
+
+		case '{':
+		case '[':
+			if(unlikely(depth >= depth_max))
+				return false;
+
+			++depth;
+			object[depth] = *p == '{';
+			last[depth] = {};
+			key = object[depth];
+			continue;
+
+		case '}':
+		case ']':
+			if(unlikely(!depth))
+				return false;
+
+			--depth;
+			key = false;
+			continue;
+
+		case ',':
+			key = object[depth];
+			continue;
+
+		case '"':
+		{
+			const char *const start(++p);
+			for(; p < e && *p != '"'; ++p)
+			{
+				if(unlikely(u8(*p) < 0x20))
+					return false;
+
+				if(*p != '\\')
+					continue;
+
+				switch(p + 1 < e? *++p: 0)
+				{
+					case 'b': case 't': case 'n': case 'f':
+					case 'r': case '"': case '\\':
+						continue;
+
+					default:
+						return false;
+				}
+			}
+
+			if(!key)
+				continue;
+
+			const string_view name
+			{
+				start, p
+			};
+
+			if(last[depth].data() && !(last[depth] < name))
+				return false;
+
+			last[depth] = name;
+			key = false;
+			continue;
+		}
+
+		default:
+			continue;
+	}
+
+	return depth == 0;
 }
 
 void
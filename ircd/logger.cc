@@ -41,6 +41,41 @@ namespace ircd::log
 	std::ostream &err_console{std::cerr};
 }
 
+namespace ircd::log
+{
+	enum async_dest :uint
+	{
+		ASYNC_FILE     = 0x01,
+		ASYNC_STDOUT   = 0x02,
+		ASYNC_STDERR   = 0x04,
+		ASYNC_FLUSH    = 0x08,
+	};
+
+	struct async_record;
+
+	static void async_copy(const size_t &pos, const const_buffer &) noexcept;
+	static void async_read(const size_t &pos, const mutable_buffer &) noexcept;
+	static void async_write(const level &, const uint &dest, const string_view &) noexcept;
+	static void async_drain() noexcept;
+	static void async_sync(const level &, const uint &dest, const string_view &) noexcept;
+	static bool async_push(const level &, const uint &dest, const string_view &) noexcept;
+	static void async_worker() noexcept;
+	static void async_start();
+	static void async_stop() noexcept;
+
+	extern conf::item<bool> async_enable;
+	extern conf::item<size_t> async_buffer_size;
+	extern std::array<stats::item<uint64_t>, num_of<level>()> async_dropped;
+	static std::unique_ptr<char[]> async_ring;
+	static size_t async_ring_size;
+	static std::atomic<size_t> async_head, async_tail;
+	static std::atomic<bool> async_terminate;
+	static std::mutex async_mutex;
+	static std::condition_variable async_cond;
+	static std::thread async_thread;
+	static bool async_ready, async_running;
+}
+
 struct ircd::log::confs
 {
 	conf::item<bool> file_enable;
@@ -166,6 +201,11 @@ ircd::log::mkdir()
 void
 ircd::log::open()
 {
+	const std::lock_guard lock
+	{
+		async_mutex
+	};
+
 	for_each<level>([](const level &lev)
 	{
 		if(file[lev].is_open())
@@ -180,6 +220,11 @@ ircd::log::open()
 void
 ircd::log::close()
 {
+	const std::lock_guard lock
+	{
+		async_mutex
+	};
+
 	for_each<level>([](const level &lev)
 	{
 		if(file[lev].is_open())
@@ -190,6 +235,14 @@ ircd::log::close()
 void
 ircd::log::flush()
 {
+	const std::lock_guard lock
+	{
+		async_mutex
+	};
+
+	if(async_running)
+		async_drain();
+
 	for_each<level>([](const level &lev)
 	{
 		file[lev].flush();
@@ -670,6 +723,9 @@ noexcept
 	if(!copy_to_file || !msg)
 		return;
 
+	if(async_push(lev, ASYNC_FILE | (conf.file_flush? ASYNC_FLUSH : 0U), msg))
+		return;
+
 	file[lev].clear();
 	check(file[lev]);
 	file[lev].write(data(msg), size(msg));
@@ -715,6 +771,16 @@ noexcept
 	if(likely(!(copy_to_stdout | copy_to_stderr) || !msg))
 		return;
 
+	const uint dest
+	{
+		(copy_to_stdout? ASYNC_STDOUT : 0U) |
+		(copy_to_stderr? ASYNC_STDERR : 0U) |
+		(conf.console_flush? ASYNC_FLUSH : 0U)
+	};
+
+	if(async_push(lev, dest, msg))
+		return;
+
 	if(unlikely(copy_to_stderr))
 	{
 		err_console.clear();
@@ -732,6 +798,336 @@ noexcept
 	}
 }
 
+//
+// Asynchronous writer
+//
+
+/// Header of a message in the ring, followed by its bytes; a record may
+/// wrap around the end of the ring.
+struct ircd::log::async_record
+{
+	uint32_t len;
+	uint8_t lev;
+	uint8_t dest;
+};
+
+decltype(ircd::log::async_enable)
+ircd::log::async_enable
+{
+	{
+		{ "name",     "ircd.log.async.enable" },
+		{ "default",  false                   },
+		{ "description",
+
+		R"(
+		Write log messages to files and the console from a dedicated thread.
+		The main thread copies each message into a ring buffer and continues;
+		the writer flushes once for all of the messages it takes at a time.
+		Debug messages are dropped when the ring is mostly full; other levels
+		are dropped when it is full, except warnings, errors and critical
+		messages which are then written synchronously. Critical messages are
+		always written synchronously after the messages before them.
+		)"},
+	},
+	[]
+	{
+		if(!async_ready)
+			return;
+
+		if(async_enable)
+			async_start();
+		else
+			async_stop();
+	}
+};
+
+decltype(ircd::log::async_buffer_size)
+ircd::log::async_buffer_size
+{
+	{ "name",     "ircd.log.async.buffer.size" },
+	{ "default",  long(1_MiB)                  },
+};
+
+decltype(ircd::log::async_dropped)
+ircd::log::async_dropped
+{{
+	{ { "name", "ircd.log.critical.dropped" } },
+	{ { "name", "ircd.log.error.dropped"    } },
+	{ { "name", "ircd.log.warning.dropped"  } },
+	{ { "name", "ircd.log.notice.dropped"   } },
+	{ { "name", "ircd.log.info.dropped"     } },
+	{ { "name", "ircd.log.derror.dropped"   } },
+	{ { "name", "ircd.log.dwarning.dropped" } },
+	{ { "name", "ircd.log.debug.dropped"    } },
+}};
+
+ircd::log::async::async()
+{
+	async_ready = true;
+	if(async_enable)
+		async_start();
+}
+
+ircd::log::async::~async()
+noexcept
+{
+	async_ready = false;
+	async_stop();
+}
+
+void
+ircd::log::async_start()
+{
+	assert_main_thread();
+	if(async_running)
+		return;
+
+	async_ring_size = std::max(size_t(async_buffer_size), LOG_BUFSIZE * 8);
+	async_ring.reset(new char[async_ring_size]);
+	async_head.store(0, std::memory_order_relaxed);
+	async_tail.store(0, std::memory_order_relaxed);
+	async_terminate.store(false, std::memory_order_relaxed);
+	async_thread = std::thread(&async_worker);
+	async_running = true;
+}
+
+void
+ircd::log::async_stop()
+noexcept
+{
+	assert_main_thread();
+	if(!async_running)
+		return;
+
+	// Messages from here are written by the main thread again; the writer
+	// drains the ring before it exits.
+	async_running = false;
+	async_terminate.store(true, std::memory_order_release);
+	async_cond.notify_all();
+	async_thread.join();
+	async_ring.reset();
+}
+
+void
+ircd::log::async_worker()
+noexcept
+{
+	std::unique_lock lock
+	{
+		async_mutex
+	};
+
+	// The main thread only notifies when the ring was empty, which can race
+	// with the predicate here; the timeout bounds any lost wakeup.
+	while(!async_terminate.load(std::memory_order_acquire))
+	{
+		async_cond.wait_for(lock, milliseconds(100), []
+		{
+			return async_terminate.load(std::memory_order_acquire)
+			|| async_head.load(std::memory_order_acquire) != async_tail.load(std::memory_order_relaxed);
+		});
+
+		async_drain();
+	}
+
+	async_drain();
+}
+
+/// Copies the message into the ring on the main thread. Returns false to
+/// have the caller write it directly (the writer is not running); all other
+/// messages are either queued, written synchronously or dropped here.
+bool
+ircd::log::async_push(const level &lev,
+                      const uint &dest,
+                      const string_view &msg)
+noexcept
+{
+	if(!async_running)
+		return false;
+
+	assert_main_thread();
+	if(lev == level::CRITICAL)
+	{
+		async_sync(lev, dest, msg);
+		return true;
+	}
+
+	const size_t need
+	{
+		sizeof(async_record) + size(msg)
+	};
+
+	const auto head
+	{
+		async_head.load(std::memory_order_relaxed)
+	};
+
+	const size_t used
+	{
+		head - async_tail.load(std::memory_order_acquire)
+	};
+
+	const bool full
+	{
+		used + need > async_ring_size
+	};
+
+	const bool pressure
+	{
+		used + need > async_ring_size / 4 * 3
+	};
+
+	if(full && lev <= level::WARNING)
+	{
+		async_sync(lev, dest, msg);
+		return true;
+	}
+
+	if(full || (pressure && lev > level::INFO))
+	{
+		++async_dropped.at(lev);
+		return true;
+	}
+
+	const async_record record
+	{
+		uint32_t(size(msg)), uint8_t(lev), uint8_t(dest)
+	};
+
+	async_copy(head, const_buffer{reinterpret_cast<const char *>(&record), sizeof(record)});
+	async_copy(head + sizeof(record), msg);
+	async_head.store(head + need, std::memory_order_release);
+
+	// The writer only sleeps when it finds the ring empty.
+	if(!used)
+		async_cond.notify_one();
+
+	return true;
+}
+
+/// Writes the message after all those in the ring, for messages which must
+/// not be dropped or delayed.
+void
+ircd::log::async_sync(const level &lev,
+                      const uint &dest,
+                      const string_view &msg)
+noexcept
+{
+	const std::lock_guard lock
+	{
+		async_mutex
+	};
+
+	async_drain();
+	async_write(lev, dest, msg);
+	if(dest & ASYNC_FILE)
+		file[lev].flush();
+
+	if(dest & ASYNC_STDOUT)
+		out_console << std::flush;
+}
+
+/// Writes all messages in the ring, flushing each stream once at the end if
+/// any of its messages asked for it. The mutex must be held.
+void
+ircd::log::async_drain()
+noexcept
+{
+	static char buf[LOG_BUFSIZE];
+	std::array<bool, num_of<level>()> flush_file {false};
+	bool flush_stdout {false};
+
+	const auto head
+	{
+		async_head.load(std::memory_order_acquire)
+	};
+
+	auto tail
+	{
+		async_tail.load(std::memory_order_relaxed)
+	};
+
+	while(tail != head)
+	{
+		async_record record;
+		async_read(tail, mutable_buffer{reinterpret_cast<char *>(&record), sizeof(record)});
+		assert(record.len <= sizeof(buf));
+		assert(record.lev < num_of<level>());
+		const mutable_buffer msg
+		{
+			buf, record.len
+		};
+
+		async_read(tail + sizeof(record), msg);
+		tail += sizeof(record) + record.len;
+		async_tail.store(tail, std::memory_order_release);
+
+		const auto lev(level(record.lev));
+		async_write(lev, record.dest, string_view{data(msg), size(msg)});
+		flush_file[lev] |= (record.dest & ASYNC_FILE) && (record.dest & ASYNC_FLUSH);
+		flush_stdout |= (record.dest & ASYNC_STDOUT) && (record.dest & ASYNC_FLUSH);
+	}
+
+	for_each<level>([&flush_file](const level &lev)
+	{
+		if(flush_file[lev])
+			file[lev].flush();
+	});
+
+	if(flush_stdout)
+		out_console << std::flush;
+}
+
+void
+ircd::log::async_write(const level &lev,
+                       const uint &dest,
+                       const string_view &msg)
+noexcept
+{
+	if((dest & ASYNC_FILE) && file[lev].is_open())
+	{
+		file[lev].clear();
+		check(file[lev]);
+		file[lev].write(data(msg), size(msg));
+	}
+
+	if(dest & ASYNC_STDERR)
+	{
+		err_console.clear();
+		check(err_console);
+		err_console.write(data(msg), size(msg));
+	}
+
+	if(dest & ASYNC_STDOUT)
+	{
+		out_console.clear();
+		check(out_console);
+		out_console.write(data(msg), size(msg));
+	}
+}
+
+void
+ircd::log::async_copy(const size_t &pos,
+                      const const_buffer &buf)
+noexcept
+{
+	const size_t off(pos % async_ring_size);
+	const size_t first(std::min(size(buf), async_ring_size - off));
+	memcpy(async_ring.get() + off, data(buf), first);
+	memcpy(async_ring.get(), data(buf) + first, size(buf) - first);
+}
+
+void
+ircd::log::async_read(const size_t &pos,
+                      const mutable_buffer &buf)
+noexcept
+{
+	const size_t off(pos % async_ring_size);
+	const size_t first(std::min(size(buf), async_ring_size - off));
+	memcpy(data(buf), async_ring.get() + off, first);
+	memcpy(data(buf) + first, async_ring.get(), size(buf) - first);
+}
+
 //
 // ircd::log util
 //
@@ -29,6 +29,7 @@ namespace ircd::magick
 	template<class R, class F, class... A> static R call(F&&, A&&...);
 	template<class R, class F, class... A> static R callex(F&&, A&&...);
 	template<class F, class... A> static void callpf(F&&, A&&...);
+	static void offload(const std::function<void ()> &);
 
 	extern bool call_ready;
 	extern ctx::dock call_dock;
@@ -37,6 +38,11 @@ namespace ircd::magick
 	extern conf::item<uint64_t> limit_cycles;
 	extern conf::item<uint64_t> yield_threshold;
 	extern conf::item<uint64_t> yield_interval;
+	extern conf::item<bool> offload_enable;
+	extern conf::item<size_t> offload_jobs;
+	extern conf::item<size_t> offload_queue;
+	extern size_t offload_running, offload_waiting;
+	extern ctx::dock offload_dock;
 	extern log::log log;
 }
 
@@ -89,6 +95,40 @@ ircd::magick::yield_interval
 	{ "default", 768L                         },
 };
 
+decltype(ircd::magick::offload_enable)
+ircd::magick::offload_enable
+{
+	{ "name",    "ircd.magick.offload.enable" },
+	{ "default", true                         },
+};
+
+/// Jobs running at once on ctx::ole threads; their parallelism is also
+/// bound by ircd.ctx.ole.thread.max.
+decltype(ircd::magick::offload_jobs)
+ircd::magick::offload_jobs
+{
+	{ "name",    "ircd.magick.offload.jobs" },
+	{ "default", 2L                         },
+};
+
+/// Jobs allowed to wait for one of the above; beyond this magick::busy is
+/// thrown so the caller can shed the work.
+decltype(ircd::magick::offload_queue)
+ircd::magick::offload_queue
+{
+	{ "name",    "ircd.magick.offload.queue" },
+	{ "default", 8L                          },
+};
+
+decltype(ircd::magick::offload_running)
+ircd::magick::offload_running;
+
+decltype(ircd::magick::offload_waiting)
+ircd::magick::offload_waiting;
+
+decltype(ircd::magick::offload_dock)
+ircd::magick::offload_dock;
+
 // It is likely that we can't have two contexts enter libmagick
 // simultaneously. This race is possible if the progress callback yields
 // and another context starts an operation. It is highly unlikely the lib
@@ -259,7 +299,7 @@ noexcept
 	call_ready = false;
 	call_dock.wait([]
 	{
-		return !call_mutex.locked();
+		return !call_mutex.locked() && !offload_running;
 	});
 
 	DestroyMagick();
@@ -437,6 +477,27 @@ ircd::magick::transform::transform(const const_buffer &input,
                                    const output &output,
                                    const transformer &transformer)
 {
+	// The transformation runs on an offload thread while this context waits;
+	// the result is copied out so the output closure runs back here.
+	if(ctx::current && offload_enable)
+	{
+		unique_buffer<mutable_buffer> result;
+		offload([&input, &transformer, &result]
+		{
+			transform
+			{
+				input, [&result](const const_buffer &buf)
+				{
+					result = unique_buffer<mutable_buffer>{buf};
+				},
+				transformer
+			};
+		});
+
+		output(result);
+		return;
+	}
+
 	const custom_ptr<ImageInfo> input_info
 	{
 		CloneImageInfo(nullptr),
@@ -509,6 +570,64 @@ ircd::magick::display::display(const ImageInfo &info,
 // util (internal)
 //
 
+void
+ircd::magick::offload(const std::function<void ()> &func)
+{
+	assert(ctx::current);
+	if(unlikely(!call_ready))
+		throw error
+		{
+			"Graphics library not ready."
+		};
+
+	const bool wait
+	{
+		offload_running >= size_t(offload_jobs)
+	};
+
+	if(wait && offload_waiting >= size_t(offload_queue))
+		throw busy
+		{
+			"%zu jobs running with %zu waiting.",
+			offload_running,
+			offload_waiting,
+		};
+
+	if(wait)
+	{
+		const scope_count waiting
+		{
+			offload_waiting
+		};
+
+		offload_dock.wait([]
+		{
+			return offload_running < size_t(offload_jobs);
+		});
+	}
+
+	const scope_count running
+	{
+		offload_running
+	};
+
+	const unwind notify{[]
+	{
+		offload_dock.notify_one();
+		call_dock.notify_all();
+	}};
+
+	static const ctx::ole::opts opts
+	{
+		"magick"
+	};
+
+	ctx::offload
+	{
+		opts, func
+	};
+}
+
 template<class return_t,
          class function,
          class... args>
@@ -522,11 +641,6 @@ ircd::magick::callex(function&& f,
 			"Graphics library not ready."
 		};
 
-	const std::lock_guard lock
-	{
-		call_mutex
-	};
-
 	ExceptionInfo ei;
 	GetExceptionInfo(&ei); // initializer
 	const unwind destroy{[&ei]
@@ -534,6 +648,30 @@ ircd::magick::callex(function&& f,
 		DestroyExceptionInfo(&ei);
 	}};
 
+	// On an offload thread there's no ircd::ctx to hold the mutex, and the
+	// error handler is global to all threads; the exception is inspected
+	// here instead.
+	if(!ctx::current)
+	{
+		const auto ret
+		{
+			f(std::forward<args>(a)..., &ei)
+		};
+
+		if(ei.severity >= ErrorException)
+			handle_exception(ei.severity, ei.reason?: "", ei.description?: "");
+
+		if(ei.severity >= WarningException)
+			handle_warning(ei.severity, ei.reason?: "", ei.description?: "");
+
+		return ret;
+	}
+
+	const std::lock_guard lock
+	{
+		call_mutex
+	};
+
 	assert(call_ready);
 	const auto ret
 	{
@@ -628,7 +766,9 @@ noexcept try
 	// and monotonically increases across jobs as well.
 	const auto cycles_sample
 	{
-		ctx::this_ctx::cycles()
+		ctx::current?
+			ctx::this_ctx::cycles():
+			prof::cycles()
 	};
 
 	// Detect if this is a new job. Tick is usually zero for a new job, but for
@@ -739,6 +879,10 @@ ircd::magick::check_cycles(job &job)
 bool
 ircd::magick::check_yield(job &job)
 {
+	// Offloaded jobs have their own thread and nothing to yield to.
+	if(!ctx::current)
+		return false;
+
 	const uint64_t &yield_threshold
 	{
 		magick::yield_threshold
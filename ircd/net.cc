@@ -15,6 +15,8 @@ namespace ircd::net
 
 	static void init_ipv6();
 	static void wait_close_sockets();
+	static bool ssl_session_load(socket &, const string_view &name) noexcept;
+	static void ssl_session_save(socket &) noexcept;
 }
 
 void
@@ -686,6 +688,13 @@ ircd::net::open_opts::default_connect_timeout
 	{ "default",  7500L                            },
 };
 
+decltype(ircd::net::open_opts::default_race_delay)
+ircd::net::open_opts::default_race_delay
+{
+	{ "name",     "ircd.net.open.race_delay"  },
+	{ "default",  250L                        },
+};
+
 decltype(ircd::net::open_opts::default_handshake_timeout)
 ircd::net::open_opts::default_handshake_timeout
 {
@@ -776,6 +785,9 @@ ircd::net::open(socket &socket,
 			return complete(std::move(eptr));
 
 		const auto ep{make_endpoint(ipport)};
+		if(opts.ipport_alt)
+			return socket.connect(ep, make_endpoint(opts.ipport_alt), opts, std::move(complete));
+
 		socket.connect(ep, opts, std::move(complete));
 	}};
 
@@ -1214,12 +1226,129 @@ ircd::net::ssl_cipher_blacklist
 	{ "default",  string_view{}                   },
 };
 
+decltype(ircd::net::ssl_session_cache_enable)
+ircd::net::ssl_session_cache_enable
+{
+	{ "name",     "ircd.net.ssl.session.cache.enable" },
+	{ "default",  true                                },
+	{ "help",     "Resume TLS sessions with servers we have connected to before." },
+};
+
+decltype(ircd::net::ssl_session_cache_max)
+ircd::net::ssl_session_cache_max
+{
+	{ "name",     "ircd.net.ssl.session.cache.max" },
+	{ "default",  4096L                            },
+};
+
+/// Client sessions (DER) keyed by the server name sent with SNI.
+decltype(ircd::net::ssl_session_cache)
+ircd::net::ssl_session_cache;
+
 boost::asio::ssl::context
 ircd::net::sslv23_client
 {
 	boost::asio::ssl::context::method::sslv23_client
 };
 
+bool
+ircd::net::ssl_session_load(socket &socket,
+                            const string_view &name)
+noexcept try
+{
+	if(!ssl_session_cache_enable)
+		return false;
+
+	const auto it
+	{
+		ssl_session_cache.find(name)
+	};
+
+	if(it == end(ssl_session_cache))
+		return false;
+
+	SSL &ssl(socket);
+	if(openssl::set_session(ssl, const_buffer{it->second}))
+		return true;
+
+	ssl_session_cache.erase(it);
+	return false;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s session resumption for '%s' :%s",
+		loghead(socket),
+		name,
+		e.what(),
+	};
+
+	return false;
+}
+
+/// Sessions are saved when the connection is closed rather than after the
+/// handshake because TLS 1.3 tickets are only received afterward.
+void
+ircd::net::ssl_session_save(socket &socket)
+noexcept try
+{
+	if(!ssl_session_cache_enable)
+		return;
+
+	SSL &ssl(socket);
+	const string_view name
+	{
+		openssl::server_name(ssl)
+	};
+
+	if(!name)
+		return;
+
+	thread_local char buf[8_KiB];
+	const const_buffer der
+	{
+		openssl::get_session(buf, ssl)
+	};
+
+	if(empty(der))
+		return;
+
+	auto it
+	{
+		ssl_session_cache.lower_bound(name)
+	};
+
+	if(it != end(ssl_session_cache) && it->first == name)
+	{
+		it->second.assign(data(der), size(der));
+		return;
+	}
+
+	// Arbitrary eviction when full.
+	if(ssl_session_cache.size() >= size_t(ssl_session_cache_max))
+	{
+		if(it == end(ssl_session_cache))
+			it = begin(ssl_session_cache);
+
+		if(it == end(ssl_session_cache))
+			return;
+
+		it = ssl_session_cache.erase(it);
+	}
+
+	ssl_session_cache.emplace_hint(it, std::string{name}, std::string{data(der), size(der)});
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s session save :%s",
+		loghead(socket),
+		e.what(),
+	};
+}
+
 decltype(ircd::net::socket::count)
 ircd::net::socket::count
 {};
@@ -1234,6 +1363,12 @@ ircd::net::socket::desc_connect
 	"ircd.net.socket.connect"
 };
 
+decltype(ircd::net::socket::desc_race)
+ircd::net::socket::desc_race
+{
+	"ircd.net.socket.race"
+};
+
 decltype(ircd::net::socket::desc_handshake)
 ircd::net::socket::desc_handshake
 {
@@ -1373,6 +1508,177 @@ ircd::net::socket::connect(const endpoint &ep,
 	sd.async_connect(ep, ios::handle(desc_connect, std::move(connect_handler)));
 }
 
+/// State of a connection race between two addresses (RFC 8305). The
+/// alternate is attempted on its own descriptor after the race_delay, or as
+/// soon as the primary fails; the first to connect is kept by the socket.
+struct ircd::net::socket::race
+{
+	ip::tcp::socket sd;
+	steady_timer timer;
+	endpoint alt;
+	open_opts opts;
+	eptr_handler callback;
+	error_code ec;                               // first failure
+	uint8_t pending {1};                         // attempts in flight
+	bool started {false};                        // alternate attempted
+	bool done {false};                           // result decided
+
+	race(const endpoint &alt, const open_opts &opts, eptr_handler callback)
+	:sd{ios::get()}
+	,timer{ios::get()}
+	,alt{alt}
+	,opts{opts}
+	,callback{std::move(callback)}
+	{}
+};
+
+void
+ircd::net::socket::connect(const endpoint &ep,
+                           const endpoint &alt,
+                           const open_opts &opts,
+                           eptr_handler callback)
+{
+	char epbuf[2][128];
+	log::debug
+	{
+		log, "socket:%lu attempting connect remote[%s] racing [%s] after %ld$ms to:%ld$ms",
+		this->id,
+		string(epbuf[0], ep),
+		string(epbuf[1], alt),
+		opts.race_delay.count(),
+		opts.connect_timeout.count()
+	};
+
+	const auto r
+	{
+		std::make_shared<race>(alt, opts, std::move(callback))
+	};
+
+	// The connect timeout covers the race as a whole; the primary attempt
+	// is canceled by the timer itself and the alternate is canceled here.
+	set_timeout(opts.connect_timeout, [r](const error_code &ec)
+	{
+		if(ec)
+			return;
+
+		boost::system::error_code ec_;
+		r->timer.cancel(ec_);
+		r->sd.close(ec_);
+	});
+
+	auto race_handler
+	{
+		std::bind(&socket::handle_race, this, weak_from(*this), r, false, ph::_1)
+	};
+
+	sd.async_connect(ep, ios::handle(desc_connect, std::move(race_handler)));
+
+	auto delay_handler{[this, wp(weak_from(*this)), r]
+	(const error_code &ec)
+	{
+		if(!ec && !wp.expired())
+			race_alt(wp, r);
+	}};
+
+	r->timer.expires_from_now(opts.race_delay);
+	r->timer.async_wait(ios::handle(desc_race, std::move(delay_handler)));
+}
+
+void
+ircd::net::socket::race_alt(std::weak_ptr<socket> wp,
+                            std::shared_ptr<race> r)
+{
+	if(r->done || r->started || timedout || fini)
+		return;
+
+	char epbuf[128];
+	log::debug
+	{
+		log, "socket:%lu racing connect remote[%s]",
+		this->id,
+		string(epbuf, r->alt),
+	};
+
+	auto race_handler
+	{
+		std::bind(&socket::handle_race, this, wp, r, true, ph::_1)
+	};
+
+	r->started = true;
+	++r->pending;
+	r->sd.async_connect(r->alt, ios::handle(desc_connect, std::move(race_handler)));
+}
+
+void
+ircd::net::socket::handle_race(std::weak_ptr<socket> wp,
+                               std::shared_ptr<race> r,
+                               const bool &alt,
+                               error_code ec)
+noexcept try
+{
+	using std::errc;
+
+	if(unlikely(wp.expired()))
+		return;
+
+	assert(r->pending > 0);
+	--r->pending;
+	if(r->done)
+		return;
+
+	boost::system::error_code ec_;
+	if(!ec && fini)
+		ec = make_error_code(errc::operation_canceled);
+
+	// The winner is decided here; the other attempt is abandoned. When the
+	// alternate wins its descriptor is moved into this socket.
+	if(!ec)
+	{
+		r->done = true;
+		r->timer.cancel(ec_);
+		if(alt)
+		{
+			sd.close(ec_);
+			sd = std::move(r->sd);
+		}
+		else r->sd.close(ec_);
+
+		return handle_connect(wp, r->opts, std::move(r->callback), ec);
+	}
+
+	if(!r->ec)
+		r->ec = ec;
+
+	// The primary failed before the delay; start the alternate at once.
+	if(!alt && !r->started && !timedout && !fini)
+	{
+		r->timer.cancel(ec_);
+		return race_alt(wp, r);
+	}
+
+	if(fini)
+		r->sd.close(ec_);
+
+	// The other attempt is still in flight.
+	if(r->pending)
+		return;
+
+	r->done = true;
+	r->timer.cancel(ec_);
+	handle_connect(wp, r->opts, std::move(r->callback), r->ec);
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "socket(%p) handle_race :%s",
+		this,
+		e.what()
+	};
+
+	assert(0);
+}
+
 void
 ircd::net::socket::handshake(const open_opts &opts,
                              eptr_handler callback)
@@ -1405,7 +1711,13 @@ ircd::net::socket::handshake(const open_opts &opts,
 	set_timeout(opts.handshake_timeout);
 
 	if(opts.send_sni && server_name(opts))
+	{
 		openssl::server_name(*this, server_name(opts));
+		ssl_session_load(*this, server_name(opts));
+	}
+
+	if(!empty(opts.alpn))
+		openssl::set_alpn(*this, opts.alpn);
 
 	ssl.set_verify_callback(std::move(verify_handler));
 	ssl.async_handshake(handshake_type::client, ios::handle(desc_handshake, std::move(handshake_handler)));
@@ -1435,6 +1747,7 @@ try
 	cancel();
 	assert(!fini);
 	fini = true;
+	ssl_session_save(*this);
 
 	if(opts.sopts)
 		set(*this, *opts.sopts);
@@ -1757,6 +2070,7 @@ try
 	in.bytes += ret;
 	++total_calls_in;
 	total_bytes_in += ret;
+	ctx::prof::account(ctx::prof::event::NET_READ, ret);
 	return ret;
 }
 catch(const boost::system::system_error &e)
@@ -1796,6 +2110,7 @@ try
 	in.bytes += ret;
 	++total_calls_in;
 	total_bytes_in += ret;
+	ctx::prof::account(ctx::prof::event::NET_READ, ret);
 	return ret;
 }
 catch(const boost::system::system_error &e)
@@ -1825,6 +2140,7 @@ ircd::net::socket::read_any(iov&& bufs)
 	in.bytes += ret;
 	++total_calls_in;
 	total_bytes_in += ret;
+	ctx::prof::account(ctx::prof::event::NET_READ, ret);
 
 	if(likely(!ec))
 		return ret;
@@ -1853,6 +2169,7 @@ ircd::net::socket::read_one(iov&& bufs)
 	in.bytes += ret;
 	++total_calls_in;
 	total_bytes_in += ret;
+	ctx::prof::account(ctx::prof::event::NET_READ, ret);
 
 	if(likely(!ec))
 		return ret;
@@ -1896,6 +2213,7 @@ try
 	out.bytes += ret;
 	++total_calls_out;
 	total_bytes_out += ret;
+	ctx::prof::account(ctx::prof::event::NET_WRITE, ret);
 	return ret;
 }
 catch(const boost::system::system_error &e)
@@ -1930,6 +2248,7 @@ try
 	out.bytes += ret;
 	++total_calls_out;
 	total_bytes_out += ret;
+	ctx::prof::account(ctx::prof::event::NET_WRITE, ret);
 	return ret;
 }
 catch(const boost::system::system_error &e)
@@ -1959,6 +2278,7 @@ try
 	out.bytes += ret;
 	++total_calls_out;
 	total_bytes_out += ret;
+	ctx::prof::account(ctx::prof::event::NET_WRITE, ret);
 	return ret;
 }
 catch(const boost::system::system_error &e)
@@ -1983,6 +2303,7 @@ try
 	out.bytes += ret;
 	++total_calls_out;
 	total_bytes_out += ret;
+	ctx::prof::account(ctx::prof::event::NET_WRITE, ret);
 	return ret;
 }
 catch(const boost::system::system_error &e)
@@ -2317,11 +2638,12 @@ noexcept try
 	char ecbuf[64];
 	log::debug
 	{
-		log, "%s handshake cipher:%s %s",
+		log, "%s handshake cipher:%s resumed:%b %s",
 		loghead(*this),
 		current_cipher?
 			openssl::name(*current_cipher):
 			"<NO CIPHER>"_sv,
+		!ec && openssl::session_reused(*this),
 		string(ecbuf, ec)
 	};
 	#endif
@@ -2330,6 +2652,10 @@ noexcept try
 	if(!ec)
 		blocking(*this, false);
 
+	// Note the application protocol the server selected, if any.
+	if(!ec)
+		strlcpy(alpn, openssl::get_alpn(*this));
+
 	// This is the end of the asynchronous call chain; the user is called
 	// back with or without error here.
 	call_user(callback, ec);
@@ -257,28 +257,67 @@ ircd::net::dns::resolver::sendq_work()
 
 	assert(sendq.size() < 65535);
 	assert(sendq.size() <= tags.size());
-	const uint16_t next(sendq.front());
-	sendq.pop_front();
-	flush(next);
-}
 
-void
-ircd::net::dns::resolver::flush(const uint16_t &next)
-try
-{
-	auto &tag
+	// Each wakeup of the worker drains up to a burst of queued queries which
+	// are then transmitted together.
+	const size_t burst
 	{
-		tags.at(next)
+		std::clamp(size_t(send_burst), 1UL, BATCH_MAX)
 	};
 
-	submit(tag);
+	size_t count(0);
+	tag *batch[BATCH_MAX];
+	while(!sendq.empty() && count < burst)
+	{
+		const uint16_t next(sendq.front());
+		sendq.pop_front();
+
+		const auto it
+		{
+			tags.find(next)
+		};
+
+		if(unlikely(it == end(tags)))
+		{
+			log::error
+			{
+				log, "Queued tag id[%u] is no longer mapped", next
+			};
+
+			continue;
+		}
+
+		batch[count++] = &it->second;
+	}
+
+	flush(vector_view<tag *>(batch, count));
 }
-catch(const std::out_of_range &e)
+
+void
+ircd::net::dns::resolver::flush(const vector_view<tag *> &batch)
 {
-	log::error
+	if(unlikely(!ns.is_open() || server.empty()))
 	{
-		log, "Queued tag id[%u] is no longer mapped", next
+		for(auto *const &tag : batch)
+			queue_query(*tag);
+
+		return;
+	}
+
+	const size_t sent
+	{
+		send_queries(batch)
 	};
+
+	// Anything the socket didn't take goes back to the front of the queue in
+	// the same order to be tried on the next pass.
+	for(size_t i(batch.size()); i > sent; --i)
+	{
+		batch[i - 1]->last = steady_point::min();
+		sendq.emplace_front(batch[i - 1]->id);
+	}
+
+	dock.notify_all();
 }
 
 void
@@ -484,6 +523,101 @@ catch(const std::exception &e)
 	throw;
 }
 
+/// Transmit the batch of queries with as few syscalls as possible. Each tag
+/// is sent to the next server in the round-robin. Returns the number of
+/// tags at the front of the batch which were handed to the socket; the rest
+/// were refused with -EAGAIN and should be requeued by the caller.
+size_t
+ircd::net::dns::resolver::send_queries(const vector_view<tag *> &batch)
+{
+	assert(!server.empty());
+	assert(batch.size() <= BATCH_MAX);
+	const ctx::uninterruptible::nothrow ui;
+
+	#if defined(HAVE_SENDMMSG)
+	struct ::iovec iov[BATCH_MAX];
+	struct ::mmsghdr msg[BATCH_MAX] {};
+	const ip::udp::endpoint *ep[BATCH_MAX];
+	for(size_t i(0); i < batch.size(); ++i)
+	{
+		auto &tag(*batch[i]);
+		assert(!empty(tag.question));
+		++server_next %= server.size();
+		ep[i] = &server.at(server_next);
+		iov[i].iov_base = const_cast<char *>(data(tag.question));
+		iov[i].iov_len = size(tag.question);
+		msg[i].msg_hdr.msg_name = const_cast<sockaddr *>(ep[i]->data());
+		msg[i].msg_hdr.msg_namelen = ep[i]->size();
+		msg[i].msg_hdr.msg_iov = iov + i;
+		msg[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	const int ret
+	{
+		::sendmmsg(ns.native_handle(), msg, batch.size(), MSG_DONTWAIT)
+	};
+
+	const bool again
+	{
+		ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)
+	};
+
+	if(unlikely(ret < 0 && !again))
+	{
+		// The whole batch is considered sent so the timeout worker will
+		// retry each tag as if the datagrams were lost.
+		const std::error_code ec
+		{
+			errno, std::system_category()
+		};
+
+		log::error
+		{
+			log, "send %zu tags to %zu servers :%s",
+			batch.size(),
+			server.size(),
+			ec.message(),
+		};
+	}
+
+	const size_t sent
+	{
+		ret < 0? (again? 0UL: batch.size()): size_t(ret)
+	};
+
+	send_last = now<steady_point>();
+	for(size_t i(0); i < sent; ++i)
+	{
+		auto &tag(*batch[i]);
+		tag.last = send_last;
+		tag.server = make_ipport(*ep[i]);
+		tag.tries++;
+
+		#ifdef RB_DEBUG
+		char buf[128];
+		log::debug
+		{
+			log, "send tag:%u qtype:%u t:%u `%s' to %s (batch %zu of %zu)",
+			tag.id,
+			tag.opts.qtype,
+			tag.tries,
+			host(tag.hp),
+			string(buf, tag.server),
+			i + 1,
+			batch.size(),
+		};
+		#endif
+	}
+
+	return sent;
+	#else
+	for(auto *const &tag : batch)
+		send_query(*tag);
+
+	return batch.size();
+	#endif
+}
+
 //
 // recv
 //
@@ -492,19 +626,25 @@ void
 ircd::net::dns::resolver::recv_worker()
 try
 {
+	// Each slot receives one datagram; replies to our queries are far
+	// smaller than this without EDNS.
 	const unique_buffer<mutable_buffer> buf
 	{
-		64_KiB
+		BATCH_MAX * 4_KiB
 	};
 
 	while(ns.is_open()) try
 	{
-		const auto &[from, reply]
+		ipport from[BATCH_MAX];
+		mutable_buffer reply[BATCH_MAX];
+		const size_t count
 		{
-			recv_recv(buf)
+			recv_recv(buf, from, reply)
 		};
 
-		handle(from, reply);
+		for(size_t i(0); i < count; ++i)
+			if(likely(!empty(reply[i])))
+				handle(from[i], reply[i]);
 	}
 	catch(const boost::system::system_error &e)
 	{
@@ -526,9 +666,100 @@ catch(const std::exception &e)
 	};
 }
 
-std::tuple<ircd::net::ipport, ircd::mutable_buffer>
-ircd::net::dns::resolver::recv_recv(const mutable_buffer &buf)
+/// Receive as many datagrams as are queued on the socket, up to the number
+/// of slots, in one syscall. The buffer is divided evenly into the slots.
+/// When nothing is queued recv_idle is asserted while the context waits for
+/// the socket to become readable. Returns the number of slots filled.
+size_t
+ircd::net::dns::resolver::recv_recv(const mutable_buffer &buf,
+                                    const vector_view<ipport> &from,
+                                    const vector_view<mutable_buffer> &reply)
 {
+	const size_t slots
+	{
+		std::min({from.size(), reply.size(), BATCH_MAX})
+	};
+
+	assert(slots > 0);
+	const size_t slot_size
+	{
+		size(buf) / slots
+	};
+
+	const auto interruption
+	{
+		std::bind(&resolver::handle_interrupt, this, ph::_1)
+	};
+
+	#if defined(HAVE_RECVMMSG)
+	ip::udp::endpoint ep[BATCH_MAX];
+	struct ::iovec iov[BATCH_MAX];
+	struct ::mmsghdr msg[BATCH_MAX] {};
+	for(size_t i(0); i < slots; ++i)
+	{
+		iov[i].iov_base = data(buf) + i * slot_size;
+		iov[i].iov_len = slot_size;
+		msg[i].msg_hdr.msg_name = ep[i].data();
+		msg[i].msg_hdr.msg_namelen = ep[i].capacity();
+		msg[i].msg_hdr.msg_iov = iov + i;
+		msg[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	// First try a non-blocking receive to find and return anything in the
+	// queue. If this comes back as -EAGAIN we'll assert recv_idle and then
+	// wait for the socket to be readable before trying again.
+	int ret;
+	while((ret = ::recvmmsg(ns.native_handle(), msg, slots, MSG_DONTWAIT, nullptr)) < 0)
+	{
+		if(errno != EAGAIN && errno != EWOULDBLOCK)
+			throw std::system_error
+			{
+				errno, std::system_category()
+			};
+
+		const scope_restore recv_idle
+		{
+			this->recv_idle, true
+		};
+
+		continuation
+		{
+			continuation::asio_predicate, interruption, [this]
+			(auto &yield)
+			{
+				ns.async_wait(ip::udp::socket::wait_read, yield);
+			}
+		};
+	}
+
+	assert(size_t(ret) <= slots);
+	for(size_t i(0); i < size_t(ret); ++i)
+	{
+		ep[i].resize(msg[i].msg_hdr.msg_namelen);
+		from[i] = make_ipport(ep[i]);
+		reply[i] = mutable_buffer
+		{
+			data(buf) + i * slot_size, msg[i].msg_len
+		};
+
+		// A truncated reply can't be parsed; it's dropped here and the tag
+		// will be retried by the timeout worker.
+		if(unlikely(msg[i].msg_hdr.msg_flags & MSG_TRUNC))
+		{
+			char pbuf[128];
+			log::derror
+			{
+				log, "recv truncated reply of %zu bytes from %s",
+				size(reply[i]),
+				string(pbuf, from[i]),
+			};
+
+			reply[i] = {};
+		}
+	}
+
+	return ret;
+	#else
 	static const ip::udp::socket::message_flags flags
 	{
 		0
@@ -536,7 +767,7 @@ ircd::net::dns::resolver::recv_recv(const mutable_buffer &buf)
 
 	const asio::mutable_buffers_1 bufs
 	{
-		buf
+		mutable_buffer{data(buf), slot_size}
 	};
 
 	// First try a non-blocking receive to find and return anything in the
@@ -560,11 +791,6 @@ ircd::net::dns::resolver::recv_recv(const mutable_buffer &buf)
 			this->recv_idle, true
 		};
 
-		const auto interruption
-		{
-			std::bind(&resolver::handle_interrupt, this, ph::_1)
-		};
-
 		continuation
 		{
 			continuation::asio_predicate, interruption, [this, &bufs, &recv, &ep]
@@ -575,13 +801,14 @@ ircd::net::dns::resolver::recv_recv(const mutable_buffer &buf)
 		};
 	}
 
-	return
+	from[0] = make_ipport(ep);
+	reply[0] = mutable_buffer
 	{
-		make_ipport(ep), mutable_buffer
-		{
-			data(buf), recv
-		}
+		data(buf), recv
 	};
+
+	return 1;
+	#endif
 }
 
 void
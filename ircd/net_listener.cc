@@ -42,10 +42,12 @@ ircd::net::allow(acceptor &a)
 	if(unlikely(!a.a.is_open()))
 		return false;
 
-	if(a.accepting > 0)
+	if(a.accepting >= size_t(a.accepting_max))
 		return false;
 
-	a.set_handle();
+	while(a.accepting < size_t(a.accepting_max))
+		a.set_handle();
+
 	return true;
 }
 
@@ -246,6 +248,25 @@ ircd::net::acceptor::timeout
 };
 
 /// The number of simultaneous handshakes we conduct across all clients.
+decltype(ircd::net::acceptor::http2_enable)
+ircd::net::acceptor::http2_enable
+{
+	{ "name",     "ircd.net.acceptor.http2.enable" },
+	{ "default",  false                            },
+	{ "help",     "Select h2 when offered with ALPN by clients." },
+};
+
+/// The number of accepts kept outstanding on the listener socket. While the
+/// kernel's queue is deep (e.g. clients reconnecting together after a
+/// restart) this many connections are taken from it on each pass of the
+/// event loop rather than one.
+decltype(ircd::net::acceptor::accepting_max)
+ircd::net::acceptor::accepting_max
+{
+	{ "name",     "ircd.net.acceptor.accepting.max" },
+	{ "default",  16L                               },
+};
+
 decltype(ircd::net::acceptor::handshaking_max)
 ircd::net::acceptor::handshaking_max
 {
@@ -379,10 +400,21 @@ ircd::net::acceptor::open()
 		true
 	};
 
+	// Allows several listener sockets to be bound to this address, each with
+	// its own queue the kernel distributes connections over; e.g. another
+	// instance sharing the port.
+	static const asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port
+	{
+		true
+	};
+
 	assert(!interrupting);
 	interrupting = false;
 	a.open(ep.protocol());
 	a.set_option(reuse_address);
+	if(json::object(opts).get<bool>("reuseport", false))
+		a.set_option(reuse_port);
+
 	a.non_blocking(true);
 	log::debug
 	{
@@ -523,7 +555,6 @@ noexcept try
 {
 	assert(bool(sock));
 	assert(accepting > 0);
-	assert(accepting == 1); // for now
 	char ecbuf[64];
 	log::debug
 	{
@@ -853,7 +884,15 @@ ircd::net::acceptor::handle_alpn(socket &socket,
 	}
 	#endif IRCD_NET_ACCEPTOR_DEBUG_ALPN
 
-	//NOTE: proto == "h2" condition goes here
+	// HTTP/2 is preferred over HTTP/1.1 regardless of the client's order.
+	if(http2_enable)
+		for(const auto &proto : in)
+			if(proto == http2::alpn)
+			{
+				strlcpy(socket.alpn, proto);
+				return proto;
+			}
+
 	for(const auto &proto : in)
 		if(proto == "http/1.1")
 		{
@@ -1111,6 +1150,18 @@ ircd::net::acceptor::configure_flags(const json::object &opts)
 		flags |= ssl.no_tlsv1_2;
 
 	ssl.set_options(flags);
+
+	// Our cipher order is used rather than the client's, so suites with
+	// hardware acceleration on this host (AES-GCM) are selected first.
+	if(opts.get<bool>("ssl_cipher_server_preference", true))
+		SSL_CTX_set_options(ssl.native_handle(), SSL_OP_CIPHER_SERVER_PREFERENCE);
+
+	// Except when the client lists ChaCha20 first, which indicates it has
+	// no AES acceleration of its own; then ChaCha20 is chosen for it.
+	#ifdef SSL_OP_PRIORITIZE_CHACHA
+	if(opts.get<bool>("ssl_prioritize_chacha", true))
+		SSL_CTX_set_options(ssl.native_handle(), SSL_OP_PRIORITIZE_CHACHA);
+	#endif
 }
 
 void
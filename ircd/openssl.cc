@@ -96,6 +96,135 @@ ircd::openssl::server_name(const SSL &ssl)
 	return ::SSL_get_servername(&ssl, type);
 }
 
+//
+// Session
+//
+
+/// Serialize the session of a client connection for resumption of another
+/// connection later. Empty if the session is not resumable, the buffer is
+/// too small, or this is the server side of the connection.
+ircd::const_buffer
+ircd::openssl::get_session(const mutable_buffer &out,
+                           const SSL &ssl)
+{
+	if(::SSL_is_server(const_cast<SSL *>(&ssl)))
+		return {};
+
+	const SSL_SESSION *const sess
+	{
+		::SSL_get_session(&ssl)
+	};
+
+	if(!sess)
+		return {};
+
+	#if OPENSSL_VERSION_NUMBER >= 0x10101000L && !defined(LIBRESSL_VERSION_NUMBER)
+	if(!::SSL_SESSION_is_resumable(sess))
+		return {};
+	#endif
+
+	const int len
+	{
+		::i2d_SSL_SESSION(const_cast<SSL_SESSION *>(sess), nullptr)
+	};
+
+	if(len <= 0 || size_t(len) > size(out))
+		return {};
+
+	auto *ptr
+	{
+		reinterpret_cast<uint8_t *>(data(out))
+	};
+
+	const int ret
+	{
+		::i2d_SSL_SESSION(const_cast<SSL_SESSION *>(sess), &ptr)
+	};
+
+	return const_buffer
+	{
+		data(out), size_t(std::max(ret, 0))
+	};
+}
+
+/// Offer a session serialized by get_session() for resumption on a client
+/// connection before the handshake. False if it could not be used.
+bool
+ircd::openssl::set_session(SSL &ssl,
+                           const const_buffer &der)
+{
+	const auto *ptr
+	{
+		reinterpret_cast<const uint8_t *>(data(der))
+	};
+
+	SSL_SESSION *const sess
+	{
+		::d2i_SSL_SESSION(nullptr, &ptr, size(der))
+	};
+
+	if(!sess)
+		return false;
+
+	const int ret
+	{
+		::SSL_set_session(&ssl, sess)
+	};
+
+	::SSL_SESSION_free(sess);
+	return ret == 1;
+}
+
+bool
+ircd::openssl::session_reused(const SSL &ssl)
+{
+	return ::SSL_session_reused(const_cast<SSL *>(&ssl));
+}
+
+//
+// ALPN
+//
+
+/// Offer application protocols in the ClientHello.
+void
+ircd::openssl::set_alpn(SSL &ssl,
+                        const vector_view<const string_view> &protos)
+{
+	uint8_t buf[128];
+	size_t len(0);
+	for(const auto &proto : protos)
+	{
+		if(unlikely(empty(proto) || size(proto) > 255 || len + 1 + size(proto) > sizeof(buf)))
+			throw error
+			{
+				"Cannot offer ALPN protocol '%s'", proto
+			};
+
+		buf[len++] = uint8_t(size(proto));
+		len += copy(mutable_buffer{reinterpret_cast<char *>(buf + len), sizeof(buf) - len}, proto);
+	}
+
+	// Note this function is unconventional and returns zero on success.
+	if(unlikely(::SSL_set_alpn_protos(&ssl, buf, len) != 0))
+		throw error
+		{
+			"Failed to set ALPN protocols"
+		};
+}
+
+/// The application protocol selected by the server; empty if none.
+ircd::string_view
+ircd::openssl::get_alpn(const SSL &ssl)
+{
+	const unsigned char *data {nullptr};
+	unsigned int len {0};
+	::SSL_get0_alpn_selected(&ssl, &data, &len);
+	return string_view
+	{
+		reinterpret_cast<const char *>(data), len
+	};
+}
+
 //
 // Cipher suite
 //
@@ -31,6 +31,53 @@ ircd::prof::psi::supported
 };
 #endif
 
+#ifndef __linux__
+decltype(ircd::prof::sampler::active)
+ircd::prof::sampler::active;
+
+decltype(ircd::prof::sampler::samples)
+ircd::prof::sampler::samples;
+
+decltype(ircd::prof::sampler::lost)
+ircd::prof::sampler::lost;
+
+decltype(ircd::prof::sampler::label)
+ircd::prof::sampler::label;
+
+void
+ircd::prof::sampler::start(const uint32_t &freq)
+{
+	throw error
+	{
+		"The sampler is not supported on this platform."
+	};
+}
+
+void
+ircd::prof::sampler::stop()
+noexcept
+{
+}
+
+void
+ircd::prof::sampler::clear()
+noexcept
+{
+}
+
+void
+ircd::prof::sampler::drain(const string_view &frame)
+noexcept
+{
+}
+
+bool
+ircd::prof::sampler::for_each(const folded_closure &closure)
+{
+	return true;
+}
+#endif
+
 uint64_t
 ircd::prof::time_real()
 noexcept
@@ -18,6 +18,7 @@ static_assert
 #include <RB_INC_SYS_IOCTL_H
 #include <RB_INC_SYS_MMAN_H
 #include <RB_INC_SYS_RESOURCE_H
+#include <RB_INC_DLFCN_H
 #include <linux/perf_event.h>
 
 #ifndef __clang__
@@ -191,6 +192,325 @@ const
 	return retired;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// prof/sampler.h
+//
+
+namespace ircd::prof::sampler
+{
+	struct ring;
+
+	static void copy(const ring &, const mutable_buffer &, const uint64_t &pos) noexcept;
+
+	extern conf::item<size_t> freq;
+	extern conf::item<size_t> pages;
+	static std::unique_ptr<ring> _ring;
+	static std::map<std::string, std::map<uint64_t, uint64_t>, std::less<>> folded;
+}
+
+/// The software task-clock of the main thread in sampling mode; the kernel
+/// writes records into the pages after the first page of the map.
+struct ircd::prof::sampler::ring
+{
+	perf_event_attr attr;
+	fs::fd fd;
+	size_t map_size {0};
+	char *map {nullptr};
+	perf_event_mmap_page *head {nullptr};
+	const_buffer body;
+
+	ring(const uint32_t &freq, const size_t &pages);
+	ring(ring &&) = delete;
+	ring(const ring &) = delete;
+	~ring() noexcept;
+};
+
+decltype(ircd::prof::sampler::freq)
+ircd::prof::sampler::freq
+{
+	{ "name",     "ircd.prof.sampler.freq" },
+	{ "default",  99L                      },
+	{ "description",
+
+	R"(
+	Samples per second of CPU time on the main thread when the sampler is
+	started without a frequency.
+	)"},
+};
+
+decltype(ircd::prof::sampler::pages)
+ircd::prof::sampler::pages
+{
+	{ "name",     "ircd.prof.sampler.pages" },
+	{ "default",  16L                       },
+	{ "description",
+
+	R"(
+	Pages of the sample ring (a power of two). The ring is drained after each
+	handler so it only has to hold the samples of one slice.
+	)"},
+};
+
+decltype(ircd::prof::sampler::active)
+ircd::prof::sampler::active;
+
+decltype(ircd::prof::sampler::samples)
+ircd::prof::sampler::samples;
+
+decltype(ircd::prof::sampler::lost)
+ircd::prof::sampler::lost;
+
+decltype(ircd::prof::sampler::label)
+ircd::prof::sampler::label;
+
+void
+ircd::prof::sampler::start(const uint32_t &freq_)
+{
+	const uint32_t freq
+	{
+		freq_?: uint32_t(sampler::freq)
+	};
+
+	stop();
+	_ring = std::make_unique<ring>(freq, pages);
+	syscall(::ioctl, int(_ring->fd), PERF_EVENT_IOC_ENABLE, 0);
+	active = true;
+
+	log::info
+	{
+		log, "Sampler started at %u Hz with %zu KiB ring",
+		freq,
+		size(_ring->body) / 1024,
+	};
+}
+
+void
+ircd::prof::sampler::stop()
+noexcept
+{
+	if(!_ring)
+		return;
+
+	::ioctl(int(_ring->fd), PERF_EVENT_IOC_DISABLE, 0);
+	drain("*");
+	active = false;
+	_ring.reset();
+
+	log::info
+	{
+		log, "Sampler stopped; samples:%lu lost:%lu",
+		samples,
+		lost,
+	};
+}
+
+void
+ircd::prof::sampler::clear()
+noexcept
+{
+	folded.clear();
+	samples = 0;
+	lost = 0;
+}
+
+/// Attributes the samples in the ring to the frame (the name of the ctx or
+/// of the handler) and the label supplied by the upper layer.
+void
+ircd::prof::sampler::drain(const string_view &frame)
+noexcept
+{
+	assert(_ring && _ring->head);
+	auto &head(*_ring->head);
+	const uint64_t data_head
+	{
+		__atomic_load_n(&head.data_head, __ATOMIC_ACQUIRE)
+	};
+
+	uint64_t tail(head.data_tail);
+	if(likely(tail == data_head))
+		return;
+
+	char label_buf[64];
+	const string_view label
+	{
+		sampler::label?
+			sampler::label(label_buf):
+			string_view{}
+	};
+
+	char key_buf[128];
+	const string_view key
+	{
+		fmt::sprintf
+		{
+			key_buf, "%s%s%s",
+			frame?: "*"_sv,
+			label? ";"_sv: string_view{},
+			label,
+		}
+	};
+
+	auto it
+	{
+		folded.lower_bound(key)
+	};
+
+	if(it == end(folded) || it->first != key)
+		it = folded.emplace_hint(it, std::string(key), std::map<uint64_t, uint64_t>{});
+
+	while(tail < data_head)
+	{
+		perf_event_header record;
+		copy(*_ring, mutable_buffer{reinterpret_cast<char *>(&record), sizeof(record)}, tail);
+		if(unlikely(!record.size))
+			break;
+
+		uint64_t val[2];
+		switch(record.type)
+		{
+			case PERF_RECORD_SAMPLE:
+				copy(*_ring, mutable_buffer{reinterpret_cast<char *>(val), sizeof(uint64_t)}, tail + sizeof(record));
+				++it->second[val[0]];
+				++samples;
+				break;
+
+			case PERF_RECORD_LOST:
+				copy(*_ring, mutable_buffer{reinterpret_cast<char *>(val), sizeof(val)}, tail + sizeof(record));
+				lost += val[1];
+				break;
+		}
+
+		tail += record.size;
+	}
+
+	__atomic_store_n(&head.data_tail, data_head, __ATOMIC_RELEASE);
+}
+
+/// Symbolizes the sampled addresses and merges those in the same function;
+/// the stack is the frame, the label, and the function, separated by ';'.
+bool
+ircd::prof::sampler::for_each(const folded_closure &closure)
+{
+	std::map<std::string, uint64_t, std::less<>> stacks;
+	for(const auto &[key, ips] : folded)
+		for(const auto &[ip, count] : ips)
+		{
+			::Dl_info info {0};
+			const bool found
+			{
+				::dladdr(reinterpret_cast<const void *>(ip), &info) != 0
+			};
+
+			const std::string sym
+			{
+				found && info.dli_sname?
+					demangle(info.dli_sname):
+				found && info.dli_fname?
+					"["s + info.dli_fname + "]":
+					"[unknown]"s
+			};
+
+			stacks[key + ';' + sym] += count;
+		}
+
+	for(const auto &[stack, count] : stacks)
+		if(!closure(stack, count))
+			return false;
+
+	return true;
+}
+
+void
+ircd::prof::sampler::copy(const ring &ring,
+                          const mutable_buffer &buf,
+                          const uint64_t &pos)
+noexcept
+{
+	const size_t max(size(ring.body));
+	for(size_t i(0); i < size(buf); ++i)
+		buf[i] = ring.body[(pos + i) % max];
+}
+
+//
+// sampler::ring::ring
+//
+
+ircd::prof::sampler::ring::ring(const uint32_t &freq,
+                                const size_t &pages)
+:attr{[&freq]
+{
+	struct ::perf_event_attr ret {0};
+	ret.size = sizeof(ret);
+
+	ret.type = PERF_TYPE_SOFTWARE;
+	ret.config = PERF_COUNT_SW_TASK_CLOCK;
+	ret.freq = true;
+	ret.sample_freq = freq;
+	ret.sample_type = PERF_SAMPLE_IP;
+
+	ret.exclude_kernel = true;
+	ret.exclude_hv = true;
+	ret.exclude_idle = true;
+	ret.exclude_callchain_user = true;
+	ret.exclude_callchain_kernel = true;
+
+	ret.disabled = true;
+	return ret;
+}()}
+,fd{[this]
+{
+	ulong flags(0);
+	flags |= PERF_FLAG_FD_CLOEXEC;
+
+	const int cpu(-1);
+	const pid_t pid(0);
+	const int group(-1);
+	return int(syscall<SYS_perf_event_open>(&attr, pid, cpu, group, flags));
+}()}
+,map_size
+{
+	(1UL + pages) * info::page_size
+}
+,map{[this, &pages]
+{
+	if(unlikely(!pages || (pages & (pages - 1))))
+		throw error
+		{
+			"Sampler pages must be a power of two; not %zu", pages
+		};
+
+	void *const ret
+	{
+		::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, int(fd), 0)
+	};
+
+	if(ret == MAP_FAILED)
+		throw std::system_error
+		{
+			errno, std::system_category()
+		};
+
+	return reinterpret_cast<char *>(ret);
+}()}
+,head
+{
+	reinterpret_cast<::perf_event_mmap_page *>(map)
+}
+,body
+{
+	map + head->data_offset,
+	head->data_size
+}
+{
+}
+
+ircd::prof::sampler::ring::~ring()
+noexcept
+{
+	syscall(::munmap, map, map_size);
+}
+
 //
 // time_*() suite
 //
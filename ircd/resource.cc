@@ -8,6 +8,9 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_ZLIB_H
+#include <RB_INC_ZSTD_H
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // resource/resource.h
@@ -23,80 +26,175 @@ decltype(ircd::resource::resources)
 ircd::resource::resources
 {};
 
-ircd::resource &
-ircd::resource::find(const string_view &path_)
+/// Path prefixes mapped to the module serving them, for modules which are
+/// not loaded until a request is first made under their prefix.
+decltype(ircd::resource::lazy)
+ircd::resource::lazy
+{};
+
+/// Loads the deferred modules for any prefix of the path; the entries are
+/// removed whether or not their module loads. Returns true if any loaded.
+bool
+ircd::resource::load(const string_view &path)
 {
-	const string_view path
+	bool ret(false);
+	for(auto it(begin(lazy)); it != end(lazy); )
 	{
-		rstrip(path_, '/')
-	};
+		if(!startswith(path, it->first))
+		{
+			++it;
+			continue;
+		}
+
+		const auto name
+		{
+			std::move(it->second)
+		};
+
+		it = lazy.erase(it); try
+		{
+			mods::imports.emplace(name, name);
+			ret = true;
+			log::info
+			{
+				log, "Loaded deferred module '%s' for `%s'",
+				name,
+				path,
+			};
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "Failed to load deferred module '%s' for `%s' :%s",
+				name,
+				path,
+				e.what(),
+			};
+		}
+	}
+
+	return ret;
+}
+
+namespace ircd
+{
+	static void resource_route_add(resource::route &, const string_view &, resource *const &);
+	static bool resource_route_del(resource::route &, const string_view &, const resource *const &);
+}
+
+/// A segment of the registered paths. The children are keyed by the segment
+/// following this one; the target is the resource registered at exactly the
+/// path ending with this segment (or null).
+struct ircd::resource::route
+{
+	std::map<std::string, std::unique_ptr<route>, iless> child;
+	resource *target {nullptr};
+};
 
-	auto it
+decltype(ircd::resource::routes)
+ircd::resource::routes
+{};
+
+void
+ircd::resource_route_add(resource::route &node,
+                         const string_view &path,
+                         resource *const &target)
+{
+	const auto &[segment, next]
 	{
-		resources.lower_bound(path)
+		split(lstrip(path, '/'), '/')
 	};
 
-	if(it == end(resources)) try
+	if(empty(segment))
 	{
-		--it;
-		if(it == begin(resources) || !startswith(path, it->first))
-			return *resources.at("/");
+		assert(!node.target);
+		node.target = target;
+		return;
 	}
-	catch(const std::out_of_range &e)
+
+	auto &child
 	{
-		throw http::error
-		{
-			http::code::NOT_FOUND
-		};
-	}
+		node.child[std::string{segment}]
+	};
 
-	auto rpath{it->first};
-	//assert(!endswith(rpath, '/'));
+	if(!child)
+		child = std::make_unique<resource::route>();
 
-	// Exact file or directory match
-	if(path == rpath)
-		return *it->second;
+	resource_route_add(*child, next, target);
+}
 
-	// Directories handle all paths under them.
-	while(!startswith(path, rpath))
+/// Returns true when the node is left without a target or children so the
+/// parent can remove it.
+bool
+ircd::resource_route_del(resource::route &node,
+                         const string_view &path,
+                         const resource *const &target)
+{
+	const auto &[segment, next]
 	{
-		// Walk the iterator back to find if there is a directory prefixing this path.
-		if(it == begin(resources))
-			throw http::error
-			{
-				http::code::NOT_FOUND
-			};
+		split(lstrip(path, '/'), '/')
+	};
 
-		--it;
-		rpath = it->first;
-		if(~it->second->opts->flags & it->second->DIRECTORY)
-			continue;
+	if(empty(segment) && node.target == target)
+		node.target = nullptr;
 
-		// If the closest directory still doesn't match hand this off to the
-		// webroot which can then service or 404 this itself.
-		if(!startswith(path, rpath))
-			return *resources.at("/");
-	}
+	if(!empty(segment))
+		if(const auto it{node.child.find(segment)}; it != end(node.child))
+			if(resource_route_del(*it->second, next, target))
+				node.child.erase(it);
 
-	// Check if the resource is a directory; if not, it can only
-	// handle exact path matches.
-	if(~it->second->opts->flags & it->second->DIRECTORY && path != rpath)
-		throw http::error
+	return !node.target && node.child.empty();
+}
+
+ircd::resource &
+ircd::resource::find(const string_view &path_)
+{
+	const string_view path
+	{
+		rstrip(path_, '/')
+	};
+
+	if(unlikely(!lazy.empty()))
+		load(path);
+
+	// Descend the routes one path segment at a time. The deepest directory
+	// passed handles the path when there's no resource at exactly the path.
+	const route *node(&routes);
+	resource *directory(nullptr);
+	string_view remain(path);
+	while(node)
+	{
+		if(node->target && node->target->opts->flags & DIRECTORY)
+			directory = node->target;
+
+		const auto &[segment, next]
 		{
-			http::code::NOT_FOUND
+			split(lstrip(remain, '/'), '/')
 		};
 
-	if(it->second->opts->flags & it->second->DIRECTORY)
-	{
-		const auto rem(lstrip(path, rpath));
-		if(!empty(rem) && !startswith(rem, '/'))
-			throw http::error
-			{
-				http::code::NOT_FOUND
-			};
+		if(empty(segment))
+			break;
+
+		const auto it
+		{
+			node->child.find(segment)
+		};
+
+		node = it != end(node->child)? it->second.get(): nullptr;
+		remain = next;
 	}
 
-	return *it->second;
+	if(node && node->target)
+		return *node->target;
+
+	if(directory)
+		return *directory;
+
+	throw http::error
+	{
+		http::code::NOT_FOUND
+	};
 }
 
 //
@@ -166,6 +264,7 @@ ircd::resource::resource(const string_view &path,
 	return std::make_unique<method>(*this, "OPTIONS", std::move(handler));
 }()}
 {
+	resource_route_add(routes, this->path, this);
 	log::debug
 	{
 		log, "Registered resource \"%s\"",
@@ -178,6 +277,7 @@ ircd::resource::resource(const string_view &path,
 ircd::resource::~resource()
 noexcept
 {
+	resource_route_del(routes, path, this);
 	log::debug
 	{
 		log, "Unregistered resource \"%s\"",
@@ -349,6 +449,45 @@ ircd::resource::method::default_payload_max
 	{ "default", long(128_KiB)                              },
 };
 
+/// Load level of the event loop (see ios::empt::load()) at which requests to
+/// SHEDDABLE methods are refused with 503. Zero disables shedding.
+decltype(ircd::resource::method::shed_level)
+ircd::resource::method::shed_level
+{
+	{ "name",    "ircd.resource.method.shed.level" },
+	{ "default", 3L                                },
+};
+
+/// Value of Retry-After in a response to a shed request.
+decltype(ircd::resource::method::shed_retry)
+ircd::resource::method::shed_retry
+{
+	{ "name",    "ircd.resource.method.shed.retry" },
+	{ "default", 5L                                },
+};
+
+bool
+ircd::resource::method::shedding()
+noexcept
+{
+	return shed_level && ios::empt::load() >= uint(shed_level);
+}
+
+void
+ircd::resource::method::shed()
+{
+	char buf[24];
+	const http::header headers[]
+	{
+		{ "Retry-After", lex_cast(seconds(shed_retry).count(), buf) },
+	};
+
+	throw http::error
+	{
+		http::SERVICE_UNAVAILABLE, {}, headers
+	};
+}
+
 //
 // method::stats
 //
@@ -380,6 +519,19 @@ ircd::resource::method::stats::stats(method &m)
 {
 	{ "name", method_stats_name(m, "internal_errors") }
 }
+,shed
+{
+	{ "name", method_stats_name(m, "shed") }
+}
+,latency
+{
+	{ "name",    "ircd.resource.latency" },
+	{ "labels",  json::members
+	{
+		{ "resource",  m.resource->path },
+		{ "method",    m.name           },
+	}},
+}
 {
 }
 
@@ -492,12 +644,26 @@ try
 			idle_dock.notify_all();
 	}};
 
+	const ircd::timer timer;
+	const unwind record_latency{[this, &timer]
+	{
+		stats->latency(timer.at<nanoseconds>());
+	}};
+
 	++stats->requests;
 	const scope_count pending
 	{
 		static_cast<uint64_t &>(stats->pending)
 	};
 
+	// Bail out before any work if this method's requests are optional and the
+	// event loop is overloaded; the client is told when to try again.
+	if(opts->flags & SHEDDABLE && shedding())
+	{
+		++stats->shed;
+		shed();
+	}
+
 	// Bail out if the method limited the amount of content and it was exceeded.
 	if(!content_length_acceptable(head))
 		throw http::error
@@ -523,14 +689,20 @@ try
 			seconds(default_timeout)
 	};
 
+	// Streams of an http/2 session share a socket and can't use its timer.
 	const net::scope_timeout timeout
 	{
-		*client.sock, method_timeout, [this, &client]
-		(const bool &timed_out)
-		{
-			if(timed_out)
-				this->handle_timeout(client);
-		}
+		client.sock?
+			net::scope_timeout
+			{
+				*client.sock, method_timeout, [this, &client]
+				(const bool &timed_out)
+				{
+					if(timed_out)
+						this->handle_timeout(client);
+				}
+			}:
+			net::scope_timeout{}
 	};
 
 	// Content that hasn't yet arrived is remaining
@@ -559,7 +731,7 @@ try
 	// in the subsequent reads for content below (or in the handler). We don't
 	// QUICKACK when we've received all content since we might be able to make
 	// an actual response all in one shot.
-	if(content_remain && ~opts->flags & DELAYED_ACK)
+	if(content_remain && ~opts->flags & DELAYED_ACK && client.sock)
 		net::quickack(*client.sock, true);
 
 	// Branch taken to receive any remaining content in the common case where
@@ -619,11 +791,8 @@ try
 	// good place because the request has finished writing everything; the
 	// socket doesn't know that, but we do, and this is the place. The action
 	// can be disabled by using the flag in the method's options.
-	if(likely(~opts->flags & DELAYED_RESPONSE))
-	{
-		assert(client.sock);
+	if(likely(~opts->flags & DELAYED_RESPONSE) && client.sock)
 		net::flush(*client.sock);
-	}
 
 	return ret;
 }
@@ -653,6 +822,11 @@ ircd::resource::method::call_handler(client &client,
                                      resource::request &request)
 try
 {
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::json
+	};
+
 	return function(client, request);
 }
 catch(const ctx::timeout &e)
@@ -761,6 +935,265 @@ const
 // resource/response.h
 //
 
+//
+// resource::response::chunked::encoder
+//
+
+/// Streaming compressor for a chunked response. Every write is flushed
+/// through (Z_SYNC_FLUSH / ZSTD_e_flush) so what the client has received is
+/// always decodable up to the last chunk; a /sync flushing at its hiwat or a
+/// longpoll response isn't held back waiting for the window to fill.
+struct ircd::resource::response::chunked::encoder
+{
+	using closure = std::function<void (const const_buffer &)>;
+
+	static conf::item<bool> enable;
+	static conf::item<bool> zstd_enable;
+	static conf::item<int> gzip_level;
+	static conf::item<int> zstd_level;
+	static conf::item<size_t> buffer_size;
+	static stats::item<uint64_t> bytes_in;
+	static stats::item<uint64_t> bytes_out;
+
+	static std::unique_ptr<encoder> make(const client &, const string_view &content_type);
+
+	string_view name;
+	unique_mutable_buffer buf;
+	#ifdef HAVE_ZLIB_H
+	z_stream z {};
+	#endif
+	#ifdef HAVE_ZSTD_H
+	ZSTD_CStream *zs {nullptr};
+	#endif
+
+	void operator()(const const_buffer &in, const bool &fin, const closure &);
+
+	encoder(const string_view &name);
+	encoder(encoder &&) = delete;
+	encoder(const encoder &) = delete;
+	~encoder() noexcept;
+};
+
+decltype(ircd::resource::response::chunked::encoder::enable)
+ircd::resource::response::chunked::encoder::enable
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.enable" },
+	{ "default", true                                             },
+	{ "help",    "Compress chunked JSON responses when the client accepts it." },
+};
+
+decltype(ircd::resource::response::chunked::encoder::zstd_enable)
+ircd::resource::response::chunked::encoder::zstd_enable
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.zstd.enable" },
+	{ "default", true                                                  },
+};
+
+decltype(ircd::resource::response::chunked::encoder::gzip_level)
+ircd::resource::response::chunked::encoder::gzip_level
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.gzip.level" },
+	{ "default", 4L                                                   },
+};
+
+decltype(ircd::resource::response::chunked::encoder::zstd_level)
+ircd::resource::response::chunked::encoder::zstd_level
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.zstd.level" },
+	{ "default", 3L                                                   },
+};
+
+decltype(ircd::resource::response::chunked::encoder::buffer_size)
+ircd::resource::response::chunked::encoder::buffer_size
+{
+	{ "name",    "ircd.resource.response.chunked.encoding.buffer_size" },
+	{ "default", long(32_KiB)                                          },
+};
+
+decltype(ircd::resource::response::chunked::encoder::bytes_in)
+ircd::resource::response::chunked::encoder::bytes_in
+{
+	{ "name", "ircd.resource.response.chunked.encoding.bytes_in" },
+};
+
+decltype(ircd::resource::response::chunked::encoder::bytes_out)
+ircd::resource::response::chunked::encoder::bytes_out
+{
+	{ "name", "ircd.resource.response.chunked.encoding.bytes_out" },
+};
+
+/// Selects an encoding from the request's Accept-Encoding; zstd is preferred
+/// over gzip. Codings offered with q=0 are refused.
+std::unique_ptr<ircd::resource::response::chunked::encoder>
+ircd::resource::response::chunked::encoder::make(const client &client,
+                                                  const string_view &content_type)
+{
+	if(!enable)
+		return {};
+
+	if(!startswith(content_type, "application/json"))
+		return {};
+
+	bool gzip{false}, zstd{false};
+	tokens(client.request.head.accept_encoding, ',', [&gzip, &zstd]
+	(const string_view &token) -> bool
+	{
+		const auto &[coding, params]
+		{
+			split(token, ';')
+		};
+
+		const auto &[param, qvalue]
+		{
+			split(strip(params), '=')
+		};
+
+		const bool refused
+		{
+			strip(param) == "q" && lex_castable<float>(strip(qvalue)) &&
+			lex_cast<float>(strip(qvalue)) <= 0.0f
+		};
+
+		gzip |= iequals(strip(coding), "gzip"_sv) && !refused;
+		zstd |= iequals(strip(coding), "zstd"_sv) && !refused;
+		return true;
+	});
+
+	#ifdef HAVE_ZSTD_H
+	if(zstd && zstd_enable)
+		return std::make_unique<encoder>("zstd");
+	#endif
+
+	#ifdef HAVE_ZLIB_H
+	if(gzip)
+		return std::make_unique<encoder>("gzip");
+	#endif
+
+	return {};
+}
+
+ircd::resource::response::chunked::encoder::encoder(const string_view &name)
+:name
+{
+	name
+}
+,buf
+{
+	size_t(buffer_size)
+}
+{
+	#ifdef HAVE_ZSTD_H
+	if(name == "zstd")
+	{
+		zs = ZSTD_createCStream();
+		if(unlikely(!zs))
+			throw std::bad_alloc{};
+
+		ZSTD_CCtx_setParameter(zs, ZSTD_c_compressionLevel, int(zstd_level));
+		return;
+	}
+	#endif
+
+	#ifdef HAVE_ZLIB_H
+	assert(name == "gzip");
+	// windowBits of 15 + 16 selects the gzip wrapper rather than zlib's.
+	const auto ret
+	{
+		deflateInit2(&z, int(gzip_level), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY)
+	};
+
+	if(unlikely(ret != Z_OK))
+		throw error
+		{
+			"gzip encoder init :%s", z.msg?: "failed"
+		};
+	#endif
+}
+
+ircd::resource::response::chunked::encoder::~encoder()
+noexcept
+{
+	#ifdef HAVE_ZSTD_H
+	if(zs)
+	{
+		ZSTD_freeCStream(zs);
+		return;
+	}
+	#endif
+
+	#ifdef HAVE_ZLIB_H
+	deflateEnd(&z);
+	#endif
+}
+
+void
+ircd::resource::response::chunked::encoder::operator()(const const_buffer &in,
+                                                       const bool &fin,
+                                                       const closure &closure)
+{
+	bytes_in += size(in);
+
+	#ifdef HAVE_ZSTD_H
+	if(zs)
+	{
+		ZSTD_inBuffer ib
+		{
+			data(in), size(in), 0
+		};
+
+		size_t remain;
+		do
+		{
+			ZSTD_outBuffer ob
+			{
+				data(buf), size(buf), 0
+			};
+
+			remain = ZSTD_compressStream2(zs, &ob, &ib, fin? ZSTD_e_end: ZSTD_e_flush);
+			if(unlikely(ZSTD_isError(remain)))
+				throw error
+				{
+					"zstd encoder :%s", ZSTD_getErrorName(remain)
+				};
+
+			bytes_out += ob.pos;
+			if(ob.pos)
+				closure(const_buffer{data(buf), ob.pos});
+		}
+		while(remain || ib.pos < ib.size);
+		return;
+	}
+	#endif
+
+	#ifdef HAVE_ZLIB_H
+	z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(in)));
+	z.avail_in = size(in);
+
+	int ret;
+	do
+	{
+		z.next_out = reinterpret_cast<Bytef *>(data(buf));
+		z.avail_out = size(buf);
+		ret = deflate(&z, fin? Z_FINISH: Z_SYNC_FLUSH);
+		if(unlikely(ret == Z_STREAM_ERROR))
+			throw error
+			{
+				"gzip encoder :%s", z.msg?: "stream error"
+			};
+
+		const size_t produced
+		{
+			size(buf) - z.avail_out
+		};
+
+		bytes_out += produced;
+		if(produced)
+			closure(const_buffer{data(buf), produced});
+	}
+	while(ret != Z_BUF_ERROR && (z.avail_out == 0 || (fin && ret != Z_STREAM_END)));
+	#endif
+}
+
 //
 // resource::response::chunked
 //
@@ -835,43 +1268,133 @@ ircd::resource::response::chunked::default_buffer_size
 	{ "default", long(128_KiB)                                },
 };
 
+/// Total bytes of output buffer held by all chunked responses. Slow clients
+/// hold theirs for as long as they take to receive the response; once this
+/// is exceeded new responses are given smaller buffers.
+decltype(ircd::resource::response::chunked::buffers_max)
+ircd::resource::response::chunked::buffers_max
+{
+	{ "name",    "ircd.resource.response.chunked.buffers.max" },
+	{ "default", long(256_MiB)                                },
+};
+
+/// The least buffer a response is reduced to when buffers.max is exceeded.
+decltype(ircd::resource::response::chunked::buffer_min)
+ircd::resource::response::chunked::buffer_min
+{
+	{ "name",    "ircd.resource.response.chunked.buffer.min" },
+	{ "default", long(128_KiB)                               },
+};
+
+decltype(ircd::resource::response::chunked::buffers_count)
+ircd::resource::response::chunked::buffers_count
+{
+	{ "name", "ircd.resource.response.chunked.buffers.count" },
+};
+
+decltype(ircd::resource::response::chunked::buffers_bytes)
+ircd::resource::response::chunked::buffers_bytes
+{
+	{ "name", "ircd.resource.response.chunked.buffers.bytes" },
+};
+
+decltype(ircd::resource::response::chunked::buffers_reduced)
+ircd::resource::response::chunked::buffers_reduced
+{
+	{ "name", "ircd.resource.response.chunked.buffers.reduced" },
+};
+
+decltype(ircd::resource::response::chunked::slow_writes)
+ircd::resource::response::chunked::slow_writes
+{
+	{ "name", "ircd.resource.response.chunked.slow_writes" },
+};
+
+/// Size of the buffer to allocate for a response wanting buffer_size; it is
+/// reduced while the total held by all responses exceeds buffers.max.
+size_t
+ircd::resource::response::chunked::reserve(const size_t &buffer_size)
+{
+	if(likely(uint64_t(buffers_bytes) + buffer_size <= size_t(buffers_max)))
+		return buffer_size;
+
+	const size_t remain
+	{
+		size_t(buffers_max) - std::min(size_t(buffers_max), size_t(buffers_bytes))
+	};
+
+	++buffers_reduced;
+	return std::min(buffer_size, std::max(remain, size_t(buffer_min)));
+}
+
 ircd::resource::response::chunked::chunked(client &client,
                                            const http::code &code,
                                            const string_view &content_type,
                                            const string_view &headers,
                                            const size_t &buffer_size,
                                            const mutable_buffer &buf)
-:response
-{
-	client,
-	code,
-	content_type,
-	size_t(-1),
-	headers
-}
-,c
+:c
 {
 	&client
 }
 ,_buf
 {
-	buffer_size
+	buffer_size?
+		reserve(buffer_size):
+		0UL
 }
 ,buf
 {
 	buffer_size? _buf: buf
 }
+,enc
+{
+	encoder::make(client, content_type)
+}
 {
 	assert(!empty(content_type));
 	assert(buffer_size > 0 || empty(_buf));
 	assert(buffer_size > 0 || !empty(buf));
 	assert(buffer_size == 0 || empty(buf));
 	assert(buffer_size == 0 || !empty(_buf));
+
+	std::string encoded_headers;
+	if(enc)
+	{
+		encoded_headers.append("Content-Encoding: ");
+		encoded_headers.append(enc->name);
+		encoded_headers.append("\r\nVary: Accept-Encoding\r\n");
+		encoded_headers.append(headers);
+	}
+
+	// The head is held to go out in the same write as the first chunk.
+	this->head.resize(HEAD_BUF_SZ);
+	const const_buffer head
+	{
+		response::head(mutable_buffer(this->head), client, code, content_type, size_t(-1), enc? string_view{encoded_headers}: headers)
+	};
+
+	this->head.resize(size(head));
+	log_head(client, code, content_type, size_t(-1), size(head));
+
+	buffers_count += !empty(_buf);
+	buffers_bytes += size(_buf);
 }
 
 ircd::resource::response::chunked::~chunked()
 noexcept try
 {
+	const unwind release{[this]
+	{
+		if(empty(_buf))
+			return;
+
+		assert(uint64_t(buffers_count) > 0);
+		assert(uint64_t(buffers_bytes) >= size(_buf));
+		--buffers_count;
+		buffers_bytes -= size(_buf);
+	}};
+
 	if(!c)
 		return;
 
@@ -912,7 +1435,7 @@ ircd::resource::response::chunked::finish(const bool psh)
 	write(const_buffer{}, false);
 	assert(finished);
 
-	if(psh)
+	if(psh && c->sock)
 		net::flush(*c->sock);
 
 	assert(count > 0);
@@ -950,19 +1473,51 @@ ircd::resource::response::chunked::flush(const const_buffer &buf)
 
 	assert(flushed <= size(buf));
 	this->flushed += flushed;
-	assert(this->flushed <= this->wrote);
+	assert(this->flushed <= this->wrote || enc);
 	return const_buffer
 	{
 		data(buf), flushed
 	};
 }
 
+/// Writes plain content; when an encoding was negotiated the content is
+/// compressed and whatever the encoder produces goes out as chunks. The
+/// return value is the amount of content consumed.
 size_t
 ircd::resource::response::chunked::write(const const_buffer &chunk,
                                          const bool &ignore_empty)
+{
+	if(likely(!enc))
+		return _write(chunk, ignore_empty);
+
+	if(!c)
+		return 0UL;
+
+	if(empty(chunk) && ignore_empty)
+		return 0UL;
+
+	const bool fin
+	{
+		empty(chunk)
+	};
+
+	(*enc)(chunk, fin, [this](const const_buffer &encoded)
+	{
+		_write(encoded, true);
+	});
+
+	if(fin)
+		_write(const_buffer{}, false);
+
+	return size(chunk);
+}
+
+size_t
+ircd::resource::response::chunked::_write(const const_buffer &chunk,
+                                          const bool &ignore_empty)
 try
 {
-	assert(size(chunk) <= size(this->buf) || empty(this->buf));
+	assert(size(chunk) <= size(this->buf) || empty(this->buf) || enc);
 	assert(!finished);
 	if(!c)
 		return 0UL;
@@ -973,6 +1528,9 @@ try
 	char headbuf[32];
 	const const_buffer iov[]
 	{
+		// response head (first chunk only)
+		string_view{this->head},
+
 		// head
 		http::writechunk(headbuf, size(chunk)),
 
@@ -988,7 +1546,23 @@ try
 		this->wrote
 	};
 
-	this->wrote += c->write_all(iov);
+	const size_t head_size
+	{
+		size(this->head)
+	};
+
+	const net::const_buffers bufs
+	{
+		iov + !head_size, iov + std::size(iov)
+	};
+
+	// The kernel has no room for this chunk; the client is not keeping up and
+	// this context will be blocked holding the buffer.
+	if(c->sock && !c->stream_id && size(chunk) > net::writable(*c->sock))
+		++slow_writes;
+
+	this->wrote += c->write_all(bufs) - head_size;
+	this->head.clear();
 	finished |= empty(chunk);
 	count++;
 
@@ -1209,21 +1783,11 @@ ircd::resource::response::response(client &client,
 {
 	assert(empty(content) || !empty(content_type));
 
-	// Head gets sent
+	// Head and all content get sent together
 	response
 	{
-		client, code, content_type, size(content), headers
+		client, code, content_type, size(content), headers, content
 	};
-
-	// All content gets sent
-	const size_t written
-	{
-		size(content)?
-			client.write_all(content):
-			0
-	};
-
-	assert(written == size(content));
 }
 
 decltype(ircd::resource::response::access_control_allow_origin)
@@ -1238,10 +1802,54 @@ ircd::resource::response::response(client &client,
                                    const http::code &code,
                                    const string_view &content_type,
                                    const size_t &content_length,
-                                   const string_view &headers)
+                                   const string_view &headers,
+                                   const const_buffer &content)
 {
 	assert(!content_length || !empty(content_type));
 
+	char head_buf[HEAD_BUF_SZ];
+	const const_buffer head
+	{
+		response::head(head_buf, client, code, content_type, content_length, headers)
+	};
+
+	// The head and any leading content go out in one write.
+	const const_buffer bufs[]
+	{
+		head, content
+	};
+
+	size_t wrote {0};
+	std::exception_ptr eptr; try
+	{
+		const net::const_buffers iov
+		{
+			bufs, size_t(empty(content)? 1: 2)
+		};
+
+		wrote += client.write_all(iov);
+	}
+	catch(...)
+	{
+		eptr = std::current_exception();
+	}
+
+	log_head(client, code, content_type, content_length, size(head), eptr);
+	if(unlikely(eptr))
+		std::rethrow_exception(eptr);
+
+	assert(wrote == size(head) + size(content));
+}
+
+/// Compose the HTTP head of a response into the buffer without sending it.
+ircd::const_buffer
+ircd::resource::response::head(const mutable_buffer &buf,
+                               client &client,
+                               const http::code &code,
+                               const string_view &content_type,
+                               const size_t &content_length,
+                               const string_view &headers)
+{
 	const auto request_time
 	{
 		client.timer.at<microseconds>()
@@ -1259,8 +1867,7 @@ ircd::resource::response::response(client &client,
 		{ "Access-Control-Allow-Origin",  string_view(access_control_allow_origin) },
 	};
 
-	char head_buf[HEAD_BUF_SZ];
-	window_buffer head{head_buf};
+	window_buffer head{buf};
 	http::response
 	{
 		head,
@@ -1276,25 +1883,27 @@ ircd::resource::response::response(client &client,
 	if(unlikely(!head.remaining()))
 		throw panic
 		{
-			"HTTP headers too large for buffer of %zu", sizeof(head_buf)
+			"HTTP headers too large for buffer of %zu", size(buf)
 		};
 
-	size_t wrote_head {0};
-	std::exception_ptr eptr; try
-	{
-		wrote_head += client.write_all(head.completed());
-	}
-	catch(...)
-	{
-		eptr = std::current_exception();
-	}
+	return head.completed();
+}
 
+void
+ircd::resource::response::log_head(const client &client,
+                                   const http::code &code,
+                                   const string_view &content_type,
+                                   const size_t &content_length,
+                                   const size_t &wrote_head,
+                                   const std::exception_ptr &eptr)
+{
 	#ifdef RB_DEBUG
 	const log::level level
 	{
 		http::severity(http::category(code))
 	};
 
+	char rtime_buf[32];
 	log::logf
 	{
 		log, level,
@@ -1303,7 +1912,7 @@ ircd::resource::response::response(client &client,
 		uint(code),
 		client.request.head.path,
 		http::status(code),
-		rtime,
+		pretty(rtime_buf, client.timer.at<microseconds>(), true),
 		content_type,
 		ssize_t(content_length) >= 0?
 			lex_cast(content_length):
@@ -1315,11 +1924,6 @@ ircd::resource::response::response(client &client,
 		what(eptr)
 	};
 	#endif
-
-	if(unlikely(eptr))
-		std::rethrow_exception(eptr);
-
-	assert(wrote_head == size(head.completed()));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -51,6 +51,159 @@ ircd::server::close_all_timeout
 	{ "default",  2L                              },
 };
 
+//
+// buffer_pool
+//
+
+decltype(ircd::server::buffer_pool::cache_max)
+ircd::server::buffer_pool::cache_max
+{
+	{ "name",     "ircd.server.buffer.cache.max" },
+	{ "default",  long(32_MiB)                   },
+	{ "description",
+
+	R"(
+	Bytes of released request head and tag scratch buffers retained for reuse
+	by later requests rather than being freed.
+	)"},
+};
+
+decltype(ircd::server::buffer_pool::cache_hits)
+ircd::server::buffer_pool::cache_hits
+{
+	{ "name", "ircd.server.buffer.cache.hits" },
+};
+
+decltype(ircd::server::buffer_pool::cache_misses)
+ircd::server::buffer_pool::cache_misses
+{
+	{ "name", "ircd.server.buffer.cache.misses" },
+};
+
+decltype(ircd::server::buffer_pool::cache_bytes)
+ircd::server::buffer_pool::cache_bytes
+{
+	{ "name", "ircd.server.buffer.cache.bytes" },
+};
+
+decltype(ircd::server::buffer_pool::live_bytes)
+ircd::server::buffer_pool::live_bytes
+{
+	{ "name", "ircd.server.buffer.live.bytes" },
+};
+
+decltype(ircd::server::buffer_pool::cache)
+ircd::server::buffer_pool::cache;
+
+void
+ircd::server::buffer_pool::clear()
+noexcept
+{
+	for(auto &free : cache)
+	{
+		for(void *const &ptr : free)
+			std::free(ptr);
+
+		free.clear();
+		free.shrink_to_fit();
+	}
+
+	cache_bytes = 0;
+}
+
+void *
+ircd::server::buffer_pool::acquire(const size_t &size)
+{
+	const auto alloc_size
+	{
+		class_size(size)
+	};
+
+	const auto cls
+	{
+		class_of(size)
+	};
+
+	live_bytes += alloc_size;
+	if(cls < CLASSES && !cache[cls].empty())
+	{
+		void *const ret(cache[cls].back());
+		cache[cls].pop_back();
+		cache_bytes -= alloc_size;
+		++cache_hits;
+		return ret;
+	}
+
+	unique_mutable_buffer umb
+	{
+		alloc_size
+	};
+
+	++cache_misses;
+	return data(umb.release());
+}
+
+void
+ircd::server::buffer_pool::release(void *const ptr,
+                                   const size_t &size)
+noexcept try
+{
+	const auto alloc_size
+	{
+		class_size(size)
+	};
+
+	const auto cls
+	{
+		class_of(size)
+	};
+
+	assert(uint64_t(live_bytes) >= alloc_size);
+	live_bytes -= alloc_size;
+	if(cls < CLASSES && uint64_t(cache_bytes) + alloc_size <= size_t(cache_max))
+	{
+		cache[cls].emplace_back(ptr);
+		cache_bytes += alloc_size;
+		return;
+	}
+
+	std::free(ptr);
+}
+catch(...)
+{
+	std::free(ptr);
+}
+
+size_t
+ircd::server::buffer_pool::class_size(const size_t &size)
+noexcept
+{
+	const auto cls
+	{
+		class_of(size)
+	};
+
+	return cls < CLASSES?
+		1UL << (cls + CLASS_MIN):
+		size;
+}
+
+size_t
+ircd::server::buffer_pool::class_of(const size_t &size)
+noexcept
+{
+	const size_t log2
+	{
+		size > 1?
+			size_t(64 - __builtin_clzl(size - 1)):
+			0UL
+	};
+
+	return log2 > CLASS_MIN?
+		std::min(log2 - CLASS_MIN, CLASSES):
+		0UL;
+}
+
 //
 // init
 //
@@ -65,6 +218,7 @@ noexcept
 {
 	interrupt(), close(), wait();
 	peers.clear();
+	buffer_pool::clear();
 	log::debug
 	{
 		log, "All server peers, connections, and requests are clear."
@@ -89,7 +243,7 @@ ircd::server::init::wait()
 				peer->tag_count(),
 				peer->link_count(),
 				peer->err_has(),
-				peer->op_resolve,
+				bool(peer->op_resolve),
 				peer->op_fini,
 			};
 
@@ -147,7 +301,7 @@ try
 		get(hostport)
 	};
 
-	if(peer.err_has())
+	if(!peer.err_check())
 		return false;
 
 	if(peer.links.empty())
@@ -283,7 +437,7 @@ noexcept
 	};
 
 	return it != end(peers)?
-		!it->second->err_has():
+		it->second->err_expires() <= now<system_point>():
 		false;
 }
 
@@ -321,10 +475,48 @@ noexcept
 	};
 
 	return it != end(peers)?
-		it->second->err_has():
+		it->second->err_expires() > now<system_point>():
 		false;
 }
 
+ircd::system_point
+ircd::server::backoff(const net::hostport &hostport)
+noexcept
+{
+	const auto hostcanon
+	{
+		server::canonize(hostport)
+	};
+
+	const auto it
+	{
+		peers.find(hostcanon)
+	};
+
+	return it != end(peers)?
+		it->second->err_expires():
+		system_point{};
+}
+
+ircd::microseconds
+ircd::server::rtt(const net::hostport &hostport)
+noexcept
+{
+	const auto hostcanon
+	{
+		server::canonize(hostport)
+	};
+
+	const auto it
+	{
+		peers.find(hostcanon)
+	};
+
+	return it != end(peers)?
+		it->second->rtt:
+		microseconds{0};
+}
+
 ircd::string_view
 ircd::server::errmsg(const net::hostport &hostport)
 noexcept
@@ -840,6 +1032,14 @@ ircd::server::peer::peer(const net::hostport &hostport,
 {
 	open_opts
 }
+,latency
+{
+	{ "name",    "ircd.server.peer.latency" },
+	{ "labels",  json::members
+	{
+		{ "peer",  string_view{hostcanon} },
+	}},
+}
 {
 	// Socket options
 	this->open_opts.sopts = &peer::sock_opts;
@@ -915,6 +1115,7 @@ void
 ircd::server::peer::err_set(A&&... args)
 {
 	this->e = std::make_unique<err>(std::forward<A>(args)...);
+	++err_streak;
 }
 
 ircd::string_view
@@ -938,6 +1139,36 @@ ircd::server::peer::error_clear_default
 	{ "default",  305L                                   }
 };
 
+decltype(ircd::server::peer::error_clear_min)
+ircd::server::peer::error_clear_min
+{
+	{ "name",     "ircd.server.peer.error.clear_min" },
+	{ "default",  15L                                }
+};
+
+/// The error indicator is held for an interval which doubles with each
+/// consecutive failure from error_clear_min up to error_clear_default. Any
+/// successful response resets the streak.
+ircd::system_point
+ircd::server::peer::err_expires()
+const
+{
+	if(!err_has())
+		return system_point{};
+
+	const size_t shift
+	{
+		std::min(err_streak? err_streak - 1: 0UL, 16UL)
+	};
+
+	const seconds interval
+	{
+		std::min(seconds(error_clear_min) * (1L << shift), seconds(error_clear_default))
+	};
+
+	return e->etime + interval;
+}
+
 bool
 ircd::server::peer::err_check()
 {
@@ -950,7 +1181,7 @@ ircd::server::peer::err_check()
 	//TODO: The specific error type should be switched and finer
 	//TODO: timeouts should be used depending on the error: i.e
 	//TODO: NXDOMAIN vs. temporary conn timeout, etc.
-	if(e->etime + seconds(error_clear_default) > now<system_point>())
+	if(err_expires() > now<system_point>())
 		return false;
 
 	err_clear();
@@ -1166,6 +1397,30 @@ ircd::server::peer::handle_open(link &link,
 		link.close(net::dc::RST);
 		return;
 	}
+
+	// When both families were raced, the family which won is tried first
+	// by the links opened from now on.
+	if(!remote_alt || !link.socket)
+		return;
+
+	const auto winner
+	{
+		net::remote_ipport(*link.socket)
+	};
+
+	if(!winner || net::is_v4(winner) == net::is_v4(remote))
+		return;
+
+	race_v4 = net::is_v4(winner);
+	set_remote();
+
+	char rembuf[64];
+	log::debug
+	{
+		log, "%s [%s]: won the connection race; now preferred",
+		loghead(link),
+		string(rembuf, winner),
+	};
 }
 
 void
@@ -1305,6 +1560,21 @@ noexcept try
 		};
 	}
 
+	// Any response short of a server error is evidence the peer is healthy;
+	// the latency sample feeds a moving average (weight 1/8) which callers
+	// use to prefer faster remotes.
+	if(tag.request && tag.state.status && uint(tag.state.status) < 500)
+	{
+		const auto sample
+		{
+			duration_cast<microseconds>(now<steady_point>() - tag.state.started)
+		};
+
+		rtt = rtt.count()? (rtt * 7 + sample) / 8: sample;
+		latency(sample);
+		err_streak = 0;
+	}
+
 	// Peer-level actions for any specific HTTP codes
 	switch(tag.state.status)
 	{
@@ -1502,51 +1772,92 @@ ircd::server::peer::resolve()
 	hostport.service = service(canon);
 	hostport.port = port(canon)?: 0;
 
-	net::dns::opts opts;
-	opts.qtype =
-		net::service(hostport) && !net::port(hostport)?
-			33:  // SRV
-		peer::enable_ipv6 && net::enable_ipv6?
-			28:  // AAAA
-			 1;  // A
+	// Skip DNS resolution for IP literals
+	if(rfc3986::valid(std::nothrow, rfc3986::parser::ip_address, host(hostport)))
+		return resolve_addr(hostport);
+
+	// The address records of the host are queried concurrently with its SRV
+	// record rather than after it. The SRV usually comes back empty, leaving
+	// the host itself as the target; otherwise the speculative answers are
+	// discarded for those of the SRV target. Nothing is concluded from the
+	// address answers while the SRV is outstanding.
+	res_srv = net::service(hostport) && !net::port(hostport);
+	resolve_addr(hostport);
+	if(!res_srv || op_fini)
+		return;
 
 	// When the result comes back as nxdomain this tells the resolver to
 	// not set eptr; instead it gives an empty set of results. We do this
 	// with SRV/AAAA queries for seamless fallback.
-	opts.nxdomain_exceptions =
-		opts.qtype != 33 &&     // SRV
-		opts.qtype != 28;       // AAAA
-
+	net::dns::opts opts;
+	opts.qtype = 33;
+	opts.nxdomain_exceptions = false;
 	resolve(hostport, opts);
 }
 
+/// Issue the AAAA and A queries for the target together; the AAAA answer
+/// is preferred and the A answer is only taken once the AAAA has nothing.
+void
+ircd::server::peer::resolve_addr(const hostport &target)
+{
+	if(rfc3986::valid(std::nothrow, rfc3986::parser::ip_address, host(target)))
+	{
+		res_host.clear();
+		this->remote = {host(target), port(target)};
+		this->remote_alt = {};
+		this->remote_expires = system_point::max();
+		open_opts.ipport = this->remote;
+		open_opts.ipport_alt = {};
+		open_links();
+		return;
+	}
+
+	const bool ipv6
+	{
+		peer::enable_ipv6 && net::enable_ipv6
+	};
+
+	res_host = host(target);
+	res_addr[0] = {};
+	res_addr[1] = {};
+	res_err = {};
+	res_done = ipv6? 0x00: 0x01;
+	res_ok = 0x00;
+	res_concluded = false;
+	if(ipv6)
+	{
+		net::dns::opts opts;
+		opts.qtype = 28;
+		opts.nxdomain_exceptions = false;
+		resolve(target, opts);
+	}
+
+	// The AAAA may have been answered from the cache with a conclusion; the
+	// A is still wanted then, as the alternate raced against it.
+	if(res_host.empty() || op_fini)
+		return;
+
+	net::dns::opts opts;
+	opts.qtype = 1;
+	opts.nxdomain_exceptions = true;
+	resolve(target, opts);
+}
+
 void
 ircd::server::peer::resolve(const net::hostport &hostport,
                             const net::dns::opts &opts)
 try
 {
-	assert(!op_resolve);
 	if(op_fini)
 		return;
 
 	const unwind_exceptional failure{[this]
 	{
-		op_resolve = false;
 		err_set(std::current_exception());
 		if(unlikely(ircd::run::level != ircd::run::level::RUN))
 			op_fini = true;
 	}};
 
-	// Skip DNS resolution for IP literals
-	if(rfc3986::valid(std::nothrow, rfc3986::parser::ip_address, host(hostport)))
-	{
-		this->remote = {host(hostport), port(hostport)};
-		this->remote_expires = system_point::max();
-		open_opts.ipport = this->remote;
-		open_links();
-		return;
-	}
-
 	if(unlikely(opts.qtype != 33 && opts.qtype != 28 && opts.qtype != 1))
 		throw error
 		{
@@ -1562,7 +1873,15 @@ try
 			net::dns::callback(std::bind(&peer::handle_resolve_A, this, ph::_1, ph::_2))
 	};
 
-	op_resolve = true;
+	// The count is incremented first because the handler may be called
+	// from the cache within this frame.
+	++op_resolve;
+	const unwind_exceptional uncount{[this]
+	{
+		assert(op_resolve);
+		--op_resolve;
+	}};
+
 	assert(ctx::current); // sorry, ircd::ctx required for now.
 	net::dns::resolve(hostport, opts, std::move(handler));
 }
@@ -1584,7 +1903,8 @@ ircd::server::peer::handle_resolve_SRV(const hostport &hp,
 try
 {
 	assert(op_resolve);
-	op_resolve = false;
+	--op_resolve;
+	res_srv = false;
 
 	if(unlikely(ircd::run::level != ircd::run::level::RUN))
 		op_fini = true;
@@ -1602,6 +1922,7 @@ try
 
 	if(net::dns::is_error(rr))
 	{
+		res_host.clear();
 		const json::string &error(rr.get("error"));
 		err_set(make_exception_ptr<rfc1035::error>("%s", error));
 		assert(this->e && this->e->eptr);
@@ -1609,7 +1930,7 @@ try
 		__builtin_unreachable();
 	}
 
-	// Target for the next address record query.
+	// Target for the address record queries.
 	const hostport &target
 	{
 		rr.has("tgt")?
@@ -1624,26 +1945,26 @@ try
 	};
 
 	// Save the port from the SRV record to a class member because it won't
-	// get carried through the next A/AAAA query.
+	// get carried through the address queries.
 	port(remote) = port(target);
 	port(open_opts.hostport) = port(target);
 
-	// Setup the address record query off this SRV response.
-	net::dns::opts opts;
-	opts.qtype = bool(peer::enable_ipv6) && bool(net::enable_ipv6)? 28: 1;
+	// The speculative address queries were for this same host; they may
+	// have been answered already.
+	if(iequals(host(target), res_host))
+		return handle_resolve();
 
 	log::debug
 	{
-		log, "peer(%p) '%s' resolved '%s' SRV to '%s' rrs:%zu; now resolving %s...",
+		log, "peer(%p) '%s' resolved '%s' SRV to '%s' rrs:%zu; now resolving addresses...",
 		this,
 		this->hostcanon,
 		host(hp),
 		host(target),
 		rrs.size(),
-		rfc1035::rqtype.at(opts.qtype)
 	};
 
-	resolve(target, opts);
+	resolve_addr(target);
 }
 catch(const std::exception &e)
 {
@@ -1667,7 +1988,7 @@ ircd::server::peer::handle_resolve_AAAA(const hostport &target,
 try
 {
 	assert(op_resolve);
-	op_resolve = false;
+	--op_resolve;
 
 	if(unlikely(ircd::run::level != ircd::run::level::RUN))
 		op_fini = true;
@@ -1678,56 +1999,37 @@ try
 	if(op_fini)
 		return;
 
-	if(net::dns::is_empty(rrs) || net::dns::is_error(rrs))
+	// Answer for a target which was superseded or already concluded.
+	if(!iequals(host(target), res_host))
+		return;
+
+	res_done |= 0x01;
+	if(!net::dns::is_empty(rrs) && !net::dns::is_error(rrs))
 	{
-		// Setup the address record query off this SRV response.
-		net::dns::opts opts;
-		opts.qtype = 1;
+		const json::object &rr
+		{
+			net::dns::random_choice(rrs)
+		};
 
-		log::debug
+		const json::string &ip
 		{
-			log, "peer(%p) resolved %s AAAA rrs:%zu resolving %s %s",
-			this,
-			hostcanon,
-			rrs.size(),
-			host(target),
-			rfc1035::rqtype.at(opts.qtype)
+			rr.at("ip")
 		};
 
-		resolve(target, opts);
-		return;
+		res_addr[0] = net::ipport{ip, port(target)};
+		res_ttl[0] = rr.get("ttl", 43200L);
+		res_ok |= 0x01;
 	}
-
-	const json::object &rr
-	{
-		net::dns::random_choice(rrs)
-	};
-
-	assert(!net::dns::is_error(rr));
-	const json::string &ip
-	{
-		rr.at("ip")
-	};
-
-	// Save the results of the query to this object instance.
-	this->remote = net::ipport
+	else log::debug
 	{
-		ip, port(this->remote)?: port(target)
-	};
-
-	// Mark the absolute time-point this remote will need to be refreshed
-	this->remote_expires =
-	{
-		now<system_point>() + std::clamp
-		(
-			seconds(rr.get("ttl", 43200L)),
-			seconds(remote_ttl_min),
-			seconds(remote_ttl_max)
-		)
+		log, "peer(%p) resolved %s AAAA rrs:%zu; falling back to A for %s",
+		this,
+		hostcanon,
+		rrs.size(),
+		host(target),
 	};
 
-	open_opts.ipport = this->remote;
-	open_links();
+	handle_resolve();
 }
 catch(const std::exception &e)
 {
@@ -1752,7 +2054,7 @@ try
 {
 	const ctx::critical_assertion ca;
 	assert(op_resolve);
-	op_resolve = false;
+	--op_resolve;
 
 	if(unlikely(ircd::run::level != ircd::run::level::RUN))
 		op_fini = true;
@@ -1763,67 +2065,146 @@ try
 	if(op_fini)
 		return;
 
-	if(net::dns::is_empty(rrs))
-	{
-		err_set(make_exception_ptr<unavailable>("Host has no address record."));
-		assert(this->e && this->e->eptr);
-		std::rethrow_exception(this->e->eptr);
-		__builtin_unreachable();
-	}
+	// Answer for a target which was superseded or already concluded.
+	if(!iequals(host(target), res_host))
+		return;
 
+	res_done |= 0x02;
 	const json::object &rr
 	{
 		net::dns::random_choice(rrs)
 	};
 
-	if(net::dns::is_error(rr))
+	if(net::dns::is_empty(rrs))
+		res_err = make_exception_ptr<unavailable>("Host has no address record.");
+	else if(net::dns::is_error(rr))
+		res_err = make_exception_ptr<rfc1035::error>("%s", json::string(rr.get("error")));
+	else
 	{
-		const json::string &error(rr.get("error"));
-		err_set(make_exception_ptr<rfc1035::error>("%s", error));
-		assert(this->e && this->e->eptr);
-		std::rethrow_exception(this->e->eptr);
-		__builtin_unreachable();
+		const json::string &ip
+		{
+			rr.at("ip")
+		};
+
+		res_addr[1] = net::ipport{ip, port(target)};
+		res_ttl[1] = rr.get("ttl", 21600L);
+		res_ok |= 0x02;
 	}
 
-	const json::string &ip
+	// Late answer after the AAAA concluded; it only adds the alternate.
+	if(res_concluded)
 	{
-		rr.at("ip")
-	};
+		res_host.clear();
+		if(res_ok & 0x02)
+			port(res_addr[1]) = port(this->remote);
+
+		return set_remote();
+	}
 
-	// Save the results of the query to this object instance.
-	this->remote = net::ipport
+	handle_resolve();
+}
+catch(const std::exception &e)
+{
+	log::derror
 	{
-		ip, port(this->remote)?: port(target)
+		log, "peer(%p) '%s' resolve '%s' A :%s",
+		this,
+		this->hostcanon,
+		host(target),
+		e.what()
 	};
 
-	// Mark the absolute time-point this remote will need to be refreshed
-	this->remote_expires =
-	{
+	err_set(std::current_exception());
+	const ctx::exception_handler eh;
+	close();
+}
+
+/// Conclude the resolution once the answers allow it. Nothing is concluded
+/// while the SRV is outstanding, since it may name another target; after
+/// that the AAAA address is taken when there is one, otherwise the A. An A
+/// answer arriving later is kept as the alternate to race against it.
+void
+ircd::server::peer::handle_resolve()
+{
+	if(res_srv || res_concluded)
+		return;
+
+	const int use
+	{
+		res_ok & 0x01?
+			0:
+		~res_done & 0x01?
+			-1:
+		res_ok & 0x02?
+			1:
+		~res_done & 0x02?
+			-1:
+			-2
+	};
+
+	// Awaiting an answer.
+	if(use == -1)
+		return;
+
+	res_concluded = true;
+	if(res_done == 0x03)
+		res_host.clear();
+
+	if(use == -2)
+	{
+		res_host.clear();
+		err_set(res_err?: make_exception_ptr<unavailable>("Host has no address record."));
+		assert(this->e && this->e->eptr);
+		std::rethrow_exception(this->e->eptr);
+		__builtin_unreachable();
+	}
+
+	// Save the results of the query to this object instance; a port set
+	// from the SRV has precedence.
+	const auto remote_port
+	{
+		port(this->remote)
+	};
+
+	for(auto &addr : res_addr)
+		if(addr)
+			port(addr) = remote_port?: port(addr);
+
+	// Mark the absolute time-point this remote will need to be refreshed
+	this->remote_expires =
+	{
 		now<system_point>() + std::clamp
 		(
-			seconds(rr.get("ttl", 21600L)),
+			seconds(res_ttl[use]),
 			seconds(remote_ttl_min),
 			seconds(remote_ttl_max)
 		)
 	};
 
-	open_opts.ipport = this->remote;
+	set_remote();
 	open_links();
 }
-catch(const std::exception &e)
+
+/// Set the addresses the links connect to from the answers. With both
+/// families the AAAA address is primary and the A address is raced against
+/// it, unless the A address won the last race.
+void
+ircd::server::peer::set_remote()
 {
-	log::derror
+	const bool both
 	{
-		log, "peer(%p) '%s' resolve '%s' A :%s",
-		this,
-		this->hostcanon,
-		host(target),
-		e.what()
+		(res_ok & 0x03) == 0x03
 	};
 
-	err_set(std::current_exception());
-	const ctx::exception_handler eh;
-	close();
+	const bool v4
+	{
+		!(res_ok & 0x01) || (both && race_v4)
+	};
+
+	this->remote = res_addr[v4];
+	this->remote_alt = both? res_addr[!v4]: net::ipport{};
+	open_opts.ipport = this->remote;
+	open_opts.ipport_alt = this->remote_alt;
 }
 
 void
@@ -2091,9 +2472,90 @@ ircd::server::link::tag_commit_max_default
 	{ "default",  3L                                }
 };
 
+decltype(ircd::server::link::http2_enable)
+ircd::server::link::http2_enable
+{
+	{ "name",     "ircd.server.link.http2.enable" },
+	{ "default",  false                           },
+	{ "help",     "Offer HTTP/2 with ALPN to multiplex requests over one connection." },
+};
+
+decltype(ircd::server::link::http2_streams_max)
+ircd::server::link::http2_streams_max
+{
+	{ "name",     "ircd.server.link.http2.streams.max" },
+	{ "default",  128L                                 },
+};
+
+decltype(ircd::server::link::http2_window)
+ircd::server::link::http2_window
+{
+	{ "name",     "ircd.server.link.http2.window" },
+	{ "default",  long(4_MiB)                     },
+	{ "help",     "Receive window advertised for the connection and each stream." },
+};
+
 decltype(ircd::server::link::ids)
 ircd::server::link::ids;
 
+/// HTTP/2 session of a link which negotiated h2 with ALPN. Tags are unaware
+/// of it: their HTTP/1.1 request head is translated into a HEADERS frame and
+/// their content into DATA frames on a stream; the response is translated
+/// back into an HTTP/1.1 head and (chunked) content fed to the tag's usual
+/// parser. Any number of tags up to the remote's stream limit are committed
+/// at once and complete in any order.
+struct ircd::server::link::h2c
+{
+	struct stream
+	{
+		uint64_t tag_id {0};               // zero when the tag is done first
+		ssize_t send_window {0};
+		size_t recv_unacked {0};
+		bool head {false};                 // response head fed to tag
+		bool chunked {false};              // response content fed as chunks
+	};
+
+	using iterator = std::list<tag>::iterator;
+
+	http2::hpack::table table;
+	std::map<uint32_t, stream> streams;
+	std::string out;                       // frames pending write
+	size_t out_pos {0};
+	std::string in;                        // partial frame received
+	std::string block;                     // header block being received
+	uint32_t block_id {0};                 // stream awaiting CONTINUATION
+	bool block_end {false};
+	uint32_t next_id {1};
+	bool goaway {false};
+	ssize_t send_window {65535};
+	size_t recv_unacked {0};
+	size_t max_streams {100};
+	ssize_t initial_window {65535};
+	size_t max_frame {16384};
+
+	void frame(const http2::frame::type &, const uint8_t &flags, const uint32_t &id, const const_buffer &payload = {});
+	void window_update(const uint32_t &id, const size_t &inc);
+	void rst(const uint32_t &id, const enum http2::error::code &);
+	iterator find(link &, const stream &);
+	void fail(link &, const uint32_t &id, std::exception_ptr);
+	void feed(link &, const uint32_t &id, const string_view &);
+	void end_stream(link &, const uint32_t &id);
+	void handle_head(link &, const uint32_t &id, const bool &eos);
+	void handle_headers(link &, const http2::frame::header &, const const_buffer &);
+	void handle_data(link &, const http2::frame::header &, const const_buffer &);
+	void handle_settings(link &, const http2::frame::header &, const const_buffer &);
+	void handle_goaway(link &, const const_buffer &);
+	void handle_frame(link &, const http2::frame::header &, const const_buffer &);
+	bool send(link &, const uint32_t &id, stream &, tag &);
+	void start(link &, tag &);
+	bool flush(link &);
+
+  public:
+	void write(link &);
+	void read(link &);
+	void open(link &);
+};
+
 ircd::string_view
 ircd::server::loghead(const link &link)
 {
@@ -2247,6 +2709,16 @@ ircd::server::link::cleanup_canceled()
 		it = queue.erase(it);
 	}
 
+	// Streams of canceled tags are reset individually by the write path
+	// without disturbing the others on the connection.
+	if(h2)
+	{
+		if(dead && ready())
+			wait_writable();
+
+		return;
+	}
+
 	// If every committed tag in the pipe is canceled we can close this link
 	// to quickly disperse any queued tags to another link or simply kill this
 	// link if it's timing out.
@@ -2277,6 +2749,15 @@ ircd::server::link::open(const net::open_opts &open_opts)
 		std::bind(&link::handle_open, this, ph::_1)
 	};
 
+	static const string_view alpn[]
+	{
+		http2::alpn, "http/1.1"
+	};
+
+	net::open_opts opts{open_opts};
+	if(http2_enable)
+		opts.alpn = alpn;
+
 	op_init = true;
 	op_open = true;
 	const unwind_exceptional unhandled{[this]
@@ -2285,7 +2766,7 @@ ircd::server::link::open(const net::open_opts &open_opts)
 		op_open = false;
 	}};
 
-	socket = net::open(open_opts, std::move(handler));
+	socket = net::open(opts, std::move(handler));
 	op_open = false;
 
 	if(finished())
@@ -2305,6 +2786,18 @@ ircd::server::link::handle_open(std::exception_ptr eptr)
 	op_init = false;
 	synack_ts = time<seconds>();
 
+	const string_view alpn
+	{
+		socket? socket->alpn: "",
+		socket? strnlen(socket->alpn, sizeof(socket->alpn)): 0
+	};
+
+	if(!eptr && !op_fini && alpn == http2::alpn)
+	{
+		h2 = std::make_unique<h2c>();
+		h2->open(*this);
+	}
+
 	if(!eptr && !op_fini)
 		wait_writable();
 
@@ -2421,6 +2914,9 @@ void
 ircd::server::link::handle_writable_success()
 {
 	assert(socket);
+	if(h2)
+		return h2->write(*this);
+
 	auto it(begin(queue));
 	while(it != end(queue))
 	{
@@ -2609,6 +3105,9 @@ void
 ircd::server::link::handle_readable_success()
 {
 	assert(socket);
+	if(h2)
+		return h2->read(*this);
+
 	if(!tag_committed())
 	{
 		discard_read();
@@ -2623,7 +3122,7 @@ ircd::server::link::handle_readable_success()
 	// case though: canceled requests have their buffers free'ed when the tag
 	// is pop'ed from this link's queue, because the user is gone; the scratch
 	// buffer is maintained between iterations in that case.
-	unique_buffer<mutable_buffer> scratch;
+	pooled_buffer scratch;
 	const_buffer overrun; do
 	{
 		if(!process_read(overrun, scratch))
@@ -2641,7 +3140,7 @@ ircd::server::link::handle_readable_success()
 /// Process as many read operations for one tag as possible
 bool
 ircd::server::link::process_read(const_buffer &overrun,
-                                 unique_buffer<mutable_buffer> &scratch)
+                                 pooled_buffer &scratch)
 try
 {
 	assert(peer);
@@ -2695,7 +3194,7 @@ try
 		// Copy into new buffer before trashing the old buffer in case each
 		// tag being processed here is just windowing down on the same data
 		// nagled together at the first tag.
-		unique_buffer<mutable_buffer> _scratch(overrun);
+		pooled_buffer _scratch(overrun);
 		scratch = std::move(_scratch);
 		overrun = scratch;
 		assert(!empty(overrun));
@@ -2780,215 +3279,1249 @@ ircd::server::link::read(const mutable_buffer &buf)
 	assert(received <= size(buf));
 	return const_buffer
 	{
-		buf, received
+		buf, received
+	};
+}
+
+void
+ircd::server::link::discard_read()
+{
+	assert(socket);
+	const size_t available
+	{
+		net::available(*socket)
+	};
+
+	const ssize_t has_pending
+	{
+		#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(LIBRESSL_VERSION_NUMBER)
+			SSL_has_pending(socket->ssl.native_handle())
+		#else
+			-2L
+		#endif
+	};
+
+	const ssize_t pending
+	{
+		SSL_pending(socket->ssl.native_handle())
+	};
+
+	const size_t discarded
+	{
+		discard_any(*socket, size_t(pending))
+	};
+
+	if(discarded)
+	{
+		log::dwarning
+		{
+			log, "%s q:%zu discarded:%zu pending:%zd has_pending:%zd available:%zd",
+			loghead(*this),
+			queue.size(),
+			discarded,
+			pending,
+			has_pending,
+			available,
+		};
+
+		assert(peer);
+		peer->read_bytes += discarded;
+		return;
+	}
+
+	throw std::system_error
+	{
+		net::eof
+	};
+}
+
+size_t
+ircd::server::link::tag_uncommitted()
+const
+{
+	return tag_count() - tag_committed();
+}
+
+size_t
+ircd::server::link::tag_committed()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.committed();
+	});
+}
+
+size_t
+ircd::server::link::tag_count()
+const
+{
+	return queue.size();
+}
+
+size_t
+ircd::server::link::read_total()
+const
+{
+	return socket? socket->in.bytes : 0;
+}
+
+size_t
+ircd::server::link::write_total()
+const
+{
+	return socket? socket->out.bytes : 0;
+}
+
+size_t
+ircd::server::link::read_remaining()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.read_remaining();
+	});
+}
+
+size_t
+ircd::server::link::read_completed()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.read_completed();
+	});
+}
+
+size_t
+ircd::server::link::read_size()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.read_size();
+	});
+}
+
+size_t
+ircd::server::link::write_remaining()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.write_remaining();
+	});
+}
+
+size_t
+ircd::server::link::write_completed()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.write_completed();
+	});
+}
+
+size_t
+ircd::server::link::write_size()
+const
+{
+	return accumulate_tags([](const auto &tag)
+	{
+		return tag.write_size();
+	});
+}
+
+bool
+ircd::server::link::busy()
+const
+{
+	return !queue.empty();
+}
+
+bool
+ircd::server::link::ready()
+const
+{
+	return opened() && !op_init && !op_fini;
+}
+
+bool
+ircd::server::link::opened()
+const noexcept
+{
+	return bool(socket) && net::opened(*socket);
+}
+
+bool
+ircd::server::link::finished()
+const
+{
+	if(!bool(socket))
+		return true;
+
+	return !opened() && op_fini && !op_init && !op_open && !op_write && !op_read;
+}
+
+size_t
+ircd::server::link::tag_commit_max()
+const
+{
+	if(h2)
+		return std::min(h2->max_streams, size_t(http2_streams_max));
+
+	return tag_commit_max_default;
+}
+
+size_t
+ircd::server::link::tag_max()
+const
+{
+	return tag_max_default;
+}
+
+template<class F>
+size_t
+ircd::server::link::accumulate_tags(F&& closure)
+const
+{
+	return std::accumulate(begin(queue), end(queue), size_t(0), [&closure]
+	(auto ret, const auto &tag)
+	{
+		return ret += closure(tag);
+	});
+}
+
+//
+// link::h2c
+//
+
+namespace ircd::server
+{
+	static uint32_t h2_uint32(const char *const &);
+	static void h2_uint32(char *const &, const uint32_t &);
+}
+
+uint32_t
+ircd::server::h2_uint32(const char *const &buf)
+{
+	const auto *const p
+	{
+		reinterpret_cast<const uint8_t *>(buf)
+	};
+
+	return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+void
+ircd::server::h2_uint32(char *const &buf,
+                        const uint32_t &val)
+{
+	buf[0] = char(val >> 24);
+	buf[1] = char(val >> 16);
+	buf[2] = char(val >> 8);
+	buf[3] = char(val);
+}
+
+void
+ircd::server::link::h2c::open(link &link)
+{
+	const size_t window
+	{
+		std::clamp(size_t(http2_window), 65535UL, 0x7fffffffUL)
+	};
+
+	// Push is disabled; our receive window is raised for each stream by
+	// the settings and for the connection by a window update.
+	char settings[2][6];
+	settings[0][0] = 0;
+	settings[0][1] = http2::frame::settings::ENABLE_PUSH;
+	h2_uint32(settings[0] + 2, 0);
+	settings[1][0] = 0;
+	settings[1][1] = http2::frame::settings::INITIAL_WINDOW_SIZE;
+	h2_uint32(settings[1] + 2, window);
+
+	out.append(data(http2::connection_preface), size(http2::connection_preface));
+	frame(http2::frame::type::SETTINGS, 0, 0, const_buffer{settings[0], sizeof(settings)});
+	if(window > 65535)
+		window_update(0, window - 65535);
+
+	log::debug
+	{
+		log, "%s negotiated http/2 window:%zu",
+		loghead(link),
+		window,
+	};
+}
+
+void
+ircd::server::link::h2c::read(link &link)
+try
+{
+	const auto tag_done
+	{
+		link.tag_done
+	};
+
+	thread_local char buf[16_KiB];
+	for(const_buffer got; !empty(got = link.read(buf)); )
+	{
+		in.append(data(got), size(got));
+
+		size_t pos(0);
+		while(size(in) - pos >= sizeof(http2::frame::header))
+		{
+			const http2::frame::header header
+			{
+				const_buffer{in.data() + pos, sizeof(http2::frame::header)}
+			};
+
+			// We never raise SETTINGS_MAX_FRAME_SIZE from its default.
+			if(unlikely(header.len > 16384))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "%s frame of %u bytes exceeds maximum",
+					http2::frame::reflect(header.type),
+					uint(header.len),
+				};
+
+			if(size(in) - pos - sizeof(header) < header.len)
+				break;
+
+			const const_buffer payload
+			{
+				in.data() + pos + sizeof(header), header.len
+			};
+
+			handle_frame(link, header, payload);
+			pos += sizeof(header) + header.len;
+			if(unlikely(link.op_fini))
+				return;
+		}
+
+		in.erase(0, pos);
+	}
+
+	if(!empty(out))
+		link.wait_writable();
+
+	if(goaway && streams.empty())
+	{
+		link.close();
+		return;
+	}
+
+	assert(link.peer);
+	if(link.tag_done != tag_done && link.queue.empty())
+		link.peer->handle_link_done(link);
+	else
+		link.wait_readable();
+}
+catch(const http2::error &e)
+{
+	char payload[8];
+	h2_uint32(payload, 0);
+	h2_uint32(payload + 4, e.code);
+	frame(http2::frame::type::GOAWAY, 0, 0, payload);
+	flush(link);
+	throw;
+}
+
+void
+ircd::server::link::h2c::write(link &link)
+{
+	if(!flush(link))
+	{
+		link.wait_writable();
+		return;
+	}
+
+	link.wait_readable();
+	for(auto it(begin(link.queue)); it != end(link.queue); )
+	{
+		auto &tag{*it};
+		if(!tag.committed() && (tag.abandoned() || tag.canceled()))
+		{
+			it = link.queue.erase(it);
+			continue;
+		}
+
+		// Streams are opened in the order of the queue so the committed tags
+		// remain at its front.
+		if(!tag.committed())
+		{
+			if(goaway || streams.size() >= link.tag_commit_max())
+				break;
+
+			start(link, tag);
+		}
+
+		const auto sit
+		{
+			std::find_if(begin(streams), end(streams), [&tag]
+			(const auto &s)
+			{
+				return s.second.tag_id == tag.state.id;
+			})
+		};
+
+		if(unlikely(sit == end(streams)))
+		{
+			++it;
+			continue;
+		}
+
+		if(tag.canceled())
+		{
+			rst(sit->first, http2::error::CANCEL);
+			streams.erase(sit);
+			it = link.queue.erase(it);
+			continue;
+		}
+
+		if(!send(link, sit->first, sit->second, tag))
+			break;
+
+		++it;
+	}
+
+	if(!flush(link))
+		link.wait_writable();
+}
+
+/// Translate the tag's HTTP/1.1 request head into a HEADERS frame opening
+/// a new stream; its content follows by send().
+void
+ircd::server::link::h2c::start(link &link,
+                               tag &tag)
+{
+	assert(tag.request);
+	assert(!tag.committed());
+	const auto &req{*tag.request};
+	const string_view head
+	{
+		data(req.out.head), size(req.out.head)
+	};
+
+	const auto &[line, fields]
+	{
+		split(head, "\r\n"_sv)
+	};
+
+	string_view authority;
+	tokens(fields, "\r\n"_sv, [&authority]
+	(const string_view &field)
+	{
+		const auto &[name, value](split(field, ':'));
+		if(iequals(name, "host"_sv))
+			authority = lstrip(value, ' ');
+	});
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		size(head) * 2 + 64
+	};
+
+	mutable_buffer cur{buf};
+	const auto add{[&cur]
+	(const string_view &name, const string_view &value)
+	{
+		consume(cur, size(http2::hpack::encode(cur, name, value)));
+	}};
+
+	add(":method", token(line, ' ', 0));
+	add(":scheme", "https");
+	add(":authority", authority);
+	add(":path", token(line, ' ', 1));
+	tokens(fields, "\r\n"_sv, [&add]
+	(const string_view &field)
+	{
+		const auto &[name, value](split(field, ':'));
+		if(iequals(name, "host"_sv)
+		|| iequals(name, "connection"_sv)
+		|| iequals(name, "keep-alive"_sv)
+		|| iequals(name, "proxy-connection"_sv)
+		|| iequals(name, "transfer-encoding"_sv)
+		|| iequals(name, "upgrade"_sv)
+		|| iequals(name, "te"_sv))
+			return;
+
+		char lower[128];
+		if(unlikely(size(name) > sizeof(lower)))
+			throw http2::error
+			{
+				"Header name of %zu bytes is too long", size(name)
+			};
+
+		add(tolower(lower, name), lstrip(value, ' '));
+	});
+
+	const uint32_t id
+	{
+		next_id
+	};
+
+	const string_view block
+	{
+		data(buf), size(buf) - size(cur)
+	};
+
+	const bool end
+	{
+		empty(req.out.content)
+	};
+
+	size_t off(0); do
+	{
+		const size_t len(std::min(size(block) - off, max_frame));
+		const uint8_t flags
+		(
+			(off + len == size(block)? uint8_t(http2::frame::flag::END_HEADERS): 0U) |
+			(!off && end? uint8_t(http2::frame::flag::END_STREAM): 0U)
+		);
+
+		frame
+		(
+			off? http2::frame::type::CONTINUATION: http2::frame::type::HEADERS,
+			flags,
+			id,
+			const_buffer{data(block) + off, len}
+		);
+
+		off += len;
+	}
+	while(off < size(block));
+
+	log::debug
+	{
+		log, "%s starting on tag:%lu stream:%u %zu of %zu: wt:%zu [%s]",
+		loghead(link),
+		tag.state.id,
+		id,
+		streams.size(),
+		link.tag_count(),
+		tag.write_size(),
+		loghead(req),
+	};
+
+	streams.emplace(id, stream{tag.state.id, initial_window});
+	tag.wrote_buffer(req.out.head);
+
+	// Once the identifiers run out the connection is drained and closed.
+	next_id += 2;
+	goaway |= next_id >= 0x7fffffffU;
+}
+
+/// Send as much of the tag's content as the flow control windows allow;
+/// false when they are exhausted or the socket is full.
+bool
+ircd::server::link::h2c::send(link &link,
+                              const uint32_t &id,
+                              stream &stream,
+                              tag &tag)
+{
+	while(tag.write_remaining())
+	{
+		const const_buffer window
+		{
+			tag.make_write_buffer()
+		};
+
+		const ssize_t len
+		{
+			std::min
+			({
+				ssize_t(size(window)),
+				send_window,
+				stream.send_window,
+				ssize_t(max_frame),
+			})
+		};
+
+		if(len <= 0)
+			return true;
+
+		const const_buffer piece
+		{
+			data(window), size_t(len)
+		};
+
+		tag.wrote_buffer(piece);
+		send_window -= len;
+		stream.send_window -= len;
+
+		const uint8_t flags
+		{
+			!tag.write_remaining()?
+				uint8_t(http2::frame::flag::END_STREAM):
+				uint8_t(0)
+		};
+
+		frame(http2::frame::type::DATA, flags, id, piece);
+		if(size(out) - out_pos >= 64_KiB && !flush(link))
+			return false;
+	}
+
+	return true;
+}
+
+bool
+ircd::server::link::h2c::flush(link &link)
+{
+	while(out_pos < size(out))
+	{
+		const const_buffer buf
+		{
+			out.data() + out_pos, size(out) - out_pos
+		};
+
+		const const_buffer written
+		{
+			link.process_write_next(buf)
+		};
+
+		out_pos += size(written);
+		if(size(written) < size(buf))
+			return false;
+	}
+
+	out.clear();
+	out_pos = 0;
+	return true;
+}
+
+void
+ircd::server::link::h2c::handle_frame(link &link,
+                                      const http2::frame::header &header,
+                                      const const_buffer &payload)
+{
+	using type = http2::frame::type;
+
+	if(unlikely(block_id && header.type != type::CONTINUATION))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Expected CONTINUATION on stream %u; got %s",
+			block_id,
+			http2::frame::reflect(header.type),
+		};
+
+	switch(header.type)
+	{
+		case type::DATA:
+			handle_data(link, header, payload);
+			break;
+
+		case type::HEADERS:
+		case type::CONTINUATION:
+			handle_headers(link, header, payload);
+			break;
+
+		case type::SETTINGS:
+			handle_settings(link, header, payload);
+			break;
+
+		case type::GOAWAY:
+			handle_goaway(link, payload);
+			break;
+
+		case type::PING:
+		{
+			if(unlikely(header.stream_id || size(payload) != 8))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "Invalid PING"
+				};
+
+			if(!(header.flags & uint8_t(http2::frame::flag::ACK)))
+				frame(type::PING, uint8_t(http2::frame::flag::ACK), 0, payload);
+
+			break;
+		}
+
+		case type::WINDOW_UPDATE:
+		{
+			if(unlikely(size(payload) != 4))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "Invalid WINDOW_UPDATE"
+				};
+
+			const ssize_t inc
+			{
+				h2_uint32(data(payload)) & 0x7fffffffU
+			};
+
+			auto *const window
+			{
+				!header.stream_id?
+					&send_window:
+				streams.count(header.stream_id)?
+					&streams.at(header.stream_id).send_window:
+					nullptr
+			};
+
+			if(unlikely(!inc || (window && *window + inc > 0x7fffffffL)))
+				throw http2::error
+				{
+					http2::error::FLOW_CONTROL_ERROR, "Invalid window increment %zd on stream %u",
+					inc,
+					uint(header.stream_id),
+				};
+
+			if(window)
+				*window += inc;
+
+			link.wait_writable();
+			break;
+		}
+
+		case type::RST_STREAM:
+		{
+			if(unlikely(size(payload) != 4))
+				throw http2::error
+				{
+					http2::error::FRAME_SIZE_ERROR, "Invalid RST_STREAM"
+				};
+
+			const auto code
+			{
+				(enum http2::error::code)h2_uint32(data(payload))
+			};
+
+			fail(link, header.stream_id, make_exception_ptr<http2::error>
+			(
+				code, "Stream %u reset by remote :%s",
+				uint(header.stream_id),
+				http2::reflect(code)
+			));
+
+			break;
+		}
+
+		// Our settings disabled push.
+		case type::PUSH_PROMISE:
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Unsolicited PUSH_PROMISE"
+			};
+
+		default:
+			break;
+	}
+}
+
+void
+ircd::server::link::h2c::handle_settings(link &link,
+                                         const http2::frame::header &header,
+                                         const const_buffer &payload)
+{
+	using code = http2::frame::settings::code;
+
+	if(unlikely(header.stream_id))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "SETTINGS on stream %u",
+			uint(header.stream_id),
+		};
+
+	if(header.flags & uint8_t(http2::frame::flag::ACK))
+		return;
+
+	if(unlikely(size(payload) % 6))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "Invalid SETTINGS of %zu bytes",
+			size(payload),
+		};
+
+	for(size_t i(0); i < size(payload); i += 6)
+	{
+		const auto *const param
+		{
+			data(payload) + i
+		};
+
+		const uint16_t id
+		(
+			uint16_t(uint8_t(param[0])) << 8 | uint8_t(param[1])
+		);
+
+		const uint32_t value
+		{
+			h2_uint32(param + 2)
+		};
+
+		switch(id)
+		{
+			case code::MAX_CONCURRENT_STREAMS:
+				max_streams = value;
+				break;
+
+			case code::INITIAL_WINDOW_SIZE:
+			{
+				if(unlikely(value > 0x7fffffffU))
+					throw http2::error
+					{
+						http2::error::FLOW_CONTROL_ERROR, "Initial window size %u too large",
+						value,
+					};
+
+				// The change applies to the windows of all open streams.
+				for(auto &[id, stream] : streams)
+					stream.send_window += ssize_t(value) - initial_window;
+
+				initial_window = value;
+				break;
+			}
+
+			case code::MAX_FRAME_SIZE:
+			{
+				if(unlikely(value < 16384 || value > 16777215))
+					throw http2::error
+					{
+						http2::error::PROTOCOL_ERROR, "Invalid max frame size %u",
+						value,
+					};
+
+				max_frame = value;
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	frame(http2::frame::type::SETTINGS, uint8_t(http2::frame::flag::ACK), 0);
+	link.wait_writable();
+}
+
+void
+ircd::server::link::h2c::handle_goaway(link &link,
+                                       const const_buffer &payload)
+{
+	if(unlikely(size(payload) < 8))
+		throw http2::error
+		{
+			http2::error::FRAME_SIZE_ERROR, "Invalid GOAWAY"
+		};
+
+	const uint32_t last
+	{
+		h2_uint32(data(payload)) & 0x7fffffffU
+	};
+
+	const auto code
+	{
+		(enum http2::error::code)h2_uint32(data(payload) + 4)
+	};
+
+	log::dwarning
+	{
+		log, "%s remote going away after stream:%u :%s",
+		loghead(link),
+		last,
+		http2::reflect(code),
+	};
+
+	// Streams after the last one were not processed by the remote; the
+	// streams up to it are allowed to finish before the link is closed.
+	goaway = true;
+	while(!streams.empty() && rbegin(streams)->first > last)
+		fail(link, rbegin(streams)->first, make_exception_ptr<http2::error>
+		(
+			http2::error::REFUSED_STREAM, "Stream %u refused by remote going away :%s",
+			rbegin(streams)->first,
+			http2::reflect(code)
+		));
+}
+
+void
+ircd::server::link::h2c::handle_headers(link &link,
+                                        const http2::frame::header &header,
+                                        const const_buffer &payload)
+{
+	using flag = http2::frame::flag;
+
+	if(header.type == http2::frame::type::CONTINUATION)
+	{
+		if(unlikely(!block_id || header.stream_id != block_id))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Unexpected CONTINUATION on stream %u",
+				uint(header.stream_id),
+			};
+
+		block.append(data(payload), size(payload));
+	}
+	else
+	{
+		const_buffer fragment{payload};
+		size_t pad(0);
+		if(header.flags & uint8_t(flag::PADDED) && !empty(fragment))
+		{
+			pad = uint8_t(fragment[0]);
+			consume(fragment, 1);
+		}
+
+		if(header.flags & uint8_t(flag::PRIORITY))
+			consume(fragment, std::min(size(fragment), 5UL));
+
+		if(unlikely(!header.stream_id || pad > size(fragment)))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "Invalid HEADERS on stream %u",
+				uint(header.stream_id),
+			};
+
+		block.assign(data(fragment), size(fragment) - pad);
+		block_id = header.stream_id;
+		block_end = header.flags & uint8_t(flag::END_STREAM);
+	}
+
+	if(!(header.flags & uint8_t(flag::END_HEADERS)))
+		return;
+
+	const auto id{block_id};
+	block_id = 0;
+	handle_head(link, id, block_end);
+}
+
+/// Translate a complete header block into the HTTP/1.1 response head the
+/// tag expects. Without a content-length the content is framed as chunks.
+void
+ircd::server::link::h2c::handle_head(link &link,
+                                     const uint32_t &id,
+                                     const bool &eos)
+{
+	uint status(0);
+	bool has_length(false);
+	std::string fields;
+	fields.reserve(size(block) * 2);
+
+	// The block is decoded regardless of the stream for the table.
+	http2::hpack::decode(table, string_view{block}, [&]
+	(const string_view &name, const string_view &value)
+	{
+		if(name == ":status")
+			status = lex_cast<uint>(value);
+
+		if(startswith(name, ':'))
+			return;
+
+		has_length |= name == "content-length";
+		fields.append(data(name), size(name));
+		fields.append(": ");
+		fields.append(data(value), size(value));
+		fields.append("\r\n");
+	});
+
+	block.clear();
+	const auto sit
+	{
+		streams.find(id)
+	};
+
+	if(sit == end(streams))
+		return;
+
+	// Trailers; or an interim response which is ignored.
+	auto &stream{sit->second};
+	if(stream.head || (status >= 100 && status < 200))
+	{
+		if(eos)
+			end_stream(link, id);
+
+		return;
+	}
+
+	if(unlikely(!status))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Response on stream %u without :status", id
+		};
+
+	stream.head = true;
+	stream.chunked = !eos && !has_length;
+
+	char buf[64];
+	const string_view line
+	{
+		fmt::sprintf
+		{
+			buf, "HTTP/1.1 %u %s\r\n",
+			status,
+			http::status(http::code(status)),
+		}
 	};
+
+	std::string head(line);
+	head.append(fields);
+	if(stream.chunked)
+		head.append("transfer-encoding: chunked\r\n");
+	else if(eos && !has_length)
+		head.append("content-length: 0\r\n");
+
+	head.append("\r\n");
+	feed(link, id, head);
+	if(eos)
+		end_stream(link, id);
 }
 
 void
-ircd::server::link::discard_read()
+ircd::server::link::h2c::handle_data(link &link,
+                                     const http2::frame::header &header,
+                                     const const_buffer &payload)
 {
-	assert(socket);
-	const size_t available
-	{
-		net::available(*socket)
-	};
+	// Flow control accounts for the entire payload including padding.
+	recv_unacked += size(payload);
 
-	const ssize_t has_pending
+	const_buffer content{payload};
+	size_t pad(0);
+	if(header.flags & uint8_t(http2::frame::flag::PADDED) && !empty(content))
 	{
-		#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(LIBRESSL_VERSION_NUMBER)
-			SSL_has_pending(socket->ssl.native_handle())
-		#else
-			-2L
-		#endif
-	};
+		pad = uint8_t(content[0]);
+		consume(content, 1);
+	}
 
-	const ssize_t pending
+	if(unlikely(!header.stream_id || pad > size(content)))
+		throw http2::error
+		{
+			http2::error::PROTOCOL_ERROR, "Invalid DATA on stream %u",
+			uint(header.stream_id),
+		};
+
+	content = const_buffer
 	{
-		SSL_pending(socket->ssl.native_handle())
+		data(content), size(content) - pad
 	};
 
-	const size_t discarded
+	const auto sit
 	{
-		discard_any(*socket, size_t(pending))
+		streams.find(header.stream_id)
 	};
 
-	if(discarded)
+	if(sit != end(streams))
 	{
-		log::dwarning
+		auto &stream{sit->second};
+		if(unlikely(!stream.head))
+			throw http2::error
+			{
+				http2::error::PROTOCOL_ERROR, "DATA before HEADERS on stream %u",
+				uint(header.stream_id),
+			};
+
+		stream.recv_unacked += size(payload);
+		if(!empty(content) && stream.chunked)
 		{
-			log, "%s q:%zu discarded:%zu pending:%zd has_pending:%zd available:%zd",
-			loghead(*this),
-			queue.size(),
-			discarded,
-			pending,
-			has_pending,
-			available,
-		};
+			char buf[24];
+			feed(link, header.stream_id, fmt::sprintf
+			{
+				buf, "%zx\r\n", size(content)
+			});
+		}
 
-		assert(peer);
-		peer->read_bytes += discarded;
-		return;
+		if(!empty(content))
+			feed(link, header.stream_id, content);
+
+		if(!empty(content) && stream.chunked)
+			feed(link, header.stream_id, "\r\n");
 	}
 
-	throw std::system_error
+	// The stream may have been finished or failed by the feeds.
+	const auto it
 	{
-		net::eof
+		streams.find(header.stream_id)
 	};
-}
 
-size_t
-ircd::server::link::tag_uncommitted()
-const
-{
-	return tag_count() - tag_committed();
-}
+	if(header.flags & uint8_t(http2::frame::flag::END_STREAM))
+		end_stream(link, header.stream_id);
+	else if(it != end(streams) && it->second.recv_unacked >= size_t(http2_window) / 2)
+	{
+		window_update(header.stream_id, it->second.recv_unacked);
+		it->second.recv_unacked = 0;
+	}
 
-size_t
-ircd::server::link::tag_committed()
-const
-{
-	return accumulate_tags([](const auto &tag)
+	if(recv_unacked >= size_t(http2_window) / 2)
 	{
-		return tag.committed();
-	});
+		window_update(0, recv_unacked);
+		recv_unacked = 0;
+	}
 }
 
-size_t
-ircd::server::link::tag_count()
-const
+/// The remote closed its side of the stream; the tag must be done with it.
+void
+ircd::server::link::h2c::end_stream(link &link,
+                                    const uint32_t &id)
 {
-	return queue.size();
-}
+	auto sit
+	{
+		streams.find(id)
+	};
 
-size_t
-ircd::server::link::read_total()
-const
-{
-	return socket? socket->in.bytes : 0;
-}
+	if(sit != end(streams) && sit->second.tag_id && sit->second.chunked)
+		feed(link, id, "0\r\n\r\n");
 
-size_t
-ircd::server::link::write_total()
-const
-{
-	return socket? socket->out.bytes : 0;
-}
+	sit = streams.find(id);
+	if(sit != end(streams) && sit->second.tag_id)
+		return fail(link, id, make_exception_ptr<http2::error>
+		(
+			http2::error::PROTOCOL_ERROR, "Stream %u ended before the response", id
+		));
 
-size_t
-ircd::server::link::read_remaining()
-const
-{
-	return accumulate_tags([](const auto &tag)
-	{
-		return tag.read_remaining();
-	});
+	if(sit != end(streams))
+		streams.erase(sit);
 }
 
-size_t
-ircd::server::link::read_completed()
-const
+/// Feed translated response data to the stream's tag. When the tag is done
+/// it is removed from the queue while the stream remains until closed.
+void
+ircd::server::link::h2c::feed(link &link,
+                              const uint32_t &id,
+                              const string_view &data)
 {
-	return accumulate_tags([](const auto &tag)
+	const auto sit
 	{
-		return tag.read_completed();
-	});
-}
+		streams.find(id)
+	};
 
-size_t
-ircd::server::link::read_size()
-const
-{
-	return accumulate_tags([](const auto &tag)
+	if(sit == end(streams))
+		return;
+
+	const auto it
 	{
-		return tag.read_size();
-	});
-}
+		find(link, sit->second)
+	};
 
-size_t
-ircd::server::link::write_remaining()
-const
-{
-	return accumulate_tags([](const auto &tag)
+	if(it == end(link.queue))
+		return;
+
+	auto &tag{*it};
+	bool done{false};
+	const_buffer remain{data};
+	while(!empty(remain) && !done) try
 	{
-		return tag.write_remaining();
-	});
-}
+		const mutable_buffer buf
+		{
+			tag.make_read_buffer()
+		};
 
-size_t
-ircd::server::link::write_completed()
-const
-{
-	return accumulate_tags([](const auto &tag)
+		const size_t copied
+		{
+			copy(buf, remain)
+		};
+
+		if(unlikely(!copied))
+			throw buffer_overrun
+			{
+				"Buffer of %zu bytes is insufficient to receive the HTTP response.",
+				size(buf),
+			};
+
+		const const_buffer overrun
+		{
+			tag.read_buffer(const_buffer{ircd::data(buf), copied}, done, link)
+		};
+
+		consume(remain, copied - size(overrun));
+	}
+	catch(const std::exception &e)
 	{
-		return tag.write_completed();
-	});
+		rst(id, http2::error::CANCEL);
+		fail(link, id, std::current_exception());
+		return;
+	}
+
+	if(!done)
+		return;
+
+	assert(link.peer);
+	link.peer->handle_tag_done(link, tag);
+	link.queue.erase(it);
+	++link.tag_done;
+	sit->second.tag_id = 0;
 }
 
-size_t
-ircd::server::link::write_size()
-const
+/// Fail the stream's tag with the exception and forget the stream.
+void
+ircd::server::link::h2c::fail(link &link,
+                              const uint32_t &id,
+                              std::exception_ptr eptr)
 {
-	return accumulate_tags([](const auto &tag)
+	const auto sit
 	{
-		return tag.write_size();
-	});
-}
+		streams.find(id)
+	};
 
-bool
-ircd::server::link::busy()
-const
-{
-	return !queue.empty();
-}
+	if(sit == end(streams))
+		return;
 
-bool
-ircd::server::link::ready()
-const
-{
-	return opened() && !op_init && !op_fini;
-}
+	const auto it
+	{
+		find(link, sit->second)
+	};
 
-bool
-ircd::server::link::opened()
-const noexcept
-{
-	return bool(socket) && net::opened(*socket);
+	if(it != end(link.queue))
+	{
+		it->set_exception(std::move(eptr));
+		link.queue.erase(it);
+	}
+
+	streams.erase(sit);
 }
 
-bool
-ircd::server::link::finished()
-const
+ircd::server::link::h2c::iterator
+ircd::server::link::h2c::find(link &link,
+                              const stream &stream)
 {
-	if(!bool(socket))
-		return true;
+	if(!stream.tag_id)
+		return end(link.queue);
 
-	return !opened() && op_fini && !op_init && !op_open && !op_write && !op_read;
+	return std::find_if(begin(link.queue), end(link.queue), [&stream]
+	(const tag &tag)
+	{
+		return tag.state.id == stream.tag_id;
+	});
 }
 
-size_t
-ircd::server::link::tag_commit_max()
-const
+void
+ircd::server::link::h2c::rst(const uint32_t &id,
+                             const enum http2::error::code &code)
 {
-	return tag_commit_max_default;
+	char payload[4];
+	h2_uint32(payload, code);
+	frame(http2::frame::type::RST_STREAM, 0, id, payload);
 }
 
-size_t
-ircd::server::link::tag_max()
-const
+void
+ircd::server::link::h2c::window_update(const uint32_t &id,
+                                       const size_t &inc)
 {
-	return tag_max_default;
+	char payload[4];
+	h2_uint32(payload, inc);
+	frame(http2::frame::type::WINDOW_UPDATE, 0, id, payload);
 }
 
-template<class F>
-size_t
-ircd::server::link::accumulate_tags(F&& closure)
-const
+void
+ircd::server::link::h2c::frame(const http2::frame::type &type,
+                               const uint8_t &flags,
+                               const uint32_t &id,
+                               const const_buffer &payload)
 {
-	return std::accumulate(begin(queue), end(queue), size_t(0), [&closure]
-	(auto ret, const auto &tag)
+	char buf[sizeof(http2::frame::header)];
+	const http2::frame::header header
 	{
-		return ret += closure(tag);
-	});
+		type, flags, id, size(payload)
+	};
+
+	const const_buffer head
+	{
+		header.write(buf)
+	};
+
+	out.append(data(head), size(head));
+	out.append(data(payload), size(payload));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -3050,7 +4583,7 @@ noexcept
 
 	assert(!tag.cancellation);
 	assert(cancellation_size < 64_MiB); // sanity
-	tag.cancellation = unique_buffer<mutable_buffer>
+	tag.cancellation = pooled_buffer
 	{
 		cancellation_size
 	};
@@ -3538,7 +5071,8 @@ ircd::server::tag::read_head(const const_buffer &buffer,
 		if(dynamic)
 		{
 			assert(req.opt);
-			req.in.chunks.reserve(req.opt->chunks_reserve);
+			state.sink = bool(req.in.sink);
+			req.in.chunks.reserve(state.sink? 1: req.opt->chunks_reserve);
 		}
 
 		const const_buffer chunk
@@ -3569,12 +5103,17 @@ ircd::server::tag::read_head(const const_buffer &buffer,
 			"Unsupported transfer-encoding '%s'", head.transfer_encoding
 		};
 
+	// When streaming to a sink the allocation is only a window which is
+	// reused for each read rather than room for the whole content.
 	if(dynamic)
 	{
 		assert(req.opt);
+		state.sink = bool(req.in.sink);
 		const size_t alloc_size
 		{
-			std::min(state.content_length, req.opt->content_length_maxalloc)
+			std::min(state.content_length, state.sink?
+				req.opt->sink_window:
+				req.opt->content_length_maxalloc)
 		};
 
 		req.in.dynamic = unique_buffer<mutable_buffer>{alloc_size};
@@ -3610,14 +5149,16 @@ ircd::server::tag::read_head(const const_buffer &buffer,
 	// how we convey the content-length back to the user. The buffer size will
 	// eventually reflect how much content was actually received; the user can
 	// find the given content-length by parsing the header.
-	req.in.content = mutable_buffer
-	{
-		req.in.content, state.content_length
-	};
+	if(!state.sink)
+		req.in.content = mutable_buffer
+		{
+			req.in.content, state.content_length
+		};
 
 	// Any partial content was written to the head buffer by accident,
-	// that may have to be copied over to the content buffer.
-	if(!empty(partial_content) && !contiguous)
+	// that may have to be copied over to the content buffer. A sink takes
+	// it straight from the head buffer instead.
+	if(!empty(partial_content) && !contiguous && !state.sink)
 		copy(req.in.content, partial_content);
 
 	// Invoke the read_content() routine which will increment this->content_read
@@ -3636,6 +5177,10 @@ ircd::server::tag::read_content(const const_buffer &buffer,
 	auto &req{*request};
 	const auto &content{req.in.content};
 
+	// Branch for streaming; the content buffer is just a window here.
+	if(state.sink)
+		return read_content_sink(buffer, done);
+
 	// The amount of remaining content for the response sequence
 	assert(size(content) + content_overflow() >= state.content_read);
 	assert(size(content) + content_overflow() == state.content_length);
@@ -3694,6 +5239,44 @@ ircd::server::content_completed(tag &tag,
 	else tag.set_value(tag.state.status);
 }
 
+ircd::const_buffer
+ircd::server::tag::read_content_sink(const const_buffer &buffer,
+                                     bool &done)
+{
+	assert(request);
+	assert(state.sink);
+	auto &req{*request};
+
+	// The amount of content read in this buffer only.
+	assert(state.content_length >= state.content_read);
+	const const_buffer content
+	{
+		buffer, std::min(size(buffer), state.content_length - state.content_read)
+	};
+
+	state.content_read += size(content);
+	assert(size(buffer) - size(content) == 0);
+	assert(state.content_read <= state.content_length);
+
+	// The sink is absent if the user canceled; the window is still used to
+	// drain the remainder of the response off the link.
+	if(req.in.sink)
+		req.in.sink(content);
+
+	if(req.in.progress)
+		req.in.progress(content, content);
+
+	if(state.content_read < state.content_length)
+		return {};
+
+	// Nothing remains in the window; release it so the user doesn't mistake
+	// the last read for the content.
+	req.in.content = {};
+	req.in.dynamic = {};
+	content_completed(*this, done);
+	return {};
+}
+
 //
 // chunked encoding into fixed-size buffers
 //
@@ -4045,10 +5628,14 @@ ircd::server::tag::read_chunk_dynamic_head(const const_buffer &buffer,
 	state.content_length += state.chunk_length;
 	assert(state.content_read <= state.content_length);
 
-	// Allocate the chunk content on the vector.
+	// Allocate the chunk content on the vector. When streaming to a sink the
+	// previous chunk was already handed off and only this one is retained.
 	//TODO: maxalloc
+	if(state.sink)
+		req.in.chunks.clear();
+
 	req.in.chunks.emplace_back(state.chunk_length);
-	assert(size_chunks(req.in) == state.content_length);
+	assert(state.sink || size_chunks(req.in) == state.content_length);
 
 	// Now we check how much chunk was received beyond the head
 	// state.chunk_read is still 0 here because that's only incremented
@@ -4188,8 +5775,13 @@ ircd::server::chunk_dynamic_content_completed(tag &tag,
 	assert(size(chunk) == state.chunk_length);
 	assert(std::get<0>(chunk) <= std::get<1>(chunk));
 
+	// Hand the chunk off to the streaming user; the buffer is released when
+	// the next chunk head arrives.
+	if(state.sink && req.in.sink && state.chunk_length > 0)
+		req.in.sink(chunk);
+
 	// State sanity tests
-	assert(state.content_length == size_chunks(req.in));
+	assert(state.sink || state.content_length == size_chunks(req.in));
 	assert(state.content_length >= state.chunk_length);
 	assert(state.content_length >= state.chunk_read);
 	assert(state.content_read >= state.chunk_length);
@@ -4201,6 +5793,9 @@ ircd::server::chunk_dynamic_content_completed(tag &tag,
 
 	assert(state.chunk_read == 0);
 	assert(req.opt);
+	if(state.sink)
+		req.in.chunks.clear();
+
 	if(req.opt->contiguous_content && !req.in.chunks.empty())
 		chunk_dynamic_contiguous_copy(state, req);
 
@@ -4280,7 +5875,7 @@ const
 		state.chunk_length?
 			make_read_chunk_content_buffer():
 
-		state.content_read >= size(request->in.content)?
+		!state.sink && state.content_read >= size(request->in.content)?
 			make_read_discard_buffer():
 
 		make_read_content_buffer()
@@ -4321,9 +5916,16 @@ const
 	assert(request);
 	const auto &req{*request};
 	const auto &content{req.in.content};
+	assert(state.content_length >= state.content_read);
 	const mutable_buffer buffer
 	{
-		content + state.content_read
+		!state.sink?
+			content + state.content_read:
+			mutable_buffer
+			{
+				data(content),
+				std::min(size(content), state.content_length - state.content_read)
+			}
 	};
 
 	if(unlikely(empty(buffer)))
@@ -4533,6 +6135,9 @@ const
 {
 	assert(request);
 	const auto &req{*request};
+	if(state.sink)
+		return 0;
+
 	const ssize_t diff(state.content_length - size(req.in.content));
 	return std::max(diff, ssize_t(0));
 }
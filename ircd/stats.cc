@@ -18,6 +18,10 @@ decltype(ircd::stats::items)
 ircd::stats::items
 {};
 
+decltype(ircd::stats::histograms)
+ircd::stats::histograms
+{};
+
 std::ostream &
 ircd::stats::operator<<(std::ostream &s,
                         const item<void> &item_)
@@ -257,3 +261,66 @@ const noexcept
 
 	return feature[key];
 }
+
+//
+// histogram
+//
+
+ircd::stats::histogram::histogram(const json::members &opts)
+:feature
+{
+	opts
+}
+,name
+{
+	this->operator[]("name")
+}
+,labels
+{
+	this->operator[]("labels")
+}
+{
+	if(unlikely(!name))
+		throw invalid
+		{
+			"Stats histogram must have a 'name' string feature"
+		};
+
+	if(unlikely(name.size() > NAME_MAX_LEN))
+		throw invalid
+		{
+			"Stats histogram '%s' name length:%zu exceeds max:%zu",
+			name,
+			name.size(),
+			NAME_MAX_LEN
+		};
+
+	histograms.emplace_back(this);
+}
+
+ircd::stats::histogram::~histogram()
+noexcept
+{
+	if(!name)
+		return;
+
+	const auto it
+	{
+		std::find(begin(histograms), end(histograms), this)
+	};
+
+	if(it != end(histograms))
+		histograms.erase(it);
+}
+
+ircd::string_view
+ircd::stats::histogram::operator[](const string_view &key)
+const noexcept
+{
+	const json::object feature
+	{
+		this->feature
+	};
+
+	return feature[key];
+}
@@ -8,6 +8,9 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_SYS_SYSCALL_H
+#include <RB_INC_LINUX_MEMPOLICY_H
+
 decltype(ircd::sys::log)
 ircd::sys::log
 {
@@ -58,3 +61,89 @@ catch(const std::exception &e)
 
 	return {};
 }
+
+bool
+ircd::sys::cpulist(const string_view &list,
+                   const cpulist_closure &closure)
+{
+	return ircd::tokens(list, ',', [&closure]
+	(const string_view &range) -> bool
+	{
+		const auto &[lo, hi]
+		{
+			split(strip(range, ' '), '-')
+		};
+
+		if(!lex_castable<uint>(lo))
+			return true;
+
+		const uint first(lex_cast<uint>(lo));
+		const uint last(lex_castable<uint>(hi)? lex_cast<uint>(hi): first);
+		for(uint i(first); i <= last; ++i)
+			if(!closure(i))
+				return false;
+
+		return true;
+	});
+}
+
+size_t
+ircd::sys::affinity(const string_view &list)
+{
+	#if defined(__linux__) && defined(CPU_SET)
+	size_t ret(0);
+	::cpu_set_t set;
+	CPU_ZERO(&set);
+	cpulist(list, [&set, &ret]
+	(const uint &cpu)
+	{
+		if(cpu >= CPU_SETSIZE)
+			return false;
+
+		CPU_SET(cpu, &set);
+		++ret;
+		return true;
+	});
+
+	if(!ret)
+		return 0;
+
+	sys::call(::sched_setaffinity, 0, sizeof(set), &set);
+	return ret;
+	#else
+	return 0;
+	#endif
+}
+
+int
+ircd::sys::numa_node()
+noexcept
+{
+	#if defined(SYS_getcpu)
+	uint cpu(0), node(0);
+	if(::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+		return node;
+	#endif
+
+	return -1;
+}
+
+bool
+ircd::sys::numa_prefer(const mutable_buffer &buf,
+                       const int &node)
+noexcept
+{
+	#if defined(SYS_mbind) && defined(MPOL_PREFERRED)
+	if(node < 0 || node >= int(sizeof(ulong) * 8))
+		return false;
+
+	const ulong mask
+	{
+		1UL << node
+	};
+
+	return ::syscall(SYS_mbind, data(buf), size(buf), MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0) == 0;
+	#else
+	return false;
+	#endif
+}
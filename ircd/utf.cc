@@ -380,6 +380,126 @@ noexcept
 	return integers;
 }
 
+namespace ircd::utf8
+{
+	static u64x2 valid_block(const u8x16 block, const u8x16 block_mask) noexcept;
+}
+
+bool
+ircd::utf8::valid(const string_view &string)
+noexcept
+{
+	using block_t = u8x16;
+
+	const u64x2 max
+	{
+		0, size(string)
+	};
+
+	const auto res
+	{
+		simd::for_each<block_t>(data(string), max, valid_block)
+	};
+
+	return res[0] == 0;
+}
+
+/// Validates the complete sequences in a block which always starts on a
+/// character boundary. The first return lane is non-zero for any error,
+/// which also ends the loop by consuming nothing. Otherwise the block is
+/// consumed up to any multibyte sequence running off its end, so the next
+/// block starts with that sequence intact. Bytes past the end of the input
+/// are zero in the last block and fail any sequence expecting them.
+ircd::u64x2
+ircd::utf8::valid_block(const u8x16 in,
+                        const u8x16 block_mask)
+noexcept
+{
+	// Fastest-path; all ascii.
+	if(likely(!simd::any(u8x16(in & 0x80))))
+		return u64x2
+		{
+			0, sizeof(u8x16)
+		};
+
+	const u8x16 is_cont
+	(
+		(in & 0xc0) == 0x80
+	);
+
+	const u8x16 is_lead2
+	(
+		in >= 0xc2 && in <= 0xdf
+	);
+
+	const u8x16 is_lead3
+	(
+		(in & 0xf0) == 0xe0
+	);
+
+	const u8x16 is_lead4
+	(
+		in >= 0xf0 && in <= 0xf4
+	);
+
+	// Overlong two-byte leads and bytes which never appear in utf-8.
+	const u8x16 is_illegal
+	(
+		(in & 0xfe) == 0xc0 || in >= 0xf5
+	);
+
+	// Each position where the preceding lead requires a continuation.
+	const u8x16 want_cont
+	{
+		shl<0x08>(is_lead2 | is_lead3 | is_lead4) |
+		shl<0x10>(is_lead3 | is_lead4) |
+		shl<0x18>(is_lead4)
+	};
+
+	// Constraints on the second byte of some three and four byte sequences
+	// to exclude overlong forms, surrogates and codepoints past U+10FFFF.
+	const u8x16 prev
+	{
+		shl<0x08>(in)
+	};
+
+	const u8x16 is_range_error
+	(
+		(prev == 0xe0 && in < 0xa0) ||
+		(prev == 0xed && in > 0x9f) ||
+		(prev == 0xf0 && in < 0x90) ||
+		(prev == 0xf4 && in > 0x8f)
+	);
+
+	const u8x16 error
+	{
+		is_illegal | is_range_error | (is_cont ^ want_cont)
+	};
+
+	if(unlikely(simd::any(error)))
+		return u64x2
+		{
+			1, 0
+		};
+
+	// Leave any sequence truncated by the end of the block for the next.
+	const u64 truncated
+	{
+		is_lead4[0xd]?
+			3UL:
+		(is_lead3[0xe] | is_lead4[0xe])?
+			2UL:
+		(is_lead2[0xf] | is_lead3[0xf] | is_lead4[0xf])?
+			1UL:
+			0UL
+	};
+
+	return u64x2
+	{
+		0, sizeof(u8x16) - truncated
+	};
+}
+
 namespace ircd::utf8
 {
 	template<class u32xN> static u32xN _encode(const u32xN codepoint) noexcept;
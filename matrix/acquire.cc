@@ -591,9 +591,11 @@ ircd::m::acquire::submit(const m::event::id &event_id,
                          const size_t &limit,
                          const vm::opts *const &vmopts)
 {
+	// Events already sought by another acquisition, fetch or eval are left
+	// to that demand; a later round finds them again if it fails.
 	const bool ret
 	{
-		!started(event_id)?
+		!started(event_id) && !fetch::inflight(event_id)?
 			start(event_id, hint, hint_only, limit, vmopts):
 			false
 	};
@@ -73,10 +73,97 @@ ircd::m::dbs::sst_write_buffer_size
 	}
 };
 
+/// Threshold of the estimated bytes pending compaction for the events
+/// database beyond which admission of remote work is throttled before the
+/// database itself begins to stall writes. Zero disables this criterion.
+decltype(ircd::m::dbs::stall_pending_max)
+ircd::m::dbs::stall_pending_max
+{
+	{ "name",     "ircd.m.dbs.stall.pending.max" },
+	{ "default",  long(32_GiB)                   },
+};
+
+namespace ircd::m::dbs::warmup
+{
+	static std::string path(const string_view &dbpath);
+	static size_t save(const string_view &path);
+	static size_t load(const string_view &path);
+	static void worker(const std::string &path);
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> scan;
+	extern conf::item<size_t> max;
+	extern conf::item<size_t> batch;
+	extern conf::item<milliseconds> interval;
+}
+
+decltype(ircd::m::dbs::warmup::enable)
+ircd::m::dbs::warmup::enable
+{
+	{ "name",     "ircd.m.dbs.warmup.enable" },
+	{ "default",  true                       },
+	{ "description",
+
+	R"(
+	Save the indexes of recent events which are in the cache on clean shutdown
+	and prefetch them in the background on the next startup.
+	)"}
+};
+
+decltype(ircd::m::dbs::warmup::scan)
+ircd::m::dbs::warmup::scan
+{
+	{ "name",     "ircd.m.dbs.warmup.scan" },
+	{ "default",  65536L                   },
+	{ "description",
+
+	R"(
+	Number of the most recent events tested for residence in the cache when
+	saving the warmup file at shutdown.
+	)"}
+};
+
+decltype(ircd::m::dbs::warmup::max)
+ircd::m::dbs::warmup::max
+{
+	{ "name",     "ircd.m.dbs.warmup.max" },
+	{ "default",  16384L                  },
+	{ "description",
+
+	R"(
+	Maximum number of event indexes saved in the warmup file.
+	)"}
+};
+
+decltype(ircd::m::dbs::warmup::batch)
+ircd::m::dbs::warmup::batch
+{
+	{ "name",     "ircd.m.dbs.warmup.batch" },
+	{ "default",  64L                       },
+	{ "description",
+
+	R"(
+	Number of events prefetched by the warmup before it sleeps for the
+	interval; the warmup also waits while the database prefetcher is busy.
+	)"}
+};
+
+decltype(ircd::m::dbs::warmup::interval)
+ircd::m::dbs::warmup::interval
+{
+	{ "name",     "ircd.m.dbs.warmup.interval" },
+	{ "default",  100L                         },
+};
+
 //
 // init
 //
 
+namespace ircd::m::dbs
+{
+	static bool init_rebuild(const conf::item<bool> &, db::column &, db::column &, size_t (&)());
+}
+
 /// Initializes the m::dbs subsystem; sets up the events database. Held/called
 /// by m::init. Most of the extern variables in m::dbs are not ready until
 /// this call completes.
@@ -101,6 +188,13 @@ ircd::m::dbs::init::init(const string_view &servername,
 {
 	fs::base::db
 }
+,warmup
+{
+	"m.dbs.warmup",
+	256_KiB,
+	context::POST,
+	std::bind(&warmup::worker, warmup::path(our_dbpath))
+}
 {
 	// NOTE that this is a global change that leaks outside of ircd::m. The
 	// database directory for the entire process is being changed here.
@@ -139,6 +233,92 @@ ircd::m::dbs::init::init(const string_view &servername,
 	room_joined = db::domain{*events, desc::room_joined.name};
 	room_state = db::domain{*events, desc::room_state.name};
 	room_state_space = db::domain{*events, desc::room_state_space.name};
+	room_counts = db::column{*events, desc::room_counts.name};
+	room_heroes = db::column{*events, desc::room_heroes.name};
+	room_idx = db::column{*events, desc::room_idx.name};
+	room_unread = db::column{*events, desc::room_unread.name};
+	room_search = db::column{*events, desc::room_search.name};
+	event_chain = db::column{*events, desc::event_chain.name};
+	event_relates = db::column{*events, desc::event_relates.name};
+	room_threads = db::column{*events, desc::room_threads.name};
+	device_inbox = db::column{*events, desc::device_inbox.name};
+	device_one_time_key = db::column{*events, desc::device_one_time_key.name};
+	user_room_keys = db::column{*events, desc::user_room_keys.name};
+
+	// Build the indexes which a database predates from the columns they are
+	// derived from.
+	init_rebuild(desc::room_counts__rebuild, room_counts, room_events, room_counts_rebuild);
+	init_rebuild(desc::room_heroes__rebuild, room_heroes, room_state, room_heroes_rebuild);
+	init_rebuild(desc::room_idx__rebuild, room_idx, room_type, room_idx_rebuild);
+	init_rebuild(desc::event_chain__rebuild, event_chain, event_column.at(json::indexof<event, "state_key"_>()), event_chain_rebuild);
+	init_rebuild(desc::event_relates__rebuild, event_relates, event_refs, event_relates_rebuild);
+
+	// Index the content of a database which predates room_search when so
+	// configured; otherwise indexing starts from the next event, and those
+	// before are found by scanning.
+	const bool room_search_init_needed
+	{
+		!events->read_only
+		&& !events->slave
+		&& !room_search.begin()
+	};
+
+	if(room_search_init_needed && desc::room_search__rebuild)
+		room_search_rebuild();
+	else if(room_search_init_needed)
+	{
+		const auto it(event_json.last());
+		room_search_floor(it? byte_view<event::idx>(it->first) + 1: 0UL);
+	}
+}
+
+/// Builds an index column for a database which predates it. A column which
+/// was just created for an existing database is found empty while the column
+/// it is derived from is not. The rebuilds must not run concurrently with
+/// evaluation, so they run here in init, before the vm; on a large database
+/// they can take hours, so the start and the duration are always logged in
+/// addition to the progress logged by each rebuild.
+bool
+ircd::m::dbs::init_rebuild(const conf::item<bool> &enable,
+                           db::column &column,
+                           db::column &source,
+                           size_t (&rebuild)())
+{
+	const bool needed
+	{
+		enable
+		&& !events->read_only
+		&& !events->slave
+		&& !column.begin()
+		&& bool(source.begin())
+	};
+
+	if(!needed)
+		return false;
+
+	log::notice
+	{
+		log, "Building %s from %s for an existing database; this may take a long time...",
+		db::name(column),
+		db::name(source),
+	};
+
+	const ircd::timer timer;
+	const size_t count
+	{
+		rebuild()
+	};
+
+	char pbuf[48];
+	log::notice
+	{
+		log, "Built %s with %zu entries in %s.",
+		db::name(column),
+		count,
+		timer.pretty(pbuf),
+	};
+
+	return true;
 }
 
 /// Shuts down the m::dbs subsystem; closes the events database. The extern
@@ -146,6 +326,16 @@ ircd::m::dbs::init::init(const string_view &servername,
 ircd::m::dbs::init::~init()
 noexcept
 {
+	warmup.terminate();
+	warmup.join();
+
+	// Save the warmup before closing while the cache is still populated.
+	if(events && warmup::enable && !events->read_only && !events->slave)
+	{
+		const auto path(warmup::path(our_dbpath));
+		warmup::save(path);
+	}
+
 	// Unref DB (should close)
 	events = {};
 
@@ -153,6 +343,186 @@ noexcept
 	fs::base::db.set(their_dbpath);
 }
 
+//
+// warmup
+//
+
+std::string
+ircd::m::dbs::warmup::path(const string_view &dbpath)
+{
+	return fs::path_string(fs::path_views
+	{
+		dbpath, "events.warmup"
+	});
+}
+
+/// Tests the most recent events for residence in the cache and writes the
+/// indexes of those found to the file at path. The block cache is keyed by
+/// internal table offsets which can't be prefetched by the next instance;
+/// an index of the event at the user level is saved instead.
+size_t
+ircd::m::dbs::warmup::save(const string_view &path)
+try
+{
+	const event::idx &top
+	{
+		vm::sequence::retired
+	};
+
+	std::vector<event::idx> hot;
+	hot.reserve(std::min(size_t(max), size_t(scan)));
+	for(event::idx i(top); i > 0 && top - i < size_t(scan) && hot.size() < size_t(max); --i)
+		if(db::cached(event_json, byte_view<string_view>(i)))
+			hot.emplace_back(i);
+
+	const const_buffer buf
+	{
+		reinterpret_cast<const char *>(hot.data()), hot.size() * sizeof(event::idx)
+	};
+
+	fs::overwrite(path, buf);
+	log::info
+	{
+		log, "Saved %zu cached of the last %zu events for warmup to `%s'",
+		hot.size(),
+		std::min(size_t(top), size_t(scan)),
+		path,
+	};
+
+	return hot.size();
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Failed to save cache warmup to `%s' :%s",
+		path,
+		e.what(),
+	};
+
+	return 0;
+}
+
+/// Prefetches the events listed in the file at path. This is throttled to
+/// not compete with requests for the database from live traffic.
+size_t
+ircd::m::dbs::warmup::load(const string_view &path)
+{
+	const fs::fd file
+	{
+		path, fs::fd::opts{std::ios::in}
+	};
+
+	const std::string buf
+	{
+		fs::read(file)
+	};
+
+	const vector_view<const event::idx> hot
+	{
+		reinterpret_cast<const event::idx *>(buf.data()), size(buf) / sizeof(event::idx)
+	};
+
+	static const event::fetch::opts fopts
+	{
+		event::keys::include
+		{
+			"event_id", "room_id", "type", "state_key",
+		}
+	};
+
+	const ctx::priority priority
+	{
+		ctx::sched::BACKGROUND
+	};
+
+	size_t ret(0);
+	for(size_t i(0); i < hot.size(); ++i)
+	{
+		if(i % std::max(size_t(batch), 1UL) == 0)
+		{
+			ctx::sleep(milliseconds(interval));
+			while(db::prefetcher && !db::prefetcher->queue.empty())
+				ctx::sleep(milliseconds(interval));
+		}
+
+		const auto &event_idx(hot[i]);
+		if(!event_idx || event_idx > vm::sequence::retired)
+			continue;
+
+		ret += m::prefetch(event_idx);
+
+		// The event_idx and room_state require properties of the event to
+		// make their keys; this fetch blocks this context only.
+		const m::event::fetch event
+		{
+			std::nothrow, event_idx, fopts
+		};
+
+		if(!event.valid)
+			continue;
+
+		ret += m::prefetch(event.event_id, "_event_idx");
+		if(defined(json::get<"state_key"_>(event)))
+			ret += m::room::state{m::room::id{json::get<"room_id"_>(event)}}.prefetch
+			(
+				json::get<"type"_>(event), json::get<"state_key"_>(event)
+			);
+	}
+
+	return ret;
+}
+
+void
+ircd::m::dbs::warmup::worker(const std::string &path)
+try
+{
+	run::barrier<ctx::interrupted> {};
+
+	if(!enable || !fs::exists(path))
+		return;
+
+	const auto count
+	{
+		fs::size(path) / sizeof(event::idx)
+	};
+
+	log::info
+	{
+		log, "Cache warmup of %zu events from `%s'...",
+		count,
+		path,
+	};
+
+	const util::timer timer;
+	const auto prefetched
+	{
+		load(path)
+	};
+
+	char pbuf[48];
+	log::info
+	{
+		log, "Cache warmup of %zu events made %zu prefetches in %s",
+		count,
+		prefetched,
+		timer.pretty(pbuf),
+	};
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Cache warmup from `%s' :%s",
+		path,
+		e.what(),
+	};
+}
+
 /// Cancels all background work by the events database. This will make the
 /// database shutdown more fluid, without waiting for large compactions.
 static const ircd::run::changed
@@ -165,6 +535,41 @@ ircd_m_dbs_handle_quit
 	}
 };
 
+/// True when writes to the events database are being delayed or stopped by
+/// RocksDB, or when the compaction debt has reached the threshold. This is
+/// used to refuse or defer remote work before it reaches the commit path and
+/// blocks there.
+bool
+ircd::m::dbs::stalled()
+noexcept try
+{
+	if(!events || events->read_only)
+		return false;
+
+	if(db::stopped(*events) || db::delayed(*events))
+		return true;
+
+	if(!size_t(stall_pending_max))
+		return false;
+
+	const auto pending
+	{
+		db::property(*events, "rocksdb.estimate-pending-compaction-bytes")
+	};
+
+	return pending >= size_t(stall_pending_max);
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Failed to determine stall conditions :%s",
+		e.what(),
+	};
+
+	return false;
+}
+
 //
 // write_opts
 //
@@ -354,6 +759,9 @@ ircd::m::dbs::_index_event(db::txn &txn,
 
 	if(opts.appendix.test(appendix::EVENT_HORIZON_RESOLVE) && opts.horizon_resolve.any())
 		_index_event_horizon_resolve(txn, event, opts);
+
+	if(opts.appendix.test(appendix::EVENT_CHAIN))
+		_index_event_chain(txn, event, opts);
 }
 
 size_t
@@ -385,6 +793,9 @@ ircd::m::dbs::_prefetch_event(const event &event,
 	if(opts.appendix.test(appendix::EVENT_HORIZON_RESOLVE) && opts.horizon_resolve.any())
 		ret += _prefetch_event_horizon_resolve(event, opts);
 
+	if(opts.appendix.test(appendix::EVENT_CHAIN))
+		;//ret += _prefetch_event_chain(event, opts);
+
 	return ret;
 }
 
@@ -395,6 +806,9 @@ ircd::m::dbs::_index_room(db::txn &txn,
 {
 	assert(!empty(json::get<"room_id"_>(event)));
 
+	if(opts.appendix.test(appendix::ROOM_IDX))
+		_index_room_idx(txn, event, opts);
+
 	if(opts.appendix.test(appendix::ROOM_EVENTS))
 		_index_room_events(txn, event, opts);
 
@@ -417,10 +831,22 @@ ircd::m::dbs::_index_room(db::txn &txn,
 
 		if(opts.appendix.test(appendix::ROOM_JOINED) && at<"type"_>(event) == "m.room.member")
 			_index_room_joined(txn, event, opts);
+
+		if(opts.appendix.test(appendix::ROOM_JOINED) && opts.appendix.test(appendix::ROOM_HEROES) && at<"type"_>(event) == "m.room.member")
+			_index_room_heroes(txn, event, opts);
 	}
 
 	if(opts.appendix.test(appendix::ROOM_REDACT) && json::get<"type"_>(event) == "m.room.redaction")
 		_index_room_redact(txn, event, opts);
+
+	if(opts.appendix.test(appendix::ROOM_COUNTS))
+		_index_room_counts(txn, event, opts);
+
+	if(opts.appendix.test(appendix::ROOM_UNREAD))
+		_index_room_unread(txn, event, opts);
+
+	if(opts.appendix.test(appendix::ROOM_SEARCH))
+		_index_room_search(txn, event, opts);
 }
 
 size_t
@@ -430,6 +856,9 @@ ircd::m::dbs::_prefetch_room(const event &event,
 	assert(!empty(json::get<"room_id"_>(event)));
 
 	size_t ret(0);
+	if(opts.appendix.test(appendix::ROOM_IDX))
+		;//ret += _prefetch_room_idx(event, opts);
+
 	if(opts.appendix.test(appendix::ROOM_EVENTS))
 		;//ret += _prefetch_room_events(event, opts);
 
@@ -452,11 +881,23 @@ ircd::m::dbs::_prefetch_room(const event &event,
 
 		if(opts.appendix.test(appendix::ROOM_JOINED) && at<"type"_>(event) == "m.room.member")
 			;//ret += _prefetch_room_joined(event, opts);
+
+		if(opts.appendix.test(appendix::ROOM_JOINED) && opts.appendix.test(appendix::ROOM_HEROES) && at<"type"_>(event) == "m.room.member")
+			;//ret += _prefetch_room_heroes(event, opts);
 	}
 
 	if(opts.appendix.test(appendix::ROOM_REDACT) && json::get<"type"_>(event) == "m.room.redaction")
 		ret += _prefetch_room_redact(event, opts);
 
+	if(opts.appendix.test(appendix::ROOM_COUNTS))
+		;//ret += _prefetch_room_counts(event, opts);
+
+	if(opts.appendix.test(appendix::ROOM_UNREAD))
+		;//ret += _prefetch_room_unread(event, opts);
+
+	if(opts.appendix.test(appendix::ROOM_SEARCH))
+		;//ret += _prefetch_room_search(event, opts);
+
 	return ret;
 }
 
@@ -494,6 +935,9 @@ ircd::m::dbs::_index_room_redact(db::txn &txn,
 		return;
 	}
 
+	if(opts.appendix.test(appendix::EVENT_RELATES))
+		_index_event_relates_redact(txn, target_idx, opts);
+
 	char state_key_buf[event::STATE_KEY_MAX_SIZE];
 	const string_view &state_key
 	{
@@ -529,6 +529,50 @@ ircd::m::dbs::desc::events
 	// Mapping of all current head events for a room.
 	room_head,
 
+	// (room_id) => (int64_t[])
+	// Materialized counters for a room.
+	room_counts,
+
+	// (room_id) => ((+|-)user_id\0...)
+	// Leading members of a room for its summary.
+	room_heroes,
+
+	// (room_id) => (room_idx)
+	// Mapping of room_id strings to the room_idx interning them.
+	room_idx,
+
+	// (user_room_id, room_id) => (int64_t[])
+	// Unread notification counters for a user in a room.
+	room_unread,
+
+	// (room_id, term, ~bucket) => (varint[])
+	// Inverted index of the terms of message content in a room.
+	room_search,
+
+	// (event_idx) => (chain, seq, cover[]) || (chain, ~seq) => (event_idx)
+	// Chain cover of the auth DAG.
+	event_chain,
+
+	// (event_idx) => ((count, latest, rel_type, key)[])
+	// Aggregations of the relations to an event.
+	event_relates,
+
+	// (room_id, root_idx) => (event_idx)
+	// Thread roots of a room with their latest reply.
+	room_threads,
+
+	// (user_id, device_id, sequence, n) => (message)
+	// To-device messages queued for each device.
+	device_inbox,
+
+	// (user_id, device_id, algorithm, name) => (key)
+	// One-time keys of each device with a counter for each algorithm.
+	device_one_time_key,
+
+	// (user_id, version, room_id, session_id) => (session)
+	// Room key backups of each user.
+	user_room_keys,
+
 	//
 	// These columns are legacy; they have been dropped from the schema.
 	//
@@ -0,0 +1,329 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static string_view device_inbox_prefix(const mutable_buffer &, const id::user &, const string_view &device_id);
+
+	extern uint64_t device_inbox_n;
+}
+
+decltype(ircd::m::dbs::device_inbox)
+ircd::m::dbs::device_inbox;
+
+decltype(ircd::m::dbs::desc::device_inbox__comp)
+ircd::m::dbs::desc::device_inbox__comp
+{
+	{ "name",     "ircd.m.dbs._device_inbox.comp" },
+	{ "default",  "default"                       },
+};
+
+decltype(ircd::m::dbs::desc::device_inbox__block__size)
+ircd::m::dbs::desc::device_inbox__block__size
+{
+	{ "name",     "ircd.m.dbs._device_inbox.block.size" },
+	{ "default",  512L                                  },
+};
+
+decltype(ircd::m::dbs::desc::device_inbox__meta_block__size)
+ircd::m::dbs::desc::device_inbox__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._device_inbox.meta_block.size" },
+	{ "default",  1024L                                      },
+};
+
+decltype(ircd::m::dbs::desc::device_inbox__cache__size)
+ircd::m::dbs::desc::device_inbox__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._device_inbox.cache.size" },
+		{ "default",  long(8_MiB)                           },
+	}, []
+	{
+		const size_t &value{device_inbox__cache__size};
+		db::capacity(db::cache(dbs::device_inbox), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::device_inbox__cache_comp__size)
+ircd::m::dbs::desc::device_inbox__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._device_inbox.cache_comp.size" },
+		{ "default",  long(0_MiB)                                },
+	}, []
+	{
+		const size_t &value{device_inbox__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::device_inbox), value);
+	}
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::device_inbox
+{
+	// name
+	"_device_inbox",
+
+	// explanation
+	R"(Queue of the to-device messages of each device.
+
+	user_id | device_id, sequence, n => message
+
+	A message to a device is queued here rather than as an event; the device
+	receives what is queued in order with one seek, and what it has received
+	is deleted by one range deletion when it acknowledges by syncing after.
+	The sequence is the vm::sequence next when the message was queued.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(device_inbox__block__size),
+
+	// meta_block size
+	size_t(device_inbox__meta_block__size),
+
+	// compression
+	string_view{device_inbox__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 1,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	false,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+};
+
+/// The tie-breaker is seeded by the clock so the positions of messages
+/// queued after a restart at an unchanged sequence remain greater.
+decltype(ircd::m::dbs::device_inbox_n)
+ircd::m::dbs::device_inbox_n
+{
+	uint64_t(ircd::time<microseconds>())
+};
+
+//
+// interface
+//
+
+/// Appends the message to the queue of the device; the txn is committed by
+/// the caller, usually after appending the messages of a whole EDU.
+ircd::m::dbs::device_inbox_pos
+ircd::m::dbs::device_inbox_put(db::txn &txn,
+                               const id::user &user_id,
+                               const string_view &device_id,
+                               const json::object &message)
+{
+	const device_inbox_pos pos
+	{
+		vm::sequence::retired + 1, ++device_inbox_n
+	};
+
+	char buf[DEVICE_INBOX_KEY_MAX_SIZE];
+	db::txn::append
+	{
+		txn, device_inbox,
+		{
+			db::op::SET,
+			device_inbox_key(buf, user_id, device_id, pos),
+			message,
+		}
+	};
+
+	return pos;
+}
+
+/// Deletes the messages of the device through the position with one range
+/// deletion.
+void
+ircd::m::dbs::device_inbox_del(const id::user &user_id,
+                               const string_view &device_id,
+                               const device_inbox_pos &through)
+{
+	char buf[2][DEVICE_INBOX_KEY_MAX_SIZE];
+	const string_view begin
+	{
+		device_inbox_prefix(buf[0], user_id, device_id)
+	};
+
+	const string_view end
+	{
+		device_inbox_key(buf[1], user_id, device_id, device_inbox_pos
+		{
+			through.first, through.second + 1
+		})
+	};
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	db::txn::append
+	{
+		txn, device_inbox,
+		{
+			db::op::DELETE_RANGE, begin, end
+		}
+	};
+
+	txn();
+}
+
+/// Iterates the queue of the device in order of position.
+bool
+ircd::m::dbs::device_inbox_for_each(const id::user &user_id,
+                                    const string_view &device_id,
+                                    const device_inbox_closure &closure)
+{
+	char buf[DEVICE_INBOX_KEY_MAX_SIZE];
+	const string_view prefix
+	{
+		device_inbox_prefix(buf, user_id, device_id)
+	};
+
+	constexpr size_t pos_size
+	{
+		sizeof(event::idx) + sizeof(uint64_t)
+	};
+
+	for(auto it(device_inbox.lower_bound(prefix)); it; ++it)
+	{
+		const auto &[key, val]
+		{
+			*it
+		};
+
+		if(!startswith(key, prefix) || size(key) != size(prefix) + pos_size)
+			break;
+
+		const string_view pos_key
+		{
+			key.substr(size(prefix))
+		};
+
+		const device_inbox_pos pos
+		{
+			ntoh(uint64_t(byte_view<uint64_t>(pos_key.substr(0, sizeof(event::idx))))),
+			ntoh(uint64_t(byte_view<uint64_t>(pos_key.substr(sizeof(event::idx))))),
+		};
+
+		if(!closure(pos, json::object{val}))
+			return false;
+	}
+
+	return true;
+}
+
+/// The position is big-endian so the queue of a device is in order.
+ircd::string_view
+ircd::m::dbs::device_inbox_key(const mutable_buffer &out_,
+                               const id::user &user_id,
+                               const string_view &device_id,
+                               const device_inbox_pos &pos)
+{
+	const uint64_t seq_be
+	{
+		hton(uint64_t(pos.first))
+	};
+
+	const uint64_t n_be
+	{
+		hton(uint64_t(pos.second))
+	};
+
+	mutable_buffer out{out_};
+	consume(out, size(device_inbox_prefix(out, user_id, device_id)));
+	consume(out, copy(out, byte_view<string_view>(seq_be)));
+	consume(out, copy(out, byte_view<string_view>(n_be)));
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::device_inbox_prefix(const mutable_buffer &out_,
+                                  const id::user &user_id,
+                                  const string_view &device_id)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, string_view{user_id}));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, device_id));
+	consume(out, copy(out, '\0'));
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
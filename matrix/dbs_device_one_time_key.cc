@@ -0,0 +1,430 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static string_view device_one_time_key_prefix(const mutable_buffer &, const id::user &, const string_view &device_id, const string_view &algorithm);
+	static string_view device_one_time_key_count_key(const mutable_buffer &, const id::user &, const string_view &device_id, const string_view &algorithm);
+	static void device_one_time_key_count_add(db::txn &, const id::user &, const string_view &device_id, const string_view &algorithm, const int64_t &);
+	static std::string device_one_time_key__merge_add(const string_view &, const db::merge_delta &);
+
+	extern ctx::mutex device_one_time_key_mutex;
+}
+
+decltype(ircd::m::dbs::device_one_time_key)
+ircd::m::dbs::device_one_time_key;
+
+decltype(ircd::m::dbs::desc::device_one_time_key__comp)
+ircd::m::dbs::desc::device_one_time_key__comp
+{
+	{ "name",     "ircd.m.dbs._device_one_time_key.comp" },
+	{ "default",  "default"                              },
+};
+
+decltype(ircd::m::dbs::desc::device_one_time_key__block__size)
+ircd::m::dbs::desc::device_one_time_key__block__size
+{
+	{ "name",     "ircd.m.dbs._device_one_time_key.block.size" },
+	{ "default",  512L                                         },
+};
+
+decltype(ircd::m::dbs::desc::device_one_time_key__meta_block__size)
+ircd::m::dbs::desc::device_one_time_key__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._device_one_time_key.meta_block.size" },
+	{ "default",  1024L                                             },
+};
+
+decltype(ircd::m::dbs::desc::device_one_time_key__cache__size)
+ircd::m::dbs::desc::device_one_time_key__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._device_one_time_key.cache.size" },
+		{ "default",  long(8_MiB)                                  },
+	}, []
+	{
+		const size_t &value{device_one_time_key__cache__size};
+		db::capacity(db::cache(dbs::device_one_time_key), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::device_one_time_key__cache_comp__size)
+ircd::m::dbs::desc::device_one_time_key__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._device_one_time_key.cache_comp.size" },
+		{ "default",  long(0_MiB)                                       },
+	}, []
+	{
+		const size_t &value{device_one_time_key__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::device_one_time_key), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::device_one_time_key__merge)
+ircd::m::dbs::desc::device_one_time_key__merge
+{
+	device_one_time_key__merge_add
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::device_one_time_key
+{
+	// name
+	"_device_one_time_key",
+
+	// explanation
+	R"(One-time keys uploaded by each device, with a count of each algorithm.
+
+	user_id | device_id, algorithm, name => key
+	user_id | device_id, "", algorithm => int64_t
+
+	A claim pops the first key of the algorithm and merges a decrement into
+	its count; an upload puts each new key and merges an increment. The
+	counts of a device sort ahead of its keys (no algorithm is empty), so
+	they are read with one short seek without visiting the keys.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(device_one_time_key__block__size),
+
+	// meta_block size
+	size_t(device_one_time_key__meta_block__size),
+
+	// compression
+	string_view{device_one_time_key__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 1,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	false,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	device_one_time_key__merge,
+};
+
+/// Claims are serialized; the first key is read before it is deleted and
+/// two claims would otherwise pop the same key.
+decltype(ircd::m::dbs::device_one_time_key_mutex)
+ircd::m::dbs::device_one_time_key_mutex;
+
+//
+// interface
+//
+
+/// Appends the key and the increment of its count unless the device has a
+/// key by that name already; the txn is committed by the caller, usually
+/// after appending all the keys of an upload.
+bool
+ircd::m::dbs::device_one_time_key_put(db::txn &txn,
+                                      const id::user &user_id,
+                                      const string_view &device_id,
+                                      const string_view &algorithm,
+                                      const string_view &name,
+                                      const string_view &key)
+{
+	if(unlikely(empty(algorithm) || empty(name)))
+		return false;
+
+	if(unlikely(size(algorithm) > 128 || size(name) > 128))
+		return false;
+
+	char buf[DEVICE_ONE_TIME_KEY_KEY_MAX_SIZE];
+	mutable_buffer out{buf};
+	consume(out, size(device_one_time_key_prefix(out, user_id, device_id, algorithm)));
+	consume(out, copy(out, name));
+	const string_view full_key
+	{
+		buf, data(out)
+	};
+
+	if(db::has(device_one_time_key, full_key))
+		return false;
+
+	db::txn::append
+	{
+		txn, device_one_time_key,
+		{
+			db::op::SET, full_key, key
+		}
+	};
+
+	device_one_time_key_count_add(txn, user_id, device_id, algorithm, 1L);
+	return true;
+}
+
+/// Deletes the first key of the algorithm for the device, passing it to the
+/// closure first. False when the device has none.
+bool
+ircd::m::dbs::device_one_time_key_pop(const id::user &user_id,
+                                      const string_view &device_id,
+                                      const string_view &algorithm,
+                                      const device_one_time_key_closure &closure)
+{
+	if(unlikely(empty(algorithm) || size(algorithm) > 128))
+		return false;
+
+	const std::lock_guard lock
+	{
+		device_one_time_key_mutex
+	};
+
+	char buf[DEVICE_ONE_TIME_KEY_KEY_MAX_SIZE];
+	const string_view prefix
+	{
+		device_one_time_key_prefix(buf, user_id, device_id, algorithm)
+	};
+
+	auto it
+	{
+		device_one_time_key.lower_bound(prefix)
+	};
+
+	if(!it || !startswith(it->first, prefix))
+		return false;
+
+	// Copied out; the closure and the commit may yield.
+	const std::string key
+	{
+		it->first
+	};
+
+	const std::string val
+	{
+		it->second
+	};
+
+	closure(algorithm, string_view{key}.substr(size(prefix)), val);
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	db::txn::append
+	{
+		txn, device_one_time_key,
+		{
+			db::op::DELETE, key
+		}
+	};
+
+	device_one_time_key_count_add(txn, user_id, device_id, algorithm, -1L);
+	txn();
+	return true;
+}
+
+/// Deletes every key and count of the device with one range deletion.
+void
+ircd::m::dbs::device_one_time_key_del(const id::user &user_id,
+                                      const string_view &device_id)
+{
+	char buf[2][DEVICE_ONE_TIME_KEY_KEY_MAX_SIZE];
+	mutable_buffer begin{buf[0]}, end{buf[1]};
+	consume(begin, copy(begin, string_view{user_id}));
+	consume(begin, copy(begin, '\0'));
+	consume(begin, copy(begin, device_id));
+	consume(end, copy(end, string_view{buf[0], data(begin)}));
+	consume(begin, copy(begin, '\0'));
+	consume(end, copy(end, '\1'));
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	db::txn::append
+	{
+		txn, device_one_time_key,
+		{
+			db::op::DELETE_RANGE,
+			string_view{buf[0], data(begin)},
+			string_view{buf[1], data(end)},
+		}
+	};
+
+	txn();
+}
+
+/// Iterates the count of each algorithm the device has had keys for; a count
+/// may be zero.
+bool
+ircd::m::dbs::device_one_time_key_count(const id::user &user_id,
+                                        const string_view &device_id,
+                                        const device_one_time_key_count_closure &closure)
+{
+	char buf[DEVICE_ONE_TIME_KEY_KEY_MAX_SIZE];
+	const string_view prefix
+	{
+		device_one_time_key_count_key(buf, user_id, device_id, string_view{})
+	};
+
+	for(auto it(device_one_time_key.lower_bound(prefix)); it; ++it)
+	{
+		const auto &[key, val]
+		{
+			*it
+		};
+
+		if(!startswith(key, prefix))
+			break;
+
+		int64_t count {0};
+		memcpy(&count, data(val), std::min(size(val), sizeof(count)));
+		if(!closure(key.substr(size(prefix)), count))
+			return false;
+	}
+
+	return true;
+}
+
+void
+ircd::m::dbs::device_one_time_key_count_add(db::txn &txn,
+                                            const id::user &user_id,
+                                            const string_view &device_id,
+                                            const string_view &algorithm,
+                                            const int64_t &delta)
+{
+	char buf[DEVICE_ONE_TIME_KEY_KEY_MAX_SIZE];
+	db::txn::append
+	{
+		txn, device_one_time_key,
+		{
+			db::op::MERGE,
+			device_one_time_key_count_key(buf, user_id, device_id, algorithm),
+			byte_view<string_view>(delta),
+		}
+	};
+}
+
+std::string
+ircd::m::dbs::device_one_time_key__merge_add(const string_view &key,
+                                             const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	int64_t a {0}, b {0};
+	memcpy(&a, data(exist), std::min(size(exist), sizeof(a)));
+	memcpy(&b, data(update), std::min(size(update), sizeof(b)));
+	a += b;
+
+	return std::string
+	{
+		reinterpret_cast<const char *>(&a), sizeof(a)
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::device_one_time_key_count_key(const mutable_buffer &out_,
+                                            const id::user &user_id,
+                                            const string_view &device_id,
+                                            const string_view &algorithm)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, string_view{user_id}));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, device_id));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, algorithm));
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::device_one_time_key_prefix(const mutable_buffer &out_,
+                                         const id::user &user_id,
+                                         const string_view &device_id,
+                                         const string_view &algorithm)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, string_view{user_id}));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, device_id));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, algorithm));
+	consume(out, copy(out, '\0'));
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
@@ -0,0 +1,613 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static void event_chain_parse(const string_view &, event_chain_pos &, event_chain_cover &, bool &complete);
+	static bool event_chain_read(const db::txn &, const event::idx &, event_chain_pos &, event_chain_cover &, bool &complete);
+	static bool event_chain_has(const db::txn &, const uint64_t &chain, const uint64_t &seq);
+	static bool event_chain_same_cell(const event &, const event::idx &);
+}
+
+decltype(ircd::m::dbs::event_chain)
+ircd::m::dbs::event_chain;
+
+decltype(ircd::m::dbs::desc::event_chain__comp)
+ircd::m::dbs::desc::event_chain__comp
+{
+	{ "name",     "ircd.m.dbs._event_chain.comp" },
+	{ "default",  "default"                      },
+};
+
+decltype(ircd::m::dbs::desc::event_chain__block__size)
+ircd::m::dbs::desc::event_chain__block__size
+{
+	{ "name",     "ircd.m.dbs._event_chain.block.size" },
+	{ "default",  1024L                                },
+};
+
+decltype(ircd::m::dbs::desc::event_chain__meta_block__size)
+ircd::m::dbs::desc::event_chain__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._event_chain.meta_block.size" },
+	{ "default",  2048L                                     },
+};
+
+decltype(ircd::m::dbs::desc::event_chain__cache__size)
+ircd::m::dbs::desc::event_chain__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_chain.cache.size" },
+		{ "default",  long(32_MiB)                         },
+	}, []
+	{
+		const size_t &value{event_chain__cache__size};
+		db::capacity(db::cache(dbs::event_chain), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::event_chain__cache_comp__size)
+ircd::m::dbs::desc::event_chain__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_chain.cache_comp.size" },
+		{ "default",  long(0_MiB)                               },
+	}, []
+	{
+		const size_t &value{event_chain__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::event_chain), value);
+	}
+};
+
+/// Assign chains to the state events of a database which predates this
+/// column at startup; state resolution falls back to walking the auth DAG
+/// for events without one.
+decltype(ircd::m::dbs::desc::event_chain__rebuild)
+ircd::m::dbs::desc::event_chain__rebuild
+{
+	{ "name",     "ircd.m.dbs._event_chain.rebuild" },
+	{ "default",  true                              },
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::event_chain
+{
+	// name
+	"_event_chain",
+
+	// explanation
+	R"(Chain cover index of the auth DAG.
+
+	'e' | event_idx => chain_id, seq, complete, (chain_id, seq)[]
+	'c' | chain_id, ~seq => event_idx
+
+	Each state event is placed at a sequence in a chain. It continues the chain
+	of an auth event for the same (type, state_key) when that auth event is the
+	chain's last; otherwise it begins a new chain identified by its own index.
+
+	The value for an event records the highest sequence reached in every chain
+	by its auth_events, recursively; this is its auth chain. Whether an event
+	is in the auth chain of another is found by comparing one sequence number
+	and the auth chain is enumerated by ranges of sequence in each chain.
+
+	The 'c' keys are big-endian with the sequence inverted so each chain is
+	iterated from its last sequence. An event whose auth_events were not all
+	indexed is marked incomplete and its cover is not relied upon.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	true,
+
+	// block size
+	size_t(event_chain__block__size),
+
+	// meta_block size
+	size_t(event_chain__meta_block__size),
+
+	// compression
+	string_view{event_chain__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+/// Adds the chain position and cover of a state event into the txn. The
+/// chain records are append-only; a deletion of the event leaves them.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_event_chain(db::txn &txn,
+                                 const event &event,
+                                 const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::EVENT_CHAIN));
+	assert(opts.event_idx);
+
+	if(!defined(json::get<"state_key"_>(event)))
+		return;
+
+	if(opts.op != db::op::SET)
+		return;
+
+	const event::auth auth
+	{
+		event
+	};
+
+	event::idx auth_idxs[event::auth::MAX];
+	const auto &auth_idx
+	{
+		auth.idxs(auth_idxs)
+	};
+
+	bool complete
+	{
+		auth_idx.size() == auth.auth_events_count()
+	};
+
+	event_chain_pos pos {0, 0};
+	event_chain_cover cover;
+	for(size_t i(0); i < auth_idx.size(); ++i)
+	{
+		event_chain_pos auth_pos;
+		event_chain_cover auth_cover;
+		bool auth_complete {false};
+		if(!auth_idx[i] || !event_chain_read(txn, auth_idx[i], auth_pos, auth_cover, auth_complete))
+		{
+			complete = false;
+			continue;
+		}
+
+		complete &= auth_complete;
+		event_chain_merge(cover, auth_cover);
+		event_chain_merge(cover, event_chain_cover{auth_pos});
+
+		const bool extends
+		{
+			!pos.first
+			&& !event_chain_has(txn, auth_pos.first, auth_pos.second + 1)
+			&& event_chain_same_cell(event, auth_idx[i])
+		};
+
+		if(extends)
+			pos = { auth_pos.first, auth_pos.second + 1 };
+	}
+
+	if(!pos.first)
+		pos = { opts.event_idx, 1UL };
+
+	std::string val(8 * (3 + cover.size() * 2), '\0');
+	uint64_t *const out(reinterpret_cast<uint64_t *>(val.data()));
+	const uint64_t head[3]
+	{
+		pos.first, pos.second, complete
+	};
+
+	memcpy(out, head, sizeof(head));
+	for(size_t i(0); i < cover.size(); ++i)
+	{
+		const uint64_t pair[2]
+		{
+			cover[i].first, cover[i].second
+		};
+
+		memcpy(out + 3 + i * 2, pair, sizeof(pair));
+	}
+
+	char buf[2][EVENT_CHAIN_KEY_MAX_SIZE];
+	db::txn::append
+	{
+		txn, event_chain,
+		{
+			db::op::SET,
+			event_chain_key(buf[0], opts.event_idx),
+			val,
+		}
+	};
+
+	db::txn::append
+	{
+		txn, event_chain,
+		{
+			db::op::SET,
+			event_chain_key(buf[1], pos.first, pos.second),
+			byte_view<string_view>(opts.event_idx),
+		}
+	};
+}
+
+bool
+ircd::m::dbs::event_chain_same_cell(const event &event,
+                                    const event::idx &idx)
+{
+	bool ret{false};
+	m::get(std::nothrow, idx, "type", [&event, &ret]
+	(const string_view &type)
+	{
+		ret = type == json::get<"type"_>(event);
+	});
+
+	if(ret)
+		m::get(std::nothrow, idx, "state_key", [&event, &ret]
+		(const string_view &state_key)
+		{
+			ret = state_key == json::get<"state_key"_>(event);
+		});
+
+	return ret;
+}
+
+bool
+ircd::m::dbs::event_chain_has(const db::txn &txn,
+                              const uint64_t &chain,
+                              const uint64_t &seq)
+{
+	char buf[EVENT_CHAIN_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		event_chain_key(buf, chain, seq)
+	};
+
+	return db::has(event_chain, key) || txn.has(db::op::SET, desc::event_chain.name, key);
+}
+
+bool
+ircd::m::dbs::event_chain_read(const db::txn &txn,
+                               const event::idx &event_idx,
+                               event_chain_pos &pos,
+                               event_chain_cover &cover,
+                               bool &complete)
+{
+	char buf[EVENT_CHAIN_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		event_chain_key(buf, event_idx)
+	};
+
+	const auto closure{[&pos, &cover, &complete]
+	(const string_view &val)
+	{
+		event_chain_parse(val, pos, cover, complete);
+	}};
+
+	return event_chain(key, std::nothrow, closure)
+	|| txn.get(db::op::SET, desc::event_chain.name, key, closure);
+}
+
+//
+// interface
+//
+
+/// Fetch the chain position and cover of an event. False is returned for an
+/// event not indexed and for one whose cover is incomplete.
+bool
+ircd::m::dbs::event_chain_get(event_chain_pos &pos,
+                              event_chain_cover &cover,
+                              const event::idx &event_idx)
+{
+	char buf[EVENT_CHAIN_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		event_chain_key(buf, event_idx)
+	};
+
+	bool complete{false};
+	const bool found
+	{
+		event_chain(key, std::nothrow, [&pos, &cover, &complete]
+		(const string_view &val)
+		{
+			event_chain_parse(val, pos, cover, complete);
+		})
+	};
+
+	return found && complete;
+}
+
+/// Iterate the events of a chain with a sequence in the range (lo, hi],
+/// from the highest sequence.
+bool
+ircd::m::dbs::event_chain_for_each(const uint64_t &chain,
+                                   const uint64_t &hi,
+                                   const uint64_t &lo,
+                                   const event_chain_closure &closure)
+{
+	char buf[EVENT_CHAIN_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		event_chain_key(buf, chain, hi)
+	};
+
+	auto it
+	{
+		event_chain.lower_bound(key)
+	};
+
+	for(; it; ++it)
+	{
+		const auto &key(it->first);
+		if(size(key) != EVENT_CHAIN_KEY_MAX_SIZE || memcmp(data(key), buf, 1 + 8) != 0)
+			break;
+
+		uint64_t seq;
+		memcpy(&seq, data(key) + 1 + 8, sizeof(seq));
+		seq = ~ntoh(seq);
+		if(seq <= lo)
+			break;
+
+		if(!closure(seq, byte_view<event::idx>(it->second)))
+			return false;
+	}
+
+	return true;
+}
+
+/// Iterate the events reached by the cover hi and not reached by the cover
+/// lo; with an empty lo this is every event of the auth chain hi covers.
+/// Events are iterated by chain and then descending sequence.
+bool
+ircd::m::dbs::event_chain_for_each(const event_chain_cover &hi,
+                                   const event_chain_cover &lo,
+                                   const event::closure_idx_bool &closure)
+{
+	auto it(std::cbegin(lo));
+	for(const auto &[chain, seq] : hi)
+	{
+		while(it != std::cend(lo) && it->first < chain)
+			++it;
+
+		const uint64_t &floor
+		{
+			it != std::cend(lo) && it->first == chain?
+				it->second:
+				0UL
+		};
+
+		if(floor >= seq)
+			continue;
+
+		const bool ok
+		{
+			event_chain_for_each(chain, seq, floor, [&closure]
+			(const uint64_t &seq, const event::idx &event_idx)
+			{
+				return closure(event_idx);
+			})
+		};
+
+		if(!ok)
+			return false;
+	}
+
+	return true;
+}
+
+/// The cover of the auth chain of any event. A state event has its own
+/// record; for other events it is composed from the records of the
+/// auth_events. False is returned when any record is missing or incomplete.
+bool
+ircd::m::dbs::event_chain_auth(event_chain_cover &cover,
+                               const event::idx &event_idx)
+{
+	event_chain_pos pos;
+	if(event_chain_get(pos, cover, event_idx))
+		return true;
+
+	// Only an event which has no record is composed here; one which has an
+	// incomplete record won't be improved by its auth_events.
+	char buf[EVENT_CHAIN_KEY_MAX_SIZE];
+	if(db::has(event_chain, event_chain_key(buf, event_idx)))
+		return false;
+
+	const m::event::fetch event
+	{
+		std::nothrow, event_idx
+	};
+
+	if(!event.valid)
+		return false;
+
+	const event::auth auth
+	{
+		event
+	};
+
+	event::idx auth_idxs[event::auth::MAX];
+	const auto &auth_idx
+	{
+		auth.idxs(auth_idxs)
+	};
+
+	if(auth_idx.size() != auth.auth_events_count())
+		return false;
+
+	cover.clear();
+	for(size_t i(0); i < auth_idx.size(); ++i)
+	{
+		event_chain_cover auth_cover;
+		if(!auth_idx[i] || !event_chain_get(pos, auth_cover, auth_idx[i]))
+			return false;
+
+		event_chain_merge(cover, auth_cover);
+		event_chain_merge(cover, event_chain_cover{pos});
+	}
+
+	return true;
+}
+
+/// Merge the cover b into a taking the greater sequence of each chain.
+ircd::m::dbs::event_chain_cover &
+ircd::m::dbs::event_chain_merge(event_chain_cover &a,
+                                const event_chain_cover &b)
+{
+	event_chain_cover ret;
+	ret.reserve(a.size() + b.size());
+	auto ia(std::cbegin(a));
+	auto ib(std::cbegin(b));
+	while(ia != end(a) || ib != end(b))
+	{
+		if(ib == end(b) || (ia != end(a) && ia->first < ib->first))
+			ret.emplace_back(*ia++);
+		else if(ia == end(a) || ib->first < ia->first)
+			ret.emplace_back(*ib++);
+		else
+		{
+			ret.emplace_back(ia->first, std::max(ia->second, ib->second));
+			++ia, ++ib;
+		}
+	}
+
+	a = std::move(ret);
+	return a;
+}
+
+/// Indexes every state event in ascending order of index so auth events are
+/// generally indexed before the events referencing them. An event continues
+/// a chain only while its auth event is that chain's last, which a concurrent
+/// evaluation could change underneath the scan.
+size_t
+ircd::m::dbs::event_chain_rebuild()
+{
+	static const db::gopts gopts
+	{
+		db::get::NO_CACHE
+	};
+
+	db::column &state_key_column
+	{
+		event_column.at(json::indexof<event, "state_key"_>())
+	};
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	write_opts opts;
+	opts.appendix.reset();
+	opts.appendix.set(appendix::EVENT_CHAIN);
+
+	size_t ret(0);
+	m::event::fetch event;
+	for(auto it(state_key_column.begin(gopts)); it; ++it)
+	{
+		opts.event_idx = byte_view<event::idx>(it->first);
+		if(!seek(std::nothrow, event, opts.event_idx))
+			continue;
+
+		_index_event_chain(txn, event, opts);
+		if(++ret % 4096UL)
+			continue;
+
+		txn();
+		txn.clear();
+		if(ret % 1048576UL == 0)
+			log::info
+			{
+				log, "Rebuilding auth chain index; %zu state events so far...",
+				ret,
+			};
+	}
+
+	txn();
+	log::notice
+	{
+		log, "Rebuilt auth chain index from %zu state events.",
+		ret,
+	};
+
+	return ret;
+}
+
+void
+ircd::m::dbs::event_chain_parse(const string_view &val,
+                                event_chain_pos &pos,
+                                event_chain_cover &cover,
+                                bool &complete)
+{
+	uint64_t head[3] {0};
+	memcpy(head, data(val), std::min(size(val), sizeof(head)));
+	pos = { head[0], head[1] };
+	complete = head[2];
+
+	const size_t count
+	(
+		size(val) > sizeof(head)?
+			(size(val) - sizeof(head)) / 16:
+			0UL
+	);
+
+	cover.resize(count);
+	for(size_t i(0); i < count; ++i)
+	{
+		uint64_t pair[2];
+		memcpy(pair, data(val) + sizeof(head) + i * 16, sizeof(pair));
+		cover[i] = { pair[0], pair[1] };
+	}
+}
+
+ircd::string_view
+ircd::m::dbs::event_chain_key(const mutable_buffer &out_,
+                              const event::idx &event_idx)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, 'e'));
+	consume(out, copy(out, byte_view<string_view>(event_idx)));
+	return { data(out_), data(out) };
+}
+
+ircd::string_view
+ircd::m::dbs::event_chain_key(const mutable_buffer &out_,
+                              const uint64_t &chain,
+                              const uint64_t &seq)
+{
+	const uint64_t key[2]
+	{
+		hton(chain), hton(~seq)
+	};
+
+	mutable_buffer out{out_};
+	consume(out, copy(out, 'c'));
+	consume(out, copy(out, const_buffer{reinterpret_cast<const char *>(key), sizeof(key)}));
+	return { data(out_), data(out) };
+}
@@ -313,6 +313,24 @@ ircd::m::dbs::desc::content__file__size__max
 	{ "default",  long(256_MiB)                       },
 };
 
+/// Directory for the bottom (oldest) files of this column, usually on a
+/// bulk device. Empty to keep all files in the database directory.
+decltype(ircd::m::dbs::desc::content__tier__path)
+ircd::m::dbs::desc::content__tier__path
+{
+	{ "name",     "ircd.m.dbs.content.tier.path"  },
+	{ "default",  string_view{}                   },
+};
+
+/// Bytes of this column kept in the database directory before files are
+/// placed in the tier path. Zero chooses from the device properties.
+decltype(ircd::m::dbs::desc::content__tier__size)
+ircd::m::dbs::desc::content__tier__size
+{
+	{ "name",     "ircd.m.dbs.content.tier.size"  },
+	{ "default",  0L                              },
+};
+
 const ircd::db::descriptor
 ircd::m::dbs::desc::content
 {
@@ -382,6 +400,21 @@ ircd::m::dbs::desc::content
 		size_t(content__file__size__max),
 		1L,
 	},
+
+	// max bytes for each level (unused by universal compaction)
+	{},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{
+		string_view{content__tier__path},
+		size_t(content__tier__size),
+	},
 };
 
 //
@@ -58,6 +58,21 @@ ircd::m::dbs::desc::event_horizon__cache_comp__size
 	}
 };
 
+decltype(ircd::m::dbs::desc::event_horizon__bloom__bits)
+ircd::m::dbs::desc::event_horizon__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._event_horizon.bloom.bits" },
+	{ "default",  0L                                     },
+};
+
+/// Build a ribbon filter rather than a bloom filter when bloom.bits is set.
+decltype(ircd::m::dbs::desc::event_horizon__bloom__ribbon)
+ircd::m::dbs::desc::event_horizon__bloom__ribbon
+{
+	{ "name",     "ircd.m.dbs._event_horizon.bloom.ribbon" },
+	{ "default",  true                                     },
+};
+
 const ircd::db::prefix_transform
 ircd::m::dbs::desc::event_horizon__pfx
 {
@@ -125,7 +140,7 @@ ircd::m::dbs::desc::event_horizon
 	bool(cache_comp_enable)? -1 : 0,
 
 	// bloom filter bits
-	0,
+	size_t(event_horizon__bloom__bits),
 
 	// expect queries hit
 	false,
@@ -144,6 +159,42 @@ ircd::m::dbs::desc::event_horizon
 
 	// compaction priority algorithm
 	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	bool(event_horizon__bloom__ribbon),
 };
 
 //
@@ -263,6 +314,7 @@ ircd::m::dbs::_index_event_horizon_resolve_one(db::txn &txn,
 	_opts.appendix.reset();
 	_opts.appendix.set(appendix::EVENT_REFS, opts.appendix[appendix::EVENT_REFS]);
 	_opts.appendix.set(appendix::ROOM_REDACT, opts.appendix[appendix::ROOM_REDACT]);
+	_opts.appendix.set(appendix::EVENT_RELATES, opts.appendix[appendix::EVENT_RELATES]);
 	_opts.appendix.set(appendix::ROOM_HEAD_RESOLVE, opts.appendix[appendix::ROOM_HEAD_RESOLVE]);
 	_opts.event_refs = opts.horizon_resolve;
 	_opts.interpose = &txn;
@@ -11,6 +11,28 @@
 decltype(ircd::m::dbs::event_idx)
 ircd::m::dbs::event_idx;
 
+namespace ircd::m::dbs::event_idx_absent
+{
+	static std::map<std::string, steady_point, std::less<>> map;
+}
+
+decltype(ircd::m::dbs::event_idx_absent::max)
+ircd::m::dbs::event_idx_absent::max
+{
+	{ "name",     "ircd.m.dbs._event_idx.absent.max" },
+	{ "default",  16384L                             },
+};
+
+decltype(ircd::m::dbs::event_idx_absent::ttl)
+ircd::m::dbs::event_idx_absent::ttl
+{
+	{ "name",     "ircd.m.dbs._event_idx.absent.ttl" },
+	{ "default",  30L                                },
+};
+
+decltype(ircd::m::dbs::event_idx_absent::generation)
+ircd::m::dbs::event_idx_absent::generation;
+
 decltype(ircd::m::dbs::desc::event_idx__comp)
 ircd::m::dbs::desc::event_idx__comp
 {
@@ -32,6 +54,14 @@ ircd::m::dbs::desc::event_idx__meta_block__size
 	{ "default",  2048L                                   },
 };
 
+/// Pin the top-level index and filter partitions of this column in the cache.
+decltype(ircd::m::dbs::desc::event_idx__meta_block__pin)
+ircd::m::dbs::desc::event_idx__meta_block__pin
+{
+	{ "name",     "ircd.m.dbs._event_idx.meta_block.pin" },
+	{ "default",  true                                   },
+};
+
 decltype(ircd::m::dbs::desc::event_idx__cache__size)
 ircd::m::dbs::desc::event_idx__cache__size
 {
@@ -65,6 +95,14 @@ ircd::m::dbs::desc::event_idx__bloom__bits
 	{ "default",  0L                                 },
 };
 
+/// Build a ribbon filter rather than a bloom filter when bloom.bits is set.
+decltype(ircd::m::dbs::desc::event_idx__bloom__ribbon)
+ircd::m::dbs::desc::event_idx__bloom__ribbon
+{
+	{ "name",     "ircd.m.dbs._event_idx.bloom.ribbon" },
+	{ "default",  true                                 },
+};
+
 decltype(ircd::m::dbs::desc::event_idx)
 ircd::m::dbs::desc::event_idx
 {
@@ -132,6 +170,42 @@ ircd::m::dbs::desc::event_idx
 
 	// compaction priority algorithm
 	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	bool(event_idx__meta_block__pin),
+
+	// bloom_ribbon
+	bool(event_idx__bloom__ribbon),
 };
 
 //
@@ -147,6 +221,9 @@ ircd::m::dbs::_index_event_id(db::txn &txn,
 	assert(opts.event_idx);
 	assert(event.event_id);
 
+	++event_idx_absent::generation;
+	event_idx_absent::clear(event.event_id);
+
 	db::txn::append
 	{
 		txn, dbs::event_idx,
@@ -175,3 +252,86 @@ ircd::m::dbs::_index_event_id(db::txn &txn,
 		}
 	};
 }
+
+//
+// event_idx_absent
+//
+
+bool
+ircd::m::dbs::event_idx_absent::clear(const string_view &event_id)
+{
+	const auto it
+	{
+		map.find(event_id)
+	};
+
+	if(it == end(map))
+		return false;
+
+	map.erase(it);
+	return true;
+}
+
+bool
+ircd::m::dbs::event_idx_absent::set(const string_view &event_id,
+                                    const uint64_t &generation)
+{
+	if(unlikely(generation != event_idx_absent::generation))
+		return false;
+
+	if(unlikely(!size_t(max)))
+		return false;
+
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	// At capacity the expired entries are swept; if that was not enough the
+	// cache is simply started over.
+	if(map.size() >= size_t(max))
+		for(auto it(begin(map)); it != end(map); )
+			it = it->second < now?
+				map.erase(it):
+				std::next(it);
+
+	if(map.size() >= size_t(max))
+		map.clear();
+
+	const auto expires
+	{
+		now + seconds(ttl)
+	};
+
+	auto it
+	{
+		map.lower_bound(event_id)
+	};
+
+	if(it == end(map) || it->first != event_id)
+		it = map.emplace_hint(it, std::string(event_id), expires);
+	else
+		it->second = expires;
+
+	return true;
+}
+
+bool
+ircd::m::dbs::event_idx_absent::test(const string_view &event_id)
+{
+	const auto it
+	{
+		map.find(event_id)
+	};
+
+	if(it == end(map))
+		return false;
+
+	if(it->second < ircd::now<steady_point>())
+	{
+		map.erase(it);
+		return false;
+	}
+
+	return true;
+}
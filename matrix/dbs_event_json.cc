@@ -18,6 +18,24 @@ ircd::m::dbs::desc::event_json__comp
 	{ "default",  "default"                     },
 };
 
+/// Size of the compression dictionary stored with each table file. Event JSON
+/// repeats the same keys and server names in every value, so a dictionary
+/// recovers most of what per-block compression of small values misses.
+decltype(ircd::m::dbs::desc::event_json__comp__dict__size)
+ircd::m::dbs::desc::event_json__comp__dict__size
+{
+	{ "name",     "ircd.m.dbs._event_json.comp.dict.size" },
+	{ "default",  long(16_KiB)                            },
+};
+
+/// Bytes sampled to train the zstd dictionary; zero uses the samples as-is.
+decltype(ircd::m::dbs::desc::event_json__comp__dict__train)
+ircd::m::dbs::desc::event_json__comp__dict__train
+{
+	{ "name",     "ircd.m.dbs._event_json.comp.dict.train" },
+	{ "default",  long(1_MiB)                              },
+};
+
 decltype(ircd::m::dbs::desc::event_json__block__size)
 ircd::m::dbs::desc::event_json__block__size
 {
@@ -72,6 +90,24 @@ ircd::m::dbs::desc::event_json__file__size__max
 	{ "default",  long(512_MiB)                             },
 };
 
+/// Directory for the bottom (oldest) files of this column, usually on a
+/// bulk device. Empty to keep all files in the database directory.
+decltype(ircd::m::dbs::desc::event_json__tier__path)
+ircd::m::dbs::desc::event_json__tier__path
+{
+	{ "name",     "ircd.m.dbs._event_json.tier.path" },
+	{ "default",  string_view{}                      },
+};
+
+/// Bytes of this column kept in the database directory before files are
+/// placed in the tier path. Zero chooses from the device properties.
+decltype(ircd::m::dbs::desc::event_json__tier__size)
+ircd::m::dbs::desc::event_json__tier__size
+{
+	{ "name",     "ircd.m.dbs._event_json.tier.size" },
+	{ "default",  0L                                 },
+};
+
 const ircd::db::descriptor
 ircd::m::dbs::desc::event_json
 {
@@ -134,6 +170,27 @@ ircd::m::dbs::desc::event_json
 		size_t(event_json__file__size__max),  // base
 		1L,                                   // multiplier
 	},
+
+	// max bytes for each level (unused by universal compaction)
+	{},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{
+		string_view{event_json__tier__path},
+		size_t(event_json__tier__size),
+	},
+
+	// compression_dict
+	{
+		size_t(event_json__comp__dict__size),
+		size_t(event_json__comp__dict__train),
+	},
 };
 
 //
@@ -154,6 +211,11 @@ ircd::m::dbs::_index_event_json(db::txn &txn,
 		byte_view<string_view>(opts.event_idx)
 	};
 
+	// The parsed copy is dropped with the erasure; the writer drops it again
+	// after the commit if the event may have been fetched in between.
+	if(opts.op != db::op::SET)
+		m::event::fetch::invalidate(opts.event_idx);
+
 	const string_view &val
 	{
 		// If an already-strung json::object is carried by the event and
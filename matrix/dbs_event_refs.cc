@@ -690,6 +690,9 @@ ircd::m::dbs::_index_event_refs_m_relates(db::txn &txn,
 			opts.op, key
 		}
 	};
+
+	if(opts.appendix.test(appendix::EVENT_RELATES))
+		_index_event_relates(txn, event, opts, event_idx);
 }
 
 size_t
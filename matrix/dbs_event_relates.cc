@@ -0,0 +1,588 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static bool event_relates_parse(const json::object &content, const string_view &sender, json::string &parent, json::string &rel_type, string_view &key);
+	static std::string event_relates_delta(const string_view &rel_type, const string_view &key, const int64_t &sign, const event::idx &);
+	static bool event_relates_decode(const string_view &val, const event_relates_closure &);
+	static std::string event_relates__merge_add(const string_view &, const db::merge_delta &);
+}
+
+decltype(ircd::m::dbs::event_relates)
+ircd::m::dbs::event_relates;
+
+decltype(ircd::m::dbs::desc::event_relates__comp)
+ircd::m::dbs::desc::event_relates__comp
+{
+	{ "name",     "ircd.m.dbs._event_relates.comp" },
+	{ "default",  "default"                        },
+};
+
+decltype(ircd::m::dbs::desc::event_relates__block__size)
+ircd::m::dbs::desc::event_relates__block__size
+{
+	{ "name",     "ircd.m.dbs._event_relates.block.size" },
+	{ "default",  512L                                   },
+};
+
+decltype(ircd::m::dbs::desc::event_relates__meta_block__size)
+ircd::m::dbs::desc::event_relates__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._event_relates.meta_block.size" },
+	{ "default",  1024L                                       },
+};
+
+decltype(ircd::m::dbs::desc::event_relates__cache__size)
+ircd::m::dbs::desc::event_relates__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_relates.cache.size" },
+		{ "default",  long(8_MiB)                            },
+	}, []
+	{
+		const size_t &value{event_relates__cache__size};
+		db::capacity(db::cache(dbs::event_relates), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::event_relates__cache_comp__size)
+ircd::m::dbs::desc::event_relates__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._event_relates.cache_comp.size" },
+		{ "default",  long(0_MiB)                                 },
+	}, []
+	{
+		const size_t &value{event_relates__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::event_relates), value);
+	}
+};
+
+/// Aggregate the relations of a database which predates this column from
+/// its event_refs at startup.
+decltype(ircd::m::dbs::desc::event_relates__rebuild)
+ircd::m::dbs::desc::event_relates__rebuild
+{
+	{ "name",     "ircd.m.dbs._event_relates.rebuild" },
+	{ "default",  true                                },
+};
+
+/// Aggregations are merged by (rel_type, key); counts are summed and the
+/// latest is the greatest event_idx.
+decltype(ircd::m::dbs::desc::event_relates__merge)
+ircd::m::dbs::desc::event_relates__merge
+{
+	event_relates__merge_add
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::event_relates
+{
+	// name
+	"_event_relates",
+
+	// explanation
+	R"(Aggregations of the relations to an event.
+
+	event_idx => (int64_t count, event_idx latest, rel_type, key)[]
+
+	The key is the event being related to. Each relation (m.relates_to) made
+	in event_refs merges an increment for its rel_type and key (the key of an
+	m.annotation; the sender of an m.thread reply; otherwise empty); a
+	redaction of the relation merges a decrement. All aggregations of an
+	event are read with one query, and most events have none; the bloom
+	filter answers those.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(uint64_t), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	10,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(event_relates__block__size),
+
+	// meta_block size
+	size_t(event_relates__meta_block__size),
+
+	// compression
+	string_view{event_relates__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	event_relates__merge,
+};
+
+//
+// indexer
+//
+
+/// Called when the M_RELATES reference to the parent is made (or removed);
+/// the horizon resolve of a relation which arrived first also lands here.
+void
+ircd::m::dbs::_index_event_relates(db::txn &txn,
+                                   const event &event,
+                                   const write_opts &opts,
+                                   const event::idx &parent)
+{
+	assert(opts.appendix.test(appendix::EVENT_RELATES));
+	assert(parent && opts.event_idx);
+
+	const int64_t sign
+	{
+		opts.op == db::op::SET?  1L:
+		opts.op == db::op::DELETE? -1L:
+		0L
+	};
+
+	if(!sign)
+		return;
+
+	json::string parent_id, rel_type;
+	string_view key;
+	if(!event_relates_parse(json::get<"content"_>(event), json::get<"sender"_>(event), parent_id, rel_type, key))
+		return;
+
+	db::txn::append
+	{
+		txn, event_relates,
+		{
+			db::op::MERGE,
+			byte_view<string_view>(parent),
+			event_relates_delta(rel_type, key, sign, opts.event_idx),
+		}
+	};
+
+	if(rel_type == "m.thread")
+		_index_room_threads(txn, event, opts, parent);
+}
+
+/// Removes the redacted relation from the aggregation of its parent.
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_event_relates_redact(db::txn &txn,
+                                          const event::idx &target,
+                                          const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::EVENT_RELATES));
+
+	// The target was already redacted and removed by an earlier redaction.
+	if(opts.op != db::op::SET || m::redacted(target))
+		return;
+
+	char sender_buf[id::MAX_SIZE];
+	const string_view sender
+	{
+		m::get(std::nothrow, target, "sender", sender_buf)
+	};
+
+	m::get(std::nothrow, target, "content", [&txn, &opts, &target, &sender]
+	(const json::object &content)
+	{
+		json::string parent_id, rel_type;
+		string_view key;
+		if(!event_relates_parse(content, sender, parent_id, rel_type, key))
+			return;
+
+		const event::idx parent
+		{
+			find_event_idx(event::id(parent_id), opts)
+		};
+
+		if(!parent)
+			return;
+
+		db::txn::append
+		{
+			txn, event_relates,
+			{
+				db::op::MERGE,
+				byte_view<string_view>(parent),
+				event_relates_delta(rel_type, key, -1L, target),
+			}
+		};
+	});
+}
+
+//
+// interface
+//
+
+bool
+ircd::m::dbs::event_relates_get(event_relates_value &ret,
+                                const event::idx &event_idx,
+                                const string_view &rel_type,
+                                const string_view &key)
+{
+	ret = {};
+	return !event_relates_for_each(event_idx, [&ret, &rel_type, &key]
+	(const string_view &_rel_type, const string_view &_key, const event_relates_value &value)
+	{
+		if(_rel_type != rel_type || _key != key)
+			return true;
+
+		ret = value;
+		return false;
+	});
+}
+
+/// Iterates the aggregations of the relations to the event; these are only
+/// those with a positive count. Returns false if the closure broke.
+bool
+ircd::m::dbs::event_relates_for_each(const event::idx &event_idx,
+                                     const event_relates_closure &closure)
+{
+	bool ret{true};
+	event_relates(byte_view<string_view>(event_idx), std::nothrow, [&ret, &closure]
+	(const string_view &val)
+	{
+		ret = event_relates_decode(val, [&closure]
+		(const string_view &rel_type, const string_view &key, const event_relates_value &value)
+		{
+			return value.count <= 0 || closure(rel_type, key, value);
+		});
+	});
+
+	return ret;
+}
+
+/// Aggregates the relations of every event from event_refs, replacing any
+/// existing values. A relation merged by an evaluation during the scan would
+/// be lost to that replacement.
+size_t
+ircd::m::dbs::event_relates_rebuild()
+{
+	static const db::gopts gopts
+	{
+		db::get::NO_CACHE
+	};
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	size_t ret(0);
+	db::column &event_refs_column(event_refs);
+	for(auto it(event_refs_column.begin(gopts)); it; ++it)
+	{
+		const string_view &ref_key
+		{
+			it->first
+		};
+
+		if(unlikely(size(ref_key) < sizeof(event::idx) * 2))
+			continue;
+
+		const auto &[type, child]
+		{
+			event_refs_key(ref_key.substr(sizeof(event::idx)))
+		};
+
+		if(type != ref::M_RELATES || m::redacted(child))
+			continue;
+
+		const event::idx parent
+		{
+			byte_view<event::idx>(ref_key.substr(0, sizeof(event::idx)))
+		};
+
+		char sender_buf[id::MAX_SIZE], room_id_buf[id::MAX_SIZE];
+		const string_view sender
+		{
+			m::get(std::nothrow, child, "sender", sender_buf)
+		};
+
+		const string_view room_id
+		{
+			m::get(std::nothrow, child, "room_id", room_id_buf)
+		};
+
+		bool added {false};
+		m::get(std::nothrow, child, "content", [&]
+		(const json::object &content)
+		{
+			json::string parent_id, rel_type;
+			string_view key;
+			if(!event_relates_parse(content, sender, parent_id, rel_type, key))
+				return;
+
+			db::txn::append
+			{
+				txn, event_relates,
+				{
+					db::op::MERGE,
+					byte_view<string_view>(parent),
+					event_relates_delta(rel_type, key, 1L, child),
+				}
+			};
+
+			char buf[ROOM_THREADS_KEY_MAX_SIZE];
+			if(rel_type == "m.thread" && valid(m::id::ROOM, room_id))
+				db::txn::append
+				{
+					txn, room_threads,
+					{
+						db::op::MERGE,
+						room_threads_key(buf, room_id, parent),
+						byte_view<string_view>(child),
+					}
+				};
+
+			added = true;
+		});
+
+		if(!added || ++ret % 4096UL)
+			continue;
+
+		txn();
+		txn.clear();
+		if(ret % 1048576UL == 0)
+			log::info
+			{
+				log, "Rebuilding relation aggregations; %zu relations so far...",
+				ret,
+			};
+	}
+
+	// A marker under event_idx 0 keeps the column from being found empty
+	// again when the database has no relations.
+	const event::idx marker {0};
+	db::txn::append
+	{
+		txn, event_relates,
+		{
+			db::op::SET,
+			byte_view<string_view>(marker),
+			string_view{},
+		}
+	};
+
+	txn();
+	log::notice
+	{
+		log, "Rebuilt relation aggregations from %zu relations.",
+		ret,
+	};
+
+	return ret;
+}
+
+//
+// util
+//
+
+bool
+ircd::m::dbs::event_relates_parse(const json::object &content,
+                                  const string_view &sender,
+                                  json::string &parent_id,
+                                  json::string &rel_type,
+                                  string_view &key)
+{
+	if(!content.has("m.relates_to", json::OBJECT))
+		return false;
+
+	const json::object &m_relates_to
+	{
+		content["m.relates_to"]
+	};
+
+	const json::string &event_id
+	{
+		m_relates_to["event_id"]
+	};
+
+	if(!valid(m::id::EVENT, event_id))
+		return false;
+
+	parent_id = event_id;
+	rel_type = m_relates_to["rel_type"];
+	// Annotations are aggregated by their key and threads by the sender of
+	// each reply, so participation is found; others have just one.
+	key =
+		rel_type == "m.annotation"?
+			string_view{json::string{m_relates_to["key"]}}:
+		rel_type == "m.thread"?
+			sender:
+			string_view{};
+
+	return !empty(rel_type)
+	&& size(rel_type) <= EVENT_RELATES_PART_MAX_SIZE
+	&& size(key) <= EVENT_RELATES_PART_MAX_SIZE;
+}
+
+/// Records are laid out as int64_t count, event_idx latest, then the
+/// rel_type and key each prefixed with a one byte length.
+std::string
+ircd::m::dbs::event_relates_delta(const string_view &rel_type,
+                                  const string_view &key,
+                                  const int64_t &count,
+                                  const event::idx &latest)
+{
+	assert(size(rel_type) <= EVENT_RELATES_PART_MAX_SIZE);
+	assert(size(key) <= EVENT_RELATES_PART_MAX_SIZE);
+
+	std::string ret;
+	ret.reserve(8 + 8 + 1 + size(rel_type) + 1 + size(key));
+	ret.append(reinterpret_cast<const char *>(&count), sizeof(count));
+	ret.append(reinterpret_cast<const char *>(&latest), sizeof(latest));
+	ret.push_back(char(size(rel_type)));
+	ret.append(data(rel_type), size(rel_type));
+	ret.push_back(char(size(key)));
+	ret.append(data(key), size(key));
+	return ret;
+}
+
+bool
+ircd::m::dbs::event_relates_decode(const string_view &val,
+                                   const event_relates_closure &closure)
+{
+	for(size_t i(0); i + 8 + 8 + 1 <= size(val); )
+	{
+		event_relates_value value;
+		memcpy(&value.count, data(val) + i, sizeof(value.count));
+		memcpy(&value.latest, data(val) + i + 8, sizeof(value.latest));
+		i += 8 + 8;
+
+		const size_t rel_type_len(uint8_t(val[i++]));
+		if(unlikely(i + rel_type_len + 1 > size(val)))
+			break;
+
+		const string_view rel_type
+		{
+			data(val) + i, rel_type_len
+		};
+
+		i += rel_type_len;
+		const size_t key_len(uint8_t(val[i++]));
+		if(unlikely(i + key_len > size(val)))
+			break;
+
+		const string_view key
+		{
+			data(val) + i, key_len
+		};
+
+		i += key_len;
+		if(!closure(rel_type, key, value))
+			return false;
+	}
+
+	return true;
+}
+
+std::string
+ircd::m::dbs::event_relates__merge_add(const string_view &,
+                                       const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	std::map<std::pair<std::string, std::string>, event_relates_value> entries;
+	const auto add{[&entries]
+	(const string_view &rel_type, const string_view &key, const event_relates_value &value)
+	{
+		auto it
+		{
+			entries.find({std::string(rel_type), std::string(key)})
+		};
+
+		if(it == end(entries) && entries.size() >= EVENT_RELATES_ENTRIES_MAX)
+			return true;
+
+		if(it == end(entries))
+			it = entries.emplace(std::make_pair(std::string(rel_type), std::string(key)), event_relates_value{}).first;
+
+		it->second.count += value.count;
+		it->second.latest = std::max(it->second.latest, value.latest);
+		return true;
+	}};
+
+	event_relates_decode(exist, add);
+	event_relates_decode(update, add);
+
+	std::string ret;
+	// Negative counts are kept; the operands may be merged before the
+	// increments they follow.
+	for(const auto &[rk, value] : entries)
+		if(value.count != 0)
+			ret += event_relates_delta(rk.first, rk.second, value.count, value.latest);
+
+	return ret;
+}
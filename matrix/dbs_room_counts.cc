@@ -0,0 +1,447 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static std::string room_counts__merge_add(const string_view &, const db::merge_delta &);
+}
+
+decltype(ircd::m::dbs::room_counts)
+ircd::m::dbs::room_counts;
+
+decltype(ircd::m::dbs::desc::room_counts__comp)
+ircd::m::dbs::desc::room_counts__comp
+{
+	{ "name",     "ircd.m.dbs._room_counts.comp" },
+	{ "default",  "default"                      },
+};
+
+decltype(ircd::m::dbs::desc::room_counts__block__size)
+ircd::m::dbs::desc::room_counts__block__size
+{
+	{ "name",     "ircd.m.dbs._room_counts.block.size" },
+	{ "default",  512L                                 },
+};
+
+decltype(ircd::m::dbs::desc::room_counts__meta_block__size)
+ircd::m::dbs::desc::room_counts__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_counts.meta_block.size" },
+	{ "default",  1024L                                     },
+};
+
+decltype(ircd::m::dbs::desc::room_counts__cache__size)
+ircd::m::dbs::desc::room_counts__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_counts.cache.size" },
+		{ "default",  long(4_MiB)                          },
+	}, []
+	{
+		const size_t &value{room_counts__cache__size};
+		db::capacity(db::cache(dbs::room_counts), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_counts__cache_comp__size)
+ircd::m::dbs::desc::room_counts__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_counts.cache_comp.size" },
+		{ "default",  long(0_MiB)                               },
+	}, []
+	{
+		const size_t &value{room_counts__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_counts), value);
+	}
+};
+
+/// Count the rooms of a database which predates this column by scanning
+/// room_events and room_state once at startup.
+decltype(ircd::m::dbs::desc::room_counts__rebuild)
+ircd::m::dbs::desc::room_counts__rebuild
+{
+	{ "name",     "ircd.m.dbs._room_counts.rebuild" },
+	{ "default",  true                              },
+};
+
+/// Counter vectors are merged by element-wise addition.
+decltype(ircd::m::dbs::desc::room_counts__merge)
+ircd::m::dbs::desc::room_counts__merge
+{
+	room_counts__merge_add
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_counts
+{
+	// name
+	"_room_counts",
+
+	// explanation
+	R"(Materialized counters for a room.
+
+	room_id => int64_t[room_counts_slot]
+
+	Each write merges a vector of deltas which are summed with the existing
+	value by the merge operator; the counters are read in constant time.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_counts__block__size),
+
+	// meta_block size
+	size_t(room_counts__meta_block__size),
+
+	// compression
+	string_view{room_counts__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	room_counts__merge,
+};
+
+//
+// indexer
+//
+
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_counts(db::txn &txn,
+                                 const event &event,
+                                 const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_COUNTS));
+
+	const int64_t sign
+	{
+		opts.op == db::op::SET?  1L:
+		opts.op == db::op::DELETE? -1L:
+		0L
+	};
+
+	if(!sign)
+		return;
+
+	room_counts_vector delta {0};
+	if(opts.appendix.test(appendix::ROOM_EVENTS))
+	{
+		delta[ROOM_COUNTS_EVENTS] += sign;
+		delta[ROOM_COUNTS_BYTES_JSON] += sign * int64_t
+		(
+			event.source && opts.json_source?
+				size(string_view(event.source)):
+				json::serialized(event)
+		);
+	}
+
+	// Membership counts track the present state; the membership being
+	// replaced is found from the present state prior to this write.
+	if(opts.appendix.test(appendix::ROOM_JOINED) && json::get<"type"_>(event) == "m.room.member")
+	{
+		const auto slot
+		{
+			room_counts_membership(m::membership(event))
+		};
+
+		if(slot >= 0)
+			delta[slot] += sign;
+
+		const auto &[room_id, state_key]
+		{
+			std::make_tuple(at<"room_id"_>(event), at<"state_key"_>(event))
+		};
+
+		const auto replaced_idx
+		{
+			sign > 0 && opts.allow_queries?
+				m::room::state(m::room::id(room_id)).get(std::nothrow, "m.room.member", state_key):
+				0UL
+		};
+
+		char buf[32];
+		const auto replaced_slot
+		{
+			replaced_idx && replaced_idx != opts.event_idx?
+				room_counts_membership(m::membership(buf, replaced_idx)):
+				-1
+		};
+
+		if(replaced_slot >= 0)
+			delta[replaced_slot] -= sign;
+	}
+
+	if(std::all_of(begin(delta), end(delta), [](const auto &v) { return v == 0; }))
+		return;
+
+	const string_view val
+	{
+		reinterpret_cast<const char *>(delta.data()), sizeof(delta)
+	};
+
+	db::txn::append
+	{
+		txn, room_counts,
+		{
+			db::op::MERGE,
+			at<"room_id"_>(event),
+			val,
+		}
+	};
+}
+
+//
+// interface
+//
+
+bool
+ircd::m::dbs::room_counts_get(room_counts_vector &ret,
+                              const id::room &room_id)
+{
+	ret.fill(0);
+	return room_counts(room_id, std::nothrow, [&ret]
+	(const string_view &val)
+	{
+		memcpy(ret.data(), data(val), std::min(size(val), sizeof(ret)));
+	});
+}
+
+int
+ircd::m::dbs::room_counts_membership(const string_view &membership)
+noexcept
+{
+	switch(hash(membership))
+	{
+		case hash("join"):     return ROOM_COUNTS_JOIN;
+		case hash("invite"):   return ROOM_COUNTS_INVITE;
+		case hash("leave"):    return ROOM_COUNTS_LEAVE;
+		case hash("ban"):      return ROOM_COUNTS_BAN;
+		case hash("knock"):    return ROOM_COUNTS_KNOCK;
+		default:               return -1;
+	}
+}
+
+/// Computes the counters of every room from the room_events and room_state
+/// indexes and writes them, replacing any existing values. A count merged by
+/// an evaluation during the scan would be lost to that replacement.
+size_t
+ircd::m::dbs::room_counts_rebuild()
+{
+	std::map<std::string, room_counts_vector, std::less<>> counts;
+	const auto vec{[&counts]
+	(const string_view &room_id) -> room_counts_vector &
+	{
+		auto it(counts.lower_bound(room_id));
+		if(it == end(counts) || it->first != room_id)
+			it = counts.emplace_hint(it, std::string(room_id), room_counts_vector{0});
+
+		return it->second;
+	}};
+
+	static const db::gopts gopts
+	{
+		db::get::NO_CACHE
+	};
+
+	size_t count(0);
+	db::column &room_events_column(room_events);
+	for(auto it(room_events_column.begin(gopts)); it; ++it)
+	{
+		const auto &[room_id, amalgam]
+		{
+			split(it->first, '\0')
+		};
+
+		const auto &[depth, event_idx]
+		{
+			room_events_key(string_view
+			{
+				room_id.end(), it->first.end()
+			})
+		};
+
+		auto &v(vec(room_id));
+		v[ROOM_COUNTS_EVENTS] += 1;
+		v[ROOM_COUNTS_BYTES_JSON] += db::bytes_value(event_json, byte_view<string_view>(event_idx), gopts);
+		if(++count % 1048576UL == 0)
+			log::info
+			{
+				log, "Rebuilding room counts; %zu events in %zu rooms so far...",
+				count,
+				counts.size(),
+			};
+	}
+
+	db::column &room_state_column(room_state);
+	for(auto it(room_state_column.begin(gopts)); it; ++it)
+	{
+		const auto &[room_id, amalgam]
+		{
+			split(it->first, '\0')
+		};
+
+		const auto &[type, state_key]
+		{
+			room_state_key(string_view
+			{
+				room_id.end(), it->first.end()
+			})
+		};
+
+		if(type != "m.room.member")
+			continue;
+
+		const event::idx event_idx
+		{
+			byte_view<event::idx>(it->second)
+		};
+
+		char buf[32];
+		const auto slot
+		{
+			room_counts_membership(m::membership(buf, event_idx))
+		};
+
+		if(slot >= 0)
+			vec(room_id)[slot] += 1;
+	}
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	for(const auto &[room_id, v] : counts)
+		db::txn::append
+		{
+			txn, room_counts,
+			{
+				db::op::SET,
+				room_id,
+				string_view
+				{
+					reinterpret_cast<const char *>(v.data()), sizeof(v)
+				},
+			}
+		};
+
+	txn();
+	log::notice
+	{
+		log, "Rebuilt room counts for %zu rooms from %zu events.",
+		counts.size(),
+		count,
+	};
+
+	return counts.size();
+}
+
+std::string
+ircd::m::dbs::room_counts__merge_add(const string_view &key,
+                                     const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	std::string ret
+	(
+		std::max(size(exist), size(update)), '\0'
+	);
+
+	const auto add{[&ret]
+	(const string_view &in)
+	{
+		for(size_t i(0); i + sizeof(int64_t) <= size(in); i += sizeof(int64_t))
+		{
+			int64_t a, b;
+			memcpy(&a, ret.data() + i, sizeof(a));
+			memcpy(&b, data(in) + i, sizeof(b));
+			a += b;
+			memcpy(ret.data() + i, &a, sizeof(a));
+		}
+	}};
+
+	add(exist);
+	add(update);
+	return ret;
+}
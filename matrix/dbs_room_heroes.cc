@@ -0,0 +1,438 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static std::string room_heroes__merge_list(const string_view &, const db::merge_delta &);
+}
+
+decltype(ircd::m::dbs::room_heroes)
+ircd::m::dbs::room_heroes;
+
+/// Number of members retained for a room. This is larger than the number of
+/// heroes in a room summary so the requesting user can be excluded and some
+/// departures absorbed before the list runs short.
+decltype(ircd::m::dbs::desc::room_heroes__max)
+ircd::m::dbs::desc::room_heroes__max
+{
+	{ "name",     "ircd.m.dbs._room_heroes.max" },
+	{ "default",  8L                            },
+};
+
+decltype(ircd::m::dbs::desc::room_heroes__comp)
+ircd::m::dbs::desc::room_heroes__comp
+{
+	{ "name",     "ircd.m.dbs._room_heroes.comp" },
+	{ "default",  "default"                      },
+};
+
+decltype(ircd::m::dbs::desc::room_heroes__block__size)
+ircd::m::dbs::desc::room_heroes__block__size
+{
+	{ "name",     "ircd.m.dbs._room_heroes.block.size" },
+	{ "default",  1024L                                },
+};
+
+decltype(ircd::m::dbs::desc::room_heroes__meta_block__size)
+ircd::m::dbs::desc::room_heroes__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_heroes.meta_block.size" },
+	{ "default",  1024L                                     },
+};
+
+decltype(ircd::m::dbs::desc::room_heroes__cache__size)
+ircd::m::dbs::desc::room_heroes__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_heroes.cache.size" },
+		{ "default",  long(4_MiB)                          },
+	}, []
+	{
+		const size_t &value{room_heroes__cache__size};
+		db::capacity(db::cache(dbs::room_heroes), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_heroes__cache_comp__size)
+ircd::m::dbs::desc::room_heroes__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_heroes.cache_comp.size" },
+		{ "default",  long(0_MiB)                               },
+	}, []
+	{
+		const size_t &value{room_heroes__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_heroes), value);
+	}
+};
+
+/// Compose the hero lists of a database which predates this column from
+/// the present room_state of every room at startup.
+decltype(ircd::m::dbs::desc::room_heroes__rebuild)
+ircd::m::dbs::desc::room_heroes__rebuild
+{
+	{ "name",     "ircd.m.dbs._room_heroes.rebuild" },
+	{ "default",  true                              },
+};
+
+/// Member lists are merged by applying each entry of the update in order.
+decltype(ircd::m::dbs::desc::room_heroes__merge)
+ircd::m::dbs::desc::room_heroes__merge
+{
+	room_heroes__merge_list
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_heroes
+{
+	// name
+	"_room_heroes",
+
+	// explanation
+	R"(Leading members of a room for its summary.
+
+	room_id => (+|-)user_id\0(+|-)user_id\0...
+
+	A bounded list of joined and invited members in the order they arrived.
+	Each change of membership in the present state merges an entry adding
+	(+) or removing (-) a member; the list is read with a single lookup.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_heroes__block__size),
+
+	// meta_block size
+	size_t(room_heroes__meta_block__size),
+
+	// compression
+	string_view{room_heroes__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	room_heroes__merge,
+};
+
+//
+// indexer
+//
+
+void
+ircd::m::dbs::_index_room_heroes(db::txn &txn,
+                                 const event &event,
+                                 const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_HEROES));
+	assert(json::get<"type"_>(event) == "m.room.member");
+
+	const string_view &membership
+	{
+		m::membership(event)
+	};
+
+	const bool member
+	{
+		membership == "join" || membership == "invite"
+	};
+
+	// The membership restored by deleting a non-member is not known here.
+	if(opts.op == db::op::DELETE && !member)
+		return;
+
+	const char sign
+	{
+		opts.op == db::op::SET && member? '+': '-'
+	};
+
+	char buf[1 + id::MAX_SIZE + 1];
+	const string_view val
+	{
+		fmt::sprintf
+		{
+			buf, "%c%s", sign, at<"state_key"_>(event)
+		}
+	};
+
+	db::txn::append
+	{
+		txn, room_heroes,
+		{
+			db::op::MERGE,
+			at<"room_id"_>(event),
+			val,
+		}
+	};
+}
+
+//
+// interface
+//
+
+bool
+ircd::m::dbs::room_heroes_for_each(const id::room &room_id,
+                                   const room_heroes_closure &closure)
+{
+	bool ret{true};
+	room_heroes(room_id, std::nothrow, [&closure, &ret]
+	(const string_view &val)
+	{
+		ret = tokens(val, '\0', [&closure]
+		(const string_view &entry) -> bool
+		{
+			if(size(entry) < 2 || entry[0] != '+')
+				return true;
+
+			return closure(id::user(entry.substr(1)));
+		});
+	});
+
+	return ret;
+}
+
+/// Computes the lists of every room from the present state and writes them,
+/// replacing any existing values. A membership change evaluated during the
+/// scan could be overwritten by the stale list of its room.
+size_t
+ircd::m::dbs::room_heroes_rebuild()
+{
+	const size_t max
+	{
+		desc::room_heroes__max
+	};
+
+	static const db::gopts gopts
+	{
+		db::get::NO_CACHE
+	};
+
+	size_t scanned(0);
+	std::map<std::string, std::pair<std::string, size_t>, std::less<>> lists;
+	db::column &room_state_column(room_state);
+	for(auto it(room_state_column.begin(gopts)); it; ++it)
+	{
+		if(++scanned % 1048576UL == 0)
+			log::info
+			{
+				log, "Rebuilding room heroes; %zu state entries in %zu rooms so far...",
+				scanned,
+				lists.size(),
+			};
+
+		const auto &[room_id, amalgam]
+		{
+			split(it->first, '\0')
+		};
+
+		const auto &[type, state_key]
+		{
+			room_state_key(string_view
+			{
+				room_id.end(), it->first.end()
+			})
+		};
+
+		if(type != "m.room.member")
+			continue;
+
+		const event::idx event_idx
+		{
+			byte_view<event::idx>(it->second)
+		};
+
+		char buf[32];
+		const string_view &membership
+		{
+			m::membership(buf, event_idx)
+		};
+
+		if(membership != "join" && membership != "invite")
+			continue;
+
+		auto lit(lists.lower_bound(room_id));
+		if(lit == end(lists) || lit->first != room_id)
+			lit = lists.emplace_hint(lit, std::string(room_id), std::pair<std::string, size_t>{});
+
+		auto &[list, count](lit->second);
+		if(count >= max)
+			continue;
+
+		list += list.empty()? "+"s : "\0+"s;
+		list += state_key;
+		++count;
+	}
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	for(const auto &[room_id, list] : lists)
+		db::txn::append
+		{
+			txn, room_heroes,
+			{
+				db::op::SET,
+				room_id,
+				list.first,
+			}
+		};
+
+	txn();
+	log::notice
+	{
+		log, "Rebuilt room heroes for %zu rooms.",
+		lists.size(),
+	};
+
+	return lists.size();
+}
+
+/// The existing value and the update are both lists of entries. Entries of
+/// the update replace any entry for the same member and are appended in
+/// order. Removals are retained as entries because the existing value may
+/// itself be a partial merge of operands lacking the base value; both kinds
+/// are bounded so the value cannot grow with the room's history.
+std::string
+ircd::m::dbs::room_heroes__merge_list(const string_view &key,
+                                      const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	std::vector<string_view> list;
+	list.reserve(size_t(desc::room_heroes__max) * 2);
+	tokens(exist, '\0', [&list]
+	(const string_view &entry) -> bool
+	{
+		if(size(entry) >= 2)
+			list.emplace_back(entry);
+
+		return true;
+	});
+
+	tokens(update, '\0', [&list]
+	(const string_view &entry) -> bool
+	{
+		if(size(entry) < 2)
+			return true;
+
+		const auto same{[&entry]
+		(const string_view &other)
+		{
+			return other.substr(1) == entry.substr(1);
+		}};
+
+		list.erase(std::remove_if(begin(list), end(list), same), end(list));
+		list.emplace_back(entry);
+		return true;
+	});
+
+	// Members beyond the limit are dropped from the end so the list retains
+	// the earliest arrivals; removals are dropped from the front.
+	const size_t max(desc::room_heroes__max);
+	const size_t removes
+	(
+		std::count_if(begin(list), end(list), [](const auto &entry)
+		{
+			return entry[0] == '-';
+		})
+	);
+
+	size_t adds(0), skip(removes > max? removes - max: 0);
+	std::string ret;
+	ret.reserve(size(exist) + size(update));
+	for(const auto &entry : list)
+	{
+		if(entry[0] == '+' && adds++ >= max)
+			continue;
+
+		if(entry[0] == '-' && skip && skip--)
+			continue;
+
+		if(!ret.empty())
+			ret.push_back('\0');
+
+		ret.append(data(entry), size(entry));
+	}
+
+	return ret;
+}
@@ -0,0 +1,397 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static bool room_idx_interns(const event &, const write_opts &);
+}
+
+decltype(ircd::m::dbs::room_idx)
+ircd::m::dbs::room_idx;
+
+decltype(ircd::m::dbs::desc::room_idx__comp)
+ircd::m::dbs::desc::room_idx__comp
+{
+	{ "name",     "ircd.m.dbs._room_idx.comp" },
+	{ "default",  "default"                   },
+};
+
+decltype(ircd::m::dbs::desc::room_idx__block__size)
+ircd::m::dbs::desc::room_idx__block__size
+{
+	{ "name",     "ircd.m.dbs._room_idx.block.size" },
+	{ "default",  256L                              },
+};
+
+decltype(ircd::m::dbs::desc::room_idx__meta_block__size)
+ircd::m::dbs::desc::room_idx__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_idx.meta_block.size" },
+	{ "default",  1024L                                  },
+};
+
+decltype(ircd::m::dbs::desc::room_idx__cache__size)
+ircd::m::dbs::desc::room_idx__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_idx.cache.size" },
+		{ "default",  long(8_MiB)                       },
+	}, []
+	{
+		const size_t &value{room_idx__cache__size};
+		db::capacity(db::cache(dbs::room_idx), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_idx__cache_comp__size)
+ircd::m::dbs::desc::room_idx__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_idx.cache_comp.size" },
+		{ "default",  long(0_MiB)                            },
+	}, []
+	{
+		const size_t &value{room_idx__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_idx), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_idx__bloom__bits)
+ircd::m::dbs::desc::room_idx__bloom__bits
+{
+	{ "name",     "ircd.m.dbs._room_idx.bloom.bits" },
+	{ "default",  10L                               },
+};
+
+/// Intern the rooms of a database which predates this column at startup,
+/// converting their keys in room_type.
+decltype(ircd::m::dbs::desc::room_idx__rebuild)
+ircd::m::dbs::desc::room_idx__rebuild
+{
+	{ "name",     "ircd.m.dbs._room_idx.rebuild" },
+	{ "default",  true                           },
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_idx
+{
+	// name
+	"_room_idx",
+
+	// explanation
+	R"(Maps matrix room_id strings into internal index numbers.
+
+	room_id => room_idx
+
+	The room_idx is the event_idx of the room's create event, so it is unique
+	and the room_id is recovered from it like any other event property. Room
+	keyed columns which support it replace the room_id prefix of their keys
+	with this fixed 8 byte number. A room is interned only by a create event
+	which is the first event of the room written to the database; a room
+	lacking an entry here continues to use the room_id in its keys.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(uint64_t)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	size_t(room_idx__bloom__bits),
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_idx__block__size),
+
+	// meta_block size
+	size_t(room_idx__meta_block__size),
+
+	// compression
+	string_view{room_idx__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+};
+
+//
+// indexer
+//
+
+void
+ircd::m::dbs::_index_room_idx(db::txn &txn,
+                              const event &event,
+                              const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_IDX));
+	if(!room_idx_interns(event, opts))
+		return;
+
+	db::txn::append
+	{
+		txn, room_idx,
+		{
+			db::op::SET,
+			at<"room_id"_>(event),
+			byte_view<string_view>(opts.event_idx),
+		}
+	};
+}
+
+/// The room_idx to key an event's room with while it is being written. This
+/// is the event's own index when it interns the room; otherwise the room is
+/// found in the database or earlier in the same transaction.
+// NOTE: QUERY
+ircd::m::event::idx
+ircd::m::dbs::_room_idx(const db::txn &txn,
+                        const event &event,
+                        const write_opts &opts)
+{
+	if(room_idx_interns(event, opts))
+		return opts.event_idx;
+
+	const id::room &room_id
+	{
+		at<"room_id"_>(event)
+	};
+
+	if(const auto ret{room_idx_get(room_id)}; ret)
+		return ret;
+
+	event::idx ret{0};
+	txn.get(db::op::SET, desc::room_idx.name, room_id, [&ret]
+	(const string_view &val)
+	{
+		ret = byte_view<event::idx>(val);
+	});
+
+	return ret;
+}
+
+// NOTE: QUERY
+bool
+ircd::m::dbs::room_idx_interns(const event &event,
+                               const write_opts &opts)
+{
+	return true
+	&& opts.op == db::op::SET
+	&& opts.appendix.test(appendix::ROOM_IDX)
+	&& json::get<"type"_>(event) == "m.room.create"
+	&& defined(json::get<"state_key"_>(event))
+	&& empty(json::get<"state_key"_>(event))
+	&& !room::index(at<"room_id"_>(event), std::nothrow)
+	;
+}
+
+//
+// interface
+//
+
+ircd::m::event::idx
+ircd::m::dbs::room_idx_get(const id::room &room_id)
+{
+	event::idx ret{0};
+	room_idx(room_id, std::nothrow, [&ret]
+	(const string_view &val)
+	{
+		ret = byte_view<event::idx>(val);
+	});
+
+	return ret;
+}
+
+/// Interns every room found in the room_type column lacking an entry here,
+/// converting its keys in that column to the room_idx prefix. Transactions
+/// are only committed between rooms, and the entry of a room is written in
+/// the same transaction as the last of its keys, so an interruption leaves
+/// each room either entirely converted and interned or untouched. A room
+/// created by a concurrent evaluation could be interned twice.
+size_t
+ircd::m::dbs::room_idx_rebuild()
+{
+	static const db::gopts gopts
+	{
+		db::get::NO_CACHE
+	};
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	std::string room_id;
+	char prefix_buf[ROOM_KEY_IDX_SIZE];
+	string_view prefix;
+	event::idx interned(0), interning(0);
+	size_t rooms(0), keys(0), committed(0);
+	const auto intern{[&](const bool &last)
+	{
+		if(interning)
+		{
+			db::txn::append
+			{
+				txn, room_idx,
+				{
+					db::op::SET,
+					room_id,
+					byte_view<string_view>(interning),
+				}
+			};
+
+			++rooms;
+		}
+
+		// Small rooms are batched; a room is never split across commits.
+		if(!txn.size() || (!last && keys - committed < 65536UL))
+			return;
+
+		txn();
+		txn.clear();
+		committed = keys;
+		if(!last)
+			log::info
+			{
+				log, "Interning rooms; %zu keys in %zu rooms so far...",
+				keys,
+				rooms,
+			};
+	}};
+
+	db::column &room_type_column(room_type);
+	for(auto it(room_type_column.begin(gopts)); it; ++it)
+	{
+		const auto &key(it->first);
+		if(!room_key_has(key) || key[0] == ROOM_KEY_IDX)
+			continue;
+
+		const string_view &_room_id
+		{
+			room_key(key)
+		};
+
+		if(_room_id != room_id)
+		{
+			intern(false);
+			room_id = _room_id;
+			interned = room_idx_get(room_id);
+			interning = !interned? room::index(room_id, std::nothrow): 0UL;
+			prefix = room_key(prefix_buf, room_id, interned?: interning);
+		}
+
+		// Keys still under the room_id of a room already interned are
+		// converted as well.
+		if(!interned && !interning)
+			continue;
+
+		char buf[ROOM_TYPE_KEY_MAX_SIZE];
+		mutable_buffer out(buf);
+		consume(out, copy(out, prefix));
+		consume(out, copy(out, string_view{key.substr(size(_room_id))}));
+		db::txn::append
+		{
+			txn, room_type_column,
+			{
+				db::op::SET,
+				string_view{buf, data(out)},
+			}
+		};
+
+		db::txn::append
+		{
+			txn, room_type_column,
+			{
+				db::op::DELETE,
+				key,
+			}
+		};
+
+		++keys;
+	}
+
+	intern(true);
+	log::notice
+	{
+		log, "Interned %zu rooms converting %zu keys.",
+		rooms,
+		keys,
+	};
+
+	return rooms;
+}
+
+ircd::string_view
+ircd::m::dbs::room_key(const mutable_buffer &out,
+                       const id::room &room_id)
+{
+	return room_key(out, room_id, room_idx_get(room_id));
+}
+
+ircd::string_view
+ircd::m::dbs::room_key(const mutable_buffer &out_,
+                       const id::room &room_id,
+                       const event::idx &room_idx)
+{
+	mutable_buffer out{out_};
+	if(!room_idx)
+	{
+		consume(out, copy(out, room_id));
+		return { data(out_), data(out) };
+	}
+
+	consume(out, copy(out, ROOM_KEY_IDX));
+	consume(out, copy(out, byte_view<string_view>(room_idx)));
+	return { data(out_), data(out) };
+}
+
+/// Extract the room prefix of a key in either format; keys prefixed with a
+/// room_id are terminated by the separator.
+ircd::string_view
+ircd::m::dbs::room_key(const string_view &key,
+                       const char &sep)
+{
+	if(likely(!empty(key)) && key[0] == ROOM_KEY_IDX)
+		return key.substr(0, ROOM_KEY_IDX_SIZE);
+
+	return split(key, sep).first;
+}
+
+/// Whether the key has anything following its room prefix.
+bool
+ircd::m::dbs::room_key_has(const string_view &key,
+                           const char &sep)
+{
+	if(likely(!empty(key)) && key[0] == ROOM_KEY_IDX)
+		return size(key) > ROOM_KEY_IDX_SIZE;
+
+	return has(key, sep);
+}
@@ -203,6 +203,8 @@ ircd::m::dbs::_index_room_joined(db::txn &txn,
 			val,
 		}
 	};
+
+	room::origins::invalidate(at<"room_id"_>(event));
 }
 
 //
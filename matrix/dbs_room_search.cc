@@ -0,0 +1,778 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	struct room_search_cursor;
+	using room_search_posting = std::pair<event::idx, bool>;
+	using room_search_posting_closure = std::function<bool (const event::idx &, const bool &)>;
+
+	static size_t room_search_varint(const mutable_buffer &, uint64_t);
+	static size_t room_search_varint(const string_view &, uint64_t &);
+	static uint64_t room_search_bucket(const string_view &key);
+	static bool room_search_postings(const string_view &val, const uint64_t &bucket, const room_search_posting_closure &);
+	static std::string room_search_encode(const uint64_t &bucket, const vector_view<const room_search_posting> &);
+	static std::string room_search__merge_union(const string_view &, const db::merge_delta &);
+
+	extern const string_view room_search_floor_key;
+}
+
+/// Iterates the postings of one term in descending order of event_idx,
+/// loading a bucket at a time.
+struct ircd::m::dbs::room_search_cursor
+{
+	std::string prefix;
+	db::column::const_iterator it;
+	std::vector<event::idx> list;
+	size_t pos {0};
+	uint64_t bucket {0};
+	bool loaded {false};
+	bool done {false};
+
+	bool load();
+	event::idx seek(const event::idx &target);
+
+	room_search_cursor(const string_view &room_key, const string_view &term);
+};
+
+decltype(ircd::m::dbs::room_search)
+ircd::m::dbs::room_search;
+
+/// Sorts after every room prefix; holds the event_idx from which events are
+/// indexed. Events below it were written before the column existed.
+decltype(ircd::m::dbs::room_search_floor_key)
+ircd::m::dbs::room_search_floor_key
+{
+	"\xff"
+};
+
+decltype(ircd::m::dbs::desc::room_search__comp)
+ircd::m::dbs::desc::room_search__comp
+{
+	{ "name",     "ircd.m.dbs._room_search.comp" },
+	{ "default",  "default"                      },
+};
+
+decltype(ircd::m::dbs::desc::room_search__block__size)
+ircd::m::dbs::desc::room_search__block__size
+{
+	{ "name",     "ircd.m.dbs._room_search.block.size" },
+	{ "default",  4096L                                },
+};
+
+decltype(ircd::m::dbs::desc::room_search__meta_block__size)
+ircd::m::dbs::desc::room_search__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_search.meta_block.size" },
+	{ "default",  4096L                                     },
+};
+
+decltype(ircd::m::dbs::desc::room_search__cache__size)
+ircd::m::dbs::desc::room_search__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_search.cache.size" },
+		{ "default",  long(16_MiB)                         },
+	}, []
+	{
+		const size_t &value{room_search__cache__size};
+		db::capacity(db::cache(dbs::room_search), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_search__cache_comp__size)
+ircd::m::dbs::desc::room_search__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_search.cache_comp.size" },
+		{ "default",  long(0_MiB)                               },
+	}, []
+	{
+		const size_t &value{room_search__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_search), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_search__terms__max)
+ircd::m::dbs::desc::room_search__terms__max
+{
+	{ "name",     "ircd.m.dbs._room_search.terms.max" },
+	{ "default",  512L                                },
+};
+
+/// Index the content of every event when the column is first created for a
+/// database which already has events. This reads the entire database at
+/// startup; otherwise only new events are indexed and search scans the rest.
+decltype(ircd::m::dbs::desc::room_search__rebuild)
+ircd::m::dbs::desc::room_search__rebuild
+{
+	{ "name",     "ircd.m.dbs._room_search.rebuild" },
+	{ "default",  false                             },
+};
+
+/// Postings are merged as a union ordered by event_idx; a removal supersedes
+/// the posting it matches and remains as a tombstone.
+decltype(ircd::m::dbs::desc::room_search__merge)
+ircd::m::dbs::desc::room_search__merge
+{
+	room_search__merge_union
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_search
+{
+	// name
+	"_room_search",
+
+	// explanation
+	R"(Inverted index of the terms of message content in a room.
+
+	room_id | term, ~bucket => varint[]
+
+	The content body, name and topic of each event are tokenized into
+	lowercase terms of letters and numbers. The key is the room prefix,
+	the term and the complement of the bucket (event_idx >> 12) in big
+	endian, so the most recent postings sort first. The value is the
+	ascending sequence of event_idx in the bucket, delta encoded as
+	varints with the low bit marking a removal.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_search__block__size),
+
+	// meta_block size
+	size_t(room_search__meta_block__size),
+
+	// compression
+	string_view{room_search__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{ 256_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	4096,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	room_search__merge,
+};
+
+//
+// indexer
+//
+
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_search(db::txn &txn,
+                                 const event &event,
+                                 const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_SEARCH));
+
+	const bool removal
+	{
+		opts.op == db::op::DELETE
+	};
+
+	if(opts.op != db::op::SET && !removal)
+		return;
+
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	if(empty(content))
+		return;
+
+	std::set<std::string, std::less<>> terms;
+	const auto add{[&terms]
+	(const string_view &term)
+	{
+		terms.emplace(term);
+		return terms.size() < size_t(desc::room_search__terms__max);
+	}};
+
+	for(const string_view &field : {"body"_sv, "name"_sv, "topic"_sv})
+	{
+		const json::object::const_iterator it
+		{
+			content.find(field)
+		};
+
+		if(it == content.end() || json::type(it->second) != json::STRING)
+			continue;
+
+		const json::string text
+		{
+			it->second
+		};
+
+		const unique_mutable_buffer buf
+		{
+			size(text)
+		};
+
+		if(!room_search_terms(json::unescape(buf, text), add))
+			break;
+	}
+
+	if(terms.empty())
+		return;
+
+	const event::idx room_idx
+	{
+		_room_idx(txn, event, opts)
+	};
+
+	char room_key_buf[id::MAX_SIZE];
+	const string_view room_key
+	{
+		dbs::room_key(room_key_buf, at<"room_id"_>(event), room_idx)
+	};
+
+	const room_search_posting posting
+	{
+		opts.event_idx, removal
+	};
+
+	const std::string val
+	{
+		room_search_encode(opts.event_idx >> ROOM_SEARCH_BUCKET_SHIFT, {&posting, 1})
+	};
+
+	for(const auto &term : terms)
+	{
+		char buf[ROOM_SEARCH_KEY_MAX_SIZE];
+		const string_view &key
+		{
+			room_search_key(buf, room_key, term, opts.event_idx)
+		};
+
+		db::txn::append
+		{
+			txn, room_search,
+			{
+				db::op::MERGE,
+				key,
+				val,
+			}
+		};
+	}
+}
+
+//
+// interface
+//
+
+/// Intersects the postings of every term, calling the closure for each
+/// event_idx at or below `from` containing all of them, newest first.
+bool
+ircd::m::dbs::room_search_for_each(const id::room &room_id,
+                                   const vector_view<const string_view> &terms,
+                                   const event::idx &from,
+                                   const event::closure_idx_bool &closure)
+{
+	if(terms.empty())
+		return true;
+
+	char room_key_buf[id::MAX_SIZE];
+	const string_view room_key
+	{
+		dbs::room_key(room_key_buf, room_id)
+	};
+
+	std::vector<room_search_cursor> cursors;
+	cursors.reserve(terms.size());
+	for(const auto &term : terms)
+		cursors.emplace_back(room_key, term);
+
+	event::idx target{from};
+	while(target)
+	{
+		bool agree{true};
+		for(auto &cursor : cursors)
+		{
+			const auto event_idx
+			{
+				cursor.seek(target)
+			};
+
+			if(!event_idx)
+				return true;
+
+			agree &= event_idx == target;
+			target = event_idx;
+		}
+
+		if(!agree)
+			continue;
+
+		if(!closure(target))
+			return false;
+
+		--target;
+	}
+
+	return true;
+}
+
+/// Splits text into search terms: maximal runs of letters, marks and numbers
+/// folded to lowercase. Ideographs are emitted one per term since those
+/// scripts do not delimit words. Terms are truncated to the maximum size.
+bool
+ircd::m::dbs::room_search_terms(const string_view &text,
+                                const room_search_term_closure &closure)
+{
+	char buf[ROOM_SEARCH_TERM_MAX_SIZE];
+	size_t len(0);
+	const auto flush{[&closure, &buf, &len]
+	{
+		const string_view term
+		{
+			buf, len
+		};
+
+		len = 0;
+		return empty(term) || closure(term);
+	}};
+
+	for(size_t i(0); i < size(text); )
+	{
+		const int32_t ch
+		(
+			icu::utf8::get(text.substr(i))
+		);
+
+		i += ch >= 0?
+			std::max(icu::utf8::length(char32_t(ch)), 1UL):
+			1UL;
+
+		const int8_t category
+		{
+			ch >= 0? icu::category(ch): int8_t(0)
+		};
+
+		// Letters (1-5), marks (6-8) and numbers (9-11)
+		if(category < 1 || category > 11)
+		{
+			if(!flush())
+				return false;
+
+			continue;
+		}
+
+		const bool ideograph
+		{
+			category == 5 && ch >= 0x2e80
+		};
+
+		if(ideograph && !flush())
+			return false;
+
+		const char32_t lower
+		{
+			icu::tolower(ch)
+		};
+
+		char enc_buf[4];
+		const const_buffer enc
+		{
+			icu::utf8::encode(enc_buf, {&lower, 1})
+		};
+
+		if(len + size(enc) <= sizeof(buf))
+			len += copy(mutable_buffer{buf + len, sizeof(buf) - len}, enc);
+
+		if(ideograph && !flush())
+			return false;
+	}
+
+	return flush();
+}
+
+ircd::m::event::idx
+ircd::m::dbs::room_search_floor()
+{
+	event::idx ret{0};
+	room_search(room_search_floor_key, std::nothrow, [&ret]
+	(const string_view &val)
+	{
+		ret = byte_view<event::idx>(val);
+	});
+
+	return ret;
+}
+
+void
+ircd::m::dbs::room_search_floor(const event::idx &event_idx)
+{
+	db::write(room_search, room_search_floor_key, byte_view<string_view>(event_idx));
+}
+
+/// Indexes the content of every event in the database; init runs this only
+/// when configured by ircd.m.dbs._room_search.rebuild.
+size_t
+ircd::m::dbs::room_search_rebuild()
+{
+	static const db::gopts gopts
+	{
+		db::get::NO_CACHE
+	};
+
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	write_opts opts;
+	opts.appendix.reset();
+	opts.appendix.set(appendix::ROOM_SEARCH);
+
+	size_t ret(0);
+	m::event::fetch event;
+	for(auto it(event_json.begin(gopts)); it; ++it)
+	{
+		opts.event_idx = byte_view<event::idx>(it->first);
+		if(!seek(std::nothrow, event, opts.event_idx))
+			continue;
+
+		if(!json::get<"room_id"_>(event) || empty(json::get<"content"_>(event)))
+			continue;
+
+		_index_room_search(txn, event, opts);
+		if(++ret % 4096UL)
+			continue;
+
+		txn();
+		txn.clear();
+		if(ret % 1048576UL == 0)
+			log::info
+			{
+				log, "Rebuilding search index; %zu events so far...",
+				ret,
+			};
+	}
+
+	txn();
+	room_search_floor(0UL);
+	log::notice
+	{
+		log, "Rebuilt search index from %zu events.",
+		ret,
+	};
+
+	return ret;
+}
+
+ircd::string_view
+ircd::m::dbs::room_search_key(const mutable_buffer &out_,
+                              const string_view &room_key,
+                              const string_view &term,
+                              const event::idx &event_idx)
+{
+	const uint64_t bucket
+	{
+		hton(~(uint64_t(event_idx) >> ROOM_SEARCH_BUCKET_SHIFT))
+	};
+
+	mutable_buffer out{out_};
+	consume(out, copy(out, room_key));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, trunc(term, ROOM_SEARCH_TERM_MAX_SIZE)));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, byte_view<string_view>(bucket)));
+	return { data(out_), data(out) };
+}
+
+//
+// room_search_cursor
+//
+
+ircd::m::dbs::room_search_cursor::room_search_cursor(const string_view &room_key,
+                                                     const string_view &term)
+:prefix
+{
+	room_key
+}
+{
+	prefix.push_back('\0');
+	prefix.append(trunc(term, ROOM_SEARCH_TERM_MAX_SIZE));
+	prefix.push_back('\0');
+}
+
+/// Positions on the greatest posting not above the target; zero when the
+/// postings are exhausted. Targets must not increase between calls.
+ircd::m::event::idx
+ircd::m::dbs::room_search_cursor::seek(const event::idx &target)
+{
+	const uint64_t target_bucket
+	{
+		target >> ROOM_SEARCH_BUCKET_SHIFT
+	};
+
+	while(!done)
+	{
+		while(pos < list.size() && list[pos] > target)
+			++pos;
+
+		if(pos < list.size())
+			return list[pos];
+
+		// Buckets sort newest first; the next one is adjacent unless the
+		// target has moved below it, in which case seek past the gap.
+		if(!loaded || target_bucket < bucket)
+		{
+			const uint64_t key_bucket
+			{
+				hton(~target_bucket)
+			};
+
+			char buf[ROOM_SEARCH_KEY_MAX_SIZE];
+			mutable_buffer out{buf};
+			consume(out, copy(out, string_view{prefix}));
+			consume(out, copy(out, byte_view<string_view>(key_bucket)));
+			it = room_search.lower_bound(string_view{buf, data(out)});
+		}
+		else ++it;
+
+		loaded = true;
+		done = !load();
+	}
+
+	return 0;
+}
+
+bool
+ircd::m::dbs::room_search_cursor::load()
+{
+	if(!it || !startswith(it->first, prefix) || size(it->first) != size(prefix) + 8)
+		return false;
+
+	bucket = room_search_bucket(it->first);
+	list.clear();
+	pos = 0;
+	room_search_postings(it->second, bucket, [this]
+	(const event::idx &event_idx, const bool &removal)
+	{
+		if(!removal)
+			list.emplace_back(event_idx);
+
+		return true;
+	});
+
+	std::reverse(begin(list), end(list));
+	return true;
+}
+
+//
+// internal
+//
+
+std::string
+ircd::m::dbs::room_search__merge_union(const string_view &key,
+                                       const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	const uint64_t bucket
+	{
+		room_search_bucket(key)
+	};
+
+	std::vector<room_search_posting> postings;
+	const auto append{[&postings]
+	(const event::idx &event_idx, const bool &removal)
+	{
+		postings.emplace_back(event_idx, removal);
+		return true;
+	}};
+
+	room_search_postings(exist, bucket, append);
+	room_search_postings(update, bucket, append);
+	std::stable_sort(begin(postings), end(postings), []
+	(const auto &a, const auto &b)
+	{
+		return a.first < b.first;
+	});
+
+	// The update follows the existing value for the same event_idx, so the
+	// last of each run is the one kept.
+	std::vector<room_search_posting> ret;
+	ret.reserve(postings.size());
+	for(const auto &posting : postings)
+		if(!ret.empty() && ret.back().first == posting.first)
+			ret.back() = posting;
+		else
+			ret.emplace_back(posting);
+
+	return room_search_encode(bucket, ret);
+}
+
+std::string
+ircd::m::dbs::room_search_encode(const uint64_t &bucket,
+                                 const vector_view<const room_search_posting> &postings)
+{
+	std::string ret;
+	ret.reserve(postings.size() * 2);
+
+	uint64_t last(bucket << ROOM_SEARCH_BUCKET_SHIFT);
+	for(const auto &[event_idx, removal] : postings)
+	{
+		assert(event_idx >= last);
+		char buf[10];
+		const size_t len
+		{
+			room_search_varint(buf, ((event_idx - last) << 1) | removal)
+		};
+
+		ret.append(buf, len);
+		last = event_idx;
+	}
+
+	return ret;
+}
+
+bool
+ircd::m::dbs::room_search_postings(const string_view &val,
+                                   const uint64_t &bucket,
+                                   const room_search_posting_closure &closure)
+{
+	uint64_t last(bucket << ROOM_SEARCH_BUCKET_SHIFT);
+	for(size_t i(0); i < size(val); )
+	{
+		uint64_t delta;
+		const size_t len
+		{
+			room_search_varint(val.substr(i), delta)
+		};
+
+		if(unlikely(!len))
+			return true;
+
+		i += len;
+		last += delta >> 1;
+		if(!closure(last, delta & 1))
+			return false;
+	}
+
+	return true;
+}
+
+uint64_t
+ircd::m::dbs::room_search_bucket(const string_view &key)
+{
+	if(unlikely(size(key) < 8))
+		return 0;
+
+	const uint64_t bucket
+	{
+		byte_view<uint64_t>(key.substr(size(key) - 8))
+	};
+
+	return ~ntoh(bucket);
+}
+
+size_t
+ircd::m::dbs::room_search_varint(const mutable_buffer &out,
+                                 uint64_t val)
+{
+	size_t i(0);
+	for(; val >= 0x80 && i < size(out); ++i, val >>= 7)
+		out[i] = char(val | 0x80);
+
+	if(i < size(out))
+		out[i++] = char(val);
+
+	return i;
+}
+
+size_t
+ircd::m::dbs::room_search_varint(const string_view &in,
+                                 uint64_t &val)
+{
+	val = 0;
+	for(size_t i(0); i < size(in) && i < 10; ++i)
+	{
+		val |= uint64_t(uint8_t(in[i]) & 0x7f) << (i * 7);
+		if(!(uint8_t(in[i]) & 0x80))
+			return i + 1;
+	}
+
+	return 0;
+}
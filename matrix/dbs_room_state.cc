@@ -32,6 +32,14 @@ ircd::m::dbs::desc::room_state__meta_block__size
 	{ "default",  8192L                                    },
 };
 
+/// Pin the top-level index and filter partitions of this column in the cache.
+decltype(ircd::m::dbs::desc::room_state__meta_block__pin)
+ircd::m::dbs::desc::room_state__meta_block__pin
+{
+	{ "name",     "ircd.m.dbs._room_state.meta_block.pin" },
+	{ "default",  true                                    },
+};
+
 decltype(ircd::m::dbs::desc::room_state__cache__size)
 ircd::m::dbs::desc::room_state__cache__size
 {
@@ -148,6 +156,39 @@ ircd::m::dbs::desc::room_state
 
 	// compaction priority algorithm
 	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	bool(room_state__meta_block__pin),
 };
 
 //
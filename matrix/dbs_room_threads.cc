@@ -0,0 +1,300 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static std::string room_threads__merge_max(const string_view &, const db::merge_delta &);
+}
+
+decltype(ircd::m::dbs::room_threads)
+ircd::m::dbs::room_threads;
+
+decltype(ircd::m::dbs::desc::room_threads__comp)
+ircd::m::dbs::desc::room_threads__comp
+{
+	{ "name",     "ircd.m.dbs._room_threads.comp" },
+	{ "default",  "default"                       },
+};
+
+decltype(ircd::m::dbs::desc::room_threads__block__size)
+ircd::m::dbs::desc::room_threads__block__size
+{
+	{ "name",     "ircd.m.dbs._room_threads.block.size" },
+	{ "default",  512L                                  },
+};
+
+decltype(ircd::m::dbs::desc::room_threads__meta_block__size)
+ircd::m::dbs::desc::room_threads__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_threads.meta_block.size" },
+	{ "default",  1024L                                      },
+};
+
+decltype(ircd::m::dbs::desc::room_threads__cache__size)
+ircd::m::dbs::desc::room_threads__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_threads.cache.size" },
+		{ "default",  long(4_MiB)                           },
+	}, []
+	{
+		const size_t &value{room_threads__cache__size};
+		db::capacity(db::cache(dbs::room_threads), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_threads__cache_comp__size)
+ircd::m::dbs::desc::room_threads__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_threads.cache_comp.size" },
+		{ "default",  long(0_MiB)                                },
+	}, []
+	{
+		const size_t &value{room_threads__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_threads), value);
+	}
+};
+
+/// The latest reply is the greatest event_idx, so replies arriving out of
+/// order don't regress it.
+decltype(ircd::m::dbs::desc::room_threads__merge)
+ircd::m::dbs::desc::room_threads__merge
+{
+	room_threads__merge_max
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_threads
+{
+	// name
+	"_room_threads",
+
+	// explanation
+	R"(Thread roots of a room.
+
+	room_id | root_idx => event_idx
+
+	Each reply in a thread (an m.thread relation) merges its event_idx into
+	the entry of the root. The threads of a room are listed without scanning
+	its timeline; the summary of each is found in _event_relates.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(uint64_t)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_threads__block__size),
+
+	// meta_block size
+	size_t(room_threads__meta_block__size),
+
+	// compression
+	string_view{room_threads__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	room_threads__merge,
+};
+
+//
+// indexer
+//
+
+/// Called for an m.thread relation when it's aggregated (EVENT_RELATES).
+void
+ircd::m::dbs::_index_room_threads(db::txn &txn,
+                                  const event &event,
+                                  const write_opts &opts,
+                                  const event::idx &root)
+{
+	assert(opts.appendix.test(appendix::EVENT_RELATES));
+	assert(root && opts.event_idx);
+
+	if(opts.op != db::op::SET || !json::get<"room_id"_>(event))
+		return;
+
+	char buf[ROOM_THREADS_KEY_MAX_SIZE];
+	db::txn::append
+	{
+		txn, room_threads,
+		{
+			db::op::MERGE,
+			room_threads_key(buf, at<"room_id"_>(event), root),
+			byte_view<string_view>(opts.event_idx),
+		}
+	};
+}
+
+//
+// interface
+//
+
+/// Iterates the thread roots of the room with the latest reply to each; the
+/// order is by root_idx.
+bool
+ircd::m::dbs::room_threads_for_each(const id::room &room_id,
+                                    const room_threads_closure &closure)
+{
+	char buf[ROOM_THREADS_KEY_MAX_SIZE];
+	const string_view prefix
+	{
+		room_threads_key(buf, room_id, 0UL)
+	};
+
+	const string_view room_key
+	{
+		prefix.substr(0, size(prefix) - sizeof(event::idx))
+	};
+
+	for(auto it(room_threads.lower_bound(prefix)); it; ++it)
+	{
+		const auto &[key, val]
+		{
+			*it
+		};
+
+		if(!startswith(key, room_key) || size(key) != size(prefix))
+			break;
+
+		const event::idx root
+		{
+			ntoh(event::idx(byte_view<event::idx>(key.substr(size(room_key)))))
+		};
+
+		const event::idx latest
+		{
+			size(val) >= sizeof(event::idx)?
+				event::idx(byte_view<event::idx>(val)):
+				0UL
+		};
+
+		if(!closure(root, latest))
+			return false;
+	}
+
+	return true;
+}
+
+/// The root_idx is big-endian so roots of a room are found in order.
+ircd::string_view
+ircd::m::dbs::room_threads_key(const mutable_buffer &out_,
+                               const id::room &room_id,
+                               const event::idx &root)
+{
+	const event::idx root_be
+	{
+		hton(root)
+	};
+
+	mutable_buffer out{out_};
+	consume(out, copy(out, string_view{room_id}));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, byte_view<string_view>(root_be)));
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
+
+std::string
+ircd::m::dbs::room_threads__merge_max(const string_view &,
+                                      const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	const auto get{[](const string_view &val) -> event::idx
+	{
+		return size(val) >= sizeof(event::idx)?
+			event::idx(byte_view<event::idx>(val)):
+			0UL;
+	}};
+
+	const event::idx ret
+	{
+		std::max(get(exist), get(update))
+	};
+
+	return std::string
+	{
+		reinterpret_cast<const char *>(&ret), sizeof(ret)
+	};
+}
@@ -63,8 +63,9 @@ ircd::m::dbs::desc::room_type__cache_comp__size
 	}
 };
 
-/// Prefix transform for the room_type. The prefix here is a room_id
-/// and the suffix is the type+depth+event_id concatenation.
+/// Prefix transform for the room_type. The prefix here is a room_id, or
+/// the room_idx of an interned room (see: room_idx.h), and the suffix is the
+/// type+depth+event_id concatenation.
 /// for efficient sequences
 ///
 const ircd::db::prefix_transform
@@ -74,12 +75,12 @@ ircd::m::dbs::desc::room_type__pfx
 
 	[](const string_view &key)
 	{
-		return has(key, "\0"_sv);
+		return room_key_has(key);
 	},
 
 	[](const string_view &key)
 	{
-		return split(key, '\0').first;
+		return room_key(key);
 	}
 };
 
@@ -100,6 +101,10 @@ ircd::m::dbs::desc::room_type__cmp
 ///
 /// [room_id | type, depth, event_idx]
 ///
+/// A room interned in the room_idx column is keyed by its room_idx instead:
+///
+/// [room_idx | type, depth, event_idx]
+///
 const ircd::db::descriptor
 ircd::m::dbs::desc::room_type
 {
@@ -111,6 +116,8 @@ ircd::m::dbs::desc::room_type
 
 	[room_id | type, depth, event_idx]
 
+	An interned room is prefixed by its room_idx rather than its room_id.
+
 	)",
 
 	// typing (key, value)
@@ -163,6 +170,7 @@ ircd::m::dbs::desc::room_type
 //
 
 /// Adds the entry for the room_type column into the txn.
+// NOTE: QUERY
 void
 ircd::m::dbs::_index_room_type(db::txn &txn,
                                const event &event,
@@ -170,11 +178,16 @@ ircd::m::dbs::_index_room_type(db::txn &txn,
 {
 	assert(opts.appendix.test(appendix::ROOM_TYPE));
 
+	const event::idx room_idx
+	{
+		_room_idx(txn, event, opts)
+	};
+
 	thread_local char buf[ROOM_TYPE_KEY_MAX_SIZE];
 	const ctx::critical_assertion ca;
 	const string_view &key
 	{
-		room_type_key(buf, at<"room_id"_>(event), at<"type"_>(event), at<"depth"_>(event), opts.event_idx)
+		room_type_key(buf, at<"room_id"_>(event), room_idx, at<"type"_>(event), at<"depth"_>(event), opts.event_idx)
 	};
 
 	db::txn::append
@@ -307,16 +320,27 @@ ircd::m::dbs::room_type_key(const string_view &amalgam_)
 	};
 }
 
+ircd::string_view
+ircd::m::dbs::room_type_key(const mutable_buffer &out,
+                            const id::room &room_id,
+                            const string_view &type,
+                            const uint64_t &depth,
+                            const event::idx &event_idx)
+{
+	return room_type_key(out, room_id, room_idx_get(room_id), type, depth, event_idx);
+}
+
 ircd::string_view
 ircd::m::dbs::room_type_key(const mutable_buffer &out_,
                             const id::room &room_id,
+                            const event::idx &room_idx,
                             const string_view &type,
                             const uint64_t &depth,
                             const event::idx &event_idx)
 {
 	assert(room_id);
 	mutable_buffer out{out_};
-	consume(out, copy(out, room_id));
+	consume(out, size(room_key(out, room_id, room_idx)));
 
 	if(!type)
 		return { data(out_), data(out) };
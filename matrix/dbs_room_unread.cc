@@ -0,0 +1,370 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static bool room_unread_reset(room_unread_vector &, const event &);
+	static std::string room_unread__merge_add(const string_view &, const db::merge_delta &);
+}
+
+decltype(ircd::m::dbs::room_unread)
+ircd::m::dbs::room_unread;
+
+decltype(ircd::m::dbs::desc::room_unread__comp)
+ircd::m::dbs::desc::room_unread__comp
+{
+	{ "name",     "ircd.m.dbs._room_unread.comp" },
+	{ "default",  "default"                      },
+};
+
+decltype(ircd::m::dbs::desc::room_unread__block__size)
+ircd::m::dbs::desc::room_unread__block__size
+{
+	{ "name",     "ircd.m.dbs._room_unread.block.size" },
+	{ "default",  512L                                 },
+};
+
+decltype(ircd::m::dbs::desc::room_unread__meta_block__size)
+ircd::m::dbs::desc::room_unread__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._room_unread.meta_block.size" },
+	{ "default",  1024L                                     },
+};
+
+decltype(ircd::m::dbs::desc::room_unread__cache__size)
+ircd::m::dbs::desc::room_unread__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_unread.cache.size" },
+		{ "default",  long(8_MiB)                          },
+	}, []
+	{
+		const size_t &value{room_unread__cache__size};
+		db::capacity(db::cache(dbs::room_unread), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::room_unread__cache_comp__size)
+ircd::m::dbs::desc::room_unread__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._room_unread.cache_comp.size" },
+		{ "default",  long(0_MiB)                               },
+	}, []
+	{
+		const size_t &value{room_unread__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::room_unread), value);
+	}
+};
+
+/// Counter vectors are merged by element-wise addition unless the update
+/// carries the reset slot, which then replaces the existing value.
+decltype(ircd::m::dbs::desc::room_unread__merge)
+ircd::m::dbs::desc::room_unread__merge
+{
+	room_unread__merge_add
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::room_unread
+{
+	// name
+	"_room_unread",
+
+	// explanation
+	R"(Unread notification counters for a user in a room.
+
+	user_room_id | room_id => int64_t[room_unread_slot]
+
+	Maintained from the user's room: each push notification (ircd.push.note)
+	merges an increment; each present read receipt (ircd.read) merges a reset
+	to the notifications remaining after the receipted event.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(room_unread__block__size),
+
+	// meta_block size
+	size_t(room_unread__meta_block__size),
+
+	// compression
+	string_view{room_unread__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 21,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	true,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+
+	// merger
+	room_unread__merge,
+};
+
+//
+// indexer
+//
+
+// NOTE: QUERY
+void
+ircd::m::dbs::_index_room_unread(db::txn &txn,
+                                 const event &event,
+                                 const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_UNREAD));
+
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	room_unread_vector delta {0};
+	string_view room_id;
+	if(startswith(type, user::notifications::type_prefix))
+	{
+		const auto note
+		{
+			user::notifications::unmake_type(type)
+		};
+
+		const int64_t sign
+		{
+			opts.op == db::op::SET?  1L:
+			opts.op == db::op::DELETE? -1L:
+			0L
+		};
+
+		if(!sign || !note.room_id)
+			return;
+
+		room_id = note.room_id;
+		delta[ROOM_UNREAD_NOTIFICATIONS] = sign;
+		delta[ROOM_UNREAD_HIGHLIGHTS] = note.only == "highlight"? sign: 0L;
+	}
+	else if(type == "ircd.read")
+	{
+		const bool reset
+		{
+			opts.op == db::op::SET
+			&& opts.appendix.test(appendix::ROOM_STATE)
+			&& opts.allow_queries
+			&& valid(id::ROOM, json::get<"state_key"_>(event))
+		};
+
+		if(!reset || !room_unread_reset(delta, event))
+			return;
+
+		room_id = at<"state_key"_>(event);
+	}
+	else return;
+
+	char buf[ROOM_UNREAD_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		room_unread_key(buf, at<"room_id"_>(event), room_id)
+	};
+
+	const string_view val
+	{
+		reinterpret_cast<const char *>(delta.data()), sizeof(delta)
+	};
+
+	db::txn::append
+	{
+		txn, room_unread,
+		{
+			db::op::MERGE,
+			key,
+			val,
+		}
+	};
+}
+
+/// Counts the notifications for events after the one receipted. Notes no
+/// older than the receipt's target are considered; each note's content
+/// carries the index of the event it notified for.
+bool
+ircd::m::dbs::room_unread_reset(room_unread_vector &delta,
+                                const event &event)
+{
+	const json::string &event_id
+	{
+		json::get<"content"_>(event).get("event_id")
+	};
+
+	const auto read_idx
+	{
+		valid(id::EVENT, event_id)?
+			m::index(std::nothrow, event::id(event_id)):
+			0UL
+	};
+
+	delta[ROOM_UNREAD_RESET] = 1;
+	if(!read_idx)
+		return true;
+
+	const m::user user
+	{
+		at<"sender"_>(event)
+	};
+
+	const m::user::notifications notifications
+	{
+		user
+	};
+
+	const auto count{[&notifications, &read_idx]
+	(user::notifications::opts opts)
+	{
+		int64_t ret(0);
+		opts.to = read_idx;
+		notifications.for_each(opts, [&read_idx, &ret]
+		(const event::idx &, const json::object &content)
+		{
+			ret += content.get<event::idx>("event_idx", 0UL) > read_idx;
+			return true;
+		});
+
+		return ret;
+	}};
+
+	user::notifications::opts opts;
+	opts.room_id = at<"state_key"_>(event);
+	delta[ROOM_UNREAD_NOTIFICATIONS] = count(opts);
+
+	opts.only = "highlight";
+	delta[ROOM_UNREAD_HIGHLIGHTS] = count(opts);
+	delta[ROOM_UNREAD_NOTIFICATIONS] += delta[ROOM_UNREAD_HIGHLIGHTS];
+	return true;
+}
+
+//
+// interface
+//
+
+bool
+ircd::m::dbs::room_unread_get(room_unread_vector &ret,
+                              const id::room &user_room,
+                              const id::room &room_id)
+{
+	char buf[ROOM_UNREAD_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		room_unread_key(buf, user_room, room_id)
+	};
+
+	ret.fill(0);
+	return room_unread(key, std::nothrow, [&ret]
+	(const string_view &val)
+	{
+		memcpy(ret.data(), data(val), std::min(size(val), sizeof(ret)));
+	});
+}
+
+ircd::string_view
+ircd::m::dbs::room_unread_key(const mutable_buffer &out_,
+                              const id::room &user_room,
+                              const id::room &room_id)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, user_room));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, room_id));
+	return { data(out_), data(out) };
+}
+
+std::string
+ircd::m::dbs::room_unread__merge_add(const string_view &key,
+                                     const db::merge_delta &delta)
+{
+	const auto &[exist, update]
+	{
+		delta
+	};
+
+	room_unread_vector a {0}, b {0};
+	memcpy(a.data(), data(exist), std::min(size(exist), sizeof(a)));
+	memcpy(b.data(), data(update), std::min(size(update), sizeof(b)));
+	if(!b[ROOM_UNREAD_RESET])
+		for(size_t i(ROOM_UNREAD_NOTIFICATIONS); i < a.size(); ++i)
+			a[i] += b[i];
+	else
+		a = b;
+
+	return std::string
+	{
+		reinterpret_cast<const char *>(a.data()), sizeof(a)
+	};
+}
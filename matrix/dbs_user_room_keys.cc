@@ -0,0 +1,357 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::dbs
+{
+	static string_view user_room_keys_prefix(const mutable_buffer &, const id::user &, const event::idx &);
+}
+
+decltype(ircd::m::dbs::user_room_keys)
+ircd::m::dbs::user_room_keys;
+
+decltype(ircd::m::dbs::desc::user_room_keys__comp)
+ircd::m::dbs::desc::user_room_keys__comp
+{
+	{ "name",     "ircd.m.dbs._user_room_keys.comp" },
+	{ "default",  "default"                         },
+};
+
+decltype(ircd::m::dbs::desc::user_room_keys__block__size)
+ircd::m::dbs::desc::user_room_keys__block__size
+{
+	{ "name",     "ircd.m.dbs._user_room_keys.block.size" },
+	{ "default",  512L                                    },
+};
+
+decltype(ircd::m::dbs::desc::user_room_keys__meta_block__size)
+ircd::m::dbs::desc::user_room_keys__meta_block__size
+{
+	{ "name",     "ircd.m.dbs._user_room_keys.meta_block.size" },
+	{ "default",  1024L                                        },
+};
+
+decltype(ircd::m::dbs::desc::user_room_keys__cache__size)
+ircd::m::dbs::desc::user_room_keys__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_room_keys.cache.size" },
+		{ "default",  long(4_MiB)                             },
+	}, []
+	{
+		const size_t &value{user_room_keys__cache__size};
+		db::capacity(db::cache(dbs::user_room_keys), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::user_room_keys__cache_comp__size)
+ircd::m::dbs::desc::user_room_keys__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs._user_room_keys.cache_comp.size" },
+		{ "default",  long(0_MiB)                                  },
+	}, []
+	{
+		const size_t &value{user_room_keys__cache_comp__size};
+		db::capacity(db::cache_compressed(dbs::user_room_keys), value);
+	}
+};
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::user_room_keys
+{
+	// name
+	"_user_room_keys",
+
+	// explanation
+	R"(Room key backups of each user.
+
+	user_id | version, room_id, session_id => session
+
+	The session keys a client backs up for each of its rooms (see room_keys
+	in the client API), under the event_idx of the backup version they were
+	uploaded for. An upload of tens of thousands of sessions is written in a
+	few transactions and a whole backup is streamed out with one seek; the
+	keys of a version, a room or a session are deleted by one range.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(user_room_keys__block__size),
+
+	// meta_block size
+	size_t(user_room_keys__meta_block__size),
+
+	// compression
+	string_view{user_room_keys__comp},
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target_file_size
+	{},
+
+	// max_bytes_for_level
+	{
+		{  32_MiB,   1L }, // max_bytes_for_level_base
+		{      0L,   0L }, // max_bytes_for_level[0]
+		{      0L,   1L }, // max_bytes_for_level[1]
+		{      0L,   1L }, // max_bytes_for_level[2]
+		{      0L,   3L }, // max_bytes_for_level[3]
+		{      0L,   7L }, // max_bytes_for_level[4]
+		{      0L,  15L }, // max_bytes_for_level[5]
+		{      0L,  31L }, // max_bytes_for_level[6]
+	},
+
+	// compaction_period
+	60s * 60 * 24 * 7,
+
+	// write_buffer_blocks
+	8192,
+
+	// tier
+	{},
+
+	// compression_dict
+	{},
+
+	// meta_block_partition
+	false,
+
+	// meta_block_pin
+	false,
+
+	// bloom_ribbon
+	false,
+};
+
+//
+// interface
+//
+
+/// Appends the session to the txn; the txn is committed by the caller, who
+/// appends many sessions to it.
+bool
+ircd::m::dbs::user_room_keys_put(db::txn &txn,
+                                 const id::user &user_id,
+                                 const event::idx &version,
+                                 const id::room &room_id,
+                                 const string_view &session_id,
+                                 const json::object &session)
+{
+	if(unlikely(empty(session_id) || size(session_id) > USER_ROOM_KEYS_SESSION_MAX_SIZE))
+		return false;
+
+	char buf[USER_ROOM_KEYS_KEY_MAX_SIZE];
+	db::txn::append
+	{
+		txn, user_room_keys,
+		{
+			db::op::SET,
+			user_room_keys_key(buf, user_id, version, room_id, session_id),
+			session,
+		}
+	};
+
+	return true;
+}
+
+/// Deletes the sessions of the version; only those of the room if one is
+/// given, and only the one session of that room if that is given too.
+void
+ircd::m::dbs::user_room_keys_del(const id::user &user_id,
+                                 const event::idx &version,
+                                 const id::room &room_id,
+                                 const string_view &session_id)
+{
+	char buf[2][USER_ROOM_KEYS_KEY_MAX_SIZE];
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	if(room_id && session_id)
+		db::txn::append
+		{
+			txn, user_room_keys,
+			{
+				db::op::DELETE,
+				user_room_keys_key(buf[0], user_id, version, room_id, session_id),
+			}
+		};
+	else
+	{
+		// The range of a room ends where its separator would be '\1'; the
+		// range of a version ends at the next version.
+		const string_view begin
+		{
+			room_id?
+				user_room_keys_key(buf[0], user_id, version, room_id):
+				user_room_keys_prefix(buf[0], user_id, version)
+		};
+
+		const string_view end
+		{
+			room_id?
+				user_room_keys_key(buf[1], user_id, version, room_id):
+				user_room_keys_prefix(buf[1], user_id, version + 1)
+		};
+
+		if(room_id)
+			buf[1][size(end) - 1] = '\1';
+
+		db::txn::append
+		{
+			txn, user_room_keys,
+			{
+				db::op::DELETE_RANGE, begin, end
+			}
+		};
+	}
+
+	txn();
+}
+
+bool
+ircd::m::dbs::user_room_keys_get(const id::user &user_id,
+                                 const event::idx &version,
+                                 const id::room &room_id,
+                                 const string_view &session_id,
+                                 const user_room_keys_session_closure &closure)
+{
+	char buf[USER_ROOM_KEYS_KEY_MAX_SIZE];
+	const string_view key
+	{
+		user_room_keys_key(buf, user_id, version, room_id, session_id)
+	};
+
+	return user_room_keys(key, std::nothrow, [&closure]
+	(const string_view &val)
+	{
+		closure(json::object{val});
+	});
+}
+
+/// Iterates the sessions of the version in order of room; only those of
+/// the room if one is given.
+bool
+ircd::m::dbs::user_room_keys_for_each(const id::user &user_id,
+                                      const event::idx &version,
+                                      const id::room &room_id,
+                                      const user_room_keys_closure &closure)
+{
+	char buf[USER_ROOM_KEYS_KEY_MAX_SIZE];
+	const string_view prefix
+	{
+		user_room_keys_key(buf, user_id, version, room_id)
+	};
+
+	const size_t version_prefix_size
+	{
+		size(string_view{user_id}) + 1 + sizeof(event::idx)
+	};
+
+	for(auto it(user_room_keys.lower_bound(prefix)); it; ++it)
+	{
+		const auto &[key, val]
+		{
+			*it
+		};
+
+		if(!startswith(key, prefix))
+			break;
+
+		const auto &[_room_id, _session_id]
+		{
+			split(key.substr(version_prefix_size), '\0')
+		};
+
+		if(!closure(id::room{_room_id}, _session_id, json::object{val}))
+			return false;
+	}
+
+	return true;
+}
+
+/// The version is big-endian so the sessions of a version are contiguous
+/// and its range ends at the next.
+ircd::string_view
+ircd::m::dbs::user_room_keys_key(const mutable_buffer &out_,
+                                 const id::user &user_id,
+                                 const event::idx &version,
+                                 const id::room &room_id,
+                                 const string_view &session_id)
+{
+	mutable_buffer out{out_};
+	consume(out, size(user_room_keys_prefix(out, user_id, version)));
+	if(room_id)
+	{
+		consume(out, copy(out, string_view{room_id}));
+		consume(out, copy(out, '\0'));
+		consume(out, copy(out, session_id));
+	}
+
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
+
+ircd::string_view
+ircd::m::dbs::user_room_keys_prefix(const mutable_buffer &out_,
+                                    const id::user &user_id,
+                                    const event::idx &version)
+{
+	const uint64_t version_be
+	{
+		hton(uint64_t(version))
+	};
+
+	mutable_buffer out{out_};
+	consume(out, copy(out, string_view{user_id}));
+	consume(out, copy(out, '\0'));
+	consume(out, copy(out, byte_view<string_view>(version_be)));
+	return string_view
+	{
+		data(out_), data(out)
+	};
+}
+
@@ -11,8 +11,20 @@
 namespace ircd::m
 {
 	static json::object make_hashes(const mutable_buffer &out, const sha256::buf &hash);
+	static bool preimage_excluded(const string_view &key) noexcept;
+	static sha256::buf hash_canonical(const json::object &event);
+
+	extern conf::item<bool> verify_offload;
 }
 
+decltype(ircd::m::verify_offload)
+ircd::m::verify_offload
+{
+	{ "name",     "ircd.m.verify.offload" },
+	{ "default",  true                    },
+	{ "help",     "Conduct event signature verification on an offload thread." },
+};
+
 /// The maximum size of an event we will create. This may also be used in
 /// some contexts for what we will accept, but the protocol limit and hard
 /// worst-case buffer size is still event::MAX_SIZE.
@@ -189,6 +201,10 @@ ircd::m::make_hashes(const mutable_buffer &out,
 ircd::sha256::buf
 ircd::m::event::hash(const json::object &event_)
 {
+	// Input already in canonical form hashes directly from its own bytes.
+	if(json::canonical(event_))
+		return hash_canonical(event_);
+
 	const json::object preimage
 	{
 		event::preimage(buf[3], event_)
@@ -200,6 +216,38 @@ ircd::m::event::hash(const json::object &event_)
 	};
 }
 
+/// The preimage of canonical input is the input itself with the excluded
+/// members cut out; rather than composing it into a buffer, the spans
+/// between those members are fed to the hash directly. The result is
+/// identical to hashing the output of event::preimage().
+ircd::sha256::buf
+ircd::m::hash_canonical(const json::object &event)
+{
+	assert(json::canonical(event));
+
+	sha256 hash;
+	bool first(true);
+	for(const auto &[key, val] : event)
+	{
+		if(preimage_excluded(key))
+			continue;
+
+		// The member's span from the key's opening quote through the end of
+		// the value; canonical input has nothing between them but ':'.
+		const string_view member
+		{
+			key.data() - 1, val.data() + val.size()
+		};
+
+		hash.update(first? "{"_sv: ","_sv);
+		hash.update(member);
+		first = false;
+	}
+
+	hash.update(first? "{}"_sv: "}"_sv);
+	return hash;
+}
+
 ircd::sha256::buf
 ircd::m::event::hash(json::iov &event,
                      const string_view &content)
@@ -546,14 +594,19 @@ try
 		origin
 	};
 
-	bool ret{false};
-	node_keys.get(keyid, [&ret, &event, &origin, &keyid]
-	(const ed25519::pk &pk)
+	// Copy the key out of the database closure; the verification may
+	// yield this context.
+	ed25519::pk pk;
+	const bool found
 	{
-		ret = verify(event, pk, origin, keyid);
-	});
+		node_keys.get(keyid, [&pk]
+		(const ed25519::pk &pk_)
+		{
+			pk = pk_;
+		})
+	};
 
-	return ret;
+	return found && verify(event, pk, origin, keyid);
 }
 catch(const ctx::interrupted &e)
 {
@@ -613,17 +666,37 @@ ircd::m::verify(const event &event_,
                 const ed25519::pk &pk,
                 const ed25519::sig &sig)
 {
-	m::event event
+	bool ret{false};
+	const auto closure{[&event_, &pk, &sig, &ret]
 	{
-		essential(event_, event::buf[3])
-	};
+		// event::buf is thread_local so the worker has its own buffers.
+		m::event event
+		{
+			essential(event_, event::buf[3])
+		};
+
+		const json::object &preimage
+		{
+			stringify(event::buf[2], event)
+		};
+
+		ret = pk.verify(preimage, sig);
+	}};
 
-	const json::object &preimage
+	// Offload is only possible from a context on the main thread; the
+	// event and key are kept alive on this stack for the duration.
+	if(verify_offload && ctx::current)
 	{
-		stringify(event::buf[2], event)
-	};
+		static const ctx::ole::opts opts
+		{
+			"m.verify"
+		};
 
-	return pk.verify(preimage, sig);
+		ctx::offload(opts, closure);
+	}
+	else closure();
+
+	return ret;
 }
 
 bool
@@ -929,17 +1002,8 @@ try
 
 	size_t i(0);
 	for(const auto &m : event)
-	{
-		if(m.first == "signatures" ||
-		   m.first == "hashes" ||
-		   m.first == "unsigned" ||
-		   m.first == "age_ts" ||
-		   m.first == "outlier" ||
-		   m.first == "destinations")
-			continue;
-
-		member.at(i++) = m;
-	}
+		if(!preimage_excluded(m.first))
+			member.at(i++) = m;
 
 	mutable_buffer buf{buf_};
 	const string_view ret
@@ -958,6 +1022,20 @@ catch(const std::out_of_range &e)
 	};
 }
 
+bool
+ircd::m::preimage_excluded(const string_view &key)
+noexcept
+{
+	return false
+	|| key == "signatures"
+	|| key == "hashes"
+	|| key == "unsigned"
+	|| key == "age_ts"
+	|| key == "outlier"
+	|| key == "destinations"
+	;
+}
+
 bool
 ircd::m::before(const event &a,
                 const event &b)
@@ -1096,7 +1174,29 @@ ircd::m::exists(const id::event &event_id)
 		dbs::event_idx
 	};
 
-	return bool(event_id) && has(column, event_id);
+	if(unlikely(!event_id))
+		return false;
+
+	if(dbs::event_idx_absent::test(event_id))
+		return false;
+
+	// The generation is sampled before the query which may yield; a miss is
+	// not recorded if event_idx was written meanwhile or if the event is
+	// being evaluated and may be written shortly.
+	const auto generation
+	{
+		dbs::event_idx_absent::generation
+	};
+
+	const bool ret
+	{
+		has(column, event_id)
+	};
+
+	if(!ret && !vm::eval::count(event_id))
+		dbs::event_idx_absent::set(event_id, generation);
+
+	return ret;
 }
 
 bool
@@ -10,9 +10,24 @@
 
 namespace ircd::m
 {
+	using event_append_cache_key = std::pair<event::idx, bool>;
+	using event_append_cache_val = std::shared_ptr<const std::string>;
+
+	using event_append_relations_vector = std::vector<std::tuple<std::string, std::string, dbs::event_relates_value>>;
+
+	static void event_append_members(json::stack::object &, const event &, const event::append::opts &);
+	static void event_append_thread(json::stack::object &, const event &, const event::append::opts &, event_append_relations_vector::const_iterator &, const event_append_relations_vector::const_iterator &);
+	static void event_append_relations(json::stack::object &, const event &, const event::append::opts &);
+	static event_append_cache_val event_append_cached(const event &, const event::append::opts &);
+
 	extern const event::keys::exclude event_append_exclude_keys;
 	extern const event::keys event_append_default_keys;
 	extern conf::item<bool> event_append_info;
+	extern conf::item<size_t> event_append_cache_max;
+	extern conf::item<bool> event_append_relations_enable;
+	extern stats::item<uint64_t> event_append_cache_hits;
+	extern stats::item<uint64_t> event_append_cache_misses;
+	extern std::map<event_append_cache_key, event_append_cache_val> event_append_cache;
 	extern log::log event_append_log;
 }
 
@@ -30,6 +45,44 @@ ircd::m::event_append_info
 	{ "persist",  false                      },
 };
 
+decltype(ircd::m::event_append_cache_max)
+ircd::m::event_append_cache_max
+{
+	{ "name",     "ircd.m.event.append.cache.max" },
+	{ "default",  1024L                           },
+	{ "help",     "Number of recent event serializations shared by appends." },
+};
+
+decltype(ircd::m::event_append_relations_enable)
+ircd::m::event_append_relations_enable
+{
+	{ "name",     "ircd.m.event.append.relations" },
+	{ "default",  true                            },
+	{ "help",     "Bundle the aggregations of relations to an event in unsigned." },
+};
+
+decltype(ircd::m::event_append_cache_hits)
+ircd::m::event_append_cache_hits
+{
+	{ "name", "ircd.m.event.append.cache.hits" },
+};
+
+decltype(ircd::m::event_append_cache_misses)
+ircd::m::event_append_cache_misses
+{
+	{ "name", "ircd.m.event.append.cache.misses" },
+};
+
+/// Serializations of the members of recent events which are the same for
+/// every client. When one event is fanned out to many clients the bytes are
+/// composed once here and copied verbatim into each response; anything
+/// specific to the user (unsigned, txnid, etc) is still composed per append.
+/// Entries are refcounted so an append which yields while flushing keeps its
+/// entry alive even if evicted. Only linear and longpoll sync opt in, so the
+/// entries are the newest events and the lowest event_idx is evicted first.
+decltype(ircd::m::event_append_cache)
+ircd::m::event_append_cache;
+
 /// Default event property mask of keys which we strip from the event sent
 /// to the client. This mask is applied only if the caller of event::append{}
 /// did not supply their mask to apply. It is also inferior to the user's
@@ -104,6 +157,9 @@ ircd::m::event::append::append(json::stack::object &object,
 	if(opts.event_filter && !m::match(*opts.event_filter, event))
 		return false;
 
+	if(opts.compiled_filter && !m::match(*opts.compiled_filter, event))
+		return false;
+
 	if(opts.query_visible && opts.user_id && !visible(event, *opts.user_id))
 	{
 		log::debug
@@ -204,66 +260,21 @@ ircd::m::event::append::append(json::stack::object &object,
 		};
 	#endif
 
-	if(!json::get<"event_id"_>(event))
-		json::stack::member
-		{
-			object, "event_id", event.event_id
-		};
-
-	const bool query_prev_state
+	const bool use_cache
 	{
-		has_event_idx && opts.query_prev_state && is_state
+		has_event_idx && opts.cache && !opts.keys && event_append_cache_max
 	};
 
-	if(query_prev_state)
+	if(use_cache)
 	{
-		const auto prev_idx
+		const auto cached
 		{
-			room::state::prev(*opts.event_idx)
+			event_append_cached(event, opts)
 		};
 
-		m::get(std::nothrow, prev_idx, "content", [&object]
-		(const json::object &content)
-		{
-			json::stack::member
-			{
-				object, "prev_content", content
-			};
-		});
+		object.splice(json::object{*cached});
 	}
-
-	// Get the list of properties to send to the client so we can strip
-	// the remaining and save b/w
-	// TODO: m::filter
-	const event::keys &keys
-	{
-		opts.keys?
-			*opts.keys:
-			event_append_default_keys
-	};
-
-	// Append the event members
-	for_each(event, [&keys, &object]
-	(const auto &key, const auto &val_)
-	{
-		if(!keys.has(key) && key != "redacts"_sv)
-			return true;
-
-		const json::value val
-		{
-			val_
-		};
-
-		if(!defined(val))
-			return true;
-
-		json::stack::member
-		{
-			object, key, val
-		};
-
-		return true;
-	});
+	else event_append_members(object, event, opts);
 
 	json::stack::object unsigned_
 	{
@@ -315,6 +326,9 @@ ircd::m::event::append::append(json::stack::object &object,
 			};
 		});
 
+	if(has_event_idx && opts.query_relations && event_append_relations_enable)
+		event_append_relations(unsigned_, event, opts);
+
 	if(unlikely(event_append_info))
 		log::info
 		{
@@ -335,3 +349,329 @@ ircd::m::event::append::append(json::stack::object &object,
 }}
 {
 }
+
+/// Bundles the aggregations of the relations to the event from
+/// dbs::event_relates; one query which finds nothing for most events.
+void
+ircd::m::event_append_relations(json::stack::object &unsigned_,
+                                const event &event,
+                                const event::append::opts &opts)
+{
+	assert(opts.event_idx);
+	event_append_relations_vector aggs;
+	dbs::event_relates_for_each(*opts.event_idx, [&aggs]
+	(const string_view &rel_type, const string_view &key, const dbs::event_relates_value &value)
+	{
+		aggs.emplace_back(rel_type, key, value);
+		return true;
+	});
+
+	if(aggs.empty())
+		return;
+
+	// Annotations with the most are listed first.
+	std::sort(begin(aggs), end(aggs), [](const auto &a, const auto &b)
+	{
+		return std::get<0>(a) != std::get<0>(b)?
+			std::get<0>(a) < std::get<0>(b):
+			std::get<2>(a).count > std::get<2>(b).count;
+	});
+
+	json::stack::object relations
+	{
+		unsigned_, "m.relations"
+	};
+
+	auto it(begin(aggs));
+	while(it != end(aggs))
+	{
+		const string_view rel_type
+		{
+			std::get<0>(*it)
+		};
+
+		json::stack::object object
+		{
+			relations, rel_type
+		};
+
+		if(rel_type == "m.annotation")
+		{
+			json::stack::array chunk
+			{
+				object, "chunk"
+			};
+
+			for(; it != end(aggs) && std::get<0>(*it) == rel_type; ++it)
+			{
+				json::stack::object annotation
+				{
+					chunk
+				};
+
+				json::stack::member
+				{
+					annotation, "type", json::value{"m.reaction"}
+				};
+
+				json::stack::member
+				{
+					annotation, "key", json::value{std::get<1>(*it)}
+				};
+
+				json::stack::member
+				{
+					annotation, "count", json::value{std::get<2>(*it).count}
+				};
+			}
+
+			continue;
+		}
+
+		if(rel_type == "m.thread")
+		{
+			event_append_thread(object, event, opts, it, end(aggs));
+			continue;
+		}
+
+		const auto &value
+		{
+			std::get<2>(*it++)
+		};
+
+		const bool latest
+		{
+			value.latest && !m::redacted(value.latest)
+		};
+
+		if(rel_type == "m.replace" && latest)
+		{
+			m::event::id::buf event_id;
+			json::stack::member
+			{
+				object, "event_id", json::value
+				{
+					m::event_id(std::nothrow, value.latest, event_id)
+				}
+			};
+
+			continue;
+		}
+
+		json::stack::member
+		{
+			object, "count", json::value{value.count}
+		};
+	}
+}
+
+/// The thread is aggregated by the sender of each reply; the summary is the
+/// sum of these, and the user participated if among them or the root's.
+void
+ircd::m::event_append_thread(json::stack::object &object,
+                             const event &event,
+                             const event::append::opts &opts,
+                             event_append_relations_vector::const_iterator &it,
+                             const event_append_relations_vector::const_iterator &end)
+{
+	int64_t count {0};
+	event::idx latest {0};
+	bool participated
+	{
+		opts.user_id && json::get<"sender"_>(event) == *opts.user_id
+	};
+
+	for(; it != end && std::get<0>(*it) == "m.thread"; ++it)
+	{
+		const auto &[rel_type, sender, value]
+		{
+			*it
+		};
+
+		count += value.count;
+		latest = std::max(latest, value.latest);
+		participated |= opts.user_id && sender == *opts.user_id;
+	}
+
+	json::stack::member
+	{
+		object, "count", json::value{count}
+	};
+
+	json::stack::member
+	{
+		object, "current_user_participated", json::value{participated}
+	};
+
+	if(!latest || m::redacted(latest))
+		return;
+
+	const m::event::fetch latest_event
+	{
+		std::nothrow, latest
+	};
+
+	if(!latest_event.valid)
+		return;
+
+	json::stack::object latest_object
+	{
+		object, "latest_event"
+	};
+
+	auto latest_opts(opts);
+	latest_opts.event_idx = &latest_event.event_idx;
+	latest_opts.client_txnid = nullptr;
+	latest_opts.event_filter = nullptr;
+	latest_opts.compiled_filter = nullptr;
+	latest_opts.query_relations = false;
+	latest_opts.cache = false;
+	event::append
+	{
+		latest_object, latest_event, latest_opts
+	};
+}
+
+/// Appends the members of the event which do not vary by user.
+void
+ircd::m::event_append_members(json::stack::object &object,
+                              const event &event,
+                              const event::append::opts &opts)
+{
+	const bool has_event_idx
+	{
+		opts.event_idx && *opts.event_idx
+	};
+
+	const bool is_state
+	{
+		defined(json::get<"state_key"_>(event))
+	};
+
+	if(!json::get<"event_id"_>(event))
+		json::stack::member
+		{
+			object, "event_id", event.event_id
+		};
+
+	const bool query_prev_state
+	{
+		has_event_idx && opts.query_prev_state && is_state
+	};
+
+	if(query_prev_state)
+	{
+		const auto prev_idx
+		{
+			room::state::prev(*opts.event_idx)
+		};
+
+		m::get(std::nothrow, prev_idx, "content", [&object]
+		(const json::object &content)
+		{
+			json::stack::member
+			{
+				object, "prev_content", content
+			};
+		});
+	}
+
+	// Get the list of properties to send to the client so we can strip
+	// the remaining and save b/w
+	// TODO: m::filter
+	const event::keys &keys
+	{
+		opts.keys?
+			*opts.keys:
+			event_append_default_keys
+	};
+
+	// Append the event members
+	for_each(event, [&keys, &object]
+	(const auto &key, const auto &val_)
+	{
+		if(!keys.has(key) && key != "redacts"_sv)
+			return true;
+
+		const json::value val
+		{
+			val_
+		};
+
+		if(!defined(val))
+			return true;
+
+		json::stack::member
+		{
+			object, key, val
+		};
+
+		return true;
+	});
+}
+
+ircd::m::event_append_cache_val
+ircd::m::event_append_cached(const event &event,
+                             const event::append::opts &opts)
+{
+	assert(opts.event_idx && *opts.event_idx);
+	const event_append_cache_key key
+	{
+		*opts.event_idx, opts.query_prev_state
+	};
+
+	auto it
+	{
+		event_append_cache.find(key)
+	};
+
+	if(it != end(event_append_cache))
+	{
+		++event_append_cache_hits;
+		return it->second;
+	}
+
+	++event_append_cache_misses;
+
+	// The members are a subset of the event plus its event_id; only a state
+	// event's prev_content is unbounded by the event itself, so only then is
+	// the worst case allocated and shrunk afterward.
+	const bool prev_state
+	{
+		opts.query_prev_state && defined(json::get<"state_key"_>(event))
+	};
+
+	const size_t buf_size
+	{
+		prev_state?
+			(event::MAX_SIZE * 2) | SHRINK_TO_FIT:
+			json::serialized(event) + event::id::MAX_SIZE + 32
+	};
+
+	auto val
+	{
+		std::make_shared<const std::string>(ircd::string(buf_size, [&event, &opts]
+		(const mutable_buffer &buf)
+		{
+			json::stack out{buf};
+			{
+				json::stack::object object{out};
+				event_append_members(object, event, opts);
+			}
+
+			return out.completed();
+		}))
+	};
+
+	// Entry may have been created by another context while this one
+	// yielded for prev_content.
+	const auto &[pit, inserted]
+	{
+		event_append_cache.try_emplace(key, std::move(val))
+	};
+
+	while(event_append_cache.size() > size_t(event_append_cache_max) && begin(event_append_cache) != pit)
+		event_append_cache.erase(begin(event_append_cache));
+
+	return pit->second;
+}
@@ -32,15 +32,17 @@ ircd::m::vm::conform_check_event_id
 		// Conditions for when we don't care if the event_id conforms. This
 		// hook only cares if the event_id is sufficient for the version, and
 		// we don't care about the early matrix versions with mxids here.
+		const auto format
+		{
+			event::conforms::format(eval.room_version)
+		};
+
 		const bool unaffected
 		{
-			!eval.room_version
-			|| eval.room_version == "0"
-			|| eval.room_version == "1"
-			|| eval.room_version == "2"
+			format <= 1
 		};
 
-		if(eval.room_version == "3")
+		if(format == 3)
 			if(!event::id::v3::is(event.event_id))
 				throw error
 				{
@@ -49,7 +51,7 @@ ircd::m::vm::conform_check_event_id
 				};
 
 		// note: we check v4 format for all other room versions, including "4"
-		if(!unaffected && eval.room_version != "3")
+		if(!unaffected && format != 3)
 			if(!event::id::v4::is(event.event_id))
 				throw error
 				{
@@ -138,10 +140,24 @@ ircd::m::vm::conform_report
 		if(eval.room_internal)
 			non_conform.set(event::conforms::MISMATCH_ORIGIN_SENDER);
 
+		// The format family of the room's events is selected once here for
+		// both the pass/fail check and any report.
+		const auto format
+		{
+			event::conforms::format(eval.room_version)
+		};
+
+		// Most events pass; the report is then clean without being generated.
+		if(likely(event::conforms::check(event, non_conform.report, format)))
+		{
+			eval.report = {};
+			return;
+		}
+
 		// Generate the report here.
 		eval.report = event::conforms
 		{
-			event, non_conform.report
+			event, non_conform.report, format
 		};
 
 		// When opts.conforming is false a bad report is not an error.
@@ -193,6 +209,9 @@ ircd::m::vm::conform_report
 
 namespace ircd::m
 {
+	template<uint format, bool fast> static uint64_t event_conforms(const event &, const uint64_t &skip);
+	template<bool fast> static uint64_t event_conforms(const event &, const uint64_t &skip, const uint &format);
+
 	constexpr size_t event_conforms_num{num_of<event::conforms::code>()};
 	extern const std::array<string_view, event_conforms_num> event_conforms_reflects;
 }
@@ -230,6 +249,7 @@ ircd::m::event_conforms_reflects
 	"MISMATCH_EVENT_ID",
 	"MISSING_HASHES",
 	"MISMATCH_HASHES",
+	"INVALID_UTF8",
 };
 
 std::ostream &
@@ -268,115 +288,219 @@ ircd::m::event::conforms::reflect(const string_view &name)
 	return code(std::distance(begin(event_conforms_reflects), it));
 }
 
+ircd::m::event::conforms::conforms(const event &e)
+:conforms{e, 0UL}
+{
+}
+
 ircd::m::event::conforms::conforms(const event &e,
                                    const uint64_t &skip)
-:conforms{e}
+:conforms{e, skip, 0U}
 {
-	report &= ~skip;
 }
 
-ircd::m::event::conforms::conforms(const event &e)
+/// The reference hash and content hash are not computed when their codes
+/// are skipped; a caller which has already computed them sets the result.
+/// The event format family is given by format(room_version); zero selects
+/// it from the event_id.
+ircd::m::event::conforms::conforms(const event &e,
+                                   const uint64_t &skip,
+                                   const uint &format)
 try
-:report{0}
+:report
+{
+	event_conforms<false>(e, skip, format) & ~skip
+}
 {
+}
+catch(const std::exception &_e)
+{
+	log::error
+	{
+		log, "Unable to complete conformity check :%s",
+		_e.what(),
+	};
+
+	throw;
+}
+
+/// Pass/fail conformity; stops at the first check which fails and isn't
+/// skipped. The result is the same as clean() of the full report, which is
+/// then only worth generating after this fails.
+bool
+ircd::m::event::conforms::check(const event &e,
+                                const uint64_t &skip,
+                                const uint &format)
+{
+	return !(event_conforms<true>(e, skip, format) & ~skip);
+}
+
+uint
+ircd::m::event::conforms::format(const string_view &room_version)
+noexcept
+{
+	return
+		!room_version?
+			0U:
+		room_version == "0" || room_version == "1" || room_version == "2"?
+			1U:
+		room_version == "3"?
+			3U:
+			4U;
+}
+
+template<bool fast>
+uint64_t
+ircd::m::event_conforms(const event &e,
+                        const uint64_t &skip,
+                        const uint &format_)
+{
+	const auto format
+	{
+		format_?: event::conforms::format(e.event_id? e.event_id.version(): string_view{})
+	};
+
+	switch(format)
+	{
+		case 1:   return event_conforms<1, fast>(e, skip);
+		case 3:   return event_conforms<3, fast>(e, skip);
+		default:  return event_conforms<4, fast>(e, skip);
+	}
+}
+
+/// The checks specialized for each event format family. The cheap checks of
+/// the fields come first; the reference hash, content hash and UTF-8 checks
+/// follow. In the fast mode each of those is only reached while the report
+/// is otherwise clean.
+template<uint format,
+         bool fast>
+uint64_t
+ircd::m::event_conforms(const event &e,
+                        const uint64_t &skip)
+{
+	using conforms = event::conforms;
+
+	uint64_t report(0);
+	const auto set{[&report](const conforms::code &code) noexcept
+	{
+		report |= (1UL << code);
+	}};
+
+	const auto has{[&report](const conforms::code &code) noexcept
+	{
+		return report & (1UL << code);
+	}};
+
+	const auto failed{[&report, &skip]() noexcept
+	{
+		return fast && (report & ~skip);
+	}};
+
+	const auto skipped{[&skip](const conforms::code &code) noexcept
+	{
+		return skip & (1UL << code);
+	}};
+
 	if(!e.event_id)
-		set(INVALID_OR_MISSING_EVENT_ID);
+		set(conforms::INVALID_OR_MISSING_EVENT_ID);
 
 	if(defined(json::get<"event_id"_>(e)))
 		if(!valid(m::id::EVENT, json::get<"event_id"_>(e)))
-			set(INVALID_OR_MISSING_EVENT_ID);
-
-	if(!has(INVALID_OR_MISSING_EVENT_ID))
-		if(!m::check_id(e))
-			set(MISMATCH_EVENT_ID);
+			set(conforms::INVALID_OR_MISSING_EVENT_ID);
 
 	if(empty(json::get<"hashes"_>(e)))
-		set(MISSING_HASHES);
-
-	if(!has(MISMATCH_HASHES) && !has(MISSING_HASHES))
-		if(!m::verify_hash(e))
-			set(MISMATCH_HASHES);
+		set(conforms::MISSING_HASHES);
 
 	if(!valid(m::id::ROOM, json::get<"room_id"_>(e)))
-		set(INVALID_OR_MISSING_ROOM_ID);
+		set(conforms::INVALID_OR_MISSING_ROOM_ID);
 
 	if(!valid(m::id::USER, json::get<"sender"_>(e)))
-		set(INVALID_OR_MISSING_SENDER_ID);
+		set(conforms::INVALID_OR_MISSING_SENDER_ID);
+
+	const auto &type
+	{
+		json::get<"type"_>(e)
+	};
 
-	if(empty(json::get<"type"_>(e)))
-		set(MISSING_TYPE);
+	if(empty(type))
+		set(conforms::MISSING_TYPE);
 
-	if(json::get<"type"_>(e).size() > event::TYPE_MAX_SIZE)
-		set(INVALID_TYPE);
+	if(type.size() > event::TYPE_MAX_SIZE)
+		set(conforms::INVALID_TYPE);
 
 	if(empty(json::get<"origin"_>(e)))
-		set(MISSING_ORIGIN);
+		set(conforms::MISSING_ORIGIN);
 
 	if(json::get<"origin"_>(e).size() > event::ORIGIN_MAX_SIZE)
-		set(INVALID_ORIGIN);
+		set(conforms::INVALID_ORIGIN);
 
 	if(!rfc3986::valid_remote(std::nothrow, json::get<"origin"_>(e)))
-		set(INVALID_ORIGIN);
+		set(conforms::INVALID_ORIGIN);
 
 	if(json::get<"state_key"_>(e).size() > event::STATE_KEY_MAX_SIZE)
-		set(INVALID_STATE_KEY);
+		set(conforms::INVALID_STATE_KEY);
 
 	if(empty(json::get<"signatures"_>(e)))
-		set(MISSING_SIGNATURES);
+		set(conforms::MISSING_SIGNATURES);
 
 	if(empty(json::object{json::get<"signatures"_>(e).get(json::get<"origin"_>(e))}))
-		set(MISSING_ORIGIN_SIGNATURE);
+		set(conforms::MISSING_ORIGIN_SIGNATURE);
 
-	if(!has(INVALID_OR_MISSING_SENDER_ID))
+	if(!has(conforms::INVALID_OR_MISSING_SENDER_ID))
 		if(json::get<"origin"_>(e) != m::id::user{json::get<"sender"_>(e)}.host())
-			set(MISMATCH_ORIGIN_SENDER);
+			set(conforms::MISMATCH_ORIGIN_SENDER);
 
-	if(json::get<"type"_>(e) == "m.room.create")
+	const bool is_create(type == "m.room.create");
+	if(is_create)
 		if(m::room::id(json::get<"room_id"_>(e)).host() != m::user::id(json::get<"sender"_>(e)).host())
-			set(MISMATCH_CREATE_SENDER);
+			set(conforms::MISMATCH_CREATE_SENDER);
 
-	if(json::get<"type"_>(e) == "m.room.aliases")
+	if(type == "m.room.aliases")
 		if(m::user::id(json::get<"sender"_>(e)).host() != json::get<"state_key"_>(e))
-			set(MISMATCH_ALIASES_STATE_KEY);
+			set(conforms::MISMATCH_ALIASES_STATE_KEY);
 
-	if(json::get<"type"_>(e) == "m.room.redaction")
+	if(type == "m.room.redaction")
 		if(!valid(m::id::EVENT, json::get<"redacts"_>(e)))
-			set(INVALID_OR_MISSING_REDACTS_ID);
+			set(conforms::INVALID_OR_MISSING_REDACTS_ID);
 
 	if(json::get<"redacts"_>(e))
 		if(json::get<"redacts"_>(e) == e.event_id)
-			set(SELF_REDACTS);
+			set(conforms::SELF_REDACTS);
+
+	if(type == "m.room.member")
+	{
+		const auto membership
+		{
+			unquote(json::get<"content"_>(e).get("membership"))
+		};
 
-	if(json::get<"type"_>(e) == "m.room.member")
-		if(empty(unquote(json::get<"content"_>(e).get("membership"))))
-			set(MISSING_CONTENT_MEMBERSHIP);
+		if(empty(membership))
+			set(conforms::MISSING_CONTENT_MEMBERSHIP);
 
-	if(json::get<"type"_>(e) == "m.room.member")
-		if(!all_of<std::islower>(unquote(json::get<"content"_>(e).get("membership"))))
-			set(INVALID_CONTENT_MEMBERSHIP);
+		if(!all_of<std::islower>(membership))
+			set(conforms::INVALID_CONTENT_MEMBERSHIP);
 
-	if(json::get<"type"_>(e) == "m.room.member")
 		if(empty(json::get<"state_key"_>(e)))
-			set(MISSING_MEMBER_STATE_KEY);
+			set(conforms::MISSING_MEMBER_STATE_KEY);
 
-	if(json::get<"type"_>(e) == "m.room.member")
 		if(!valid(m::id::USER, json::get<"state_key"_>(e)))
-			set(INVALID_MEMBER_STATE_KEY);
+			set(conforms::INVALID_MEMBER_STATE_KEY);
+	}
 
-	if(json::get<"type"_>(e) != "m.room.create")
+	if(!is_create)
+	{
 		if(empty(json::get<"prev_events"_>(e)))
-			set(MISSING_PREV_EVENTS);
+			set(conforms::MISSING_PREV_EVENTS);
 
-	if(json::get<"type"_>(e) != "m.room.create")
 		if(empty(json::get<"auth_events"_>(e)))
-			set(MISSING_AUTH_EVENTS);
-
-	if(json::get<"depth"_>(e) != json::undefined_number && json::get<"depth"_>(e) < 0)
-		set(DEPTH_NEGATIVE);
+			set(conforms::MISSING_AUTH_EVENTS);
 
-	if(json::get<"type"_>(e) != "m.room.create")
 		if(json::get<"depth"_>(e) == 0)
-			set(DEPTH_ZERO);
+			set(conforms::DEPTH_ZERO);
+	}
+
+	if(json::get<"depth"_>(e) != json::undefined_number && json::get<"depth"_>(e) < 0)
+		set(conforms::DEPTH_NEGATIVE);
 
 	const event::prev prev{e};
 	const event::auth auth{e};
@@ -384,48 +508,61 @@ try
 	{
 		for(size_t i(0); i < auth.auth_events_count(); ++i)
 			if(auth.auth_event(i) == json::get<"event_id"_>(e))
-				set(SELF_AUTH_EVENT);
+				set(conforms::SELF_AUTH_EVENT);
 
 		for(size_t i(0); i < prev.prev_events_count(); ++i)
 			if(prev.prev_event(i) == json::get<"event_id"_>(e))
-				set(SELF_PREV_EVENT);
+				set(conforms::SELF_PREV_EVENT);
 	}
 
 	for(size_t i(0); i < auth.auth_events_count(); ++i)
-	{
-		const auto &[event_id, ref_hash]
-		{
-			auth.auth_events(i)
-		};
-
-		for(size_t j(0); j < auth.auth_events_count(); ++j)
-			if(i != j)
-				if(event_id == auth.auth_event(j))
-					set(DUP_AUTH_EVENT);
-	}
+		for(size_t j(i + 1); j < auth.auth_events_count(); ++j)
+			if(auth.auth_event(i) == auth.auth_event(j))
+				set(conforms::DUP_AUTH_EVENT);
 
 	for(size_t i(0); i < prev.prev_events_count(); ++i)
-	{
-		const auto &[event_id, ref_hash]
-		{
-			prev.prev_events(i)
-		};
+		for(size_t j(i + 1); j < prev.prev_events_count(); ++j)
+			if(prev.prev_event(i) == prev.prev_event(j))
+				set(conforms::DUP_PREV_EVENT);
+
+	if(failed())
+		return report;
 
-		for(size_t j(0); j < prev.prev_events_count(); ++j)
-			if(i != j)
-				if(event_id == prev.prev_event(j))
-					set(DUP_PREV_EVENT);
+	// Versions 1 and 2 carry the event_id chosen by the origin; later
+	// versions derive it from the reference hash of the event.
+	if(!has(conforms::INVALID_OR_MISSING_EVENT_ID) && !skipped(conforms::MISMATCH_EVENT_ID)) try
+	{
+		char buf[64];
+		bool match;
+		if constexpr(format == 1)
+			match = e.event_id == json::get<"event_id"_>(e);
+		else if constexpr(format == 3)
+			match = e.event_id == event::id{event::id::v3{buf, e}};
+		else
+			match = e.event_id == event::id{event::id::v4{buf, e}};
+
+		if(!match)
+			set(conforms::MISMATCH_EVENT_ID);
 	}
-}
-catch(const std::exception &_e)
-{
-	log::error
+	catch(const std::exception &)
 	{
-		log, "Unable to complete conformity check :%s",
-		_e.what(),
-	};
+		set(conforms::MISMATCH_EVENT_ID);
+	}
 
-	throw;
+	if(failed())
+		return report;
+
+	if(!has(conforms::MISSING_HASHES) && !skipped(conforms::MISMATCH_HASHES))
+		if(!m::verify_hash(e))
+			set(conforms::MISMATCH_HASHES);
+
+	if(failed())
+		return report;
+
+	if(!utf8::valid(e.source? string_view{e.source}: string_view{json::get<"content"_>(e)}))
+		set(conforms::INVALID_UTF8);
+
+	return report;
 }
 
 void
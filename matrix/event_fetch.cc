@@ -8,6 +8,78 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using event_fetch_cache_entry = std::shared_ptr<const event::fetch::cache_entry>;
+	using event_fetch_cache_lru_t = std::list<std::pair<event::idx, event_fetch_cache_entry>>;
+
+	static event_fetch_cache_entry event_fetch_cache_find(const event::idx &);
+	static bool event_fetch_cache_admit(event::fetch &, const json::object &source);
+
+	extern conf::item<bool> event_fetch_cache_enable;
+	extern conf::item<size_t> event_fetch_cache_max;
+	extern conf::item<size_t> event_fetch_cache_event_max;
+	extern stats::item<uint64_t> event_fetch_cache_hits;
+	extern stats::item<uint64_t> event_fetch_cache_misses;
+	static uint64_t event_fetch_cache_generation;
+	static event_fetch_cache_lru_t event_fetch_cache_lru;
+	static std::map<event::idx, event_fetch_cache_lru_t::iterator> event_fetch_cache;
+}
+
+/// Parsed event held by the cache. The event refers into the source and
+/// event_id of the entry; a fetch assigned from the entry shares it, so an
+/// entry evicted or invalidated while in use remains until released.
+struct ircd::m::event::fetch::cache_entry
+{
+	std::string source;
+	event::id::buf event_id;
+	m::event event;
+	uint64_t generation {0};
+};
+
+decltype(ircd::m::event_fetch_cache_enable)
+ircd::m::event_fetch_cache_enable
+{
+	{ "name",     "ircd.m.event.fetch.cache.enable" },
+	{ "default",  true                              },
+	{ "description",
+
+	R"(
+	Keep recently fetched events parsed in memory by event_idx. Events fetched
+	with all keys (the JSON query) are served from the cache without reading
+	or parsing them again. Hot events such as the power levels, join rules and
+	members read by the auth checks are the primary beneficiaries.
+	)"},
+};
+
+decltype(ircd::m::event_fetch_cache_max)
+ircd::m::event_fetch_cache_max
+{
+	{ "name",     "ircd.m.event.fetch.cache.max" },
+	{ "default",  16384L                         },
+	{ "help",     "Number of parsed events kept by event_idx." },
+};
+
+decltype(ircd::m::event_fetch_cache_event_max)
+ircd::m::event_fetch_cache_event_max
+{
+	{ "name",     "ircd.m.event.fetch.cache.event.max" },
+	{ "default",  long(8_KiB)                          },
+	{ "help",     "Events with JSON larger than this are not cached." },
+};
+
+decltype(ircd::m::event_fetch_cache_hits)
+ircd::m::event_fetch_cache_hits
+{
+	{ "name", "ircd.m.event.fetch.cache.hits" },
+};
+
+decltype(ircd::m::event_fetch_cache_misses)
+ircd::m::event_fetch_cache_misses
+{
+	{ "name", "ircd.m.event.fetch.cache.misses" },
+};
+
 //
 // seek
 //
@@ -86,6 +158,13 @@ ircd::m::seek(std::nothrow_t,
 
 	assert(fetch.fopts);
 	const auto &opts(*fetch.fopts);
+	fetch._cached = fetch.should_cache(opts)?
+		event_fetch_cache_find(event_idx):
+		nullptr;
+
+	if(fetch._cached)
+		return fetch.valid = fetch.assign_from_cache();
+
 	if(!fetch.should_seek_json(opts))
 		if((fetch.valid = db::seek(fetch.row, key, opts.gopts)))
 			if((fetch.valid = fetch.assign_from_row(key)))
@@ -97,6 +176,270 @@ ircd::m::seek(std::nothrow_t,
 	return fetch.valid;
 }
 
+size_t
+ircd::m::seek(std::nothrow_t,
+              const vector_view<event::fetch> &fetch,
+              const vector_view<const event::idx> &event_idx)
+{
+	assert(fetch.size() >= event_idx.size());
+	const size_t num
+	{
+		std::min(fetch.size(), event_idx.size())
+	};
+
+	// Each query is one of the columns of an event, or its event_json. The
+	// position of the fetch (and the key selected, or -1 for json) is noted
+	// for each query so the results can be assigned after they've all been
+	// copied; the fetch buffer may be reallocated while it is being filled.
+	struct query
+	{
+		uint32_t pos;
+		int16_t key;
+		bool found;
+		uint32_t off, len;
+	};
+
+	std::vector<db::column> column;
+	std::vector<string_view> key;
+	std::vector<query> queries;
+	column.reserve(num);
+	key.reserve(num);
+	queries.reserve(num);
+	for(size_t i(0); i < num; ++i)
+	{
+		auto &f(fetch[i]);
+		f.event_idx = event_idx[i];
+		f.event_id_buf = {};
+		f.valid = false;
+		f._cached.reset();
+		f._buf.clear();
+		static_cast<m::event &>(f) = m::event{};
+		if(!f.event_idx)
+			continue;
+
+		assert(f.fopts);
+		const auto &opts(*f.fopts);
+		if(f.should_seek_json(opts))
+		{
+			column.emplace_back(dbs::event_json);
+			key.emplace_back(f.key(&f.event_idx));
+			queries.emplace_back(query{uint32_t(i), -1});
+			continue;
+		}
+
+		for(size_t j(0); j < opts.keys.size(); ++j)
+			if(opts.keys.test(j))
+			{
+				assert(dbs::event_column.at(j));
+				column.emplace_back(dbs::event_column.at(j));
+				key.emplace_back(f.key(&f.event_idx));
+				queries.emplace_back(query{uint32_t(i), int16_t(j)});
+			}
+	}
+
+	if(queries.empty())
+		return 0;
+
+	// All queries are made in as few rounds to the database as possible.
+	const auto &gopts(fetch[queries.front().pos].fopts->gopts);
+	db::read(column, key, [&fetch, &queries]
+	(const size_t &i, const string_view &val, const bool &found)
+	{
+		auto &q(queries.at(i));
+		auto &buf(fetch[q.pos]._buf);
+		q.found = found;
+		q.off = buf.size();
+		q.len = found? size(val) : 0;
+		buf.append(begin(val), begin(val) + q.len);
+	},
+	gopts);
+
+	// Assign the property values from the copies.
+	for(size_t i(0); i < queries.size(); ++i)
+	{
+		const auto &q(queries[i]);
+		auto &f(fetch[q.pos]);
+		auto &event(static_cast<m::event &>(f));
+		const string_view val
+		{
+			f._buf.data() + q.off, q.len
+		};
+
+		if(q.key < 0)
+		{
+			f.valid = q.found && !empty(val) && f.assign_from_source(val);
+			continue;
+		}
+
+		f.valid |= q.found;
+		const string_view name
+		{
+			json::key<m::event>(q.key)
+		};
+
+		const auto &descriptor
+		{
+			describe(dbs::event_column.at(q.key))
+		};
+
+		const bool is_string
+		{
+			descriptor.type.second == typeid(string_view)
+		};
+
+		if(q.found && is_string)
+			json::set(event, name, val);
+		else if(q.found)
+			json::set(event, name, byte_view<string_view>{val});
+		else if(is_string)
+			json::set(event, name, string_view{});
+		else
+			json::set(event, name, json::undefined_number);
+	}
+
+	size_t ret(0);
+	for(size_t i(0); i < num; ++i)
+	{
+		auto &f(fetch[i]);
+		auto &event(static_cast<m::event &>(f));
+		if(f.valid && !f.should_seek_json(*f.fopts))
+			event.event_id = !empty(json::get<"event_id"_>(event))?
+				event::id{json::get<"event_id"_>(event)}:
+				event::id{};
+
+		ret += f.valid;
+	}
+
+	return ret;
+}
+
+size_t
+ircd::m::seek(std::nothrow_t,
+              const vector_view<event> &event,
+              const vector_view<const event::idx> &event_idx,
+              std::string &buf)
+{
+	assert(event.size() >= event_idx.size());
+	const size_t num
+	{
+		std::min(event.size(), event_idx.size())
+	};
+
+	// The JSON of each event is copied to the buffer; the offsets are noted
+	// so the events can be assigned after all copies are made. Most events
+	// are smaller than 1 KiB.
+	struct query
+	{
+		uint32_t pos;
+		bool found;
+		uint32_t off, len;
+		uint32_t id_off, id_len;
+	};
+
+	std::vector<db::column> column;
+	std::vector<string_view> key;
+	std::vector<query> queries;
+	column.reserve(num);
+	key.reserve(num);
+	queries.reserve(num);
+	buf.clear();
+	buf.reserve(num * 1_KiB);
+	for(size_t i(0); i < num; ++i)
+	{
+		event[i] = m::event{};
+		if(!event_idx[i])
+			continue;
+
+		column.emplace_back(dbs::event_json);
+		key.emplace_back(byte_view<string_view>(event_idx[i]));
+		queries.emplace_back(query{uint32_t(i)});
+	}
+
+	if(queries.empty())
+		return 0;
+
+	db::read(column, key, [&buf, &queries]
+	(const size_t &i, const string_view &val, const bool &found)
+	{
+		auto &q(queries.at(i));
+		q.found = found && !empty(val);
+		q.off = buf.size();
+		q.len = q.found? size(val) : 0;
+		buf.append(begin(val), begin(val) + q.len);
+	});
+
+	// The event_id is not part of the JSON of later room versions; those are
+	// queried in a second round.
+	std::vector<size_t> missing;
+	for(size_t i(0); i < queries.size(); ++i)
+	{
+		const auto &q(queries[i]);
+		const json::object source
+		{
+			string_view{buf.data() + q.off, q.len}
+		};
+
+		if(q.found && !source.has("event_id"))
+			missing.emplace_back(i);
+	}
+
+	column.assign(missing.size(), dbs::event_column.at(json::indexof<m::event, "event_id"_>()));
+	key.clear();
+	for(const auto &i : missing)
+		key.emplace_back(byte_view<string_view>(event_idx[queries[i].pos]));
+
+	if(!missing.empty())
+		db::read(column, key, [&buf, &queries, &missing]
+		(const size_t &i, const string_view &val, const bool &found)
+		{
+			auto &q(queries.at(missing.at(i)));
+			q.id_off = buf.size();
+			q.id_len = found? size(val) : 0;
+			buf.append(begin(val), begin(val) + q.id_len);
+		});
+
+	size_t ret(0);
+	for(const auto &q : queries) try
+	{
+		if(!q.found)
+			continue;
+
+		const json::object source
+		{
+			string_view{buf.data() + q.off, q.len}
+		};
+
+		const event::id event_id
+		{
+			q.id_len?
+				event::id{string_view{buf.data() + q.id_off, q.id_len}}:
+				event::id{}
+		};
+
+		event[q.pos] = m::event
+		{
+			source, event_id
+		};
+
+		if(unlikely(!event[q.pos].event_id))
+			event[q.pos] = m::event{};
+
+		ret += bool(event[q.pos].event_id);
+	}
+	catch(const std::exception &e)
+	{
+		event[q.pos] = m::event{};
+		log::derror
+		{
+			m::log, "Bulk seek of event idx:%lu :%s",
+			event_idx[q.pos],
+			e.what(),
+		};
+	}
+
+	return ret;
+}
+
 //
 // event::fetch
 //
@@ -190,10 +533,16 @@ ircd::m::event::fetch::fetch(std::nothrow_t,
 {
 	event_idx
 }
+,_cached
+{
+	event_idx && should_cache(opts)?
+		event_fetch_cache_find(event_idx):
+		nullptr
+}
 ,_json
 {
 	dbs::event_json,
-	event_idx && should_seek_json(opts)?
+	event_idx && !_cached && should_seek_json(opts)?
 		key(&event_idx):
 		string_view{},
 	opts.gopts
@@ -201,10 +550,10 @@ ircd::m::event::fetch::fetch(std::nothrow_t,
 ,row
 {
 	*dbs::events,
-	event_idx && !_json.valid(key(&event_idx))?
+	event_idx && !_cached && !_json.valid(key(&event_idx))?
 		key(&event_idx):
 		string_view{},
-	event_idx && !_json.valid(key(&event_idx))?
+	event_idx && !_cached && !_json.valid(key(&event_idx))?
 		event::keys{opts.keys}:
 		event::keys{event::keys::include{}},
 	cell,
@@ -222,6 +571,8 @@ ircd::m::event::fetch::fetch(std::nothrow_t,
 }
 {
 	valid =
+		_cached?
+			assign_from_cache():
 		event_idx && _json.valid(key(&event_idx))?
 			assign_from_json(key(&event_idx)):
 		event_idx?
@@ -261,17 +612,37 @@ ircd::m::event::fetch::fetch(const opts &opts)
 [[gnu::visibility("hidden")]]
 bool
 ircd::m::event::fetch::assign_from_json(const string_view &key)
-try
+{
+	assert(_json.valid(key));
+	assert(fopts);
+	if(should_cache(*fopts) && event_fetch_cache_admit(*this, _json.val()))
+		return true;
+
+	return assign_from_source(_json.val());
+}
+
+[[gnu::visibility("hidden")]]
+bool
+ircd::m::event::fetch::assign_from_cache()
 {
 	auto &event
 	{
 		static_cast<m::event &>(*this)
 	};
 
-	assert(_json.valid(key));
-	const json::object source
+	assert(_cached);
+	event = _cached->event;
+	return true;
+}
+
+[[gnu::visibility("hidden")]]
+bool
+ircd::m::event::fetch::assign_from_source(const json::object &source)
+try
+{
+	auto &event
 	{
-		_json.val()
+		static_cast<m::event &>(*this)
 	};
 
 	assert(!empty(source));
@@ -401,6 +772,20 @@ ircd::m::event::fetch::should_seek_json(const opts &opts)
 	return false;
 }
 
+[[gnu::visibility("hidden")]]
+bool
+ircd::m::event::fetch::should_cache(const opts &opts)
+{
+	// The entry is a whole event; a narrower selection would be given keys
+	// it didn't ask for. Reads at a snapshot or declining the cache are not
+	// served from here either.
+	return event_fetch_cache_enable
+	&& opts.keys.all()
+	&& !opts.gopts.snapshot
+	&& !opts.gopts.seqnum
+	&& !test(opts.gopts, db::get::NO_CACHE);
+}
+
 [[gnu::visibility("hidden")]]
 ircd::string_view
 ircd::m::event::fetch::key(const event::idx *const &event_idx)
@@ -409,6 +794,125 @@ ircd::m::event::fetch::key(const event::idx *const &event_idx)
 	return byte_view<string_view>(*event_idx);
 }
 
+//
+// event::fetch::cache
+//
+
+/// Drops the cached event; called by anything which erases or rewrites the
+/// JSON of the event.
+void
+ircd::m::event::fetch::invalidate(const idx &event_idx)
+noexcept
+{
+	const auto it
+	{
+		event_fetch_cache.find(event_idx)
+	};
+
+	if(it == end(event_fetch_cache))
+		return;
+
+	event_fetch_cache_lru.erase(it->second);
+	event_fetch_cache.erase(it);
+}
+
+/// Drops all cached events. Entries are abandoned by advancing the generation
+/// and released as they are found, rather than all at once here.
+void
+ircd::m::event::fetch::invalidate()
+noexcept
+{
+	++event_fetch_cache_generation;
+}
+
+ircd::m::event_fetch_cache_entry
+ircd::m::event_fetch_cache_find(const event::idx &event_idx)
+{
+	const auto it
+	{
+		event_fetch_cache.find(event_idx)
+	};
+
+	if(it == end(event_fetch_cache))
+	{
+		++event_fetch_cache_misses;
+		return {};
+	}
+
+	const auto lit
+	{
+		it->second
+	};
+
+	if(lit->second->generation != event_fetch_cache_generation)
+	{
+		event_fetch_cache_lru.erase(lit);
+		event_fetch_cache.erase(it);
+		++event_fetch_cache_misses;
+		return {};
+	}
+
+	event_fetch_cache_lru.splice(begin(event_fetch_cache_lru), event_fetch_cache_lru, lit);
+	++event_fetch_cache_hits;
+	return lit->second;
+}
+
+/// Parses the source into a new entry and assigns the fetch from it. False
+/// is returned when the event is not cached, leaving it to the caller.
+bool
+ircd::m::event_fetch_cache_admit(event::fetch &fetch,
+                                 const json::object &source)
+try
+{
+	if(size(string_view(source)) > size_t(event_fetch_cache_event_max))
+		return false;
+
+	if(event_fetch_cache.count(fetch.event_idx))
+		return false;
+
+	auto entry
+	{
+		std::make_shared<event::fetch::cache_entry>()
+	};
+
+	entry->source = std::string(string_view(source));
+	entry->generation = event_fetch_cache_generation;
+	const json::object &copy
+	{
+		entry->source
+	};
+
+	entry->event_id =
+		copy.has("event_id")?
+			event::id::buf{json::string(copy.at("event_id"))}:
+		fetch.event_id_buf?
+			event::id::buf{fetch.event_id_buf}:
+			m::event_id(std::nothrow, fetch.event_idx);
+
+	if(!entry->event_id)
+		return false;
+
+	entry->event = m::event
+	{
+		copy, entry->event_id
+	};
+
+	event_fetch_cache_lru.emplace_front(fetch.event_idx, std::move(entry));
+	event_fetch_cache.emplace(fetch.event_idx, begin(event_fetch_cache_lru));
+	while(event_fetch_cache.size() > size_t(event_fetch_cache_max))
+	{
+		event_fetch_cache.erase(event_fetch_cache_lru.back().first);
+		event_fetch_cache_lru.pop_back();
+	}
+
+	fetch._cached = event_fetch_cache_lru.front().second;
+	return fetch.assign_from_cache();
+}
+catch(const json::parse_error &)
+{
+	return false;
+}
+
 //
 // event::fetch::opts
 //
@@ -17,47 +17,45 @@ namespace ircd::m::dbs
 size_t
 ircd::m::event::horizon::rebuild()
 {
-	m::dbs::write_opts opts;
-	opts.appendix.reset();
-	opts.appendix.set(dbs::appendix::EVENT_HORIZON);
-	db::txn txn
+	static const event::fetch::opts fopts
 	{
-		*dbs::events
+		event::keys::include {"event_id", "prev_events"}
 	};
 
-	size_t ret(0);
-	m::events::for_each({0UL, -1UL}, [&ret, &txn, &opts]
-	(const m::event::idx &event_idx, const m::event &event)
+	m::events::rebuild::opts opts;
+	opts.name = "event_horizon";
+	opts.fopts = &fopts;
+	const m::events::rebuild rebuild
 	{
-		const m::event::prev prev
+		opts, [](db::txn &txn, const event::idx &event_idx, const m::event &event)
 		{
-			event
-		};
+			m::dbs::write_opts opts;
+			opts.appendix.reset();
+			opts.appendix.set(dbs::appendix::EVENT_HORIZON);
+			opts.event_idx = event_idx;
 
-		m::for_each(prev, [&ret, &txn, &opts, &event_idx, &event]
-		(const m::event::id &event_id)
-		{
-			if(m::exists(event_id))
-				return true;
+			size_t ret(0);
+			const m::event::prev prev
+			{
+				event
+			};
 
-			opts.event_idx = event_idx;
-			m::dbs::_index_event_horizon(txn, event, opts, event_id);
-			if(++ret % 1024 == 0)
-				log::info
-				{
-					m::log, "event::horizon rebuild @ %lu/%lu",
-					event_idx,
-					m::vm::sequence::retired,
-				};
-
-			return true;
-		});
+			m::for_each(prev, [&ret, &txn, &opts, &event]
+			(const m::event::id &event_id)
+			{
+				if(m::exists(event_id))
+					return true;
 
-		return true;
-	});
+				m::dbs::_index_event_horizon(txn, event, opts, event_id);
+				++ret;
+				return true;
+			});
 
-	txn();
-	return ret;
+			return ret;
+		}
+	};
+
+	return rebuild.indexed;
 }
 
 bool
@@ -67,3 +67,75 @@ ircd::m::event_id(std::nothrow_t,
 {
 	return get(std::nothrow, event_idx, "event_id", closure);
 }
+
+size_t
+ircd::m::event_id(std::nothrow_t,
+                  const vector_view<event::id::buf> &out,
+                  const vector_view<const event::idx> &in)
+{
+	static const size_t batch_max
+	{
+		256
+	};
+
+	const size_t max
+	{
+		std::min(out.size(), in.size())
+	};
+
+	auto &column
+	{
+		dbs::event_column.at(json::indexof<m::event, "event_id"_>())
+	};
+
+	std::vector<db::column> columns;
+	std::vector<string_view> keys;
+	std::vector<size_t> pos;
+	columns.reserve(batch_max);
+	keys.reserve(batch_max);
+	pos.reserve(batch_max);
+
+	size_t ret(0);
+	for(size_t i(0); i < max; i += batch_max)
+	{
+		const size_t num
+		{
+			i + batch_max > max? max - i: batch_max
+		};
+
+		columns.clear();
+		keys.clear();
+		pos.clear();
+		for(size_t j(i); j < i + num; ++j)
+		{
+			out[j] = event::id::buf{};
+			if(!in[j])
+				continue;
+
+			columns.emplace_back(column);
+			keys.emplace_back(byte_view<string_view>(in[j]));
+			pos.emplace_back(j);
+		}
+
+		if(keys.empty())
+			continue;
+
+		db::read(columns, keys, [&out, &pos, &ret]
+		(const size_t &k, const string_view &val, const bool &found)
+		{
+			if(!found || empty(val))
+				return;
+
+			out[pos.at(k)] = event::id{val};
+			++ret;
+		});
+
+		// Events of the older room versions might only carry their event_id
+		// in the JSON; those fall back to the individual query.
+		for(const auto &j : pos)
+			if(!out[j] && event_id(std::nothrow, in[j], out[j]))
+				++ret;
+	}
+
+	return ret;
+}
@@ -11,6 +11,9 @@
 namespace ircd::m::events
 {
 	extern conf::item<size_t> dump_buffer_size;
+	extern conf::item<size_t> dump_jsonl_buffer_size;
+	extern conf::item<size_t> dump_jsonl_parts;
+	extern conf::item<size_t> load_jsonl_batch;
 }
 
 decltype(ircd::m::events::dump_buffer_size)
@@ -20,68 +23,323 @@ ircd::m::events::dump_buffer_size
 	{ "default",  int64_t(512_KiB)                 },
 };
 
-void
-ircd::m::events::rebuild()
+decltype(ircd::m::events::dump_jsonl_buffer_size)
+ircd::m::events::dump_jsonl_buffer_size
+{
+	{ "name",     "ircd.m.events.dump.jsonl.buffer_size" },
+	{ "default",  int64_t(8_MiB)                         },
+	{ "description",
+
+	R"(
+	Size of the buffer each partition of a JSON-lines dump fills before it
+	is written out; larger buffers make fewer, larger writes.
+	)"},
+};
+
+decltype(ircd::m::events::dump_jsonl_parts)
+ircd::m::events::dump_jsonl_parts
+{
+	{ "name",     "ircd.m.events.dump.jsonl.parts" },
+	{ "default",  4L                               },
+	{ "description",
+
+	R"(
+	Default number of files (and concurrent writers) a JSON-lines dump
+	divides its range of events among.
+	)"},
+};
+
+decltype(ircd::m::events::load_jsonl_batch)
+ircd::m::events::load_jsonl_batch
+{
+	{ "name",     "ircd.m.events.load.jsonl.batch" },
+	{ "default",  2048L                            },
+};
+
+//
+// events::rebuild
+//
+
+namespace ircd::m::events
+{
+	static event::idx rebuild_checkpoint(const string_view &name);
+	static void rebuild_checkpoint(const string_view &name, const event::idx &);
+}
+
+decltype(ircd::m::events::rebuild::concurrency)
+ircd::m::events::rebuild::concurrency
+{
+	{ "name",     "ircd.m.events.rebuild.concurrency" },
+	{ "default",  4L                                  },
+};
+
+decltype(ircd::m::events::rebuild::partition)
+ircd::m::events::rebuild::partition
+{
+	{ "name",     "ircd.m.events.rebuild.partition" },
+	{ "default",  long(256_KiB)                     },
+	{ "description",
+
+	R"(
+	Number of event_idx in each partition of a rebuild. This is also the
+	granularity of the checkpoint from which an interrupted rebuild resumes.
+	)"},
+};
+
+decltype(ircd::m::events::rebuild::txn_max)
+ircd::m::events::rebuild::txn_max
+{
+	{ "name",     "ircd.m.events.rebuild.txn_max" },
+	{ "default",  long(64_MiB)                    },
+	{ "description",
+
+	R"(
+	Size of a partition's transaction after which it is committed and a new
+	one is started. Larger transactions make fewer, larger writes.
+	)"},
+};
+
+ircd::m::events::rebuild::rebuild()
+:rebuild{[]
 {
 	static const event::fetch::opts fopts
 	{
 		event::keys::include {"type", "sender"}
 	};
 
-	static const m::events::range range
+	struct opts ret;
+	ret.name = "type_sender";
+	ret.fopts = &fopts;
+	return ret;
+}(), []
+(db::txn &txn, const event::idx &event_idx, const m::event &event)
+{
+	dbs::write_opts wopts;
+	wopts.appendix.reset();
+	wopts.appendix.set(dbs::appendix::EVENT_TYPE);
+	wopts.appendix.set(dbs::appendix::EVENT_SENDER);
+	wopts.event_idx = event_idx;
+	dbs::write(txn, event, wopts);
+	return 2UL;
+}}
+{
+}
+
+ircd::m::events::rebuild::rebuild(const opts &opts,
+                                  const closure &closure)
+{
+	const event::idx stop
+	{
+		std::min(opts.stop, vm::sequence::retired + 1)
+	};
+
+	resumed = opts.name?
+		std::max(opts.start, rebuild_checkpoint(opts.name)):
+		opts.start;
+
+	const size_t part_size
 	{
-		0, -1UL, &fopts
+		std::max(size_t(partition), 1UL)
 	};
 
-	db::txn txn
+	std::vector<event::idx_range> parts;
+	parts.reserve(stop > resumed? (stop - resumed) / part_size + 1: 0);
+	for(event::idx start(resumed); start < stop; start += part_size)
+		parts.emplace_back(start, std::min(start + part_size, stop));
+
+	const size_t workers
 	{
-		*m::dbs::events
+		std::clamp(opts.concurrency?: size_t(concurrency), 1UL, std::max(parts.size(), 1UL))
 	};
 
-	dbs::write_opts wopts;
-	wopts.appendix.reset();
-	wopts.appendix.set(dbs::appendix::EVENT_TYPE);
-	wopts.appendix.set(dbs::appendix::EVENT_SENDER);
+	log::notice
+	{
+		log, "Events rebuild '%s' of %lu to %lu in %zu partitions by %zu workers%s...",
+		opts.name,
+		resumed,
+		stop,
+		parts.size(),
+		workers,
+		resumed > opts.start? " (resumed)"_sv: string_view{},
+	};
 
-	size_t ret(0);
-	for_each(range, [&txn, &wopts, &ret]
-	(const event::idx &event_idx, const m::event &event)
+	const ctx::pool::opts pool_opts
+	{
+		512_KiB,                                             // stack sz
+		workers,                                             // pool sz
+		-1,                                                  // queue max hard
+		0,                                                   // queue max soft
+		true,                                                // queue max blocking
+		false,                                               // queue max warning
+		int8_t(opts.background? 3: 0),                       // ionice
+		int8_t(opts.background? ctx::sched::BACKGROUND: 0),  // nice
+	};
+
+	ctx::pool pool
 	{
-		wopts.event_idx = event_idx;
-		dbs::write(txn, event, wopts);
-		++ret;
+		"m.events.rebuild", pool_opts
+	};
 
-		if(ret % 8192UL == 0UL)
+	// Partitions complete out of order; the checkpoint only advances over a
+	// contiguous run of completed partitions from the front.
+	ctx::mutex mutex;
+	size_t low(0);
+	std::vector<bool> done(parts.size(), false);
+	std::vector<size_t> index(parts.size());
+	std::iota(begin(index), end(index), 0UL);
+
+	util::timer timer;
+	ctx::concurrent_for_each<size_t>
+	{
+		pool, index, [&](size_t &i)
+		{
+			const auto &part(parts.at(i));
+			const range range
+			{
+				part.first, part.second, opts.fopts
+			};
+
+			db::txn txn
+			{
+				*dbs::events
+			};
+
+			size_t visited(0), indexed(0), commits(0);
+			events::for_each(range, [&](const event::idx &event_idx, const m::event &event)
+			{
+				indexed += closure(txn, event_idx, event);
+				++visited;
+				if(txn.bytes() < size_t(txn_max))
+					return true;
+
+				txn();
+				txn.clear();
+				++commits;
+				return true;
+			});
+
+			if(txn.size())
+			{
+				txn();
+				++commits;
+			}
+
+			const std::lock_guard lock
+			{
+				mutex
+			};
+
+			this->visited += visited;
+			this->indexed += indexed;
+			this->commits += commits;
+			done.at(i) = true;
+
+			const size_t last(low);
+			while(low < done.size() && done[low])
+				++low;
+
+			if(opts.name && low > last)
+				rebuild_checkpoint(opts.name, low < parts.size()? parts[low].first: stop);
+
+			char pbuf[48];
 			log::info
 			{
-				log, "Events type/sender table rebuild events %zu of %zu num:%zu txn:%zu %s",
-				event_idx,
-				vm::sequence::retired,
-				ret,
-				txn.size(),
-				pretty(iec(txn.bytes())),
+				log, "Events rebuild '%s' partition %zu of %zu [%lu, %lu) events:%zu indexed:%zu commits:%zu in %s",
+				opts.name,
+				i + 1,
+				parts.size(),
+				part.first,
+				part.second,
+				visited,
+				indexed,
+				commits,
+				timer.pretty(pbuf),
 			};
+		}
+	};
 
-		return true;
+	char pbuf[48];
+	log::notice
+	{
+		log, "Events rebuild '%s' complete events:%zu indexed:%zu commits:%zu in %s",
+		opts.name,
+		this->visited,
+		this->indexed,
+		this->commits,
+		timer.pretty(pbuf),
+	};
+}
+
+/// Progress is noted in a state event of our own room for the purpose; the
+/// content holds the event_idx from which to resume.
+void
+ircd::m::events::rebuild_checkpoint(const string_view &name,
+                                    const event::idx &resume)
+try
+{
+	const m::room::id::buf progress_room_id
+	{
+		"rebuild", my_host()
+	};
+
+	if(!exists(progress_room_id))
+		create(progress_room_id, me());
+
+	// Notes are local records; see vm::record_copts.
+	const m::room progress_room
+	{
+		progress_room_id, &vm::record_copts
+	};
+
+	send(progress_room, me(), "ircd.events.rebuild", name, json::members
+	{
+		{ "resume", long(resume) },
 	});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Failed to checkpoint events rebuild '%s' at %lu :%s",
+		name,
+		resume,
+		e.what(),
+	};
+}
 
-	log::info
+ircd::m::event::idx
+ircd::m::events::rebuild_checkpoint(const string_view &name)
+{
+	const m::room::id::buf progress_room_id
 	{
-		log, "Events type/sender table rebuild events:%zu txn:%zu %s commit...",
-		ret,
-		txn.size(),
-		pretty(iec(txn.bytes())),
+		"rebuild", my_host()
 	};
 
-	txn();
+	if(!exists(progress_room_id))
+		return 0;
 
-	log::notice
+	const m::room::state state
 	{
-		log, "Events type/sender table rebuild complete.",
-		ret,
-		txn.size(),
-		pretty(iec(txn.bytes())),
+		progress_room_id
 	};
+
+	const auto event_idx
+	{
+		state.get(std::nothrow, "ircd.events.rebuild", name)
+	};
+
+	event::idx ret{0};
+	m::get(std::nothrow, event_idx, "content", [&ret]
+	(const json::object &content)
+	{
+		ret = content.get<long>("resume", 0L);
+	});
+
+	return ret;
 }
 
 void
@@ -215,6 +473,272 @@ ircd::m::events::dump__file(const string_view &filename)
 	};
 }
 
+size_t
+ircd::m::events::dump__jsonl(const string_view &prefix,
+                             const range &range,
+                             const size_t &num_parts)
+{
+	const event::idx start
+	{
+		std::max(range.first, 1UL)
+	};
+
+	const event::idx stop
+	{
+		std::min(range.second, vm::sequence::retired + 1)
+	};
+
+	const size_t parts
+	{
+		std::clamp(num_parts?: size_t(dump_jsonl_parts), 1UL, std::max(stop - start, 1UL))
+	};
+
+	const size_t part_size
+	{
+		stop > start?
+			(stop - start + parts - 1) / parts:
+			0UL
+	};
+
+	const ctx::pool::opts pool_opts
+	{
+		512_KiB,                   // stack sz
+		parts,                     // pool sz
+		-1,                        // queue max hard
+		0,                         // queue max soft
+		true,                      // queue max blocking
+		false,                     // queue max warning
+		3,                         // ionice
+		ctx::sched::BACKGROUND,    // nice
+	};
+
+	ctx::pool pool
+	{
+		"m.events.dump", pool_opts
+	};
+
+	std::vector<size_t> index(parts);
+	std::iota(begin(index), end(index), 0UL);
+
+	util::timer timer;
+	size_t ecount{0}, foff{0};
+	ctx::concurrent_for_each<size_t>
+	{
+		pool, index, [&](size_t &i)
+		{
+			const events::range part
+			{
+				std::min(start + i * part_size, stop),
+				std::min(start + (i + 1) * part_size, stop),
+			};
+
+			const fmt::snstringf filename
+			{
+				size(prefix) + 16, "%s.%04zu", prefix, i
+			};
+
+			fs::fd::opts fileopts(std::ios::out);
+			fileopts.exclusive = true;   // error if exists
+			fileopts.dontneed = true;    // fadvise
+			const fs::fd file
+			{
+				filename, fileopts
+			};
+
+			const unique_buffer<mutable_buffer> buf
+			{
+				size_t(dump_jsonl_buffer_size), 4_KiB
+			};
+
+			size_t count(0), wrote(0);
+			mutable_buffer out(buf);
+			const auto flush{[&]
+			{
+				const const_buffer pending
+				{
+					data(buf), size(buf) - size(out)
+				};
+
+				wrote += size(fs::append(file, pending));
+				out = buf;
+			}};
+
+			events::source::for_each(part, [&]
+			(const event::idx &event_idx, const json::object &event)
+			{
+				if(unlikely(size(string_view(event)) + 1 > size(out)))
+					flush();
+
+				// An event larger than the whole buffer is written directly.
+				if(unlikely(size(string_view(event)) + 1 > size(out)))
+				{
+					wrote += size(fs::append(file, const_buffer{string_view(event)}));
+					wrote += size(fs::append(file, const_buffer{"\n"_sv}));
+					++count;
+					return true;
+				}
+
+				consume(out, copy(out, string_view(event)));
+				consume(out, copy(out, "\n"_sv));
+				++count;
+				return true;
+			});
+
+			flush();
+			ecount += count;
+			foff += wrote;
+
+			char pbuf[2][48];
+			log::info
+			{
+				log, "dump[%s] [%lu, %lu) events:%zu wrote %s in %s",
+				string_view{filename},
+				part.first,
+				part.second,
+				count,
+				pretty(pbuf[0], iec(wrote)),
+				timer.pretty(pbuf[1]),
+			};
+		}
+	};
+
+	char pbuf[3][48];
+	const auto elapsed
+	{
+		std::max(timer.at<seconds>().count(), 1L)
+	};
+
+	log::notice
+	{
+		log, "dump[%s] complete events:%zu in %zu parts using %s; %s/s; %s elapsed",
+		prefix,
+		ecount,
+		parts,
+		pretty(pbuf[0], iec(foff)),
+		pretty(pbuf[1], iec(foff / elapsed), 1),
+		timer.pretty(pbuf[2]),
+	};
+
+	return ecount;
+}
+
+/// Loads a JSON-lines file as produced by dump__jsonl(). The events are
+/// evaluated in batches through the same reduced set of phases used to
+/// bootstrap a database from a vector of events: they are conformed,
+/// indexed and written; the input is trusted to be authentic.
+size_t
+ircd::m::events::load__jsonl(const string_view &filename)
+{
+	fs::fd::opts fileopts(std::ios::in);
+	const fs::fd file
+	{
+		filename, fileopts
+	};
+
+	fs::map::opts map_opts(fileopts);
+	map_opts.sequential = true;
+	const fs::map map
+	{
+		file, map_opts
+	};
+
+	vm::opts vmopts;
+	vmopts.phase.reset();
+	vmopts.mprefetch_refs = true;
+	vmopts.phase.set(vm::phase::CONFORM, true);
+	vmopts.phase.set(vm::phase::PREINDEX, true);
+	vmopts.phase.set(vm::phase::INDEX, true);
+	vmopts.phase.set(vm::phase::WRITE, true);
+	vmopts.wopts.appendix.set(dbs::appendix::ROOM_HEAD, false);
+	vmopts.wopts.appendix.set(dbs::appendix::ROOM_HEAD_RESOLVE, false);
+	vmopts.non_conform.set(event::conforms::MISMATCH_ORIGIN_SENDER);
+	vmopts.non_conform.set(event::conforms::MISMATCH_HASHES);
+	vmopts.replays = sequence(*dbs::events) == 0;
+	vmopts.infolog_accept = false;
+	vmopts.nothrows = -1UL;
+
+	vm::eval eval
+	{
+		vmopts
+	};
+
+	std::vector<m::event> vec
+	(
+		std::max(size_t(load_jsonl_batch), 1UL)
+	);
+
+	util::timer timer;
+	string_view input(const_buffer{map});
+	size_t count(0), evicted(0);
+	while(!empty(input))
+	{
+		size_t i(0);
+		for(; i < vec.size() && !empty(input); )
+		{
+			const auto line
+			{
+				split(input, '\n')
+			};
+
+			input = line.second;
+			if(!empty(line.first))
+				vec[i++] = json::object{line.first};
+		}
+
+		const vector_view<const m::event> batch
+		{
+			vec.data(), vec.data() + i
+		};
+
+		execute(eval, batch);
+		count += i;
+
+		auto opts(map_opts);
+		opts.offset = evicted;
+		const size_t consumed
+		{
+			size(map) - size(input)
+		};
+
+		// advise dontneed
+		evicted += evict(map, consumed - evicted, opts);
+
+		char pbuf[2][48];
+		log::info
+		{
+			log, "load[%s] %0.2lf%% events:%zu accepts:%zu faults:%zu read %s in %s",
+			filename,
+			(consumed / double(std::max(size(map), 1UL))) * 100.0,
+			count,
+			eval.accepted,
+			eval.faulted,
+			pretty(pbuf[0], iec(consumed)),
+			timer.pretty(pbuf[1]),
+		};
+
+		ctx::interruption_point();
+	}
+
+	if(likely(count))
+	{
+		const bool blocking(true), allow_stall(true);
+		db::sort(*dbs::events, blocking, allow_stall);
+	}
+
+	char pbuf[48];
+	log::notice
+	{
+		log, "load[%s] complete events:%zu accepts:%zu faults:%zu in %s",
+		filename,
+		count,
+		eval.accepted,
+		eval.faulted,
+		timer.pretty(pbuf),
+	};
+
+	return eval.accepted;
+}
+
 bool
 ircd::m::events::for_each(const range &range,
                           const event_filter &filter,
@@ -370,6 +894,14 @@ ircd::m::events::content::readahead
 
 bool
 ircd::m::events::content::for_each(const closure &closure)
+{
+	return for_each(0UL, closure);
+}
+
+/// Iterates in ascending order of event_idx beginning at start (inclusive).
+bool
+ircd::m::events::content::for_each(const event::idx &start,
+                                   const closure &closure)
 {
 	constexpr auto content_idx
 	{
@@ -388,7 +920,7 @@ ircd::m::events::content::for_each(const closure &closure)
 	};
 	gopts.readahead = size_t(readahead);
 
-	auto it(column.begin(gopts));
+	auto it(column.lower_bound(byte_view<string_view>(start), gopts));
 	for(; it; ++it)
 	{
 		const auto &event_idx
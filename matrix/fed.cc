@@ -1682,6 +1682,37 @@ ircd::m::fed::errant(const string_view &name)
 	});
 }
 
+/// backoff() reports when the cached error for the remote server expires.
+/// Subsequent consecutive failures extend this interval exponentially. The
+/// result is the epoch when the remote is not errant.
+ircd::system_point
+ircd::m::fed::backoff(const string_view &name)
+{
+	well_known::opts opts;
+	opts.request = false;
+	opts.expired = true;
+	return with_server(name, opts, []
+	(const auto &remote)
+	{
+		return server::backoff(remote);
+	});
+}
+
+/// rtt() reports the moving average of request latency for the remote
+/// server; zero when no successful request has been made.
+ircd::microseconds
+ircd::m::fed::rtt(const string_view &name)
+{
+	well_known::opts opts;
+	opts.request = false;
+	opts.expired = true;
+	return with_server(name, opts, []
+	(const auto &remote)
+	{
+		return server::rtt(remote);
+	});
+}
+
 /// exists() reports that contact has been made with the remote server. This
 /// does not indicate success or failure for prior or active engagements.
 bool
@@ -11,13 +11,23 @@
 namespace ircd::m::fed::well_known
 {
 	static net::hostport make_remote(const string_view &);
+	static ctx::future<string_view> start(const mutable_buffer &, const string_view &target, const string_view &cached, const system_point &expires, const opts &);
+	static void refresh(const string_view &target, const string_view &cached, const system_point &expires, const opts &);
 	static void submit(request &);
 	static void receive(request &);
 	static void finish(request &);
 	static bool handle(request &);
 	static void worker();
+	static void remember(const string_view &target, const string_view &m_server, const system_point &expires);
+
+	using cache_entry = std::pair<std::string, system_point>;
+	using cache_memory_t = std::map<std::string, cache_entry, std::less<>>;
 
 	static server::request request_skip;
+	extern cache_memory_t cache_memory;
+	extern conf::item<size_t> cache_memory_max;
+	extern conf::item<seconds> cache_min;
+	extern conf::item<seconds> cache_stale;
 	extern ctx::dock worker_dock;
 	extern ctx::context worker_context;
 	extern run::changed handle_quit;
@@ -56,14 +66,59 @@ ircd::m::fed::well_known::cache_error
 	{ "default",  36 * 60 * 60L                       },
 };
 
-///NOTE: not yet used until HTTP cache headers in response are respected.
 decltype(ircd::m::fed::well_known::cache_max)
 ircd::m::fed::well_known::cache_max
 {
 	{ "name",     "ircd.m.fed.well-known.cache.max" },
 	{ "default",  48 * 60 * 60L                     },
+	{ "description",
+
+	R"(
+	Upper bound on the lifetime given to a result by the Cache-Control or
+	Expires headers of the response. Responses without either header are
+	cached for ircd.m.fed.well-known.cache.default.
+	)"},
 };
 
+decltype(ircd::m::fed::well_known::cache_min)
+ircd::m::fed::well_known::cache_min
+{
+	{ "name",     "ircd.m.fed.well-known.cache.min" },
+	{ "default",  5 * 60L                           },
+	{ "description",
+
+	R"(
+	Lower bound on the lifetime given to a result by the cache headers of the
+	response, so a response marked no-cache isn't requested for every peer.
+	)"},
+};
+
+decltype(ircd::m::fed::well_known::cache_stale)
+ircd::m::fed::well_known::cache_stale
+{
+	{ "name",     "ircd.m.fed.well-known.cache.stale" },
+	{ "default",  7 * 24 * 60 * 60L                   },
+	{ "description",
+
+	R"(
+	Period after a result expires during which it is still returned without
+	waiting, while a request to refresh it is made in the background.
+	)"},
+};
+
+decltype(ircd::m::fed::well_known::cache_memory_max)
+ircd::m::fed::well_known::cache_memory_max
+{
+	{ "name",     "ircd.m.fed.well-known.cache.memory.max" },
+	{ "default",  16384L                                   },
+};
+
+/// Results are held here in front of the cache room, which is then only
+/// read on a miss (e.g. after a restart). The server already consults this
+/// for every new peer before any DNS query is made for it.
+decltype(ircd::m::fed::well_known::cache_memory)
+ircd::m::fed::well_known::cache_memory;
+
 decltype(ircd::m::fed::well_known::request::path)
 ircd::m::fed::well_known::request::path
 {
@@ -139,9 +194,21 @@ try
 		cache_room_id
 	};
 
-	const m::event::idx event_idx
+	const auto memory_it
 	{
 		likely(opts.cache_check)?
+			cache_memory.find(target):
+			end(cache_memory)
+	};
+
+	const bool memory_hit
+	{
+		memory_it != end(cache_memory)
+	};
+
+	const m::event::idx event_idx
+	{
+		likely(opts.cache_check) && !memory_hit?
 			cache_room.get(std::nothrow, request::type, target):
 			0UL
 	};
@@ -163,7 +230,9 @@ try
 
 	const system_point expires
 	{
-		origin_server_ts + ttl
+		memory_hit?
+			memory_it->second.second:
+			system_point(origin_server_ts + ttl)
 	};
 
 	const bool expired
@@ -171,20 +240,40 @@ try
 		ircd::now<system_point>() > expires
 	};
 
+	// An expired result is returned while it is refreshed in the background
+	// for a period after it expires.
+	const bool stale
+	{
+		expired
+		&& !opts.expired
+		&& opts.request
+		&& ircd::now<system_point>() < expires + seconds(cache_stale)
+	};
+
+	// The result from memory is copied to the buffer like one from the room
+	// since this frame may yield below.
 	const json::string cached
 	{
-		content["m.server"]
+		memory_hit?
+			string_view{data(buf), copy(buf, string_view(memory_it->second.first))}:
+			string_view{content["m.server"]}
 	};
 
+	if(event_idx && !empty(cached))
+		remember(target, cached, expires);
+
 	const bool valid
 	{
 		// entry must not be blank
 		!empty(cached)
 
 		// entry must not be expired unless options allow expired hits
-		&& (!expired || opts.expired)
+		&& (!expired || opts.expired || stale)
 	};
 
+	if(valid && stale)
+		refresh(target, cached, expires, opts);
+
 	// Branch to return cache hit
 	if(likely(valid))
 		return ctx::future<string_view>
@@ -232,6 +321,37 @@ try
 		};
 	}
 
+	return start(buf, target, cached, expires, opts);
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "get %s :%s",
+		target,
+		e.what(),
+	};
+
+	return ctx::future<string_view>
+	{
+		ctx::already, string_view
+		{
+			data(buf), move(buf, target)
+		}
+	};
+}
+
+ircd::ctx::future<ircd::string_view>
+ircd::m::fed::well_known::start(const mutable_buffer &buf,
+                                const string_view &target,
+                                const string_view &cached,
+                                const system_point &expires,
+                                const opts &opts)
+{
 	// Synchronize modification of the request::list
 	const std::lock_guard request_lock
 	{
@@ -286,26 +406,50 @@ try
 
 	return ret;
 }
-catch(const ctx::interrupted &)
+
+void
+ircd::m::fed::well_known::refresh(const string_view &target,
+                                  const string_view &cached,
+                                  const system_point &expires,
+                                  const opts &opts)
+try
 {
-	throw;
+	if(server::errant(make_remote(target)))
+		return;
+
+	const bool inflight
+	{
+		std::any_of(begin(request::list), end(request::list), [&target]
+		(const auto *const &req)
+		{
+			return req->target == target;
+		})
+	};
+
+	if(inflight)
+		return;
+
+	char tmbuf[48];
+	log::debug
+	{
+		log, "%s refreshing stale %s expired %s",
+		target,
+		cached,
+		timef(tmbuf, expires, localtime),
+	};
+
+	// Nothing is written to the caller's buffer and the future is dropped;
+	// the result is only cached by finish().
+	start(mutable_buffer{}, target, cached, expires, opts);
 }
 catch(const std::exception &e)
 {
-	log::error
+	log::derror
 	{
-		log, "get %s :%s",
+		log, "%s refresh :%s",
 		target,
 		e.what(),
 	};
-
-	return ctx::future<string_view>
-	{
-		ctx::already, string_view
-		{
-			data(buf), move(buf, target)
-		}
-	};
 }
 
 void
@@ -482,10 +626,19 @@ try
 	// includes legitimate errors where fetch_well_known() returns the
 	// req.target to default) we consider that an error and use the error
 	// TTL value. Sorry, no exponential backoff implemented yet.
+	const seconds freshness
+	{
+		req.code == 200?
+			http::freshness(http::headers{req.head.headers}):
+			seconds(-1)
+	};
+
 	const auto cache_ttl
 	{
 		req.target == req.m_server?
 			seconds(cache_error).count():
+		freshness >= seconds(0)?
+			std::clamp(freshness, seconds(cache_min), seconds(cache_max)).count():
 			seconds(cache_default).count()
 	};
 
@@ -497,15 +650,21 @@ try
 	// Write our record to the cache room; note that this doesn't really
 	// match the format of other DNS records in this room since it's a bit
 	// simpler, but we don't share the ircd.dns.rr type prefix anyway.
+	const m::room cache_room
+	{
+		cache_room_id, &vm::record_copts
+	};
+
 	const auto cache_id
 	{
-		m::send(cache_room_id, m::me(), request::type, req.target, json::members
+		m::send(cache_room, m::me(), request::type, req.target, json::members
 		{
 			{ "ttl",       cache_ttl    },
 			{ "m.server",  req.m_server },
 		})
 	};
 
+	remember(req.target, req.m_server, now<system_point>() + seconds(cache_ttl));
 	log::debug
 	{
 		log, "%s cached delegation to %s with %s ttl:%ld",
@@ -609,3 +768,39 @@ ircd::m::fed::well_known::make_remote(const string_view &target)
 
 	return ret;
 }
+
+void
+ircd::m::fed::well_known::remember(const string_view &target,
+                                   const string_view &m_server,
+                                   const system_point &expires)
+{
+	// Drop the expired results when full; if that isn't enough the
+	// arbitrary first results are dropped, to be found in the room again.
+	if(unlikely(cache_memory.size() >= size_t(cache_memory_max)))
+	{
+		const auto now
+		{
+			ircd::now<system_point>()
+		};
+
+		for(auto it(begin(cache_memory)); it != end(cache_memory);)
+			if(it->second.second < now)
+				it = cache_memory.erase(it);
+			else
+				++it;
+
+		while(!cache_memory.empty() && cache_memory.size() >= size_t(cache_memory_max))
+			cache_memory.erase(begin(cache_memory));
+	}
+
+	auto it
+	{
+		cache_memory.lower_bound(target)
+	};
+
+	if(it == end(cache_memory) || it->first != target)
+		it = cache_memory.emplace_hint(it, std::string(target), cache_entry{});
+
+	it->second.first = m_server;
+	it->second.second = expires;
+}
@@ -345,6 +345,8 @@ ircd::m::feds::handler(request_list &reqs,
 		now<system_point>() + timeout
 	};
 
+	// Successful results of each operation with a quorum.
+	std::map<const opts *, size_t> quorum;
 	while(!reqs.empty())
 	{
 		static const auto dereferencer{[]
@@ -385,6 +387,17 @@ ircd::m::feds::handler(request_list &reqs,
 
 			if(!call_user(closure, result))
 				return false;
+
+			if(!req.opts->quorum || ++quorum[req.opts] < req.opts->quorum)
+				continue;
+
+			// The requests still pending for this operation are cancelled by
+			// their destruction; this one is removed by the unwind.
+			for(auto jt(begin(reqs)); jt != end(reqs);)
+				if(jt != it && (*jt)->opts == req.opts)
+					jt = reqs.erase(jt);
+				else
+					++jt;
 		}
 		catch(const std::exception &)
 		{
@@ -21,22 +21,32 @@ namespace ircd::m::fetch
 
 	extern ctx::dock dock;
 	extern ctx::mutex requests_mutex;
+	extern const ctx::prof::lock::label requests_mutex_label;
 	extern std::set<request, std::less<>> requests;
 	extern ctx::context request_context;
 	extern conf::item<size_t> backfill_limit_default;
 	extern conf::item<size_t> requests_max;
 	extern conf::item<seconds> timeout;
 	extern conf::item<bool> enable;
+	extern conf::item<bool> hedge_enable;
+	extern conf::item<size_t> hedge_max;
+	extern conf::item<size_t> hedge_rtt_factor;
+	extern conf::item<milliseconds> hedge_delay_min;
+	extern conf::item<milliseconds> hedge_delay_max;
 	extern log::log log;
 
 	static bool timedout(const request &, const system_point &now);
-	static void _check_event(const request &, const m::event &);
+	static void _check_event(const request &, const m::event &, const sha256::buf *const &hash = nullptr);
 	static void check_response(const request &, const json::object &);
 	static bool proffer_remote(request &, const string_view &);
 	static bool select_remote(request &, const string_view &);
 	static bool select_random_remote(request &);
 	static void finish(request &);
 	static void retry(request &);
+	static milliseconds hedge_delay(const request &, const string_view &remote);
+	static void hedge_promote(request &);
+	static bool hedge(request &);
+	static std::unique_ptr<server::request> submit(request &, const string_view &remote, const mutable_buffer &);
 	static bool start(request &, const string_view &remote);
 	static bool start(request &);
 	static void handle_result(request &);
@@ -82,6 +92,44 @@ ircd::m::fetch::backfill_limit_default
 	{ "default",  96L                                   },
 };
 
+decltype(ircd::m::fetch::hedge_enable)
+ircd::m::fetch::hedge_enable
+{
+	{ "name",     "ircd.m.fetch.hedge.enable" },
+	{ "default",  true                        },
+	{ "help",     "Duplicate slow event and auth requests to a second server." },
+};
+
+decltype(ircd::m::fetch::hedge_max)
+ircd::m::fetch::hedge_max
+{
+	{ "name",     "ircd.m.fetch.hedge.max" },
+	{ "default",  32L                      },
+	{ "help",     "Maximum hedged attempts outstanding at once." },
+};
+
+decltype(ircd::m::fetch::hedge_rtt_factor)
+ircd::m::fetch::hedge_rtt_factor
+{
+	{ "name",     "ircd.m.fetch.hedge.rtt.factor" },
+	{ "default",  4L                              },
+	{ "help",     "Multiple of the server's average latency before hedging." },
+};
+
+decltype(ircd::m::fetch::hedge_delay_min)
+ircd::m::fetch::hedge_delay_min
+{
+	{ "name",     "ircd.m.fetch.hedge.delay.min" },
+	{ "default",  250L                           },
+};
+
+decltype(ircd::m::fetch::hedge_delay_max)
+ircd::m::fetch::hedge_delay_max
+{
+	{ "name",     "ircd.m.fetch.hedge.delay.max" },
+	{ "default",  1500L                          },
+};
+
 decltype(ircd::m::fetch::dock)
 ircd::m::fetch::dock;
 
@@ -91,6 +139,12 @@ ircd::m::fetch::requests;
 decltype(ircd::m::fetch::requests_mutex)
 ircd::m::fetch::requests_mutex;
 
+decltype(ircd::m::fetch::requests_mutex_label)
+ircd::m::fetch::requests_mutex_label
+{
+	&requests_mutex, "m.fetch.requests"
+};
+
 decltype(ircd::m::fetch::request_context)
 ircd::m::fetch::request_context
 {
@@ -199,6 +253,47 @@ ircd::m::fetch::exists(const opts &opts)
 	return requests.count(opts);
 }
 
+/// Whether the event is being evaluated or sought by an unfinished request
+/// for it (or for a backfill starting from it). Callers which can wait for
+/// this demand to be satisfied should do so rather than start another.
+bool
+ircd::m::fetch::inflight(const event::id &event_id)
+{
+	if(vm::eval::count(event_id))
+		return true;
+
+	return std::any_of(begin(requests), end(requests), [&event_id]
+	(const auto &request)
+	{
+		return true
+		&& !request.finished
+		&& request.opts.op != op::auth
+		&& request.opts.event_id == event_id
+		;
+	});
+}
+
+/// Waits for the evals and requests in flight for the event elsewhere.
+/// Returns true if the event exists afterward; false if it does not, which
+/// includes when there was nothing in flight to wait for.
+bool
+ircd::m::fetch::wait(const event::id &event_id,
+                     const milliseconds &timeout)
+{
+	const auto deadline
+	{
+		ircd::now<system_point>() + timeout
+	};
+
+	// The sequence dock is notified by each eval when it completes.
+	vm::sequence::dock.wait_until(deadline, [&event_id]
+	{
+		return !inflight(event_id);
+	});
+
+	return m::exists(event_id);
+}
+
 bool
 ircd::m::fetch::for_each(const std::function<bool (request &)> &closure)
 {
@@ -235,6 +330,12 @@ void
 ircd::m::fetch::request_worker()
 try
 {
+	// Fetching is bulk work on behalf of the vm; yield to client requests.
+	const ctx::priority priority
+	{
+		ctx::sched::BACKGROUND
+	};
+
 	while(1)
 	{
 		dock.wait([]
@@ -273,6 +374,33 @@ ircd::m::fetch::request_handle()
 		fetch::dock
 	};
 
+	// Each request has an entry for its attempt; a request with a hedged
+	// attempt outstanding has a second entry where the flag is set.
+	using attempt = std::pair<decltype(requests)::iterator, bool>;
+	std::vector<attempt> attempts;
+	attempts.reserve(requests.size() + size_t(hedge_max));
+
+	milliseconds wait
+	{
+		seconds(timeout)
+	};
+
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	for(auto it(begin(requests)); it != end(requests); ++it)
+	{
+		attempts.emplace_back(it, false);
+		if(it->hedge)
+			attempts.emplace_back(it, true);
+
+		// Wake up in time to start any hedged attempt.
+		if(it->hedge_at != system_point{} && !it->finished)
+			wait = std::min(wait, std::max(duration_cast<milliseconds>(it->hedge_at - now), 0ms));
+	}
+
 	static const auto dereferencer{[]
 	(auto &it) -> server::request &
 	{
@@ -280,15 +408,21 @@ ircd::m::fetch::request_handle()
 		// during this pass we reference this default constructed static
 		// instance which when_any() will treat as a no-op.
 		static server::request request_skip;
-		auto &request(mutable_cast(*it));
-		return request.future?
-			*request.future:
+		const auto &[rit, hedge] {*it};
+		auto &request(mutable_cast(*rit));
+		auto &future
+		{
+			hedge? request.hedge: request.future
+		};
+
+		return future?
+			*future:
 			request_skip;
 	}};
 
 	auto next
 	{
-		ctx::when_any(requests.begin(), requests.end(), dereferencer)
+		ctx::when_any(attempts.begin(), attempts.end(), dereferencer)
 	};
 
 	bool timedout{true};
@@ -298,7 +432,7 @@ ircd::m::fetch::request_handle()
 			lock
 		};
 
-		timedout = !next.wait(seconds(timeout), std::nothrow);
+		timedout = !next.wait(wait, std::nothrow);
 	};
 
 	if(likely(!timedout))
@@ -308,9 +442,15 @@ ircd::m::fetch::request_handle()
 			next.get()
 		};
 
-		if(it != end(requests))
-			if(!request_handle(it))
+		if(it != end(attempts))
+		{
+			const auto &[rit, hedge] {*it};
+			if(hedge)
+				hedge_promote(mutable_cast(*rit));
+
+			if(!request_handle(rit))
 				return;
+		}
 	}
 
 	request_cleanup();
@@ -341,6 +481,15 @@ try
 		ircd::now<system_point>()
 	};
 
+	size_t hedges
+	{
+		size_t(std::count_if(begin(requests), end(requests), []
+		(const auto &request)
+		{
+			return bool(request.hedge);
+		}))
+	};
+
 	size_t ret(0);
 	for(auto it(begin(requests)); it != end(requests); ++it)
 	{
@@ -353,6 +502,13 @@ try
 
 		else if(!request.finished && timedout(request, now))
 			retry(request);
+
+		else if(request.hedge_at != system_point{} && request.hedge_at <= now)
+		{
+			request.hedge_at = {};
+			if(hedges < size_t(hedge_max))
+				hedges += hedge(request);
+		}
 	}
 
 	auto it(begin(requests)); while(it != end(requests))
@@ -453,6 +609,88 @@ try
 	if(!request.started)
 		request.started = request.last;
 
+	request.future = submit(request, remote, request.buf);
+
+	// Event and auth requests are on the critical path of evaluation; when
+	// the remote is slower than usual another server is tried concurrently.
+	const bool hedgeable
+	{
+		request.opts.op == op::event || request.opts.op == op::auth
+	};
+
+	request.hedge_at = hedge_enable && hedgeable?
+		request.last + hedge_delay(request, remote):
+		system_point{};
+
+	log::debug
+	{
+		log, "Starting %s request for %s in %s from '%s'",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+	};
+
+	dock.notify_all();
+	return true;
+}
+catch(const m::UNAVAILABLE &e)
+{
+	throw;
+}
+catch(const ctx::interrupted &e)
+{
+	throw;
+}
+catch(const http::error &e)
+{
+	log::derror
+	{
+		log, "Starting %s request for %s in %s to '%s' :%s %s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+		e.what(),
+		e.content,
+	};
+
+	return false;
+}
+catch(const server::error &e)
+{
+	log::derror
+	{
+		log, "Starting %s request for %s in %s to '%s' :%s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+		e.what(),
+	};
+
+	return false;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Starting %s request for %s in %s to '%s' :%s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+		e.what()
+	};
+
+	return false;
+}
+
+std::unique_ptr<ircd::server::request>
+ircd::m::fetch::submit(request &request,
+                       const string_view &remote,
+                       const mutable_buffer &buf)
+{
 	switch(request.opts.op)
 	{
 		case op::noop:
@@ -462,29 +700,25 @@ try
 		{
 			fed::event_auth::opts opts;
 			opts.remote = remote;
-			request.future = std::make_unique<fed::event_auth>
+			return std::make_unique<fed::event_auth>
 			(
 				request.opts.room_id,
 				request.opts.event_id,
-				request.buf,
+				buf,
 				std::move(opts)
 			);
-
-			break;
 		}
 
 		case op::event:
 		{
 			fed::event::opts opts;
 			opts.remote = remote;
-			request.future = std::make_unique<fed::event>
+			return std::make_unique<fed::event>
 			(
 				request.opts.event_id,
-				request.buf,
+				buf,
 				std::move(opts)
 			);
-
-			break;
 		}
 
 		case op::backfill:
@@ -494,79 +728,122 @@ try
 			opts.limit = request.opts.backfill_limit;
 			opts.limit = opts.limit?: size_t(backfill_limit_default);
 			opts.event_id = request.opts.event_id;
-			request.future = std::make_unique<fed::backfill>
+			return std::make_unique<fed::backfill>
 			(
 				request.opts.room_id,
-				request.buf,
+				buf,
 				std::move(opts)
 			);
-
-			break;
 		}
 	}
 
+	return {};
+}
+
+/// Start a duplicate of the current attempt to another server in the room.
+/// Whichever responds first is handled; the other is canceled.
+bool
+ircd::m::fetch::hedge(request &request)
+try
+{
+	assert(!request.finished);
+	assert(request.future && !request.hedge);
+	if(request.opts.attempt_limit)
+		if(request.attempted.size() >= request.opts.attempt_limit)
+			return false;
+
+	// The selection is made into the attempted set as usual but the origin
+	// of the current attempt is restored.
+	const string_view origin
+	{
+		request.origin
+	};
+
+	request.hedge_origin = select_random_remote(request)?
+		request.origin:
+		string_view{};
+
+	request.origin = origin;
+	if(!request.hedge_origin)
+		return false;
+
+	if(!size(request.hedge_buf))
+		request.hedge_buf = server::pooled_buffer
+		{
+			size(request.buf)
+		};
+
+	request.hedge = submit(request, request.hedge_origin, request.hedge_buf);
+
 	log::debug
 	{
-		log, "Starting %s request for %s in %s from '%s'",
+		log, "Hedging %s request for %s in %s from '%s' after '%s'",
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		request.hedge_origin,
+		request.origin,
 	};
 
 	dock.notify_all();
 	return true;
 }
-catch(const m::UNAVAILABLE &e)
-{
-	throw;
-}
 catch(const ctx::interrupted &e)
 {
 	throw;
 }
-catch(const http::error &e)
+catch(const std::exception &e)
 {
 	log::derror
 	{
-		log, "Starting %s request for %s in %s to '%s' :%s %s",
+		log, "Hedging %s request for %s in %s to '%s' :%s",
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		request.hedge_origin,
 		e.what(),
-		e.content,
 	};
 
+	request.hedge.reset(nullptr);
+	request.hedge_origin = {};
 	return false;
 }
-catch(const server::error &e)
+
+/// Swap the hedged attempt into the place of the current attempt.
+void
+ircd::m::fetch::hedge_promote(request &request)
 {
-	log::derror
+	assert(request.hedge);
+	std::swap(request.future, request.hedge);
+	std::swap(request.origin, request.hedge_origin);
+	std::swap(request.buf, request.hedge_buf);
+}
+
+/// The hedge is made after some multiple of the remote's average latency
+/// as an estimate of its tail latency; without any measurement the maximum
+/// delay is used.
+ircd::milliseconds
+ircd::m::fetch::hedge_delay(const request &request,
+                            const string_view &remote)
+{
+	const auto rtt
 	{
-		log, "Starting %s request for %s in %s to '%s' :%s",
-		reflect(request.opts.op),
-		string_view{request.opts.event_id},
-		string_view{request.opts.room_id},
-		string_view{request.origin},
-		e.what(),
+		duration_cast<milliseconds>(fed::rtt(remote))
 	};
 
-	return false;
-}
-catch(const std::exception &e)
-{
-	log::error
+	const milliseconds estimate
 	{
-		log, "Starting %s request for %s in %s to '%s' :%s",
-		reflect(request.opts.op),
-		string_view{request.opts.event_id},
-		string_view{request.opts.room_id},
-		string_view{request.origin},
-		e.what()
+		rtt.count()?
+			rtt * long(hedge_rtt_factor):
+			milliseconds(hedge_delay_max)
 	};
 
-	return false;
+	return std::clamp
+	(
+		estimate,
+		milliseconds(hedge_delay_min),
+		milliseconds(hedge_delay_max)
+	);
 }
 
 bool
@@ -578,20 +855,48 @@ ircd::m::fetch::select_random_remote(request &request)
 		return proffer_remote(request, remote);
 	}};
 
-	// copies randomly selected remote into the attempted set.
-	const auto closure{[&request](const string_view &remote)
-	{
-		select_remote(request, remote);
-	}};
-
 	const m::room::origins origins
 	{
 		request.opts.room_id
 	};
 
-	// Select a random server in the room
+	// Select two random servers in the room and take the one with the lower
+	// observed latency; an unmeasured remote is not penalized so it still
+	// gets the chance to be measured (power of two choices).
+	char buf[2][rfc3986::DOMAIN_BUFSIZE];
+	const string_view first
+	{
+		origins.random(buf[0], proffer)
+	};
+
+	const string_view choice[2]
+	{
+		first,
+		origins.random(buf[1], [&proffer, &first](const string_view &remote)
+		{
+			return remote != first && proffer(remote);
+		}),
+	};
+
 	request.origin = {};
-	if(origins.random(closure, proffer))
+	if(choice[0] && choice[1])
+	{
+		const microseconds rtt[2]
+		{
+			fed::rtt(choice[0]),
+			fed::rtt(choice[1]),
+		};
+
+		const bool second
+		{
+			rtt[0].count() && (!rtt[1].count() || rtt[1] < rtt[0])
+		};
+
+		if(select_remote(request, choice[second]))
+			return true;
+	}
+
+	if(choice[0] && select_remote(request, choice[0]))
 		return true;
 
 	// If nothing found attempt hosts from mxids
@@ -726,6 +1031,17 @@ try
 
 	request.eptr = std::exception_ptr{};
 	request.origin = {};
+	request.hedge_at = {};
+
+	// An outstanding hedge becomes the current attempt rather than starting
+	// yet another one.
+	if(request.hedge)
+	{
+		hedge_promote(request);
+		request.last = ircd::now<system_point>();
+		return;
+	}
+
 	start(request);
 }
 catch(...)
@@ -738,6 +1054,12 @@ void
 ircd::m::fetch::finish(request &request)
 {
 	request.finished = ircd::now<system_point>();
+	if(request.hedge)
+	{
+		server::cancel(*request.hedge);
+		request.hedge.reset(nullptr);
+		request.hedge_origin = {};
+	}
 
 	#if 0
 	log::logf
@@ -776,14 +1098,33 @@ namespace ircd::m::fetch
 	static void check_response__backfill(const request &, const json::object &);
 	static void check_response__event(const request &, const json::object &);
 	static void check_response__auth(const request &, const json::object &);
+	static void check_response__pdus(const request &, const json::array &);
 
+	extern conf::item<bool> check_batch;
 	extern conf::item<bool> check_event_id;
 	extern conf::item<bool> check_conforms;
 	extern conf::item<bool> check_signature;
 	extern conf::item<bool> check_hashes;
 	extern conf::item<bool> check_authoritative_redaction;
+	extern conf::item<bool> check_offload;
 }
 
+decltype(ircd::m::fetch::check_offload)
+ircd::m::fetch::check_offload
+{
+	{ "name",     "ircd.m.fetch.check.offload" },
+	{ "default",  true                         },
+	{ "help",     "Conduct the event_id and hash checks on an offload thread." },
+};
+
+decltype(ircd::m::fetch::check_batch)
+ircd::m::fetch::check_batch
+{
+	{ "name",     "ircd.m.fetch.check.batch" },
+	{ "default",  true                       },
+	{ "help",     "Hash all events of a backfill or auth_chain response at once." },
+};
+
 decltype(ircd::m::fetch::check_event_id)
 ircd::m::fetch::check_event_id
 {
@@ -867,6 +1208,9 @@ ircd::m::fetch::check_response__auth(const request &request,
 		response.at("auth_chain")
 	};
 
+	if(check_batch)
+		return check_response__pdus(request, auth_chain);
+
 	for(const json::object auth_event : auth_chain)
 	{
 		m::event::id::buf event_id;
@@ -905,6 +1249,9 @@ ircd::m::fetch::check_response__backfill(const request &request,
 		response.at("pdus")
 	};
 
+	if(check_batch)
+		return check_response__pdus(request, pdus);
+
 	for(const json::object event : pdus)
 	{
 		m::event::id::buf event_id;
@@ -917,65 +1264,228 @@ ircd::m::fetch::check_response__backfill(const request &request,
 	}
 }
 
+/// The reference hash and the content hash of every event in the response
+/// are computed by one sha256::batch(), which may take a large response to
+/// an OpenCL device. Each event_id is made from its reference hash rather
+/// than hashed again by the event's construction and by its checks.
 void
-ircd::m::fetch::_check_event(const request &request,
-                             const m::event &event)
+ircd::m::fetch::check_response__pdus(const request &request,
+                                     const json::array &pdus)
 {
-	if(request.opts.check_event_id && check_event_id && !m::check_id(event))
+	const std::vector<json::object> sources
+	{
+		std::begin(pdus), std::end(pdus)
+	};
+
+	const size_t count
+	{
+		sources.size()
+	};
+
+	size_t total(0);
+	for(const auto &source : sources)
+		total += size(string_view{source});
+
+	// Preimages don't exceed their source but for the canonical form of a
+	// few numbers and escapes; on overflow the slow path is taken.
+	const unique_mutable_buffer buf
+	{
+		2 * (total + count * 64)
+	};
+
+	const unique_mutable_buffer digests
+	{
+		2 * count * sha256::digest_size
+	};
+
+	std::vector<const_buffer> preimage(2 * count);
+	const auto compose{[&]
 	{
-		event::id::buf buf;
-		const m::event &claim
+		thread_local char content_buf[m::event::MAX_SIZE];
+		mutable_buffer out{buf};
+		for(size_t i(0); i < count; ++i)
 		{
-			buf, event.source
-		};
+			const m::event event
+			{
+				sources[i], m::event::id{}
+			};
+
+			// Reference hashes are only needed for ids not in the source.
+			if(!sources[i].has("event_id"))
+			{
+				const m::event essential
+				{
+					m::essential(event, content_buf)
+				};
+
+				preimage[i * 2 + 0] = json::stringify(out, essential);
+			}
+
+			preimage[i * 2 + 1] = m::event::preimage(out, sources[i]);
+			consume(out, size(preimage[i * 2 + 1]));
+		}
+
+		sha256::batch(digests, preimage);
+	}};
+
+	try
+	{
+		if(check_offload && ctx::current)
+		{
+			static const ctx::ole::opts opts
+			{
+				"m.fetch.check"
+			};
 
-		throw ircd::error
+			ctx::offload(opts, compose);
+		}
+		else compose();
+	}
+	catch(const std::exception &e)
+	{
+		log::dwarning
 		{
-			"event::id claim:%s != sought:%s",
-			string_view{claim.event_id},
-			string_view{request.opts.event_id},
+			log, "Batch check of %zu events in %s :%s",
+			count,
+			string_view{request.opts.room_id},
+			e.what(),
 		};
+
+		for(const auto &source : sources)
+		{
+			m::event::id::buf event_id;
+			const m::event event
+			{
+				event_id, source
+			};
+
+			_check_event(request, event);
+		}
+
+		return;
 	}
 
-	if(request.opts.check_conforms && check_conforms)
+	for(size_t i(0); i < count; ++i)
 	{
-		m::event::conforms conforms
+		const auto digest{[&digests](const size_t &j)
+		{
+			return sha256::buf
+			{
+				const_buffer
+				{
+					data(digests) + j * sha256::digest_size, sha256::digest_size
+				}
+			};
+		}};
+
+		m::event::id::buf event_id_buf;
+		const m::event::id event_id
 		{
-			event
+			sources[i].has("event_id")?
+				m::event::id{json::string(sources[i].at("event_id"))}:
+				make_id(m::event{sources[i], m::event::id{}}, "4", event_id_buf, digest(i * 2 + 0))
 		};
 
-		const bool mismatch_hashes
+		const m::event event
 		{
-			check_hashes
-			&& request.opts.check_hashes
-			&& conforms.has(m::event::conforms::MISMATCH_HASHES)
+			sources[i], event_id
 		};
 
-		const bool authoritative_redaction
+		const sha256::buf hash
 		{
-			check_authoritative_redaction
-			&& request.opts.authoritative_redaction
-			&& mismatch_hashes
-			&& json::get<"origin"_>(event) == request.origin
+			digest(i * 2 + 1)
 		};
 
-		if(authoritative_redaction || !mismatch_hashes)
-			conforms.del(m::event::conforms::MISMATCH_HASHES);
+		_check_event(request, event, &hash);
+	}
+}
 
-		thread_local char buf[128];
-		const string_view failures
+void
+ircd::m::fetch::_check_event(const request &request,
+                             const m::event &event,
+                             const sha256::buf *const &hash)
+{
+	// The reference hash, content hash and conformity checks are pure
+	// computation on the response which is held on this stack. A caller
+	// supplying the content hash made the event_id from the same batch.
+	const auto check{[&request, &event, &hash]
+	{
+		if(!hash && request.opts.check_event_id && check_event_id && !m::check_id(event))
 		{
-			conforms.string(buf)
-		};
+			event::id::buf buf;
+			const m::event &claim
+			{
+				buf, event.source
+			};
 
-		assert(failures || conforms.clean());
-		if(!conforms.clean())
 			throw ircd::error
 			{
-				"Non-conforming event in response :%s",
-				failures,
+				"event::id claim:%s != sought:%s",
+				string_view{claim.event_id},
+				string_view{request.opts.event_id},
+			};
+		}
+
+		if(request.opts.check_conforms && check_conforms)
+		{
+			static const uint64_t hashed
+			{
+				(1UL << m::event::conforms::MISMATCH_EVENT_ID) |
+				(1UL << m::event::conforms::MISMATCH_HASHES)
+			};
+
+			m::event::conforms conforms
+			{
+				event, hash? hashed: 0UL
+			};
+
+			if(hash && !empty(json::get<"hashes"_>(event)) && !m::verify_hash(event, *hash))
+				conforms.set(m::event::conforms::MISMATCH_HASHES);
+
+			const bool mismatch_hashes
+			{
+				check_hashes
+				&& request.opts.check_hashes
+				&& conforms.has(m::event::conforms::MISMATCH_HASHES)
+			};
+
+			const bool authoritative_redaction
+			{
+				check_authoritative_redaction
+				&& request.opts.authoritative_redaction
+				&& mismatch_hashes
+				&& json::get<"origin"_>(event) == request.origin
 			};
+
+			if(authoritative_redaction || !mismatch_hashes)
+				conforms.del(m::event::conforms::MISMATCH_HASHES);
+
+			thread_local char buf[128];
+			const string_view failures
+			{
+				conforms.string(buf)
+			};
+
+			assert(failures || conforms.clean());
+			if(!conforms.clean())
+				throw ircd::error
+				{
+					"Non-conforming event in response :%s",
+					failures,
+				};
+		}
+	}};
+
+	if(check_offload && ctx::current && !hash)
+	{
+		static const ctx::ole::opts opts
+		{
+			"m.fetch.check"
+		};
+
+		ctx::offload(opts, check);
 	}
+	else check();
 
 	// only check signature for v1 events
 	if(request.opts.check_signature && check_signature && request.opts.event_id.version() == "1")
@@ -1130,5 +1640,6 @@ ircd::m::fetch::request::~request()
 noexcept
 {
 	//TODO: bad things unless this first here
+	hedge.reset(nullptr);
 	future.reset(nullptr);
 }
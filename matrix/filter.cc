@@ -13,6 +13,46 @@
 // m/filter.h
 //
 
+//TODO: tribool for contains_url; we currently ignore the false value.
+bool
+ircd::m::match(const compiled_filter &filter,
+               const event &event)
+noexcept
+{
+	if(!filter.flags)
+		return true;
+
+	if(filter.has(filter.CONTAINS_URL))
+		if(!json::get<"content"_>(event).has("url"))
+			return false;
+
+	if(filter.has(filter.NOT_ROOMS))
+		if(filter.not_rooms.has(json::get<"room_id"_>(event)))
+			return false;
+
+	if(filter.has(filter.ROOMS))
+		if(!filter.rooms.has(json::get<"room_id"_>(event)))
+			return false;
+
+	if(filter.has(filter.NOT_SENDERS))
+		if(filter.not_senders.has(json::get<"sender"_>(event)))
+			return false;
+
+	if(filter.has(filter.NOT_TYPES))
+		if(filter.not_types.has(json::get<"type"_>(event)))
+			return false;
+
+	if(filter.has(filter.SENDERS))
+		if(!filter.senders.has(json::get<"sender"_>(event)))
+			return false;
+
+	if(filter.has(filter.TYPES))
+		if(!filter.types.has(json::get<"type"_>(event)))
+			return false;
+
+	return true;
+}
+
 //TODO: globular expression
 //TODO: tribool for contains_url; we currently ignore the false value.
 bool
@@ -76,6 +116,160 @@ noexcept
 	return true;
 }
 
+//
+// compiled_filter
+//
+
+namespace ircd::m
+{
+	template<class room_filter_type>
+	static void compile_room_filter(compiled_filter &, const room_filter_type &);
+}
+
+ircd::m::compiled_filter::compiled_filter(const room_event_filter &filter)
+:compiled_filter
+{
+	event_filter{filter}
+}
+{
+	compile_room_filter(*this, filter);
+}
+
+ircd::m::compiled_filter::compiled_filter(const state_filter &filter)
+:compiled_filter
+{
+	event_filter{filter}
+}
+{
+	compile_room_filter(*this, filter);
+}
+
+ircd::m::compiled_filter::compiled_filter(const event_filter &filter)
+:limit
+{
+	json::get<"limit"_>(filter)
+}
+,types
+{
+	json::get<"types"_>(filter), true
+}
+,not_types
+{
+	json::get<"not_types"_>(filter), true
+}
+,senders
+{
+	json::get<"senders"_>(filter)
+}
+,not_senders
+{
+	json::get<"not_senders"_>(filter)
+}
+{
+	flags |= TYPES & boolmask<uint>(!empty(json::get<"types"_>(filter)));
+	flags |= NOT_TYPES & boolmask<uint>(!empty(json::get<"not_types"_>(filter)));
+	flags |= SENDERS & boolmask<uint>(!empty(json::get<"senders"_>(filter)));
+	flags |= NOT_SENDERS & boolmask<uint>(!empty(json::get<"not_senders"_>(filter)));
+}
+
+template<class room_filter_type>
+void
+ircd::m::compile_room_filter(compiled_filter &ret,
+                             const room_filter_type &filter)
+{
+	using flag = compiled_filter::flag;
+
+	ret.rooms = compiled_filter::set{json::get<"rooms"_>(filter)};
+	ret.not_rooms = compiled_filter::set{json::get<"not_rooms"_>(filter)};
+	ret.flags |= flag::ROOMS & boolmask<uint>(!empty(json::get<"rooms"_>(filter)));
+	ret.flags |= flag::NOT_ROOMS & boolmask<uint>(!empty(json::get<"not_rooms"_>(filter)));
+	ret.flags |= flag::CONTAINS_URL & boolmask<uint>(json::get<"contains_url"_>(filter) == true);
+	ret.flags |= flag::LAZY_LOAD & boolmask<uint>(json::get<"lazy_load_members"_>(filter) == true);
+	ret.flags |= flag::REDUNDANT & boolmask<uint>(json::get<"include_redundant_members"_>(filter) == true);
+}
+
+//
+// compiled_filter::set
+//
+
+ircd::m::compiled_filter::set::set(const json::array &array,
+                                   const bool &patterns)
+{
+	for(const json::string str : array)
+	{
+		const auto star
+		{
+			str.find('*')
+		};
+
+		if(!patterns || star == str.npos)
+			exact.emplace_back(str);
+
+		else if(star == size(str) - 1)
+			prefix.emplace_back(rstrip(str, '*'));
+
+		else
+			glob.emplace_back(str);
+	}
+
+	std::sort(begin(exact), end(exact));
+	exact.erase(std::unique(begin(exact), end(exact)), end(exact));
+}
+
+bool
+ircd::m::compiled_filter::set::has(const string_view &str)
+const noexcept
+{
+	if(std::binary_search(begin(exact), end(exact), str))
+		return true;
+
+	for(const auto &prefix : this->prefix)
+		if(startswith(str, prefix))
+			return true;
+
+	for(const auto &glob : this->glob)
+		if(globular_imatch(glob)(str))
+			return true;
+
+	return false;
+}
+
+//
+// user::filter::cached
+//
+
+ircd::m::user::filter::cached::cached(std::string content_)
+:content
+{
+	std::move(content_)
+}
+,filter
+{
+	json::object{content}
+}
+,timeline
+{
+	json::get<"timeline"_>(json::get<"room"_>(filter))
+}
+,state
+{
+	json::get<"state"_>(json::get<"room"_>(filter))
+}
+,ephemeral
+{
+	json::get<"ephemeral"_>(json::get<"room"_>(filter))
+}
+,account_data
+{
+	json::get<"account_data"_>(json::get<"room"_>(filter))
+}
+,presence
+{
+	json::get<"presence"_>(filter)
+}
+{
+}
+
 //
 // filter
 //
@@ -14,8 +14,24 @@ namespace ircd::m
 
 	extern conf::item<std::string> online_status_msg;
 	extern conf::item<std::string> offline_status_msg;
+	extern conf::item<bool> mods_lazy;
 }
 
+decltype(ircd::m::mods_lazy)
+ircd::m::mods_lazy
+{
+	{ "name",     "ircd.m.mods.lazy" },
+	{ "default",  false              },
+	{ "persist",  false              },
+	{ "description",
+
+	R"(
+	Defer loading the rarely used modules (media, identity) until a request
+	is first made for one of their resources. Shortens startup; the first
+	such request pays for the load instead.
+	)"},
+};
+
 // Linkage for the container of all active clients for iteration purposes.
 template<>
 decltype(ircd::util::instance_multimap<ircd::string_view, ircd::m::homeserver, std::less<>>::map)
@@ -219,7 +235,7 @@ try
 }
 ,opts{[this, &opts]
 {
-	primary = primary?: this; //TODO: xxx
+	primary = primary?: this;
 	return opts;
 }()}
 ,key
@@ -228,7 +244,11 @@ try
 }
 ,database
 {
-	std::make_shared<dbs::init>(opts->server_name)
+	// Tenants share the primary's database and with it the block cache,
+	// event caches and everything else keyed off the one dataset.
+	primary != this?
+		primary->database:
+		std::make_shared<dbs::init>(opts->server_name)
 }
 ,self
 {
@@ -238,14 +258,45 @@ try
 {
 	std::make_unique<struct conf>(*opts)
 }
-,modules
+,stats
 {
-	begin(matrix::module_names), end(matrix::module_names)
+	std::make_unique<struct stats>(*opts)
 }
+,modules{[this]
+{
+	// Modules are loaded once for the process by the primary.
+	if(primary != this)
+		return decltype(modules){};
+
+	return decltype(modules)
+	{
+		begin(matrix::module_names), end(matrix::module_names)
+	};
+}()}
 {
+	if(primary != this)
+		return tenant();
+
 	if(ircd::mods::autoload)
 		for(const auto &name : modules)
+		{
+			const auto lazy
+			{
+				std::find_if(begin(matrix::module_names_lazy), end(matrix::module_names_lazy), [&name]
+				(const auto &pair)
+				{
+					return pair.first == name;
+				})
+			};
+
+			if(mods_lazy && lazy != end(matrix::module_names_lazy))
+			{
+				ircd::resource::lazy.emplace(lazy->second, lazy->first);
+				continue;
+			}
+
 			mods::imports.emplace(std::string{name}, name);
+		}
 
 	if(conf && !ircd::defaults)
 		conf->load();
@@ -287,6 +338,9 @@ try
 
 	if(!ircd::maintenance && opts->backfill)
 		m::init::backfill::init();
+
+	if(!ircd::maintenance && opts->backfill)
+		m::init::horizon::init();
 }
 catch(const std::exception &e)
 {
@@ -300,15 +354,55 @@ catch(const std::exception &e)
 	};
 }
 
+/// Startup of an additional homeserver after the primary. Everything shared
+/// for the process is already running; this only brings up what is specific
+/// to the origin.
+void
+ircd::m::homeserver::tenant()
+{
+	assert(primary && primary != this);
+	const m::room::id::buf my_room_id
+	{
+		"ircd", origin(*this)
+	};
+
+	if(!exists(my_room_id) && !ircd::read_only)
+		bootstrap();
+
+	if(!ircd::write_avoid)
+		if(key && !key->verify_keys.empty())
+			m::keys::cache::set(key->verify_keys);
+
+	if(!ircd::maintenance)
+		signon(*this);
+
+	log::notice
+	{
+		log, "Hosting %s for network %s alongside %s",
+		server_name(*this),
+		origin(*this),
+		origin(*primary),
+	};
+}
+
 ircd::m::homeserver::~homeserver()
 noexcept try
 {
-	///TODO: XXX primary
+	// Tenants leave the process-wide subsystems to the primary.
+	if(primary != this)
+	{
+		if(!ircd::maintenance && _vm)
+			signoff(*this);
+
+		return;
+	}
+
 	server::init::interrupt();
 	client::terminate_all();         //TODO: XXX
 	server::init::close();
 	client::close_all();
 	m::init::backfill::fini();
+	m::init::horizon::fini();
 	client::wait_all();
 	server::init::wait();
 	m::sync::pool.join();
@@ -340,6 +434,10 @@ catch(const std::exception &e)
 ircd::m::homeserver::modules::~modules()
 noexcept
 {
+	if(empty())
+		return;
+
+	ircd::resource::lazy.clear();
 	for(auto rit(std::rbegin(*this)); rit != std::rend(*this); ++rit)
 		mods::imports.erase(*rit);
 }
@@ -493,6 +591,51 @@ ircd::m::homeserver::key::key(const struct opts &opts)
 	};
 }
 
+//
+// homeserver::stats
+//
+
+namespace ircd::m
+{
+	static thread_local char homeserver_stats_name_buf[128];
+	static string_view homeserver_stats_name(const string_view &origin, const string_view &key);
+}
+
+ircd::string_view
+ircd::m::homeserver_stats_name(const string_view &origin,
+                               const string_view &key)
+{
+	return fmt::sprintf
+	{
+		homeserver_stats_name_buf, "ircd.m.homeserver.%s.%s",
+		origin,
+		key,
+	};
+}
+
+ircd::m::homeserver::stats::stats(const struct opts &opts)
+:events
+{
+	{ "name", homeserver_stats_name(opts.origin, "events") },
+}
+,requests
+{
+	{ "name", homeserver_stats_name(opts.origin, "requests") },
+}
+,event_committed
+{
+	[this](const m::event &event, vm::eval &eval)
+	{
+		++events;
+	},
+	{
+		{ "_site",   "vm.effect"  },
+		{ "origin",  opts.origin  },
+	}
+}
+{
+}
+
 //
 // homeserver::conf
 //
@@ -524,7 +667,9 @@ ircd::m::homeserver::conf::conf(const struct opts &opts)
 {
 	ircd::conf::on_init, [this](ircd::conf::item<> &item)
 	{
-		handle_item_init(room, item);
+		// Only the primary homeserver controls the global conf items.
+		if(homeserver::primary && origin(*homeserver::primary) == room_id.host())
+			handle_item_init(room, item);
 	}
 }
 ,conf_updated
@@ -22,7 +22,7 @@ try
 	if(opts->bootstrap_vector_path)
 		return bootstrap_event_vector(*this);
 
-	assert(db::sequence(*dbs::events) == 0);
+	assert(db::sequence(*dbs::events) == 0 || primary != this);
 	assert(this->self);
 	const m::user::id &my_id
 	{
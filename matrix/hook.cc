@@ -12,6 +12,7 @@
 namespace ircd::m
 {
 	static bool _hook_match(const m::event &matching, const m::event &);
+	static size_t _hook_matchers(const m::event &matching);
 	static void _hook_fix_state_key(const json::members &, json::member &);
 	static void _hook_fix_room_id(const json::members &, json::member &);
 	static void _hook_fix_sender(const json::members &, json::member &);
@@ -48,13 +49,14 @@ ircd::util::instance_list<ircd::m::hook::base>::list
 // hook::maps
 //
 
+/// Index of a site's hooks by the event type they match. Hooks which don't
+/// specify a type are in the wildcard bucket. Dispatch only considers the
+/// bucket of the event's type and the wildcard bucket, rather than every hook
+/// registered to the site; each bucket is kept sorted so the call order is
+/// the same as if all hooks had been considered together.
 struct ircd::m::hook::maps
 {
-	std::multimap<string_view, base *> origin;
-	std::multimap<string_view, base *> room_id;
-	std::multimap<string_view, base *> sender;
-	std::multimap<string_view, base *> state_key;
-	std::multimap<string_view, base *> type;
+	std::map<std::string, std::vector<base *>, std::less<>> type;
 	std::vector<base *> always;
 
 	size_t match(const event &match, const std::function<bool (base &)> &) const;
@@ -78,34 +80,24 @@ size_t
 ircd::m::hook::maps::add(base &hook,
                          const event &matching)
 {
-	size_t ret{0};
-	const auto map{[&hook, &ret]
-	(auto &map, const string_view &value)
+	const size_t ret
 	{
-		map.emplace(value, &hook);
-		++ret;
-	}};
-
-	if(json::get<"origin"_>(matching))
-		map(origin, at<"origin"_>(matching));
-
-	if(json::get<"room_id"_>(matching))
-		map(room_id, at<"room_id"_>(matching));
-
-	if(json::get<"sender"_>(matching))
-		map(sender, at<"sender"_>(matching));
-
-	if(json::get<"state_key"_>(matching))
-		map(state_key, at<"state_key"_>(matching));
+		_hook_matchers(matching)
+	};
 
-	if(json::get<"type"_>(matching))
-		map(type, at<"type"_>(matching));
+	auto &bucket
+	{
+		json::get<"type"_>(matching)?
+			type[std::string(at<"type"_>(matching))]:
+			always
+	};
 
-	// Hook had no mappings which means it will match everything.
-	// We don't increment the matcher count for this case.
-	if(!ret)
-		always.emplace_back(&hook);
+	const auto it
+	{
+		std::lower_bound(begin(bucket), end(bucket), &hook)
+	};
 
+	bucket.emplace(it, &hook);
 	return ret;
 }
 
@@ -113,37 +105,40 @@ size_t
 ircd::m::hook::maps::del(base &hook,
                          const event &matching)
 {
-	size_t ret{0};
-	const auto unmap{[&hook, &ret]
-	(auto &map, const string_view &value)
+	const size_t ret
 	{
-		auto pit{map.equal_range(value)};
-		while(pit.first != pit.second)
-			if(pit.first->second == &hook)
-			{
-				pit.first = map.erase(pit.first);
-				++ret;
-			}
-			else ++pit.first;
-	}};
+		_hook_matchers(matching)
+	};
 
-	// Unconditional attempt to remove from always.
-	std::remove(begin(always), end(always), &hook);
+	const auto unmap{[&hook]
+	(auto &bucket)
+	{
+		const auto it
+		{
+			std::lower_bound(begin(bucket), end(bucket), &hook)
+		};
 
-	if(json::get<"origin"_>(matching))
-		unmap(origin, at<"origin"_>(matching));
+		if(it != end(bucket) && *it == &hook)
+			bucket.erase(it);
+	}};
 
-	if(json::get<"room_id"_>(matching))
-		unmap(room_id, at<"room_id"_>(matching));
+	if(!json::get<"type"_>(matching))
+	{
+		unmap(always);
+		return ret;
+	}
 
-	if(json::get<"sender"_>(matching))
-		unmap(sender, at<"sender"_>(matching));
+	const auto it
+	{
+		type.find(at<"type"_>(matching))
+	};
 
-	if(json::get<"state_key"_>(matching))
-		unmap(state_key, at<"state_key"_>(matching));
+	if(it == end(type))
+		return ret;
 
-	if(json::get<"type"_>(matching))
-		unmap(type, at<"type"_>(matching));
+	unmap(it->second);
+	if(it->second.empty())
+		type.erase(it);
 
 	return ret;
 }
@@ -153,46 +148,41 @@ ircd::m::hook::maps::match(const event &event,
                            const std::function<bool (base &)> &callback)
 const
 {
-	std::set<base *> matching
+	static const std::vector<base *> empty;
+	const auto it
 	{
-		begin(always), end(always)
+		json::get<"type"_>(event)?
+			type.find(at<"type"_>(event)):
+			end(type)
 	};
 
-	const auto site_match{[&matching]
-	(auto &map, const string_view &key)
+	const auto &typed
 	{
-		auto pit{map.equal_range(key)};
-		for(; pit.first != pit.second; ++pit.first)
-			matching.emplace(pit.first->second);
-	}};
-
-	if(json::get<"origin"_>(event))
-		site_match(origin, at<"origin"_>(event));
-
-	if(json::get<"room_id"_>(event))
-		site_match(room_id, at<"room_id"_>(event));
-
-	if(json::get<"sender"_>(event))
-		site_match(sender, at<"sender"_>(event));
-
-	if(json::get<"type"_>(event))
-		site_match(type, at<"type"_>(event));
-
-	if(json::get<"state_key"_>(event))
-		site_match(state_key, at<"state_key"_>(event));
+		it != end(type)? it->second: empty
+	};
 
-	auto it(begin(matching));
-	while(it != end(matching))
-	{
-		const base &hook(**it);
-		if(!_hook_match(hook.matching, event))
-			it = matching.erase(it);
-		else
-			++it;
-	}
+	// Matching hooks are gathered before any is called, because a hook may
+	// add or remove hooks to this site while it's being called.
+	std::vector<base *> matching;
+	matching.reserve(typed.size() + always.size());
+	std::set_union
+	(
+		begin(typed), end(typed),
+		begin(always), end(always),
+		std::back_inserter(matching)
+	);
+
+	const auto last
+	{
+		std::remove_if(begin(matching), end(matching), [&event]
+		(const base *const &hook)
+		{
+			return !_hook_match(hook->matching, event);
+		})
+	};
 
 	size_t ret{0};
-	for(auto it(begin(matching)); it != end(matching); ++it, ++ret)
+	for(auto it(begin(matching)); it != last; ++it, ++ret)
 		if(!callback(**it))
 			return ret;
 
@@ -683,6 +673,19 @@ ircd::m::_hook_fix_state_key(const json::members &members,
 	validate(id::USER, member.second);
 }
 
+/// Number of the match parameters given by a hook's feature.
+size_t
+ircd::m::_hook_matchers(const m::event &matching)
+{
+	return 0
+	+ bool(json::get<"origin"_>(matching))
+	+ bool(json::get<"room_id"_>(matching))
+	+ bool(json::get<"sender"_>(matching))
+	+ bool(json::get<"state_key"_>(matching))
+	+ bool(json::get<"type"_>(matching))
+	;
+}
+
 bool
 ircd::m::_hook_match(const m::event &matching,
                      const m::event &event)
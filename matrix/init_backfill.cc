@@ -10,7 +10,11 @@
 
 namespace ircd::m::init::backfill
 {
+	struct queued;
+
 	void handle_room(const room::id &);
+	bool resumed(const room::id &);
+	void progress(const room::id &);
 	void worker();
 
 	extern size_t count, complete;
@@ -24,6 +28,10 @@ namespace ircd::m::init::backfill
 	extern conf::item<size_t> viewports;
 	extern conf::item<size_t> attempt_max;
 	extern conf::item<size_t> pool_size;
+	extern conf::item<seconds> resume;
+	extern conf::item<seconds> recent;
+	extern conf::item<size_t> remote_max;
+	extern conf::item<milliseconds> interval;
 	extern conf::item<bool> enable;
 	extern log::log log;
 };
@@ -90,6 +98,73 @@ ircd::m::init::backfill::attempt_max
 	{ "default",  8L                                  },
 };
 
+decltype(ircd::m::init::backfill::resume)
+ircd::m::init::backfill::resume
+{
+	{ "name",     "ircd.m.init.backfill.resume" },
+	{ "default",  6 * 60 * 60L                  },
+	{ "description",
+
+	R"(
+	Rooms which completed their initial backfill within this many seconds
+	(i.e. before a restart) are not backfilled again. 0 backfills all rooms
+	on every start.
+	)"},
+};
+
+decltype(ircd::m::init::backfill::recent)
+ircd::m::init::backfill::recent
+{
+	{ "name",     "ircd.m.init.backfill.recent" },
+	{ "default",  24 * 60 * 60L                 },
+	{ "description",
+
+	R"(
+	Rooms with an event within this many seconds are backfilled first;
+	after them rooms are ordered by the count of our joined members.
+	)"},
+};
+
+decltype(ircd::m::init::backfill::remote_max)
+ircd::m::init::backfill::remote_max
+{
+	{ "name",     "ircd.m.init.backfill.remote_max" },
+	{ "default",  4L                                },
+	{ "description",
+
+	R"(
+	Maximum number of rooms created by the same server being backfilled at
+	once, so a server hosting many of our rooms is not stormed.
+	)"},
+};
+
+decltype(ircd::m::init::backfill::interval)
+ircd::m::init::backfill::interval
+{
+	{ "name",     "ircd.m.init.backfill.interval" },
+	{ "default",  250L                            },
+	{ "description",
+
+	R"(
+	Milliseconds between starting the backfill of each room, spreading the
+	work over time after startup.
+	)"},
+};
+
+/// Room admitted to the backfill; ordered by its priority.
+struct ircd::m::init::backfill::queued
+{
+	std::string room_id;
+	bool recent {false};
+	size_t local {0};
+	time_t ts {0};
+
+	bool operator<(const queued &o) const
+	{
+		return std::tie(o.recent, o.local, o.ts) < std::tie(recent, local, ts);
+	}
+};
+
 decltype(ircd::m::init::backfill::count)
 ircd::m::init::backfill::count;
 
@@ -168,7 +243,7 @@ try
 
 	// Set a low priority for this context; see related pool_opts
 	ionice(ctx::cur(), 4);
-	nice(ctx::cur(), 4);
+	nice(ctx::cur(), ctx::sched::BACKGROUND);
 
 	// Prepare to iterate all of the rooms this server is aware of which
 	// contain at least one member from another server in any state, and
@@ -207,7 +282,7 @@ try
 		true,                  // queue max blocking
 		true,                  // queue max warning
 		3,                     // ionice
-		3,                     // nice
+		int8_t(ctx::sched::BACKGROUND),
 	};
 
 	ctx::pool pool
@@ -220,40 +295,104 @@ try
 		backfill::worker_pool, std::addressof(pool)
 	};
 
-	// Iterate the room_id's, submitting a copy of each to the next pool
-	// worker; the submission blocks when all pool workers are busy, as per
-	// the pool::opts.
-	ctx::dock dock;
-	const ctx::uninterruptible ui;
-	rooms::for_each(opts, [&pool, &estimate, &dock]
+	const m::room::id::buf progress_room_id
+	{
+		"backfill", my_host()
+	};
+
+	if(!exists(progress_room_id))
+		create(progress_room_id, me());
+
+	// Collect and order the room_id's before anything is submitted; rooms
+	// completed before a recent restart are skipped.
+	std::vector<queued> queue;
+	const auto now
+	{
+		ircd::time<milliseconds>()
+	};
+
+	const milliseconds recency
+	{
+		seconds(recent)
+	};
+
+	rooms::for_each(opts, [&queue, &now, &recency]
 	(const room::id &room_id)
 	{
 		if(unlikely(ctx::interruption_requested()))
 			return false;
 
+		if(resumed(room_id))
+			return true;
+
+		queued q;
+		q.room_id = room_id;
+		q.local = m::room::members(room_id).count("join", my_host());
+		m::get(std::nothrow, std::get<event::idx>(m::top(std::nothrow, room_id)), "origin_server_ts", q.ts);
+		q.recent = now - q.ts < recency.count();
+		queue.emplace_back(std::move(q));
+		return true;
+	});
+
+	std::sort(begin(queue), end(queue));
+	log::info
+	{
+		log, "Initial backfill of %zu rooms in order of priority...",
+		queue.size(),
+	};
+
+	// Submit a copy of each room_id to the next pool worker; the submission
+	// blocks when all pool workers are busy, as per the pool::opts. Rooms are
+	// held back while too many created by the same server are in progress.
+	ctx::dock dock;
+	std::map<std::string, size_t, std::less<>> inflight;
+	const ctx::uninterruptible ui;
+	for(const auto &q : queue)
+	{
+		// Hold off on admitting more rooms while the database is stalled or
+		// the server is shedding optional work under load.
+		while((dbs::stalled() || ircd::resource::method::shedding()) && !ctx::interruption_requested())
+			ctx::sleep(seconds(1));
+
+		if(unlikely(ctx::interruption_requested()))
+			break;
+
+		const std::string remote
+		{
+			m::room::id(q.room_id).host()
+		};
+
+		while(inflight[remote] >= size_t(remote_max) && !ctx::interruption_requested())
+			dock.wait_for(seconds(1));
+
+		if(unlikely(ctx::interruption_requested()))
+			break;
+
 		++count;
-		pool([&, room_id(std::string(room_id))] // asynchronous
+		++inflight[remote];
+		pool([&, room_id(q.room_id), remote] // asynchronous
 		{
-			const unwind completed{[&dock]
+			const unwind completed{[&dock, &inflight, &remote]
 			{
+				--inflight[remote];
 				++complete;
-				dock.notify_one();
+				dock.notify_all();
 			}};
 
 			handle_room(room_id);
+			progress(room_id);
 
 			log::info
 			{
-				log, "Initial backfill of %s complete:%zu", //estimate:%zu %02.2lf%%",
+				log, "Initial backfill of %s complete:%zu of %zu",
 				string_view{room_id},
 				complete,
-				estimate,
-				(complete / double(estimate)) * 100.0,
+				queue.size(),
 			};
 		});
 
-		return true;
-	});
+		ctx::sleep(milliseconds(interval));
+	}
 
 	if(complete < count)
 		log::dwarning
@@ -339,3 +478,72 @@ ircd::m::init::backfill::handle_room(const room::id &room_id)
 		};
 	}
 }
+
+bool
+ircd::m::init::backfill::resumed(const room::id &room_id)
+{
+	if(!seconds(resume).count())
+		return false;
+
+	const m::room::id::buf progress_room_id
+	{
+		"backfill", my_host()
+	};
+
+	const m::room::state state
+	{
+		progress_room_id
+	};
+
+	const auto event_idx
+	{
+		state.get(std::nothrow, "ircd.init.backfill", room_id)
+	};
+
+	time_t ts {0};
+	if(!m::get(std::nothrow, event_idx, "origin_server_ts", ts))
+		return false;
+
+	const milliseconds age
+	{
+		ircd::time<milliseconds>() - ts
+	};
+
+	return age < seconds(resume);
+}
+
+/// Completion is noted in a state event of our own room for the purpose;
+/// its origin_server_ts is the time of completion.
+void
+ircd::m::init::backfill::progress(const room::id &room_id)
+try
+{
+	const m::room::id::buf progress_room_id
+	{
+		"backfill", my_host()
+	};
+
+	// Notes are local records; see vm::record_copts.
+	const m::room progress_room
+	{
+		progress_room_id, &vm::record_copts
+	};
+
+	send(progress_room, me(), "ircd.init.backfill", room_id, json::members
+	{
+		{ "viewports", long(size_t(viewports)) },
+	});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Failed to note backfill of %s :%s",
+		string_view{room_id},
+		e.what(),
+	};
+}
@@ -0,0 +1,677 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::init::horizon
+{
+	struct ref;
+	struct queued;
+
+	static bool eval_pdus(const json::array &, const string_view &origin);
+	static size_t handle_frontfill(const queued &, const string_view &origin, const std::vector<ref> &);
+	static size_t handle_fetch(const queued &, const string_view &origin, const std::vector<ref> &);
+	static void handle_room(const queued &);
+	static std::vector<queued> scan();
+	static void pass(ctx::pool &);
+	static void worker();
+
+	extern size_t passes, resolved, unresolved;
+	extern std::map<std::string, system_point, std::less<>> backoff;
+	extern ircd::run::changed handle_quit;
+	extern ctx::ctx *worker_context;
+	extern ctx::pool *worker_pool;
+	extern conf::item<bool> enable;
+	extern conf::item<bool> local_joined_only;
+	extern conf::item<seconds> delay;
+	extern conf::item<seconds> interval;
+	extern conf::item<seconds> retry;
+	extern conf::item<seconds> timeout;
+	extern conf::item<size_t> pool_size;
+	extern conf::item<size_t> scan_max;
+	extern conf::item<size_t> room_max;
+	extern conf::item<size_t> frontfill_limit;
+	extern conf::item<size_t> attempt_max;
+	extern log::log log;
+}
+
+decltype(ircd::m::init::horizon::log)
+ircd::m::init::horizon::log
+{
+	"m.init.horizon"
+};
+
+decltype(ircd::m::init::horizon::enable)
+ircd::m::init::horizon::enable
+{
+	{ "name",     "ircd.m.init.horizon.enable" },
+	{ "default",  true                         },
+};
+
+decltype(ircd::m::init::horizon::local_joined_only)
+ircd::m::init::horizon::local_joined_only
+{
+	{ "name",     "ircd.m.init.horizon.local_joined_only" },
+	{ "default",  true                                    },
+};
+
+decltype(ircd::m::init::horizon::delay)
+ircd::m::init::horizon::delay
+{
+	{ "name",     "ircd.m.init.horizon.delay" },
+	{ "default",  60L                         },
+};
+
+decltype(ircd::m::init::horizon::interval)
+ircd::m::init::horizon::interval
+{
+	{ "name",     "ircd.m.init.horizon.interval" },
+	{ "default",  300L                           },
+	{ "description",
+
+	R"(
+	Seconds between passes over the event horizon. Each pass takes a bounded
+	portion of the unresolved references and resolves what it can.
+	)"},
+};
+
+decltype(ircd::m::init::horizon::retry)
+ircd::m::init::horizon::retry
+{
+	{ "name",     "ircd.m.init.horizon.retry" },
+	{ "default",  6 * 60 * 60L                },
+	{ "description",
+
+	R"(
+	Seconds before an event which could not be found is sought again.
+	)"},
+};
+
+decltype(ircd::m::init::horizon::timeout)
+ircd::m::init::horizon::timeout
+{
+	{ "name",     "ircd.m.init.horizon.timeout" },
+	{ "default",  30L                           },
+};
+
+decltype(ircd::m::init::horizon::pool_size)
+ircd::m::init::horizon::pool_size
+{
+	{ "name",     "ircd.m.init.horizon.pool_size" },
+	{ "default",  8L                              },
+};
+
+decltype(ircd::m::init::horizon::scan_max)
+ircd::m::init::horizon::scan_max
+{
+	{ "name",     "ircd.m.init.horizon.scan_max" },
+	{ "default",  8192L                          },
+	{ "description",
+
+	R"(
+	Maximum number of missing events taken from the horizon in each pass.
+	)"},
+};
+
+decltype(ircd::m::init::horizon::room_max)
+ircd::m::init::horizon::room_max
+{
+	{ "name",     "ircd.m.init.horizon.room_max" },
+	{ "default",  256L                           },
+	{ "description",
+
+	R"(
+	Maximum number of missing events sought in any one room in each pass,
+	so a room with a large gap does not starve the others.
+	)"},
+};
+
+decltype(ircd::m::init::horizon::frontfill_limit)
+ircd::m::init::horizon::frontfill_limit
+{
+	{ "name",     "ircd.m.init.horizon.frontfill.limit" },
+	{ "default",  64L                                   },
+};
+
+decltype(ircd::m::init::horizon::attempt_max)
+ircd::m::init::horizon::attempt_max
+{
+	{ "name",     "ircd.m.init.horizon.attempt_max" },
+	{ "default",  4L                                },
+};
+
+/// A missing event and the event referring to it.
+struct ircd::m::init::horizon::ref
+{
+	std::string event_id;
+	event::id::buf referrer;
+	int64_t depth {0};
+};
+
+/// Room admitted to a pass; the missing events are grouped by the origin of
+/// the events referring to them, which is the server most likely to have
+/// them. Rooms are ordered by the count of our joined members.
+struct ircd::m::init::horizon::queued
+{
+	std::string room_id;
+	size_t local {0};
+	size_t missing {0};
+	std::map<std::string, std::vector<ref>, std::less<>> origins;
+
+	bool operator<(const queued &o) const
+	{
+		return std::tie(o.local, o.missing) < std::tie(local, missing);
+	}
+};
+
+decltype(ircd::m::init::horizon::passes)
+ircd::m::init::horizon::passes;
+
+decltype(ircd::m::init::horizon::resolved)
+ircd::m::init::horizon::resolved;
+
+decltype(ircd::m::init::horizon::unresolved)
+ircd::m::init::horizon::unresolved;
+
+decltype(ircd::m::init::horizon::backoff)
+ircd::m::init::horizon::backoff;
+
+decltype(ircd::m::init::horizon::worker_pool)
+ircd::m::init::horizon::worker_pool;
+
+decltype(ircd::m::init::horizon::worker_context)
+ircd::m::init::horizon::worker_context;
+
+decltype(ircd::m::init::horizon::handle_quit)
+ircd::m::init::horizon::handle_quit
+{
+	run::level::QUIT, []
+	{
+		fini();
+	}
+};
+
+void
+ircd::m::init::horizon::init()
+{
+	if(!enable)
+		return;
+
+	ctx::context context
+	{
+		"m.init.horizon",
+		512_KiB,
+		&worker,
+		context::POST
+	};
+
+	assert(!worker_context);
+	worker_context = context.detach();
+}
+
+void
+ircd::m::init::horizon::fini()
+noexcept
+{
+	if(worker_pool)
+		worker_pool->terminate();
+
+	if(worker_context)
+		ctx::terminate(*worker_context);
+
+	worker_context = nullptr;
+	worker_pool = nullptr;
+}
+
+void
+ircd::m::init::horizon::worker()
+try
+{
+	// Wait for runlevel RUN before proceeding...
+	run::barrier<ctx::interrupted>{};
+
+	ionice(ctx::cur(), 4);
+	nice(ctx::cur(), ctx::sched::BACKGROUND);
+	ctx::sleep(seconds(delay));
+
+	static const ctx::pool::opts pool_opts
+	{
+		512_KiB,               // stack sz
+		size_t(pool_size),     // pool sz
+		-1,                    // queue max hard
+		0,                     // queue max soft
+		true,                  // queue max blocking
+		false,                 // queue max warning
+		3,                     // ionice
+		int8_t(ctx::sched::BACKGROUND),
+	};
+
+	ctx::pool pool
+	{
+		"m.init.horizon", pool_opts
+	};
+
+	const scope_restore horizon_worker_pool
+	{
+		horizon::worker_pool, std::addressof(pool)
+	};
+
+	while(run::level == run::level::RUN)
+	{
+		// Defer while the database is stalled or the server is shedding
+		// optional work under load.
+		if(!dbs::stalled() && !ircd::resource::method::shedding())
+			pass(pool);
+
+		ctx::sleep(seconds(interval));
+	}
+}
+catch(const ctx::interrupted &e)
+{
+	throw;
+}
+catch(const ctx::terminated &e)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Worker fatal :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::m::init::horizon::pass(ctx::pool &pool)
+{
+	const auto queue
+	{
+		scan()
+	};
+
+	if(queue.empty())
+		return;
+
+	const size_t resolved_prior(resolved), unresolved_prior(unresolved);
+	log::info
+	{
+		log, "Resolving missing events in %zu rooms pass:%zu...",
+		queue.size(),
+		passes,
+	};
+
+	util::timer timer;
+	ctx::dock dock;
+	size_t count(0), complete(0);
+	const ctx::uninterruptible ui;
+	for(const auto &q : queue)
+	{
+		if(unlikely(ctx::interruption_requested()))
+			break;
+
+		++count;
+		pool([&dock, &complete, &q] // asynchronous
+		{
+			const unwind completed{[&dock, &complete]
+			{
+				++complete;
+				dock.notify_all();
+			}};
+
+			handle_room(q);
+		});
+	}
+
+	// The queue lives in this frame; the workers must be finished with it.
+	dock.wait([&complete, &count]
+	{
+		return complete >= count;
+	});
+
+	++passes;
+	char pbuf[48];
+	log::info
+	{
+		log, "Pass:%zu over %zu rooms resolved:%zu unresolved:%zu in %s",
+		passes,
+		count,
+		resolved - resolved_prior,
+		unresolved - unresolved_prior,
+		timer.pretty(pbuf),
+	};
+}
+
+/// Collects a bounded portion of the horizon into rooms ordered by priority.
+/// Events which recently could not be found and those already being
+/// fetched by other demands are skipped.
+std::vector<ircd::m::init::horizon::queued>
+ircd::m::init::horizon::scan()
+{
+	static const event::fetch::opts fopts
+	{
+		event::keys::include {"room_id", "origin", "depth"}
+	};
+
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	for(auto it(begin(backoff)); it != end(backoff); )
+		it = it->second < now? backoff.erase(it): std::next(it);
+
+	size_t count(0);
+	std::map<std::string, queued, std::less<>> rooms;
+	std::set<std::string, std::less<>> excluded;
+	event::horizon::for_every([&](const event::id &event_id, const event::idx &ref_idx)
+	{
+		if(unlikely(ctx::interruption_requested()))
+			return false;
+
+		if(backoff.count(event_id) || fetch::inflight(event_id))
+			return true;
+
+		const m::event::fetch referrer
+		{
+			std::nothrow, ref_idx, fopts
+		};
+
+		if(!referrer.valid)
+			return true;
+
+		const auto &room_id
+		{
+			json::get<"room_id"_>(referrer)
+		};
+
+		if(excluded.count(room_id))
+			return true;
+
+		auto it(rooms.lower_bound(room_id));
+		if(it == end(rooms) || it->first != room_id)
+		{
+			queued q;
+			q.room_id = room_id;
+			q.local = m::room::members(room_id).count("join", my_host());
+			if(!q.local && local_joined_only)
+			{
+				excluded.emplace(room_id);
+				return true;
+			}
+
+			it = rooms.emplace_hint(it, room_id, std::move(q));
+		}
+
+		auto &q(it->second);
+		if(q.missing >= size_t(room_max))
+			return true;
+
+		const auto &origin
+		{
+			json::get<"origin"_>(referrer)
+		};
+
+		q.origins[origin].emplace_back(ref
+		{
+			event_id,
+			m::event_id(std::nothrow, ref_idx),
+			json::get<"depth"_>(referrer),
+		});
+
+		++q.missing;
+		return ++count < size_t(scan_max);
+	});
+
+	std::vector<queued> ret;
+	ret.reserve(rooms.size());
+	for(auto &[room_id, q] : rooms)
+		ret.emplace_back(std::move(q));
+
+	std::sort(begin(ret), end(ret));
+	return ret;
+}
+
+/// Each origin is first asked for the gap below the referring events with
+/// one get_missing_events; whatever remains is fetched individually with
+/// that origin as the hint. Events which still can't be found back off.
+void
+ircd::m::init::horizon::handle_room(const queued &q)
+try
+{
+	std::vector<std::pair<string_view, const std::vector<ref> *>> origins;
+	origins.reserve(q.origins.size());
+	for(const auto &[origin, refs] : q.origins)
+		origins.emplace_back(origin, std::addressof(refs));
+
+	// Origins referring to the most missing events first.
+	std::sort(begin(origins), end(origins), []
+	(const auto &a, const auto &b)
+	{
+		return a.second->size() > b.second->size();
+	});
+
+	for(const auto &[origin, refs] : origins)
+	{
+		if(my_host(origin))
+			continue;
+
+		handle_frontfill(q, origin, *refs);
+		handle_fetch(q, origin, *refs);
+		ctx::interruption_point();
+	}
+
+	const auto until
+	{
+		ircd::now<system_point>() + seconds(retry)
+	};
+
+	size_t missing(0);
+	for(const auto &[origin, refs] : q.origins)
+		for(const auto &ref : refs)
+		{
+			if(m::exists(event::id(ref.event_id)))
+			{
+				++resolved;
+				continue;
+			}
+
+			backoff[ref.event_id] = until;
+			++unresolved;
+			++missing;
+		}
+
+	log::debug
+	{
+		log, "Resolved %zu of %zu missing events in %s",
+		q.missing - missing,
+		q.missing,
+		string_view{q.room_id},
+	};
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Resolving missing events in %s :%s",
+		string_view{q.room_id},
+		e.what(),
+	};
+}
+
+size_t
+ircd::m::init::horizon::handle_frontfill(const queued &q,
+                                         const string_view &origin,
+                                         const std::vector<ref> &refs)
+try
+{
+	std::vector<event::id> latest;
+	int64_t min_depth(std::numeric_limits<int64_t>::max());
+	for(const auto &ref : refs)
+	{
+		if(empty(ref.referrer))
+			continue;
+
+		min_depth = std::min(min_depth, ref.depth);
+		if(std::find(begin(latest), end(latest), ref.referrer) == end(latest))
+			latest.emplace_back(ref.referrer);
+
+		if(latest.size() >= 16)
+			break;
+	}
+
+	if(latest.empty())
+		return 0;
+
+	fed::frontfill::opts opts;
+	opts.remote = origin;
+	opts.limit = size_t(frontfill_limit);
+	opts.min_depth = std::max(min_depth - int64_t(opts.limit), 0L);
+	const unique_buffer<mutable_buffer> buf
+	{
+		16_KiB
+	};
+
+	fed::frontfill request
+	{
+		q.room_id, fed::frontfill::ranges{{}, latest}, buf, std::move(opts)
+	};
+
+	request.wait(seconds(timeout));
+	request.get();
+	const json::array pdus
+	{
+		request
+	};
+
+	return eval_pdus(pdus, origin)? pdus.size(): 0UL;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "get_missing_events for %zu in %s from '%s' :%s",
+		refs.size(),
+		string_view{q.room_id},
+		origin,
+		e.what(),
+	};
+
+	return 0;
+}
+
+size_t
+ircd::m::init::horizon::handle_fetch(const queued &q,
+                                     const string_view &origin,
+                                     const std::vector<ref> &refs)
+{
+	std::list<std::pair<ctx::future<fetch::result>, string_view>> futures;
+	for(const auto &ref : refs) try
+	{
+		const event::id event_id
+		{
+			ref.event_id
+		};
+
+		if(m::exists(event_id) || fetch::inflight(event_id))
+			continue;
+
+		fetch::opts opts;
+		opts.op = fetch::op::event;
+		opts.room_id = q.room_id;
+		opts.event_id = event_id;
+		opts.hint = origin;
+		opts.attempt_limit = size_t(attempt_max);
+		futures.emplace_back(fetch::start(opts), ref.event_id);
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::derror
+		{
+			log, "Fetch %s in %s :%s",
+			ref.event_id,
+			string_view{q.room_id},
+			e.what(),
+		};
+	}
+
+	size_t ret(0);
+	for(auto &[future, event_id] : futures) try
+	{
+		const auto result
+		{
+			future.get()
+		};
+
+		const json::object body
+		{
+			result
+		};
+
+		const json::array pdus
+		{
+			body["pdus"]
+		};
+
+		ret += eval_pdus(pdus, result.origin)? pdus.size(): 0UL;
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::derror
+		{
+			log, "Fetch %s in %s :%s",
+			event_id,
+			string_view{q.room_id},
+			e.what(),
+		};
+	}
+
+	return ret;
+}
+
+bool
+ircd::m::init::horizon::eval_pdus(const json::array &pdus,
+                                  const string_view &origin)
+{
+	if(pdus.empty())
+		return false;
+
+	// Filling gaps below the head; nothing here is new to anyone else.
+	vm::opts vmopts;
+	vmopts.node_id = origin;
+	vmopts.notify_servers = false;
+	vmopts.phase.set(m::vm::phase::NOTIFY, false);
+	vmopts.phase.set(m::vm::phase::FETCH_PREV, false);
+	vmopts.phase.set(m::vm::phase::FETCH_STATE, false);
+	vmopts.wopts.appendix.set(dbs::appendix::ROOM_HEAD, false);
+	vmopts.warnlog &= ~vm::fault::EXISTS;
+	vmopts.nothrows = -1;
+	m::vm::eval
+	{
+		pdus, vmopts
+	};
+
+	return true;
+}
@@ -274,6 +274,8 @@ catch(const ctx::timeout &e)
 
 namespace ircd::m
 {
+	static bool keys_fetch_origin(const string_view &server_name, const string_view &key_id, const keys::closure &);
+
 	extern conf::item<milliseconds> keys_get_timeout;
 }
 
@@ -308,7 +310,6 @@ bool
 ircd::m::keys::get(const string_view &server_name,
                    const string_view &key_id,
                    const closure &closure)
-try
 {
 	assert(!server_name.empty());
 	if(cache::get(server_name, key_id, closure))
@@ -328,6 +329,15 @@ try
 		server_name
 	};
 
+	return keys_fetch_origin(server_name, key_id, closure);
+}
+
+bool
+ircd::m::keys_fetch_origin(const string_view &server_name,
+                           const string_view &key_id,
+                           const keys::closure &closure)
+try
+{
 	const unique_buffer<mutable_buffer> buf
 	{
 		32_KiB
@@ -512,9 +522,111 @@ ircd::m::keys::get(const queries &queries,
 // m::keys::cache
 //
 
+namespace ircd::m
+{
+	struct keys_memory_entry;
+	using keys_memory_map = std::map<std::string, keys_memory_entry, std::less<>>;
+
+	static string_view keys_memory_key(const mutable_buffer &, const string_view &server, const string_view &key_id);
+	static void keys_memory_set(const json::object &keys);
+	static size_t keys_refresh();
+	static void keys_refresh_worker();
+
+	extern conf::item<size_t> keys_memory_max;
+	extern conf::item<seconds> keys_refresh_interval;
+	extern conf::item<seconds> keys_refresh_ahead;
+	extern conf::item<seconds> keys_refresh_retry;
+	extern conf::item<std::string> keys_refresh_notary;
+
+	static keys_memory_map keys_memory;
+	extern context keys_refresh_context;
+}
+
+/// Public key held in memory for each (server_name, key_id) which has passed
+/// through the cache; the expiry is that of the key object which carried it.
+struct ircd::m::keys_memory_entry
+{
+	ed25519::pk pk;
+	time_t valid_until_ts {0};
+	time_t attempt_ts {0};
+	bool refresh {false};
+};
+
+decltype(ircd::m::keys_memory_max)
+ircd::m::keys_memory_max
+{
+	{ "name",     "ircd.keys.memory.max" },
+	{ "default",  32768L                 },
+	{ "description",
+
+	R"(
+	Maximum number of public keys of remote servers held in memory for
+	signature verification. 0 reads the key from the node's room each time.
+	)"},
+};
+
+decltype(ircd::m::keys_refresh_interval)
+ircd::m::keys_refresh_interval
+{
+	{ "name",     "ircd.keys.refresh.interval" },
+	{ "default",  60L                          },
+};
+
+decltype(ircd::m::keys_refresh_ahead)
+ircd::m::keys_refresh_ahead
+{
+	{ "name",     "ircd.keys.refresh.ahead" },
+	{ "default",  3600L                     },
+	{ "description",
+
+	R"(
+	Seconds before the valid_until_ts of a key held in memory at which the
+	keys of its server are fetched again in the background. 0 disables.
+	)"},
+};
+
+decltype(ircd::m::keys_refresh_retry)
+ircd::m::keys_refresh_retry
+{
+	{ "name",     "ircd.keys.refresh.retry" },
+	{ "default",  900L                      },
+};
+
+decltype(ircd::m::keys_refresh_notary)
+ircd::m::keys_refresh_notary
+{
+	{ "name",     "ircd.keys.refresh.notary" },
+	{ "default",  string_view{}              },
+	{ "description",
+
+	R"(
+	Server queried for the keys of a server which could not be refreshed
+	from the server itself. Empty for none.
+	)"},
+};
+
+decltype(ircd::m::keys_refresh_context)
+ircd::m::keys_refresh_context
+{
+	"m.keys.refresh",
+	512_KiB,
+	context::POST,
+	keys_refresh_worker,
+};
+
+static const ircd::run::changed
+keys_refresh_terminate
+{
+	ircd::run::level::QUIT, []
+	{
+		ircd::m::keys_refresh_context.terminate();
+	}
+};
+
 size_t
 ircd::m::keys::cache::set(const json::object &keys)
 {
+	keys_memory_set(keys);
 	const json::string &server_name
 	{
 		keys.at("server_name")
@@ -528,11 +640,17 @@ ircd::m::keys::cache::set(const json::object &keys)
 	if(!exists(node_room.room_id))
 		create(node_room, me());
 
-	const auto send_to_cache{[&node_room, &keys]
+	// Keys are cached as local records; see vm::record_copts.
+	const m::room cache_room
+	{
+		node_room.room_id, &vm::record_copts
+	};
+
+	const auto send_to_cache{[&cache_room, &keys]
 	(const json::object::member &member)
 	{
 		const json::string &key_id{member.first};
-		send(node_room, me(), "ircd.key", key_id, keys);
+		send(cache_room, me(), "ircd.key", key_id, keys);
 	}};
 
 	size_t ret{0};
@@ -548,6 +666,74 @@ ircd::m::keys::cache::set(const json::object &keys)
 	return ret;
 }
 
+/// Public key for key_id of the server from memory, otherwise from the
+/// node's room, which is then held in memory; never from the network.
+bool
+ircd::m::keys::cache::get(const string_view &server_name,
+                          const string_view &key_id,
+                          ed25519::pk &pk)
+{
+	char buf[512];
+	const string_view memory_key
+	{
+		keys_memory_key(buf, server_name, key_id)
+	};
+
+	auto it
+	{
+		keys_memory.find(memory_key)
+	};
+
+	if(it != end(keys_memory))
+	{
+		pk = it->second.pk;
+		return true;
+	}
+
+	bool ret{false};
+	get(server_name, key_id, [&key_id, &pk, &ret]
+	(const json::object &keys)
+	{
+		const json::object &verify_keys
+		{
+			keys["verify_keys"]
+		};
+
+		const json::object &old_verify_keys
+		{
+			keys["old_verify_keys"]
+		};
+
+		const json::object &verify_key
+		{
+			verify_keys.has(key_id)?
+				verify_keys.get(key_id):
+				old_verify_keys.get(key_id)
+		};
+
+		const json::string &key
+		{
+			verify_key["key"]
+		};
+
+		if(!key)
+			return;
+
+		pk = ed25519::pk
+		{
+			[&key](auto&& buf)
+			{
+				b64::decode(buf, key);
+			}
+		};
+
+		keys_memory_set(keys);
+		ret = true;
+	});
+
+	return ret;
+}
+
 bool
 ircd::m::keys::cache::get(const string_view &server_name,
                           const string_view &key_id,
@@ -619,6 +805,237 @@ ircd::m::keys::cache::for_each(const string_view &server_name,
 	});
 }
 
+void
+ircd::m::keys_memory_set(const json::object &keys)
+{
+	if(!size_t(keys_memory_max))
+		return;
+
+	const json::string &server_name
+	{
+		keys["server_name"]
+	};
+
+	const time_t valid_until_ts
+	{
+		keys.get<time_t>("valid_until_ts", 0L)
+	};
+
+	// Current keys are refreshed ahead of their expiry; old keys are only
+	// ever used for what they signed before they were retired.
+	const auto set{[&server_name, &valid_until_ts]
+	(const json::object::member &member, const bool &refresh)
+	{
+		const json::object &verify_key
+		{
+			member.second
+		};
+
+		const json::string &key
+		{
+			verify_key["key"]
+		};
+
+		if(!key)
+			return;
+
+		char buf[512];
+		const string_view memory_key
+		{
+			keys_memory_key(buf, server_name, json::string(member.first))
+		};
+
+		auto it
+		{
+			keys_memory.find(memory_key)
+		};
+
+		if(it == end(keys_memory))
+		{
+			while(keys_memory.size() >= size_t(keys_memory_max))
+				keys_memory.erase(begin(keys_memory));
+
+			it = keys_memory.emplace(std::string{memory_key}, keys_memory_entry{}).first;
+		}
+
+		auto &entry(it->second);
+		entry.pk = ed25519::pk
+		{
+			[&key](auto&& buf)
+			{
+				b64::decode(buf, key);
+			}
+		};
+
+		entry.valid_until_ts = std::max(entry.valid_until_ts, valid_until_ts);
+		entry.refresh = refresh && !my_host(server_name);
+	}};
+
+	for(const auto &member : json::object(keys["old_verify_keys"]))
+		set(member, false);
+
+	for(const auto &member : json::object(keys["verify_keys"]))
+		set(member, true);
+}
+
+ircd::string_view
+ircd::m::keys_memory_key(const mutable_buffer &buf,
+                         const string_view &server_name,
+                         const string_view &key_id)
+{
+	return fmt::sprintf
+	{
+		buf, "%s %s",
+		server_name,
+		key_id,
+	};
+}
+
+void
+ircd::m::keys_refresh_worker()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	while(1)
+	{
+		ctx::sleep(seconds(keys_refresh_interval));
+		if(!seconds(keys_refresh_ahead).count())
+			continue;
+
+		const auto refreshed
+		{
+			keys_refresh()
+		};
+
+		if(refreshed)
+			log::debug
+			{
+				log, "Refreshed keys of %zu servers held in memory.",
+				refreshed,
+			};
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Keys refresh worker fatal :%s",
+		e.what()
+	};
+}
+
+size_t
+ircd::m::keys_refresh()
+{
+	const time_t now
+	{
+		ircd::time<milliseconds>()
+	};
+
+	const milliseconds ahead
+	{
+		seconds(keys_refresh_ahead)
+	};
+
+	const milliseconds retry
+	{
+		seconds(keys_refresh_retry)
+	};
+
+	// One query per server; the map is not iterated across the yields of the
+	// fetches below.
+	std::map<std::string, std::string, std::less<>> due;
+	for(auto &[memory_key, entry] : keys_memory)
+	{
+		if(!entry.refresh)
+			continue;
+
+		if(entry.valid_until_ts - ahead.count() > now)
+			continue;
+
+		if(entry.attempt_ts + retry.count() > now)
+			continue;
+
+		entry.attempt_ts = now;
+		const auto &[server_name, key_id]
+		{
+			split(memory_key, ' ')
+		};
+
+		due.emplace(server_name, key_id);
+	}
+
+	const std::string notary
+	{
+		string_view{keys_refresh_notary}
+	};
+
+	size_t ret(0);
+	for(const auto &[server_name, key_id] : due)
+	{
+		bool refreshed{false};
+		const auto closure{[&refreshed]
+		(const json::object &keys)
+		{
+			refreshed = true;
+		}};
+
+		try
+		{
+			keys_fetch_origin(server_name, string_view{}, closure);
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::derror
+			{
+				log, "Failed to refresh keys of '%s' :%s",
+				server_name,
+				e.what(),
+			};
+		}
+
+		if(!refreshed && !notary.empty() && notary != server_name) try
+		{
+			const fed::key::server_key query
+			{
+				server_name, key_id
+			};
+
+			refreshed = keys::query(notary, {&query, 1}, [&server_name]
+			(const json::object &keys)
+			{
+				return json::string(keys["server_name"]) == server_name;
+			});
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::derror
+			{
+				log, "Failed to refresh keys of '%s' from notary '%s' :%s",
+				server_name,
+				notary,
+				e.what(),
+			};
+		}
+
+		ret += refreshed;
+	}
+
+	return ret;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // (internal) ed25519 support sanity test
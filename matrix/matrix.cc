@@ -189,6 +189,17 @@ ircd::m::matrix::module_names_optional
 	"web_hook",
 };
 
+/// This is a list of modules from module_names which are not loaded by
+/// m::init when ircd.m.mods.lazy is set; each is loaded when a request is
+/// first made under the path prefix paired with it.
+decltype(ircd::m::matrix::module_names_lazy)
+ircd::m::matrix::module_names_lazy
+{
+	{ "media_media",       "/_matrix/media/"           },
+	{ "identity_v1",       "/_matrix/identity/"        },
+	{ "identity_pubkey",   "/_matrix/identity/"        },
+};
+
 //
 // init
 //
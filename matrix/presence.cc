@@ -10,9 +10,26 @@
 
 namespace ircd::m
 {
+	using presence_cells_type = std::map<std::string, presence::cell, std::less<>>;
+	using presence_recent_type = std::map<event::idx, string_view>;
+
+	static void presence_assign(presence::cell &, const json::object &, const time_t &, const event::idx &);
+	static void presence_trim();
+
 	extern const string_view presence_valid_states[];
+	static presence_cells_type presence_cells;
+	static presence_recent_type presence_recent;
+	static event::idx presence_floor {-1UL};
 }
 
+decltype(ircd::m::presence::cells_max)
+ircd::m::presence::cells_max
+{
+	{ "name",     "ircd.m.presence.cells.max" },
+	{ "default",  262144L                     },
+	{ "help",     "Number of users whose presence is kept in memory."  },
+};
+
 decltype(ircd::m::presence_valid_states)
 ircd::m::presence_valid_states
 {
@@ -190,6 +207,207 @@ ircd::m::presence::set(const m::presence &content)
 	return send(user_room, user.user_id, "ircd.presence", "", json::object(_content));
 }
 
+//
+// In-memory table
+//
+// The table holds a cell for every user whose ircd.presence was noted by the
+// m_presence module or looked up here. Cells are also ordered by their
+// event_idx; the first noted event opens a floor above which every change
+// is in the table, so the users whose presence changed since a token above
+// the floor are found without visiting anyone else. Beyond cells.max the
+// oldest cells are evicted and the floor is raised past them.
+//
+
+bool
+ircd::m::presence::complete(const event::idx &since)
+{
+	return presence_floor != -1UL && since >= presence_floor;
+}
+
+/// Iterates the cells changed at or after `since`. The closure must not
+/// yield the ctx.
+bool
+ircd::m::presence::for_each(const event::idx &since,
+                            const closure_cell_bool &closure)
+{
+	const ctx::critical_assertion ca;
+	for(auto it(presence_recent.lower_bound(since)); it != end(presence_recent); ++it)
+	{
+		const auto cell
+		{
+			presence_cells.find(it->second)
+		};
+
+		assert(cell != end(presence_cells));
+		if(!closure(id::user(cell->first), cell->second))
+			return false;
+	}
+
+	return true;
+}
+
+/// Copies the user's cell, reading it from the user's room on a miss.
+bool
+ircd::m::presence::get(std::nothrow_t,
+                       const user &user,
+                       cell &ret)
+{
+	const auto it
+	{
+		presence_cells.find(user.user_id)
+	};
+
+	if(it != end(presence_cells))
+	{
+		ret = it->second;
+		return true;
+	}
+
+	static const m::event::fetch::opts fopts
+	{
+		m::event::keys::include {"content", "origin_server_ts"}
+	};
+
+	const m::event::idx event_idx
+	{
+		get(std::nothrow, user)
+	};
+
+	const m::event::fetch event
+	{
+		std::nothrow, event_idx, fopts
+	};
+
+	if(!event_idx || !event.valid)
+		return false;
+
+	presence_assign(ret, json::get<"content"_>(event), json::get<"origin_server_ts"_>(event), event_idx);
+
+	// The fetch yielded; the user may have been noted in the meantime.
+	const auto pit
+	{
+		presence_cells.emplace(std::string(user.user_id), ret)
+	};
+
+	if(!pit.second)
+	{
+		ret = pit.first->second;
+		return true;
+	}
+
+	presence_recent.emplace(event_idx, pit.first->first);
+	presence_trim();
+	return true;
+}
+
+void
+ircd::m::presence::note(const m::event &event,
+                        const event::idx &event_idx)
+{
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	const json::string &user_id
+	{
+		content["user_id"]
+	};
+
+	if(!m::valid(m::id::USER, user_id))
+		return;
+
+	if(presence_floor == -1UL)
+		presence_floor = event_idx;
+
+	auto it
+	{
+		presence_cells.lower_bound(user_id)
+	};
+
+	if(it == end(presence_cells) || it->first != user_id)
+		it = presence_cells.emplace_hint(it, std::string(user_id), cell{});
+
+	auto &cell
+	{
+		it->second
+	};
+
+	if(cell.event_idx > event_idx)
+		return;
+
+	if(cell.event_idx)
+		presence_recent.erase(cell.event_idx);
+
+	presence_assign(cell, content, json::get<"origin_server_ts"_>(event), event_idx);
+	presence_recent.emplace(event_idx, it->first);
+	presence_trim();
+}
+
+void
+ircd::m::presence::clear()
+noexcept
+{
+	presence_recent.clear();
+	presence_cells.clear();
+	presence_floor = -1UL;
+}
+
+void
+ircd::m::presence_trim()
+{
+	while(presence_cells.size() > size_t(presence::cells_max) && !presence_recent.empty())
+	{
+		const auto it
+		{
+			begin(presence_recent)
+		};
+
+		if(presence_floor != -1UL)
+			presence_floor = std::max(presence_floor, it->first + 1);
+
+		presence_cells.erase(it->second);
+		presence_recent.erase(it);
+	}
+}
+
+void
+ircd::m::presence_assign(presence::cell &cell,
+                         const json::object &content,
+                         const time_t &ts,
+                         const event::idx &event_idx)
+{
+	const json::string &state
+	{
+		content["presence"]
+	};
+
+	const auto valid
+	{
+		std::find(begin(presence_valid_states), end(presence_valid_states), state)
+	};
+
+	cell.event_idx = event_idx;
+	cell.last_active = ts - content.get<time_t>("last_active_ago", 0L);
+	cell.state = valid != end(presence_valid_states)?
+		std::distance(begin(presence_valid_states), valid):
+		-1;
+
+	cell.currently_active = content.get<bool>("currently_active", false);
+	cell.status_msg = !empty(json::string(content["status_msg"]));
+}
+
+//
+// presence::cell
+//
+
+bool
+ircd::m::presence::cell::offline()
+const noexcept
+{
+	return state == 1;
+}
+
 bool
 ircd::m::presence::valid_state(const string_view &state)
 {
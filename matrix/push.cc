@@ -56,6 +56,33 @@ ircd::m::push::request::timeout
 	{ "default",  8L                            },
 };
 
+decltype(ircd::m::push::request::gateway_max)
+ircd::m::push::request::gateway_max
+{
+	{ "name",     "ircd.m.push.request.gateway.max" },
+	{ "default",  64L                               },
+	{ "description",
+
+	R"(
+	Maximum requests pending to any one push gateway. Requests to the same
+	gateway share its kept-alive links. When this is reached the oldest
+	pending request to the gateway is dropped in favor of the new one.
+	)"},
+};
+
+decltype(ircd::m::push::request::devices_max)
+ircd::m::push::request::devices_max
+{
+	{ "name",     "ircd.m.push.request.devices.max" },
+	{ "default",  16L                               },
+	{ "description",
+
+	R"(
+	Maximum devices coalesced into the notification of a single request
+	when a user has several pushers to the same gateway.
+	)"},
+};
+
 decltype(ircd::m::push::request::mutex)
 ircd::m::push::request::mutex;
 
@@ -78,6 +105,7 @@ namespace ircd::m::push
 	static bool contains_user_mxid(const event &, const cond &, const match::opts &);
 	static bool room_member_count(const event &, const cond &, const match::opts &);
 	static bool event_match(const event &, const cond &, const match::opts &);
+	static string_view event_match_value(const event &, const string_view &key, const json::object::index *);
 }
 
 decltype(ircd::m::push::match::cond_kind)
@@ -172,30 +200,11 @@ try
 {
 	assert(json::get<"kind"_>(cond) == "event_match");
 
-	const auto &[top, path]
-	{
-		split(json::get<"key"_>(cond), '.')
-	};
-
-	string_view value
+	const string_view value
 	{
-		json::get(event, top, json::object{})
+		event_match_value(event, json::get<"key"_>(cond), opts.content)
 	};
 
-	tokens(path, ".", [&value]
-	(const string_view &key)
-	{
-		if(!json::type(value, json::OBJECT))
-			return false;
-
-		value = json::object(value)[key];
-		if(likely(!json::type(value, json::STRING)))
-			return true;
-
-		value = json::string(value);
-		return false;
-	});
-
 	 //TODO: XXX spec leading/trailing; not imatch
 	const globular_imatch pattern
 	{
@@ -220,6 +229,44 @@ catch(const std::exception &e)
 	return false;
 }
 
+/// Resolves the dotted key of an event_match condition to the value in the
+/// event; strings are unquoted.
+ircd::string_view
+ircd::m::push::event_match_value(const event &event,
+                                 const string_view &key,
+                                 const json::object::index *index)
+{
+	const auto &[top, path]
+	{
+		split(key, '.')
+	};
+
+	string_view value
+	{
+		json::get(event, top, json::object{})
+	};
+
+	if(top != "content")
+		index = nullptr;
+
+	tokens(path, ".", [&value, &index]
+	(const string_view &key)
+	{
+		if(!json::type(value, json::OBJECT))
+			return false;
+
+		value = index? index->get(key): json::object(value)[key];
+		index = nullptr;
+		if(likely(!json::type(value, json::STRING)))
+			return true;
+
+		value = json::string(value);
+		return false;
+	});
+
+	return value;
+}
+
 bool
 ircd::m::push::contains_user_mxid(const event &event,
                                   const cond &cond,
@@ -239,7 +286,9 @@ try
 
 	const json::string &body
 	{
-		content["body"]
+		opts.content?
+			opts.content->get("body"):
+			content["body"]
 	};
 
 	if(has(body, opts.user_id))
@@ -247,7 +296,9 @@ try
 
 	const json::string &formatted_body
 	{
-		content["formatted_body"]
+		opts.content?
+			opts.content->get("formatted_body"):
+			content["formatted_body"]
 	};
 
 	if(has(formatted_body, opts.user_id))
@@ -318,7 +369,9 @@ try
 
 	const json::string &body
 	{
-		content["body"]
+		opts.content?
+			opts.content->get("body"):
+			content["body"]
 	};
 
 	if(!body)
@@ -386,22 +439,11 @@ try
 		power.level_user(at<"sender"_>(event))
 	};
 
-	int64_t required_level
+	const auto &required_level
 	{
-		room::power::default_power_level
+		power.level_notification(key)
 	};
 
-	power.for_each("notifications", [&required_level, &key]
-	(const auto &name, const auto &level)
-	{
-		if(name == key)
-		{
-			required_level = level;
-			return false;
-		}
-		else return true;
-	});
-
 	const bool ret
 	{
 		user_level >= required_level
@@ -546,6 +588,491 @@ ircd::m::push::unknown_condition_kind(const event &event,
 	return false;
 }
 
+//
+// program
+//
+
+decltype(ircd::m::push::program::cache_max)
+ircd::m::push::program::cache_max
+{
+	{ "name",     "ircd.m.push.program.cache.max" },
+	{ "default",  8192L                           },
+};
+
+decltype(ircd::m::push::program::cache)
+ircd::m::push::program::cache;
+
+decltype(ircd::m::push::program::cache_gen)
+ircd::m::push::program::cache_gen;
+
+std::shared_ptr<const ircd::m::push::program>
+ircd::m::push::program::get(const id::user &user_id)
+{
+	const auto it
+	{
+		cache.find(user_id)
+	};
+
+	if(it != end(cache))
+		return it->second;
+
+	// The rules are read from the user's room; a change made meanwhile
+	// invalidates this compilation, which is used once but not kept.
+	const auto gen{cache_gen};
+	auto ret
+	{
+		std::make_shared<const program>(user_id)
+	};
+
+	if(gen != cache_gen)
+		return ret;
+
+	if(cache.size() >= size_t(cache_max))
+		cache.erase(begin(cache));
+
+	cache.emplace(std::string{user_id}, ret);
+	return ret;
+}
+
+void
+ircd::m::push::program::invalidate(const id::user &user_id)
+{
+	++cache_gen;
+	const auto it
+	{
+		cache.find(user_id)
+	};
+
+	if(it != end(cache))
+		cache.erase(it);
+}
+
+ircd::m::push::program::program(const id::user &user_id)
+:user_id
+{
+	user_id
+}
+{
+	const m::user::profile profile
+	{
+		user_id
+	};
+
+	profile.get(std::nothrow, "displayname", [this]
+	(const string_view &, const json::string &displayname)
+	{
+		this->displayname = displayname;
+	});
+
+	const user::pushrules pushrules
+	{
+		user_id
+	};
+
+	// Order of priority; the first rule matched is the one applied.
+	static const string_view kinds[]
+	{
+		"override", "content", "room", "sender", "underride"
+	};
+
+	for(const auto &kind : kinds)
+		pushrules.for_each(push::path{"global", kind, {}}, [this]
+		(const event::idx &rule_idx, const push::path &path, const json::object &object)
+		{
+			const push::rule rule
+			{
+				object
+			};
+
+			if(!json::get<"enabled"_>(rule))
+				return true;
+
+			const auto &[scope, kind, rule_id]
+			{
+				path
+			};
+
+			auto &r(rules.emplace_back());
+			r.scope = scope;
+			r.kind = kind;
+			r.rule_id = rule_id;
+			r.rule_idx = rule_idx;
+			r.actions = json::get<"actions"_>(rule);
+			r.notify = notifying(rule);
+			r.highlight = highlighting(rule);
+
+			// Room and sender rules apply to the room or sender named by
+			// their rule_id.
+			if(kind == "room")
+				r.conds.emplace_back(cond::ROOM_ID, string_view{}, rule_id);
+
+			if(kind == "sender")
+				r.conds.emplace_back(cond::SENDER, string_view{}, rule_id);
+
+			if(json::get<"pattern"_>(rule))
+				r.conds.emplace_back(cond::EVENT_MATCH, "content.body", json::get<"pattern"_>(rule));
+
+			for(const json::object cond : json::get<"conditions"_>(rule))
+				r.conds.emplace_back(push::cond(cond));
+
+			return true;
+		});
+}
+
+const ircd::m::push::program::rule *
+ircd::m::push::program::operator()(memo &memo)
+const
+{
+	for(const auto &rule : rules)
+	{
+		const auto matched{[this, &memo, &rule]
+		{
+			for(const auto &cond : rule.conds)
+				if(!cond(*this, memo))
+					return false;
+
+			return true;
+		}};
+
+		try
+		{
+			if(matched())
+				return &rule;
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::error
+			{
+				log, "Push rule matching in %s for %s at { %s, %s, %s } :%s",
+				string_view{memo.event.event_id},
+				string_view{user_id},
+				string_view{rule.scope},
+				string_view{rule.kind},
+				string_view{rule.rule_id},
+				e.what(),
+			};
+		}
+	}
+
+	return nullptr;
+}
+
+//
+// program::rule
+//
+
+ircd::m::push::path
+ircd::m::push::program::rule::path()
+const
+{
+	return
+	{
+		scope, kind, rule_id
+	};
+}
+
+//
+// program::cond
+//
+
+decltype(ircd::m::push::program::cond::slots_max)
+ircd::m::push::program::cond::slots_max
+{
+	{ "name",     "ircd.m.push.program.cond.slots.max" },
+	{ "default",  65536L                               },
+	{ "description",
+
+	R"(
+	Distinct event_match conditions whose results are shared by all programs
+	evaluating an event. Slots are kept for the life of the process; those
+	conditions found after the limit is reached are evaluated by each
+	program on its own.
+	)"},
+};
+
+decltype(ircd::m::push::program::cond::slots)
+ircd::m::push::program::cond::slots;
+
+ircd::m::push::program::cond::cond(const push::cond &cond)
+{
+	const string_view &kind
+	{
+		json::get<"kind"_>(cond)
+	};
+
+	const auto pos
+	{
+		indexof(kind, string_views(match::cond_kind_name))
+	};
+
+	// The kinds are enumerated in the order of their names.
+	this->kind = pos < ROOM_ID? (enum kind)pos: UNKNOWN;
+	switch(this->kind)
+	{
+		case EVENT_MATCH:
+			*this = program::cond
+			{
+				EVENT_MATCH, json::get<"key"_>(cond), json::get<"pattern"_>(cond)
+			};
+			break;
+
+		case SENDER_NOTIFICATION_PERMISSION:
+			key = json::get<"key"_>(cond);
+			break;
+
+		case ROOM_MEMBER_COUNT:
+		{
+			const string_view &is
+			{
+				json::get<"is"_>(cond)
+			};
+
+			string_view valstr(is);
+			while(valstr && !all_of<std::isdigit>(valstr))
+				valstr.pop_front();
+
+			pattern = string_view{begin(is), begin(valstr)};
+			val = lex_cast<ulong>(valstr);
+			break;
+		}
+
+		case UNKNOWN:
+			log::derror
+			{
+				log, "Push condition kind '%s' is unknown; rule always fails...",
+				kind,
+			};
+			break;
+
+		default:
+			break;
+	}
+}
+
+ircd::m::push::program::cond::cond(const enum kind &kind,
+                                   const string_view &key,
+                                   const string_view &pattern)
+:kind{kind}
+,glob
+{
+	pattern == "*"?
+		ANY:
+	pattern.find_first_of("*?") == pattern.npos?
+		EXACT:
+		GLOB
+}
+,key{key}
+,pattern{pattern}
+{
+	if(kind != EVENT_MATCH || glob == ANY)
+		return;
+
+	// Matches of the same key and pattern share a slot across all programs
+	// so each is conducted once for an event rather than once per user.
+	std::string sig(key);
+	sig.push_back('\0');
+	sig.append(pattern);
+
+	auto it(slots.lower_bound(sig));
+	if(it == end(slots) || it->first != sig)
+	{
+		if(slots.size() >= size_t(slots_max))
+			return;
+
+		it = slots.emplace_hint(it, std::move(sig), uint32_t(slots.size()));
+	}
+
+	slot = it->second;
+}
+
+bool
+ircd::m::push::program::cond::operator()(const program &program,
+                                         memo &memo)
+const
+{
+	if(slot == -1U)
+		return eval(program, memo);
+
+	auto &ret
+	{
+		memo.result(slot)
+	};
+
+	if(ret < 0)
+		ret = eval(program, memo);
+
+	return ret;
+}
+
+bool
+ircd::m::push::program::cond::eval(const program &program,
+                                   memo &memo)
+const
+{
+	const auto &event(memo.event);
+	const auto body{[&memo](const string_view &key)
+	{
+		return json::string
+		{
+			memo.content?
+				memo.content->get(key):
+				json::get<"content"_>(memo.event).get(key)
+		};
+	}};
+
+	switch(kind)
+	{
+		case EVENT_MATCH:
+		{
+			const string_view value
+			{
+				memo.value(key)
+			};
+
+			switch(glob)
+			{
+				case EXACT:
+					return iequals(value, pattern);
+
+				case ANY:
+					return !empty(value);
+
+				case GLOB:
+					return globular_imatch{pattern}(value);
+			}
+
+			return false;
+		}
+
+		case ROOM_MEMBER_COUNT:
+		{
+			const size_t count
+			{
+				memo.member_count()
+			};
+
+			switch(hash(pattern))
+			{
+				default:
+				case "=="_:
+					return val? count == val: !count;
+
+				case ">="_:
+					return val? count >= val: true;
+
+				case "<="_:
+					return val? count <= val: !count;
+
+				case ">"_:
+					return val? count > val: count > 0;
+
+				case "<"_:
+					return val > 1? count < val: val == 1? !count: false;
+			}
+		}
+
+		case CONTAINS_USER_MXID:
+			return has(body("body"), program.user_id)
+			|| has(body("formatted_body"), program.user_id);
+
+		case STATE_KEY_USER_MXID:
+			return json::get<"state_key"_>(event) == program.user_id;
+
+		case CONTAINS_DISPLAY_NAME:
+		{
+			const auto &body_(body("body"));
+			return body_ && !program.displayname.empty() && has(body_, program.displayname);
+		}
+
+		case SENDER_NOTIFICATION_PERMISSION:
+			return memo.permission(key);
+
+		case ROOM_ID:
+			return json::get<"room_id"_>(event) == pattern;
+
+		case SENDER:
+			return json::get<"sender"_>(event) == pattern;
+
+		case UNKNOWN:
+			return false;
+	}
+
+	return false;
+}
+
+//
+// program::memo
+//
+
+ircd::m::push::program::memo::memo(const m::event &event,
+                                   const json::object::index *const &content)
+:event{event}
+,content{content}
+{
+}
+
+ircd::string_view
+ircd::m::push::program::memo::value(const string_view &key)
+{
+	auto it(values.lower_bound(key));
+	if(it == end(values) || it->first != key)
+		it = values.emplace_hint(it, std::string{key}, event_match_value(event, key, content));
+
+	return it->second;
+}
+
+bool
+ircd::m::push::program::memo::permission(const string_view &key)
+{
+	auto it(permitted.lower_bound(key));
+	if(it != end(permitted) && it->first == key)
+		return it->second;
+
+	const push::cond cond
+	{
+		{ "kind",  "sender_notification_permission" },
+		{ "key",   key                              },
+	};
+
+	const bool ret
+	{
+		sender_notification_permission(event, cond, match::opts{})
+	};
+
+	permitted.emplace_hint(it, std::string{key}, ret);
+	return ret;
+}
+
+int8_t &
+ircd::m::push::program::memo::result(const uint32_t &slot)
+{
+	if(slot >= results.size())
+		results.resize(cond::slots.size(), -1);
+
+	assert(slot < results.size());
+	return results[slot];
+}
+
+size_t
+ircd::m::push::program::memo::member_count()
+{
+	if(!members)
+	{
+		const m::room::members room_members
+		{
+			at<"room_id"_>(event)
+		};
+
+		members = room_members.count("join");
+	}
+
+	return *members;
+}
+
 //
 // rule
 //
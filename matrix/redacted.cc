@@ -0,0 +1,250 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m
+{
+	static bool redacted_bitmap_test(const event::idx &) noexcept;
+	static void redacted_bitmap_set(const event::idx &);
+	static void redacted_bitmap_build();
+	static void redacted_bitmap_worker();
+	static void redacted_bitmap_update(const event &, vm::eval &);
+
+	static std::vector<uint64_t> redacted_bitmap;
+	static bool redacted_bitmap_ready;
+	static bool redacted_bitmap_pending {true};
+	static ctx::dock redacted_bitmap_dock;
+	extern hookfn<vm::eval &> redacted_bitmap_hook;
+	extern context redacted_bitmap_context;
+}
+
+decltype(ircd::m::redacted::bitmap_enable)
+ircd::m::redacted::bitmap_enable
+{
+	{ "name",     "ircd.m.redacted.bitmap.enable" },
+	{ "default",  true                            },
+	{ "description",
+
+	R"(
+	Hold one bit for every event in memory indicating whether it has been
+	redacted, so timelines of rooms with many redactions are not slowed by
+	seeking the references of each event. Takes effect at the next start.
+	)"},
+};
+
+/// Bits are set after the write of the redaction (or of the redacted event
+/// arriving after its redaction) has been committed.
+decltype(ircd::m::redacted_bitmap_hook)
+ircd::m::redacted_bitmap_hook
+{
+	redacted_bitmap_update,
+	{
+		{ "_site",  "vm.notify"  },
+	}
+};
+
+decltype(ircd::m::redacted_bitmap_context)
+ircd::m::redacted_bitmap_context
+{
+	"m.redacted",
+	512_KiB,
+	context::POST,
+	redacted_bitmap_worker,
+};
+
+static const ircd::run::changed
+redacted_bitmap_terminate
+{
+	ircd::run::level::QUIT, []
+	{
+		ircd::m::redacted_bitmap_context.terminate();
+	}
+};
+
+ircd::m::redacted::redacted(const event::idx &event_idx)
+:boolean
+{
+	!event_idx?
+		false:
+
+	redacted_bitmap_ready?
+		redacted_bitmap_test(event_idx):
+
+	event::refs(event_idx).has(dbs::ref::M_ROOM_REDACTION)
+}
+{
+}
+
+/// Discards the bitmap and builds it again in the background; queries seek
+/// event::refs meanwhile. This is required after writes which bypass the
+/// notify phase of the vm (i.e. bulk loads).
+void
+ircd::m::redacted::rebuild()
+{
+	redacted_bitmap_ready = false;
+	redacted_bitmap_pending = true;
+	redacted_bitmap_dock.notify_all();
+}
+
+void
+ircd::m::redacted_bitmap_update(const event &event,
+                                vm::eval &eval)
+{
+	assert(eval.opts);
+	const auto &wopts
+	{
+		eval.opts->wopts
+	};
+
+	if(!redacted::bitmap_enable || eval.opts->edu || !eval.sequence)
+		return;
+
+	if(wopts.op != db::op::SET || !wopts.appendix[dbs::appendix::EVENT_REFS])
+		return;
+
+	// Mirrors the reference made by dbs for the redaction's target when
+	// the target exists.
+	const bool redaction
+	{
+		json::get<"type"_>(event) == "m.room.redaction"
+		&& wopts.event_refs[uint(dbs::ref::M_ROOM_REDACTION)]
+		&& valid(m::id::EVENT, json::get<"redacts"_>(event))
+	};
+
+	const event::idx target_idx
+	{
+		redaction?
+			m::index(std::nothrow, event::id(json::get<"redacts"_>(event))):
+			0UL
+	};
+
+	if(target_idx)
+		redacted_bitmap_set(target_idx);
+
+	// The event may have been redacted before it arrived; the reference was
+	// made when its horizon was resolved by this write.
+	const bool horizon
+	{
+		wopts.appendix[dbs::appendix::EVENT_HORIZON_RESOLVE]
+		&& wopts.horizon_resolve[uint(dbs::ref::M_ROOM_REDACTION)]
+	};
+
+	if(horizon && event::refs(eval.sequence).has(dbs::ref::M_ROOM_REDACTION))
+		redacted_bitmap_set(eval.sequence);
+}
+
+void
+ircd::m::redacted_bitmap_worker()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	if(!redacted::bitmap_enable)
+		return;
+
+	while(1)
+	{
+		redacted_bitmap_dock.wait([]
+		{
+			return redacted_bitmap_pending;
+		});
+
+		redacted_bitmap_pending = false;
+		redacted_bitmap_build();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Redacted bitmap worker fatal :%s",
+		e.what()
+	};
+}
+
+void
+ircd::m::redacted_bitmap_build()
+{
+	redacted_bitmap.clear();
+	redacted_bitmap.reserve((vm::sequence::retired >> 6) + 1);
+
+	auto &column
+	{
+		dbs::event_column.at(json::indexof<event, "redacts"_>())
+	};
+
+	// The iteration is over a snapshot; redactions committed after it are
+	// set by the notify hook.
+	size_t count(0), found(0);
+	for(auto it(column.begin()); it && !redacted_bitmap_pending; ++it)
+	{
+		const json::string &redacts
+		{
+			it->second
+		};
+
+		if(!valid(m::id::EVENT, redacts))
+			continue;
+
+		const auto target_idx
+		{
+			m::index(std::nothrow, event::id(redacts))
+		};
+
+		++count;
+		if(!target_idx)
+			continue;
+
+		redacted_bitmap_set(target_idx);
+		++found;
+	}
+
+	if(redacted_bitmap_pending)
+		return;
+
+	redacted_bitmap_ready = true;
+	log::info
+	{
+		log, "Redacted bitmap of %zu events from %zu redactions; %zu KiB",
+		found,
+		count,
+		redacted_bitmap.size() * sizeof(uint64_t) / 1024,
+	};
+}
+
+void
+ircd::m::redacted_bitmap_set(const event::idx &event_idx)
+{
+	const auto word
+	{
+		event_idx >> 6
+	};
+
+	if(word >= redacted_bitmap.size())
+		redacted_bitmap.resize(word + 1);
+
+	redacted_bitmap[word] |= 1UL << (event_idx & 63);
+}
+
+bool
+ircd::m::redacted_bitmap_test(const event::idx &event_idx)
+noexcept
+{
+	const auto word
+	{
+		event_idx >> 6
+	};
+
+	return word < redacted_bitmap.size()?
+		redacted_bitmap[word] & (1UL << (event_idx & 63)):
+		false;
+}
@@ -10,9 +10,21 @@
 
 namespace ircd::m
 {
-	static unique_mutable_buffer request_content_buf;
+	static bool request_verify(const request &, const ed25519::pk &, const ed25519::sig &);
+
+	extern conf::item<bool> request_verify_offload;
+
+	static thread_local unique_mutable_buffer request_content_buf;
 }
 
+decltype(ircd::m::request_verify_offload)
+ircd::m::request_verify_offload
+{
+	{ "name",     "ircd.m.request.verify.offload" },
+	{ "default",  true                            },
+	{ "help",     "Conduct request signature verification on an offload thread." },
+};
+
 decltype(ircd::m::request::headers_max)
 ircd::m::request::headers_max
 {
@@ -252,26 +264,65 @@ const
 		origin
 	};
 
-	bool verified{false};
-	node_keys.get(key, [this, &verified, &sig]
-	(const ed25519::pk &pk)
+	// The key is copied out so the verify does not yield under the fetch.
+	ed25519::pk pk;
+	const bool found
 	{
-		verified = verify(pk, sig);
-	});
+		node_keys.get(key, [&pk]
+		(const ed25519::pk &pk_)
+		{
+			pk = pk_;
+		})
+	};
 
-	return verified;
+	return found && verify(pk, sig);
 }
 
 bool
 ircd::m::request::verify(const ed25519::pk &pk,
                          const ed25519::sig &sig)
 const
+{
+	bool ret{false};
+	const auto closure{[this, &pk, &sig, &ret]
+	{
+		ret = request_verify(*this, pk, sig);
+	}};
+
+	// The content buffer is thread_local so the worker has its own; the
+	// request is kept alive on this stack for the duration.
+	if(request_verify_offload && ctx::current)
+	{
+		static const ctx::ole::opts opts
+		{
+			"m.request.verify"
+		};
+
+		ctx::offload(opts, closure);
+	}
+	else closure();
+
+	return ret;
+}
+
+bool
+ircd::m::request::verify(const ed25519::pk &pk,
+                         const ed25519::sig &sig,
+                         const json::object &object)
+{
+	return pk.verify(object, sig);
+}
+
+bool
+ircd::m::request_verify(const request &request,
+                        const ed25519::pk &pk,
+                        const ed25519::sig &sig)
 {
 	const ctx::critical_assertion ca;
-	if(unlikely(buffer::size(request_content_buf) != size_t(content_max)))
+	if(unlikely(buffer::size(request_content_buf) != size_t(request::content_max)))
 		request_content_buf = unique_mutable_buffer
 		{
-			size_t(content_max), info::page_size
+			size_t(request::content_max), info::page_size
 		};
 
 	assert(!empty(request_content_buf));
@@ -285,8 +336,8 @@ const
 	// to undefined i.e json::object{}/string_view{} but not json::object{"{}"}
 	// or even json::object{""}; rather than burdening the caller with ensuring
 	// their assignment conforms perfectly, we ensure correctness manually.
-	auto _this(*this);
-	if(empty(json::get<"content"_>(*this)))
+	auto _this(request);
+	if(empty(json::get<"content"_>(request)))
 		json::get<"content"_>(_this) = json::object{};
 
 	const size_t request_size
@@ -308,15 +359,7 @@ const
 		stringify(mutable_buffer{buf}, _this)
 	};
 
-	return verify(pk, sig, object);
-}
-
-bool
-ircd::m::request::verify(const ed25519::pk &pk,
-                         const ed25519::sig &sig,
-                         const json::object &object)
-{
-	return pk.verify(object, sig);
+	return request::verify(pk, sig, object);
 }
 
 //
@@ -10,8 +10,16 @@
 
 namespace ircd::m
 {
+	struct ratelimit;
+
 	extern conf::item<bool> x_matrix_verify_origin;
 	extern conf::item<bool> x_matrix_verify_destination;
+	extern conf::item<bool> ratelimit_enable;
+	extern conf::item<uint64_t> ratelimit_cost_default;
+	extern conf::item<uint64_t> ratelimit_cost_limited;
+	extern ratelimit ratelimit_user, ratelimit_origin, ratelimit_ip;
+
+	static void check_ratelimit(const resource::method &, const client &, const resource::request &);
 
 	static pair<string_view> parse_version(const resource::request &);
 	static string_view authenticate_bridge(const resource::method &, const client &, resource::request &);
@@ -39,6 +47,181 @@ ircd::m::x_matrix_verify_destination
 	{ "default",  true                                 },
 };
 
+/// Token buckets over a fixed table so no allocation is made for a request;
+/// the table is only touched by the main thread. A requestor is found by the
+/// hash of its identity in a set of a few buckets; one not found takes over
+/// the fullest bucket of the set, which is the one idle the longest. The
+/// tokens are counted in thousandths.
+struct ircd::m::ratelimit
+{
+	static constexpr size_t SETS {1024}, WAYS {4};
+
+	struct bucket
+	{
+		uint64_t tag {0};
+		int64_t tokens {0};
+		int64_t last {0};
+	};
+
+	conf::item<uint64_t> rate;         // tokens per second
+	conf::item<uint64_t> burst;        // bucket size in tokens
+	std::array<bucket, SETS * WAYS> table;
+
+	int64_t refill(const bucket &, const int64_t &now) const noexcept;
+
+  public:
+	// Takes the cost or returns the time until it could have been taken.
+	milliseconds operator()(const uint64_t &tag, const uint &cost) noexcept;
+
+	ratelimit(const json::members &rate, const json::members &burst);
+};
+
+decltype(ircd::m::ratelimit_enable)
+ircd::m::ratelimit_enable
+{
+	{ "name",     "ircd.m.resource.ratelimit.enable" },
+	{ "default",  true                               },
+};
+
+/// Tokens taken by a request to a method with no cost given in its options.
+decltype(ircd::m::ratelimit_cost_default)
+ircd::m::ratelimit_cost_default
+{
+	{ "name",     "ircd.m.resource.ratelimit.cost.default" },
+	{ "default",  1L                                       },
+};
+
+/// Tokens taken by a request to a RATE_LIMITED method with no cost given in
+/// its options.
+decltype(ircd::m::ratelimit_cost_limited)
+ircd::m::ratelimit_cost_limited
+{
+	{ "name",     "ircd.m.resource.ratelimit.cost.limited" },
+	{ "default",  4L                                       },
+};
+
+/// Requests authenticated by an access token, by user.
+decltype(ircd::m::ratelimit_user)
+ircd::m::ratelimit_user
+{
+	{
+		{ "name",     "ircd.m.resource.ratelimit.user.rate" },
+		{ "default",  10L                                   },
+	},
+	{
+		{ "name",     "ircd.m.resource.ratelimit.user.burst" },
+		{ "default",  100L                                   },
+	},
+};
+
+/// Requests authenticated by X-Matrix, by origin.
+decltype(ircd::m::ratelimit_origin)
+ircd::m::ratelimit_origin
+{
+	{
+		{ "name",     "ircd.m.resource.ratelimit.origin.rate" },
+		{ "default",  50L                                     },
+	},
+	{
+		{ "name",     "ircd.m.resource.ratelimit.origin.burst" },
+		{ "default",  500L                                     },
+	},
+};
+
+/// Unauthenticated requests, by IPv4 address or IPv6 /64.
+decltype(ircd::m::ratelimit_ip)
+ircd::m::ratelimit_ip
+{
+	{
+		{ "name",     "ircd.m.resource.ratelimit.ip.rate" },
+		{ "default",  5L                                  },
+	},
+	{
+		{ "name",     "ircd.m.resource.ratelimit.ip.burst" },
+		{ "default",  50L                                  },
+	},
+};
+
+ircd::m::ratelimit::ratelimit(const json::members &rate,
+                              const json::members &burst)
+:rate{rate}
+,burst{burst}
+{
+}
+
+ircd::milliseconds
+ircd::m::ratelimit::operator()(const uint64_t &tag,
+                               const uint &cost)
+noexcept
+{
+	const int64_t now
+	{
+		ircd::now<milliseconds>().count()
+	};
+
+	bucket *const set
+	{
+		table.data() + (tag % SETS) * WAYS
+	};
+
+	bucket *b(set);
+	for(size_t i(0); i < WAYS; ++i)
+		if(set[i].tag == tag)
+		{
+			b = set + i;
+			break;
+		}
+		else if(refill(set[i], now) > refill(*b, now))
+			b = set + i;
+
+	if(b->tag != tag)
+	{
+		b->tag = tag;
+		b->tokens = int64_t(burst) * 1000;
+		b->last = now;
+	}
+
+	b->tokens = refill(*b, now);
+	b->last = now;
+
+	const int64_t want
+	{
+		int64_t(cost) * 1000
+	};
+
+	if(b->tokens >= want)
+	{
+		b->tokens -= want;
+		return 0ms;
+	}
+
+	const int64_t per_ms
+	{
+		std::max(int64_t(rate), 1L)
+	};
+
+	return milliseconds
+	{
+		(want - b->tokens + per_ms - 1) / per_ms
+	};
+}
+
+int64_t
+ircd::m::ratelimit::refill(const bucket &b,
+                           const int64_t &now)
+const noexcept
+{
+	if(!b.tag)
+		return std::numeric_limits<int64_t>::max();
+
+	const int64_t elapsed
+	{
+		std::min(now - b.last, 86400L * 1000)
+	};
+
+	return std::min(b.tokens + elapsed * int64_t(rate), int64_t(burst) * 1000);
+}
+
 //
 // m::resource::method
 //
@@ -94,6 +277,21 @@ try
 			request.head.path,
 		};
 
+	if(ratelimit_enable)
+		check_ratelimit(*this, client, request);
+
+	// Attribute the request to the homeserver hosting the user.
+	if(request.user_id)
+		m::for_each([&request](homeserver &homeserver)
+		{
+			if(origin(homeserver) != request.user_id.host())
+				return true;
+
+			assert(homeserver.stats);
+			++homeserver.stats->requests;
+			return false;
+		});
+
 	const bool cached_error
 	{
 		request.node_id
@@ -150,6 +348,82 @@ catch(const ctx::timeout &e)
 	};
 }
 
+/// Requests are charged to the authenticated origin or user, otherwise to
+/// the remote address. Bridges and this server are not limited.
+void
+ircd::m::check_ratelimit(const resource::method &method,
+                         const client &client,
+                         const resource::request &request)
+{
+	if(request.bridge_id)
+		return;
+
+	if(request.node_id && my_host(request.node_id))
+		return;
+
+	const auto &ip
+	{
+		remote(client)
+	};
+
+	if(!request.node_id && !request.user_id && is_loop(ip))
+		return;
+
+	const uint cost
+	{
+		method.opts->cost?:
+		method.opts->flags & method.RATE_LIMITED?
+			uint(ratelimit_cost_limited):
+			uint(ratelimit_cost_default)
+	};
+
+	if(!cost)
+		return;
+
+	auto &limit
+	{
+		request.node_id? ratelimit_origin:
+		request.user_id? ratelimit_user:
+		ratelimit_ip
+	};
+
+	const uint64_t tag
+	{
+		request.node_id? ircd::hash(request.node_id):
+		request.user_id? ircd::hash(string_view{request.user_id}):
+		is_v6(ip)? uint64_t(host6(ip) >> 64):
+		uint64_t(host4(ip))
+	};
+
+	const milliseconds retry
+	{
+		limit(tag | 1, cost)
+	};
+
+	if(likely(retry == 0ms))
+		return;
+
+	log::dwarning
+	{
+		log, "%s %s rate limited %s `%s' retry:%ldms",
+		client.loghead(),
+		request.node_id?: string_view{request.user_id}?: "-"_sv,
+		request.head.method,
+		request.head.path,
+		retry.count(),
+	};
+
+	throw m::error
+	{
+		http::TOO_MANY_REQUESTS, json::members
+		{
+			{ "errcode",         "M_LIMIT_EXCEEDED"     },
+			{ "error",           "Too many requests."   },
+			{ "retry_after_ms",  retry.count()          },
+		}
+	};
+}
+
 //
 // resource::request
 //
@@ -241,25 +515,16 @@ ircd::m::authenticate_user(const resource::method &method,
 	if(startswith(request.access_token, "bridge_"))
 		return {};
 
-	const m::room::id::buf tokens_room_id
+	// The sender of the token is the user being authenticated; this is
+	// usually served from the token cache.
+	const m::user::id::buf owner
 	{
-		"tokens", origin(my())
+		m::user::tokens::get(std::nothrow, request.access_token)
 	};
 
-	const m::room::state tokens
-	{
-		tokens_room_id
-	};
-
-	const event::idx event_idx
-	{
-		tokens.get(std::nothrow, "ircd.access_token", request.access_token)
-	};
-
-	// The sender of the token is the user being authenticated.
 	const string_view sender
 	{
-		m::get(std::nothrow, event_idx, "sender", request.id_buf)
+		strlcpy(request.id_buf, owner)
 	};
 
 	// Note that if the endpoint does not require auth and we were not
@@ -290,26 +555,16 @@ ircd::m::authenticate_bridge(const resource::method &method,
 	if(!startswith(request.access_token, "bridge_"))
 		return {};
 
-	const m::room::id::buf tokens_room_id
-	{
-		"tokens", origin(my())
-	};
-
-	const m::room::state tokens
-	{
-		tokens_room_id
-	};
-
-	const event::idx event_idx
+	// The sender of the token is the bridge's user_id, where the bridge_id
+	// is the localpart, but none of this is a puppetting/target user_id.
+	const m::user::id::buf owner
 	{
-		tokens.get(std::nothrow, "ircd.access_token", request.access_token)
+		m::user::tokens::get(std::nothrow, request.access_token)
 	};
 
-	// The sender of the token is the bridge's user_id, where the bridge_id
-	// is the localpart, but none of this is a puppetting/target user_id.
 	const string_view sender
 	{
-		m::get(std::nothrow, event_idx, "sender", request.id_buf)
+		strlcpy(request.id_buf, owner)
 	};
 
 	// Note that unlike authenticate_user, if an as_token was proffered but is
@@ -8,16 +8,32 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	static void purge_commit(db::txn &, size_t &);
+}
+
+/// Events deleted in one transaction by a purge; the batch of a large room
+/// is committed in pieces rather than held in memory all at once.
+decltype(ircd::m::room::purge_txn_events)
+ircd::m::room::purge_txn_events
+{
+	{ "name",     "ircd.m.room.purge.txn.events" },
+	{ "default",  2048L                          },
+};
+
+/// Deletes every event of the room, committing in batches of
+/// purge_txn_events.
 size_t
 ircd::m::room::purge(const room &room)
 {
-	size_t ret(0);
+	size_t ret(0), pending(0);
 	db::txn txn
 	{
 		*m::dbs::events
 	};
 
-	room.for_each([&txn, &ret]
+	room.for_each([&txn, &ret, &pending]
 	(const m::event::idx &event_idx)
 	{
 		const m::event::fetch event
@@ -33,12 +49,84 @@ ircd::m::room::purge(const room &room)
 		opts.event_idx = event_idx;
 		m::dbs::write(txn, event, opts);
 		++ret;
+
+		if(++pending >= size_t(purge_txn_events))
+			purge_commit(txn, pending);
 	});
 
-	txn();
+	purge_commit(txn, pending);
 	return ret;
 }
 
+/// Deletes the events of the room from before the timestamp in order of
+/// depth, stopping at the first which is not. The present state of the room
+/// is never deleted; the room remains usable with its history truncated.
+size_t
+ircd::m::room::purge(const room &room,
+                     const int64_t &before_ts)
+{
+	const m::room::state state
+	{
+		room
+	};
+
+	size_t ret(0), pending(0);
+	db::txn txn
+	{
+		*m::dbs::events
+	};
+
+	m::room::events it
+	{
+		room, uint64_t(0)
+	};
+
+	for(; it; ++it)
+	{
+		const m::event::idx event_idx
+		{
+			it.event_idx()
+		};
+
+		const m::event::fetch event
+		{
+			std::nothrow, event_idx
+		};
+
+		if(!event.valid)
+			continue;
+
+		if(json::get<"origin_server_ts"_>(event) >= before_ts)
+			break;
+
+		if(defined(json::get<"state_key"_>(event)))
+			if(state.get(std::nothrow, at<"type"_>(event), at<"state_key"_>(event)) == event_idx)
+				continue;
+
+		m::dbs::write_opts opts;
+		opts.op = db::op::DELETE;
+		opts.event_idx = event_idx;
+		m::dbs::write(txn, event, opts);
+		++ret;
+
+		if(++pending >= size_t(purge_txn_events))
+			purge_commit(txn, pending);
+	}
+
+	purge_commit(txn, pending);
+	return ret;
+}
+
+void
+ircd::m::purge_commit(db::txn &txn,
+                      size_t &pending)
+{
+	txn();
+	txn.clear();
+	pending = 0;
+	m::event::fetch::invalidate();
+}
+
 ircd::m::room
 ircd::m::create(const id::room &room_id,
                 const id::user &creator,
@@ -1069,6 +1157,9 @@ ircd::m::event::idx
 ircd::m::room::index(const room::id &room_id,
                      std::nothrow_t)
 {
+	if(const auto ret{dbs::room_idx_get(room_id)}; ret)
+		return ret;
+
 	uint64_t depth{0};
 	room::events it
 	{
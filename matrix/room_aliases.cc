@@ -10,8 +10,18 @@
 
 namespace ircd::m
 {
+	using alias_cache_entry = std::pair<room::id::buf, system_point>;
+
+	static void alias_cache_remember(const string_view &key, const room::id &, const system_point &expires);
+
 	extern conf::item<seconds> alias_fetch_timeout;
 	extern conf::item<seconds> alias_cache_ttl;
+	extern conf::item<seconds> alias_cache_min;
+	extern conf::item<seconds> alias_cache_max;
+	extern conf::item<seconds> alias_cache_stale;
+	extern conf::item<size_t> alias_cache_memory_max;
+	extern std::map<std::string, alias_cache_entry, std::less<>> alias_cache_memory;
+	extern std::set<std::string, std::less<>> alias_cache_refreshing;
 }
 
 decltype(ircd::m::alias_cache_ttl)
@@ -19,8 +29,58 @@ ircd::m::alias_cache_ttl
 {
 	{ "name",    "ircd.m.room.aliases.cache.ttl" },
 	{ "default", 604800L                         },
+	{ "description",
+
+	R"(
+	Lifetime of a remote alias lookup when the directory response has no
+	Cache-Control or Expires header.
+	)"},
+};
+
+decltype(ircd::m::alias_cache_min)
+ircd::m::alias_cache_min
+{
+	{ "name",    "ircd.m.room.aliases.cache.min" },
+	{ "default", 300L                            },
+};
+
+decltype(ircd::m::alias_cache_max)
+ircd::m::alias_cache_max
+{
+	{ "name",    "ircd.m.room.aliases.cache.max" },
+	{ "default", 2592000L                        },
+};
+
+decltype(ircd::m::alias_cache_stale)
+ircd::m::alias_cache_stale
+{
+	{ "name",    "ircd.m.room.aliases.cache.stale" },
+	{ "default", 604800L                           },
+	{ "description",
+
+	R"(
+	Period after a remote alias lookup expires during which the room_id is
+	still returned without waiting, while the lookup is refreshed in the
+	background.
+	)"},
+};
+
+decltype(ircd::m::alias_cache_memory_max)
+ircd::m::alias_cache_memory_max
+{
+	{ "name",    "ircd.m.room.aliases.cache.memory.max" },
+	{ "default", 8192L                                  },
 };
 
+/// Results are held here in front of the alias room, which is then only
+/// read on a miss (e.g. after a restart).
+decltype(ircd::m::alias_cache_memory)
+ircd::m::alias_cache_memory;
+
+/// Keys of aliases with a background refresh underway.
+decltype(ircd::m::alias_cache_refreshing)
+ircd::m::alias_cache_refreshing;
+
 decltype(ircd::m::alias_fetch_timeout)
 ircd::m::alias_fetch_timeout
 {
@@ -147,6 +207,10 @@ ircd::m::room::aliases::cache::del(const alias &alias)
 		make_key(buf, alias)
 	};
 
+	const auto it(alias_cache_memory.find(key));
+	if(it != end(alias_cache_memory))
+		alias_cache_memory.erase(it);
+
 	const m::room::id::buf alias_room_id
 	{
 		"alias", origin(my())
@@ -183,7 +247,8 @@ ircd::m::room::aliases::cache::del(const alias &alias)
 
 bool
 ircd::m::room::aliases::cache::set(const alias &alias,
-                                   const id &id)
+                                   const id &id,
+                                   const seconds &ttl)
 {
 	char buf[m::id::room_alias::buf::SIZE];
 	const string_view &key
@@ -201,14 +266,31 @@ ircd::m::room::aliases::cache::set(const alias &alias,
 		alias_room_id
 	};
 
-	const auto ret
+	json::iov content;
+	const json::iov::push push[]
+	{
+		{ content, { "room_id", id } },
+	};
+
+	// The lifetime is only stored when it came from the cache headers of
+	// a directory response; otherwise the configured default applies.
+	const json::iov::add ttl_
 	{
-		send(alias_room, me(), "ircd.room.alias", key,
+		content, ttl >= seconds(0),
 		{
-			{ "room_id", id }
-		})
+			"ttl", [&ttl]
+			{
+				return json::value{ttl.count()};
+			}
+		}
 	};
 
+	const auto ret
+	{
+		send(alias_room, me(), "ircd.room.alias", key, content)
+	};
+
+	alias_cache_remember(key, id, now<system_point>() + (ttl >= seconds(0)? ttl: seconds(alias_cache_ttl)));
 	return true;
 }
 
@@ -217,6 +299,40 @@ ircd::m::room::aliases::cache::get(std::nothrow_t,
                                    const alias &alias,
                                    const id::closure &closure)
 {
+	char keybuf[m::id::room_alias::buf::SIZE];
+	const string_view &key
+	{
+		make_key(keybuf, alias)
+	};
+
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	// The hot set is answered from memory; an expired result within the
+	// stale period is answered as well while it's refreshed in the background.
+	const auto it(alias_cache_memory.find(key));
+	if(it != end(alias_cache_memory))
+	{
+		const auto &[room_id, expires](it->second);
+		const bool fresh
+		{
+			my_host(alias.host()) || now < expires
+		};
+
+		if(fresh || now < expires + seconds(alias_cache_stale))
+		{
+			// The entry may not survive the closure or a refresh.
+			const id::buf room_id_(room_id);
+			if(!fresh)
+				refresh(alias);
+
+			closure(room_id_);
+			return true;
+		}
+	}
+
 	m::event::idx event_idx
 	{
 		getidx(alias)
@@ -227,7 +343,15 @@ ircd::m::room::aliases::cache::get(std::nothrow_t,
 		!my_host(alias.host()) && (!event_idx || cache::expired(event_idx))
 	};
 
-	if(!event_idx || expired)
+	const bool stale
+	{
+		expired && event_idx && cache::age(event_idx) < cache::ttl(event_idx) + seconds(alias_cache_stale)
+	};
+
+	if(stale)
+		refresh(alias);
+
+	if(!event_idx || (expired && !stale))
 	{
 		if(my_host(alias.host()))
 			return false;
@@ -238,7 +362,7 @@ ircd::m::room::aliases::cache::get(std::nothrow_t,
 				log, "Cached alias %s expired age:%ld ttl:%ld",
 				string_view{alias},
 				cache::age(event_idx).count(),
-				milliseconds(seconds(alias_cache_ttl)).count(),
+				milliseconds(cache::ttl(event_idx)).count(),
 			};
 
 		if(!fetch(std::nothrow, alias, alias.host()))
@@ -248,8 +372,13 @@ ircd::m::room::aliases::cache::get(std::nothrow_t,
 			return false;
 	}
 
+	const system_point expires
+	{
+		now + (cache::ttl(event_idx) - cache::age(event_idx))
+	};
+
 	bool ret{false};
-	m::get(std::nothrow, event_idx, "content", [&closure, &ret]
+	m::get(std::nothrow, event_idx, "content", [&closure, &ret, &key, &expires]
 	(const json::object &content)
 	{
 		const json::string &room_id
@@ -260,6 +389,7 @@ ircd::m::room::aliases::cache::get(std::nothrow_t,
 		if(!empty(room_id))
 		{
 			ret = true;
+			alias_cache_remember(key, room_id, expires);
 			closure(room_id);
 		}
 	});
@@ -267,6 +397,60 @@ ircd::m::room::aliases::cache::get(std::nothrow_t,
 	return ret;
 }
 
+void
+ircd::m::room::aliases::cache::refresh(const alias &alias)
+try
+{
+	char keybuf[m::id::room_alias::buf::SIZE];
+	const string_view &key
+	{
+		make_key(keybuf, alias)
+	};
+
+	auto it
+	{
+		alias_cache_refreshing.lower_bound(key)
+	};
+
+	if(it != end(alias_cache_refreshing) && *it == key)
+		return;
+
+	alias_cache_refreshing.emplace_hint(it, key);
+	context
+	{
+		"m.alias.refresh", 256_KiB, context::POST | context::DETACH,
+		[alias(std::string(alias)), key(std::string(key))]
+		{
+			const unwind done{[&key]
+			{
+				alias_cache_refreshing.erase(key);
+			}};
+
+			const m::id::room_alias _alias
+			{
+				alias
+			};
+
+			log::debug
+			{
+				log, "Refreshing stale cached alias %s",
+				alias,
+			};
+
+			fetch(std::nothrow, _alias, _alias.host());
+		}
+	};
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Failed to refresh alias %s :%s",
+		string_view{alias},
+		e.what(),
+	};
+}
+
 bool
 ircd::m::room::aliases::cache::fetch(std::nothrow_t,
                                      const alias &a,
@@ -358,6 +542,16 @@ try
 		request.get(seconds(alias_fetch_timeout))
 	};
 
+	const http::response::head head
+	{
+		request.in.gethead(request)
+	};
+
+	const seconds freshness
+	{
+		http::freshness(http::headers{head.headers})
+	};
+
 	const json::object response
 	{
 		request
@@ -376,7 +570,9 @@ try
 			string_view{alias},
 		};
 
-	set(alias, m::id::room(room_id));
+	set(alias, m::id::room(room_id), freshness >= seconds(0)?
+		std::clamp(freshness, seconds(alias_cache_min), seconds(alias_cache_max)):
+		seconds(-1));
 }
 catch(const ctx::timeout &e)
 {
@@ -495,7 +691,7 @@ ircd::m::room::aliases::cache::expires(const alias &alias)
 
 	const seconds ttl
 	{
-		alias_cache_ttl
+		cache::ttl(event_idx)
 	};
 
 	return now<system_point>() + (ttl - age);
@@ -511,12 +707,27 @@ ircd::m::room::aliases::cache::expired(const event::idx &event_idx)
 
 	const seconds ttl
 	{
-		alias_cache_ttl
+		cache::ttl(event_idx)
 	};
 
 	return age > ttl;
 }
 
+ircd::seconds
+ircd::m::room::aliases::cache::ttl(const event::idx &event_idx)
+{
+	time_t ret(-1);
+	m::get(std::nothrow, event_idx, "content", [&ret]
+	(const json::object &content)
+	{
+		ret = content.get<time_t>("ttl", time_t(-1));
+	});
+
+	return ret >= 0?
+		seconds(ret):
+		seconds(alias_cache_ttl);
+}
+
 ircd::milliseconds
 ircd::m::room::aliases::cache::age(const event::idx &event_idx)
 {
@@ -586,3 +797,39 @@ ircd::m::room::aliases::cache::make_key(const mutable_buffer &out,
 
 	return key;
 }
+
+void
+ircd::m::alias_cache_remember(const string_view &key,
+                              const room::id &room_id,
+                              const system_point &expires)
+{
+	// Drop the expired results when full; if that isn't enough the
+	// arbitrary first results are dropped, to be found in the room again.
+	if(unlikely(alias_cache_memory.size() >= size_t(alias_cache_memory_max)))
+	{
+		const auto now
+		{
+			ircd::now<system_point>()
+		};
+
+		for(auto it(begin(alias_cache_memory)); it != end(alias_cache_memory);)
+			if(it->second.second < now)
+				it = alias_cache_memory.erase(it);
+			else
+				++it;
+
+		while(!alias_cache_memory.empty() && alias_cache_memory.size() >= size_t(alias_cache_memory_max))
+			alias_cache_memory.erase(begin(alias_cache_memory));
+	}
+
+	auto it
+	{
+		alias_cache_memory.lower_bound(key)
+	};
+
+	if(it == end(alias_cache_memory) || it->first != key)
+		it = alias_cache_memory.emplace_hint(it, std::string(key), alias_cache_entry{});
+
+	it->second.first = room_id;
+	it->second.second = expires;
+}
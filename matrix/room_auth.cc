@@ -328,6 +328,10 @@ ircd::m::room::auth::check(const event &event,
 		event, {authv.data(), j}
 	};
 
+	for(const auto &fetch : auth)
+		if(data.auth_power == &fetch)
+			data.auth_power_idx = fetch.event_idx;
+
 	return check(event, data);
 }
 
@@ -525,7 +529,7 @@ ircd::m::check_room_auth_rule_8(const m::event &event,
 
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		data.auth_power? *data.auth_power : m::event{}, *data.auth_create, data.auth_power_idx
 	};
 
 	// 8. If the event type's required power level is greater than the
@@ -809,6 +813,15 @@ const
 // room::auth::chain
 //
 
+/// Enumerate the auth chain from the chain cover index (dbs::event_chain)
+/// by ranges of sequence rather than fetching every event of the chain.
+decltype(ircd::m::room::auth::chain::cover)
+ircd::m::room::auth::chain::cover
+{
+	{ "name",     "ircd.m.room.auth.chain.cover" },
+	{ "default",  true                           },
+};
+
 size_t
 ircd::m::room::auth::chain::depth()
 const
@@ -846,6 +859,32 @@ const
 bool
 ircd::m::room::auth::chain::for_each(const closure &closure)
 const
+{
+	dbs::event_chain_cover ranges;
+	if(!cover || !dbs::event_chain_auth(ranges, idx))
+		return for_each_walk(closure);
+
+	// Iterated in ascending index like for_each_walk(); the chains are
+	// disjoint so every event is found once.
+	std::vector<event::idx> ae;
+	dbs::event_chain_for_each(ranges, {}, [&ae]
+	(const event::idx &event_idx)
+	{
+		ae.emplace_back(event_idx);
+		return true;
+	});
+
+	std::sort(begin(ae), end(ae));
+	for(const auto &idx : ae)
+		if(!closure(idx))
+			return false;
+
+	return true;
+}
+
+bool
+ircd::m::room::auth::chain::for_each_walk(const closure &closure)
+const
 {
 	m::event::fetch e, a;
 	std::set<event::idx> ae;
@@ -11,20 +11,26 @@
 namespace ircd::m::roomstrap
 {
 	struct pkg;
+	struct stream;
 	using send_join_response = std::tuple<json::object, unique_buffer<mutable_buffer>>;
 
 	static event::id::buf make_join(const string_view &host, const room::id &, const user::id &, const mutable_buffer &);
-	static send_join_response send_join(const string_view &host, const room::id &, const event::id &, const json::object &event);
+	static send_join_response send_join(const string_view &host, const room::id &, const event::id &, const json::object &event, const bool &omit_members, stream &);
 	static void broadcast_join(const room &, const event &, const string_view &exclude);
 	static void eval_auth_chain(const json::array &auth_chain, vm::opts);
-	static void eval_state(const json::array &state, vm::opts);
+	static void eval_auth_chain(std::vector<m::event> &auth_chain, vm::opts);
+	static void eval_state(const json::array &state, const size_t &skip, vm::opts);
+	static void eval_state(std::vector<m::event> &state, vm::opts);
 	static void backfill(const string_view &host, const room::id &, const event::id &, vm::opts);
+	static void complete_state(const string_view &host, const room &);
 	static void worker(pkg);
 
 	extern conf::item<seconds> make_join_timeout;
 	extern conf::item<seconds> send_join_timeout;
+	extern conf::item<bool> send_join_stream;
 	extern conf::item<seconds> backfill_timeout;
 	extern conf::item<size_t> backfill_limit;
+	extern conf::item<bool> omit_members;
 	extern log::log log;
 }
 
@@ -36,12 +42,60 @@ struct ircd::m::roomstrap::pkg
 	std::string room_version;
 };
 
+/// Evaluates the send_join response while it is still being received. The
+/// content is scanned as it arrives; once the auth_chain has been received
+/// in full it is evaluated, and the state following it is evaluated in
+/// batches, overlapping the remainder of the transfer. When the state
+/// arrives ahead of the auth_chain (or the content isn't received into one
+/// contiguous buffer) the stream is abandoned and whatever remains is
+/// evaluated after the response as before.
+struct ircd::m::roomstrap::stream
+{
+	static constexpr const size_t batch_max {64};
+
+	const vm::opts &vmopts;
+	json::scanner scanner {2};         // [200, {"auth_chain": [...], ...}]
+	const char *base {nullptr};
+	size_t received {0};
+	bool broken {!bool(send_join_stream)};
+	bool auth_chain_done {false};
+	size_t state_done {0};
+	std::vector<m::event> auth_chain;
+	std::vector<m::event> state;
+
+	bool handle(const string_view &key, const json::object &pdu);
+
+  public:
+	void progress(const const_buffer &) noexcept;
+	void operator()();
+	void finish(const json::object &response);
+
+	stream(const vm::opts &vmopts)
+	:vmopts{vmopts}
+	{}
+};
+
 decltype(ircd::m::roomstrap::log)
 ircd::m::roomstrap::log
 {
 	"m.room.bootstrap"
 };
 
+decltype(ircd::m::roomstrap::omit_members)
+ircd::m::roomstrap::omit_members
+{
+	{ "name",         "ircd.client.rooms.join.omit_members" },
+	{ "default",      false                                 },
+	{ "description",
+
+	R"(
+	Request a partial state (MSC3706) from the send_join. The room is usable
+	as soon as the state without the membership is evaluated; the remaining
+	state is then acquired from the servers in the room, after which the
+	initial backfill is performed and the join is broadcast.
+	)"}
+};
+
 decltype(ircd::m::roomstrap::backfill_limit)
 ircd::m::roomstrap::backfill_limit
 {
@@ -70,6 +124,13 @@ ircd::m::roomstrap::send_join_timeout
 	{ "default",  90L  /* spinappse */                       },
 };
 
+decltype(ircd::m::roomstrap::send_join_stream)
+ircd::m::roomstrap::send_join_stream
+{
+	{ "name",     "ircd.client.rooms.join.send_join.stream" },
+	{ "default",  true                                      },
+};
+
 decltype(ircd::m::roomstrap::make_join_timeout)
 ircd::m::roomstrap::make_join_timeout
 {
@@ -225,10 +286,25 @@ try
 		host
 	};
 
+	m::vm::opts vmopts;
+	vmopts.node_id = host;
+	vmopts.infolog_accept = false;
+	vmopts.warnlog &= ~vm::fault::EXISTS;
+	vmopts.nothrows = -1;
+	vmopts.room_version = room_version;
+	vmopts.phase.reset(m::vm::phase::FETCH_PREV);
+	vmopts.phase.reset(m::vm::phase::FETCH_STATE);
+	vmopts.notify_servers = false;
+
 	assert(event.source);
+	m::roomstrap::stream stream
+	{
+		vmopts
+	};
+
 	const auto &[response, buf]
 	{
-		m::roomstrap::send_join(host, room_id, event_id, event.source)
+		m::roomstrap::send_join(host, room_id, event_id, event.source, bool(m::roomstrap::omit_members), stream)
 	};
 
 	const json::array &auth_chain
@@ -241,30 +317,32 @@ try
 		response["state"]
 	};
 
+	const bool partial
+	{
+		response.get<bool>("members_omitted", false)
+	};
+
 	log::info
 	{
-		log, "Joined to %s for %s at %s to '%s' state:%zu auth_chain:%zu",
+		log, "Joined to %s for %s at %s to '%s' state:%zu auth_chain:%zu partial:%b streamed:%zu",
 		string_view{room_id},
 		string_view{user_id},
 		string_view{event_id},
 		host,
 		state.size(),
 		auth_chain.size(),
+		partial,
+		stream.state_done,
 	};
 
-	m::vm::opts vmopts;
-	vmopts.node_id = host;
-	vmopts.infolog_accept = false;
-	vmopts.warnlog &= ~vm::fault::EXISTS;
-	vmopts.nothrows = -1;
-	vmopts.room_version = room_version;
-	vmopts.phase.reset(m::vm::phase::FETCH_PREV);
-	vmopts.phase.reset(m::vm::phase::FETCH_STATE);
-	vmopts.notify_servers = false;
+	// Evaluate whatever the stream didn't while the response was arriving.
+	stream.finish(response);
 
-	m::roomstrap::eval_auth_chain(auth_chain, vmopts);
-	m::roomstrap::eval_state(state, vmopts);
-	m::roomstrap::backfill(host, room_id, event_id, vmopts);
+	// With a partial state the timeline is deferred until the membership is
+	// complete; its events would otherwise fail auth against the senders
+	// missing from the present state.
+	if(!partial)
+		m::roomstrap::backfill(host, room_id, event_id, vmopts);
 
 	// After we just received and processed all of this state with only a
 	// recent backfill our system doesn't know if state events which are
@@ -282,6 +360,12 @@ try
 	// server. Now that we have processed the state we know of more servers.
 	// They don't know about our join event though, so we conduct a synchronous
 	// broadcast to the room now manually.
+	if(partial)
+	{
+		m::roomstrap::complete_state(host, room);
+		m::roomstrap::backfill(host, room_id, event_id, vmopts);
+	}
+
 	m::roomstrap::broadcast_join(room, event, host);
 
 	log::notice
@@ -305,6 +389,111 @@ catch(const std::exception &e)
 	};
 }
 
+//
+// m::roomstrap::stream
+//
+
+void
+ircd::m::roomstrap::stream::progress(const const_buffer &content)
+noexcept
+{
+	base = base?: data(content);
+	broken |= data(content) != base;
+	received = std::max(received, size(content));
+}
+
+void
+ircd::m::roomstrap::stream::operator()()
+try
+{
+	if(broken || !base)
+		return;
+
+	scanner(string_view{base, received}, [this]
+	(const string_view &key, const json::object &pdu)
+	{
+		return handle(key, pdu);
+	});
+}
+catch(const json::error &e)
+{
+	log::derror
+	{
+		log, "send_join stream abandoned :%s",
+		e.what(),
+	};
+
+	broken = true;
+}
+
+bool
+ircd::m::roomstrap::stream::handle(const string_view &key,
+                                   const json::object &pdu)
+{
+	if(key == "auth_chain")
+	{
+		auth_chain.emplace_back(pdu);
+		return true;
+	}
+
+	if(key != "state")
+		return true;
+
+	// The state can't be evaluated before its auth_chain; when the state
+	// comes first everything is left for the end.
+	if(!auth_chain_done && auth_chain.empty())
+	{
+		broken = true;
+		return false;
+	}
+
+	if(!auth_chain_done)
+	{
+		eval_auth_chain(auth_chain, vmopts);
+		auth_chain_done = true;
+		auth_chain = {};
+	}
+
+	state.emplace_back(pdu);
+	if(state.size() < batch_max)
+		return true;
+
+	eval_state(state, vmopts);
+	state_done += state.size();
+	state.clear();
+	return true;
+}
+
+void
+ircd::m::roomstrap::stream::finish(const json::object &response)
+{
+	// The events held here are views into the content, valid only when it
+	// was received contiguously and scanned to its end; otherwise whatever
+	// remains is taken from the response.
+	const bool complete
+	{
+		!broken && scanner.done()
+	};
+
+	if(!complete)
+	{
+		auth_chain.clear();
+		state.clear();
+	}
+
+	if(!auth_chain_done && complete)
+		eval_auth_chain(auth_chain, vmopts);
+	else if(!auth_chain_done)
+		eval_auth_chain(json::array(response["auth_chain"]), vmopts);
+
+	auth_chain_done = true;
+	if(!complete)
+		return eval_state(json::array(response["state"]), state_done, vmopts);
+
+	eval_state(state, vmopts);
+	state.clear();
+}
+
 //
 // m::roomstrap
 //
@@ -500,21 +689,99 @@ catch(const std::exception &e)
 	//throw;
 }
 
+/// Acquire the state omitted from a partial send_join. The state_ids
+/// reported by the servers in the room are fetched and evaluated like any
+/// other missing state; each is authed on evaluation against the state
+/// then present.
+void
+ircd::m::roomstrap::complete_state(const string_view &host,
+                                   const m::room &room)
+try
+{
+	const size_t before
+	{
+		m::room::state(room).count()
+	};
+
+	struct m::acquire::opts opts;
+	opts.room = room;
+	opts.hint = host;
+	opts.head = false;
+	opts.history = false;
+	opts.timeline = false;
+	opts.state = true;
+	m::acquire
+	{
+		opts
+	};
+
+	const size_t after
+	{
+		m::room::state(room).count()
+	};
+
+	log::info
+	{
+		log, "Completed partial state of %s from %s state:%zu acquired:%zu",
+		string_view{room.room_id},
+		host,
+		after,
+		after - before,
+	};
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "%s partial state completion from %s :%s",
+		string_view{room.room_id},
+		string(host),
+		e.what(),
+	};
+
+	// The room remains usable with the partial state; this can be remedied
+	// later by another acquisition of the state.
+	//throw;
+}
+
 void
 ircd::m::roomstrap::eval_state(const json::array &state,
+                               const size_t &skip,
                                vm::opts vmopts)
 try
 {
 	log::info
 	{
 		log, "Evaluating %zu state events...",
-		state.size(),
+		state.size() - std::min(state.size(), skip),
 	};
 
-	m::vm::eval
+	if(!skip)
 	{
-		state, vmopts
-	};
+		m::vm::eval
+		{
+			state, vmopts
+		};
+
+		return;
+	}
+
+	auto it(begin(state));
+	for(size_t i(0); i < skip && it != end(state); ++i, ++it);
+
+	std::vector<m::event> batch;
+	batch.reserve(stream::batch_max);
+	for(; it != end(state); ++it)
+	{
+		batch.emplace_back(json::object(*it));
+		if(batch.size() < stream::batch_max)
+			continue;
+
+		eval_state(batch, vmopts);
+		batch.clear();
+	}
+
+	eval_state(batch, vmopts);
 }
 catch(const std::exception &e)
 {
@@ -529,16 +796,46 @@ catch(const std::exception &e)
 	//throw;
 }
 
+void
+ircd::m::roomstrap::eval_state(std::vector<m::event> &state,
+                               vm::opts vmopts)
+try
+{
+	if(state.empty())
+		return;
+
+	std::sort(begin(state), end(state));
+	vmopts.ordered = true;
+	m::vm::eval
+	{
+		state, vmopts
+	};
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "eval state :%s", e.what(),
+	};
+}
+
 void
 ircd::m::roomstrap::eval_auth_chain(const json::array &auth_chain_,
                                     vm::opts vmopts)
-try
 {
 	std::vector<m::event> auth_chain
 	(
 		begin(auth_chain_), end(auth_chain_)
 	);
 
+	eval_auth_chain(auth_chain, vmopts);
+}
+
+void
+ircd::m::roomstrap::eval_auth_chain(std::vector<m::event> &auth_chain,
+                                    vm::opts vmopts)
+try
+{
 	log::info
 	{
 		log, "Evaluating %zu authentication events...",
@@ -572,7 +869,9 @@ ircd::m::roomstrap::send_join_response
 ircd::m::roomstrap::send_join(const string_view &host,
                               const m::room::id &room_id,
                               const m::event::id &event_id,
-                              const json::object &event)
+                              const json::object &event,
+                              const bool &omit_members,
+                              stream &stream)
 try
 {
 	const unique_buffer<mutable_buffer> buf
@@ -580,17 +879,49 @@ try
 		16_KiB // headers in and out
 	};
 
+	char ridbuf[768], eidbuf[768], uribuf[2048];
 	m::fed::send_join::opts opts{host};
+	if(omit_members)
+		json::get<"uri"_>(opts.request) = fmt::sprintf
+		{
+			uribuf, "/_matrix/federation/v1/send_join/%s/%s?omit_members=true",
+			url::encode(ridbuf, room_id),
+			url::encode(eidbuf, event_id),
+		};
 	m::fed::send_join send_join
 	{
 		room_id, event_id, event, buf, std::move(opts)
 	};
 
+	// No content has been received yet; none can be until this context
+	// yields, so the progress callback is safely installed after the fact.
+	send_join.in.progress = [&stream]
+	(const const_buffer &, const const_buffer &content) noexcept
+	{
+		stream.progress(content);
+	};
+
+	const auto deadline
+	{
+		now<system_point>() + seconds(send_join_timeout)
+	};
+
+	while(!send_join.wait(milliseconds(50), std::nothrow))
+	{
+		if(unlikely(now<system_point>() >= deadline))
+			throw ctx::timeout{};
+
+		stream();
+	}
+
 	const auto send_join_code
 	{
-		send_join.get(seconds(send_join_timeout))
+		send_join.get()
 	};
 
+	stream.progress(send_join.in.content);
+	stream();
+
 	const json::array send_join_response
 	{
 		send_join
@@ -10,10 +10,91 @@
 
 namespace ircd::m
 {
+	struct room_head_cache_entry;
+	using room_head_cache_map = std::map<std::string, room_head_cache_entry, std::less<>>;
+
 	static void append_v1(json::stack::array &, const event::id &);
 	static void append_v3(json::stack::array &, const event::id &);
+	static void room_head_cache_update(const event &, vm::eval &);
+	static void room_head_reduce_worker();
+
+	static room_head_cache_map room_head_cache;
+	static std::set<std::string, std::less<>> room_head_reduce_rooms;
+	static ctx::dock room_head_reduce_dock;
+	extern hookfn<vm::eval &> room_head_cache_hook;
+	extern context room_head_reduce_context;
 }
 
+/// Heads of a room kept in memory by depth. An entry is marked while the
+/// column is read for it; a write to the room during that read marks it
+/// stale and it is not retained.
+struct ircd::m::room_head_cache_entry
+{
+	std::map<event::idx, int64_t> depth;
+	std::set<std::pair<int64_t, event::idx>, std::greater<>> sorted;
+	bool building {false};
+	bool stale {false};
+};
+
+decltype(ircd::m::room::head::cache_enable)
+ircd::m::room::head::cache_enable
+{
+	{ "name",     "ircd.m.room.head.cache.enable" },
+	{ "default",  true                            },
+};
+
+decltype(ircd::m::room::head::cache_rooms_max)
+ircd::m::room::head::cache_rooms_max
+{
+	{ "name",     "ircd.m.room.head.cache.rooms.max" },
+	{ "default",  4096L                              },
+};
+
+/// Rooms with more heads than this have them merged by dummy events from
+/// one of our members; zero disables the reduction.
+decltype(ircd::m::room::head::reduce_threshold)
+ircd::m::room::head::reduce_threshold
+{
+	{ "name",     "ircd.m.room.head.reduce.threshold" },
+	{ "default",  64L                                 },
+};
+
+decltype(ircd::m::room::head::reduce_rounds)
+ircd::m::room::head::reduce_rounds
+{
+	{ "name",     "ircd.m.room.head.reduce.rounds" },
+	{ "default",  8L                               },
+};
+
+/// The cached heads are updated after the write is committed, like the
+/// room_head column by the INDEX phase.
+decltype(ircd::m::room_head_cache_hook)
+ircd::m::room_head_cache_hook
+{
+	room_head_cache_update,
+	{
+		{ "_site",  "vm.notify"  },
+	}
+};
+
+decltype(ircd::m::room_head_reduce_context)
+ircd::m::room_head_reduce_context
+{
+	"m.room.head",
+	512_KiB,
+	context::POST,
+	room_head_reduce_worker,
+};
+
+static const ircd::run::changed
+room_head_reduce_terminate
+{
+	ircd::run::level::QUIT, []
+	{
+		ircd::m::room_head_reduce_context.terminate();
+	}
+};
+
 ircd::m::room::head::generate::generate(const mutable_buffer &buf,
                                         const m::room::head &head,
                                         const opts &opts)
@@ -69,40 +150,20 @@ try
 	if(opts.need_top_head)
 		top_head = m::top(std::nothrow, head.room.room_id);
 
-	// Iterate the room head; starts with oldest events
+	// Iterate the room head; starts with the deepest events, so a large head
+	// is bounded by the limit to the references most useful to the room.
 	bool need_top_head{opts.need_top_head};
 	bool need_my_head{opts.need_my_head};
 	ssize_t limit(opts.limit);
-	head.for_each([&](const event::idx &event_idx, const event::id &event_id)
+	for(const auto &[depth, event_idx] : head.sorted())
 	{
-		// Determine the depth for metrics
-		const int64_t depth
-		{
-			event_id == std::get<0>(top_head)?
-				std::get<int64_t>(top_head):
-				m::get<int64_t>(std::nothrow, event_idx, "depth", -1L)
-		};
-
-		if(unlikely(depth < 0))
-		{
-			log::derror
-			{
-				log, "Missing depth for %s idx:%lu in room head of %s",
-				string_view{event_id},
-				event_idx,
-				string_view{head.room.room_id},
-			};
-
-			return true;
-		}
-
 		// When using the need_my_head option, if we hit a head which
 		// originated from this server we mark that is no longer needed.
 		if(need_my_head && event::my(event_idx))
 			need_my_head = false;
 
 		// If we hit the top_head during the loop we can mark that satisfied.
-		if(need_top_head && event_id == std::get<0>(top_head))
+		if(need_top_head && event_idx == std::get<2>(top_head))
 			need_top_head = false;
 
 		// Two reference slots are reserved to fulfill these features; the
@@ -114,7 +175,11 @@ try
 
 		// Skip/continue the loop if all that remains are reserved slots.
 		if(remain <= 0)
-			return true;
+			continue;
+
+		event::id::buf event_id;
+		if(unlikely(!m::event_id(std::nothrow, event_idx, event_id)))
+			continue;
 
 		// Add this head reference to result to output.
 		append(out, event_id);
@@ -124,8 +189,9 @@ try
 		this->depth[1] = std::max(depth, this->depth[1]);
 
 		// Continue loop until we're out of slots.
-		return --limit > 0;
-	});
+		if(--limit <= 0)
+			break;
+	}
 
 	// If the iteration did not provide us with the top_head and the opts
 	// require it, we add that here.
@@ -277,6 +343,338 @@ const
 	return true;
 }
 
+/// Heads of the room by descending depth. These are from the cache when the
+/// room is cached, otherwise the column is read for them and the cache is
+/// filled unless another context is already doing so.
+ircd::m::room::head::list
+ircd::m::room::head::sorted()
+const
+{
+	list ret;
+	if(!room)
+		return ret;
+
+	const auto it
+	{
+		room_head_cache.find(string_view{room.room_id})
+	};
+
+	if(it != end(room_head_cache) && !it->second.building)
+	{
+		ret.assign(begin(it->second.sorted), end(it->second.sorted));
+		return ret;
+	}
+
+	const bool build
+	{
+		cache_enable && it == end(room_head_cache)
+	};
+
+	if(build)
+	{
+		if(room_head_cache.size() >= size_t(cache_rooms_max))
+			room_head_cache.erase(begin(room_head_cache));
+
+		room_head_cache[std::string(room.room_id)].building = true;
+	}
+
+	for_each([this, &ret]
+	(const event::idx &event_idx, const event::id &event_id)
+	{
+		const int64_t depth
+		{
+			m::get<int64_t>(std::nothrow, event_idx, "depth", -1L)
+		};
+
+		if(unlikely(depth < 0))
+		{
+			log::derror
+			{
+				log, "Missing depth for %s idx:%lu in room head of %s",
+				string_view{event_id},
+				event_idx,
+				string_view{room.room_id},
+			};
+
+			return true;
+		}
+
+		ret.emplace_back(depth, event_idx);
+		return true;
+	});
+
+	std::sort(begin(ret), end(ret), std::greater<>{});
+	if(!build)
+		return ret;
+
+	const auto jt
+	{
+		room_head_cache.find(string_view{room.room_id})
+	};
+
+	if(jt == end(room_head_cache) || !jt->second.building)
+		return ret;
+
+	if(jt->second.stale)
+	{
+		room_head_cache.erase(jt);
+		return ret;
+	}
+
+	auto &entry(jt->second);
+	for(const auto &[depth, event_idx] : ret)
+	{
+		entry.depth.emplace(event_idx, depth);
+		entry.sorted.emplace(depth, event_idx);
+	}
+
+	entry.building = false;
+	return ret;
+}
+
+void
+ircd::m::room::head::invalidate(const id &room_id)
+noexcept
+{
+	const auto it
+	{
+		room_head_cache.find(string_view{room_id})
+	};
+
+	if(it != end(room_head_cache) && it->second.building)
+		it->second.stale = true;
+	else if(it != end(room_head_cache))
+		room_head_cache.erase(it);
+}
+
+void
+ircd::m::room_head_cache_update(const event &event,
+                                vm::eval &eval)
+{
+	assert(eval.opts);
+	const auto &opts
+	{
+		*eval.opts
+	};
+
+	if(opts.edu || !json::get<"room_id"_>(event))
+		return;
+
+	const room::id &room_id
+	{
+		at<"room_id"_>(event)
+	};
+
+	if(!room_head_cache.count(string_view{room_id}))
+		return;
+
+	if(!opts.phase[vm::phase::INDEX] || !opts.phase[vm::phase::WRITE])
+		return;
+
+	// The write of an event evaluated in the POST phase of another is not
+	// committed until the other is; those heads are read again later.
+	const bool parent_post
+	{
+		eval.parent && eval.parent->phase == vm::phase::POST
+	};
+
+	if(parent_post || opts.wopts.op != db::op::SET || !eval.sequence)
+	{
+		room::head::invalidate(room_id);
+		return;
+	}
+
+	// Mirrors the ROOM_HEAD modulation of the vm's write_append().
+	const bool dummy_event
+	{
+		json::get<"type"_>(event) == "org.matrix.dummy_event"
+	};
+
+	const bool add
+	{
+		opts.wopts.appendix[dbs::appendix::ROOM_HEAD]
+		&& (!dummy_event || my(event))
+	};
+
+	const bool resolve
+	{
+		opts.wopts.appendix[dbs::appendix::ROOM_HEAD_RESOLVE]
+	};
+
+	// The references are found before the entry; these queries may yield.
+	const event::prev prev{event};
+	std::vector<event::idx> resolved;
+	if(resolve)
+	{
+		resolved.reserve(prev.prev_events_count());
+		for(size_t i(0); i < prev.prev_events_count(); ++i)
+			resolved.emplace_back(m::index(std::nothrow, prev.prev_event(i)));
+	}
+
+	const auto it
+	{
+		room_head_cache.find(string_view{room_id})
+	};
+
+	if(it == end(room_head_cache))
+		return;
+
+	auto &entry(it->second);
+	if(entry.building)
+	{
+		entry.stale = true;
+		return;
+	}
+
+	for(const auto &event_idx : resolved)
+	{
+		const auto jt
+		{
+			entry.depth.find(event_idx)
+		};
+
+		if(jt == end(entry.depth))
+			continue;
+
+		entry.sorted.erase({jt->second, jt->first});
+		entry.depth.erase(jt);
+	}
+
+	if(add)
+	{
+		const int64_t depth
+		{
+			json::get<"depth"_>(event)
+		};
+
+		if(entry.depth.emplace(eval.sequence, depth).second)
+			entry.sorted.emplace(depth, eval.sequence);
+	}
+
+	// Our own dummy events don't start another reduction; the worker
+	// continues through its rounds for the room.
+	const bool reduce
+	{
+		room::head::reduce_threshold
+		&& !dummy_event
+		&& !eval.room_internal
+		&& entry.depth.size() > size_t(room::head::reduce_threshold)
+	};
+
+	if(!reduce)
+		return;
+
+	room_head_reduce_rooms.emplace(room_id);
+	room_head_reduce_dock.notify_one();
+}
+
+void
+ircd::m::room_head_reduce_worker()
+try
+{
+	while(1)
+	{
+		room_head_reduce_dock.wait([]
+		{
+			return !room_head_reduce_rooms.empty();
+		});
+
+		const std::string room_id
+		{
+			std::move(room_head_reduce_rooms.extract(begin(room_head_reduce_rooms)).value())
+		};
+
+		const room::head head
+		{
+			room::id{room_id}
+		};
+
+		room::head::reduce(head);
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Room head reduction worker fatal :%s",
+		e.what()
+	};
+}
+
+/// Merges the heads of the room with dummy events from one of our members
+/// until there are no more than the threshold or the rounds are exhausted.
+/// Each dummy event references as many heads as a send does and becomes
+/// the single head in their place. Returns the number of heads reduced.
+size_t
+ircd::m::room::head::reduce(const head &head)
+try
+{
+	const auto &room{head.room};
+	const auto before
+	{
+		head.sorted().size()
+	};
+
+	if(before <= size_t(reduce_threshold))
+		return 0;
+
+	const auto sender
+	{
+		m::any_user(room, my_host(), "join")
+	};
+
+	if(!sender)
+		return 0;
+
+	size_t after(before), rounds(0);
+	for(; rounds < size_t(reduce_rounds) && after > size_t(reduce_threshold); ++rounds)
+	{
+		m::send(room, sender, "org.matrix.dummy_event", json::object{json::empty_object});
+
+		const auto count
+		{
+			head.sorted().size()
+		};
+
+		// No progress; e.g. heads which can't be referenced.
+		if(count >= after)
+			break;
+
+		after = count;
+	}
+
+	log::info
+	{
+		log, "Reduced the head of %s from %zu to %zu with %zu dummy events by %s",
+		string_view{room.room_id},
+		before,
+		after,
+		rounds,
+		string_view{sender},
+	};
+
+	return before - after;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Failed to reduce the head of %s :%s",
+		string_view{head.room.room_id},
+		e.what(),
+	};
+
+	return 0;
+}
+
 //
 // special tools
 //
@@ -340,6 +738,7 @@ ircd::m::room::head::reset(const head &head)
 
 	// Commit txn
 	txn();
+	invalidate(room.room_id);
 	return ret;
 }
 
@@ -378,6 +777,7 @@ ircd::m::room::head::rebuild(const head &head)
 	}
 
 	txn();
+	invalidate(head.room.room_id);
 	return ret;
 }
 
@@ -406,4 +806,5 @@ ircd::m::room::head::modify(const m::event::id &event_id,
 
 	// Commit txn
 	txn();
+	invalidate(at<"room_id"_>(event));
 }
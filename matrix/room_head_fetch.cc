@@ -191,7 +191,11 @@ ircd::m::room::head::fetch::fetch(const opts &opts,
 	fopts.closure_errors = false; // exceptions wil not propagate feds::execute
 	fopts.exclude_myself = true;
 	fopts.timeout = milliseconds(timeout);
-	feds::execute(fopts, [this, &opts, &top, &top_ots, &closure, &result]
+	fopts.quorum = opts.quorum;
+
+	// Servers in a row which reported nothing new.
+	size_t concordant {0};
+	feds::execute(fopts, [this, &opts, &top, &top_ots, &closure, &result, &concordant]
 	(const auto &response)
 	{
 		m::event event
@@ -242,46 +246,53 @@ ircd::m::room::head::fetch::fetch(const opts &opts,
 			json::get<"depth"_>(result) = depth;
 		}
 
-		size_t i(0);
-		return m::for_each(prev, [this, &opts, &closure, &result, &i]
-		(const event::id &event_id)
+		size_t i(0), added(0);
+		const bool ret
 		{
-			if(unlikely(i++ > opts.max_results_per_server))
-				return true;
-
-			if(unlikely(this->head.size() >= opts.max_results))
-				return false;
-
-			auto it
+			m::for_each(prev, [this, &opts, &closure, &result, &i, &added]
+			(const event::id &event_id)
 			{
-				this->head.lower_bound(event_id)
-			};
-
-			if(likely(opts.unique))
-				if(it != std::end(this->head) && *it == event_id)
-				{
-					++this->concur;
+				if(unlikely(i++ > opts.max_results_per_server))
 					return true;
-				}
 
-			if(likely(!opts.existing))
-				if(m::exists(event_id))
+				if(unlikely(this->head.size() >= opts.max_results))
+					return false;
+
+				auto it
 				{
-					++this->exists;
-					return true;
+					this->head.lower_bound(event_id)
+				};
+
+				if(likely(opts.unique))
+					if(it != std::end(this->head) && *it == event_id)
+					{
+						++this->concur;
+						return true;
+					}
+
+				if(likely(!opts.existing))
+					if(m::exists(event_id))
+					{
+						++this->exists;
+						return true;
+					}
+
+				if(likely(opts.unique))
+				{
+					it = this->head.emplace_hint(it, event_id);
+					result.event_id = *it;
 				}
+				else result.event_id = event_id;
 
-			if(likely(opts.unique))
-			{
-				it = this->head.emplace_hint(it, event_id);
-				result.event_id = *it;
-			}
-			else result.event_id = event_id;
+				++added;
+				if(likely(closure))
+					return closure(result);
 
-			if(likely(closure))
-				return closure(result);
+				return true;
+			})
+		};
 
-			return true;
-		});
+		concordant = added? 0: concordant + 1;
+		return ret && (!opts.converge || concordant < opts.converge);
 	});
 }
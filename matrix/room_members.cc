@@ -53,6 +53,29 @@ ircd::m::room::members::count(const string_view &membership,
                               const string_view &host)
 const
 {
+	// The materialized counters cover the present state without a host.
+	dbs::room_counts_vector counts;
+	const bool counted
+	{
+		!host
+		&& !room.event_id
+		&& dbs::room_counts_get(counts, room.room_id)
+	};
+
+	const auto slot
+	{
+		dbs::room_counts_membership(membership)
+	};
+
+	if(counted && slot >= 0)
+		return std::max(counts[slot], 0L);
+
+	if(counted && !membership)
+		return std::max(std::accumulate
+		(
+			begin(counts) + dbs::ROOM_COUNTS_JOIN, end(counts), 0L
+		), 0L);
+
 	size_t ret{0};
 	for_each(membership, host, closure{[&ret]
 	(const user::id &user_id)
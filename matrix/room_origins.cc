@@ -8,6 +8,127 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using room_origins_cache_map = std::map<std::string, std::shared_ptr<const room::origins::list>, std::less<>>;
+
+	static room_origins_cache_map room_origins_cache;
+	static uint64_t room_origins_invalidations;
+	static void room_origins_invalidate(const event &, vm::eval &);
+	extern hookfn<vm::eval &> room_origins_invalidate_hook;
+}
+
+decltype(ircd::m::room::origins::cache_enable)
+ircd::m::room::origins::cache_enable
+{
+	{ "name",     "ircd.m.room.origins.cache.enable" },
+	{ "default",  true                               },
+};
+
+decltype(ircd::m::room::origins::cache_rooms_max)
+ircd::m::room::origins::cache_rooms_max
+{
+	{ "name",     "ircd.m.room.origins.cache.rooms.max" },
+	{ "default",  4096L                                 },
+};
+
+/// Rooms with fewer servers than this are not cached; iterating room_joined
+/// for them is already about as cheap as the cache.
+decltype(ircd::m::room::origins::cache_origins_min)
+ircd::m::room::origins::cache_origins_min
+{
+	{ "name",     "ircd.m.room.origins.cache.origins.min" },
+	{ "default",  8L                                      },
+};
+
+/// The list is dropped again after the write is committed; a list rebuilt
+/// by another context between the index and the commit of a membership
+/// change is not retained.
+decltype(ircd::m::room_origins_invalidate_hook)
+ircd::m::room_origins_invalidate_hook
+{
+	room_origins_invalidate,
+	{
+		{ "_site",  "vm.notify"      },
+		{ "type",   "m.room.member"  },
+	}
+};
+
+void
+ircd::m::room_origins_invalidate(const event &event,
+                                 vm::eval &)
+{
+	room::origins::invalidate(at<"room_id"_>(event));
+}
+
+void
+ircd::m::room::origins::invalidate(const id &room_id)
+noexcept
+{
+	++room_origins_invalidations;
+	const auto it
+	{
+		room_origins_cache.find(string_view{room_id})
+	};
+
+	if(it != end(room_origins_cache))
+		room_origins_cache.erase(it);
+}
+
+/// The list of origins of the room from the cache, building it when absent.
+/// The list is sorted like the room_joined iteration. Null is returned when
+/// the room is not cached.
+std::shared_ptr<const ircd::m::room::origins::list>
+ircd::m::room::origins::cached()
+const
+{
+	if(!cache_enable)
+		return {};
+
+	const auto it
+	{
+		room_origins_cache.find(string_view{room.room_id})
+	};
+
+	if(it != end(room_origins_cache))
+		return it->second;
+
+	const auto invalidations
+	{
+		room_origins_invalidations
+	};
+
+	list origins;
+	for_each_walk([&origins]
+	(const string_view &origin)
+	{
+		origins.emplace_back(origin);
+		return true;
+	});
+
+	if(origins.size() < size_t(cache_origins_min))
+		return {};
+
+	// Membership may have changed while the walk yielded; the list is not
+	// retained and the caller walks the column itself.
+	if(invalidations != room_origins_invalidations)
+		return {};
+
+	if(room_origins_cache.count(string_view{room.room_id}))
+		return room_origins_cache.find(string_view{room.room_id})->second;
+
+	if(room_origins_cache.size() >= size_t(cache_rooms_max))
+		room_origins_cache.erase(begin(room_origins_cache));
+
+	auto ptr
+	{
+		std::make_shared<const list>(std::move(origins))
+	};
+
+	room_origins_cache.emplace(room.room_id, ptr);
+	return ptr;
+}
+
 ircd::string_view
 ircd::m::room::origins::random(const mutable_buffer &buf,
                                const closure_bool &proffer)
@@ -167,6 +288,9 @@ bool
 ircd::m::room::origins::has(const string_view &origin)
 const
 {
+	if(const auto list{cached()}; list)
+		return std::binary_search(begin(*list), end(*list), origin, std::less<>{});
+
 	db::domain &index
 	{
 		dbs::room_joined
@@ -214,6 +338,22 @@ const
 bool
 ircd::m::room::origins::for_each(const closure_bool &view)
 const
+{
+	if(const auto list{cached()}; list)
+	{
+		for(const auto &origin : *list)
+			if(!view(origin))
+				return false;
+
+		return true;
+	}
+
+	return for_each_walk(view);
+}
+
+bool
+ircd::m::room::origins::for_each_walk(const closure_bool &view)
+const
 {
 	db::domain &index
 	{
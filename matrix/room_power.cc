@@ -8,6 +8,14 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using power_cache_entry = std::pair<event::idx, std::shared_ptr<const room::power::table>>;
+
+	static std::list<power_cache_entry> power_cache_lru;
+	static std::map<event::idx, decltype(power_cache_lru)::iterator> power_cache;
+}
+
 ircd::m::room::power::revoke::revoke(json::stack::object &out,
                                      const room::power &power,
                                      const pair<string_view> &prop_key)
@@ -173,6 +181,16 @@ ircd::m::room::power::default_user_level
 	{ "default",  0L                                     },
 };
 
+/// Number of parsed power_levels kept by event_idx (see compile()). The
+/// content at an event_idx never changes so an entry is never stale; a change
+/// to the room's power levels is a new event_idx and the prior ages out.
+decltype(ircd::m::room::power::cache_max)
+ircd::m::room::power::cache_max
+{
+	{ "name",     "ircd.m.room.power.cache.max" },
+	{ "default",  1024L                         },
+};
+
 ircd::json::object
 ircd::m::room::power::default_content(const mutable_buffer &buf,
                                       const m::user::id &creator)
@@ -309,16 +327,23 @@ ircd::m::room::power::power(const m::room &room,
 {
 	power_event_idx
 }
+,power_table
+{
+	compile(power_event_idx)
+}
 {
 }
 
 ircd::m::room::power::power(const m::event &power_event,
-                            const m::event &create_event)
+                            const m::event &create_event,
+                            const event::idx &power_event_idx)
 :power
 {
 	power_event, m::user::id(unquote(json::get<"content"_>(create_event).get("creator")))
 }
 {
+	if(power_event_idx)
+		power_table = compile(power_event_idx, json::get<"content"_>(power_event));
 }
 
 ircd::m::room::power::power(const m::event &power_event,
@@ -383,6 +408,17 @@ int64_t
 ircd::m::room::power::level_user(const m::user::id &user_id)
 const try
 {
+	if(power_table)
+	{
+		const auto *const level
+		{
+			table::find(power_table->users, user_id)?:
+			table::find(power_table->levels, "users_default")
+		};
+
+		return level? *level: int64_t(default_user_level);
+	}
+
 	int64_t ret
 	{
 		default_user_level
@@ -430,10 +466,53 @@ catch(const json::error &e)
 	return default_user_level;
 }
 
+int64_t
+ircd::m::room::power::level_notification(const string_view &key)
+const
+{
+	if(power_table)
+	{
+		const auto *const level
+		{
+			table::find(power_table->notifications, key)
+		};
+
+		return level? *level: int64_t(default_power_level);
+	}
+
+	int64_t ret
+	{
+		default_power_level
+	};
+
+	for_each("notifications", [&ret, &key]
+	(const auto &name, const auto &level)
+	{
+		if(name != key)
+			return true;
+
+		ret = level;
+		return false;
+	});
+
+	return ret;
+}
+
 int64_t
 ircd::m::room::power::level_event(const string_view &type)
 const try
 {
+	if(power_table)
+	{
+		const auto *const level
+		{
+			table::find(power_table->events, type)?:
+			table::find(power_table->levels, "events_default")
+		};
+
+		return level? *level: int64_t(default_event_level);
+	}
+
 	int64_t ret
 	{
 		default_event_level
@@ -480,6 +559,17 @@ const try
 	if(!defined(state_key))
 		return level_event(type);
 
+	if(power_table)
+	{
+		const auto *const level
+		{
+			table::find(power_table->events, type)?:
+			table::find(power_table->levels, "state_default")
+		};
+
+		return level? *level: int64_t(default_power_level);
+	}
+
 	int64_t ret
 	{
 		default_power_level
@@ -522,6 +612,16 @@ int64_t
 ircd::m::room::power::level(const string_view &prop)
 const try
 {
+	if(power_table)
+	{
+		const auto *const level
+		{
+			table::find(power_table->levels, prop)
+		};
+
+		return level? *level: int64_t(default_power_level);
+	}
+
 	int64_t ret
 	{
 		default_power_level
@@ -787,3 +887,88 @@ noexcept
 {
 	return lex_castable<int64_t>(value);
 }
+
+//
+// room::power::table
+//
+
+std::shared_ptr<const ircd::m::room::power::table>
+ircd::m::room::power::compile(const event::idx &event_idx,
+                              const json::object &content)
+{
+	if(!event_idx)
+		return {};
+
+	const auto it
+	{
+		power_cache.find(event_idx)
+	};
+
+	if(it != end(power_cache))
+	{
+		power_cache_lru.splice(begin(power_cache_lru), power_cache_lru, it->second);
+		return it->second->second;
+	}
+
+	std::shared_ptr<const table> ret;
+	if(content)
+		ret = std::make_shared<const table>(content);
+	else
+		m::get(std::nothrow, event_idx, "content", [&ret]
+		(const json::object &content)
+		{
+			ret = std::make_shared<const table>(content);
+		});
+
+	// The fetch yielded; another context may have put the same entry.
+	if(!ret || !cache_max || power_cache.count(event_idx))
+		return ret;
+
+	power_cache_lru.emplace_front(event_idx, ret);
+	power_cache.emplace(event_idx, begin(power_cache_lru));
+	while(power_cache.size() > size_t(cache_max))
+	{
+		power_cache.erase(power_cache_lru.back().first);
+		power_cache_lru.pop_back();
+	}
+
+	return ret;
+}
+
+ircd::m::room::power::table::table(const json::object &content)
+{
+	const auto collect{[]
+	(map &out, const json::object &object)
+	{
+		for(const auto &[key, val] : object)
+			if(is_level(val))
+				out.emplace(key, as_level(val));
+	}};
+
+	collect(levels, content);
+	for(const auto &[key, val] : content)
+	{
+		if(!json::type(val, json::OBJECT))
+			continue;
+
+		if(key == "events" && events.empty())
+			collect(events, val);
+		else if(key == "users" && users.empty())
+			collect(users, val);
+		else if(key == "notifications" && notifications.empty())
+			collect(notifications, val);
+	}
+}
+
+const int64_t *
+ircd::m::room::power::table::find(const map &map,
+                                  const string_view &key)
+noexcept
+{
+	const auto it
+	{
+		map.find(key)
+	};
+
+	return it != end(map)? &it->second: nullptr;
+}
@@ -8,6 +8,67 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using server_acl_cache_entry = std::pair<event::idx, std::shared_ptr<const room::server_acl::compiled>>;
+
+	static std::list<server_acl_cache_entry> server_acl_cache_lru;
+	static std::map<event::idx, decltype(server_acl_cache_lru)::iterator> server_acl_cache;
+}
+
+/// The content of an m.room.server_acl event is compiled once (see compile())
+/// and matched by every check afterward; this is the number of them kept. The
+/// key is the event_idx of the ACL so a change to the room's ACL is compiled
+/// anew and the prior is left to age out. Zero disables the cache.
+decltype(ircd::m::room::server_acl::cache_max)
+ircd::m::room::server_acl::cache_max
+{
+	{ "name",     "ircd.m.room.server_acl.cache.max" },
+	{ "default",  512L                               },
+};
+
+/// Compiled form of the m.room.server_acl content. Expressions in each list
+/// without wildcards are kept for exact match. Expressions of a wildcard
+/// followed by a literal (i.e. `*.example.org`) are kept in a trie of the
+/// reversed literal so they're all matched in one pass over the host. Any
+/// other expression is kept for globular match. All matching is case
+/// insensitive like globular_imatch.
+struct ircd::m::room::server_acl::compiled
+{
+	struct list;
+
+	bool deny_ip_literals {false};
+	std::unique_ptr<const list> deny;
+	std::unique_ptr<const list> allow;
+
+	bool operator()(const net::hostport &server) const;
+
+	compiled(const json::object &content);
+	~compiled() noexcept;
+};
+
+struct ircd::m::room::server_acl::compiled::list
+{
+	struct node
+	{
+		std::map<char, uint32_t> next;
+		bool term {false};
+	};
+
+	bool any {false};
+	std::set<std::string, iless> exact;
+	std::vector<node> suffix;
+	std::vector<std::string> glob;
+
+	void add_suffix(const string_view &);
+	void add(const string_view &expr);
+
+  public:
+	bool operator()(const string_view &host) const;
+
+	list(const json::array &);
+};
+
 /// Coarse control over whether ACL's are considered during the vm::eval of an
 /// event, ACL's will be checked against the event's origin during processing
 /// of the event, regardless of how the event was received, fetched, etc. The
@@ -143,6 +204,16 @@ bool
 ircd::m::room::server_acl::operator()(const net::hostport &server)
 const
 {
+	if(!content && event_idx)
+	{
+		const auto acl
+		{
+			compile(event_idx)
+		};
+
+		return !acl || (*acl)(server);
+	}
+
 	bool ret;
 	const auto closure{[this, &server, &ret]
 	(const json::object &content)
@@ -326,3 +397,199 @@ const
 
 	return event_idx && m::get(std::nothrow, event_idx, "content", closure);
 }
+
+//
+// server_acl::compiled
+//
+
+std::shared_ptr<const ircd::m::room::server_acl::compiled>
+ircd::m::room::server_acl::compile(const event::idx &event_idx)
+{
+	if(!event_idx)
+		return {};
+
+	const auto it
+	{
+		server_acl_cache.find(event_idx)
+	};
+
+	if(it != end(server_acl_cache))
+	{
+		server_acl_cache_lru.splice(begin(server_acl_cache_lru), server_acl_cache_lru, it->second);
+		return it->second->second;
+	}
+
+	std::shared_ptr<const compiled> ret;
+	m::get(std::nothrow, event_idx, "content", [&ret]
+	(const json::object &content)
+	{
+		ret = std::make_shared<const compiled>(content);
+	});
+
+	// The fetch yielded; another context may have put the same entry.
+	if(!ret || !cache_max || server_acl_cache.count(event_idx))
+		return ret;
+
+	server_acl_cache_lru.emplace_front(event_idx, ret);
+	server_acl_cache.emplace(event_idx, begin(server_acl_cache_lru));
+	while(server_acl_cache.size() > size_t(cache_max))
+	{
+		server_acl_cache.erase(server_acl_cache_lru.back().first);
+		server_acl_cache_lru.pop_back();
+	}
+
+	return ret;
+}
+
+ircd::m::room::server_acl::compiled::compiled(const json::object &content)
+:deny_ip_literals
+{
+	content["allow_ip_literals"] == json::literal_false
+}
+,deny
+{
+	std::make_unique<const list>(json::array{content["deny"]})
+}
+,allow
+{
+	std::make_unique<const list>(json::array{content["allow"]})
+}
+{
+}
+
+ircd::m::room::server_acl::compiled::~compiled()
+noexcept
+{
+}
+
+/// Same rules as server_acl::check() in the same order.
+bool
+ircd::m::room::server_acl::compiled::operator()(const net::hostport &server)
+const
+{
+	const string_view &host
+	{
+		net::host(server)
+	};
+
+	if(deny_ip_literals)
+		if(rfc3986::valid(std::nothrow, rfc3986::parser::ip_address, host))
+			return false;
+
+	if((*deny)(host))
+		return false;
+
+	if((*allow)(host))
+		return true;
+
+	return false;
+}
+
+ircd::m::room::server_acl::compiled::list::list(const json::array &array)
+{
+	if(!array || !json::type(array, json::ARRAY))
+		return;
+
+	for(auto it(begin(array)); it != end(array); ++it)
+		if(json::type(*it, json::STRING, json::strict))
+			add(json::string(*it));
+}
+
+void
+ircd::m::room::server_acl::compiled::list::add(const string_view &expr)
+{
+	if(expr.find_first_of("*?") == expr.npos)
+	{
+		exact.emplace(expr);
+		return;
+	}
+
+	// Any number of leading '*' matches anything prefixing the remainder;
+	// when the remainder is literal this is a suffix match.
+	const string_view literal
+	{
+		lstrip(expr, '*')
+	};
+
+	if(!literal)
+		any = true;
+	else if(literal.find_first_of("*?") == literal.npos)
+		add_suffix(literal);
+	else
+		glob.emplace_back(expr);
+}
+
+void
+ircd::m::room::server_acl::compiled::list::add_suffix(const string_view &literal)
+{
+	if(suffix.empty())
+		suffix.emplace_back();
+
+	uint32_t pos(0);
+	for(auto it(literal.rbegin()); it != literal.rend(); ++it)
+	{
+		const char c
+		{
+			char(tolower(*it))
+		};
+
+		const auto next
+		{
+			suffix[pos].next.find(c)
+		};
+
+		if(next != end(suffix[pos].next))
+		{
+			pos = next->second;
+			continue;
+		}
+
+		const uint32_t child(suffix.size());
+		suffix[pos].next.emplace(c, child);
+		suffix.emplace_back();
+		pos = child;
+	}
+
+	suffix[pos].term = true;
+}
+
+bool
+ircd::m::room::server_acl::compiled::list::operator()(const string_view &host)
+const
+{
+	if(any)
+		return true;
+
+	if(exact.count(host))
+		return true;
+
+	if(!suffix.empty())
+	{
+		uint32_t pos(0);
+		for(auto it(host.rbegin()); it != host.rend(); ++it)
+		{
+			const auto next
+			{
+				suffix[pos].next.find(char(tolower(*it)))
+			};
+
+			if(next == end(suffix[pos].next))
+				break;
+
+			pos = next->second;
+			if(suffix[pos].term)
+				return true;
+		}
+	}
+
+	return std::any_of(begin(glob), end(glob), [&host]
+	(const std::string &expr)
+	{
+		const globular_imatch match
+		{
+			expr
+		};
+
+		return match(host);
+	});
+}
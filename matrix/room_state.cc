@@ -518,6 +518,68 @@ const
 	return ret;
 }
 
+/// The cells of the excluded type are not read; rather than filtering
+/// them the iteration seeks over them, which matters for m.room.member in
+/// a room with a large membership.
+bool
+ircd::m::room::state::for_each_except(const string_view &except,
+                                      const closure_bool &closure)
+const
+{
+	if(!present())
+		return for_each(closure_bool{[&except, &closure]
+		(const string_view &type, const string_view &state_key, const event::idx &event_idx)
+		{
+			return type == except || closure(type, state_key, event_idx);
+		}});
+
+	db::gopts opts
+	{
+		this->fopts? this->fopts->gopts : db::gopts{}
+	};
+
+	if(!opts.readahead)
+		opts.readahead = size_t(readahead_size);
+
+	bool found(false);
+	auto &column{dbs::room_state};
+	for(auto it{column.begin(room_id, opts)}; bool(it); ++it)
+	{
+		const auto key(dbs::room_state_key(it->first));
+		if((found = std::get<0>(key) == except))
+			break;
+
+		const byte_view<event::idx> idx(it->second);
+		if(!closure(std::get<0>(key), std::get<1>(key), idx))
+			return false;
+	}
+
+	if(!found)
+		return true;
+
+	// Types can't contain a NUL, so all keys of the excluded type sort
+	// before the type suffixed with \x01, and any other type after it.
+	char keybuf[dbs::ROOM_STATE_KEY_MAX_SIZE + 1];
+	mutable_buffer buf{keybuf, sizeof(keybuf)};
+	consume(buf, size(dbs::room_state_key(buf, room_id, except)));
+	consume(buf, copy(buf, '\x01'));
+	const string_view seek
+	{
+		keybuf, data(buf)
+	};
+
+	for(auto it{column.begin(seek, opts)}; bool(it); ++it)
+	{
+		const auto key(dbs::room_state_key(it->first));
+		assert(std::get<0>(key) != except);
+		const byte_view<event::idx> idx(it->second);
+		if(!closure(std::get<0>(key), std::get<1>(key), idx))
+			return false;
+	}
+
+	return true;
+}
+
 void
 ircd::m::room::state::for_each(const string_view &type,
                                const event::closure &closure)
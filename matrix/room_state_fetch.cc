@@ -28,6 +28,7 @@ ircd::m::room::state::fetch::fetch(const opts &opts,
 	fopts.arg[0] = "ids";
 	fopts.exclude_myself = true;
 	fopts.closure_errors = false;
+	fopts.quorum = opts.quorum;
 	log::debug
 	{
 		log, "Resynchronizing %s state at %s from %zu joined servers...",
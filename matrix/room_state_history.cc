@@ -13,6 +13,13 @@
 // room::state::history
 //
 
+decltype(ircd::m::room::state::history::step_max)
+ircd::m::room::state::history::step_max
+{
+	{ "name",     "ircd.m.room.state.history.step_max" },
+	{ "default",  8L                                   },
+};
+
 ircd::m::room::state::history::history(const m::room &room)
 :history
 {
@@ -168,6 +175,11 @@ const
 	return for_each(type, string_view{}, closure);
 }
 
+/// Iterates the state at the bound. The state-space holds every version of
+/// each (type, state_key) in descending depth; versions newer than the bound
+/// and those older than the version taken are passed over by seeking once
+/// stepping through them exceeds step_max, so the cost is proportional to
+/// the state at the bound rather than the length of the room's history.
 bool
 ircd::m::room::state::history::for_each(const string_view &type,
                                         const string_view &state_key,
@@ -176,28 +188,81 @@ const
 {
 	char type_buf[m::event::TYPE_MAX_SIZE];
 	char state_key_buf[m::event::STATE_KEY_MAX_SIZE];
+	char key_buf[dbs::ROOM_STATE_SPACE_KEY_MAX_SIZE];
 
 	string_view last_type;
 	string_view last_state_key;
 
-	return space.for_each(type, state_key, [&]
-	(const auto &type, const auto &state_key, const auto &depth, const auto &event_idx)
+	const auto &room_id
 	{
-		if(bound > -1 && depth >= bound && event_idx != this->event_idx)
-			return true;
+		space.room.room_id
+	};
 
-		if(type == last_type && state_key == last_state_key)
-			return true;
+	auto it
+	{
+		dbs::room_state_space.begin(dbs::room_state_space_key
+		(
+			key_buf, room_id, type, state_key, type? -1L: 0L, 0UL
+		))
+	};
 
-		if(!closure(type, state_key, depth, event_idx))
-			return false;
+	for(size_t steps(0); it; )
+	{
+		const auto &[_type, _state_key, _depth, _event_idx]
+		{
+			dbs::room_state_space_key(it->first)
+		};
 
-		if(type != last_type)
-			last_type = { type_buf, copy(type_buf, type) };
+		if(type && type != _type)
+			break;
 
-		if(state_key != last_state_key)
-			last_state_key = { state_key_buf, copy(state_key_buf, state_key) };
+		if(state_key && state_key != _state_key)
+			break;
 
-		return true;
-	});
+		const bool taken
+		{
+			_type == last_type && _state_key == last_state_key
+		};
+
+		const bool ahead
+		{
+			!taken && bound > -1 && _depth >= bound && _event_idx != this->event_idx
+		};
+
+		if(!taken && !ahead)
+		{
+			if(!closure(_type, _state_key, _depth, _event_idx))
+				return false;
+
+			if(_type != last_type)
+				last_type = { type_buf, copy(type_buf, _type) };
+
+			if(_state_key != last_state_key)
+				last_state_key = { state_key_buf, copy(state_key_buf, _state_key) };
+
+			steps = 0;
+			++it;
+			continue;
+		}
+
+		// Versions at the bound itself are stepped; the seek would land on
+		// or before them again.
+		if(++steps < step_max || (ahead && _depth <= bound))
+		{
+			++it;
+			continue;
+		}
+
+		const string_view &key
+		{
+			taken?
+				dbs::room_state_space_key(key_buf, room_id, _type, _state_key, 0L, 0UL):
+				dbs::room_state_space_key(key_buf, room_id, _type, _state_key, bound, this->event_idx)
+		};
+
+		steps = 0;
+		db::seek(it, key);
+	}
+
+	return true;
 }
@@ -0,0 +1,566 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m
+{
+	struct resolve_node;
+	using resolve_nodes = std::map<event::idx, resolve_node>;
+	using resolve_set = std::set<event::idx>;
+	using resolve_order = std::vector<event::idx>;
+	using resolve_maps = room::state::resolve::state_maps;
+	using resolve_state = room::state::resolve::state_map;
+
+	static const resolve_node *resolve_load(resolve_nodes &, const event::idx &);
+	static int64_t resolve_sender_level(resolve_nodes &, const room &, const resolve_node &);
+	static bool resolve_auth_difference_cover(resolve_set &, const resolve_maps &);
+	static void resolve_auth_difference_walk(resolve_set &, const resolve_maps &);
+	static resolve_order resolve_power_sort(resolve_nodes &, const room &, const resolve_set &);
+	static resolve_order resolve_mainline_sort(resolve_nodes &, const resolve_set &, const event::idx &power);
+	static size_t resolve_iterate(resolve_state &, resolve_nodes &, const resolve_order &);
+}
+
+/// The few properties of an event the algorithm sorts and selects with,
+/// loaded once for each event involved.
+struct ircd::m::resolve_node
+{
+	std::string type;
+	std::string state_key;
+	std::string sender;
+	std::string event_id;
+	int64_t ts {0};
+	int64_t level {-1};
+	std::vector<event::idx> auth;
+	bool power {false};
+	bool member_joining {false};
+};
+
+decltype(ircd::m::room::state::resolve::chain_cover)
+ircd::m::room::state::resolve::chain_cover
+{
+	{ "name",     "ircd.m.room.state.resolve.chain_cover" },
+	{ "default",  true                                    },
+};
+
+ircd::m::room::state::resolve::resolve(const m::room::id &room_id,
+                                       const vector_view<const event::id> &event_ids)
+:resolve{[&room_id, &event_ids]
+{
+	std::vector<state_map> sets(event_ids.size());
+	for(size_t i(0); i < event_ids.size(); ++i)
+	{
+		const history history
+		{
+			room_id, event_ids[i]
+		};
+
+		history.for_each([&sets, &i]
+		(const auto &type, const auto &state_key, const auto &depth, const auto &event_idx)
+		{
+			sets[i].emplace(cell{type, state_key}, event_idx);
+			return true;
+		});
+	}
+
+	return resolve
+	{
+		room_id, state_maps{sets}
+	};
+}()}
+{
+}
+
+ircd::m::room::state::resolve::resolve(const m::room &room,
+                                       const state_maps &sets)
+:room{room}
+{
+	if(sets.empty())
+		return;
+
+	// Split the unconflicted state, which is the same cell with the same
+	// event in every set, from the conflicted events.
+	resolve_set conflicted;
+	state_map unconflicted;
+	for(size_t i(0); i < sets.size(); ++i)
+		for(const auto &[cell, event_idx] : sets[i])
+		{
+			bool agree(true);
+			for(size_t j(0); j < sets.size() && agree; ++j)
+			{
+				const auto it(sets[j].find(cell));
+				agree = it != end(sets[j]) && it->second == event_idx;
+			}
+
+			if(agree)
+				unconflicted.emplace(cell, event_idx);
+			else
+				conflicted.emplace(event_idx);
+		}
+
+	this->state = unconflicted;
+	this->conflicted = conflicted.size();
+	if(conflicted.empty())
+		return;
+
+	// The full conflicted set is the conflicted events and their auth
+	// difference; the auth difference is the events in some but not all of
+	// the auth chains of the sets.
+	resolve_set full;
+	const bool covered
+	{
+		bool(chain_cover)
+		&& resolve_auth_difference_cover(full, sets)
+	};
+
+	if(!covered)
+	{
+		full.clear();
+		resolve_auth_difference_walk(full, sets);
+	}
+
+	this->auth_difference = full.size();
+	full.insert(begin(conflicted), end(conflicted));
+
+	resolve_nodes nodes;
+	for(auto it(begin(full)); it != end(full); )
+		if(!resolve_load(nodes, *it))
+			it = full.erase(it);
+		else
+			++it;
+
+	// The power events of the full conflicted set and the events of their
+	// auth chains in the full conflicted set are ordered and authed first.
+	resolve_set power;
+	for(const auto &event_idx : full)
+	{
+		if(!nodes.at(event_idx).power)
+			continue;
+
+		power.emplace(event_idx);
+		room::auth::chain{event_idx}.for_each([&full, &power]
+		(const event::idx &auth_idx)
+		{
+			if(full.count(auth_idx))
+				power.emplace(auth_idx);
+
+			return true;
+		});
+	}
+
+	const auto power_order
+	{
+		resolve_power_sort(nodes, room, power)
+	};
+
+	this->rejected += resolve_iterate(this->state, nodes, power_order);
+
+	// The remaining events are ordered by the mainline of the resolved
+	// power levels and authed on top of that state.
+	resolve_set others;
+	std::set_difference
+	(
+		begin(full), end(full),
+		begin(power), end(power),
+		std::inserter(others, end(others))
+	);
+
+	const auto pl_it
+	{
+		this->state.find(cell{"m.room.power_levels", ""})
+	};
+
+	const auto mainline_order
+	{
+		resolve_mainline_sort(nodes, others, pl_it != end(this->state)? pl_it->second: 0UL)
+	};
+
+	this->rejected += resolve_iterate(this->state, nodes, mainline_order);
+
+	// Finally the unconflicted state is reapplied over the result.
+	for(const auto &[cell, event_idx] : unconflicted)
+		this->state[cell] = event_idx;
+
+	log::debug
+	{
+		m::log, "Resolved %zu sets in %s conflicted:%zu auth_difference:%zu rejected:%zu cover:%b",
+		sets.size(),
+		string_view{room.room_id},
+		this->conflicted,
+		this->auth_difference,
+		this->rejected,
+		covered,
+	};
+}
+
+//
+// internal
+//
+
+/// Each event of the order is authed against the state resolved so far,
+/// using the resolved events for the cells it is authed by in preference
+/// to its own auth_events; it is applied to the state when it passes.
+size_t
+ircd::m::resolve_iterate(resolve_state &state,
+                         resolve_nodes &nodes,
+                         const resolve_order &order)
+{
+	size_t ret(0);
+	m::event::fetch event;
+	for(const auto &event_idx : order)
+	{
+		const auto &node
+		{
+			nodes.at(event_idx)
+		};
+
+		const bool is_member
+		{
+			node.type == "m.room.member"
+		};
+
+		const resolve_state::key_type cells[event::auth::MAX]
+		{
+			{ "m.room.create",        ""              },
+			{ "m.room.power_levels",  ""              },
+			{ "m.room.member",        node.sender     },
+			{ is_member && node.member_joining? "m.room.join_rules"s: std::string{}, ""  },
+			{ is_member && node.state_key != node.sender? "m.room.member"s: std::string{}, node.state_key },
+		};
+
+		size_t num(0);
+		event::idx idxs[event::auth::MAX] {0};
+		for(const auto &cell : cells)
+		{
+			if(cell.first.empty())
+				continue;
+
+			const auto it(state.find(cell));
+			if(it != end(state))
+			{
+				idxs[num++] = it->second;
+				continue;
+			}
+
+			for(const auto &auth_idx : node.auth)
+			{
+				const auto *const auth(resolve_load(nodes, auth_idx));
+				if(auth && auth->type == cell.first && auth->state_key == cell.second)
+				{
+					idxs[num++] = auth_idx;
+					break;
+				}
+			}
+		}
+
+		if(!seek(std::nothrow, event, event_idx))
+		{
+			++ret;
+			continue;
+		}
+
+		const auto &[pass, fail]
+		{
+			node.type == "m.room.create"?
+				room::auth::passfail{true, {}}:
+				room::auth::check(event, vector_view<event::idx>(idxs, num))
+		};
+
+		if(!pass)
+		{
+			++ret;
+			continue;
+		}
+
+		state[{node.type, node.state_key}] = event_idx;
+	}
+
+	return ret;
+}
+
+/// Reverse topological power ordering: an event comes after all events of
+/// the set in its auth chain; ties are broken by the greater power of the
+/// sender, then the earlier origin_server_ts, then the lesser event_id.
+ircd::m::resolve_order
+ircd::m::resolve_power_sort(resolve_nodes &nodes,
+                            const room &room,
+                            const resolve_set &set)
+{
+	std::map<event::idx, size_t> degree;
+	std::multimap<event::idx, event::idx> rdeps;
+	for(const auto &event_idx : set)
+	{
+		auto &node(nodes.at(event_idx));
+		node.level = resolve_sender_level(nodes, room, node);
+		auto &deg(degree[event_idx]);
+		room::auth::chain{event_idx}.for_each([&set, &rdeps, &deg, &event_idx]
+		(const event::idx &auth_idx)
+		{
+			if(!set.count(auth_idx))
+				return true;
+
+			rdeps.emplace(auth_idx, event_idx);
+			++deg;
+			return true;
+		});
+	}
+
+	const auto cmp{[&nodes]
+	(const event::idx &a, const event::idx &b)
+	{
+		const auto &na(nodes.at(a)), &nb(nodes.at(b));
+		if(na.level != nb.level)
+			return na.level > nb.level;
+
+		if(na.ts != nb.ts)
+			return na.ts < nb.ts;
+
+		return na.event_id < nb.event_id;
+	}};
+
+	std::set<event::idx, decltype(cmp)> ready{cmp};
+	for(const auto &[event_idx, deg] : degree)
+		if(!deg)
+			ready.emplace(event_idx);
+
+	resolve_order ret;
+	ret.reserve(set.size());
+	while(!ready.empty())
+	{
+		const auto event_idx(*begin(ready));
+		ready.erase(begin(ready));
+		ret.emplace_back(event_idx);
+
+		const auto pit(rdeps.equal_range(event_idx));
+		for(auto it(pit.first); it != pit.second; ++it)
+			if(!--degree.at(it->second))
+				ready.emplace(it->second);
+	}
+
+	// A cycle would leave events unordered; they are not authed.
+	assert(ret.size() == set.size());
+	return ret;
+}
+
+/// Mainline ordering: the events are ordered by the position of the closest
+/// power levels event of the mainline reached through their auth_events,
+/// then by the earlier origin_server_ts, then by the lesser event_id.
+ircd::m::resolve_order
+ircd::m::resolve_mainline_sort(resolve_nodes &nodes,
+                               const resolve_set &set,
+                               const event::idx &power)
+{
+	const auto auth_power{[&nodes]
+	(const event::idx &event_idx) -> event::idx
+	{
+		const auto *const node(resolve_load(nodes, event_idx));
+		if(node)
+			for(const auto &auth_idx : node->auth)
+			{
+				const auto *const auth(resolve_load(nodes, auth_idx));
+				if(auth && auth->type == "m.room.power_levels" && auth->state_key.empty())
+					return auth_idx;
+			}
+
+		return 0;
+	}};
+
+	// Position zero is reserved for events reaching no mainline event; the
+	// mainline is numbered from the end nearest the create event.
+	std::vector<event::idx> line;
+	for(auto idx(power); idx; idx = auth_power(idx))
+		line.emplace_back(idx);
+
+	std::map<event::idx, size_t> position;
+	for(size_t i(0); i < line.size(); ++i)
+		position.emplace(line[i], line.size() - i);
+
+	std::map<event::idx, size_t> depth;
+	for(const auto &event_idx : set)
+	{
+		size_t pos(0);
+		for(auto idx(event_idx); idx; idx = auth_power(idx))
+		{
+			const auto it(position.find(idx));
+			if(it != end(position))
+			{
+				pos = it->second;
+				break;
+			}
+		}
+
+		depth.emplace(event_idx, pos);
+	}
+
+	resolve_order ret(begin(set), end(set));
+	std::sort(begin(ret), end(ret), [&nodes, &depth]
+	(const event::idx &a, const event::idx &b)
+	{
+		const auto &na(nodes.at(a)), &nb(nodes.at(b));
+		const auto &da(depth.at(a)), &db(depth.at(b));
+		if(da != db)
+			return da < db;
+
+		if(na.ts != nb.ts)
+			return na.ts < nb.ts;
+
+		return na.event_id < nb.event_id;
+	});
+
+	return ret;
+}
+
+/// The auth difference from the chain cover of each set: an event at
+/// (chain, seq) is in the auth chain of a set iff the set's cover reaches
+/// seq in that chain. The difference of each chain is then the sequence
+/// range between the least and greatest cover of the sets. False is
+/// returned when the cover is not available for every event.
+bool
+ircd::m::resolve_auth_difference_cover(resolve_set &out,
+                                       const resolve_maps &sets)
+{
+	std::vector<dbs::event_chain_cover> covers(sets.size());
+	for(size_t i(0); i < sets.size(); ++i)
+		for(const auto &[cell, event_idx] : sets[i])
+		{
+			dbs::event_chain_pos pos;
+			dbs::event_chain_cover cover;
+			if(!dbs::event_chain_get(pos, cover, event_idx))
+				return false;
+
+			dbs::event_chain_merge(covers[i], cover);
+		}
+
+	dbs::event_chain_cover un;
+	for(const auto &cover : covers)
+		dbs::event_chain_merge(un, cover);
+
+	// The intersection takes the lesser sequence of the chains every cover
+	// reaches.
+	dbs::event_chain_cover in(covers.at(0));
+	for(size_t i(1); i < covers.size(); ++i)
+	{
+		dbs::event_chain_cover intersect;
+		auto jt(begin(covers[i]));
+		for(const auto &[chain, seq] : in)
+		{
+			while(jt != end(covers[i]) && jt->first < chain)
+				++jt;
+
+			if(jt != end(covers[i]) && jt->first == chain)
+				intersect.emplace_back(chain, std::min(seq, jt->second));
+		}
+
+		in = std::move(intersect);
+	}
+
+	dbs::event_chain_for_each(un, in, [&out]
+	(const event::idx &event_idx)
+	{
+		out.emplace(event_idx);
+		return true;
+	});
+
+	return true;
+}
+
+void
+ircd::m::resolve_auth_difference_walk(resolve_set &out,
+                                      const resolve_maps &sets)
+{
+	std::vector<resolve_set> chains(sets.size());
+	for(size_t i(0); i < sets.size(); ++i)
+		for(const auto &[cell, event_idx] : sets[i])
+			room::auth::chain{event_idx}.for_each([&chains, &i]
+			(const event::idx &auth_idx)
+			{
+				chains[i].emplace(auth_idx);
+				return true;
+			});
+
+	resolve_set un, in(chains.at(0));
+	for(const auto &chain : chains)
+	{
+		un.insert(begin(chain), end(chain));
+
+		resolve_set intersect;
+		std::set_intersection
+		(
+			begin(in), end(in),
+			begin(chain), end(chain),
+			std::inserter(intersect, end(intersect))
+		);
+
+		in = std::move(intersect);
+	}
+
+	std::set_difference
+	(
+		begin(un), end(un),
+		begin(in), end(in),
+		std::inserter(out, end(out))
+	);
+}
+
+int64_t
+ircd::m::resolve_sender_level(resolve_nodes &nodes,
+                              const room &room,
+                              const resolve_node &node)
+{
+	event::idx power_idx(0);
+	for(const auto &auth_idx : node.auth)
+	{
+		const auto *const auth(resolve_load(nodes, auth_idx));
+		if(auth && auth->type == "m.room.power_levels" && auth->state_key.empty())
+			power_idx = auth_idx;
+	}
+
+	const room::power power
+	{
+		room, power_idx
+	};
+
+	return power.level_user(node.sender);
+}
+
+const ircd::m::resolve_node *
+ircd::m::resolve_load(resolve_nodes &nodes,
+                      const event::idx &event_idx)
+{
+	auto it(nodes.lower_bound(event_idx));
+	if(it != end(nodes) && it->first == event_idx)
+		return &it->second;
+
+	const m::event::fetch event
+	{
+		std::nothrow, event_idx
+	};
+
+	if(!event.valid)
+		return nullptr;
+
+	resolve_node node;
+	node.type = json::get<"type"_>(event);
+	node.state_key = json::get<"state_key"_>(event);
+	node.sender = json::get<"sender"_>(event);
+	node.event_id = event.event_id;
+	node.ts = json::get<"origin_server_ts"_>(event);
+	node.power = room::auth::is_power_event(event);
+	node.member_joining =
+		node.type == "m.room.member"
+		&& (membership(event) == "join" || membership(event) == "invite");
+
+	const event::auth auth{event};
+	event::idx auth_idxs[event::auth::MAX];
+	for(const auto &auth_idx : auth.idxs(auth_idxs))
+		if(auth_idx)
+			node.auth.emplace_back(auth_idx);
+
+	it = nodes.emplace_hint(it, event_idx, std::move(node));
+	return &it->second;
+}
@@ -194,6 +194,11 @@ const
 
 ircd::m::room::state::space::rebuild::rebuild(const room::id &room_id)
 {
+	const ctx::priority priority
+	{
+		ctx::sched::BACKGROUND
+	};
+
 	db::txn txn
 	{
 		*m::dbs::events
@@ -31,6 +31,10 @@ ircd::m::room::stats::bytes_total_compressed(const m::room &room)
 size_t
 ircd::m::room::stats::bytes_json(const m::room &room)
 {
+	dbs::room_counts_vector counts;
+	if(dbs::room_counts_get(counts, room.room_id))
+		return std::max(counts[dbs::ROOM_COUNTS_BYTES_JSON], 0L);
+
 	size_t ret(0);
 	for(m::room::events it(room); it; --it)
 	{
@@ -64,3 +68,17 @@ ircd::m::room::stats::bytes_json_compressed(const m::room &room)
 		"Not yet implemented."
 	};
 }
+
+size_t
+ircd::m::room::stats::events(const m::room &room)
+{
+	dbs::room_counts_vector counts;
+	if(dbs::room_counts_get(counts, room.room_id))
+		return std::max(counts[dbs::ROOM_COUNTS_EVENTS], 0L);
+
+	size_t ret(0);
+	for(m::room::events it(room); it; --it)
+		++ret;
+
+	return ret;
+}
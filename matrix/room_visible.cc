@@ -161,3 +161,167 @@ ircd::m::visible_to_node(const m::room &room,
 
 	return false;
 }
+
+//
+// visibility
+//
+
+ircd::m::visibility::visibility(const m::room::id &room_id,
+                                const string_view &mxid)
+:room_id
+{
+	room_id
+}
+,mxid
+{
+	mxid
+}
+{
+	const bool is_node
+	{
+		!empty(mxid) && rfc3986::valid_remote(std::nothrow, mxid)
+	};
+
+	const bool is_user
+	{
+		!is_node && !empty(mxid) && m::valid(m::id::USER, mxid)
+	};
+
+	if(!empty(mxid) && !is_node && !is_user)
+		throw m::UNSUPPORTED
+		{
+			"Cannot determine visibility of %s for '%s'",
+			string_view{room_id},
+			mxid,
+		};
+
+	const m::room room
+	{
+		room_id
+	};
+
+	if(is_node)
+		origin = m::room::origins(room).has(mxid);
+
+	if(is_user)
+	{
+		unrestricted = is_oper(m::user::id(mxid));
+		present = m::membership(room, m::user::id(mxid), m::membership_positive);
+	}
+
+	// Each change of either value is collected by depth and event_idx, the
+	// other value is carried forward after sorting.
+	const m::room::state::space space
+	{
+		room
+	};
+
+	using change = std::tuple<int64_t, event::idx, bool, char>;
+	std::vector<change> changes;
+	space.for_each("m.room.history_visibility", "", [&changes]
+	(const auto &type, const auto &state_key, const auto &depth, const auto &event_idx)
+	{
+		char value('s');
+		m::get(std::nothrow, event_idx, "content", [&value]
+		(const json::object &content)
+		{
+			const json::string &history_visibility
+			{
+				content.get("history_visibility", "shared")
+			};
+
+			value = history_visibility? history_visibility[0] : 's';
+		});
+
+		changes.emplace_back(depth, event_idx, true, value);
+		return true;
+	});
+
+	if(is_user)
+		space.for_each("m.room.member", mxid, [&changes]
+		(const auto &type, const auto &state_key, const auto &depth, const auto &event_idx)
+		{
+			char buf[m::room::MEMBERSHIP_MAX_SIZE];
+			const string_view membership
+			{
+				m::membership(buf, event_idx)
+			};
+
+			changes.emplace_back(depth, event_idx, false, membership? membership[0] : 0);
+			return true;
+		});
+
+	std::sort(begin(changes), end(changes));
+
+	point cur;
+	points.reserve(changes.size());
+	for(const auto &[depth, event_idx, is_visibility, value] : changes)
+	{
+		cur.depth = depth;
+		(is_visibility? cur.history_visibility : cur.membership) = value;
+		if(!points.empty() && points.back().depth == cur.depth)
+			points.back() = cur;
+		else
+			points.emplace_back(cur);
+	}
+}
+
+/// Same rules as visible(event, mxid) with the state at the event found
+/// by its depth.
+bool
+ircd::m::visibility::operator()(const m::event &event)
+const
+{
+	const auto it
+	{
+		std::upper_bound(begin(points), end(points), json::get<"depth"_>(event), []
+		(const int64_t &depth, const point &p)
+		{
+			return depth < p.depth;
+		})
+	};
+
+	const point state
+	{
+		it != begin(points)? *std::prev(it) : point{}
+	};
+
+	if(state.history_visibility == 'w')
+		return true;
+
+	if(empty(mxid))
+		return false;
+
+	if(rfc3986::valid_remote(std::nothrow, mxid))
+	{
+		if(m::room::auth::is_power_event(event))
+			return true;
+
+		if(m::valid(m::id::USER, json::get<"state_key"_>(event)))
+			if(m::user::id(at<"state_key"_>(event)).host() == mxid)
+				return true;
+
+		return origin;
+	}
+
+	if(unrestricted)
+		return true;
+
+	if(json::get<"type"_>(event) == "m.room.member")
+		if(json::get<"state_key"_>(event) == mxid)
+			return true;
+
+	if(state.membership == 'j')
+		return true;
+
+	if(state.history_visibility == 'j')
+		return false;
+
+	if(state.membership == 'i')
+		return true;
+
+	if(state.history_visibility == 'i')
+		return false;
+
+	return present;
+}
@@ -218,6 +218,22 @@ ircd::m::sync::item::item(std::string name,
 	{ "name",     conf_name[1] },
 	{ "default",  false        },
 }
+,stats_calls
+{
+	{ "name", fmt::snstringf{128, "ircd.m.sync.%s.calls", this->name()} },
+}
+,stats_cycles
+{
+	{ "name", fmt::snstringf{128, "ircd.m.sync.%s.cycles", this->name()} },
+}
+,stats_yields
+{
+	{ "name", fmt::snstringf{128, "ircd.m.sync.%s.yields", this->name()} },
+}
+,stats_bytes
+{
+	{ "name", fmt::snstringf{128, "ircd.m.sync.%s.bytes", this->name()} },
+}
 ,_polylog
 {
 	std::move(polylog)
@@ -263,6 +279,35 @@ noexcept
 	};
 }
 
+/// Accumulates the cost of one handler call into the item's stats. Cycles
+/// are those of the calling context only; work an item fans out to the sync
+/// pool is not included. Yields are counted as the proxy for blocking reads
+/// since a db read which misses the cache yields the ctx.
+struct ircd::m::sync::item::account
+{
+	item &i;
+	const json::stack *const out;
+	const uint64_t cycles;
+	const uint64_t yields;
+	const size_t appended;
+
+	account(item &i, const data &data) noexcept
+	:i{i}
+	,out{data.out}
+	,cycles{this_ctx::cycles()}
+	,yields{ctx::prof::get(ctx::cur(), ctx::prof::event::YIELD)}
+	,appended{out? out->appended: 0UL}
+	{}
+
+	~account() noexcept
+	{
+		++i.stats_calls;
+		i.stats_cycles += this_ctx::cycles() - cycles;
+		i.stats_yields += ctx::prof::get(ctx::cur(), ctx::prof::event::YIELD) - yields;
+		i.stats_bytes += out && out->appended > appended? out->appended - appended: 0UL;
+	}
+};
+
 bool
 ircd::m::sync::item::polylog(data &data)
 try
@@ -277,6 +322,11 @@ try
 	if(data.prefetch && !prefetch)
 		return false;
 
+	const account accounting
+	{
+		*this, data
+	};
+
 	#ifdef RB_DEBUG
 	sync::stats stats
 	{
@@ -373,6 +423,11 @@ try
 	if(!enable)
 		return false;
 
+	const account accounting
+	{
+		*this, data
+	};
+
 	#ifdef RB_DEBUG
 	sync::stats stats
 	{
@@ -592,15 +647,18 @@ ircd::m::sync::data::data(const m::user &user,
 {
 	user
 }
-,filter_buf
+,filters
 {
 	this->args?
-		m::filter::get(this->args->filter_id, user):
-		std::string{}
+		user::filter::compile(user, this->args->filter_id):
+		nullptr
 }
 ,filter
 {
-	json::object{filter_buf}
+	json::object
+	{
+		filters? string_view{filters->content}: string_view{}
+	}
 }
 ,device_id
 {
@@ -613,6 +671,98 @@ ircd::m::sync::data::data(const m::user &user,
 {
 }
 
+ircd::m::sync::data::data(const data &parent,
+                          json::stack &out)
+:range
+{
+	parent.range
+}
+,phased
+{
+	parent.phased
+}
+,prefetch
+{
+	parent.prefetch
+}
+,stats
+{
+	parent.stats
+}
+,client
+{
+	parent.client
+}
+,args
+{
+	parent.args
+}
+,user
+{
+	parent.user
+}
+,user_room
+{
+	user
+}
+,user_state
+{
+	user_room
+}
+,user_rooms
+{
+	user
+}
+,filters
+{
+	parent.filters
+}
+,filter
+{
+	json::object
+	{
+		filters? string_view{filters->content}: string_view{}
+	}
+}
+,device_id
+{
+	parent.device_id
+}
+,event
+{
+	parent.event
+}
+,room
+{
+	parent.room
+}
+,membership
+{
+	parent.membership
+}
+,room_depth
+{
+	parent.room_depth
+}
+,room_head
+{
+	parent.room_head
+}
+,event_idx
+{
+	parent.event_idx
+}
+,client_txnid
+{
+	parent.client_txnid
+}
+,out
+{
+	&out
+}
+{
+}
+
 ircd::m::sync::data::~data()
 noexcept
 {
@@ -643,6 +793,15 @@ ircd::m::sync::args::timeout_default
 	{ "default",  90 * 1000L                          },
 };
 
+/// Longpoll timeout limit while the server is shedding load (see
+/// resource::method::shedding()); the held requests are released sooner.
+ircd::conf::item<ircd::milliseconds>
+ircd::m::sync::args::timeout_shed
+{
+	{ "name",     "ircd.client.sync.timeout.shed"  },
+	{ "default",  10 * 1000L                       },
+};
+
 //
 // args::args
 //
@@ -667,11 +826,17 @@ try
 }
 ,timesout
 {
-	ircd::now<system_point>() + std::clamp
+	ircd::now<system_point>() + std::min
 	(
-		request.query.get("timeout", milliseconds(timeout_default)),
-		milliseconds(timeout_min),
-		milliseconds(timeout_max)
+		std::clamp
+		(
+			request.query.get("timeout", milliseconds(timeout_default)),
+			milliseconds(timeout_min),
+			milliseconds(timeout_max)
+		),
+		ircd::resource::method::shedding()?
+			milliseconds(timeout_shed):
+			milliseconds(timeout_max)
 	)
 }
 ,full_state
@@ -10,6 +10,8 @@
 
 namespace ircd::m::typing
 {
+	struct pending;
+
 	static system_point calc_timesout(milliseconds relative);
 	static bool update_state(const edu &);
 	static m::event::id::buf set_typing(const edu &);
@@ -18,6 +20,9 @@ namespace ircd::m::typing
 	static void timeout_timeout(const typist &);
 	static void timeout_check();
 	static void timeout_worker();
+	static void transmit(const pending &);
+	static void commit_flush();
+	static void commit_worker();
 
 	extern log::log log;
 	extern ctx::dock dock;
@@ -26,10 +31,22 @@ namespace ircd::m::typing
 	extern conf::item<milliseconds> timeout_max;
 	extern conf::item<milliseconds> timeout_min;
 	extern conf::item<milliseconds> timeout_int;
+	extern conf::item<milliseconds> commit_window;
 	extern hookfn<vm::eval &> on_eval;
 	extern context timeout_context;
+	extern ctx::dock commit_dock;
+	extern std::vector<pending> commits;
+	extern context commit_context;
 }
 
+/// Typing change from a local client awaiting transmission.
+struct ircd::m::typing::pending
+{
+	m::user::id::buf user_id;
+	m::room::id::buf room_id;
+	bool typing;
+};
+
 decltype(ircd::m::typing::log)
 ircd::m::typing::log
 {
@@ -66,6 +83,20 @@ ircd::m::typing::timeout_int
 	{ "default",  5 * 1000L                 },
 };
 
+decltype(ircd::m::typing::commit_window)
+ircd::m::typing::commit_window
+{
+	{ "name",     "ircd.typing.commit.window" },
+	{ "default",  150L                        },
+	{ "description",
+
+	R"(
+	Changes from local clients are held for this many milliseconds before
+	transmission. A change reversed within the window (i.e. a start then a
+	stop) cancels out and nothing is sent for either. Zero disables.
+	)"},
+};
+
 decltype(ircd::m::typing::timeout_context)
 ircd::m::typing::timeout_context
 {
@@ -75,12 +106,28 @@ ircd::m::typing::timeout_context
 	timeout_worker,
 };
 
+decltype(ircd::m::typing::commit_dock)
+ircd::m::typing::commit_dock;
+
+decltype(ircd::m::typing::commits)
+ircd::m::typing::commits;
+
+decltype(ircd::m::typing::commit_context)
+ircd::m::typing::commit_context
+{
+	"typing.commit",
+	512_KiB,
+	context::POST,
+	commit_worker,
+};
+
 static const ircd::run::changed
 timeout_context_terminate
 {
 	ircd::run::level::QUIT, []
 	{
 		ircd::m::typing::timeout_context.terminate();
+		ircd::m::typing::commit_context.terminate();
 	}
 };
 
@@ -127,6 +174,68 @@ catch(const std::exception &e)
 	};
 }
 
+void
+ircd::m::typing::commit_worker()
+try
+{
+	while(1)
+	{
+		commit_dock.wait([]
+		{
+			return !commits.empty();
+		});
+
+		// Let the window fill before transmitting what remains of it.
+		ctx::sleep(milliseconds(commit_window));
+		commit_flush();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Typing commit worker fatal :%s",
+		e.what()
+	};
+}
+
+void
+ircd::m::typing::commit_flush()
+{
+	std::vector<pending> flush;
+	{
+		const std::lock_guard lock
+		{
+			mutex
+		};
+
+		std::swap(flush, commits);
+	}
+
+	for(const auto &p : flush) try
+	{
+		transmit(p);
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "Typing transmit for %s in %s :%s",
+			string_view{p.user_id},
+			string_view{p.room_id},
+			e.what(),
+		};
+	}
+}
+
 void
 ircd::m::typing::timeout_check()
 try
@@ -519,14 +628,57 @@ ircd::m::typing::commit::commit(const edu &edu)
 	if(!update_state(edu))
 		return;
 
+	pending p
+	{
+		at<"user_id"_>(edu),
+		at<"room_id"_>(edu),
+		json::get<"typing"_>(edu),
+	};
+
+	if(!milliseconds(commit_window).count())
+	{
+		transmit(p);
+		return;
+	}
+
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	// Only transitions reach here, so a change already pending for this
+	// user and room is the opposite of this one; together they're a no-op.
+	const auto it
+	{
+		std::find_if(begin(commits), end(commits), [&p]
+		(const auto &c)
+		{
+			return c.user_id == p.user_id && c.room_id == p.room_id;
+		})
+	};
+
+	if(it != end(commits))
+	{
+		assert(it->typing != p.typing);
+		commits.erase(it);
+		return;
+	}
+
+	commits.emplace_back(std::move(p));
+	commit_dock.notify_one();
+}
+
+void
+ircd::m::typing::transmit(const pending &p)
+{
 	json::iov event, content;
 	const json::iov::push push[]
 	{
-		{ event,    { "type",     "m.typing"                  } },
-		{ event,    { "room_id",  at<"room_id"_>(edu)         } },
-		{ content,  { "user_id",  at<"user_id"_>(edu)         } },
-		{ content,  { "room_id",  at<"room_id"_>(edu)         } },
-		{ content,  { "typing",   json::get<"typing"_>(edu)   } },
+		{ event,    { "type",     "m.typing"   } },
+		{ event,    { "room_id",  p.room_id    } },
+		{ content,  { "user_id",  p.user_id    } },
+		{ content,  { "room_id",  p.room_id    } },
+		{ content,  { "typing",   p.typing     } },
 	};
 
 	m::vm::copts opts;
@@ -8,6 +8,123 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	static std::map<event::idx, std::string> device_changes;
+	static event::idx device_changes_floor {-1UL};
+
+	static event::idx device_list_stream(const user::room &, long &stream_id, bool &stale);
+	static void device_list_track(const user::room &, const long &stream_id, const bool &stale);
+	static void device_list_update_track(const user &, const device_list_update &);
+}
+
+decltype(ircd::m::user::devices::changes_max)
+ircd::m::user::devices::changes_max
+{
+	{ "name",     "ircd.m.user.devices.changes.max" },
+	{ "default",  131072L                          },
+	{ "help",     "Number of device list changes kept in memory."  },
+};
+
+decltype(ircd::m::user::devices::tracked_max_age)
+ircd::m::user::devices::tracked_max_age
+{
+	{ "name",     "ircd.m.user.devices.tracked.max_age" },
+	{ "default",  86400L                                },
+	{ "help",     "Seconds a cached remote device list is trusted without an update."  },
+};
+
+//
+// Change stream
+//
+// Every device list change committed to a user room is noted here by the
+// m_device_list_update module, in order of its event_idx. The first noted
+// change opens a floor above which the stream is complete, so the users
+// whose devices changed since a token above the floor are found without
+// visiting anyone else. Beyond changes.max the oldest entries are dropped
+// and the floor is raised past them.
+//
+
+bool
+ircd::m::user::devices::changes_complete(const event::idx &since)
+{
+	return device_changes_floor != -1UL && since >= device_changes_floor;
+}
+
+/// Iterates the changes at or after `since`; a user appears once for each
+/// change. The closure must not yield the ctx.
+bool
+ircd::m::user::devices::for_each_change(const event::idx &since,
+                                        const closure_change_bool &closure)
+{
+	const ctx::critical_assertion ca;
+	for(auto it(device_changes.lower_bound(since)); it != end(device_changes); ++it)
+		if(!closure(it->first, m::user::id(it->second)))
+			return false;
+
+	return true;
+}
+
+/// Whether the event in a user's room changes that user's device list as
+/// seen by others: a device or its keys were added, altered or deleted.
+/// Bookkeeping like one-time keys, access tokens and last-seen are not.
+bool
+ircd::m::user::devices::changes(const m::event &event)
+{
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	if(type == "m.room.redaction")
+		return true;
+
+	if(!startswith(type, "ircd.device."))
+		return false;
+
+	const auto prop
+	{
+		lstrip(type, "ircd.device.")
+	};
+
+	return true
+	&& !startswith(prop, "one_time_key|")
+	&& prop != "access_token_id"
+	&& !startswith(prop, "last_seen_");
+}
+
+void
+ircd::m::user::devices::note(const m::event &event,
+                             const event::idx &event_idx)
+{
+	if(device_changes_floor == -1UL)
+		device_changes_floor = event_idx;
+
+	device_changes.emplace_hint
+	(
+		end(device_changes), event_idx, json::get<"sender"_>(event)
+	);
+
+	while(device_changes.size() > size_t(changes_max))
+	{
+		const auto it
+		{
+			begin(device_changes)
+		};
+
+		device_changes_floor = std::max(device_changes_floor, it->first + 1);
+		device_changes.erase(it);
+	}
+}
+
+void
+ircd::m::user::devices::clear()
+noexcept
+{
+	device_changes.clear();
+	device_changes_floor = -1UL;
+}
+
 bool
 ircd::m::user::devices::send(json::iov &content)
 try
@@ -59,6 +176,225 @@ catch(const std::exception &e)
 	return false;
 }
 
+//
+// Remote device lists
+//
+// The device list of a remote user is cached in their user room once it is
+// fetched with resync() and kept current by the m.device_list_update EDUs
+// of their server. The ircd.device_list state holds the stream_id of the
+// last update applied; an update which doesn't follow from it means one was
+// lost, so the cache is marked stale until the next resync.
+//
+
+bool
+ircd::m::user::devices::tracked(const m::user &user)
+{
+	if(my(user))
+		return true;
+
+	const user::room user_room
+	{
+		user
+	};
+
+	long stream_id {0};
+	bool stale {true};
+	const auto event_idx
+	{
+		device_list_stream(user_room, stream_id, stale)
+	};
+
+	time_t ts {0};
+	if(!event_idx || stale || !m::get(std::nothrow, event_idx, "origin_server_ts", ts))
+		return false;
+
+	const auto age
+	{
+		ircd::time<milliseconds>() - ts
+	};
+
+	return age < milliseconds(seconds(tracked_max_age)).count();
+}
+
+/// Replaces the cached device list of a remote user with the response to a
+/// federation /user/devices request.
+bool
+ircd::m::user::devices::resync(const json::object &response)
+{
+	const m::user::id &user_id
+	{
+		json::string(response.at("user_id"))
+	};
+
+	const m::user user
+	{
+		user_id
+	};
+
+	if(my(user) || !exists(user))
+		return false;
+
+	const json::array &devices_
+	{
+		response["devices"]
+	};
+
+	const m::user::devices devices
+	{
+		user
+	};
+
+	std::set<std::string, std::less<>> listed;
+	for(const json::object device : devices_)
+	{
+		const json::string device_id
+		{
+			device["device_id"]
+		};
+
+		if(!device_id)
+			continue;
+
+		devices.set(device_id, "device_id", device_id);
+		if(device.has("keys"))
+			devices.set(device_id, "keys", device["keys"]);
+
+		if(device.has("device_display_name"))
+			devices.set(device_id, "device_display_name", json::string(device["device_display_name"]));
+
+		listed.emplace(device_id);
+	}
+
+	std::vector<std::string> unlisted;
+	devices.for_each([&listed, &unlisted]
+	(const auto &, const string_view &device_id)
+	{
+		if(!listed.count(device_id))
+			unlisted.emplace_back(device_id);
+
+		return true;
+	});
+
+	for(const auto &device_id : unlisted)
+		devices.del(device_id);
+
+	const user::room user_room
+	{
+		user
+	};
+
+	// Some servers send the plural.
+	const json::object &ssk
+	{
+		response.has("self_signing_key")?
+			response["self_signing_key"]:
+			response["self_signing_keys"]
+	};
+
+	const std::pair<string_view, json::object> signing[]
+	{
+		{ "ircd.device.signing.master", response["master_key"] },
+		{ "ircd.device.signing.self",   ssk                    },
+	};
+
+	for(const auto &[type, key] : signing)
+	{
+		if(empty(key))
+			continue;
+
+		bool dup {false};
+		m::get(std::nothrow, user_room.get(std::nothrow, type, ""), "content", [&key, &dup]
+		(const json::object &content)
+		{
+			dup = string_view{content} == string_view{key};
+		});
+
+		if(!dup)
+			send(user_room, user_id, type, "", key);
+	}
+
+	device_list_track(user_room, response.get<long>("stream_id", 0L), false);
+	return true;
+}
+
+void
+ircd::m::device_list_update_track(const user &user,
+                                  const device_list_update &update)
+{
+	const user::room user_room
+	{
+		user
+	};
+
+	long stream_id {0};
+	bool stale {true};
+	if(!device_list_stream(user_room, stream_id, stale) || stale)
+		return;
+
+	const json::array &prev_id
+	{
+		json::get<"prev_id"_>(update)
+	};
+
+	const long &update_id
+	{
+		json::get<"stream_id"_>(update)
+	};
+
+	// An empty prev_id begins a sequence; some servers send every update
+	// this way with the same stream_id.
+	bool follows
+	{
+		empty(prev_id) && update_id >= stream_id
+	};
+
+	for(auto it(begin(prev_id)); it != end(prev_id) && !follows; ++it)
+		follows = lex_castable<long>(json::string(*it)) && lex_cast<long>(json::string(*it)) == stream_id;
+
+	if(!follows)
+		log::dwarning
+		{
+			log, "Device list of %s is stale; update %ld does not follow %ld",
+			string_view{user.user_id},
+			update_id,
+			stream_id,
+		};
+
+	device_list_track(user_room, follows? update_id: stream_id, !follows);
+}
+
+ircd::m::event::idx
+ircd::m::device_list_stream(const user::room &user_room,
+                            long &stream_id,
+                            bool &stale)
+{
+	const auto event_idx
+	{
+		user_room.get(std::nothrow, "ircd.device_list", "")
+	};
+
+	m::get(std::nothrow, event_idx, "content", [&stream_id, &stale]
+	(const json::object &content)
+	{
+		stream_id = content.get<long>("stream_id", 0L);
+		stale = content.get<bool>("stale", false);
+	});
+
+	return event_idx;
+}
+
+void
+ircd::m::device_list_track(const user::room &user_room,
+                           const long &stream_id,
+                           const bool &stale)
+{
+	send(user_room, user_room.user, "ircd.device_list", "", json::members
+	{
+		{ "stream_id",  stream_id  },
+		{ "stale",      stale      },
+	});
+}
+
 bool
 ircd::m::user::devices::update(const device_list_update &update)
 {
@@ -90,6 +426,9 @@ ircd::m::user::devices::update(const device_list_update &update)
 		json::at<"device_id"_>(update)
 	};
 
+	if(!my(user))
+		device_list_update_track(user, update);
+
 	if(json::get<"deleted"_>(update))
 		return devices.del(device_id);
 
@@ -119,39 +458,11 @@ std::map<std::string, long>
 ircd::m::user::devices::count_one_time_keys(const m::user &user,
                                             const string_view &device_id)
 {
-	const m::user::devices devices
-	{
-		user
-	};
-
 	std::map<std::string, long> ret;
-	devices.for_each(device_id, [&ret]
-	(const auto &event_idx, const string_view &type)
+	dbs::device_one_time_key_count(user.user_id, device_id, [&ret]
+	(const string_view &algorithm, const int64_t &count)
 	{
-		if(!startswith(type, "one_time_key|"))
-			return true;
-
-		const auto &[prefix, ident]
-		{
-			split(type, '|')
-		};
-
-		const auto &[algorithm, name]
-		{
-			split(ident, ':')
-		};
-
-		assert(prefix == "one_time_key");
-		assert(!empty(algorithm));
-		assert(!empty(ident));
-		assert(!empty(name));
-
-		auto it(ret.lower_bound(algorithm));
-		if(it == end(ret) || it->first != algorithm)
-			it = ret.emplace_hint(it, algorithm, 0L);
-
-		auto &count(it->second);
-		++count;
+		ret.emplace(algorithm, std::max(count, 0L));
 		return true;
 	});
 
@@ -185,6 +496,11 @@ const
 		m::redact(user_room, user_room.user, event_id, "deleted")
 	};
 
+	// Messages still queued for the device are dropped with it, as are the
+	// one-time keys it hasn't had claimed.
+	dbs::device_inbox_del(user.user_id, id, dbs::device_inbox_pos_max);
+	dbs::device_one_time_key_del(user.user_id, id);
+
 	if(!my(user))
 		return true;
 
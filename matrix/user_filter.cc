@@ -8,6 +8,90 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	using filter_cache_entry = std::pair<std::string, std::shared_ptr<const user::filter::cached>>;
+
+	extern conf::item<size_t> filter_cache_max;
+	static std::list<filter_cache_entry> filter_cache_lru;
+	static std::map<string_view, decltype(filter_cache_lru)::iterator, std::less<>> filter_cache;
+}
+
+decltype(ircd::m::filter_cache_max)
+ircd::m::filter_cache_max
+{
+	{ "name",     "ircd.m.user.filter.cache.max" },
+	{ "default",  1024L                           },
+	{ "help",     "Number of compiled filters kept by filter_id." },
+};
+
+/// Parsed and compiled filter for a `?filter=` argument (see m::filter::get).
+/// A filter referenced by id is kept in a cache; the id is the hash of the
+/// content so an entry is never stale. An inline filter is compiled for the
+/// caller alone. Null is returned when there's no filter.
+std::shared_ptr<const ircd::m::user::filter::cached>
+ircd::m::user::filter::compile(const m::user &user,
+                               const string_view &val)
+{
+	if(!val)
+		return {};
+
+	const bool is_inline
+	{
+		startswith(val, "{") || startswith(val, "%7B")
+	};
+
+	if(is_inline)
+		return std::make_shared<const cached>(m::filter::get(val, user));
+
+	char keybuf[id::MAX_SIZE + 1 + event::STATE_KEY_MAX_SIZE];
+	const string_view key
+	{
+		fmt::sprintf
+		{
+			keybuf, "%s %s", string_view{user.user_id}, val
+		}
+	};
+
+	const auto it
+	{
+		filter_cache.find(key)
+	};
+
+	if(it != end(filter_cache))
+	{
+		filter_cache_lru.splice(begin(filter_cache_lru), filter_cache_lru, it->second);
+		return it->second->second;
+	}
+
+	auto content
+	{
+		m::filter::get(val, user)
+	};
+
+	if(content.empty())
+		return {};
+
+	auto ret
+	{
+		std::make_shared<const cached>(std::move(content))
+	};
+
+	// The fetch yielded; another context may have put the same entry.
+	if(filter_cache.count(key))
+		return ret;
+
+	filter_cache_lru.emplace_front(std::string(key), ret);
+	filter_cache.emplace(filter_cache_lru.front().first, begin(filter_cache_lru));
+	while(filter_cache.size() > size_t(filter_cache_max))
+	{
+		filter_cache.erase(filter_cache_lru.back().first);
+		filter_cache_lru.pop_back();
+	}
+
+	return ret;
+}
+
 ircd::string_view
 ircd::m::user::filter::set(const mutable_buffer &buf,
                            const json::object &val)
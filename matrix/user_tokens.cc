@@ -8,6 +8,208 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+namespace ircd::m
+{
+	struct user_tokens_cache_entry;
+	using user_tokens_cache_map = std::map<std::string, user_tokens_cache_entry, std::less<>>;
+
+	static const user_tokens_cache_entry *user_tokens_cache_fetch(const string_view &token);
+	static void user_tokens_cache_update(const event &, vm::eval &);
+
+	static user_tokens_cache_map user_tokens_cache;
+	static uint64_t user_tokens_cache_generation;
+	extern hookfn<vm::eval &> user_tokens_cache_hook;
+}
+
+/// The owner and device of a token resolved from the tokens room; the
+/// entry is dropped when the token's state changes or its event is redacted
+/// (i.e. logout), or re-resolved once it's older than the ttl.
+struct ircd::m::user_tokens_cache_entry
+{
+	std::string user_id;
+	std::string device_id;
+	system_point resolved;
+};
+
+decltype(ircd::m::user::tokens::cache_max)
+ircd::m::user::tokens::cache_max
+{
+	{ "name",     "ircd.m.user.tokens.cache.max" },
+	{ "default",  65536L                         },
+	{ "description",
+
+	R"(
+	Number of access tokens kept resolved in memory for authenticating
+	requests. Zero disables the cache.
+	)"},
+};
+
+decltype(ircd::m::user::tokens::cache_ttl)
+ircd::m::user::tokens::cache_ttl
+{
+	{ "name",     "ircd.m.user.tokens.cache.ttl" },
+	{ "default",  600L                           },
+};
+
+/// Cached entries are dropped after the write is committed; the tokens room
+/// only receives token and redaction events. Every such event also advances
+/// the generation so a resolution which yielded across it is not cached.
+decltype(ircd::m::user_tokens_cache_hook)
+ircd::m::user_tokens_cache_hook
+{
+	user_tokens_cache_update,
+	{
+		{ "_site",  "vm.notify"  },
+	}
+};
+
+void
+ircd::m::user_tokens_cache_update(const event &event,
+                                  vm::eval &eval)
+{
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	const bool relevant
+	{
+		type == "ircd.access_token" || type == "m.room.redaction"
+	};
+
+	if(!relevant)
+		return;
+
+	const m::room::id::buf tokens_room_id
+	{
+		"tokens", origin(my())
+	};
+
+	if(json::get<"room_id"_>(event) != tokens_room_id)
+		return;
+
+	++user_tokens_cache_generation;
+	if(user_tokens_cache.empty())
+		return;
+
+	if(type == "ircd.access_token")
+	{
+		const auto it
+		{
+			user_tokens_cache.find(json::get<"state_key"_>(event))
+		};
+
+		if(it != end(user_tokens_cache))
+			user_tokens_cache.erase(it);
+
+		return;
+	}
+
+	const auto target_idx
+	{
+		m::index(std::nothrow, event::id(json::get<"redacts"_>(event)))
+	};
+
+	m::get(std::nothrow, target_idx, "state_key", []
+	(const string_view &token)
+	{
+		const auto it
+		{
+			user_tokens_cache.find(token)
+		};
+
+		if(it != end(user_tokens_cache))
+			user_tokens_cache.erase(it);
+	});
+}
+
+const ircd::m::user_tokens_cache_entry *
+ircd::m::user_tokens_cache_fetch(const string_view &token)
+{
+	if(!size_t(user::tokens::cache_max))
+		return nullptr;
+
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	auto it
+	{
+		user_tokens_cache.find(token)
+	};
+
+	const seconds ttl
+	{
+		user::tokens::cache_ttl
+	};
+
+	if(it != end(user_tokens_cache) && now - it->second.resolved < ttl)
+		return &it->second;
+
+	const auto generation
+	{
+		user_tokens_cache_generation
+	};
+
+	const m::room::id::buf tokens_room_id
+	{
+		"tokens", origin(my())
+	};
+
+	const m::room::state tokens
+	{
+		tokens_room_id
+	};
+
+	const event::idx event_idx
+	{
+		tokens.get(std::nothrow, "ircd.access_token", token)
+	};
+
+	// Unknown tokens are not cached; they're erased if they were.
+	user_tokens_cache_entry entry;
+	m::get(std::nothrow, event_idx, "sender", [&entry]
+	(const string_view &sender)
+	{
+		entry.user_id = sender;
+	});
+
+	if(entry.user_id.empty())
+	{
+		user_tokens_cache.erase(std::string{token});
+		return nullptr;
+	}
+
+	m::get(std::nothrow, event_idx, "content", [&entry]
+	(const json::object &content)
+	{
+		entry.device_id = json::string
+		{
+			content["device_id"]
+		};
+	});
+
+	// The fetches above yield. When the tokens room changed meanwhile (i.e.
+	// a logout) the result may already be stale, so it's resolved again.
+	if(generation != user_tokens_cache_generation)
+		return user_tokens_cache_fetch(token);
+
+	// Another fetch of the same token may have cached it meanwhile.
+	it = user_tokens_cache.find(token);
+	if(it == end(user_tokens_cache))
+	{
+		while(user_tokens_cache.size() >= size_t(user::tokens::cache_max))
+			user_tokens_cache.erase(begin(user_tokens_cache));
+
+		it = user_tokens_cache.emplace_hint(it, std::string{token}, user_tokens_cache_entry{});
+	}
+
+	entry.resolved = now;
+	it->second = std::move(entry);
+	return &it->second;
+}
+
 size_t
 ircd::m::user::tokens::del(const string_view &reason)
 const
@@ -158,6 +360,15 @@ ircd::m::user::id::buf
 ircd::m::user::tokens::get(std::nothrow_t,
                            const string_view &token)
 {
+	m::user::id::buf ret;
+	if(size_t(cache_max))
+	{
+		if(const auto *const entry{user_tokens_cache_fetch(token)})
+			ret = string_view{entry->user_id};
+
+		return ret;
+	}
+
 	const m::room::id::buf tokens_room_id
 	{
 		"tokens", origin(my())
@@ -173,7 +384,6 @@ ircd::m::user::tokens::get(std::nothrow_t,
 		tokens.get(std::nothrow, "ircd.access_token", token)
 	};
 
-	m::user::id::buf ret;
 	m::get(std::nothrow, event_idx, "sender", [&ret]
 	(const string_view &sender)
 	{
@@ -204,6 +414,15 @@ ircd::m::device::id::buf
 ircd::m::user::tokens::device(std::nothrow_t,
                               const string_view &token)
 {
+	device::id::buf ret;
+	if(size_t(cache_max))
+	{
+		if(const auto *const entry{user_tokens_cache_fetch(token)})
+			ret = string_view{entry->device_id};
+
+		return ret;
+	}
+
 	const m::room::id::buf tokens_room_id
 	{
 		"tokens", origin(my())
@@ -219,7 +438,6 @@ ircd::m::user::tokens::device(std::nothrow_t,
 		tokens.get(std::nothrow, "ircd.access_token", token)
 	};
 
-	device::id::buf ret;
 	m::get(std::nothrow, event_idx, "content", [&ret]
 	(const json::object &content)
 	{
@@ -26,11 +26,86 @@ ircd::m::vm::default_copts;
 decltype(ircd::m::vm::default_opts)
 ircd::m::vm::default_opts;
 
+/// Options for local records: events created by this server in one of its
+/// internal rooms holding data which never leaves the server (DNS answers,
+/// cached keys). These are not hashed, signed or given auth_events, and only
+/// the indexes needed to find them again are written: the event itself, its
+/// columns, the room timeline and the present state. The event reference
+/// graph, horizon, room head, state space and the various counters are all
+/// bypassed. Internal rooms bypass auth, so this is only suitable for them.
+decltype(ircd::m::vm::record_copts)
+ircd::m::vm::record_copts
+{[]
+{
+	copts ret;
+	ret.prop_mask.set("auth_events", false);
+	ret.prop_mask.set("hashes", false);
+	ret.prop_mask.set("prev_state", false);
+	ret.prop_mask.set("signatures", false);
+
+	ret.non_conform.set(event::conforms::MISSING_AUTH_EVENTS);
+	ret.non_conform.set(event::conforms::MISSING_SIGNATURES);
+	ret.non_conform.set(event::conforms::MISSING_ORIGIN_SIGNATURE);
+	ret.non_conform.set(event::conforms::MISSING_HASHES);
+
+	ret.phase.reset(phase::VERIFY);
+	ret.notify_clients = false;
+	ret.notify_servers = false;
+	ret.mfetch_keys = false;
+	ret.mverify = false;
+
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_REFS);
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_HORIZON);
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_HORIZON_RESOLVE);
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_SENDER);
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_TYPE);
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_STATE);
+	ret.wopts.appendix.reset(dbs::appendix::EVENT_CHAIN);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_TYPE);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_HEAD);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_HEAD_RESOLVE);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_STATE_SPACE);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_JOINED);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_COUNTS);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_HEROES);
+	ret.wopts.appendix.reset(dbs::appendix::ROOM_UNREAD);
+	return ret;
+}()};
+
+namespace ircd::m::vm
+{
+	static string_view sampler_label(const mutable_buffer &);
+}
+
+namespace ircd::m::vm::sequence
+{
+	static void refresher();
+
+	extern conf::item<milliseconds> refresh_interval;
+}
+
+/// When the events database is opened as a secondary (i.e. a read replica
+/// with -slave) it tails the primary's files; the secondary is caught up on
+/// this interval. Zero disables the automatic catch-up.
+decltype(ircd::m::vm::sequence::refresh_interval)
+ircd::m::vm::sequence::refresh_interval
+{
+	{ "name",     "ircd.m.vm.sequence.refresh.interval" },
+	{ "default",  1000L                                 },
+};
+
 //
 // init
 //
 
 ircd::m::vm::init::init()
+:refresher
+{
+	"m.vm.refresh",
+	256_KiB,
+	context::POST,
+	sequence::refresher
+}
 {
 	id::event::buf event_id;
 	sequence::retired = sequence::get(event_id);
@@ -39,6 +114,7 @@ ircd::m::vm::init::init()
 
 	vm::ready = true;
 	vm::dock.notify_all();
+	prof::sampler::label = sampler_label;
 
 	log::info
 	{
@@ -55,6 +131,13 @@ ircd::m::vm::init::init()
 ircd::m::vm::init::~init()
 noexcept
 {
+	refresher.terminate();
+	refresher.join();
+
+	prof::sampler::label = nullptr;
+
+	// Deferred effects may still create evals; run them out while ready.
+	effects::fini();
 	vm::ready = false;
 
 	if(eval::executing || eval::injecting)
@@ -109,6 +192,22 @@ noexcept
 	assert(retired == sequence::retired || ircd::read_only);
 }
 
+/// Frame for samples of the profiler: the phase of the innermost eval on
+/// the current context, if any.
+ircd::string_view
+ircd::m::vm::sampler_label(const mutable_buffer &buf)
+{
+	string_view ret;
+	if(ctx::current)
+		eval::for_each(ctx::current, [&ret](eval &eval)
+		{
+			ret = reflect(eval.phase);
+			return true;
+		});
+
+	return ret;
+}
+
 ircd::http::code
 ircd::m::vm::http_code(const fault &code)
 {
@@ -259,6 +358,87 @@ ircd::m::vm::sequence::get(const eval &eval)
 	return eval.sequence;
 }
 
+/// Catch up the events database when opened as a secondary and advance the
+/// sequence counters to the latest event written by the primary. Waiters on
+/// the sequence dock are notified when it advances. Returns the number of
+/// events advanced.
+uint64_t
+ircd::m::vm::sequence::refresh()
+{
+	assert(dbs::events);
+	assert(dbs::events->slave);
+	assert(!pending);
+
+	db::refresh(*dbs::events);
+
+	event::id::buf event_id;
+	const auto latest
+	{
+		get(event_id)
+	};
+
+	if(latest <= retired)
+		return 0;
+
+	const auto ret
+	{
+		latest - retired
+	};
+
+	retired = latest;
+	committed = latest;
+	uncommitted = latest;
+	dock.notify_all();
+
+	log::debug
+	{
+		log, "Refreshed secondary +%lu to @%lu [%s]",
+		ret,
+		retired,
+		string_view{event_id},
+	};
+
+	return ret;
+}
+
+void
+ircd::m::vm::sequence::refresher()
+try
+{
+	if(!dbs::events || !dbs::events->slave)
+		return;
+
+	run::barrier<ctx::interrupted> {};
+	while(1)
+	{
+		const milliseconds interval
+		{
+			refresh_interval
+		};
+
+		if(interval <= 0ms)
+		{
+			ctx::sleep(seconds(5));
+			continue;
+		}
+
+		ctx::sleep(interval);
+		refresh();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Secondary refresh worker :%s",
+		e.what(),
+	};
+}
+
 //
 // copts (creation options)
 //
@@ -0,0 +1,299 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::vm::effects
+{
+	struct item;
+
+	static void handle(item &);
+	static void worker();
+
+	extern std::map<std::string, std::deque<item>, std::less<>> rooms;
+	extern std::deque<std::string> ready;
+	extern std::vector<context> pool;
+	extern bool stopping;
+}
+
+/// Copy of an event and the parts of its eval relevant to the effect hooks.
+/// The views and pointers in the opts refer to the evaluator's frame, which
+/// is gone by the time the item is handled; the strings are kept here and
+/// the opts are pointed at them by handle().
+struct ircd::m::vm::effects::item
+{
+	vm::opts opts;
+	std::string node_id;
+	std::string user_id;
+	std::string txn_id;
+	std::string room_version;
+	std::string source;
+	event::id::buf event_id;
+	uint64_t sequence {0};
+};
+
+decltype(ircd::m::vm::effects::enable)
+ircd::m::vm::effects::enable
+{
+	{ "name",     "ircd.m.vm.effects.async.enable" },
+	{ "default",  false                            },
+	{ "description",
+
+	R"(
+	Call the effect hooks for events in public rooms on a pool of contexts
+	after the eval retires, so the evaluator (i.e. a client's send) does not
+	wait for them. Effects for events in internal rooms are always called by
+	the evaluator because other local operations depend on them.
+	)"},
+};
+
+decltype(ircd::m::vm::effects::queue_max)
+ircd::m::vm::effects::queue_max
+{
+	{ "name",     "ircd.m.vm.effects.async.queue.max" },
+	{ "default",  4096L                               },
+	{ "description",
+
+	R"(
+	Maximum effects waiting for the pool. When reached the evaluator calls
+	the effects itself, which slows it down as the pool falls behind.
+	)"},
+};
+
+decltype(ircd::m::vm::effects::pool_size)
+ircd::m::vm::effects::pool_size
+{
+	{ "name",     "ircd.m.vm.effects.async.pool.size" },
+	{ "default",  4L                                  },
+};
+
+decltype(ircd::m::vm::effects::dock)
+ircd::m::vm::effects::dock;
+
+decltype(ircd::m::vm::effects::queued)
+ircd::m::vm::effects::queued;
+
+decltype(ircd::m::vm::effects::running)
+ircd::m::vm::effects::running;
+
+decltype(ircd::m::vm::effects::rooms)
+ircd::m::vm::effects::rooms;
+
+decltype(ircd::m::vm::effects::ready)
+ircd::m::vm::effects::ready;
+
+decltype(ircd::m::vm::effects::pool)
+ircd::m::vm::effects::pool;
+
+decltype(ircd::m::vm::effects::stopping)
+ircd::m::vm::effects::stopping;
+
+void
+ircd::m::vm::effects::fini()
+{
+	stopping = true;
+	if(queued || running)
+		log::warning
+		{
+			log, "Waiting for %zu queued and %zu running effects...",
+			queued,
+			running,
+		};
+
+	dock.wait([]
+	{
+		return !queued && !running;
+	});
+
+	for(auto &context : pool)
+		context.terminate();
+
+	dock.notify_all();
+	pool.clear();
+}
+
+bool
+ircd::m::vm::effects::defer(const eval &eval,
+                            const event &event)
+{
+	assert(eval.opts);
+	const bool deferrable
+	{
+		enable
+		&& !stopping
+		&& vm::ready
+		&& !eval.room_internal
+		&& !eval.parent
+		&& !eval.opts->edu
+		&& eval.sequence
+		&& event.event_id
+		&& json::get<"room_id"_>(event)
+	};
+
+	if(!deferrable)
+		return false;
+
+	if(queued >= size_t(queue_max))
+		return false;
+
+	// The pool is spawned with the first deferral.
+	if(pool.size() < size_t(pool_size))
+	{
+		pool.reserve(pool_size);
+		while(pool.size() < size_t(pool_size))
+			pool.emplace_back("m.vm.effect", 512_KiB, context::POST, worker);
+	}
+
+	const string_view &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	auto it
+	{
+		rooms.lower_bound(room_id)
+	};
+
+	// A room already in the map is either ready or being run by a worker
+	// which takes this item after those before it.
+	if(it == end(rooms) || it->first != room_id)
+	{
+		it = rooms.emplace_hint(it, std::string(room_id), std::deque<item>{});
+		ready.emplace_back(room_id);
+	}
+
+	auto &item
+	{
+		it->second.emplace_back(effects::item
+		{
+			*eval.opts,
+			eval.opts->node_id,
+			eval.opts->user_id,
+			eval.opts->txn_id,
+			eval.opts->room_version,
+			event.source?
+				std::string(string_view(event.source)):
+				std::string(json::strung(event)),
+			event.event_id,
+			eval.sequence,
+		})
+	};
+
+	item.opts.node_id = {};
+	item.opts.user_id = {};
+	item.opts.txn_id = {};
+	item.opts.room_version = {};
+	item.opts.wopts.interpose = nullptr;
+	item.opts.out = nullptr;
+
+	++queued;
+	dock.notify_all();
+	return true;
+}
+
+void
+ircd::m::vm::effects::worker()
+try
+{
+	while(1)
+	{
+		dock.wait([]
+		{
+			return !ready.empty();
+		});
+
+		const std::string room_id
+		{
+			std::move(ready.front())
+		};
+
+		ready.pop_front();
+		const scope_count _running
+		{
+			running
+		};
+
+		auto it
+		{
+			rooms.find(room_id)
+		};
+
+		assert(it != end(rooms));
+		while(!it->second.empty())
+		{
+			auto item
+			{
+				std::move(it->second.front())
+			};
+
+			it->second.pop_front();
+			--queued;
+			handle(item);
+		}
+
+		rooms.erase(it);
+		dock.notify_all();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Effects worker :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::m::vm::effects::handle(item &item)
+try
+{
+	const m::event event
+	{
+		json::object{item.source}, item.event_id
+	};
+
+	// Items are moved through the queue, so the views are only pointed at
+	// the strings once the item is at rest here.
+	item.opts.node_id = item.node_id;
+	item.opts.user_id = item.user_id;
+	item.opts.txn_id = item.txn_id;
+	item.opts.room_version = item.room_version;
+	vm::eval eval
+	{
+		item.opts
+	};
+
+	eval.sequence = item.sequence;
+	eval.room_id = json::get<"room_id"_>(event);
+	eval.event_id = item.event_id;
+	eval.event_ = &event;
+	const unwind clear_event{[&eval]
+	{
+		eval.event_ = nullptr;
+	}};
+
+	call(eval, event);
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Deferred effects of %s :%s",
+		string_view{item.event_id},
+		e.what(),
+	};
+}
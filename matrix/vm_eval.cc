@@ -28,6 +28,19 @@ ircd::util::instance_list<ircd::m::vm::eval>::list
 	allocator
 };
 
+namespace ircd::m::vm
+{
+	extern conf::item<size_t> verify_concurrency;
+}
+
+decltype(ircd::m::vm::verify_concurrency)
+ircd::m::vm::verify_concurrency
+{
+	{ "name",     "ircd.m.vm.verify.concurrency" },
+	{ "default",  4L                             },
+	{ "help",     "Offload threads sharing a batch verification of pdus." },
+};
+
 decltype(ircd::m::vm::eval::id_ctr)
 ircd::m::vm::eval::id_ctr;
 
@@ -79,16 +92,217 @@ ircd::m::vm::fetch_keys(const eval &eval)
 }
 
 size_t
-ircd::m::vm::prefetch_refs(const eval &eval)
+ircd::m::vm::verify_pdus(const vector_view<bool> &out,
+                         const eval &eval)
 {
-	assert(eval.opts);
-	const dbs::write_opts &wopts
+	return verify_pdus(out, eval.pdus);
+}
+
+/// Verifies the signatures of all pdus together. The keys are gathered on
+/// this context and the verifications are then conducted in a single offload
+/// shared by several threads. The result for each pdu is written to the
+/// parallel array in `out`; false does not indicate a bad signature, only
+/// that the pdu was not verified here.
+size_t
+ircd::m::vm::verify_pdus(const vector_view<bool> &out,
+                         const vector_view<const event> &pdus)
+{
+	struct task
 	{
-		eval.opts->wopts
+		const m::event *event;
+		ed25519::pk pk;
+		ed25519::sig sig;
+		bool *result;
 	};
 
+	assert(out.size() == pdus.size());
+	std::vector<task> tasks;
+	tasks.reserve(pdus.size());
+	for(size_t i(0); i < pdus.size(); ++i) try
+	{
+		const auto &event(pdus[i]);
+		out[i] = false;
+
+		const string_view &origin
+		{
+			json::get<"origin"_>(event)
+		};
+
+		if(!origin)
+			continue;
+
+		const json::object &origin_sigs
+		{
+			json::get<"signatures"_>(event).get(origin)
+		};
+
+		const auto it
+		{
+			origin_sigs.begin()
+		};
+
+		if(it == origin_sigs.end())
+			continue;
+
+		const json::string key_id
+		{
+			it->first
+		};
+
+		const json::string sigb64
+		{
+			it->second
+		};
+
+		task task
+		{
+			&event, {}, {}, std::addressof(out[i])
+		};
+
+		const m::node::keys node_keys
+		{
+			origin
+		};
+
+		const bool found
+		{
+			node_keys.get(key_id, [&task]
+			(const ed25519::pk &pk)
+			{
+				task.pk = pk;
+			})
+		};
+
+		if(!found)
+			continue;
+
+		b64::decode(task.sig, sigb64);
+		tasks.emplace_back(std::move(task));
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		// The pdu is left for the individual verification to report.
+		continue;
+	}
+
+	if(tasks.empty())
+		return 0;
+
+	std::atomic<size_t> next {0};
+	const auto worker{[&tasks, &next]
+	{
+		for(size_t i; (i = next.fetch_add(1)) < tasks.size(); )
+		{
+			auto &task(tasks[i]);
+			*task.result = m::verify(*task.event, task.pk, task.sig);
+		}
+	}};
+
+	const ctx::ole::opts opts
+	{
+		"m.vm.verify",
+		std::min(tasks.size(), size_t(verify_concurrency))
+	};
+
+	if(ctx::current && opts.concurrency > 0)
+		ctx::offload(opts, worker);
+	else
+		worker();
+
+	return std::count(begin(out), end(out), true);
+}
+
+/// Computes the reference hash of each pdu without an event_id together in
+/// one sha256::batch(), conducted on an offload thread. The result for each
+/// pdu is written to the parallel array in `out`; a zero digest is left for
+/// pdus which have an event_id or were not hashed here.
+size_t
+ircd::m::vm::hash_pdus(const vector_view<sha256::buf> &out,
+                       const vector_view<const event> &pdus)
+{
+	assert(out.size() == pdus.size());
+	size_t total(0);
+	for(const auto &event : pdus)
+		total += !event.event_id? size(string_view{event.source}): 0UL;
+
+	// The preimages are no larger than their source, but for the canonical
+	// form of some numbers and escapes; those without room are skipped.
+	const unique_mutable_buffer buf
+	{
+		total + pdus.size() * 64
+	};
+
+	std::vector<size_t> which;
+	std::vector<const_buffer> preimage;
+	which.reserve(pdus.size());
+	preimage.reserve(pdus.size());
+	const auto worker{[&out, &pdus, &buf, &which, &preimage]
+	{
+		thread_local char content_buf[event::MAX_SIZE];
+		mutable_buffer dst{buf};
+		for(size_t i(0); i < pdus.size(); ++i) try
+		{
+			out[i] = sha256::buf{};
+			if(pdus[i].event_id || !pdus[i].source)
+				continue;
+
+			const m::event essential
+			{
+				m::essential(pdus[i], content_buf)
+			};
+
+			preimage.emplace_back(json::stringify(dst, essential));
+			which.emplace_back(i);
+		}
+		catch(const std::exception &e)
+		{
+			// The pdu is left for its eval to hash and report.
+			continue;
+		}
+
+		const unique_mutable_buffer digests
+		{
+			std::max(preimage.size(), 1UL) * sha256::digest_size
+		};
+
+		sha256::batch(digests, preimage);
+		for(size_t j(0); j < which.size(); ++j)
+			out[which[j]] = const_buffer
+			{
+				data(digests) + j * sha256::digest_size, sha256::digest_size
+			};
+	}};
+
+	static const ctx::ole::opts opts
+	{
+		"m.vm.hash"
+	};
+
+	if(ctx::current)
+		ctx::offload(opts, worker);
+	else
+		worker();
+
+	return which.size();
+}
+
+size_t
+ircd::m::vm::prefetch_refs(const eval &eval)
+{
+	assert(eval.opts);
+	return prefetch_refs(eval.pdus, eval.opts->wopts);
+}
+
+size_t
+ircd::m::vm::prefetch_refs(const vector_view<const event> &pdus,
+                           const dbs::write_opts &wopts)
+{
 	size_t prefetched(0);
-	for(const auto &event : eval.pdus)
+	for(const auto &event : pdus)
 	{
 		if(event.event_id)
 			prefetched += m::prefetch(event.event_id, "_event_idx");
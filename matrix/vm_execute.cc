@@ -10,6 +10,9 @@
 
 namespace ircd::m::vm
 {
+	struct phase_scope;
+
+	static void log_slow(const eval &, const event &, const nanoseconds &) noexcept;
 	template<class... args> static bool output(const vm::opts &, const vm::fault &, const string_view &event_id, const string_view &fmt, args&&...);
 	template<class... args> static fault handle_fault(const opts &, const fault &, const string_view &event_id, const string_view &fmt, args&&...);
 	template<class T> static void call_hook(hook::site<T> &, eval &, const event &, T&& data);
@@ -17,6 +20,8 @@ namespace ircd::m::vm
 	static void emption_check(eval &, const event &);
 	static size_t calc_txn_reserve(const opts &, const event &);
 	static void write_commit(eval &);
+	static void write_commit_group(eval &);
+	static void write_commit_wait(eval &);
 	static void write_append(eval &, const event &, const bool &);
 	static fault execute_edu(eval &, const event &);
 	static fault execute_pdu(eval &, const event &);
@@ -41,8 +46,101 @@ namespace ircd::m::vm
 	extern conf::item<bool> log_commit_debug;
 	extern conf::item<bool> log_accept_debug;
 	extern conf::item<bool> log_accept_info;
+	extern conf::item<milliseconds> emption_stall_wait;
+	extern conf::item<size_t> pipeline_window;
+	extern conf::item<size_t> bulk_window;
+	extern conf::item<milliseconds> log_slow_threshold;
+	extern std::array<std::unique_ptr<stats::histogram>, num_of<phase>()> phase_latency;
+	extern std::array<std::unique_ptr<stats::item<uint64_t>>, num_of<phase>()> phase_cycles;
 }
 
+/// Enters the phase for the duration of the instance like a scope_restore
+/// of eval.phase. The duration and cycles are added to the eval's accounting
+/// for the phase, and recorded to the phase's histogram and cycle counter.
+/// Phases entered within another are included in the outer phase.
+struct ircd::m::vm::phase_scope
+{
+	scope_restore<vm::phase> restore;
+	vm::eval &eval;
+	vm::phase which;
+	ircd::timer timer;
+	uint64_t started {prof::cycles()};
+
+	phase_scope(vm::eval &eval, const vm::phase &which)
+	:restore{eval.phase, which}
+	,eval{eval}
+	,which{which}
+	{}
+
+	~phase_scope() noexcept
+	{
+		const auto elapsed
+		{
+			timer.at<nanoseconds>()
+		};
+
+		const auto cycles
+		{
+			prof::cycles() - started
+		};
+
+		eval.phase_time[which] += elapsed;
+		eval.phase_cycles[which] += cycles;
+		static_cast<uint64_t &>(*phase_cycles[which]) += cycles;
+		(*phase_latency[which])(elapsed);
+	}
+};
+
+decltype(ircd::m::vm::phase_cycles)
+ircd::m::vm::phase_cycles{[]
+{
+	decltype(phase_cycles) ret;
+	for(size_t i(0); i < ret.size(); ++i)
+	{
+		char buf[64], name[32];
+		ret[i] = std::make_unique<stats::item<uint64_t>>(json::members
+		{
+			{ "name", fmt::sprintf
+			{
+				buf, "ircd.m.vm.phase.%s.cycles",
+				tolower(name, reflect(vm::phase(i))),
+			}},
+		});
+	}
+
+	return ret;
+}()};
+
+decltype(ircd::m::vm::log_slow_threshold)
+ircd::m::vm::log_slow_threshold
+{
+	{ "name",     "ircd.m.vm.log.slow.threshold" },
+	{ "default",  2000L                          },
+	{ "description",
+
+	R"(
+	Evals of an event taking longer than this many milliseconds are logged
+	with the time spent in each phase. Zero disables.
+	)"},
+};
+
+decltype(ircd::m::vm::phase_latency)
+ircd::m::vm::phase_latency{[]
+{
+	decltype(phase_latency) ret;
+	for(size_t i(0); i < ret.size(); ++i)
+		ret[i] = std::make_unique<stats::histogram>(json::members
+		{
+			{ "name",    "ircd.m.vm.phase.latency" },
+			{ "labels",  json::members
+			{
+				{ "phase",  reflect(vm::phase(i)) },
+			}},
+		});
+
+	return ret;
+}()};
+
 decltype(ircd::m::vm::log_commit_debug)
 ircd::m::vm::log_commit_debug
 {
@@ -64,6 +162,34 @@ ircd::m::vm::log_accept_info
 	{ "default",  false                       },
 };
 
+/// Maximum time a remote event is held in the EMPTION phase waiting for the
+/// database to leave a stall condition before it is bounced.
+decltype(ircd::m::vm::emption_stall_wait)
+ircd::m::vm::emption_stall_wait
+{
+	{ "name",     "ircd.m.vm.emption.stall.wait" },
+	{ "default",  5000L                          },
+};
+
+/// Size of the windows into an input vector of events. The batch phases for
+/// the next window are conducted on another context while the events of the
+/// present window are executed.
+decltype(ircd::m::vm::pipeline_window)
+ircd::m::vm::pipeline_window
+{
+	{ "name",     "ircd.m.vm.pipeline.window" },
+	{ "default",  64L                         },
+};
+
+/// Number of events taken from an array input at once in bulk-load mode;
+/// these are ordered by room and depth before execution.
+decltype(ircd::m::vm::bulk_window)
+ircd::m::vm::bulk_window
+{
+	{ "name",     "ircd.m.vm.bulk.window" },
+	{ "default",  4096L                   },
+};
+
 decltype(ircd::m::vm::issue_hook)
 ircd::m::vm::issue_hook
 {
@@ -167,21 +293,53 @@ ircd::m::vm::execute(eval &eval,
 		return execute(eval, vector_view(&event, 1));
 	}
 
+	// Bulk loads are ordered so each room's events are written together with
+	// the dependencies of an event preceding it.
+	static const auto bulk_order{[]
+	(const m::event &a, const m::event &b)
+	{
+		return false
+		|| json::get<"room_id"_>(a) < json::get<"room_id"_>(b)
+		|| (json::get<"room_id"_>(a) == json::get<"room_id"_>(b) && json::get<"depth"_>(a) < json::get<"depth"_>(b))
+		;
+	}};
+
 	fault ret{fault::ACCEPT};
-	std::vector<m::event> eventv(64); do
+	std::vector<m::event> eventv
+	(
+		opts.bulk? std::max(size_t(bulk_window), 64UL): 64UL
+	);
+
+	do
 	{
 		size_t i(0);
 		for(; i < eventv.size() && it != end(pdus); ++i, ++it)
 			eventv[i] = json::object(*it);
 
-		if(likely(!opts.ordered))
+		if(likely(!opts.ordered) && opts.bulk)
+			std::stable_sort(begin(eventv), begin(eventv) + i, bulk_order);
+		else if(likely(!opts.ordered))
 			std::sort(begin(eventv), begin(eventv) + i);
 
 		assert(i <= eventv.size());
 		execute(eval, vector_view(eventv.data(), i)); //XXX
+
+		// Notify is skipped in bulk mode; cached heads of the rooms are stale.
+		if(opts.bulk)
+			for(size_t j(0); j < i; ++j)
+				if(json::get<"room_id"_>(eventv[j]))
+					room::head::invalidate(json::get<"room_id"_>(eventv[j]));
 	}
 	while(it != end(pdus) && eval.evaluated < opts.limit);
 
+	// The unjournaled writes of the bulk load are persisted now.
+	if(opts.bulk && opts.phase[phase::WRITE])
+		db::flush(*dbs::events, true);
+
+	// Redactions in the bulk load were not seen by the notify hook.
+	if(opts.bulk && opts.phase[phase::WRITE])
+		m::redacted::rebuild();
+
 	return ret;
 }
 
@@ -205,9 +363,9 @@ ircd::m::vm::execute(eval &eval,
 		eval::executing
 	};
 
-	const scope_restore eval_phase
+	const phase_scope eval_phase
 	{
-		eval.phase, phase::EXECUTE
+		eval, phase::EXECUTE
 	};
 
 	const bool prefetch_keys
@@ -223,6 +381,50 @@ ircd::m::vm::execute(eval &eval,
 			fetch_keys(eval): 0UL
 	};
 
+	const bool batch_verify
+	{
+		opts.phase[phase::VERIFY]
+		&& opts.mverify
+		&& events.size() > 1
+	};
+
+	const std::unique_ptr<bool[]> verified
+	{
+		batch_verify?
+			std::make_unique<bool[]>(events.size()):
+			nullptr
+	};
+
+	const scope_restore eval_verified
+	{
+		eval.verified, vector_view<const bool>
+		(
+			verified.get(), batch_verify? events.size(): 0UL
+		)
+	};
+
+	const bool batch_hash
+	{
+		!opts.edu
+		&& opts.mhash
+		&& events.size() > 1
+	};
+
+	const std::unique_ptr<sha256::buf[]> hashes
+	{
+		batch_hash?
+			std::make_unique<sha256::buf[]>(events.size()):
+			nullptr
+	};
+
+	const scope_restore eval_hashes
+	{
+		eval.hashes, vector_view<const sha256::buf>
+		(
+			hashes.get(), batch_hash? events.size(): 0UL
+		)
+	};
+
 	const bool prefetch_refs
 	{
 		opts.phase[phase::PREINDEX]
@@ -230,70 +432,130 @@ ircd::m::vm::execute(eval &eval,
 		&& events.size() > 1
 	};
 
-	const size_t prefetched_refs
+	// Conducts the batch phases for the events in [start, stop). These only
+	// depend on the event data, so they can run ahead of the evals.
+	const auto prepare{[&opts, &events, &verified, &batch_verify, &hashes, &batch_hash, &prefetch_refs]
+	(const size_t &start, const size_t &stop)
+	{
+		const vector_view<const event> pdus
+		{
+			events.data() + start, events.data() + stop
+		};
+
+		const size_t batch_hashed
+		{
+			batch_hash?
+				hash_pdus(vector_view<sha256::buf>(hashes.get() + start, stop - start), pdus): 0UL
+		};
+
+		const size_t batch_verified
+		{
+			batch_verify?
+				verify_pdus(vector_view<bool>(verified.get() + start, stop - start), pdus): 0UL
+		};
+
+		const size_t prefetched_refs
+		{
+			prefetch_refs?
+				vm::prefetch_refs(pdus, opts.wopts): 0UL
+		};
+	}};
+
+	const size_t window
 	{
-		prefetch_refs?
-			vm::prefetch_refs(eval): 0UL
+		pipeline_window && (batch_verify || batch_hash || prefetch_refs)?
+			std::max(size_t(pipeline_window), 1UL):
+			events.size()
 	};
 
+	prepare(0, std::min(window, events.size()));
+
 	size_t accepted(0), existed(0), i, j, k;
-	for(i = 0; i < events.size(); i += j)
+	for(i = 0; i < events.size() && eval.evaluated < opts.limit; )
 	{
-		id::event ids[64];
-		for(j = 0; j < 64 && i + j < events.size() && eval.evaluated + j < opts.limit; ++j)
-			ids[j] = events[i + j].event_id;
-
-		// Bitset indicating which events already exist.
-		const uint64_t existing
+		const size_t window_stop
 		{
-			!opts.replays?
-				m::exists(vector_view<const id::event>(ids, j)):
-				0UL
+			std::min(i + window, events.size())
 		};
 
-		for(k = 0; k < j; ++k, ++eval.evaluated) try
+		const size_t next_stop
 		{
-			const bool exists
-			(
-				existing & (1 << k)
-			);
+			std::min(window_stop + window, events.size())
+		};
 
-			const auto &event
+		// Prepare the next window while this one executes; none of its events
+		// are reached until that context is joined below.
+		ctx::context next;
+		if(window_stop < next_stop)
+			next = ctx::context
 			{
-				events[i + k]
+				"m.vm.pipe", 512_KiB, ctx::context::POST | ctx::context::WAIT_JOIN, [&prepare, window_stop, next_stop]
+				{
+					prepare(window_stop, next_stop);
+				}
 			};
 
-			const auto fault
+		for(; i < window_stop && eval.evaluated < opts.limit; i += j)
+		{
+			id::event ids[64];
+			for(j = 0; j < 64 && i + j < window_stop && eval.evaluated + j < opts.limit; ++j)
+				ids[j] = events[i + j].event_id;
+
+			// Bitset indicating which events already exist.
+			const uint64_t existing
 			{
-				!exists?
-					execute(eval, event):
-					fault::EXISTS
+				!opts.replays?
+					m::exists(vector_view<const id::event>(ids, j)):
+					0UL
 			};
 
-			existed += exists;
-			accepted += fault == fault::ACCEPT;
-			eval.accepted += fault == fault::ACCEPT;
-			eval.faulted += fault != fault::ACCEPT;
+			for(k = 0; k < j; ++k, ++eval.evaluated) try
+			{
+				const bool exists
+				(
+					existing & (1UL << k)
+				);
 
-			// If handle_fault() was not previously called about this eval
-			if(likely(fault == fault::ACCEPT || exists))
-				handle_fault(opts, fault, event.event_id?: eval.event_id, string_view{});
-		}
-		catch(const ctx::interrupted &)
-		{
-			++eval.faulted;
-			throw;
-		}
-		catch(const std::exception &)
-		{
-			++eval.faulted;
-			continue;
-		}
-		catch(...)
-		{
-			++eval.faulted;
-			throw;
+				const auto &event
+				{
+					events[i + k]
+				};
+
+				const auto fault
+				{
+					!exists?
+						execute(eval, event):
+						fault::EXISTS
+				};
+
+				existed += exists;
+				accepted += fault == fault::ACCEPT;
+				eval.accepted += fault == fault::ACCEPT;
+				eval.faulted += fault != fault::ACCEPT;
+
+				// If handle_fault() was not previously called about this eval
+				if(likely(fault == fault::ACCEPT || exists))
+					handle_fault(opts, fault, event.event_id?: eval.event_id, string_view{});
+			}
+			catch(const ctx::interrupted &)
+			{
+				++eval.faulted;
+				throw;
+			}
+			catch(const std::exception &)
+			{
+				++eval.faulted;
+				continue;
+			}
+			catch(...)
+			{
+				++eval.faulted;
+				throw;
+			}
 		}
+
+		if(next)
+			next.join();
 	}
 
 	return fault::ACCEPT;
@@ -313,6 +575,26 @@ try
 		vm::dock
 	};
 
+	// The accounting of the phases is for each event in the eval.
+	eval.phase_cycles.fill(0);
+	eval.phase_time.fill(0ns);
+	const ircd::timer timer;
+	const unwind slow{[&eval, &event, &timer]
+	{
+		const auto elapsed
+		{
+			timer.at<nanoseconds>()
+		};
+
+		const milliseconds threshold
+		{
+			log_slow_threshold
+		};
+
+		if(threshold.count() && elapsed > threshold)
+			log_slow(eval, event, elapsed);
+	}};
+
 	assert(eval.opts);
 	const auto &opts
 	{
@@ -360,9 +642,9 @@ try
 	// local queries may still be made by the hook, such as m::redacted().
 	if(likely(opts.phase[phase::CONFORM]) && !opts.edu)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::CONFORM
+			eval, phase::CONFORM
 		};
 
 		call_hook(conform_hook, eval, event, eval);
@@ -465,9 +747,25 @@ try
 		m::version(room_version_buf, room{eval.room_id}, std::nothrow)
 	};
 
+	// Check if the reference hash of this pdu was computed in a batch.
+	const auto pos
+	{
+		std::addressof(event) - eval.pdus.data()
+	};
+
+	const bool hashed
+	{
+		pos >= 0
+		&& size_t(pos) < eval.hashes.size()
+		&& eval.hashes[pos] != sha256::buf{}
+	};
+
 	// Copy the event_id into the eval buffer
 	eval.event_id =
 	{
+		!opts.edu && !_event.event_id && hashed?
+			event::id::buf{make_id(_event, eval.room_version == "3"? "3"_sv: "4"_sv, eval.event_id, eval.hashes[pos])}:
+
 		!opts.edu && !_event.event_id && eval.room_version == "3"?
 			event::id::buf{event::id::v3{eval.event_id, _event}}:
 
@@ -485,9 +783,9 @@ try
 	// rejected here, as the first eval might fail and the second might not.
 	if(likely(opts.phase[phase::DUPWAIT]) && eval.event_id)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::DUPWAIT
+			eval, phase::DUPWAIT
 		};
 
 		// Prevent more than one event with the same event_id from
@@ -598,9 +896,9 @@ try
 	// created event.
 	if(opts.phase[phase::ISSUE] && eval.copts && eval.copts->issue)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::ISSUE
+			eval, phase::ISSUE
 		};
 
 		call_hook(issue_hook, eval, event, eval);
@@ -627,11 +925,11 @@ try
 
 	// The event was executed; now we broadcast the good news. This will
 	// include notifying client `/sync` and the federation sender.
-	if(likely(opts.phase[phase::NOTIFY]))
+	if(likely(opts.phase[phase::NOTIFY]) && !opts.bulk)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::NOTIFY
+			eval, phase::NOTIFY
 		};
 
 		call_hook(notify_hook, eval, event, eval);
@@ -641,15 +939,9 @@ try
 	// These can include the creation of even more events, such as creating a
 	// PDU out of an EDU, etc. Unlike the post_hook in execute_pdu(), the
 	// notify for the event at issue here has already been made.
-	if(likely(opts.phase[phase::EFFECTS]))
-	{
-		const scope_restore eval_phase
-		{
-			eval.phase, phase::EFFECTS
-		};
-
-		call_hook(effect_hook, eval, event, eval);
-	}
+	if(likely(opts.phase[phase::EFFECTS]) && !opts.bulk)
+		if(!effects::defer(eval, event))
+			effects::call(eval, event);
 
 	if(opts.infolog_accept || bool(log_accept_info))
 		log::info
@@ -730,15 +1022,54 @@ catch(const std::exception &e) // ALL OTHER ERRORS
 	);
 }
 
+void
+ircd::m::vm::log_slow(const eval &eval,
+                      const event &event,
+                      const nanoseconds &elapsed)
+noexcept
+{
+	char buf[512];
+	window_buffer wb{buf};
+	for(size_t i(phase::CONFORM); i < eval.phase_time.size(); ++i)
+	{
+		const auto ms
+		{
+			duration_cast<milliseconds>(eval.phase_time[i])
+		};
+
+		if(!ms.count())
+			continue;
+
+		wb([&i, &ms](const mutable_buffer &buf)
+		{
+			return size(fmt::sprintf
+			{
+				buf, " %s:%ld",
+				reflect(phase(i)),
+				ms.count(),
+			});
+		});
+	}
+
+	log::warning
+	{
+		log, "%s %s slow eval in %ld ms; phases (ms):%s",
+		loghead(eval),
+		json::get<"room_id"_>(event),
+		duration_cast<milliseconds>(elapsed).count(),
+		string_view{wb.completed()},
+	};
+}
+
 ircd::m::vm::fault
 ircd::m::vm::execute_edu(eval &eval,
                          const event &event)
 {
 	if(likely(eval.opts->phase[phase::EVALUATE]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::EVALUATE
+			eval, phase::EVALUATE
 		};
 
 		call_hook(eval_hook, eval, event, eval);
@@ -746,9 +1077,9 @@ ircd::m::vm::execute_edu(eval &eval,
 
 	if(likely(eval.opts->phase[phase::POST]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::POST
+			eval, phase::POST
 		};
 
 		call_hook(post_hook, eval, event, eval);
@@ -809,9 +1140,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Check if an event with the same ID was already accepted.
 	if(likely(opts.phase[phase::DUPCHK]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::DUPCHK
+			eval, phase::DUPCHK
 		};
 
 		// Prevent the same event from being accepted twice.
@@ -833,9 +1164,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Check if event's proprietor is denied by the room ACL.
 	if(likely(opts.phase[phase::ACCESS]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::ACCESS
+			eval, phase::ACCESS
 		};
 
 		call_hook(access_hook, eval, event, eval);
@@ -844,9 +1175,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Check if this event is relevant to this server.
 	if(likely(opts.phase[phase::EMPTION]) && !eval.room_internal)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::EMPTION
+			eval, phase::EMPTION
 		};
 
 		emption_check(eval, event);
@@ -854,12 +1185,25 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::VERIFY]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::VERIFY
+			eval, phase::VERIFY
 		};
 
-		if(!verify(event))
+		// Check if this pdu already passed in a batch verification.
+		const auto pos
+		{
+			std::addressof(event) - eval.pdus.data()
+		};
+
+		const bool verified
+		{
+			pos >= 0
+			&& size_t(pos) < eval.verified.size()
+			&& eval.verified[pos]
+		};
+
+		if(!verified && !verify(event))
 			throw m::BAD_SIGNATURE
 			{
 				"Signature verification failed."
@@ -868,9 +1212,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::FETCH_AUTH] && opts.fetch))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::FETCH_AUTH
+			eval, phase::FETCH_AUTH
 		};
 
 		call_hook(fetch_auth_hook, eval, event, eval);
@@ -879,9 +1223,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Evaluation by auth system; throws
 	if(likely(opts.phase[phase::AUTH_STATIC]) && authenticate)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::AUTH_STATIC
+			eval, phase::AUTH_STATIC
 		};
 
 		const auto &[pass, fail]
@@ -899,9 +1243,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::FETCH_PREV] && opts.fetch))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::FETCH_PREV
+			eval, phase::FETCH_PREV
 		};
 
 		call_hook(fetch_prev_hook, eval, event, eval);
@@ -909,9 +1253,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::FETCH_STATE] && opts.fetch))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::FETCH_STATE
+			eval, phase::FETCH_STATE
 		};
 
 		call_hook(fetch_state_hook, eval, event, eval);
@@ -950,9 +1294,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Allocate transaction; prefetch dependencies.
 	if(likely(opts.phase[phase::PREINDEX]) && !opts.mprefetch_refs)
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::PREINDEX
+			eval, phase::PREINDEX
 		};
 
 		dbs::write_opts wopts(opts.wopts);
@@ -963,9 +1307,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 		};
 	}
 
-	const scope_restore eval_phase_precommit
+	const phase_scope eval_phase_precommit
 	{
-		eval.phase, phase::PRECOMMIT
+		eval, phase::PRECOMMIT
 	};
 
 	// Wait until this is the lowest sequence number
@@ -980,9 +1324,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 
 	if(likely(opts.phase[phase::AUTH_RELA] && authenticate))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::AUTH_RELA
+			eval, phase::AUTH_RELA
 		};
 
 		const auto &[pass, fail]
@@ -1005,9 +1349,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	assert(sequence::retired < sequence::get(eval));
 	sequence::uncommitted = std::max(sequence::get(eval), sequence::uncommitted);
 
-	const scope_restore eval_phase_commit
+	const phase_scope eval_phase_commit
 	{
-		eval.phase, phase::COMMIT
+		eval, phase::COMMIT
 	};
 
 	// Wait until this is the lowest sequence number
@@ -1019,12 +1363,17 @@ ircd::m::vm::execute_pdu(eval &eval,
 		;
 	});
 
+	// Wait for any grouped write still carrying an event in this room so
+	// the present state observed below includes it.
+	if(likely(!parent_post))
+		write_commit_wait(eval);
+
 	// Reevaluation of auth against the present state of the room.
 	if(likely(opts.phase[phase::AUTH_PRES] && authenticate))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::AUTH_PRES
+			eval, phase::AUTH_PRES
 		};
 
 		room::auth::check_present(event);
@@ -1033,9 +1382,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Evaluation by module hooks
 	if(likely(opts.phase[phase::EVALUATE]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::EVALUATE
+			eval, phase::EVALUATE
 		};
 
 		call_hook(eval_hook, eval, event, eval);
@@ -1044,9 +1393,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Allocate transaction; discover shared-sequenced evals.
 	if(likely(opts.phase[phase::INDEX]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::INDEX
+			eval, phase::INDEX
 		};
 
 		// Transaction composition.
@@ -1057,9 +1406,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// an entire eval of several more events recursively before returning.
 	if(likely(opts.phase[phase::POST]))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::POST
+			eval, phase::POST
 		};
 
 		call_hook(post_hook, eval, event, eval);
@@ -1074,9 +1423,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// Commit the transaction to database iff this eval is at the stack base.
 	if(likely(opts.phase[phase::WRITE] && !parent_post))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::WRITE
+			eval, phase::WRITE
 		};
 
 		write_commit(eval);
@@ -1086,9 +1435,9 @@ ircd::m::vm::execute_pdu(eval &eval,
 	// never return back to that stack base.
 	if(likely(!parent_post))
 	{
-		const scope_restore eval_phase
+		const phase_scope eval_phase
 		{
-			eval.phase, phase::RETIRE
+			eval, phase::RETIRE
 		};
 
 		retire(eval, event);
@@ -1097,6 +1446,18 @@ ircd::m::vm::execute_pdu(eval &eval,
 	return fault::ACCEPT;
 }
 
+void
+ircd::m::vm::effects::call(eval &eval,
+                           const event &event)
+{
+	const phase_scope eval_phase
+	{
+		eval, phase::EFFECTS
+	};
+
+	call_hook(effect_hook, eval, event, eval);
+}
+
 void
 ircd::m::vm::retire(eval &eval,
                     const event &event)
@@ -1146,12 +1507,67 @@ ircd::m::vm::retire(eval &eval,
 
 namespace ircd::m::vm
 {
+	struct write_group_entry;
+
 	[[gnu::visibility("internal")]]
 	extern stats::item<uint64_t>
 	write_commit_count,
-	write_commit_cycles;
+	write_commit_cycles,
+	write_commit_grouped;
+
+	extern conf::item<bool> write_commit_group_enable;
+	extern conf::item<size_t> write_commit_group_max;
+	extern conf::item<milliseconds> write_commit_group_wait;
+
+	static std::vector<write_group_entry *> write_group;
+	static ctx::dock write_group_dock;
+	static size_t write_group_blocked;
+	static bool write_group_leader;
 }
 
+/// An eval's stake in a group commit. The entry lives on the stack of the
+/// eval's context while it is queued; the leader marks it done (or stores
+/// the exception) after the combined batch is written.
+struct ircd::m::vm::write_group_entry
+{
+	vm::eval *eval {nullptr};
+	std::exception_ptr eptr;
+	bool done {false};
+};
+
+/// Concurrently committing evals have their transactions written to the
+/// events database as a single batch by the first to arrive.
+decltype(ircd::m::vm::write_commit_group_enable)
+ircd::m::vm::write_commit_group_enable
+{
+	{ "name",     "ircd.m.vm.write_commit.group.enable" },
+	{ "default",  true                                  },
+};
+
+/// Maximum number of evals in one group commit.
+decltype(ircd::m::vm::write_commit_group_max)
+ircd::m::vm::write_commit_group_max
+{
+	{ "name",     "ircd.m.vm.write_commit.group.max" },
+	{ "default",  64L                                },
+};
+
+/// Maximum time the leader holds a group open for evals which have already
+/// entered the commit phase behind it. The leader only waits when such evals
+/// exist, so an uncontended eval is written without delay.
+decltype(ircd::m::vm::write_commit_group_wait)
+ircd::m::vm::write_commit_group_wait
+{
+	{ "name",     "ircd.m.vm.write_commit.group.wait" },
+	{ "default",  2L                                  },
+};
+
+decltype(ircd::m::vm::write_commit_grouped)
+ircd::m::vm::write_commit_grouped
+{
+	{ "name", "ircd.m.vm.write_commit.grouped" },
+};
+
 decltype(ircd::m::vm::write_commit_cycles)
 ircd::m::vm::write_commit_cycles
 {
@@ -1164,9 +1580,181 @@ ircd::m::vm::write_commit_count
 	{ "name", "ircd.m.vm.write_commit.count" },
 };
 
+void
+ircd::m::vm::write_commit_wait(eval &eval)
+{
+	const auto conflict{[&eval]
+	{
+		return std::any_of(begin(write_group), end(write_group), [&eval]
+		(const auto *const entry)
+		{
+			return entry->eval->room_id == eval.room_id;
+		});
+	}};
+
+	if(!eval.room_id || !conflict())
+		return;
+
+	const scope_count blocked
+	{
+		write_group_blocked
+	};
+
+	write_group_dock.notify_all();
+	write_group_dock.wait([&conflict]
+	{
+		return !conflict();
+	});
+}
+
+void
+ircd::m::vm::write_commit_group(eval &eval)
+{
+	write_group_entry entry
+	{
+		&eval
+	};
+
+	write_group.emplace_back(&entry);
+	write_group_dock.notify_all();
+
+	// When another eval is leading the group this eval's transaction is
+	// written with it; the leadership passes on if it leaves entries behind.
+	write_group_dock.wait([&entry]
+	{
+		return entry.done || !write_group_leader;
+	});
+
+	if(entry.done && entry.eptr)
+		std::rethrow_exception(entry.eptr);
+
+	if(entry.done)
+		return;
+
+	const scope_restore leader
+	{
+		write_group_leader, true
+	};
+
+	const scope_notify notify
+	{
+		write_group_dock, scope_notify::all
+	};
+
+	// Let the evals behind this one in the commit phase proceed to compose
+	// their transactions while the group is held open.
+	const auto max(std::max(size_t(write_commit_group_max), 1UL));
+	if(sequence::uncommitted > sequence::get(eval) && max > 1)
+	{
+		sequence::dock.notify_all();
+		write_group_dock.wait_for(milliseconds(write_commit_group_wait), [&max]
+		{
+			return false
+			|| write_group.size() >= max
+			|| write_group_blocked
+			|| sequence::get(*write_group.back()->eval) >= sequence::uncommitted
+			;
+		});
+	}
+
+	while(!entry.done)
+	{
+		assert(!write_group.empty());
+		const auto count
+		{
+			std::min(write_group.size(), max)
+		};
+
+		const std::vector<write_group_entry *> group
+		(
+			begin(write_group), begin(write_group) + count
+		);
+
+		write_group.erase(begin(write_group), begin(write_group) + count);
+
+		std::vector<db::txn *> txns(group.size());
+		std::transform(begin(group), end(group), begin(txns), []
+		(const auto *const entry)
+		{
+			assert(entry->eval->txn);
+			assert(entry->eval->txn.use_count() == 1);
+			return entry->eval->txn.get();
+		});
+
+		size_t cells(0), bytes(0);
+		for(const auto *const txn : txns)
+		{
+			cells += txn->size();
+			bytes += txn->bytes();
+		}
+
+		// The journal is only bypassed when every member is a bulk load.
+		const bool bulk
+		{
+			std::all_of(begin(group), end(group), []
+			(const auto *const entry)
+			{
+				return entry->eval->opts && entry->eval->opts->bulk;
+			})
+		};
+
+		const db::sopts sopts
+		{
+			bulk?
+				db::sopts{db::set::NO_JOURNAL}:
+				db::sopts{}
+		};
+
+		const uint64_t cyc_before {write_commit_cycles};
+		std::exception_ptr eptr; try
+		{
+			const prof::scope_cycles cycles
+			{
+				write_commit_cycles
+			};
+
+			db::commit(txns, sopts);
+		}
+		catch(...)
+		{
+			eptr = std::current_exception();
+		}
+
+		for(auto *const member : group)
+		{
+			member->eptr = eptr;
+			member->done = true;
+		}
+
+		if(eptr)
+			continue;
+
+		++write_commit_count;
+		write_commit_grouped += group.size() > 1? group.size(): 0;
+		log::debug
+		{
+			log, "%s wrote %lu:%lu in group of %zu | txn:%lu cells:%zu in bytes:%zu cycles:%lu to events database",
+			loghead(eval),
+			sequence::get(*group.front()->eval),
+			sequence::get(*group.back()->eval),
+			group.size(),
+			uint64_t(write_commit_count),
+			cells,
+			bytes,
+			uint64_t(write_commit_cycles) - cyc_before,
+		};
+	}
+
+	if(entry.eptr)
+		std::rethrow_exception(entry.eptr);
+}
+
 void
 ircd::m::vm::write_commit(eval &eval)
 {
+	if(write_commit_group_enable)
+		return write_commit_group(eval);
+
 	assert(eval.txn);
 	assert(eval.txn.use_count() == 1);
 	auto &txn
@@ -1190,7 +1778,15 @@ ircd::m::vm::write_commit(eval &eval)
 			write_commit_cycles
 		};
 
-		txn();
+		assert(eval.opts);
+		const db::sopts sopts
+		{
+			eval.opts->bulk?
+				db::sopts{db::set::NO_JOURNAL}:
+				db::sopts{}
+		};
+
+		txn(sopts);
 	}
 
 	++write_commit_count;
@@ -1262,10 +1858,12 @@ ircd::m::vm::write_append(eval &eval,
 	wopts.event_idx = eval.sequence;
 	wopts.json_source = true;
 
-	// Don't update or resolve the room head with this shit.
+	// Don't update or resolve the room head with this shit. Our own dummy
+	// events are issued to merge the head and take its place.
 	const bool dummy_event
 	{
 		json::get<"type"_>(event) == "org.matrix.dummy_event"
+		&& !my(event)
 	};
 
 	wopts.appendix.set
@@ -1368,6 +1966,28 @@ void
 ircd::m::vm::emption_check(eval &eval,
                            const m::event &event)
 {
+	// Remote events are held here while the database is stalled rather than
+	// being admitted to block in the commit path; they bounce back to their
+	// origin after the wait so that it retries later.
+	if(!my(event) && dbs::stalled())
+	{
+		const auto timeout
+		{
+			now<steady_point>() + milliseconds(emption_stall_wait)
+		};
+
+		while(dbs::stalled() && now<steady_point>() < timeout)
+			ctx::sleep(milliseconds(250));
+
+		if(dbs::stalled())
+			throw vm::error
+			{
+				http::SERVICE_UNAVAILABLE, fault::BOUNCE,
+				"Database stalled; %s not accepted at this time.",
+				string_view{event.event_id},
+			};
+	}
+
 	const bool my_target_member_event
 	{
 		json::get<"type"_>(event) == "m.room.member"
@@ -12,10 +12,14 @@ namespace ircd::m::vm::fetch
 {
 	static void prev_check(const event &, vm::eval &);
 	static bool prev_wait(const event &, vm::eval &);
+	static size_t prev_missing_servers(const event &, vm::eval &, const room &, std::set<std::string, std::less<>> &);
+	static std::vector<event::id::buf> prev_missing_window(const json::array &, const size_t &limit);
+	static bool prev_missing(const event &, vm::eval &, const room &);
 	static std::forward_list<ctx::future<m::fetch::result>> prev_fetch(const event &, vm::eval &, const room &);
 	static void prev(const event &, vm::eval &, const room &);
 	static std::forward_list<ctx::future<m::fetch::result>> state_fetch(const event &, vm::eval &, const room &);
 	static void state(const event &, vm::eval &, const room &);
+	static std::vector<std::vector<m::event>> auth_chain_layers(const vector_view<const m::event> &);
 	static void auth_chain_eval(const event &, vm::eval &, const room &, const json::array &, const string_view &);
 	static void auth_chain(const event &, vm::eval &, const room &);
 	static void auth(const event &, vm::eval &, const room &);
@@ -25,9 +29,16 @@ namespace ircd::m::vm::fetch
 	extern conf::item<milliseconds> prev_wait_time;
 	extern conf::item<size_t> prev_wait_count;
 	extern conf::item<size_t> prev_backfill_limit;
+	extern conf::item<bool> prev_missing_enable;
+	extern conf::item<size_t> prev_missing_limit;
+	extern conf::item<size_t> prev_missing_rounds;
+	extern conf::item<size_t> prev_missing_servers_max;
 	extern conf::item<seconds> event_timeout;
 	extern conf::item<seconds> state_timeout;
 	extern conf::item<seconds> auth_timeout;
+	extern conf::item<size_t> auth_concurrency;
+	extern conf::item<size_t> auth_concurrency_min;
+	extern const ctx::pool::opts auth_pool_opts;
 	extern conf::item<bool> enable;
 	extern hookfn<vm::eval &> auth_hook;
 	extern hookfn<vm::eval &> prev_hook;
@@ -82,6 +93,35 @@ ircd::m::vm::fetch::auth_timeout
 	{ "default",  15L                            },
 };
 
+/// Events of an auth chain which don't depend on each other are evaluated on
+/// up to this many contexts at once; one or zero evaluates the chain in order.
+decltype(ircd::m::vm::fetch::auth_concurrency)
+ircd::m::vm::fetch::auth_concurrency
+{
+	{ "name",     "ircd.m.vm.fetch.auth.concurrency" },
+	{ "default",  8L                                 },
+};
+
+/// Layers of the auth chain with fewer events than this are evaluated in
+/// order with the layers around them rather than concurrently.
+decltype(ircd::m::vm::fetch::auth_concurrency_min)
+ircd::m::vm::fetch::auth_concurrency_min
+{
+	{ "name",     "ircd.m.vm.fetch.auth.concurrency.min" },
+	{ "default",  16L                                    },
+};
+
+decltype(ircd::m::vm::fetch::auth_pool_opts)
+ircd::m::vm::fetch::auth_pool_opts
+{
+	1_MiB,                 // stack sz
+	0,                     // pool sz
+	-1,                    // queue max hard
+	0,                     // queue max soft
+	true,                  // queue max blocking
+	false,                 // queue max warning
+};
+
 decltype(ircd::m::vm::fetch::state_timeout)
 ircd::m::vm::fetch::state_timeout
 {
@@ -103,6 +143,38 @@ ircd::m::vm::fetch::prev_backfill_limit
 	{ "default",  128L                                  },
 };
 
+decltype(ircd::m::vm::fetch::prev_missing_enable)
+ircd::m::vm::fetch::prev_missing_enable
+{
+	{ "name",     "ircd.m.vm.fetch.prev.missing.enable" },
+	{ "default",  true                                  },
+	{ "help",     "Close gaps with get_missing_events before backfilling." },
+};
+
+decltype(ircd::m::vm::fetch::prev_missing_limit)
+ircd::m::vm::fetch::prev_missing_limit
+{
+	{ "name",     "ircd.m.vm.fetch.prev.missing.limit" },
+	{ "default",  20L                                  },
+	{ "help",     "Number of events requested for each window." },
+};
+
+decltype(ircd::m::vm::fetch::prev_missing_rounds)
+ircd::m::vm::fetch::prev_missing_rounds
+{
+	{ "name",     "ircd.m.vm.fetch.prev.missing.rounds" },
+	{ "default",  8L                                    },
+	{ "help",     "Maximum number of windows walked back over a gap." },
+};
+
+decltype(ircd::m::vm::fetch::prev_missing_servers_max)
+ircd::m::vm::fetch::prev_missing_servers_max
+{
+	{ "name",     "ircd.m.vm.fetch.prev.missing.servers" },
+	{ "default",  3L                                     },
+	{ "help",     "Number of servers each window is requested from at once." },
+};
+
 decltype(ircd::m::vm::fetch::prev_wait_count)
 ircd::m::vm::fetch::prev_wait_count
 {
@@ -350,28 +422,94 @@ try
 	opts.notify_servers = false;
 	opts.node_id = origin;
 
-	std::vector<m::event> auth_chain
-	(
-		std::begin(auth_chain_), std::end(auth_chain_)
-	);
+	// The event_id's are computed for the topological sort; event_id is not
+	// part of the event's JSON in later room versions.
+	std::vector<event::id::buf> event_id(auth_chain_.size());
+	std::vector<m::event> auth_chain;
+	auth_chain.reserve(auth_chain_.size());
+	for(const json::object pdu : auth_chain_)
+		auth_chain.emplace_back(event_id.at(auth_chain.size()), pdu, eval.room_version);
 
 	// pre-sort here and indicate that to eval.
 	std::sort(begin(auth_chain), end(auth_chain));
 	opts.ordered = true;
 
+	const auto layers
+	{
+		auth_chain_layers(auth_chain)
+	};
+
 	log::debug
 	{
-		log, "Evaluating auth chain for %s in %s events:%zu",
+		log, "Evaluating auth chain for %s in %s events:%zu layers:%zu",
 		string_view{room.event_id},
 		string_view{room.room_id},
 		auth_chain.size(),
+		layers.size(),
 	};
 
-	// eval
-	m::vm::eval
+	// Small layers are accumulated and evaluated in order; this preserves
+	// the batch verification and prefetch of the vector eval for them.
+	std::vector<m::event> serial;
+	std::optional<ctx::pool> pool;
+	for(const auto &layer : layers)
 	{
-		auth_chain, opts
-	};
+		const bool concurrent
+		{
+			size_t(auth_concurrency) > 1
+			&& layer.size() >= std::max(size_t(auth_concurrency_min), 2UL)
+		};
+
+		if(!concurrent)
+		{
+			serial.insert(end(serial), begin(layer), end(layer));
+			continue;
+		}
+
+		if(!serial.empty())
+		{
+			m::vm::eval
+			{
+				serial, opts
+			};
+
+			serial.clear();
+		}
+
+		// Each context evaluates a share of the layer as a vector so its
+		// signatures are still verified in a batch.
+		std::vector<std::vector<m::event>> shares
+		(
+			std::min(size_t(auth_concurrency), layer.size())
+		);
+
+		for(size_t i(0); i < layer.size(); ++i)
+			shares.at(i % shares.size()).emplace_back(layer[i]);
+
+		if(!pool)
+			pool.emplace("m.vm.fetch.auth", auth_pool_opts);
+
+		pool->min(shares.size());
+		auto sopts(opts);
+		sopts.out = nullptr;
+		ctx::concurrent_for_each<std::vector<m::event>>
+		{
+			*pool, shares, [&sopts]
+			(auto &events)
+			{
+				m::vm::eval
+				{
+					events, sopts
+				};
+			}
+		};
+	}
+
+	if(!serial.empty())
+		m::vm::eval
+		{
+			serial, opts
+		};
 }
 catch(const std::exception &e)
 {
@@ -386,6 +524,78 @@ catch(const std::exception &e)
 	throw;
 }
 
+/// Partitions the auth chain into layers where every event only references
+/// events of the chain in the layers before it. The events retain their
+/// relative order within each layer. Events on a cycle, which can't be
+/// authorized anyway, are placed in a final layer.
+std::vector<std::vector<ircd::m::event>>
+ircd::m::vm::fetch::auth_chain_layers(const vector_view<const m::event> &auth_chain)
+{
+	std::map<string_view, size_t, std::less<>> pos;
+	for(size_t i(0); i < auth_chain.size(); ++i)
+		if(auth_chain[i].event_id)
+			pos.emplace(auth_chain[i].event_id, i);
+
+	std::vector<size_t> degree(auth_chain.size(), 0);
+	std::vector<std::vector<size_t>> dependents(auth_chain.size());
+	for(size_t i(0); i < auth_chain.size(); ++i)
+	{
+		const event::auth auth
+		{
+			auth_chain[i]
+		};
+
+		for(size_t j(0); j < auth.auth_events_count(); ++j)
+		{
+			const auto it
+			{
+				pos.find(auth.auth_event(j))
+			};
+
+			if(it == end(pos) || it->second == i)
+				continue;
+
+			dependents.at(it->second).emplace_back(i);
+			++degree.at(i);
+		}
+	}
+
+	std::vector<size_t> frontier;
+	for(size_t i(0); i < auth_chain.size(); ++i)
+		if(!degree[i])
+			frontier.emplace_back(i);
+
+	size_t layered(0);
+	std::vector<std::vector<m::event>> ret;
+	while(!frontier.empty())
+	{
+		std::vector<size_t> next;
+		auto &layer(ret.emplace_back());
+		layer.reserve(frontier.size());
+		for(const auto &i : frontier)
+		{
+			layer.emplace_back(auth_chain[i]);
+			for(const auto &j : dependents[i])
+				if(!--degree[j])
+					next.emplace_back(j);
+		}
+
+		layered += frontier.size();
+		std::sort(begin(next), end(next));
+		frontier = std::move(next);
+	}
+
+	if(layered < auth_chain.size())
+	{
+		auto &layer(ret.emplace_back());
+		for(size_t i(0); i < auth_chain.size(); ++i)
+			if(degree[i])
+				layer.emplace_back(auth_chain[i]);
+	}
+
+	return ret;
+}
+
 //
 // state handler stack
 //
@@ -503,6 +713,11 @@ ircd::m::vm::fetch::prev(const event &event,
 		return;
 	}
 
+	// Walk back over the gap with get_missing_events; anything this did not
+	// satisfy falls through to backfilling off each missing prev_event.
+	if(prev_missing_enable && prev_missing(event, eval, room))
+		return;
+
 	auto futures
 	{
 		prev_fetch(event, eval, room)
@@ -600,10 +815,344 @@ ircd::m::vm::fetch::prev(const event &event,
 		};
 	}
 
+	// Missing prev_events which were being evaluated elsewhere were not
+	// fetched; their evals are given the remainder of the timeout.
+	const auto remain
+	{
+		duration_cast<milliseconds>(timeout - now<system_point>())
+	};
+
+	for(size_t i(0); i < prev_count; ++i)
+		if(!m::exists(prev.prev_event(i)))
+			m::fetch::wait(prev.prev_event(i), std::max(remain, 0ms));
+
 	// check if result evals have satisfied this eval now; or throw
 	prev_check(event, eval);
 }
 
+/// Requests the events between our room heads and this event from several
+/// servers at once, taking the first good response. The lowest events of
+/// each response become the latest_events of the next window, which is
+/// requested before the current response is evaluated so the round trip
+/// overlaps with evaluation. Returns true when all prev_events now exist.
+bool
+ircd::m::vm::fetch::prev_missing(const event &event,
+                                 vm::eval &eval,
+                                 const room &room)
+try
+{
+	const event::prev prev{event};
+	const size_t prev_count
+	{
+		prev.prev_events_count()
+	};
+
+	std::set<std::string, std::less<>> servers;
+	if(!prev_missing_servers(event, eval, room, servers))
+		return false;
+
+	// Our side of the gap.
+	std::vector<event::id::buf> earliest;
+	m::room::head{room}.for_each([&earliest]
+	(const event::idx &, const event::id &event_id)
+	{
+		earliest.emplace_back(event_id);
+		return earliest.size() < 16;
+	});
+
+	const std::vector<event::id> earliest_ids
+	(
+		begin(earliest), end(earliest)
+	);
+
+	struct request
+	{
+		std::string origin;
+		unique_buffer<mutable_buffer> buf;
+		fed::frontfill frontfill;
+	};
+
+	const size_t limit
+	{
+		std::min(size_t(prev_missing_limit), eval.opts->fetch_prev_limit)
+	};
+
+	const auto launch{[&](const std::vector<event::id::buf> &latest)
+	{
+		const std::vector<event::id> latest_ids
+		(
+			begin(latest), end(latest)
+		);
+
+		std::list<request> ret;
+		for(const auto &server : servers) try
+		{
+			fed::frontfill::opts opts;
+			opts.remote = server;
+			opts.limit = limit;
+			unique_buffer<mutable_buffer> buf
+			{
+				16_KiB
+			};
+
+			fed::frontfill frontfill
+			{
+				room.room_id,
+				fed::frontfill::ranges{earliest_ids, latest_ids},
+				buf,
+				std::move(opts)
+			};
+
+			ret.emplace_back(request{server, std::move(buf), std::move(frontfill)});
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::derror
+			{
+				log, "%s get_missing_events to '%s' :%s",
+				loghead(eval),
+				server,
+				e.what(),
+			};
+		}
+
+		return ret;
+	}};
+
+	// Takes the first satisfying response out of the pending requests.
+	const auto receive{[&eval](std::list<request> &pending,
+	                          unique_buffer<mutable_buffer> &buf,
+	                          std::string &origin)
+	{
+		const auto timeout
+		{
+			now<system_point>() + seconds(event_timeout)
+		};
+
+		size_t remain(std::distance(begin(pending), end(pending)));
+		while(remain--)
+		{
+			auto next
+			{
+				ctx::when_any(begin(pending), end(pending), []
+				(auto &it) -> server::request &
+				{
+					return it->frontfill;
+				})
+			};
+
+			if(!next.wait_until(timeout, std::nothrow))
+				break;
+
+			const auto it
+			{
+				next.get()
+			};
+
+			if(it == end(pending))
+				break;
+
+			try
+			{
+				it->frontfill.get();
+				origin = std::move(it->origin);
+				buf = std::move(it->frontfill.in.dynamic);
+				return json::array(it->frontfill);
+			}
+			catch(const ctx::interrupted &)
+			{
+				throw;
+			}
+			catch(const std::exception &e)
+			{
+				log::derror
+				{
+					log, "%s get_missing_events from '%s' :%s",
+					loghead(eval),
+					it->origin,
+					e.what(),
+				};
+			}
+		}
+
+		return json::array{};
+	}};
+
+	std::vector<event::id::buf> window
+	{
+		event::id::buf{event.event_id}
+	};
+
+	auto pending
+	{
+		launch(window)
+	};
+
+	size_t round(0), evaluated(0);
+	while(!pending.empty())
+	{
+		unique_buffer<mutable_buffer> buf;
+		std::string origin;
+		const json::array pdus
+		{
+			receive(pending, buf, origin)
+		};
+
+		pending.clear();
+		if(pdus.empty())
+			break;
+
+		// Launch the next window before evaluating this one.
+		window = prev_missing_window(pdus, limit);
+		if(!window.empty() && ++round < size_t(prev_missing_rounds))
+			pending = launch(window);
+
+		auto opts(*eval.opts);
+		opts.phase.set(m::vm::phase::FETCH_PREV, false);
+		opts.phase.set(m::vm::phase::FETCH_STATE, false);
+		opts.notify_servers = false;
+		opts.node_id = origin;
+		log::debug
+		{
+			log, "%s get_missing_events %zu pdus from '%s' round:%zu; evaluating...",
+			loghead(eval),
+			pdus.size(),
+			origin,
+			round,
+		};
+
+		evaluated += pdus.size();
+		vm::eval
+		{
+			pdus, opts
+		};
+
+		if(prev.prev_events_exist() == prev_count)
+			return true;
+	}
+
+	log::dwarning
+	{
+		log, "%s get_missing_events evaluated:%zu rounds:%zu unsatisfied",
+		loghead(eval),
+		evaluated,
+		round,
+	};
+
+	return false;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s get_missing_events :%s",
+		loghead(eval),
+		e.what(),
+	};
+
+	return false;
+}
+
+/// The next window is latest_events made of the lowest events in the
+/// response which still have missing prev_events. An empty result means the
+/// remote had nothing more or the gap is closed.
+std::vector<ircd::m::event::id::buf>
+ircd::m::vm::fetch::prev_missing_window(const json::array &pdus,
+                                        const size_t &limit)
+{
+	std::vector<event::id::buf> ret;
+	if(pdus.size() < limit)
+		return ret;
+
+	int64_t depth(std::numeric_limits<int64_t>::max());
+	for(const json::object pdu : pdus)
+		depth = std::min(depth, pdu.get<int64_t>("depth", depth));
+
+	for(const json::object pdu : pdus)
+	{
+		if(pdu.get<int64_t>("depth", 0) != depth)
+			continue;
+
+		event::id::buf event_id;
+		const m::event event
+		{
+			event_id, pdu
+		};
+
+		const event::prev prev{event};
+		if(prev.prev_events_exist() == prev.prev_events_count())
+			continue;
+
+		ret.emplace_back(event.event_id);
+		if(ret.size() >= 8)
+			break;
+	}
+
+	return ret;
+}
+
+/// Selects the servers requested for each window: the sender of this event
+/// first, then others in the room at random.
+size_t
+ircd::m::vm::fetch::prev_missing_servers(const event &event,
+                                         vm::eval &eval,
+                                         const room &room,
+                                         std::set<std::string, std::less<>> &ret)
+{
+	const size_t max
+	{
+		prev_missing_servers_max
+	};
+
+	const auto proffer{[&ret](const string_view &server)
+	{
+		return server
+		&& !my_host(server)
+		&& !ret.count(server)
+		&& !fed::errant(server);
+	}};
+
+	const string_view hints[]
+	{
+		eval.opts->node_id,
+		json::get<"origin"_>(event),
+		room.room_id.host(),
+	};
+
+	for(const auto &hint : hints)
+		if(ret.size() < max && proffer(hint))
+			ret.emplace(hint);
+
+	const m::room::origins origins
+	{
+		room
+	};
+
+	char buf[rfc3986::DOMAIN_BUFSIZE];
+	for(size_t i(0); ret.size() < max && i < max * 4; ++i)
+	{
+		const string_view server
+		{
+			origins.random(buf, proffer)
+		};
+
+		if(!server)
+			break;
+
+		ret.emplace(server);
+	}
+
+	return ret.size();
+}
+
 std::forward_list
 <
 	ircd::ctx::future<ircd::m::fetch::result>
@@ -638,6 +1187,10 @@ ircd::m::vm::fetch::prev_fetch(const event &event,
 		if(m::exists(prev_id))
 			continue;
 
+		// Being evaluated by another context; it's waited for by prev().
+		if(vm::eval::count(prev_id))
+			continue;
+
 		const long depth_gap
 		{
 			std::max(std::abs(at<"depth"_>(event) - room_depth), 1L)
@@ -10,10 +10,104 @@
 
 using namespace ircd;
 
+using directory_token_closure = std::function<void (const string_view &)>;
+using directory_result_closure = std::function<bool (const m::user::id &, const string_view &display_name)>;
+
+static void directory_tokens(const string_view &text, const directory_token_closure &);
+static void directory_tokens(const m::user::id &, const string_view &display_name, const directory_token_closure &);
+static void directory_set(const m::user::id &, const string_view &display_name);
+static bool directory_search(const string_view &term, const m::user::id &requester, const directory_result_closure &);
+static void directory_build();
+static void directory_fini();
+static void handle_profile(const m::event &, m::vm::eval &);
+static void handle_member(const m::event &, m::vm::eval &);
+static bool search_index(const m::user::id &requester, const string_view &term, json::stack::array &, const size_t &limit);
+static bool search_users(const string_view &term, json::stack::array &, const size_t &limit);
+static void search_result(json::stack::array &, const m::user::id &, const string_view &display_name);
+
 mapi::header
 IRCD_MODULE
 {
-	"Client 8.1 :User Directory"
+	"Client 8.1 :User Directory",
+	nullptr,
+	directory_fini,
+};
+
+static conf::item<bool>
+directory_enable
+{
+	{ "name",     "ircd.client.directory.user.index.enable" },
+	{ "default",  true                                      },
+	{ "description",
+
+	R"(
+	Hold an index of the display name and localpart tokens of every known
+	user in memory for the search; built in the background when the module
+	loads. Otherwise the search is over a range of user_id's only.
+	)"},
+};
+
+static conf::item<bool>
+directory_mitsein
+{
+	{ "name",     "ircd.client.directory.user.mitsein" },
+	{ "default",  false                                },
+	{ "description",
+
+	R"(
+	Only return users who share a room with the searching user.
+	)"},
+};
+
+static conf::item<size_t>
+directory_candidates
+{
+	{ "name",     "ircd.client.directory.user.candidates" },
+	{ "default",  1024L                                   },
+	{ "description",
+
+	R"(
+	Maximum number of users matching a search which are considered for the
+	result; the result is limited when this is reached.
+	)"},
+};
+
+/// Display name of every known user.
+static std::map<std::string, std::string, std::less<>>
+directory_names;
+
+/// Normalized (token, user_id) of the display name and localpart of every
+/// known user; a prefix of a token is a range of this set.
+static std::set<std::pair<std::string, std::string>>
+directory_index;
+
+static bool
+directory_ready;
+
+static context
+directory_context
+{
+	"m.directory.user", 512_KiB, context::POST, directory_build
+};
+
+static m::hookfn<m::vm::eval &>
+directory_profile_hook
+{
+	handle_profile,
+	{
+		{ "_site",  "vm.notify"     },
+		{ "type",   "ircd.profile"  },
+	}
+};
+
+static m::hookfn<m::vm::eval &>
+directory_member_hook
+{
+	handle_member,
+	{
+		{ "_site",  "vm.notify"      },
+		{ "type",   "m.room.member"  },
+	}
 };
 
 m::resource
@@ -39,6 +133,69 @@ post__search(client &client,
 		request.get<ushort>("limit", 16)
 	};
 
+	const unique_buffer<mutable_buffer> buf
+	{
+		16_KiB
+	};
+
+	json::stack out{buf};
+	json::stack::object top{out};
+	json::stack::array results
+	{
+		top, "results"
+	};
+
+	// Terms with a hostpart are still served by a range of user_id's.
+	const bool limited
+	{
+		directory_ready && !has(search_term, ':')?
+			search_index(request.user_id, search_term, results, limit):
+			search_users(search_term, results, limit)
+	};
+
+	results.~array();
+	json::stack::member
+	{
+		top, "limited", json::value{limited}
+	};
+
+	top.~object();
+	return m::resource::response
+	{
+		client, json::object
+		{
+			out.completed()
+		}
+	};
+}
+
+bool
+search_index(const m::user::id &requester,
+             const string_view &term,
+             json::stack::array &results,
+             const size_t &limit)
+{
+	size_t count(0);
+	bool limited{false};
+	const bool complete
+	{
+		directory_search(term, requester, [&results, &limit, &limited, &count]
+		(const m::user::id &user_id, const string_view &display_name)
+		{
+			search_result(results, user_id, display_name);
+			limited = ++count >= limit;
+			return !limited;
+		})
+	};
+
+	return limited || !complete;
+}
+
+bool
+search_users(const string_view &search_term,
+             json::stack::array &results,
+             const size_t &limit)
+{
 	// Search term in this endpoint comes in as-is from Riot. Our query
 	// is a lower_bound of a user_id, so we have to prefix the '@'.
 	char qbuf[256] {"@"};
@@ -51,85 +208,359 @@ post__search(client &client,
 			string_view{search_term}
 	};
 
-	const unique_buffer<mutable_buffer> buf
+	size_t count(0);
+	bool limited{false};
+	const m::users::opts opts{query};
+	m::users::for_each(opts, [&results, &limit, &limited, &count]
+	(const m::user::id &user_id)
 	{
-		16_KiB
+		char buf[256];
+		const m::user::profile profile
+		{
+			user_id
+		};
+
+		const json::string display_name
+		{
+			profile.get(buf, "displayname")
+		};
+
+		search_result(results, user_id, display_name);
+		limited = ++count >= limit;
+		return !limited;
+	});
+
+	return limited;
+}
+
+void
+search_result(json::stack::array &results,
+              const m::user::id &user_id,
+              const string_view &display_name)
+{
+	json::stack::object result
+	{
+		results
 	};
 
-	json::stack out{buf};
-	json::stack::object top{out};
+	json::stack::member
+	{
+		result, "user_id", user_id
+	};
 
-	size_t count(0);
-	bool limited{false};
-	json::stack::array results
+	const m::user::profile profile
 	{
-		top, "results"
+		user_id
 	};
 
-	const m::users::opts opts{query};
-	m::users::for_each(opts, [&results, &limit, &limited, &count]
-	(const m::user::id &user_id)
+	profile.get(std::nothrow, "avatar_url", [&result]
+	(const string_view &key, const string_view &val)
 	{
-		json::stack::object result
+		json::stack::member
 		{
-			results
+			result, key, val
 		};
+	});
 
+	// spec inconsistent
+	if(display_name)
 		json::stack::member
 		{
-			result, "user_id", user_id
+			result, "display_name", display_name
 		};
+}
 
-		const m::user::profile profile
+m::resource::method
+search_post
+{
+	search_resource, "POST", post__search,
+	{
+		search_post.REQUIRES_AUTH |
+		search_post.RATE_LIMITED |
+		search_post.SHEDDABLE
+	}
+};
+
+//
+// index
+//
+
+bool
+directory_search(const string_view &term,
+                 const m::user::id &requester,
+                 const directory_result_closure &closure)
+{
+	static const size_t terms_max {8};
+	std::string terms[terms_max];
+	size_t terms_count(0), seed(0);
+	directory_tokens(lstrip(term, '@'), [&terms, &terms_count, &seed]
+	(const string_view &token)
+	{
+		if(terms_count >= terms_max)
+			return;
+
+		terms[terms_count] = token;
+		if(size(token) > size(terms[seed]))
+			seed = terms_count;
+
+		++terms_count;
+	});
+
+	if(!terms_count)
+		return true;
+
+	const bool mitsein
+	{
+		directory_mitsein && requester
+	};
+
+	// The longest term selects the candidates; each candidate must then
+	// have a token beginning with every other term. The index is not held
+	// across the yields of the filter and the closure, so the candidates
+	// are copied out first.
+	const auto &prefix(terms[seed]);
+	const size_t candidates_max(directory_candidates);
+	std::vector<std::pair<std::string, std::string>> candidates;
+	std::set<string_view> seen;
+	auto it(directory_index.lower_bound({prefix, std::string{}}));
+	for(; it != end(directory_index) && startswith(it->first, prefix); ++it)
+	{
+		if(candidates.size() >= candidates_max)
+			break;
+
+		const auto &user_id(it->second);
+		if(!seen.emplace(user_id).second)
+			continue;
+
+		const auto name_it
 		{
-			user_id
+			directory_names.find(user_id)
 		};
 
-		profile.get(std::nothrow, "avatar_url", [&result]
-		(const string_view &key, const string_view &val)
+		if(unlikely(name_it == end(directory_names)))
+			continue;
+
+		const string_view display_name
 		{
-			json::stack::member
-			{
-				result, key, val
-			};
-		});
+			name_it->second
+		};
 
-		// spec inconsistent
-		profile.get(std::nothrow, "displayname", [&result]
-		(const string_view &key, const string_view &val)
+		size_t matched(1);
+		for(size_t i(0); i < terms_count; ++i)
 		{
-			json::stack::member
+			if(i == seed)
+				continue;
+
+			bool match{false};
+			directory_tokens(user_id, display_name, [&terms, &i, &match]
+			(const string_view &token)
 			{
-				result, "display_name", val
-			};
-		});
+				match |= startswith(token, terms[i]);
+			});
 
-		limited = ++count >= limit;
-		return !limited;
-	});
+			matched += match;
+		}
 
-	results.~array();
-	json::stack::member
+		if(matched < terms_count)
+			continue;
+
+		candidates.emplace_back(user_id, display_name);
+	}
+
+	for(const auto &[user_id, display_name] : candidates)
 	{
-		top, "limited", json::value{limited}
+		if(mitsein && !m::user::mitsein(requester).has(m::user::id(user_id)))
+			continue;
+
+		if(!closure(m::user::id{user_id}, display_name))
+			return false;
+	}
+
+	return candidates.size() < candidates_max;
+}
+
+void
+directory_set(const m::user::id &user_id,
+              const string_view &display_name)
+{
+	auto it
+	{
+		directory_names.find(user_id)
 	};
 
-	top.~object();
-	return m::resource::response
+	if(it != end(directory_names) && it->second == display_name)
+		return;
+
+	if(it != end(directory_names))
+		directory_tokens(user_id, it->second, [&user_id]
+		(const string_view &token)
+		{
+			directory_index.erase({std::string{token}, std::string{user_id}});
+		});
+	else
+		it = directory_names.emplace(std::string{user_id}, std::string{}).first;
+
+	it->second = display_name;
+	directory_tokens(user_id, display_name, [&user_id]
+	(const string_view &token)
 	{
-		client, json::object
+		directory_index.emplace(std::string{token}, std::string{user_id});
+	});
+}
+
+void
+directory_tokens(const m::user::id &user_id,
+                 const string_view &display_name,
+                 const directory_token_closure &closure)
+{
+	directory_tokens(display_name, closure);
+	directory_tokens(user_id.localname(), closure);
+}
+
+/// Tokens are the runs of alphanumerics (and of any non-ASCII, which is
+/// kept as-is) lowercased; everything else separates.
+void
+directory_tokens(const string_view &text,
+                 const directory_token_closure &closure)
+{
+	static const size_t token_max {64};
+	char buf[token_max];
+	size_t len(0);
+	for(size_t i(0); i <= size(text); ++i)
+	{
+		const uint8_t c
 		{
-			out.completed()
+			i < size(text)? uint8_t(text[i]): uint8_t(0)
+		};
+
+		if(c >= 0x80 || std::isalnum(c))
+		{
+			if(len < token_max)
+				buf[len++] = std::tolower(c);
+
+			continue;
 		}
+
+		if(len)
+			closure(string_view{buf, len});
+
+		len = 0;
+	}
+}
+
+void
+handle_profile(const m::event &event,
+               m::vm::eval &eval)
+{
+	if(json::get<"state_key"_>(event) != "displayname")
+		return;
+
+	const m::user::id &user_id
+	{
+		json::get<"sender"_>(event)
+	};
+
+	if(!my(user_id))
+		return;
+
+	const m::user::room user_room
+	{
+		user_id
+	};
+
+	if(json::get<"room_id"_>(event) != user_room.room_id)
+		return;
+
+	const json::string display_name
+	{
+		json::get<"content"_>(event).get("text")
 	};
+
+	directory_set(user_id, display_name);
 }
 
-m::resource::method
-search_post
+void
+handle_member(const m::event &event,
+              m::vm::eval &eval)
 {
-	search_resource, "POST", post__search,
+	if(!valid(m::id::USER, json::get<"state_key"_>(event)))
+		return;
+
+	// Our own users are indexed by their profile.
+	const m::user::id &user_id
 	{
-		search_post.REQUIRES_AUTH |
-		search_post.RATE_LIMITED
-	}
-};
+		json::get<"state_key"_>(event)
+	};
+
+	if(my(user_id))
+		return;
+
+	if(m::membership(event) != "join")
+		return;
+
+	const json::string display_name
+	{
+		json::get<"content"_>(event).get("displayname")
+	};
+
+	directory_set(user_id, display_name);
+}
+
+void
+directory_build()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	if(!directory_enable)
+		return;
+
+	size_t count(0);
+	m::users::for_each(m::users::opts{}, [&count]
+	(const m::user::id &user_id)
+	{
+		ctx::interruption_point();
+
+		// Remote users without a display name here are found by localpart
+		// until their next membership.
+		char buf[256];
+		const json::string display_name
+		{
+			my(user_id)?
+				m::user::profile(user_id).get(buf, "displayname"):
+				string_view{}
+		};
+
+		if(!directory_names.count(user_id))
+			directory_set(user_id, display_name);
+
+		++count;
+		return true;
+	});
+
+	directory_ready = true;
+	log::info
+	{
+		m::log, "User directory indexed %zu users with %zu tokens.",
+		count,
+		directory_index.size(),
+	};
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "User directory index :%s",
+		e.what(),
+	};
+}
+
+void
+directory_fini()
+{
+	directory_context.terminate();
+	directory_context.join();
+}
@@ -94,7 +94,24 @@ get__keys_changes(client &client,
 			response, "changed"
 		};
 
-		m::events::type::for_each_in("ircd.device.keys", [&from, &to, &out, &mitsein]
+		if(m::user::devices::changes_complete(from))
+		{
+			std::set<std::string, std::less<>> users;
+			m::user::devices::for_each_change(from, [&to, &users]
+			(const auto &event_idx, const auto &user_id)
+			{
+				if(event_idx >= to)
+					return false;
+
+				users.emplace(user_id);
+				return true;
+			});
+
+			for(const auto &user_id : users)
+				if(mitsein.has(m::user::id(user_id)))
+					out.append(string_view{user_id});
+		}
+		else m::events::type::for_each_in("ircd.device.keys", [&from, &to, &out, &mitsein]
 		(const string_view &type, const m::event::idx &event_idx)
 		{
 			if(event_idx < from || event_idx >= to)
@@ -117,7 +134,7 @@ get__keys_changes(client &client,
 					if(!mitsein.has(user_id))
 						return;
 
-					out.append(user_id);
+					out.append(string_view{user_id});
 				});
 			});
 
@@ -22,6 +22,13 @@ namespace
 static host_users_map
 parse_user_request(const json::object &device_keys);
 
+static user_devices_map
+split_local(host_users_map &);
+
+static void
+claim_local(const user_devices_map &,
+            json::stack::object &);
+
 static bool
 send_request(const string_view &,
              const user_devices_map &,
@@ -42,7 +49,8 @@ recv_response(const string_view &,
               const system_point &);
 
 static void
-recv_responses(query_map &,
+recv_responses(const user_devices_map &,
+               query_map &,
                failure_map &,
                json::stack::object &,
                const milliseconds &);
@@ -143,11 +151,16 @@ post__keys_claim(client &client,
 		request.at("one_time_keys")
 	};
 
-	const host_users_map map
+	host_users_map map
 	{
 		parse_user_request(one_time_keys)
 	};
 
+	const user_devices_map local
+	{
+		split_local(map)
+	};
+
 	buffer_list buffers;
 	failure_map failures;
 	query_map queries
@@ -170,7 +183,7 @@ post__keys_claim(client &client,
 		out
 	};
 
-	recv_responses(queries, failures, top, timeout);
+	recv_responses(local, queries, failures, top, timeout);
 	handle_failures(failures, top);
 	return {};
 }
@@ -192,7 +205,8 @@ handle_failures(const failure_map &failures,
 }
 
 void
-recv_responses(query_map &queries,
+recv_responses(const user_devices_map &local,
+               query_map &queries,
                failure_map &failures,
                json::stack::object &out,
                const milliseconds &timeout)
@@ -207,6 +221,8 @@ recv_responses(query_map &queries,
 		out, "one_time_keys"
 	};
 
+	claim_local(local, one_time_keys);
+
 	for(auto &[remote, request] : queries)
 	{
 		assert(!failures.count(remote));
@@ -322,6 +338,66 @@ catch(const std::exception &e)
 	return false;
 }
 
+/// Our own users' keys are popped from the column here rather than by a
+/// federation request to ourselves.
+void
+claim_local(const user_devices_map &local,
+            json::stack::object &out)
+{
+	for(const auto &[user_id, devices] : local)
+	{
+		json::stack::object response_user
+		{
+			out, user_id
+		};
+
+		for(const auto &[device_id, algorithm] : devices)
+		{
+			json::stack::object response_device
+			{
+				response_user, device_id
+			};
+
+			m::dbs::device_one_time_key_pop(user_id, device_id, json::string(algorithm), [&response_device]
+			(const string_view &algorithm, const string_view &name, const string_view &key)
+			{
+				char buf[256];
+				const string_view ident{fmt::sprintf
+				{
+					buf, "%s:%s", algorithm, name
+				}};
+
+				json::stack::member
+				{
+					response_device, ident, json::value
+					{
+						key
+					}
+				};
+			});
+		}
+	}
+}
+
+user_devices_map
+split_local(host_users_map &map)
+{
+	user_devices_map ret;
+	for(auto it(begin(map)); it != end(map); )
+	{
+		if(!m::my_host(it->first))
+		{
+			++it;
+			continue;
+		}
+
+		ret.merge(it->second);
+		it = map.erase(it);
+	}
+
+	return ret;
+}
+
 host_users_map
 parse_user_request(const json::object &one_time_keys)
 {
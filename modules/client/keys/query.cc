@@ -15,6 +15,7 @@ namespace
 	using user_devices_map = std::map<m::user::id, json::array>;
 	using host_users_map = std::map<string_view, user_devices_map>;
 	using query_map = std::map<string_view, m::fed::user::keys::query>;
+	using resync_map = std::map<m::user::id, m::fed::user::devices>;
 	using failure_map = std::map<string_view, std::exception_ptr, std::less<>>;
 	using buffer_list = std::vector<unique_buffer<mutable_buffer>>;
 }
@@ -22,6 +23,10 @@ namespace
 static host_users_map
 parse_user_request(const json::object &device_keys);
 
+static user_devices_map
+split_local(host_users_map &,
+            user_devices_map &);
+
 static bool
 send_request(const string_view &,
              const user_devices_map &,
@@ -34,19 +39,40 @@ send_requests(const host_users_map &,
               buffer_list &,
               failure_map &);
 
+static resync_map
+send_resyncs(const user_devices_map &,
+             buffer_list &,
+             failure_map &);
+
 static void
-recv_response(const m::resource::request &,
-              const string_view &,
-              m::fed::user::keys::query &,
-              failure_map &,
-              json::stack::object &);
+recv_resyncs(resync_map &,
+             const user_devices_map &,
+             user_devices_map &,
+             failure_map &,
+             const system_point &);
 
 static void
-recv_responses(const m::resource::request &,
-               query_map &,
+recv_responses(query_map &,
                failure_map &,
-               json::stack::object &,
-               const milliseconds &);
+               const system_point &);
+
+static void
+append_local_device(const m::user::devices &,
+                    const string_view &device_id,
+                    json::stack::object &);
+
+static void
+append_device_keys(const user_devices_map &,
+                   const query_map &,
+                   json::stack::object &);
+
+static void
+append_signing_keys(const m::resource::request &,
+                    const user_devices_map &,
+                    const query_map &,
+                    const string_view &name,
+                    const string_view &type,
+                    json::stack::object &);
 
 static void
 handle_failures(const failure_map &,
@@ -126,6 +152,20 @@ query_limit
 	{ "default",  4096L                          },
 };
 
+/// Remote users whose device lists are fetched to be cached by one query;
+/// any more untracked users are queried from their servers without caching.
+conf::item<size_t>
+query_resync_max
+{
+	{ "name",     "ircd.client.keys.query.resync.max" },
+	{ "default",  32L                                 },
+};
+
+/// Users whose device lists are held locally are answered from the user
+/// rooms: our own users, and remote users whose lists are tracked by the
+/// m.device_list_update EDUs of their servers. A remote user who isn't is
+/// fetched with federation /user/devices to begin tracking; only the users
+/// beyond resync.max go to the remote's /user/keys/query uncached.
 m::resource::response
 post__keys_query(client &client,
                  const m::resource::request &request)
@@ -139,14 +179,9 @@ post__keys_query(client &client,
 		std::clamp(request.get("timeout", timeout_default), timeout_min, timeout_max)
 	};
 
-	const json::string token
-	{
-		request["token"]
-	};
-
-	const m::event::idx since
+	const system_point timedout
 	{
-		m::sync::sequence(m::sync::make_since(token))
+		ircd::now<system_point>() + timeout
 	};
 
 	const json::object &request_keys
@@ -154,18 +189,32 @@ post__keys_query(client &client,
 		request.at("device_keys")
 	};
 
-	const host_users_map map
+	host_users_map map
 	{
 		parse_user_request(request_keys)
 	};
 
+	user_devices_map local;
+	const user_devices_map resyncs
+	{
+		split_local(map, local)
+	};
+
 	buffer_list buffers;
 	failure_map failures;
+	resync_map resyncing
+	{
+		send_resyncs(resyncs, buffers, failures)
+	};
+
 	query_map queries
 	{
 		send_requests(map, buffers, failures)
 	};
 
+	recv_resyncs(resyncing, resyncs, local, failures, timedout);
+	recv_responses(queries, failures, timedout);
+
 	m::resource::response::chunked response
 	{
 		client, http::OK
@@ -181,7 +230,10 @@ post__keys_query(client &client,
 		out
 	};
 
-	recv_responses(request, queries, failures, top, timeout);
+	append_device_keys(local, queries, top);
+	append_signing_keys(request, local, queries, "master_keys", "ircd.device.signing.master", top);
+	append_signing_keys(request, local, queries, "self_signing_keys", "ircd.device.signing.self", top);
+	append_signing_keys(request, local, queries, "user_signing_keys", "ircd.device.signing.user", top);
 	handle_failures(failures, top);
 	return {};
 }
@@ -207,177 +259,295 @@ handle_failures(const failure_map &failures,
 }
 
 void
-recv_responses(const m::resource::request &client_request,
-               query_map &queries,
-               failure_map &failures,
-               json::stack::object &out,
-               const milliseconds &timeout)
-try
+append_signing_keys(const m::resource::request &client_request,
+                    const user_devices_map &local,
+                    const query_map &queries,
+                    const string_view &name,
+                    const string_view &type,
+                    json::stack::object &out)
 {
-	const system_point timedout
+	// The user-signing key is only for its own user.
+	const bool own_only
 	{
-		ircd::now<system_point>() + timeout
+		name == "user_signing_keys"
 	};
 
-	json::stack::object response_keys
+	json::stack::object object
 	{
-		out, "device_keys"
+		out, name
 	};
 
-	while(!queries.empty())
+	for(const auto &[user_id, device_ids] : local)
 	{
-		static const auto dereferencer{[]
-		(auto &it) -> m::fed::user::keys::query &
-		{
-			return it->second;
-		}};
+		if(own_only && client_request.user_id != user_id)
+			continue;
 
-		auto next
+		const m::user::room room
 		{
-			ctx::when_any(begin(queries), end(queries), dereferencer)
+			user_id
 		};
 
-		next.wait_until(timedout); // throws on timeout
-		const auto it{next.get()};
-		const unwind remove{[&queries, &it]
+		m::get(std::nothrow, room.get(std::nothrow, type, ""), "content", [&object, &user_id]
+		(const json::object &content)
 		{
-			queries.erase(it);
-		}};
+			json::stack::member
+			{
+				object, user_id, content
+			};
+		});
+	}
 
-		const auto &remote(it->first);
-		auto &request(it->second);
+	for(const auto &[remote, request] : queries)
+	{
+		const json::object response
+		{
+			request
+		};
 
-		assert(!failures.count(remote));
-		if(failures.count(remote))
-			continue;
+		const json::object &keys
+		{
+			response[name]
+		};
 
-		recv_response(client_request, remote, request, failures, response_keys);
+		for(const auto &[user_id, key] : keys)
+		{
+			if(own_only && client_request.user_id != user_id)
+				continue;
+
+			json::stack::member
+			{
+				object, user_id, json::object
+				{
+					key
+				}
+			};
+		}
 	}
 }
-catch(const std::exception &)
-{
-	for(const auto &[remote, request] : queries)
-		failures.emplace(remote, std::current_exception());
-}
 
 void
-recv_response(const m::resource::request &client_request,
-              const string_view &remote,
-              m::fed::user::keys::query &request,
-              failure_map &failures,
-              json::stack::object &object)
-try
+append_device_keys(const user_devices_map &local,
+                   const query_map &queries,
+                   json::stack::object &out)
 {
-	const auto code
-	{
-		request.get()
-	};
-
-	const json::object response
-	{
-		request
-	};
-
-	const json::object &device_keys
+	json::stack::object response_keys
 	{
-		response["device_keys"]
+		out, "device_keys"
 	};
 
-	for(const auto &[_user_id, device_keys] : device_keys)
+	for(const auto &[user_id, device_ids] : local)
 	{
-		const m::user::id &user_id
+		const m::user::devices devices
 		{
-			_user_id
+			user_id
 		};
 
 		json::stack::object user_object
 		{
-			object, user_id
+			response_keys, user_id
 		};
 
-		for(const auto &[device_id, keys] : json::object(device_keys))
-			json::stack::member
+		if(empty(device_ids))
+			devices.for_each([&devices, &user_object]
+			(const auto &, const string_view &device_id)
 			{
-				user_object, device_id, keys
-			};
+				append_local_device(devices, device_id, user_object);
+				return true;
+			});
+		else
+			for(const json::string device_id : device_ids)
+				append_local_device(devices, device_id, user_object);
 	}
 
-	const json::object &master_keys
+	for(const auto &[remote, request] : queries)
 	{
-		response["master_keys"]
-	};
+		const json::object response
+		{
+			request
+		};
 
-	for(const auto &[_user_id, master_key] : master_keys)
-	{
-		const m::user::id &user_id
+		const json::object &device_keys
 		{
-			_user_id
+			response["device_keys"]
 		};
 
-		json::stack::member
+		for(const auto &[_user_id, device_keys] : device_keys)
 		{
-			object, user_id, json::object
+			const m::user::id &user_id
 			{
-				master_key
-			}
-		};
+				_user_id
+			};
+
+			// Answers are only taken for users of that server.
+			if(user_id.host() != remote)
+				continue;
+
+			json::stack::object user_object
+			{
+				response_keys, user_id
+			};
+
+			for(const auto &[device_id, keys] : json::object(device_keys))
+				json::stack::member
+				{
+					user_object, device_id, keys
+				};
+		}
 	}
+}
+
+void
+append_local_device(const m::user::devices &devices,
+                    const string_view &device_id,
+                    json::stack::object &out)
+{
+	if(!devices.has(device_id, "keys"))
+		return;
 
-	const json::object &self_signing_keys
+	json::stack::object object
 	{
-		response["self_signing_keys"]
+		out, device_id
 	};
 
-	for(const auto &[_user_id, self_signing_key] : self_signing_keys)
+	devices.get(std::nothrow, device_id, "keys", [&object]
+	(const auto &event_idx, const json::object &device_keys)
+	{
+		for(const auto &member : device_keys)
+			json::stack::member
+			{
+				object, member.first, member.second
+			};
+	});
+
+	// Our own devices are named by display_name; those of remote users are
+	// cached by the name in the device list update.
+	const auto display_name{[&object]
+	(const auto &event_idx, const string_view &display_name)
 	{
-		const m::user::id &user_id
+		json::stack::object non_hancock
 		{
-			_user_id
+			object, "unsigned"
 		};
 
 		json::stack::member
 		{
-			object, user_id, json::object
-			{
-				self_signing_key
-			}
+			non_hancock, "device_display_name", display_name
 		};
-	}
+	}};
 
-	const json::object &user_signing_keys
+	if(!devices.get(std::nothrow, device_id, "display_name", display_name))
+		devices.get(std::nothrow, device_id, "device_display_name", display_name);
+}
+
+void
+recv_responses(query_map &queries,
+               failure_map &failures,
+               const system_point &timedout)
+{
+	for(auto it(begin(queries)); it != end(queries); ) try
 	{
-		response["user_signing_keys"]
-	};
+		auto &request(it->second);
+		request.wait_until(timedout); // throws on timeout
+		request.get();
+		++it;
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			m::log, "user keys query from %s :%s",
+			it->first,
+			e.what()
+		};
 
-	for(const auto &[_user_id, user_signing_key] : user_signing_keys)
+		failures.emplace(it->first, std::current_exception());
+		it = queries.erase(it);
+	}
+}
+
+void
+recv_resyncs(resync_map &resyncing,
+             const user_devices_map &resyncs,
+             user_devices_map &local,
+             failure_map &failures,
+             const system_point &timedout)
+{
+	for(auto &[user_id, request] : resyncing) try
 	{
-		const m::user::id &user_id
+		request.wait_until(timedout); // throws on timeout
+		request.get();
+
+		const json::object response
 		{
-			_user_id
+			request
 		};
 
-		if(client_request.user_id != _user_id)
+		if(json::string(response["user_id"]) != user_id)
 			continue;
 
-		json::stack::member
+		if(m::user::devices::resync(response))
+			local.emplace(user_id, resyncs.at(user_id));
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
 		{
-			object, user_id, json::object
-			{
-				user_signing_key
-			}
+			m::log, "user devices for %s from %s :%s",
+			string_view{user_id},
+			user_id.host(),
+			e.what()
 		};
+
+		failures.emplace(user_id.host(), std::current_exception());
 	}
+
+	resyncing.clear();
 }
-catch(const std::exception &e)
+
+resync_map
+send_resyncs(const user_devices_map &users,
+             buffer_list &buffers,
+             failure_map &failures)
 {
-	log::error
+	resync_map ret;
+	for(const auto &[user_id, device_ids] : users) try
 	{
-		m::log, "user keys query from %s :%s",
-		remote,
-		e.what()
-	};
+		const auto &buffer
+		{
+			buffers.emplace_back(8_KiB)
+		};
 
-	failures.emplace(remote, std::current_exception());
+		m::fed::user::opts opts;
+		opts.remote = user_id.host();
+		ret.emplace
+		(
+			std::piecewise_construct,
+			std::forward_as_tuple(user_id),
+			std::forward_as_tuple(user_id, buffer, std::move(opts))
+		);
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			m::log, "user devices for %s to %s :%s",
+			string_view{user_id},
+			user_id.host(),
+			e.what()
+		};
+
+		failures.emplace(user_id.host(), std::current_exception());
+	}
+
+	return ret;
 }
 
 query_map
@@ -445,6 +615,46 @@ catch(const std::exception &e)
 	return false;
 }
 
+/// Moves the users answered from local state out of the map into local;
+/// returns the remote users to resync, who are also removed from the map.
+user_devices_map
+split_local(host_users_map &map,
+            user_devices_map &local)
+{
+	user_devices_map ret;
+	for(auto hit(begin(map)); hit != end(map); )
+	{
+		const bool my_host
+		{
+			m::my_host(hit->first)
+		};
+
+		auto &users(hit->second);
+		for(auto it(begin(users)); it != end(users); )
+		{
+			const auto &[user_id, device_ids] {*it};
+			if(my_host || m::user::devices::tracked(user_id))
+				local.emplace(user_id, device_ids);
+			else if(ret.size() < size_t(query_resync_max) && m::exists(user_id))
+				ret.emplace(user_id, device_ids);
+			else
+			{
+				++it;
+				continue;
+			}
+
+			it = users.erase(it);
+		}
+
+		if(users.empty())
+			hit = map.erase(hit);
+		else
+			++hit;
+	}
+
+	return ret;
+}
+
 host_users_map
 parse_user_request(const json::object &device_keys)
 {
@@ -140,9 +140,9 @@ upload_one_time_keys(client &client,
                      const m::device::id &device_id,
                      const json::object &one_time_keys)
 {
-	const m::user::devices devices
+	db::txn txn
 	{
-		request.user_id
+		*m::dbs::events
 	};
 
 	for(const auto &[ident, object] : one_time_keys)
@@ -155,29 +155,22 @@ upload_one_time_keys(client &client,
 		if(empty(algorithm) || empty(name))
 			continue;
 
-		char state_key_buf[128]
-		{
-			"one_time_key|"
-		};
-
-		const string_view state_key
+		const auto put
 		{
-			ircd::strlcat(state_key_buf, ident)
-		};
-
-		const auto set
-		{
-			devices.set(device_id, state_key, object)
+			m::dbs::device_one_time_key_put(txn, request.user_id, device_id, algorithm, name, object)
 		};
 
 		log::debug
 		{
-			m::log, "Received one_time_key:%s for %s on %s",
+			m::log, "Received one_time_key:%s for %s on %s%s",
 			ident,
 			string_view{device_id},
 			string_view{request.user_id},
+			put? string_view{}: " (duplicate)"_sv,
 		};
 	}
+
+	txn();
 }
 
 void
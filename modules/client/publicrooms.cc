@@ -10,10 +10,94 @@
 
 using namespace ircd;
 
+struct directory_room;
+
+static void directory_set(const string_view &state_key, const json::object &summary);
+static void directory_set(const m::room::id &);
+static void directory_del(const string_view &state_key);
+static size_t directory_select(const string_view &server, const string_view &search_term, const size_t &offset, const size_t &limit, std::vector<std::string> &);
+static void directory_build();
+static void directory_fini();
+static void handle_summary(const m::event &, m::vm::eval &);
+static void handle_redaction(const m::event &, m::vm::eval &);
+static void handle_state(const m::event &, m::vm::eval &);
+
 mapi::header
 IRCD_MODULE
 {
-	"Client 7.5 :Public Rooms"
+	"Client 7.5 :Public Rooms",
+	nullptr,
+	directory_fini,
+};
+
+/// Published room held in memory by the directory; the key of the map is
+/// the state_key of its ircd.rooms.summary (room_id!origin).
+struct directory_room
+{
+	/// Lowercased name, topic and aliases for the search.
+	std::string search;
+
+	/// Position in the directory_order set.
+	long members {0};
+};
+
+conf::item<bool>
+directory_enable
+{
+	{ "name",     "ircd.client.publicrooms.index.enable" },
+	{ "default",  true                                   },
+	{ "description",
+
+	R"(
+	Hold the published rooms in memory sorted by the count of joined
+	members; built in the background when the module loads. Otherwise each
+	request walks the summaries in the public rooms room.
+	)"},
+};
+
+static std::map<std::string, directory_room, std::less<>>
+directory_rooms;
+
+/// (-members, state_key) so iteration is by descending members.
+static std::set<std::pair<long, std::string>>
+directory_order;
+
+static bool
+directory_ready;
+
+static context
+directory_context
+{
+	"m.publicrooms", 512_KiB, context::POST, directory_build
+};
+
+static m::hookfn<m::vm::eval &>
+directory_summary_hook
+{
+	handle_summary,
+	{
+		{ "_site",  "vm.notify"           },
+		{ "type",   "ircd.rooms.summary"  },
+	}
+};
+
+static m::hookfn<m::vm::eval &>
+directory_redaction_hook
+{
+	handle_redaction,
+	{
+		{ "_site",  "vm.notify"        },
+		{ "type",   "m.room.redaction" },
+	}
+};
+
+static m::hookfn<m::vm::eval &>
+directory_state_hook
+{
+	handle_state,
+	{
+		{ "_site",  "vm.notify"  },
+	}
 };
 
 resource
@@ -39,13 +123,19 @@ get__publicrooms(client &,
 resource::method
 post_method
 {
-	publicrooms_resource, "POST", get__publicrooms
+	publicrooms_resource, "POST", get__publicrooms,
+	{
+		post_method.SHEDDABLE
+	}
 };
 
 resource::method
 get_method
 {
-	publicrooms_resource, "GET", get__publicrooms
+	publicrooms_resource, "GET", get__publicrooms,
+	{
+		get_method.SHEDDABLE
+	}
 };
 
 resource::response
@@ -60,7 +150,14 @@ get__publicrooms(client &client,
 			url::decode(since_buf, request.query["since"])
 	};
 
-	if(since && !valid(m::id::ROOM, since))
+	// The index paginates by ordinal offset; a room_id is the token of the
+	// summaries walk.
+	const bool since_offset
+	{
+		since && lex_castable<size_t>(since)
+	};
+
+	if(since && !since_offset && !valid(m::id::ROOM, since))
 		throw m::BAD_REQUEST
 		{
 			"Invalid since token for this server."
@@ -162,10 +259,71 @@ get__publicrooms(client &client,
 		since,
 	};
 
+	const bool indexed
+	{
+		directory_ready
+		&& !opts.user_id
+		&& !opts.room_alias
+		&& (!since || since_offset)
+	};
+
+	json::stack::object top{out};
+	if(indexed)
+	{
+		const size_t offset
+		{
+			since? lex_cast<size_t>(since): 0UL
+		};
+
+		std::vector<std::string> rooms;
+		const size_t total
+		{
+			directory_select(opts.server, search_term, offset, limit, rooms)
+		};
+
+		{
+			json::stack::array chunk
+			{
+				top, "chunk"
+			};
+
+			for(const auto &room_id : rooms)
+			{
+				json::stack::object obj
+				{
+					chunk
+				};
+
+				m::rooms::summary::get(obj, m::room::id{room_id});
+			}
+		}
+
+		json::stack::member
+		{
+			top, "total_room_count_estimate", json::value
+			{
+				long(total)
+			}
+		};
+
+		if(offset)
+			json::stack::member
+			{
+				top, "prev_batch", lex_cast(offset - std::min(offset, limit))
+			};
+
+		if(offset + rooms.size() < total)
+			json::stack::member
+			{
+				top, "next_batch", lex_cast(offset + rooms.size())
+			};
+
+		return std::move(response);
+	}
+
 	size_t count{0};
 	m::room::id::buf prev_batch_buf; //TODO: XXX
 	m::room::id::buf next_batch_buf;
-	json::stack::object top{out};
 	{
 		json::stack::array chunk
 		{
@@ -221,3 +379,288 @@ get__publicrooms(client &client,
 
 	return std::move(response);
 }
+
+//
+// index
+//
+
+size_t
+directory_select(const string_view &server,
+                 const string_view &search_term,
+                 const size_t &offset,
+                 const size_t &limit,
+                 std::vector<std::string> &rooms)
+{
+	char term_buf[256];
+	const string_view term
+	{
+		tolower(term_buf, search_term)
+	};
+
+	// The rooms are copied out; the index is not held across the yields of
+	// the caller's summaries.
+	size_t total(0);
+	for(const auto &[order, state_key] : directory_order)
+	{
+		const auto &[room_id, origin]
+		{
+			m::rooms::summary::unmake_state_key(state_key)
+		};
+
+		if(server && origin != server)
+			continue;
+
+		const auto it
+		{
+			directory_rooms.find(state_key)
+		};
+
+		assert(it != end(directory_rooms));
+		if(term && !has(it->second.search, term))
+			continue;
+
+		if(total++ < offset)
+			continue;
+
+		if(rooms.size() < limit)
+			rooms.emplace_back(room_id);
+	}
+
+	return total;
+}
+
+void
+directory_set(const string_view &state_key,
+              const json::object &summary)
+{
+	const long members
+	{
+		summary.get<long>("num_joined_members", 0L)
+	};
+
+	thread_local char buf[2_KiB];
+	mutable_buffer search{buf};
+	const auto append{[&search]
+	(const string_view &value)
+	{
+		consume(search, size(tolower(search, value)));
+		consume(search, copy(search, "\n"_sv));
+	}};
+
+	append(json::string(summary["name"]));
+	append(json::string(summary["canonical_alias"]));
+	for(const json::string alias : json::array(summary["aliases"]))
+		append(alias);
+
+	append(json::string(summary["topic"]));
+
+	auto it
+	{
+		directory_rooms.find(state_key)
+	};
+
+	if(it != end(directory_rooms))
+		directory_order.erase({-it->second.members, std::string{state_key}});
+	else
+		it = directory_rooms.emplace(std::string{state_key}, directory_room{}).first;
+
+	it->second.members = members;
+	it->second.search = string_view{buf, data(search)};
+	directory_order.emplace(-members, std::string{state_key});
+}
+
+/// Summarizes one of our published rooms again after a change to its state.
+void
+directory_set(const m::room::id &room_id)
+{
+	char state_key_buf[m::event::STATE_KEY_MAX_SIZE];
+	const string_view state_key
+	{
+		m::rooms::summary::make_state_key(state_key_buf, room_id, my_host())
+	};
+
+	if(!directory_rooms.count(state_key))
+		return;
+
+	const unique_mutable_buffer buf
+	{
+		48_KiB
+	};
+
+	const json::object summary
+	{
+		m::rooms::summary::get(buf, room_id)
+	};
+
+	directory_set(state_key, summary);
+}
+
+void
+directory_del(const string_view &state_key)
+{
+	const auto it
+	{
+		directory_rooms.find(state_key)
+	};
+
+	if(it == end(directory_rooms))
+		return;
+
+	directory_order.erase({-it->second.members, std::string{state_key}});
+	directory_rooms.erase(it);
+}
+
+void
+handle_summary(const m::event &event,
+               m::vm::eval &eval)
+{
+	const m::room::id::buf public_room_id
+	{
+		"public", my_host()
+	};
+
+	if(json::get<"room_id"_>(event) != public_room_id)
+		return;
+
+	directory_set(json::get<"state_key"_>(event), json::get<"content"_>(event));
+}
+
+/// Summaries are delisted by their redaction.
+void
+handle_redaction(const m::event &event,
+                 m::vm::eval &eval)
+{
+	const m::room::id::buf public_room_id
+	{
+		"public", my_host()
+	};
+
+	if(json::get<"room_id"_>(event) != public_room_id)
+		return;
+
+	if(!valid(m::id::EVENT, json::get<"redacts"_>(event)))
+		return;
+
+	const auto event_idx
+	{
+		m::index(std::nothrow, m::event::id(json::get<"redacts"_>(event)))
+	};
+
+	m::get(std::nothrow, event_idx, "state_key", []
+	(const string_view &state_key)
+	{
+		directory_del(state_key);
+	});
+}
+
+void
+handle_state(const m::event &event,
+             m::vm::eval &eval)
+{
+	if(!defined(json::get<"state_key"_>(event)))
+		return;
+
+	const string_view &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	const bool summarized
+	{
+		type == "m.room.member"
+		|| type == "m.room.name"
+		|| type == "m.room.topic"
+		|| type == "m.room.canonical_alias"
+		|| type == "m.room.aliases"
+	};
+
+	if(!summarized || !directory_ready)
+		return;
+
+	directory_set(m::room::id(json::get<"room_id"_>(event)));
+}
+
+void
+directory_build()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	if(!directory_enable)
+		return;
+
+	const m::room::id::buf public_room_id
+	{
+		"public", my_host()
+	};
+
+	const m::room::state state
+	{
+		public_room_id
+	};
+
+	// Keys are collected first; summarizing the local rooms yields.
+	std::vector<std::string> keys;
+	state.for_each("ircd.rooms.summary", [&keys]
+	(const string_view &type, const string_view &state_key, const m::event::idx &event_idx)
+	{
+		keys.emplace_back(state_key);
+		return true;
+	});
+
+	for(const auto &state_key : keys)
+	{
+		ctx::interruption_point();
+		const auto &[room_id, origin]
+		{
+			m::rooms::summary::unmake_state_key(state_key)
+		};
+
+		if(my_host(origin) && exists(m::room(room_id)))
+		{
+			const unique_mutable_buffer buf
+			{
+				48_KiB
+			};
+
+			directory_set(state_key, m::rooms::summary::get(buf, room_id));
+			continue;
+		}
+
+		const auto event_idx
+		{
+			state.get(std::nothrow, "ircd.rooms.summary", state_key)
+		};
+
+		m::get(std::nothrow, event_idx, "content", [&state_key]
+		(const json::object &summary)
+		{
+			directory_set(state_key, summary);
+		});
+	}
+
+	directory_ready = true;
+	log::info
+	{
+		m::log, "Public rooms directory indexed %zu rooms.",
+		directory_rooms.size(),
+	};
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "Public rooms directory index :%s",
+		e.what(),
+	};
+}
+
+void
+directory_fini()
+{
+	directory_context.terminate();
+	directory_context.join();
+}
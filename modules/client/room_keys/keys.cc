@@ -10,16 +10,19 @@
 
 namespace ircd::m
 {
+	static event::idx room_keys_version_current(const user::id &);
+
 	static resource::response get_room_keys_keys(client &, const resource::request &);
 	extern resource::method room_keys_keys_get;
 
-	static event::id::buf put_room_keys_keys_key(client &, const resource::request &, const room::id &, const string_view &, const event::idx &, const json::object &);
+	static bool put_room_keys_keys_key(db::txn &, size_t &, const resource::request &, const room::id &, const string_view &, const event::idx &, const json::object &);
 	static resource::response put_room_keys_keys(client &, const resource::request &);
 	extern resource::method room_keys_keys_put;
 
 	static resource::response delete_room_keys_keys(client &, const resource::request &);
 	extern resource::method room_keys_keys_delete;
 
+	extern conf::item<size_t> room_keys_keys_txn_sessions;
 	extern resource room_keys_keys;
 }
 
@@ -39,6 +42,15 @@ ircd::m::room_keys_keys
 	}
 };
 
+/// Sessions written by one transaction of an upload; a large upload is
+/// committed in pieces, yielding to others between them.
+decltype(ircd::m::room_keys_keys_txn_sessions)
+ircd::m::room_keys_keys_txn_sessions
+{
+	{ "name",     "ircd.client.room_keys.keys.txn.sessions" },
+	{ "default",  1024L                                     },
+};
+
 //
 // DELETE
 //
@@ -56,10 +68,31 @@ ircd::m::resource::response
 ircd::m::delete_room_keys_keys(client &client,
                                const resource::request &request)
 {
+	char room_id_buf[room::id::buf::SIZE];
+	const string_view &room_id
+	{
+		request.parv.size() > 0?
+			url::decode(room_id_buf, request.parv[0]):
+			string_view{}
+	};
 
+	char session_id_buf[256];
+	const string_view &session_id
+	{
+		request.parv.size() > 1?
+			url::decode(session_id_buf, request.parv[1]):
+			string_view{}
+	};
+
+	const event::idx version
+	{
+		request.query.at<event::idx>("version")
+	};
+
+	dbs::user_room_keys_del(request.user_id, version, room_id, session_id);
 	return resource::response
 	{
-		client, http::NOT_IMPLEMENTED
+		client, json::object{}
 	};
 }
 
@@ -76,13 +109,15 @@ ircd::m::room_keys_keys_put
 		room_keys_keys_put.REQUIRES_AUTH,
 
 		// timeout //TODO: XXX designated
-		30s,
+		60s,
 
 		// Payload maximum
-		1_MiB,
+		64_MiB,
 	}
 };
 
+/// The sessions are read from the content in place and written to the
+/// txn, which is committed whenever it holds txn.sessions of them.
 ircd::m::resource::response
 ircd::m::put_room_keys_keys(client &client,
                             const resource::request &request)
@@ -108,6 +143,20 @@ ircd::m::put_room_keys_keys(client &client,
 		request.query.at<event::idx>("version")
 	};
 
+	if(version != room_keys_version_current(request.user_id))
+		throw http::error
+		{
+			"%lu is not the most recent key version",
+			http::FORBIDDEN,
+			version
+		};
+
+	size_t pending(0), count(0);
+	db::txn txn
+	{
+		*dbs::events
+	};
+
 	if(!room_id && !session_id)
 	{
 		const json::object &rooms
@@ -115,9 +164,16 @@ ircd::m::put_room_keys_keys(client &client,
 			request["rooms"]
 		};
 
-		for(const auto &[room_id, sessions] : rooms)
-			for(const auto &[session_id, session] : json::object(sessions))
-				put_room_keys_keys_key(client, request, room_id, session_id, version, session);
+		for(const auto &[room_id, room] : rooms)
+		{
+			const json::object &sessions
+			{
+				json::object(room)["sessions"]
+			};
+
+			for(const auto &[session_id, session] : sessions)
+				count += put_room_keys_keys_key(txn, pending, request, room_id, session_id, version, session);
+		}
 	}
 	else if(!session_id)
 	{
@@ -127,66 +183,46 @@ ircd::m::put_room_keys_keys(client &client,
 		};
 
 		for(const auto &[session_id, session] : sessions)
-			put_room_keys_keys_key(client, request, room_id, session_id, version, session);
+			count += put_room_keys_keys_key(txn, pending, request, room_id, session_id, version, session);
 	}
-	else put_room_keys_keys_key(client, request, room_id, session_id, version, request);
+	else count += put_room_keys_keys_key(txn, pending, request, room_id, session_id, version, request);
+
+	if(pending)
+		txn();
+
+	log::debug
+	{
+		log, "Backed up %zu room key sessions for %s version %lu",
+		count,
+		string_view{request.user_id},
+		version,
+	};
 
 	return resource::response
 	{
-		client, http::OK
+		client, json::object{}
 	};
 }
 
-ircd::m::event::id::buf
-ircd::m::put_room_keys_keys_key(client &client,
+bool
+ircd::m::put_room_keys_keys_key(db::txn &txn,
+                                size_t &pending,
                                 const resource::request &request,
                                 const room::id &room_id,
                                 const string_view &session_id,
                                 const event::idx &version,
                                 const json::object &content)
 {
-	const m::user::room user_room
-	{
-		request.user_id
-	};
+	if(!dbs::user_room_keys_put(txn, request.user_id, version, room_id, session_id, content))
+		return false;
 
-	const m::room::type events
-	{
-		user_room, "ircd.room_keys.version"
-	};
-
-	events.for_each([&version]
-	(const auto &, const auto &, const event::idx &_event_idx)
-	{
-		if(m::redacted(_event_idx))
-			return true;
-
-		if(_event_idx != version)
-			throw http::error
-			{
-				"%lu is not the most recent key version",
-				http::FORBIDDEN,
-				version
-			};
+	if(++pending < size_t(room_keys_keys_txn_sessions))
+		return true;
 
-		return false; // false to break after this first hit
-	});
-
-	char state_key_buf[event::STATE_KEY_MAX_SIZE];
-	const string_view state_key{fmt::sprintf
-	{
-		state_key_buf, "%s:%s:%u",
-		string_view{room_id},
-		session_id,
-		version,
-	}};
-
-	const auto event_id
-	{
-		send(user_room, request.user_id, "ircd.room_keys.key", state_key, content)
-	};
-
-	return event_id;
+	txn();
+	txn.clear();
+	pending = 0;
+	return true;
 }
 
 //
@@ -202,6 +238,8 @@ ircd::m::room_keys_keys_get
 	}
 };
 
+/// A whole backup is streamed out of the column in order of room, so each
+/// room's object is opened once.
 ircd::m::resource::response
 ircd::m::get_room_keys_keys(client &client,
                             const resource::request &request)
@@ -227,40 +265,27 @@ ircd::m::get_room_keys_keys(client &client,
 		request.query.at<event::idx>("version")
 	};
 
-	const m::user::room user_room
-	{
-		request.user_id
-	};
-
-	const m::room::state state
-	{
-		user_room
-	};
-
 	if(room_id && session_id)
 	{
-		char state_key_buf[event::STATE_KEY_MAX_SIZE];
-		const string_view state_key{fmt::sprintf
+		const bool found
 		{
-			state_key_buf, "%s:%s:%u",
-			string_view{room_id},
-			session_id,
-			version,
-		}};
-
-		const auto event_idx
-		{
-			state.get("ircd.room_keys.key", state_key)
+			dbs::user_room_keys_get(request.user_id, version, room_id, session_id, [&client]
+			(const json::object &session)
+			{
+				resource::response
+				{
+					client, session
+				};
+			})
 		};
 
-		m::get(event_idx, "content", [&client]
-		(const json::object &content)
-		{
-			resource::response
+		if(!found)
+			throw m::NOT_FOUND
 			{
-				client, content
+				"No key found for session %s in %s",
+				session_id,
+				room_id,
 			};
-		});
 
 		return {}; // responded from closure
 	}
@@ -287,43 +312,75 @@ ircd::m::get_room_keys_keys(client &client,
 			top, "sessions"
 		};
 
-		state.for_each("ircd.room_keys.key", [&room_id, &version, &sessions]
-		(const string_view &type, const string_view &state_key, const event::idx &event_idx)
+		dbs::user_room_keys_for_each(request.user_id, version, room_id, [&sessions]
+		(const id::room &, const string_view &session_id, const json::object &session)
 		{
-			string_view part[4]; const auto parts
-			{
-				tokens(state_key, ":", part)
-			};
-
-			const auto &_version{part[3]};
-			const auto &_session_id{part[2]};
-			const string_view &_room_id
+			json::stack::member
 			{
-				begin(part[0]), end(part[1])
+				sessions, session_id, session
 			};
 
-			assert(m::valid(id::ROOM, _room_id));
-			if(_room_id != room_id)
-				return true;
-
-			if(_version != lex_cast<event::idx>(version))
-				return true;
-
-			m::get(std::nothrow, event_idx, "content", [&sessions, &_session_id]
-			(const json::object &session)
-			{
-				json::stack::member
-				{
-					sessions, _session_id, session
-				};
-			});
-
 			return true;
 		});
 
 		return {};
 	}
 
-	assert(0);
+	json::stack::object rooms
+	{
+		top, "rooms"
+	};
+
+	std::optional<json::stack::object> room, sessions;
+	room::id::buf last;
+	dbs::user_room_keys_for_each(request.user_id, version, room::id{}, [&rooms, &room, &sessions, &last]
+	(const id::room &room_id, const string_view &session_id, const json::object &session)
+	{
+		if(room_id != last)
+		{
+			sessions.reset();
+			room.reset();
+			room.emplace(rooms, room_id);
+			sessions.emplace(*room, "sessions");
+			last = room_id;
+		}
+
+		json::stack::member
+		{
+			*sessions, session_id, session
+		};
+
+		return true;
+	});
+
+	sessions.reset();
+	room.reset();
 	return {};
 }
+
+ircd::m::event::idx
+ircd::m::room_keys_version_current(const user::id &user_id)
+{
+	const m::user::room user_room
+	{
+		user_id
+	};
+
+	const m::room::type events
+	{
+		user_room, "ircd.room_keys.version"
+	};
+
+	event::idx ret {0};
+	events.for_each([&ret]
+	(const auto &, const auto &, const event::idx &event_idx)
+	{
+		if(m::redacted(event_idx))
+			return true;
+
+		ret = event_idx;
+		return false; // false to break after this first hit
+	});
+
+	return ret;
+}
@@ -160,6 +160,8 @@ ircd::m::delete_room_keys_version(client &client,
 		m::redact(user_room, request.user_id, event_id, "deleted by client")
 	};
 
+	dbs::user_room_keys_del(request.user_id, event_idx);
+
 	return resource::response
 	{
 		client, http::OK
@@ -79,6 +79,12 @@ get__context(client &client,
 			"You are not permitted to view the room at this event"
 		};
 
+	// Visibility of each event is tested against intervals collected once.
+	const m::visibility visibility
+	{
+		room_id, request.user_id
+	};
+
 	// Non-spec param to allow preventing any state from being returned.
 	const bool include_state
 	{
@@ -172,7 +178,7 @@ get__context(client &client,
 		{
 			const m::event &event{*before};
 			start = event.event_id;
-			if(!visible(event, request.user_id))
+			if(!visibility(event))
 				continue;
 
 			counts.before += _append(array, event, before.event_idx(), user_room, room_depth);
@@ -212,7 +218,7 @@ get__context(client &client,
 		{
 			const m::event &event{*after};
 			end = event.event_id;
-			if(!visible(event, request.user_id))
+			if(!visibility(event))
 				continue;
 
 			counts.after += _append(array, event, after.event_idx(), user_room, room_depth);
@@ -270,7 +276,7 @@ get__context(client &client,
 			if(!seek(std::nothrow, event, event_idx))
 				return true;
 
-			if(!visible(event, request.user_id))
+			if(!visibility(event))
 				return true;
 
 			counts.state += _append(array, event, event_idx, user_room, room_depth, false);
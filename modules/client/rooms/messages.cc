@@ -22,6 +22,48 @@ struct pagination_tokens
 	pagination_tokens(const m::resource::request &);
 };
 
+/// Merges the _room_type ranges of several event types into one iteration
+/// by descending (depth, event_idx) like room::events, so a page filtered by
+/// type is filled without visiting the events of the other types. Only the
+/// backward direction is supported.
+struct type_events
+{
+	struct cursor
+	{
+		std::string type;
+		db::domain::const_iterator it;
+	};
+
+	m::room::id room_id;
+	std::vector<cursor> cursors;
+	ssize_t head {-1};
+
+	bool valid(const cursor &) const;
+	void select();
+
+  public:
+	explicit operator bool() const     { return head >= 0;                     }
+	m::event::idx event_idx() const;
+
+	bool seek(const uint64_t &depth, const m::event::idx &);
+	bool seek_idx(const m::event::idx &);
+	type_events &operator--();
+
+	type_events(const m::room &, std::vector<std::string> types);
+};
+
+static bool
+_types(std::vector<std::string> &,
+       const m::room::id &,
+       const m::compiled_filter &);
+
+template<class iterator>
+static bool
+_step(iterator &, const char &dir);
+
+static bool
+_step(type_events &, const char &dir);
+
 static bool
 _append(json::stack::array &chunk,
         const m::event &,
@@ -36,6 +78,13 @@ max_filter_miss
 	{ "default",   2048L                                        },
 };
 
+conf::item<size_t>
+fetch_batch
+{
+	{ "name",      "ircd.client.rooms.messages.fetch.batch" },
+	{ "default",   64L                                      },
+};
+
 conf::item<float>
 postfetch_multiplier
 {
@@ -43,6 +92,33 @@ postfetch_multiplier
 	{ "default",   2.0                                               },
 };
 
+conf::item<size_t>
+types_max
+{
+	{ "name",      "ircd.client.rooms.messages.types.max" },
+	{ "default",   64L                                    },
+	{ "description",
+
+	R"(
+	Filters restricting the event types are met by merging the type index of
+	each admitted type. Wildcards and not_types require listing the types in
+	the room; past this many the events are scanned and filtered instead.
+	)"},
+};
+
+conf::item<bool>
+messages_snapshot
+{
+	{ "name",      "ircd.client.rooms.messages.snapshot" },
+	{ "default",   true                                  },
+	{ "description",
+
+	R"(
+	Pin a database snapshot for each request so the page is read from one
+	consistent view; events arriving meanwhile are not encountered at all.
+	)"},
+};
+
 log::log
 messages_log
 {
@@ -54,6 +130,10 @@ get__messages(client &client,
               const m::resource::request &request,
               const m::room::id &room_id)
 {
+	std::optional<db::database::snapshot::pin> snapshot;
+	if(messages_snapshot)
+		snapshot.emplace(*m::dbs::events);
+
 	const pagination_tokens page
 	{
 		request
@@ -81,6 +161,12 @@ get__messages(client &client,
 			filter_json
 	};
 
+	// Compiled once so the check for each event below is a few comparisons.
+	const m::compiled_filter compiled_filter
+	{
+		filter
+	};
+
 	const m::room room
 	{
 		room_id, page.from
@@ -92,6 +178,12 @@ get__messages(client &client,
 			"You are not permitted to view the room at this event"
 		};
 
+	// Visibility of each event is tested against intervals collected once.
+	const m::visibility visibility
+	{
+		room_id, request.user_id
+	};
+
 	const m::user::room user_room
 	{
 		request.user_id
@@ -132,85 +224,150 @@ get__messages(client &client,
 		top, "chunk"
 	};
 
-	size_t hit{0}, miss{0};
-	m::room::events it
+	const auto paginate{[&](auto &it)
 	{
-		room
-	};
-
-	for(; it; page.dir == 'b'? --it : ++it)
-	{
-		const m::event &event
+		size_t hit{0}, miss{0};
+
+		// The events are fetched together in batches rather than one at a time
+		// as the iteration proceeds. Each batch is only as large as the number
+		// of events which may still be needed to complete the page (including
+		// the event for the `end` token). The JSON of a batch shares one buffer.
+		std::string fetch_buf;
+		std::vector<m::event> fetch
+		(
+			std::clamp(size_t(page.limit) + 1, 1UL, std::max(size_t(fetch_batch), 1UL))
+		);
+
+		std::vector<m::event::idx> event_idx;
+		event_idx.reserve(fetch.size());
+		for(bool done(false); it && !done; )
 		{
-			*it
-		};
-
-		end = event.event_id;
-		if(hit >= page.limit || miss >= size_t(max_filter_miss))
-			break;
-
-		const bool ok
+			// The iterator is left on the last event gathered for the batch.
+			const size_t want
+			{
+				std::min(page.limit - std::min(hit, size_t(page.limit)) + 1, fetch.size())
+			};
+
+			event_idx.clear();
+			while(1)
+			{
+				event_idx.emplace_back(it.event_idx());
+				if(event_idx.size() >= want)
+					break;
+
+				if(!_step(it, page.dir))
+					break;
+			}
+
+			m::seek(std::nothrow, fetch, event_idx, fetch_buf);
+			for(size_t i(0); i < event_idx.size() && !done; ++i)
+			{
+				const m::event &event
+				{
+					fetch[i]
+				};
+
+				end = event.event_id;
+				if(hit >= page.limit || miss >= size_t(max_filter_miss))
+				{
+					// Reposition the iterator on the last event considered if the
+					// batch went beyond it.
+					if(i + 1 < event_idx.size() || !it)
+						it.seek_idx(event_idx[i]);
+
+					done = true;
+					continue;
+				}
+
+				const bool ok
+				{
+					match(compiled_filter, event)
+
+					&& visibility(event)
+
+					&& _append(chunk, event, event_idx[i], user_room, room_depth)
+				};
+
+				hit += ok;
+				miss += !ok;
+			}
+
+			if(it && !done)
+				_step(it, page.dir);
+		}
+		chunk.~array();
+
+		if(it || page.dir == 'b')
+			json::stack::member
+			{
+				top, "start", json::value{start}
+			};
+
+		if(it || page.dir != 'b')
+			json::stack::member
+			{
+				top, "end", json::value{end}
+			};
+
+		// Manually close out and flush here so the client isn't impacted by
+		// anything related to the postprefetching loop below.
+		top.~object();
+		out.flush(true);
+		response.finish();
+
+		// Continue the room::events iteration to prefetch the next results for a
+		// client hitting /messages to paginate. This endpoint does not conduct any
+		// other prefetching because: 1. The first /messages is predicted by other
+		// requests which initiate prefetches. 2. Subsequent /messages are
+		// prefetched by the following loop after each request from here. Note that
+		// this loop does not yet account for visibility and filters etc.
+		size_t postfetched(0);
+		const size_t postfetch_max(page.limit * float(postfetch_multiplier));
+		for(size_t i(0); i <= postfetch_max && it; ++i, _step(it, page.dir))
 		{
-			(empty(filter_json) || match(filter, event))
-
-			&& visible(event, request.user_id)
+			const auto &event_idx(it.event_idx());
+			postfetched += m::prefetch(event_idx);
+		}
 
-			&& _append(chunk, event, it.event_idx(), user_room, room_depth)
+		log::debug
+		{
+			messages_log, "%s in %s from:%s to:%s dir:%c limit:%zu start:%s end:%s hit:%zu miss:%zu post:%zu",
+			client.loghead(),
+			string_view{room_id},
+			string_view{page.from},
+			string_view{page.to},
+			page.dir,
+			page.limit,
+			string_view{start},
+			string_view{end},
+			hit,
+			miss,
+			postfetched,
 		};
+	}};
 
-		hit += ok;
-		miss += !ok;
-	}
-	chunk.~array();
-
-	if(it || page.dir == 'b')
-		json::stack::member
+	// Type filters are met from the type index; otherwise all events of the
+	// room are visited and filtered.
+	std::vector<std::string> types;
+	if(page.dir == 'b' && _types(types, room.room_id, compiled_filter))
+	{
+		type_events it
 		{
-			top, "start", json::value{start}
+			room, std::move(types)
 		};
 
-	if(it || page.dir != 'b')
-		json::stack::member
+		paginate(it);
+	}
+	else
+	{
+		m::room::events it
 		{
-			top, "end", json::value{end}
+			room
 		};
 
-	// Manually close out and flush here so the client isn't impacted by
-	// anything related to the postprefetching loop below.
-	top.~object();
-	out.flush(true);
-	response.finish();
-
-	// Continue the room::events iteration to prefetch the next results for a
-	// client hitting /messages to paginate. This endpoint does not conduct any
-	// other prefetching because: 1. The first /messages is predicted by other
-	// requests which initiate prefetches. 2. Subsequent /messages are
-	// prefetched by the following loop after each request from here. Note that
-	// this loop does not yet account for visibility and filters etc.
-	size_t postfetched(0);
-	const size_t postfetch_max(page.limit * float(postfetch_multiplier));
-	for(size_t i(0); i <= postfetch_max && it; ++i, page.dir == 'b'? --it : ++it)
-	{
-		const auto &event_idx(it.event_idx());
-		postfetched += m::prefetch(event_idx);
+		paginate(it);
 	}
 
-	log::debug
-	{
-		messages_log, "%s in %s from:%s to:%s dir:%c limit:%zu start:%s end:%s hit:%zu miss:%zu post:%zu",
-		client.loghead(),
-		string_view{room_id},
-		string_view{page.from},
-		string_view{page.to},
-		page.dir,
-		page.limit,
-		string_view{start},
-		string_view{end},
-		hit,
-		miss,
-		postfetched,
-	};
-
 	return {};
 }
 
@@ -229,6 +386,201 @@ _append(json::stack::array &chunk,
 	return m::event::append(chunk, event, opts);
 }
 
+/// Lists the event types admitted by the filter for type_events; false if
+/// the filter doesn't restrict types or the room has too many to list.
+bool
+_types(std::vector<std::string> &ret,
+       const m::room::id &room_id,
+       const m::compiled_filter &filter)
+{
+	using m::compiled_filter;
+
+	const bool has_types
+	{
+		filter.has(compiled_filter::TYPES)
+	};
+
+	const bool has_not_types
+	{
+		filter.has(compiled_filter::NOT_TYPES)
+	};
+
+	if(!has_types && !has_not_types)
+		return false;
+
+	const auto admit{[&filter, &has_types, &has_not_types]
+	(const string_view &type)
+	{
+		return (!has_types || filter.types.has(type))
+		&& (!has_not_types || !filter.not_types.has(type));
+	}};
+
+	// Exact types are seeked directly without listing the room's types.
+	if(has_types && filter.types.prefix.empty() && filter.types.glob.empty())
+	{
+		for(const auto &type : filter.types.exact)
+			if(admit(type))
+				ret.emplace_back(type);
+
+		return ret.size() <= size_t(types_max);
+	}
+
+	// Each type of the room is visited with one seek past its events.
+	char buf[m::dbs::ROOM_TYPE_KEY_MAX_SIZE];
+	auto it
+	{
+		m::dbs::room_type.begin(m::dbs::room_type_key(buf, room_id))
+	};
+
+	for(size_t i(0); it; ++i)
+	{
+		if(i >= size_t(types_max))
+			return false;
+
+		const std::string type
+		{
+			std::get<0>(m::dbs::room_type_key(it->first))
+		};
+
+		if(admit(type))
+			ret.emplace_back(type);
+
+		it = m::dbs::room_type.begin(m::dbs::room_type_key(buf, room_id, type, 0UL, 0UL));
+		if(it && std::get<0>(m::dbs::room_type_key(it->first)) == type)
+			++it;
+	}
+
+	return true;
+}
+
+template<class iterator>
+bool
+_step(iterator &it,
+      const char &dir)
+{
+	return dir == 'b'?
+		bool(--it):
+		bool(++it);
+}
+
+bool
+_step(type_events &it,
+      const char &dir)
+{
+	assert(dir == 'b');
+	return bool(--it);
+}
+
+//
+// type_events
+//
+
+type_events::type_events(const m::room &room,
+                         std::vector<std::string> types)
+:room_id
+{
+	room.room_id
+}
+{
+	cursors.reserve(types.size());
+	for(auto &type : types)
+		cursors.emplace_back(cursor
+		{
+			std::move(type)
+		});
+
+	if(room.event_id)
+		seek_idx(m::index(std::nothrow, room.event_id));
+	else
+		seek(-1UL, -1UL);
+}
+
+type_events &
+type_events::operator--()
+{
+	assert(head >= 0);
+	++cursors.at(head).it;
+	select();
+	return *this;
+}
+
+bool
+type_events::seek_idx(const m::event::idx &event_idx)
+{
+	if(!event_idx)
+	{
+		head = -1;
+		return false;
+	}
+
+	const uint64_t depth
+	{
+		m::get(std::nothrow, event_idx, "depth", -1UL)
+	};
+
+	return seek(depth, event_idx);
+}
+
+/// Positions every cursor at or below the (depth, event_idx) inclusive.
+bool
+type_events::seek(const uint64_t &depth,
+                  const m::event::idx &event_idx)
+{
+	char buf[m::dbs::ROOM_TYPE_KEY_MAX_SIZE];
+	for(auto &cursor : cursors)
+		cursor.it = m::dbs::room_type.begin
+		(
+			m::dbs::room_type_key(buf, room_id, cursor.type, depth, event_idx)
+		);
+
+	select();
+	return bool(*this);
+}
+
+m::event::idx
+type_events::event_idx()
+const
+{
+	assert(head >= 0);
+	return std::get<2>(m::dbs::room_type_key(cursors.at(head).it->first));
+}
+
+void
+type_events::select()
+{
+	head = -1;
+	std::pair<uint64_t, m::event::idx> best {0, 0};
+	for(size_t i(0); i < cursors.size(); ++i)
+	{
+		if(!valid(cursors[i]))
+			continue;
+
+		const auto &[type, depth, event_idx]
+		{
+			m::dbs::room_type_key(cursors[i].it->first)
+		};
+
+		const std::pair<uint64_t, m::event::idx> pos
+		{
+			depth, event_idx
+		};
+
+		if(head >= 0 && pos <= best)
+			continue;
+
+		head = i;
+		best = pos;
+	}
+}
+
+bool
+type_events::valid(const cursor &cursor)
+const
+{
+	return cursor.it
+	&& std::get<0>(m::dbs::room_type_key(cursor.it->first)) == cursor.type;
+}
+
 // Client-Server 6.3.6 query parameters
 pagination_tokens::pagination_tokens(const m::resource::request &request)
 try
@@ -172,6 +172,19 @@ try
 	// Send the original event
 	append(event_idx, event);
 
+	// The aggregations tell whether there are any relations of the rel_type
+	// before the references are walked and fetched.
+	int64_t count{0};
+	m::dbs::event_relates_for_each(event_idx, [&count, &rel_type]
+	(const string_view &_rel_type, const string_view &, const m::dbs::event_relates_value &value)
+	{
+		count += _rel_type == rel_type? value.count: 0L;
+		return true;
+	});
+
+	if(rel_type && !count)
+		return;
+
 	// Send all the referencees
 	const m::event::refs refs{event_idx};
 	refs.for_each(m::dbs::ref::M_RELATES, each_ref);
@@ -225,6 +225,16 @@ get__relations(ircd::client &,
                const ircd::m::resource::request &,
                const ircd::m::room::id &);
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// threads.cc
+//
+
+ircd::m::resource::response
+get__threads(ircd::client &,
+             const ircd::m::resource::request &,
+             const ircd::m::room::id &);
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // upgrade.cc
@@ -13,9 +13,16 @@
 using namespace ircd::m;
 using namespace ircd;
 
-static bool
-check_transaction_id(const m::user::id &user_id,
-                     const string_view &transaction_id);
+static m::event::id::buf
+find_transaction_id(const m::user::id &user_id,
+                    const string_view &transaction_id);
+
+static m::event::id::buf
+cached_transaction_id(const string_view &key);
+
+static void
+cache_transaction_id(const string_view &key,
+                     const m::event::id::buf &event_id);
 
 static void
 save_transaction_id(const m::event &,
@@ -37,6 +44,25 @@ save_transaction_id_hookfn
 	}
 };
 
+conf::item<size_t>
+txnid_cache_max
+{
+	{ "name",     "ircd.client.rooms.send.txnid.cache.max" },
+	{ "default",  16384L                                   },
+};
+
+/// Recent transactions by "user device txnid" so a retried request is
+/// answered with the event_id of the first. An empty event_id marks a
+/// request still in progress; the retry waits for it on the dock.
+static std::list<std::pair<std::string, m::event::id::buf>>
+txnid_cache_lru;
+
+static std::map<string_view, decltype(txnid_cache_lru)::iterator, std::less<>>
+txnid_cache;
+
+static ctx::dock
+txnid_dock;
+
 conf::item<bool>
 new_content_workaround
 {
@@ -84,13 +110,60 @@ put__send(client &client,
 		url::decode(transaction_id_buf, request.parv[3])
 	};
 
-	if(!check_transaction_id(request.user_id, transaction_id))
-		throw m::error
+	const m::device::id::buf device_id
+	{
+		m::user::tokens::device(std::nothrow, request.access_token)
+	};
+
+	char txnid_key_buf[m::id::MAX_SIZE * 2 + sizeof(transaction_id_buf) + 2];
+	const string_view txnid_key
+	{
+		fmt::sprintf
 		{
-			http::CONFLICT, "M_DUPLICATE_TXNID",
-			"Already processed request with txnid '%s'",
-			transaction_id
+			txnid_key_buf, "%s %s %s",
+			string_view{request.user_id},
+			string_view{device_id},
+			transaction_id,
+		}
+	};
+
+	// A retried request is answered with the event_id of the original. The
+	// persisted transactions in the user's room are consulted when it is not
+	// in the cache, i.e. after a restart.
+	m::event::id::buf txnid_event_id
+	{
+		cached_transaction_id(txnid_key)
+	};
+
+	if(!txnid_event_id)
+		txnid_event_id = find_transaction_id(request.user_id, transaction_id);
+
+	if(txnid_event_id)
+	{
+		cache_transaction_id(txnid_key, txnid_event_id);
+		return m::resource::response
+		{
+			client, json::members
+			{
+				{ "event_id", txnid_event_id }
+			}
 		};
+	}
+
+	// Mark the transaction in progress; the mark is removed on error so the
+	// client can retry.
+	cache_transaction_id(txnid_key, m::event::id::buf{});
+	const unwind_exceptional txnid_failed{[&txnid_key]
+	{
+		const auto it(txnid_cache.find(txnid_key));
+		if(it != end(txnid_cache) && !it->second->second)
+		{
+			txnid_cache_lru.erase(it->second);
+			txnid_cache.erase(it);
+		}
+
+		txnid_dock.notify_all();
+	}};
 
 	json::object content
 	{
@@ -168,6 +241,7 @@ put__send(client &client,
 				handle_command(client, request, room)
 			};
 
+			cache_transaction_id(txnid_key, event_id);
 			return m::resource::response
 			{
 				client, json::members
@@ -185,6 +259,8 @@ put__send(client &client,
 		m::send(room, request.user_id, type, content)
 	};
 
+	cache_transaction_id(txnid_key, event_id);
+
 	// For public echo, run the command after sending the command to the room.
 	if(command_echo)
 	{
@@ -263,9 +339,59 @@ save_transaction_id(const m::event &event,
 	});
 }
 
+m::event::id::buf
+cached_transaction_id(const string_view &key)
+{
+	auto it
+	{
+		txnid_cache.find(key)
+	};
+
+	// Wait out a request in progress for the same transaction.
+	txnid_dock.wait([&it, &key]
+	{
+		it = txnid_cache.find(key);
+		return it == end(txnid_cache) || it->second->second;
+	});
+
+	if(it == end(txnid_cache))
+		return {};
+
+	txnid_cache_lru.splice(begin(txnid_cache_lru), txnid_cache_lru, it->second);
+	return it->second->second;
+}
+
+void
+cache_transaction_id(const string_view &key,
+                     const m::event::id::buf &event_id)
+{
+	const auto it
+	{
+		txnid_cache.find(key)
+	};
+
+	if(it != end(txnid_cache))
+	{
+		it->second->second = event_id;
+		txnid_cache_lru.splice(begin(txnid_cache_lru), txnid_cache_lru, it->second);
+		txnid_dock.notify_all();
+		return;
+	}
+
+	txnid_cache_lru.emplace_front(std::string(key), event_id);
+	txnid_cache.emplace(txnid_cache_lru.front().first, begin(txnid_cache_lru));
+	while(txnid_cache.size() > size_t(txnid_cache_max))
+	{
+		txnid_cache.erase(txnid_cache_lru.back().first);
+		txnid_cache_lru.pop_back();
+	}
+}
+
 // Using a linear search here because we have no index on txnids as this
 // is the only codepath where we'd perform that lookup; in contrast the
-// event_id -> txnid query is made far more often for client sync.
+// event_id -> txnid query is made far more often for client sync. Recent
+// transactions are found in the cache above so this is only reached for a
+// first attempt or after the cache has lost it.
 //
 // This means we have to set some arbitrary limits on the linear search:
 // lim[0] is a total limit of events to iterate, so if the user's room
@@ -273,9 +399,9 @@ save_transaction_id(const m::event &event,
 // duplicate txnid; this is highly unlikely. lim[1] allows the user to
 // have several /sends in flight at the same time, also unlikely but we
 // avoid that case for false non-match.
-static bool
-check_transaction_id(const m::user::id &user_id,
-                     const string_view &transaction_id)
+static m::event::id::buf
+find_transaction_id(const m::user::id &user_id,
+                    const string_view &transaction_id)
 {
 	static const auto type_match
 	{
@@ -299,6 +425,7 @@ check_transaction_id(const m::user::id &user_id,
 	};
 
 	ssize_t lim[] { 128, 3 };
+	m::event::id::buf ret;
 	const m::user::room user_room{user_id};
 	for(m::room::events it(user_room); it && lim[0] > 0 && lim[1] > 0; --it, --lim[0])
 	{
@@ -309,8 +436,15 @@ check_transaction_id(const m::user::id &user_id,
 		if(!m::query(std::nothrow, it.event_idx(), "content", content_match))
 			continue;
 
-		return false;
+		// The state_key of the transaction is the event_id it produced.
+		m::get(std::nothrow, it.event_idx(), "state_key", [&ret]
+		(const string_view &state_key)
+		{
+			ret = m::event::id{state_key};
+		});
+
+		break;
 	}
 
-	return true;
+	return ret;
 }
@@ -23,6 +23,19 @@ get__state(client &client,
            const m::resource::request &request,
            const m::room::state &state);
 
+conf::item<bool>
+state_snapshot
+{
+	{ "name",      "ircd.client.rooms.state.snapshot" },
+	{ "default",   true                               },
+	{ "description",
+
+	R"(
+	Pin a database snapshot while listing the full state of a room, so the
+	listing is consistent as new state arrives during the response.
+	)"},
+};
+
 m::resource::response
 put__state(client &client,
            const m::resource::request &request,
@@ -149,6 +162,10 @@ get__state(client &client,
            const m::resource::request &request,
            const m::room::state &state)
 {
+	std::optional<db::database::snapshot::pin> snapshot;
+	if(state_snapshot)
+		snapshot.emplace(*m::dbs::events);
+
 	m::resource::response::chunked response
 	{
 		client, http::OK
@@ -0,0 +1,201 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#include "rooms.h"
+
+using namespace ircd;
+
+static bool
+threads_participated(const m::event::idx &root,
+                     const m::user::id &user_id);
+
+static int64_t
+threads_count(const m::event::idx &root);
+
+conf::item<size_t>
+threads_limit_default
+{
+	{ "name",     "ircd.client.rooms.threads.limit.default" },
+	{ "default",  10L                                       },
+};
+
+conf::item<size_t>
+threads_limit_max
+{
+	{ "name",     "ircd.client.rooms.threads.limit.max" },
+	{ "default",  100L                                  },
+};
+
+/// Lists the threads of the room by their latest reply, newest first. The
+/// roots and their latest replies are read from the room_threads index and
+/// the summaries from the event_relates aggregations; no thread is scanned.
+/// The pagination token is the event_idx of the latest reply of the last
+/// thread in the chunk.
+m::resource::response
+get__threads(client &client,
+             const m::resource::request &request,
+             const m::room::id &room_id)
+{
+	if(!m::exists(room_id))
+		throw m::NOT_FOUND
+		{
+			"Cannot find threads in %s which is not found.",
+			string_view{room_id}
+		};
+
+	const m::room room
+	{
+		room_id
+	};
+
+	if(!visible(room, request.user_id))
+		throw m::ACCESS_DENIED
+		{
+			"You are not permitted to view the room."
+		};
+
+	const string_view include
+	{
+		request.query.get("include", "all"_sv)
+	};
+
+	if(include != "all" && include != "participated")
+		throw m::BAD_REQUEST
+		{
+			"Unrecognized value for the include parameter."
+		};
+
+	const size_t limit
+	{
+		std::min(request.query.get<size_t>("limit", size_t(threads_limit_default)), size_t(threads_limit_max))
+	};
+
+	const m::event::idx from
+	{
+		request.query.get<m::event::idx>("from", std::numeric_limits<m::event::idx>::max())
+	};
+
+	// (latest, root) of each thread before the token.
+	std::vector<std::pair<m::event::idx, m::event::idx>> threads;
+	m::dbs::room_threads_for_each(room_id, [&threads, &from]
+	(const m::event::idx &root, const m::event::idx &latest)
+	{
+		if(latest < from)
+			threads.emplace_back(latest, root);
+
+		return true;
+	});
+
+	std::sort(rbegin(threads), rend(threads));
+
+	m::resource::response::chunked response
+	{
+		client, http::OK
+	};
+
+	json::stack out
+	{
+		response.buf, response.flusher()
+	};
+
+	json::stack::object top
+	{
+		out
+	};
+
+	m::event::idx next_batch {0};
+	{
+		json::stack::array chunk
+		{
+			top, "chunk"
+		};
+
+		size_t count {0};
+		m::event::fetch event;
+		for(const auto &[latest, root] : threads)
+		{
+			if(count >= limit)
+				break;
+
+			if(threads_count(root) <= 0)
+				continue;
+
+			if(include == "participated" && !threads_participated(root, request.user_id))
+				continue;
+
+			if(!seek(std::nothrow, event, root))
+				continue;
+
+			if(!visible(event, request.user_id))
+				continue;
+
+			m::event::append::opts opts;
+			opts.event_idx = &root;
+			opts.user_id = &request.user_id;
+			opts.query_txnid = false;
+			m::event::append
+			{
+				chunk, event, opts
+			};
+
+			next_batch = latest;
+			++count;
+		}
+
+		if(count < limit)
+			next_batch = 0;
+	}
+
+	if(next_batch)
+		json::stack::member
+		{
+			top, "next_batch", json::value
+			{
+				lex_cast(next_batch), json::STRING
+			}
+		};
+
+	return std::move(response);
+}
+
+bool
+threads_participated(const m::event::idx &root,
+                     const m::user::id &user_id)
+{
+	const bool sender
+	{
+		m::query(std::nothrow, root, "sender", false, [&user_id]
+		(const string_view &sender)
+		{
+			return sender == user_id;
+		})
+	};
+
+	// The m.thread aggregations are keyed by the sender of each reply.
+	return sender || !m::dbs::event_relates_for_each(root, [&user_id]
+	(const string_view &rel_type, const string_view &key, const auto &)
+	{
+		return rel_type != "m.thread" || key != user_id;
+	});
+}
+
+int64_t
+threads_count(const m::event::idx &root)
+{
+	int64_t ret {0};
+	m::dbs::event_relates_for_each(root, [&ret]
+	(const string_view &rel_type, const string_view &, const auto &value)
+	{
+		ret += rel_type == "m.thread"? value.count: 0L;
+		return true;
+	});
+
+	return ret;
+}
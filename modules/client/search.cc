@@ -10,16 +10,27 @@
 
 namespace ircd::m::search
 {
+	using terms = vector_view<const string_view>;
+
 	static bool handle_result(result &, const query &);
+	static bool handle_match(result &, const query &);
 	static bool handle_content(result &, const query &, const json::object &);
-	static bool query_all_rooms(result &, const query &);
-	static bool query_room(result &, const query &, const room::id &);
+	static long rank_content(const terms &, const json::object &);
+	static bool query_index(result &, const query &, const room::id &, const terms &);
+	static bool query_scan(result &, const query &, const m::room &, const terms &);
+	static bool query_all_rooms(result &, const query &, const terms &);
+	static bool query_room(result &, const query &, const room::id &, const terms &);
+	static std::vector<std::string> query_terms(const query &);
 	static bool query_rooms(result &, const query &);
+	static string_view make_batch(const mutable_buffer &, const batch &);
+	static batch parse_batch(const string_view &);
 	static void handle_room_events(client &, const resource::request &, const json::object &, json::stack::object &);
 	static resource::response search_post_handle(client &, const resource::request &);
 
 	extern conf::item<size_t> limit_override;
 	extern conf::item<bool> count_total;
+	extern conf::item<bool> index_enable;
+	extern conf::item<size_t> rank_window;
 	extern resource::method search_post;
 	extern resource search_resource;
 	extern log::log log;
@@ -55,7 +66,8 @@ ircd::m::search::search_post
 {
 	search_resource, "POST", search_post_handle,
 	{
-		search_post.REQUIRES_AUTH,
+		search_post.REQUIRES_AUTH |
+		search_post.SHEDDABLE,
 
 		// Some queries can take a really long time, especially under
 		// development. We don't need the default request timer getting
@@ -71,6 +83,22 @@ ircd::m::search::count_total
 	{ "default",  false                       },
 };
 
+decltype(ircd::m::search::index_enable)
+ircd::m::search::index_enable
+{
+	{ "name",     "ircd.m.search.index.enable" },
+	{ "default",  true                         },
+};
+
+/// Results answered by the index are ranked in windows of this many of the
+/// most recent candidates; order_by "recent" does not rank.
+decltype(ircd::m::search::rank_window)
+ircd::m::search::rank_window
+{
+	{ "name",     "ircd.m.search.rank.window" },
+	{ "default",  256L                        },
+};
+
 decltype(ircd::m::search::limit_override)
 ircd::m::search::limit_override
 {
@@ -161,7 +189,7 @@ try
 	const search::query query
 	{
 		request.user_id,
-		request.query.get<size_t>("next_batch", 0UL),
+		parse_batch(request.query["next_batch"]),
 		room_events,
 		room_event_filter,
 		at<"search_term"_>(room_events),
@@ -173,10 +201,10 @@ try
 	log::logf
 	{
 		log, log::DEBUG,
-		"Query '%s' by %s batch:%ld order_by:%s inc_state:%b rooms:%zu limit:%zu",
+		"Query '%s' by %s batch:%s order_by:%s inc_state:%b rooms:%zu limit:%zu",
 		query.search_term,
 		string_view{query.user_id},
-		query.batch,
+		request.query["next_batch"],
 		json::get<"order_by"_>(query.room_events),
 		json::get<"include_state"_>(query.room_events),
 		json::get<"rooms"_>(query.filter).size(),
@@ -188,6 +216,8 @@ try
 		room_events_result.s
 	};
 
+	result.next = query.batch;
+
 	const bool finished
 	{
 		query_rooms(result, query)
@@ -216,12 +246,20 @@ try
 		room_events_result, "state"
 	};
 
+	char batch_buf[96];
+	const string_view next_batch
+	{
+		!finished?
+			make_batch(batch_buf, result.next):
+			string_view{}
+	};
+
 	if(!finished)
 		json::stack::member
 		{
 			room_events_result, "next_batch", json::value
 			{
-				lex_cast(result.skipped + result.checked), json::STRING
+				next_batch, json::STRING
 			}
 		};
 
@@ -229,11 +267,11 @@ try
 	log::logf
 	{
 		log, log::DEBUG,
-		"Result '%s' by %s batch[%ld -> %ld] count:%lu append:%lu match:%lu check:%lu skip:%lu in %s",
+		"Result '%s' by %s batch[%s -> %s] count:%lu append:%lu match:%lu check:%lu skip:%lu in %s",
 		query.search_term,
 		string_view{query.user_id},
-		query.batch,
-		result.event_idx,
+		request.query["next_batch"],
+		next_batch,
 		result.count,
 		result.appends,
 		result.matched,
@@ -255,6 +293,41 @@ catch(const std::exception &e)
 	};
 }
 
+/// The batch token is room.phase.pos.skip; a token which does not parse
+/// starts the search from the beginning.
+ircd::m::search::batch
+ircd::m::search::parse_batch(const string_view &token)
+{
+	string_view part[4];
+	if(tokens(token, '.', part) != 4)
+		return {};
+
+	for(const auto &p : part)
+		if(!lex_castable<ulong>(p))
+			return {};
+
+	batch ret;
+	ret.room = lex_cast<ulong>(part[0]);
+	ret.phase = (enum batch::phase)std::min(lex_cast<ulong>(part[1]), ulong(batch::SCAN_ALL));
+	ret.pos = lex_cast<ulong>(part[2]);
+	ret.skip = lex_cast<ulong>(part[3]);
+	return ret;
+}
+
+ircd::string_view
+ircd::m::search::make_batch(const mutable_buffer &buf,
+                            const batch &batch)
+{
+	return fmt::sprintf
+	{
+		buf, "%zu.%u.%lu.%zu",
+		batch.room,
+		uint(batch.phase),
+		batch.pos,
+		batch.skip,
+	};
+}
+
 bool
 ircd::m::search::query_rooms(result &result,
                              const query &query)
@@ -269,20 +342,70 @@ ircd::m::search::query_rooms(result &result,
 		*result.out, "results"
 	};
 
+	const auto terms_buf
+	{
+		query_terms(query)
+	};
+
+	const std::vector<string_view> terms
+	(
+		begin(terms_buf), end(terms_buf)
+	);
+
 	if(rooms.empty())
-		return query_all_rooms(result, query);
+		return query_all_rooms(result, query, terms);
 
+	size_t i(0);
 	for(const json::string room_id : rooms)
-		if(!query_room(result, query, room_id))
+	{
+		if(i++ < result.next.room)
+			continue;
+
+		if(!query_room(result, query, room_id, terms))
 			return false;
 
+		result.next = search::batch{i};
+	}
+
 	return true;
 }
 
+/// Terms of the search as the index tokenizes them; empty when the index is
+/// not to be used.
+std::vector<std::string>
+ircd::m::search::query_terms(const query &query)
+{
+	std::vector<std::string> ret;
+	if(!index_enable || empty(query.search_term))
+		return ret;
+
+	const unique_mutable_buffer buf
+	{
+		size(query.search_term)
+	};
+
+	const string_view search_term
+	{
+		json::unescape(buf, json::string(query.search_term))
+	};
+
+	dbs::room_search_terms(search_term, [&ret]
+	(const string_view &term)
+	{
+		if(std::find(begin(ret), end(ret), term) == end(ret))
+			ret.emplace_back(term);
+
+		return true;
+	});
+
+	return ret;
+}
+
 bool
 ircd::m::search::query_room(result &result,
                             const query &query,
-                            const room::id &room_id)
+                            const room::id &room_id,
+                            const terms &terms)
 {
 	const m::room room
 	{
@@ -296,22 +419,214 @@ ircd::m::search::query_room(result &result,
 			string_view{room_id},
 		};
 
+	if(result.next.phase == batch::INDEX && !terms.empty())
+		if(!query_index(result, query, room_id, terms))
+			return false;
+
+	return query_scan(result, query, room, terms);
+}
+
+/// Scans the content of the room in descending order of depth. With the
+/// index this starts from the most recent event which predates it.
+bool
+ircd::m::search::query_scan(result &result,
+                            const query &query,
+                            const m::room &room,
+                            const terms &terms)
+{
+	const event::idx floor
+	{
+		!terms.empty()? dbs::room_search_floor(): -1UL
+	};
+
+	if(!floor)
+		return true;
+
+	auto &next(result.next);
+	if(next.phase != batch::SCAN)
+	{
+		next.phase = batch::SCAN;
+		next.pos = -1UL;
+		next.skip = 0;
+	}
+
+	if(next.pos == -1UL && !terms.empty())
+	{
+		m::room::events it
+		{
+			room
+		};
+
+		for(; it && it.event_idx() >= floor; --it);
+		if(!it)
+			return true;
+
+		next.pos = it.depth();
+	}
+
 	const m::room::content content
 	{
-		room
+		room, { next.pos, -1L }
 	};
 
-	return content.for_each([&result, &query]
+	size_t skip(next.skip);
+	return content.for_each([&result, &query, &floor, &next, &skip]
 	(const json::object &content, const auto &depth, const auto &event_idx)
 	{
+		// Events at the resumed depth which the last page visited.
+		if(depth == next.pos && skip)
+		{
+			--skip;
+			return true;
+		}
+
+		if(depth != next.pos)
+		{
+			next.pos = depth;
+			next.skip = 0;
+		}
+
+		++next.skip;
+		if(event_idx >= floor)
+			return true;
+
 		result.event_idx = event_idx;
+		result.rank = 0;
 		return handle_content(result, query, content);
 	});
 }
 
+/// Answers the search from the inverted index. Candidates contain every
+/// term; each is ranked by the occurrences of the terms in its content,
+/// which also drops candidates which no longer match (e.g. redacted).
+bool
+ircd::m::search::query_index(result &result,
+                             const query &query,
+                             const room::id &room_id,
+                             const terms &terms)
+{
+	const bool ranked
+	{
+		json::get<"order_by"_>(query.room_events) != "recent"
+	};
+
+	const size_t window
+	{
+		ranked? std::max(size_t(rank_window), 1UL): 1UL
+	};
+
+	// Each window is the candidates below the position; results of the
+	// window already returned are skipped after ranking it again.
+	auto &next(result.next);
+	event::idx lowest{0};
+	std::vector<std::pair<long, event::idx>> candidates;
+	candidates.reserve(window);
+	const auto flush{[&result, &query, &next, &lowest, &candidates]
+	{
+		if(candidates.empty())
+			return true;
+
+		std::stable_sort(begin(candidates), end(candidates), []
+		(const auto &a, const auto &b)
+		{
+			return a.first > b.first;
+		});
+
+		bool ret{true};
+		result.skipped += std::min(next.skip, candidates.size());
+		for(size_t i(next.skip); i < candidates.size() && ret; ++i)
+		{
+			result.rank = candidates[i].first;
+			result.event_idx = candidates[i].second;
+			next.skip = i + 1;
+			ret = handle_match(result, query);
+		}
+
+		if(next.skip >= candidates.size())
+		{
+			next.pos = lowest - 1;
+			next.skip = 0;
+		}
+
+		candidates.clear();
+		return ret;
+	}};
+
+	const bool ret
+	{
+		dbs::room_search_for_each(room_id, terms, next.pos, [&terms, &window, &lowest, &candidates, &flush]
+		(const event::idx &event_idx)
+		{
+			long rank(0);
+			m::get(std::nothrow, event_idx, "content", [&terms, &rank]
+			(const json::object &content)
+			{
+				rank = rank_content(terms, content);
+			});
+
+			if(!rank)
+				return true;
+
+			lowest = event_idx;
+			candidates.emplace_back(rank, event_idx);
+			return candidates.size() < window || flush();
+		})
+	};
+
+	return ret && flush();
+}
+
+/// Counts the occurrences of the terms in the searchable fields; zero unless
+/// every term occurs.
+long
+ircd::m::search::rank_content(const terms &terms,
+                              const json::object &content)
+{
+	std::vector<long> hits(terms.size(), 0L);
+	for(const string_view &field : {"body"_sv, "name"_sv, "topic"_sv})
+	{
+		const json::object::const_iterator it
+		{
+			content.find(field)
+		};
+
+		if(it == content.end() || json::type(it->second) != json::STRING)
+			continue;
+
+		const json::string text
+		{
+			it->second
+		};
+
+		const unique_mutable_buffer buf
+		{
+			size(text)
+		};
+
+		dbs::room_search_terms(json::unescape(buf, text), [&terms, &hits]
+		(const string_view &term)
+		{
+			for(size_t i(0); i < terms.size(); ++i)
+				hits[i] += term == terms[i];
+
+			return true;
+		});
+	}
+
+	long ret(0);
+	for(const auto &hit : hits)
+		if(!hit)
+			return 0L;
+		else
+			ret += hit;
+
+	return ret;
+}
+
 bool
 ircd::m::search::query_all_rooms(result &result,
-                                 const query &query)
+                                 const query &query,
+                                 const terms &terms)
 {
 	if(!is_oper(query.user_id))
 		throw m::ACCESS_DENIED
@@ -319,12 +634,51 @@ ircd::m::search::query_all_rooms(result &result,
 			"You are not an operator."
 		};
 
-	return m::events::content::for_each([&result, &query]
+	size_t i(0);
+	const bool indexed
+	{
+		result.next.phase == batch::SCAN_ALL || terms.empty() || rooms::for_each([&result, &query, &terms, &i]
+		(const room::id &room_id)
+		{
+			if(i++ < result.next.room)
+				return true;
+
+			if(!query_index(result, query, room_id, terms))
+				return false;
+
+			result.next = search::batch{i};
+			return true;
+		})
+	};
+
+	if(!indexed)
+		return false;
+
+	// Content is iterated in ascending order of event_idx, so the scan of
+	// events written before the index ends at its floor.
+	const event::idx floor
+	{
+		!terms.empty()? dbs::room_search_floor(): -1UL
+	};
+
+	auto &next(result.next);
+	if(next.phase != batch::SCAN_ALL)
+		next = { 0, batch::SCAN_ALL, 0, 0 };
+
+	bool ret{true};
+	m::events::content::for_each(next.pos, [&result, &query, &floor, &next, &ret]
 	(const auto &event_idx, const json::object &content)
 	{
+		if(event_idx >= floor)
+			return false;
+
+		next.pos = event_idx + 1;
 		result.event_idx = event_idx;
-		return handle_content(result, query, content);
+		result.rank = 0;
+		return ret = handle_content(result, query, content);
 	});
+
+	return ret;
 }
 
 bool
@@ -333,12 +687,6 @@ ircd::m::search::handle_content(result &result,
                                 const json::object &content)
 try
 {
-	if(result.skipped < query.batch)
-	{
-		++result.skipped;
-		return true;
-	}
-
 	const json::string body
 	{
 		content["body"]
@@ -349,15 +697,11 @@ try
 		has(body, query.search_term)
 	};
 
-	const bool handled
-	{
-		match && handle_result(result, query)
-	};
+	if(match)
+		return handle_match(result, query);
 
 	result.checked += 1;
-	result.matched += match;
-	result.count += handled;
-	return result.count < query.limit;
+	return true;
 }
 catch(const ctx::interrupted &e)
 {
@@ -399,6 +743,21 @@ catch(const std::exception &e)
 	return true;
 }
 
+bool
+ircd::m::search::handle_match(result &result,
+                              const query &query)
+{
+	const bool handled
+	{
+		handle_result(result, query)
+	};
+
+	result.checked += 1;
+	result.matched += 1;
+	result.count += handled;
+	return result.count < query.limit;
+}
+
 bool
 ircd::m::search::handle_result(result &result,
                                const query &query)
@@ -0,0 +1,1162 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::sync::sliding
+{
+	struct list;
+	struct conn;
+	struct want;
+	struct window;
+
+	using item_closure = std::function<void (const json::object &)>;
+
+	static event::idx recency(const m::room &, const m::user::id &);
+	static list &acquire_list(const m::user::id &);
+	static conn &acquire_conn(const string_view &key, const event::idx &since);
+	static bool append_item(data &, const string_view &name, const item_closure &);
+	static void append_counts(data &, json::stack::object &);
+	static void append_name(data &, json::stack::object &, const event::idx &since);
+	static bool append_required_state(data &, json::stack::object &, const json::array &);
+	static bool append_timeline(data &, json::stack::object &, const event::idx &since, const size_t &limit);
+	static void append_room(data &, json::stack::object &, const json::object &opts, const event::idx &since);
+	static void handle_notify(const m::event &, m::vm::eval &);
+	static void fini() noexcept;
+	static resource::response handle_post(client &, const resource::request &);
+
+	extern conf::item<size_t> lists_max;
+	extern conf::item<size_t> conns_max;
+	extern conf::item<size_t> ranges_max;
+	extern conf::item<size_t> range_max;
+	extern conf::item<size_t> timeline_limit_max;
+	extern hookfn<vm::eval &> notified;
+	extern resource::method method_post;
+	extern resource resource;
+}
+
+ircd::mapi::header
+IRCD_MODULE
+{
+	"Client Sliding Sync :MSC3575", nullptr, []
+	{
+		ircd::m::sync::sliding::fini();
+	}
+};
+
+/// Rooms of one user ordered by the index of their most recent event, which
+/// is the recency sort of the MSC. The list is built once from the user's
+/// joins and invites when first requested and then kept in order by the
+/// notify hook; a window requested by the client is a walk from the front
+/// rather than a fetch of every room's head on each request.
+///
+struct ircd::m::sync::sliding::list
+{
+	using order_type = std::set<std::pair<event::idx, std::string>, std::greater<>>;
+	using index_type = std::multimap<string_view, list *, std::less<>>;
+	using map_type = std::map<std::string, std::unique_ptr<list>, std::less<>>;
+
+	struct cell
+	{
+		order_type::iterator order;
+		index_type::iterator index;
+	};
+
+	using rooms_type = std::map<string_view, cell, std::less<>>;
+
+	static map_type map;
+	static index_type index;
+
+	m::user::id::buf user_id;
+	order_type order;
+	rooms_type rooms;
+	ctx::dock dock;
+	uint64_t version {0};
+	size_t refs {0};
+	bool ready {false};
+	system_point used;
+
+	bool set(const string_view &room_id, const event::idx &);
+	bool erase(const string_view &room_id);
+
+	list(const m::user::id &);
+	list(list &&) = delete;
+	list(const list &) = delete;
+	~list() noexcept;
+};
+
+/// State of one connection (user, device and conn_id): the rooms it has been
+/// sent and the sequence they were brought up to, and the room_ids of each
+/// list window last sent so a longpoll can tell when a window has moved.
+/// A request without a pos starts the connection over.
+///
+struct ircd::m::sync::sliding::conn
+{
+	using map_type = std::map<std::string, conn, std::less<>>;
+
+	static map_type map;
+
+	std::map<std::string, event::idx, std::less<>> sent;
+	std::map<std::string, std::vector<std::string>, std::less<>> windows;
+	event::idx pos {0};
+	size_t refs {0};
+	system_point used;
+};
+
+/// One room the response will carry and the options it was requested with.
+struct ircd::m::sync::sliding::want
+{
+	std::string room_id;
+	json::object opts;
+	event::idx since {0};
+};
+
+/// One range of one list as it will be sent in a SYNC op.
+struct ircd::m::sync::sliding::window
+{
+	string_view name;
+	size_t range[2] {0, 0};
+	std::vector<std::string> room_ids;
+};
+
+decltype(ircd::m::sync::sliding::list::map)
+ircd::m::sync::sliding::list::map;
+
+decltype(ircd::m::sync::sliding::list::index)
+ircd::m::sync::sliding::list::index;
+
+decltype(ircd::m::sync::sliding::conn::map)
+ircd::m::sync::sliding::conn::map;
+
+decltype(ircd::m::sync::sliding::lists_max)
+ircd::m::sync::sliding::lists_max
+{
+	{ "name",     "ircd.client.sync.sliding.lists.max" },
+	{ "default",  1024L                                },
+	{ "help",     "Number of users whose sorted room list is kept."   },
+};
+
+decltype(ircd::m::sync::sliding::conns_max)
+ircd::m::sync::sliding::conns_max
+{
+	{ "name",     "ircd.client.sync.sliding.conns.max" },
+	{ "default",  4096L                                },
+	{ "help",     "Number of connections whose sent state is kept."   },
+};
+
+decltype(ircd::m::sync::sliding::ranges_max)
+ircd::m::sync::sliding::ranges_max
+{
+	{ "name",     "ircd.client.sync.sliding.ranges.max" },
+	{ "default",  16L                                   },
+	{ "help",     "Maximum ranges honored for all lists of a request." },
+};
+
+decltype(ircd::m::sync::sliding::range_max)
+ircd::m::sync::sliding::range_max
+{
+	{ "name",     "ircd.client.sync.sliding.range.max" },
+	{ "default",  256L                                 },
+	{ "help",     "Maximum rooms in a single range of a list."        },
+};
+
+decltype(ircd::m::sync::sliding::timeline_limit_max)
+ircd::m::sync::sliding::timeline_limit_max
+{
+	{ "name",     "ircd.client.sync.sliding.timeline_limit.max" },
+	{ "default",  64L                                           },
+	{ "help",     "Maximum timeline events sent for one room."  },
+};
+
+decltype(ircd::m::sync::sliding::resource)
+ircd::m::sync::sliding::resource
+{
+	"/_matrix/client/unstable/org.matrix.msc3575/sync",
+	{
+		"Sliding sync (MSC3575)",
+	}
+};
+
+decltype(ircd::m::sync::sliding::method_post)
+ircd::m::sync::sliding::method_post
+{
+	resource, "POST", handle_post,
+	{
+		method_post.REQUIRES_AUTH
+	}
+};
+
+decltype(ircd::m::sync::sliding::notified)
+ircd::m::sync::sliding::notified
+{
+	handle_notify,
+	{
+		{ "_site",  "vm.notify" },
+	}
+};
+
+void
+ircd::m::sync::sliding::fini()
+noexcept
+{
+	for(const auto &[user_id, list] : list::map)
+		interrupt(list->dock);
+}
+
+ircd::m::resource::response
+ircd::m::sync::sliding::handle_post(client &client,
+                                    const resource::request &request)
+{
+	const json::object lists
+	{
+		request["lists"]
+	};
+
+	const json::object room_subscriptions
+	{
+		request["room_subscriptions"]
+	};
+
+	const json::string conn_id
+	{
+		request["conn_id"]
+	};
+
+	const auto since
+	{
+		request.query.get<event::idx>("pos", 0UL)
+	};
+
+	const milliseconds timeout
+	{
+		std::clamp
+		(
+			request.query.get("timeout", milliseconds(args::timeout_default)),
+			milliseconds(args::timeout_min),
+			milliseconds(args::timeout_max)
+		)
+	};
+
+	const auto device_id
+	{
+		m::user::tokens::device(request.access_token)
+	};
+
+	const string_view key_parts[]
+	{
+		request.user_id, " ", device_id, " ", conn_id,
+	};
+
+	std::string key;
+	for(const auto &part : key_parts)
+		key.append(ircd::data(part), ircd::size(part));
+
+	auto &list
+	{
+		acquire_list(request.user_id)
+	};
+
+	const unwind release_list{[&list]
+	{
+		assert(list.refs > 0);
+		--list.refs;
+	}};
+
+	auto &conn
+	{
+		acquire_conn(key, since)
+	};
+
+	const unwind release_conn{[&conn]
+	{
+		assert(conn.refs > 0);
+		--conn.refs;
+	}};
+
+	// The windows and the rooms to send are gathered without yielding so
+	// the list can't be reordered by the notify hook in the middle of it.
+	std::vector<window> windows;
+	std::vector<want> wants;
+	const auto compute{[&]
+	{
+		windows.clear();
+		wants.clear();
+
+		const auto consider{[&conn, &wants]
+		(const string_view &room_id, const json::object &opts, const event::idx &head)
+		{
+			const bool already
+			{
+				std::any_of(begin(wants), end(wants), [&room_id]
+				(const auto &want)
+				{
+					return want.room_id == room_id;
+				})
+			};
+
+			if(already)
+				return;
+
+			const auto it
+			{
+				conn.sent.find(room_id)
+			};
+
+			const event::idx sent
+			{
+				it != end(conn.sent)? it->second: 0UL
+			};
+
+			if(sent && head <= sent)
+				return;
+
+			wants.emplace_back(want
+			{
+				std::string(room_id), opts, sent
+			});
+		}};
+
+		size_t ranges(0);
+		bool changed(false);
+		for(const auto &[name, opts_] : lists)
+		{
+			const json::object opts{opts_};
+			for(const json::array range : json::array(opts["ranges"]))
+			{
+				if(ranges++ >= size_t(ranges_max))
+					break;
+
+				const size_t lo
+				{
+					range.at<size_t>(0)
+				};
+
+				const size_t hi
+				{
+					std::min(range.at<size_t>(1), lo + size_t(range_max) - 1)
+				};
+
+				auto &window
+				{
+					windows.emplace_back()
+				};
+
+				window.name = name;
+				window.range[0] = lo;
+				window.range[1] = hi;
+
+				auto it(begin(list.order));
+				for(size_t i(0); i < lo && it != end(list.order); ++i)
+					++it;
+
+				for(size_t i(lo); i <= hi && it != end(list.order); ++i, ++it)
+				{
+					const auto &[head, room_id] {*it};
+					window.room_ids.emplace_back(room_id);
+					consider(room_id, opts, head);
+				}
+
+				const auto sent
+				{
+					conn.windows.find(name)
+				};
+
+				changed |= sent == end(conn.windows) || sent->second != window.room_ids;
+			}
+		}
+
+		for(const auto &[room_id, opts] : room_subscriptions)
+		{
+			const auto it
+			{
+				list.rooms.find(room_id)
+			};
+
+			const event::idx head
+			{
+				it != end(list.rooms)?
+					it->second.order->first:
+					m::head_idx(std::nothrow, m::room::id(room_id))
+			};
+
+			consider(room_id, opts, head);
+		}
+
+		return !since || changed || !wants.empty();
+	}};
+
+	const auto deadline
+	{
+		now<system_point>() + timeout
+	};
+
+	while(!compute())
+	{
+		const auto version
+		{
+			list.version
+		};
+
+		const bool woken
+		{
+			list.dock.wait_until(deadline, [&list, &version]
+			{
+				return list.version != version;
+			})
+		};
+
+		if(!woken)
+			break;
+	}
+
+	const event::idx next
+	{
+		vm::sequence::retired
+	};
+
+	// Rooms the user can't view aren't sent even when subscribed to.
+	wants.erase(std::remove_if(begin(wants), end(wants), [&request]
+	(const auto &want)
+	{
+		return !m::membership(m::room::id(want.room_id), request.user_id, m::membership_positive);
+	}), end(wants));
+
+	m::resource::response::chunked::json response
+	{
+		client, http::OK
+	};
+
+	sync::data data
+	{
+		request.user_id,
+		m::events::range{0, next + 1},
+		&client,
+		&response.out,
+		nullptr,
+		nullptr,
+		device_id,
+	};
+
+	json::stack::member
+	{
+		response.top, "pos", json::value
+		{
+			lex_cast(next), json::STRING
+		}
+	};
+
+	// lists
+	{
+		json::stack::object lists_
+		{
+			response.top, "lists"
+		};
+
+		for(auto it(begin(windows)); it != end(windows); )
+		{
+			const auto &name(it->name);
+			json::stack::object list_
+			{
+				lists_, name
+			};
+
+			json::stack::member
+			{
+				list_, "count", json::value
+				{
+					long(list.order.size())
+				}
+			};
+
+			json::stack::array ops
+			{
+				list_, "ops"
+			};
+
+			for(; it != end(windows) && it->name == name; ++it)
+			{
+				json::stack::object op
+				{
+					ops
+				};
+
+				json::stack::member
+				{
+					op, "op", "SYNC"
+				};
+
+				{
+					json::stack::array range
+					{
+						op, "range"
+					};
+
+					range.append(json::value{long(it->range[0])});
+					range.append(json::value{long(it->range[1])});
+				}
+
+				json::stack::array room_ids
+				{
+					op, "room_ids"
+				};
+
+				for(const auto &room_id : it->room_ids)
+					room_ids.append(string_view{room_id});
+			}
+		}
+	}
+
+	// rooms
+	{
+		json::stack::object rooms_
+		{
+			response.top, "rooms"
+		};
+
+		for(const auto &want : wants)
+		{
+			const m::room room
+			{
+				m::room::id(want.room_id)
+			};
+
+			const scope_restore _room
+			{
+				data.room, &room
+			};
+
+			json::stack::object room_
+			{
+				rooms_, want.room_id
+			};
+
+			append_room(data, room_, want.opts, want.since);
+		}
+	}
+
+	for(const auto &want : wants)
+		conn.sent[want.room_id] = next;
+
+	conn.windows.clear();
+	for(auto &window : windows)
+		conn.windows[std::string(window.name)] = std::move(window.room_ids);
+
+	conn.pos = next;
+	return response;
+}
+
+void
+ircd::m::sync::sliding::append_room(data &data,
+                                    json::stack::object &object,
+                                    const json::object &opts,
+                                    const event::idx &since)
+{
+	assert(data.room);
+	const auto &room
+	{
+		*data.room
+	};
+
+	char membuf[32];
+	const scope_restore _membership
+	{
+		data.membership, m::membership(membuf, room, data.user)
+	};
+
+	const auto &[top_event_id, top_depth, top_event_idx]
+	{
+		m::top(std::nothrow, room)
+	};
+
+	const scope_restore _head
+	{
+		data.room_head, top_event_idx
+	};
+
+	const scope_restore _depth
+	{
+		data.room_depth, top_depth
+	};
+
+	const bool initial
+	{
+		!since
+	};
+
+	if(initial)
+		json::stack::member
+		{
+			object, "initial", json::value{true}
+		};
+
+	append_name(data, object, since);
+
+	if(initial)
+		append_required_state(data, object, opts["required_state"]);
+
+	const size_t limit
+	{
+		std::min(opts.get<size_t>("timeline_limit", 1UL), size_t(timeline_limit_max))
+	};
+
+	append_timeline(data, object, since, limit);
+	append_counts(data, object);
+}
+
+void
+ircd::m::sync::sliding::append_name(data &data,
+                                    json::stack::object &object,
+                                    const event::idx &since)
+{
+	assert(data.room);
+	const m::room::state state
+	{
+		*data.room
+	};
+
+	const auto event_idx
+	{
+		state.get(std::nothrow, "m.room.name", "")
+	};
+
+	if(!event_idx || event_idx <= since)
+		return;
+
+	m::get(std::nothrow, event_idx, "content", [&object]
+	(const json::object &content)
+	{
+		json::stack::member
+		{
+			object, "name", json::string
+			{
+				content["name"]
+			}
+		};
+	});
+}
+
+bool
+ircd::m::sync::sliding::append_required_state(data &data,
+                                              json::stack::object &object,
+                                              const json::array &required_state)
+{
+	assert(data.room);
+	const m::room::state state
+	{
+		*data.room
+	};
+
+	json::stack::array array
+	{
+		object, "required_state"
+	};
+
+	std::set<event::idx> sent;
+	m::event::fetch event;
+	const event::closure_idx append{[&data, &array, &sent, &event]
+	(const event::idx &event_idx)
+	{
+		if(!sent.emplace(event_idx).second)
+			return;
+
+		if(!seek(std::nothrow, event, event_idx))
+			return;
+
+		m::event::append::opts opts;
+		opts.event_idx = &event_idx;
+		opts.user_id = &data.user.user_id;
+		opts.user_room = &data.user_room;
+		opts.query_txnid = false;
+		opts.query_prev_state = false;
+		m::event::append(array, event, opts);
+	}};
+
+	for(const json::array pair : required_state)
+	{
+		const json::string type
+		{
+			pair[0]
+		};
+
+		const json::string state_key
+		{
+			pair[1]
+		};
+
+		if(type == "*" && state_key == "*")
+			state.for_each(append);
+
+		else if(state_key == "*")
+			state.for_each(type, append);
+
+		else if(state_key == "$ME")
+			state.get(std::nothrow, type, data.user.user_id, append);
+
+		else
+			state.get(std::nothrow, type, state_key, append);
+	}
+
+	return !sent.empty();
+}
+
+bool
+ircd::m::sync::sliding::append_timeline(data &data,
+                                        json::stack::object &object,
+                                        const event::idx &since,
+                                        const size_t &limit)
+{
+	assert(data.room);
+	std::vector<event::idx> idxs;
+	idxs.reserve(limit);
+
+	bool limited{false};
+	m::room::events it
+	{
+		*data.room
+	};
+
+	for(; it; --it)
+	{
+		const auto event_idx
+		{
+			it.event_idx()
+		};
+
+		if(event_idx >= data.range.second)
+			continue;
+
+		if(event_idx <= since)
+			break;
+
+		if(idxs.size() >= limit)
+		{
+			limited = true;
+			break;
+		}
+
+		idxs.emplace_back(event_idx);
+	}
+
+	// timeline
+	{
+		json::stack::array events
+		{
+			object, "timeline"
+		};
+
+		m::event::fetch event;
+		for(auto it(rbegin(idxs)); it != rend(idxs); ++it)
+		{
+			if(!seek(std::nothrow, event, *it))
+				continue;
+
+			m::event::append::opts opts;
+			opts.event_idx = &*it;
+			opts.client_txnid = &data.client_txnid;
+			opts.user_id = &data.user.user_id;
+			opts.user_room = &data.user_room;
+			opts.room_depth = &data.room_depth;
+			m::event::append(events, event, opts);
+		}
+	}
+
+	json::stack::member
+	{
+		object, "limited", json::value{limited}
+	};
+
+	const auto prev
+	{
+		limited && !idxs.empty()?
+			m::event_id(std::nothrow, idxs.back()):
+			m::event::id::buf{}
+	};
+
+	if(prev)
+		json::stack::member
+		{
+			object, "prev_batch", string_view{prev}
+		};
+
+	return !idxs.empty();
+}
+
+/// The counts come from the same items which provide them to /sync so both
+/// endpoints always agree.
+void
+ircd::m::sync::sliding::append_counts(data &data,
+                                      json::stack::object &object)
+{
+	append_item(data, "rooms.unread_notifications", [&object]
+	(const json::object &unread)
+	{
+		for(const auto &key : {"notification_count"_sv, "highlight_count"_sv})
+			json::stack::member
+			{
+				object, key, json::value
+				{
+					unread.get<long>(key, 0L)
+				}
+			};
+	});
+
+	append_item(data, "rooms.summary", [&object]
+	(const json::object &summary)
+	{
+		if(summary.has("m.joined_member_count"))
+			json::stack::member
+			{
+				object, "joined_count", summary["m.joined_member_count"]
+			};
+
+		if(summary.has("m.invited_member_count"))
+			json::stack::member
+			{
+				object, "invited_count", summary["m.invited_member_count"]
+			};
+	});
+}
+
+/// Runs the polylog handler of the named /sync item for data.room into a
+/// private json::stack and gives the closure what it wrote. Nothing is given
+/// if the item isn't loaded, is disabled, or overflows the buffer.
+bool
+ircd::m::sync::sliding::append_item(data &data,
+                                    const string_view &name,
+                                    const item_closure &closure)
+{
+	bool ret{false};
+	m::sync::for_each("rooms", [&data, &name, &closure, &ret]
+	(item &item)
+	{
+		if(item.name() != name)
+			return true;
+
+		const unique_mutable_buffer buf
+		{
+			4_KiB
+		};
+
+		json::stack out
+		{
+			buf
+		};
+
+		const scope_restore _out
+		{
+			data.out, &out
+		};
+
+		{
+			json::stack::object top
+			{
+				out
+			};
+
+			json::stack::object object
+			{
+				out, item.member_name()
+			};
+
+			ret = item.polylog(data);
+		}
+
+		if(!ret || out.failed())
+			return false;
+
+		const json::object completed
+		{
+			out.completed()
+		};
+
+		closure(completed[item.member_name()]);
+		return false;
+	});
+
+	return ret;
+}
+
+void
+ircd::m::sync::sliding::handle_notify(const m::event &event,
+                                      m::vm::eval &eval)
+try
+{
+	assert(eval.opts);
+	if(!eval.opts->notify_clients)
+		return;
+
+	if(!event.event_id || !eval.sequence)
+		return;
+
+	const auto &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	if(!room_id)
+		return;
+
+	// Membership of a user with a list adds the room to it or removes it.
+	if(json::get<"type"_>(event) == "m.room.member")
+	{
+		const auto it
+		{
+			list::map.find(json::get<"state_key"_>(event))
+		};
+
+		if(it != end(list::map))
+		{
+			auto &list(*it->second);
+			if(m::membership(event, m::membership_positive))
+				list.set(room_id, eval.sequence);
+			else
+				list.erase(room_id);
+		}
+	}
+
+	// Every other list holding the room moves it to the front; they're
+	// gathered first because set() replaces their entry in the index.
+	std::vector<list *> lists;
+	const auto pit
+	{
+		list::index.equal_range(room_id)
+	};
+
+	for(auto it(pit.first); it != pit.second; ++it)
+		lists.emplace_back(it->second);
+
+	for(auto *const &list : lists)
+		list->set(room_id, eval.sequence);
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "sliding sync notify %s :%s",
+		string_view{event.event_id},
+		e.what(),
+	};
+}
+
+ircd::m::sync::sliding::list &
+ircd::m::sync::sliding::acquire_list(const m::user::id &user_id)
+{
+	auto it
+	{
+		list::map.find(user_id)
+	};
+
+	if(it != end(list::map))
+	{
+		auto &list(*it->second);
+		++list.refs;
+		list.used = now<system_point>();
+		list.dock.wait([&list]
+		{
+			return list.ready;
+		});
+
+		return list;
+	}
+
+	// Evict the least recently used list no request holds.
+	if(list::map.size() >= size_t(lists_max))
+	{
+		auto lru(end(list::map));
+		for(auto it(begin(list::map)); it != end(list::map); ++it)
+			if(!it->second->refs)
+				if(lru == end(list::map) || it->second->used < lru->second->used)
+					lru = it;
+
+		if(lru != end(list::map))
+			list::map.erase(lru);
+	}
+
+	it = list::map.emplace(std::string(user_id), std::make_unique<list>(user_id)).first;
+	auto &list(*it->second);
+	++list.refs;
+
+	// The list is in the map while it's built so membership changes during
+	// the build are applied; set() keeps whichever index is newer.
+	const unwind ready{[&list]
+	{
+		list.ready = true;
+		list.dock.notify_all();
+	}};
+
+	const m::user::rooms rooms
+	{
+		user_id
+	};
+
+	for(const auto &membership : {"join"_sv, "invite"_sv})
+		rooms.for_each(membership, m::user::rooms::closure_bool{[&list, &user_id]
+		(const m::room &room, const string_view &)
+		{
+			list.set(room.room_id, recency(room, user_id));
+			return true;
+		}});
+
+	return list;
+}
+
+ircd::m::sync::sliding::conn &
+ircd::m::sync::sliding::acquire_conn(const string_view &key,
+                                     const event::idx &since)
+{
+	auto it
+	{
+		conn::map.find(key)
+	};
+
+	// A pos which isn't the one last given to this connection can't be
+	// resumed; the client is told to start over.
+	if(since && (it == end(conn::map) || it->second.pos != since))
+		throw m::error
+		{
+			http::BAD_REQUEST, "M_UNKNOWN_POS",
+			"Unknown position; start a new connection."
+		};
+
+	if(it == end(conn::map) && conn::map.size() >= size_t(conns_max))
+	{
+		auto lru(end(conn::map));
+		for(auto it(begin(conn::map)); it != end(conn::map); ++it)
+			if(!it->second.refs)
+				if(lru == end(conn::map) || it->second.used < lru->second.used)
+					lru = it;
+
+		if(lru != end(conn::map))
+			conn::map.erase(lru);
+	}
+
+	if(it == end(conn::map))
+		it = conn::map.emplace(std::string(key), conn{}).first;
+
+	auto &conn(it->second);
+	if(!since)
+	{
+		conn.sent.clear();
+		conn.windows.clear();
+	}
+
+	++conn.refs;
+	conn.used = now<system_point>();
+	return conn;
+}
+
+/// An invite to a room without any timeline here is ordered by the invite.
+ircd::m::event::idx
+ircd::m::sync::sliding::recency(const m::room &room,
+                                const m::user::id &user_id)
+{
+	const m::room::state state
+	{
+		room
+	};
+
+	return std::max
+	(
+		m::head_idx(std::nothrow, room.room_id),
+		state.get(std::nothrow, "m.room.member", user_id)
+	);
+}
+
+//
+// list
+//
+
+ircd::m::sync::sliding::list::list(const m::user::id &user_id)
+:user_id
+{
+	user_id
+}
+,used
+{
+	now<system_point>()
+}
+{
+}
+
+ircd::m::sync::sliding::list::~list()
+noexcept
+{
+	for(const auto &[room_id, cell] : rooms)
+		index.erase(cell.index);
+}
+
+bool
+ircd::m::sync::sliding::list::set(const string_view &room_id_,
+                                  const event::idx &event_idx)
+{
+	// The argument may view the key of the cell being replaced.
+	const std::string room_id
+	{
+		room_id_
+	};
+
+	const auto it
+	{
+		rooms.find(room_id)
+	};
+
+	if(it != end(rooms))
+	{
+		if(it->second.order->first >= event_idx)
+			return false;
+
+		const auto cell(it->second);
+		rooms.erase(it);
+		index.erase(cell.index);
+		order.erase(cell.order);
+	}
+
+	const auto order_it
+	{
+		order.emplace(event_idx, room_id).first
+	};
+
+	const string_view key
+	{
+		order_it->second
+	};
+
+	const auto index_it
+	{
+		index.emplace(key, this)
+	};
+
+	rooms.emplace(key, cell{order_it, index_it});
+	++version;
+	dock.notify_all();
+	return true;
+}
+
+bool
+ircd::m::sync::sliding::list::erase(const string_view &room_id)
+{
+	const auto it
+	{
+		rooms.find(room_id)
+	};
+
+	if(it == end(rooms))
+		return false;
+
+	const auto cell(it->second);
+	rooms.erase(it);
+	index.erase(cell.index);
+	order.erase(cell.order);
+	++version;
+	dock.notify_all();
+	return true;
+}
@@ -12,12 +12,15 @@
 namespace ircd::m::sync
 {
 	struct response;
+	struct latency;
+	struct latency_scope;
 
 	static const_buffer flush(data &, resource::response::chunked &, const const_buffer &);
 	static bool empty_response(data &, const uint64_t &next_batch);
 	static bool linear_handle(data &);
 	static bool polylog_handle(data &);
 	static bool longpoll_handle(data &);
+	static bool event_keys(const m::event &, string_view (&)[3]);
 	static resource::response handle_get(client &, const resource::request &);
 
 	extern conf::item<size_t> flush_hiwat;
@@ -27,17 +30,101 @@ namespace ircd::m::sync
 	extern conf::item<bool> longpoll_enable;
 	extern conf::item<bool> polylog_phased;
 	extern conf::item<bool> polylog_only;
+	extern conf::item<bool> polylog_snapshot;
 	extern conf::item<bool> MSC2855;
 	extern conf::item<std::string> pause;
 
 	extern resource::method method_get;
 	extern const string_view description;
 	extern resource resource;
+
+	static const http::header response_headers[]
+	{
+		{ "Cache-Control", "no-cache" },
+	};
+}
+
+/// Latency histogram for one sync mode. Buckets are cumulative powers of two
+/// in milliseconds in the manner of a prometheus histogram; a sample counts
+/// toward every bucket at or above its duration.
+struct ircd::m::sync::latency
+{
+	static constexpr const size_t BUCKETS {16};
+
+	std::string name;
+	ircd::stats::item<uint64_t> count;
+	ircd::stats::item<uint64_t> total_us;
+	std::vector<std::unique_ptr<ircd::stats::item<uint64_t>>> bucket;
+
+	void operator()(const microseconds &) noexcept;
+
+	latency(const string_view &mode);
+};
+
+/// Times the enclosing scope into a latency histogram.
+struct ircd::m::sync::latency_scope
+{
+	latency &hist;
+	ircd::timer timer;
+
+	latency_scope(latency &hist) noexcept
+	:hist{hist}
+	{}
+
+	~latency_scope() noexcept
+	{
+		hist(timer.at<microseconds>());
+	}
+};
+
+namespace ircd::m::sync
+{
+	extern latency polylog_latency;
+	extern latency linear_latency;
+	extern latency longpoll_latency;
 }
 
 namespace ircd::m::sync::longpoll
 {
+	static void park(client &, const data &, std::set<event::idx> hits = {});
+	static void fini() noexcept;
+
+	extern conf::item<bool> park_enable;
+}
+
+namespace ircd::m::sync::snapshot
+{
+	struct capture;
+
+	static bool serve(data &, resource::response::chunked &);
+
+	extern conf::item<bool> enable;
+}
+
+/// Accumulates the flushed output of one sync.
+struct ircd::m::sync::snapshot::capture
+{
+	std::string key;
+	std::string buf;
+	event::idx sequence {0};
+	bool complete {false};
+
+	void operator()(const const_buffer &) noexcept;
+
+	capture(const data &, const bool &eligible);
+	capture(capture &&) = delete;
+	capture(const capture &) = delete;
+	~capture() noexcept;
+};
+
+namespace ircd::m::sync::stream
+{
+	static bool covers(const m::events::range &) noexcept;
+	static bool for_each(data &, const m::events::closure &);
 	static void fini() noexcept;
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> delta_max;
 }
 
 ircd::mapi::header
@@ -45,6 +132,7 @@ IRCD_MODULE
 {
 	"Client 6.2.1 :Sync", nullptr, []
 	{
+		ircd::m::sync::stream::fini();
 		ircd::m::sync::longpoll::fini();
 	}
 };
@@ -145,6 +233,20 @@ ircd::m::sync::polylog_only
 	{ "default",  false                           },
 };
 
+decltype(ircd::m::sync::polylog_snapshot)
+ircd::m::sync::polylog_snapshot
+{
+	{ "name",     "ircd.client.sync.polylog.snapshot" },
+	{ "default",  true                                },
+	{ "description",
+
+	R"(
+	Pin a database snapshot for the duration of a polylog sync. Iterations
+	over the rooms then skip events retired after the sync began without
+	reading them, and every item observes the same view of the database.
+	)"},
+};
+
 decltype(ircd::m::sync::longpoll_enable)
 ircd::m::sync::longpoll_enable
 {
@@ -282,17 +384,79 @@ ircd::m::sync::handle_get(client &client,
 		)
 	};
 
-	static const http::header response_headers[]
+	// Pre-determine if longpoll sync mode should be used. This may
+	// indicate false now but after conducting a linear or even polylog
+	// sync if we don't find any events for the client then we might
+	// longpoll later.
+	const bool should_longpoll
 	{
-		{ "Cache-Control", "no-cache" },
+		// longpoll can be disabled by a conf item (for developers).
+		longpoll_enable
+
+		// polylog-phased sync and longpoll are totally exclusive.
+		&& !data.phased
+
+		// initial_sync cannot hang on a longpoll otherwise bad things clients
+		&& !initial_sync
+
+		// When the since token is in advance of the vm sequence number
+		// there's no events to consider for a sync.
+		&& range.first > vm::sequence::retired
+
+		// Spec sez that when ?full_state=1 to return immediately, so
+		// that rules out longpoll
+		&& !args.full_state
 	};
 
+	// A longpoll is parked here rather than holding this context while the
+	// client waits; the response is made later on another context by
+	// longpoll::resumed().
+	const bool should_park
+	{
+		should_longpoll
+		&& longpoll::park_enable
+		&& !paused
+		&& !invalid_since
+		&& int64_t(args.next_batch) <= 0
+		&& !iequals(request.head.connection, "close"_sv)
+	};
+
+	if(should_park)
+	{
+		longpoll::park(client, data);
+		return {};
+	}
+
 	// Start the chunked encoded response.
 	resource::response::chunked response
 	{
 		client, http::OK, response_headers, buffer_size
 	};
 
+	// A repeat of a non-phased initial sync can be satisfied by the last
+	// response to the same user, device and filter; the client then catches
+	// up from its next_batch with an incremental sync.
+	const bool snapshot_eligible
+	{
+		snapshot::enable
+		&& initial_sync
+		&& !data.phased
+		&& !paused
+		&& !invalid_since
+		&& !args.full_state
+		&& !args.semaphore
+		&& !request.query["next_batch"]
+	};
+
+	if(snapshot_eligible && snapshot::serve(data, response))
+		return std::move(response);
+
+	// Retains the output of an eligible polylog to serve the next repeat.
+	snapshot::capture capture
+	{
+		data, snapshot_eligible
+	};
+
 	// Start the JSON stream for this response. As the sync items are iterated
 	// the supplied response buffer will be flushed out to the supplied
 	// callback; in this case, both are provided by the chunked encoding
@@ -302,7 +466,16 @@ ircd::m::sync::handle_get(client &client,
 	json::stack out
 	{
 		response.buf,
-		std::bind(sync::flush, std::ref(data), std::ref(response), ph::_1),
+		[&data, &response, &capture](const const_buffer &buffer)
+		{
+			const auto wrote
+			{
+				sync::flush(data, response, buffer)
+			};
+
+			capture(wrote);
+			return wrote;
+		},
 		size_t(flush_hiwat)
 	};
 	data.out = &out;
@@ -312,30 +485,6 @@ ircd::m::sync::handle_get(client &client,
 		log, "request %s", loghead(data)
 	};
 
-	// Pre-determine if longpoll sync mode should be used. This may
-	// indicate false now but after conducting a linear or even polylog
-	// sync if we don't find any events for the client then we might
-	// longpoll later.
-	const bool should_longpoll
-	{
-		// longpoll can be disabled by a conf item (for developers).
-		longpoll_enable
-
-		// polylog-phased sync and longpoll are totally exclusive.
-		&& !data.phased
-
-		// initial_sync cannot hang on a longpoll otherwise bad things clients
-		&& !initial_sync
-
-		// When the since token is in advance of the vm sequence number
-		// there's no events to consider for a sync.
-		&& range.first > vm::sequence::retired
-
-		// Spec sez that when ?full_state=1 to return immediately, so
-		// that rules out longpoll
-		&& !args.full_state
-	};
-
 	// Determine if linear sync mode should be used. If this is not used, and
 	// longpoll mode is not used, then polylog mode must be used.
 	const bool should_linear
@@ -351,8 +500,14 @@ ircd::m::sync::handle_get(client &client,
 
 		// The primary condition for a linear sync is the number of events
 		// in the range being considered by the sync. That threshold is
-		// supplied by a conf item.
-		&& range.second - range.first <= size_t(linear_delta_max)
+		// supplied by a conf item. When the stream index covers the range
+		// only the user's events are visited, so the threshold is larger.
+		&& range.second - range.first <=
+		(
+			stream::covers(range)?
+				size_t(stream::delta_max):
+				size_t(linear_delta_max)
+		)
 
 		// When the semaphore query param is set we don't need linear mode.
 		&& !args.semaphore
@@ -387,13 +542,22 @@ ircd::m::sync::handle_get(client &client,
 		ctx::sleep_until(data.args->timesout);
 
 	if(!complete && should_polylog)
-		complete = polylog_handle(data);
+	{
+		const latency_scope timed{polylog_latency};
+		capture.complete = complete = polylog_handle(data);
+	}
 
 	if(!complete && should_linear)
+	{
+		const latency_scope timed{linear_latency};
 		complete = linear_handle(data);
+	}
 
 	if(!complete)
+	{
+		const latency_scope timed{longpoll_latency};
 		complete = longpoll_handle(data);
+	}
 
 	if(!complete || invalid_since || paused)
 		complete = empty_response(data, uint64_t
@@ -414,6 +578,73 @@ ircd::m::sync::handle_get(client &client,
 	return std::move(response);
 }
 
+//
+// latency
+//
+
+decltype(ircd::m::sync::polylog_latency)
+ircd::m::sync::polylog_latency
+{
+	"polylog"
+};
+
+decltype(ircd::m::sync::linear_latency)
+ircd::m::sync::linear_latency
+{
+	"linear"
+};
+
+decltype(ircd::m::sync::longpoll_latency)
+ircd::m::sync::longpoll_latency
+{
+	"longpoll"
+};
+
+ircd::m::sync::latency::latency(const string_view &mode)
+:name
+{
+	fmt::snstringf{64, "ircd.client.sync.%s.latency", mode}
+}
+,count
+{
+	{ "name", name + ".count" },
+}
+,total_us
+{
+	{ "name", name + ".total_us" },
+}
+{
+	bucket.reserve(BUCKETS + 1);
+	for(size_t i(0); i < BUCKETS; ++i)
+		bucket.emplace_back(std::make_unique<ircd::stats::item<uint64_t>>(json::members
+		{
+			{ "name", fmt::snstringf{96, "%s.le_%zums", name, 1UL << i} },
+		}));
+
+	bucket.emplace_back(std::make_unique<ircd::stats::item<uint64_t>>(json::members
+	{
+		{ "name", name + ".le_inf" },
+	}));
+}
+
+void
+ircd::m::sync::latency::operator()(const microseconds &dur)
+noexcept
+{
+	const auto us
+	{
+		uint64_t(std::max(dur.count(), 0L))
+	};
+
+	++count;
+	total_us += us;
+	for(size_t i(0); i < BUCKETS; ++i)
+		if(us <= (1000UL << i))
+			++*bucket[i];
+
+	++*bucket.back();
+}
+
 bool
 ircd::m::sync::empty_response(data &data,
                               const uint64_t &next_batch)
@@ -466,101 +697,1129 @@ ircd::m::sync::empty_response(data &data,
 		next_batch,
 	};
 
-	return true;
-}
-
-ircd::const_buffer
-ircd::m::sync::flush(data &data,
-                     resource::response::chunked &response,
-                     const const_buffer &buffer)
-{
-	assert(size(buffer) <= size(response.buf));
-	const auto wrote
+	return true;
+}
+
+ircd::const_buffer
+ircd::m::sync::flush(data &data,
+                     resource::response::chunked &response,
+                     const const_buffer &buffer)
+{
+	assert(size(buffer) <= size(response.buf));
+	const auto wrote
+	{
+		response.flush(buffer)
+	};
+
+	assert(size(wrote) <= size(buffer));
+	if(data.stats)
+	{
+		data.stats->flush_bytes += size(wrote);
+		data.stats->flush_count++;
+	}
+
+	return wrote;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// snapshot
+//
+
+// Cache of the most recent non-phased initial sync for a user, device and
+// filter. Since tokens are stateless: a response composed at sequence S is
+// a valid reply to a later initial sync as long as the client can catch up
+// from S with a cheap linear-sync, so the entry is served only while the
+// distance from S to the present is within the linear threshold. The device
+// is part of the key because the response contains its to-device messages.
+// Entries are evicted least-recently-used beyond the memory budget.
+
+namespace ircd::m::sync::snapshot
+{
+	struct entry
+	{
+		std::shared_ptr<const std::string> content;
+		event::idx sequence {0};
+	};
+
+	using lru_type = std::list<std::pair<std::string, entry>>;
+	using map_type = std::map<string_view, lru_type::iterator, std::less<>>;
+
+	static std::string make_key(const data &);
+	static bool fresh(const entry &, const m::events::range &) noexcept;
+	static void erase(const map_type::iterator &) noexcept;
+	static void put(std::string key, entry) noexcept;
+
+	extern conf::item<size_t> budget;
+	extern conf::item<size_t> size_max;
+	extern lru_type lru;
+	extern map_type map;
+	extern size_t bytes;
+}
+
+decltype(ircd::m::sync::snapshot::enable)
+ircd::m::sync::snapshot::enable
+{
+	{ "name",     "ircd.client.sync.snapshot.enable" },
+	{ "default",  true                               },
+	{ "help",     "Serve repeat initial syncs from the last response." },
+};
+
+decltype(ircd::m::sync::snapshot::budget)
+ircd::m::sync::snapshot::budget
+{
+	{ "name",     "ircd.client.sync.snapshot.budget" },
+	{ "default",  long(64_MiB)                       },
+	{ "help",     "Memory retained for all snapshots." },
+};
+
+decltype(ircd::m::sync::snapshot::size_max)
+ircd::m::sync::snapshot::size_max
+{
+	{ "name",     "ircd.client.sync.snapshot.size.max" },
+	{ "default",  long(8_MiB)                          },
+	{ "help",     "Responses larger than this are not retained." },
+};
+
+decltype(ircd::m::sync::snapshot::lru)
+ircd::m::sync::snapshot::lru;
+
+decltype(ircd::m::sync::snapshot::map)
+ircd::m::sync::snapshot::map;
+
+decltype(ircd::m::sync::snapshot::bytes)
+ircd::m::sync::snapshot::bytes;
+
+bool
+ircd::m::sync::snapshot::serve(data &data,
+                               resource::response::chunked &response)
+{
+	const auto it
+	{
+		map.find(make_key(data))
+	};
+
+	if(it == end(map))
+		return false;
+
+	if(!fresh(it->second->second, data.range))
+	{
+		erase(it);
+		return false;
+	}
+
+	lru.splice(begin(lru), lru, it->second);
+
+	// Held for the duration of the write; the entry might be evicted or
+	// replaced while this context yields to the socket.
+	const auto content
+	{
+		it->second->second.content
+	};
+
+	const auto sequence
+	{
+		it->second->second.sequence
+	};
+
+	const const_buffer buf
+	{
+		*content
+	};
+
+	for(size_t off(0); off < size(buf); )
+	{
+		const const_buffer chunk
+		{
+			ircd::data(buf) + off, std::min(size(buf) - off, size(response.buf))
+		};
+
+		const auto wrote
+		{
+			sync::flush(data, response, chunk)
+		};
+
+		if(unlikely(empty(wrote)))
+			break;
+
+		off += size(wrote);
+	}
+
+	log::debug
+	{
+		log, "request %s snapshot @%lu %zu bytes",
+		loghead(data),
+		sequence,
+		size(buf),
+	};
+
+	return true;
+}
+
+bool
+ircd::m::sync::snapshot::fresh(const entry &entry,
+                               const m::events::range &range)
+noexcept
+{
+	if(entry.sequence > range.second)
+		return false;
+
+	const m::events::range delta
+	{
+		entry.sequence, range.second
+	};
+
+	return range.second - entry.sequence <=
+	(
+		stream::covers(delta)?
+			size_t(stream::delta_max):
+			size_t(linear_delta_max)
+	);
+}
+
+void
+ircd::m::sync::snapshot::put(std::string key,
+                             entry entry)
+noexcept try
+{
+	const auto it
+	{
+		map.find(key)
+	};
+
+	if(it != end(map))
+		erase(it);
+
+	bytes += entry.content->size();
+	lru.emplace_front(std::move(key), std::move(entry));
+	map.emplace(lru.front().first, begin(lru));
+
+	while(bytes > size_t(budget) && !lru.empty())
+		erase(map.find(lru.back().first));
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "snapshot :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::m::sync::snapshot::erase(const map_type::iterator &it)
+noexcept
+{
+	assert(it != end(map));
+	const auto lit
+	{
+		it->second
+	};
+
+	assert(bytes >= lit->second.content->size());
+	bytes -= lit->second.content->size();
+	map.erase(it);
+	lru.erase(lit);
+}
+
+std::string
+ircd::m::sync::snapshot::make_key(const data &data)
+{
+	assert(data.args);
+	const string_view parts[]
+	{
+		data.user.user_id, " ", data.device_id, " ", data.args->filter_id,
+	};
+
+	std::string ret;
+	for(const auto &part : parts)
+		ret.append(ircd::data(part), ircd::size(part));
+
+	return ret;
+}
+
+//
+// snapshot::capture
+//
+
+ircd::m::sync::snapshot::capture::capture(const data &data,
+                                          const bool &eligible)
+:key
+{
+	eligible?
+		make_key(data):
+		std::string{}
+}
+,sequence
+{
+	data.range.second
+}
+{
+}
+
+ircd::m::sync::snapshot::capture::~capture()
+noexcept
+{
+	if(!complete || key.empty() || buf.empty())
+		return;
+
+	// The final flush might not have reached the client.
+	if(!json::valid(buf, std::nothrow))
+		return;
+
+	put(std::move(key), entry
+	{
+		std::make_shared<const std::string>(std::move(buf)), sequence
+	});
+}
+
+void
+ircd::m::sync::snapshot::capture::operator()(const const_buffer &wrote)
+noexcept try
+{
+	if(key.empty())
+		return;
+
+	if(buf.size() + size(wrote) > size_t(size_max))
+	{
+		key.clear();
+		buf = {};
+		return;
+	}
+
+	buf.append(ircd::data(wrote), size(wrote));
+}
+catch(...)
+{
+	key.clear();
+	buf = {};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// longpoll
+//
+
+namespace ircd::m::sync
+{
+	// fwd decl as longpoll is a frontend to a linear-sync.
+	static size_t linear_proffer_event(data &, const mutable_buffer &);
+}
+
+namespace ircd::m::sync::longpoll
+{
+	struct interest;
+	struct parked;
+
+	static bool polled(data &, const args &);
+	static int poll(data &, interest &);
+	static bool resumed(client &, const std::shared_ptr<parked> &);
+	static void park_worker();
+	static void replica_worker();
+	static event::idx horizon() noexcept;
+	static event::idx timedout(const data &, const args &);
+	static size_t notify_interest(const m::event &, const event::idx &);
+	static void handle_notify(const m::event &, m::vm::eval &);
+	static void fini() noexcept;
+
+	extern conf::item<bool> interest_enable;
+	extern conf::item<size_t> interest_rooms_max;
+	extern m::hookfn<m::vm::eval &> notified;
+	extern ctx::dock park_dock;
+	extern context park_context;
+	extern context replica_context;
+}
+
+/// Subscription of one longpolling /sync to the events which can possibly
+/// be relevant to it. Rather than waking every longpoller for every event
+/// retired by the vm, the notify handler looks up the keys of the event in
+/// the index and only wakes the interests registered under them. The keys
+/// are the room_id's the user is joined or invited to, the user's own
+/// user room, and the user's mxid (for membership events targeting them).
+///
+/// Keys are a conservative superset of what the linear handlers will accept;
+/// false positives only cost a linear proffer which rejects the event. An
+/// interest configured with `everything` is woken for all events, which is
+/// the legacy behavior.
+struct ircd::m::sync::longpoll::interest
+:instance_list<interest>
+{
+	using index_type = std::multimap<string_view, interest *, std::less<>>;
+
+	static index_type index;
+	static std::set<interest *> deferred;
+
+	const m::events::range &range;
+	ctx::dock dock;
+	std::set<event::idx> hits;
+	std::vector<std::string> keys;
+	std::vector<index_type::iterator> its;
+	event::idx registered {0};
+	bool everything {false};
+	parked *park {nullptr};
+
+	bool ready() const noexcept;
+	void wake() noexcept;
+	void hit(const event::idx &) noexcept;
+
+	interest(const m::user::id &, const m::events::range &);
+	interest(interest &&) = delete;
+	interest(const interest &) = delete;
+	~interest() noexcept;
+};
+
+/// A longpoll which is not holding a context. The state of the request is
+/// saved here and the client's context is released back to the request pool.
+/// The interest wakes this object rather than a dock; the park worker then
+/// resumes the client on the request pool to continue where poll() would,
+/// either when the interest is ready or when the timeout is reached.
+struct ircd::m::sync::longpoll::parked
+{
+	using map_type = std::map<const ircd::client *, std::shared_ptr<parked>>;
+	using deadlines_type = std::multimap<system_point, parked *>;
+
+	static map_type map;
+	static deadlines_type deadlines;
+	static std::deque<parked *> queue;
+
+	std::shared_ptr<ircd::client> client;
+	std::string filter_id;
+	std::string since_flags;
+	sync::args args;
+	m::user::id::buf user_id;
+	device::id::buf device_id;
+	m::events::range range;
+	deadlines_type::iterator deadline;
+	std::unique_ptr<longpoll::interest> interest;
+	bool queued {false};
+
+	void wake() noexcept;
+
+	static void clear() noexcept;
+
+	parked(ircd::client &, const sync::data &);
+	parked(parked &&) = delete;
+	parked(const parked &) = delete;
+};
+
+decltype(ircd::m::sync::longpoll::parked::map)
+ircd::m::sync::longpoll::parked::map;
+
+decltype(ircd::m::sync::longpoll::parked::deadlines)
+ircd::m::sync::longpoll::parked::deadlines;
+
+decltype(ircd::m::sync::longpoll::parked::queue)
+ircd::m::sync::longpoll::parked::queue;
+
+decltype(ircd::m::sync::longpoll::park_dock)
+ircd::m::sync::longpoll::park_dock;
+
+decltype(ircd::m::sync::longpoll::park_context)
+ircd::m::sync::longpoll::park_context
+{
+	"m.sync.park",
+	256_KiB,
+	&park_worker,
+	context::POST
+};
+
+/// Events are not evaluated on a read replica (secondary), so the notify
+/// hook is never called; this context notifies the interests for the events
+/// found when the secondary catches up with the primary instead.
+decltype(ircd::m::sync::longpoll::replica_context)
+ircd::m::sync::longpoll::replica_context
+{
+	"m.sync.replica",
+	256_KiB,
+	&replica_worker,
+	context::POST
+};
+
+template<>
+decltype(ircd::instance_list<ircd::m::sync::longpoll::interest>::allocator)
+ircd::instance_list<ircd::m::sync::longpoll::interest>::allocator
+{};
+
+template<>
+decltype(ircd::instance_list<ircd::m::sync::longpoll::interest>::list)
+ircd::instance_list<ircd::m::sync::longpoll::interest>::list
+{
+	allocator
+};
+
+decltype(ircd::m::sync::longpoll::interest::index)
+ircd::m::sync::longpoll::interest::index;
+
+decltype(ircd::m::sync::longpoll::interest::deferred)
+ircd::m::sync::longpoll::interest::deferred;
+
+decltype(ircd::m::sync::longpoll::interest_enable)
+ircd::m::sync::longpoll::interest_enable
+{
+	{ "name",     "ircd.client.sync.longpoll.interest.enable" },
+	{ "default",  true                                        },
+	{ "help",     "Only wake longpolls for events in their rooms." },
+};
+
+decltype(ircd::m::sync::longpoll::interest_rooms_max)
+ircd::m::sync::longpoll::interest_rooms_max
+{
+	{ "name",     "ircd.client.sync.longpoll.interest.rooms.max" },
+	{ "default",  long(16384)                                    },
+	{ "help",     "Users with more rooms than this wake for every event." },
+};
+
+decltype(ircd::m::sync::longpoll::park_enable)
+ircd::m::sync::longpoll::park_enable
+{
+	{ "name",     "ircd.client.sync.longpoll.park.enable" },
+	{ "default",  false                                   },
+	{ "help",     "Release the context of an idle longpoll until it is woken." },
+};
+
+decltype(ircd::m::sync::longpoll::notified)
+ircd::m::sync::longpoll::notified
+{
+	handle_notify,
+	{
+		{ "_site",  "vm.notify" },
+	}
+};
+
+void
+ircd::m::sync::longpoll::fini()
+noexcept
+{
+	if(!interest::list.empty())
+		log::warning
+		{
+			log, "Interrupting %zu longpolling clients...",
+			interest::list.size(),
+		};
+
+	for(auto *const &interest : interest::list)
+		if(!interest->park)
+			interrupt(interest->dock);
+
+	replica_context.terminate();
+	replica_context.join();
+	park_context.terminate();
+	park_context.join();
+	parked::clear();
+}
+
+void
+ircd::m::sync::longpoll::handle_notify(const m::event &event,
+                                       m::vm::eval &eval)
+try
+{
+	assert(eval.opts);
+	if(!eval.opts->notify_clients)
+		return;
+
+	// Interests which were hit by an event which had not yet retired
+	// (i.e. a child eval notifying before its parent retires) are woken
+	// again now that the sequence may have advanced.
+	for(auto it(begin(interest::deferred)); it != end(interest::deferred); )
+		if((*it)->ready())
+		{
+			(*it)->wake();
+			it = interest::deferred.erase(it);
+		}
+		else ++it;
+
+	// EDU's are not available to the linear handlers, which only
+	// see events retired to the database.
+	if(!event.event_id || !eval.sequence)
+		return;
+
+	notify_interest(event, eval.sequence);
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "request %s longpoll notify :%s",
+		loghead(eval),
+		e.what(),
+	};
+}
+
+void
+ircd::m::sync::longpoll::replica_worker()
+try
+{
+	if(!dbs::events || !dbs::events->slave)
+		return;
+
+	event::idx last
+	{
+		vm::sequence::retired
+	};
+
+	while(1)
+	{
+		vm::sequence::dock.wait([&last]
+		{
+			return vm::sequence::retired > last;
+		});
+
+		const event::idx retired
+		{
+			vm::sequence::retired
+		};
+
+		for(auto it(begin(interest::deferred)); it != end(interest::deferred); )
+			if((*it)->ready())
+			{
+				(*it)->wake();
+				it = interest::deferred.erase(it);
+			}
+			else ++it;
+
+		for(event::idx event_idx(last + 1); event_idx <= retired; ++event_idx)
+		{
+			const m::event::fetch event
+			{
+				std::nothrow, event_idx
+			};
+
+			if(event.valid)
+				notify_interest(event, event_idx);
+		}
+
+		last = retired;
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "replica notify worker :%s",
+		e.what(),
+	};
+}
+
+/// Keys of the event which might match the key of an interest; these are
+/// also the keys of the linear stream index. Typing and receipts are stored
+/// in the sender's user room and target the room found in their content or
+/// state_key respectively. Unused keys are left empty. Returns false for
+/// events in another user's room which are broadcast to everyone sharing a
+/// room with that user; we can't cheaply determine those recipients.
+bool
+ircd::m::sync::event_keys(const m::event &event,
+                          string_view (&keys)[3])
+{
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	const bool broadcast
+	{
+		type == "ircd.presence"
+		|| startswith(type, "ircd.device")
+	};
+
+	if(broadcast)
+		return false;
+
+	keys[0] = json::get<"room_id"_>(event);
+
+	keys[1] = type == "m.room.member" || type == "ircd.read"?
+		string_view{json::get<"state_key"_>(event)}:
+		string_view{};
+
+	keys[2] = type == "ircd.typing"?
+		string_view{json::string(json::get<"content"_>(event).get("room_id"))}:
+		string_view{};
+
+	return true;
+}
+
+/// Wake the interests which may care about the event. Returns the number of
+/// interests notified.
+size_t
+ircd::m::sync::longpoll::notify_interest(const m::event &event,
+                                         const event::idx &event_idx)
+{
+	string_view event_key[3];
+	const bool broadcast
+	{
+		!event_keys(event, event_key)
+	};
+
+	size_t ret(0);
+	const auto wake{[&ret, &event_idx]
+	(interest &interest)
+	{
+		interest.hit(event_idx);
+		ret += interest.ready();
+	}};
+
+	if(broadcast)
+	{
+		for(auto *const &interest : interest::list)
+			wake(*interest);
+
+		return ret;
+	}
+
+	// Interests wanting everything are indexed under the empty key.
+	const string_view keys[]
+	{
+		string_view{}, event_key[0], event_key[1], event_key[2],
+	};
+
+	for(size_t i(0); i < size(keys); ++i)
+	{
+		if(i && !keys[i])
+			continue;
+
+		auto it(interest::index.lower_bound(keys[i]));
+		for(; it != end(interest::index) && it->first == keys[i]; ++it)
+			wake(*it->second);
+	}
+
+	return ret;
+}
+
+/// The since token for a longpoll which timed out without anything of
+/// interest: one past the notify horizon, limited to the next_batch the
+/// client asked for when it gave one.
+ircd::m::event::idx
+ircd::m::sync::longpoll::timedout(const data &data,
+                                  const args &args)
+{
+	const auto since
+	{
+		horizon() + 1
+	};
+
+	return std::clamp
+	(
+		since,
+		data.range.second,
+		std::max(args.next_batch?: since, data.range.second)
+	);
+}
+
+/// The highest event::idx for which all events at or below have been both
+/// retired and offered to the notify hook. Events beyond this might still
+/// notify an interest which is not yet aware of them.
+ircd::m::event::idx
+ircd::m::sync::longpoll::horizon()
+noexcept
+{
+	event::idx ret
+	{
+		vm::sequence::retired
+	};
+
+	vm::eval::for_each([&ret]
+	(const vm::eval &eval)
+	{
+		const bool notifying
+		{
+			eval.sequence != 0
+			&& eval.sequence <= ret
+			&& eval.phase < vm::phase::EFFECTS
+		};
+
+		if(notifying)
+			ret = eval.sequence - 1;
+
+		return true;
+	});
+
+	return ret;
+}
+
+//
+// interest::interest
+//
+
+ircd::m::sync::longpoll::interest::interest(const m::user::id &user_id,
+                                            const m::events::range &range)
+:range{range}
+,everything
+{
+	!interest_enable
+}
+{
+	const auto add{[this]
+	(const string_view &key)
+	{
+		keys.emplace_back(key);
+		return keys.size() <= size_t(interest_rooms_max);
+	}};
+
+	if(!everything)
+	{
+		const m::user user
+		{
+			user_id
+		};
+
+		const m::user::room user_room
+		{
+			user
+		};
+
+		const m::user::rooms user_rooms
+		{
+			user
+		};
+
+		add(user.user_id);
+		add(user_room.room_id);
+		for(const auto &membership : {"join"_sv, "invite"_sv})
+			user_rooms.for_each(membership, m::user::rooms::closure_bool{[&add]
+			(const m::room &room, const string_view &)
+			{
+				return add(room.room_id);
+			}});
+	}
+
+	// Interests wanting everything are indexed under the empty key.
+	if(keys.size() > size_t(interest_rooms_max))
+		everything = true;
+
+	if(everything)
+		keys.assign(1, std::string{});
+
+	// The keys are never modified after this point.
+	its.reserve(keys.size());
+	for(const auto &key : keys)
+		its.emplace_back(index.emplace(key, this));
+
+	// Any yields during the rooms iteration have to be covered by the
+	// sequential scan up to here.
+	registered = vm::sequence::retired;
+}
+
+ircd::m::sync::longpoll::interest::~interest()
+noexcept
+{
+	for(const auto &it : its)
+		index.erase(it);
+
+	deferred.erase(this);
+}
+
+void
+ircd::m::sync::longpoll::interest::hit(const event::idx &event_idx)
+noexcept
+{
+	if(event_idx < range.second)
+		return;
+
+	hits.emplace(event_idx);
+	if(ready())
+		wake();
+	else
+		deferred.emplace(this);
+}
+
+void
+ircd::m::sync::longpoll::interest::wake()
+noexcept
+{
+	if(park)
+		park->wake();
+	else
+		dock.notify();
+}
+
+/// True when the lowest unconsumed hit has been retired and can be fetched
+/// from the database.
+bool
+ircd::m::sync::longpoll::interest::ready()
+const noexcept
+{
+	return !hits.empty()
+	&& *begin(hits) <= vm::sequence::retired;
+}
+
+//
+// parked
+//
+
+ircd::m::sync::longpoll::parked::parked(ircd::client &client,
+                                        const sync::data &data)
+:client
+{
+	shared_from(client)
+}
+,filter_id
+{
+	data.args->filter_id
+}
+,since_flags
+{
+	std::get<2>(data.args->since)
+}
+,args
+{
+	*data.args
+}
+,user_id
+{
+	data.user.user_id
+}
+,device_id
+{
+	data.device_id
+}
+,range
+{
+	data.range
+}
+{
+	// The views in the args are repointed to the copies owned here.
+	args.filter_id = filter_id;
+	std::get<2>(args.since) = since_flags;
+}
+
+void
+ircd::m::sync::longpoll::parked::wake()
+noexcept
+{
+	if(queued)
+		return;
+
+	queued = true;
+	queue.emplace_back(this);
+	park_dock.notify();
+}
+
+void
+ircd::m::sync::longpoll::parked::clear()
+noexcept
+{
+	if(!map.empty())
+		log::warning
+		{
+			log, "Closing %zu parked longpolling clients...",
+			map.size(),
+		};
+
+	for(const auto &[client, parked] : map)
+		parked->client->close(net::dc::SSL_NOTIFY, net::close_ignore);
+
+	queue.clear();
+	deadlines.clear();
+	map.clear();
+}
+
+/// Save the longpoll on the stack of data into a parked object and register
+/// its interest. The client is marked as parked so it isn't put back into async
+/// mode when the request handler returns without a response.
+void
+ircd::m::sync::longpoll::park(client &client,
+                              const data &data,
+                              std::set<event::idx> hits)
+{
+	assert(data.args);
+	assert(!client.parked);
+	auto parked
+	{
+		std::make_shared<longpoll::parked>(client, data)
+	};
+
+	parked->interest = std::make_unique<interest>(parked->user_id, parked->range);
+	parked->interest->park = parked.get();
+	parked->interest->hits = std::move(hits);
+	parked->deadline = parked::deadlines.emplace(parked->args.timesout, parked.get());
+	parked::map.emplace(&client, parked);
+	client.parked = true;
+
+	log::debug
+	{
+		log, "request %s parked @%lu",
+		loghead(data),
+		parked->range.second,
+	};
+
+	// Events which retired while the interest was being registered have to
+	// be scanned by resumed(), and any hits carried over which weren't yet
+	// retired still have to be woken when they are.
+	auto &interest(*parked->interest);
+	if(parked->range.second <= interest.registered || interest.ready())
+		parked->wake();
+	else if(!interest.hits.empty())
+		interest::deferred.emplace(&interest);
+
+	park_dock.notify();
+}
+
+/// Executes on a request context when a parked longpoll is resumed. This acts
+/// as poll() but without waiting: events of interest are proffered, and if
+/// nothing was relevant and time remains the longpoll is parked again.
+bool
+ircd::m::sync::longpoll::resumed(client &client,
+                                 const std::shared_ptr<parked> &parked)
+{
+	assert(parked->interest);
+	auto &interest(*parked->interest);
+	auto &args(parked->args);
+	const latency_scope timed
+	{
+		longpoll_latency
+	};
+
+	sync::stats stats;
+	sync::data data
+	{
+		parked->user_id,
+		parked->range,
+		&client,
+		nullptr,
+		&stats,
+		&args,
+		parked->device_id,
+	};
+
+	// The response is only started on the first flush. Nothing is written to
+	// the client if the longpoll ends up parked again.
+	std::optional<resource::response::chunked> response;
+	const unique_buffer<mutable_buffer> buf
 	{
-		response.flush(buffer)
+		size_t(buffer_size)
 	};
 
-	assert(size(wrote) <= size(buffer));
-	if(data.stats)
+	json::stack out
 	{
-		data.stats->flush_bytes += size(wrote);
-		data.stats->flush_count++;
-	}
+		buf, [&data, &response, &client, &buf]
+		(const const_buffer &buffer)
+		{
+			if(!response)
+				response.emplace(client, http::OK, response_headers, 0UL, buf);
 
-	return wrote;
-}
+			return sync::flush(data, *response, buffer);
+		},
+		size_t(flush_hiwat)
+	};
+	data.out = &out;
 
-///////////////////////////////////////////////////////////////////////////////
-//
-// longpoll
-//
+	auto &hits(interest.hits);
+	while(1)
+	{
+		hits.erase(begin(hits), hits.lower_bound(data.range.second));
+		const bool ready
+		{
+			data.range.second <= interest.registered || interest.ready()
+		};
 
-namespace ircd::m::sync
-{
-	// fwd decl as longpoll is a frontend to a linear-sync.
-	static size_t linear_proffer_event(data &, const mutable_buffer &);
-}
+		if(!ready)
+			break;
 
-namespace ircd::m::sync::longpoll
-{
-	static bool polled(data &, const args &);
-	static int poll(data &);
-	static void handle_notify(const m::event &, m::vm::eval &);
-	static void fini() noexcept;
+		if(data.range.second > interest.registered && !hits.empty())
+			data.range.second = std::clamp
+			(
+				horizon() + 1,
+				data.range.second,
+				*begin(hits)
+			);
 
-	extern m::hookfn<m::vm::eval &> notified;
-	extern ctx::dock dock;
-}
+		if(client.sock)
+			net::check(*client.sock);
+
+		if(polled(data, args))
+			return true;
 
-decltype(ircd::m::sync::longpoll::dock)
-ircd::m::sync::longpoll::dock;
+		data.range.second = std::min(data.range.second + 1, vm::sequence::retired + 1);
+	}
 
-decltype(ircd::m::sync::longpoll::notified)
-ircd::m::sync::longpoll::notified
-{
-	handle_notify,
+	parked->range = data.range;
+	if(ircd::now<system_point>() < args.timesout)
 	{
-		{ "_site",  "vm.notify" },
+		parked->queued = false;
+		parked->deadline = parked::deadlines.emplace(args.timesout, parked.get());
+		parked::map.emplace(&client, parked);
+		client.parked = true;
+		if(interest.ready())
+			parked->wake();
+
+		park_dock.notify();
+		return true;
 	}
-};
 
+	data.range.second = timedout(data, args);
+	return empty_response(data, data.range.second);
+}
+
+/// Dedicated context which resumes parked longpolls on the request pool when
+/// they are woken by their interest or reach their timeout.
 void
-ircd::m::sync::longpoll::fini()
-noexcept
+ircd::m::sync::longpoll::park_worker()
+try
 {
-	if(!dock.empty())
-		log::warning
+	const auto earliest{[]
+	{
+		return !parked::deadlines.empty()?
+			begin(parked::deadlines)->first:
+			ircd::now<system_point>() + 1h;
+	}};
+
+	while(1)
+	{
+		const auto until
 		{
-			log, "Interrupting %zu longpolling clients...",
-			dock.size(),
+			earliest()
 		};
 
-	interrupt(dock);
-}
+		park_dock.wait_until(until, [&earliest, &until]
+		{
+			return !parked::queue.empty() || earliest() < until;
+		});
 
-void
-ircd::m::sync::longpoll::handle_notify(const m::event &event,
-                                       m::vm::eval &eval)
-try
-{
-	assert(eval.opts);
-	if(!eval.opts->notify_clients)
-		return;
+		const auto now
+		{
+			ircd::now<system_point>()
+		};
+
+		auto it(begin(parked::deadlines));
+		for(; it != end(parked::deadlines) && it->first <= now; ++it)
+			it->second->wake();
+
+		while(!parked::queue.empty())
+		{
+			auto *const p(parked::queue.front());
+			parked::queue.pop_front();
+
+			auto node
+			{
+				parked::map.extract(p->client.get())
+			};
+
+			assert(!node.empty());
+			parked::deadlines.erase(p->deadline);
+			std::shared_ptr<parked> parked
+			{
+				std::move(node.mapped())
+			};
 
-	dock.notify_all();
+			auto client(parked->client);
+			ircd::client::resume(std::move(client), [parked(std::move(parked))]
+			(ircd::client &client)
+			{
+				return resumed(client, parked);
+			});
+		}
+	}
 }
 catch(const ctx::interrupted &)
 {
-	throw;
-}
-catch(const std::exception &e)
-{
-	log::critical
-	{
-		log, "request %s longpoll notify :%s",
-		loghead(eval),
-		e.what(),
-	};
+	return;
 }
 
 /// Longpolling blocks the client's request until a relevant event is processed
@@ -569,8 +1828,13 @@ bool
 ircd::m::sync::longpoll_handle(data &data)
 try
 {
+	longpoll::interest interest
+	{
+		data.user.user_id, data.range
+	};
+
 	int ret;
-	while((ret = longpoll::poll(data)) == -1)
+	while((ret = longpoll::poll(data, interest)) == -1)
 	{
 		// When the client explicitly gives a next_batch token we have to
 		// adhere to it and return an empty response before going past their
@@ -610,10 +1874,11 @@ catch(const std::exception &e)
 	throw;
 }
 
-/// When the vm's sequence number is incremented our dock is notified and the
-/// event at that next sequence number is fetched. That event gets proffered
-/// around the linear sync handlers for whether it's relevant to the user
-/// making the request on this stack.
+/// When an event of interest is retired our dock is notified and the event
+/// at that sequence number is fetched. That event gets proffered around the
+/// linear sync handlers for whether it's relevant to the user making the
+/// request on this stack. Events which retired before the interest was
+/// registered are proffered sequentially as before.
 ///
 /// If relevant, we respond immediately with that one event and finish the
 /// request right there, providing them the next since token of one-past the
@@ -621,8 +1886,8 @@ catch(const std::exception &e)
 ///
 /// If not relevant, we send nothing and continue checking events that come
 /// through until the timeout. This will be an empty response providing the
-/// client with the next since token of one past where we left off (vm's
-/// current sequence number) to start the next /sync.
+/// client with the next since token of one past where we left off (the
+/// notify horizon) to start the next /sync.
 ///
 /// @returns
 /// - true if a relevant event was hit and output to the client. If so, this
@@ -633,28 +1898,49 @@ catch(const std::exception &e)
 /// has been sent to the client yet here either.
 ///
 int
-ircd::m::sync::longpoll::poll(data &data)
+ircd::m::sync::longpoll::poll(data &data,
+                              interest &interest)
 {
-	const auto ready{[&data]
+	// Discard hits which the range has already passed.
+	auto &hits(interest.hits);
+	hits.erase(begin(hits), hits.lower_bound(data.range.second));
+
+	const auto ready{[&data, &interest]
 	{
 		assert(data.range.second <= m::vm::sequence::retired + 1);
-		return data.range.second <= m::vm::sequence::retired;
+		return data.range.second <= interest.registered || interest.ready();
 	}};
 
 	assert(data.args);
-	if(!dock.wait_until(data.args->timesout, ready))
+	if(!interest.dock.wait_until(data.args->timesout, ready))
+	{
+		// Nothing of interest was retired up to the horizon; the client can
+		// skip all of it on their next request.
+		data.range.second = timedout(data, *data.args);
 		return false;
+	}
+
+	// Skip ahead to the first hit, but not past any event which might not
+	// have notified the interest yet.
+	if(data.range.second > interest.registered && !hits.empty())
+		data.range.second = std::clamp
+		(
+			horizon() + 1,
+			data.range.second,
+			*begin(hits)
+		);
 
 	// Check if client went away while we were sleeping,
 	// if so, just returning true is the easiest way out w/o throwing
-	assert(data.client && data.client->sock);
-	if(unlikely(!data.client || !data.client->sock))
+	assert(data.client);
+	if(unlikely(!data.client))
 		return true;
 
 	// slightly more involved check of the socket before
 	// we waste resources on the operation; throws.
 	const auto &client(*data.client);
-	net::check(*client.sock);
+	if(client.sock)
+		net::check(*client.sock);
 
 	// Keep in mind if the handler returns true that means
 	// it made a hit and we can return true to exit longpoll
@@ -810,10 +2096,13 @@ try
 		*data.out
 	};
 
-	const unique_buffer<mutable_buffer> buf
+	// Drawn from the client's request arena; a client syncing over a
+	// persistent connection reuses the same block for each request.
+	assert(data.client);
+	const mutable_buffer buf
 	{
 		// must be at least worst-case size of m::event plus some.
-		std::max(size_t(linear_buffer_size), size_t(128_KiB))
+		data.client->arena(std::max(size_t(linear_buffer_size), size_t(128_KiB)))
 	};
 
 	window_buffer wb{buf};
@@ -943,7 +2232,9 @@ ircd::m::sync::linear_proffer(data &data,
 
 	const auto completed
 	{
-		m::events::for_each(data.range, closure)
+		stream::covers(data.range)?
+			stream::for_each(data, closure):
+			m::events::for_each(data.range, closure)
 	};
 
 	return
@@ -1005,6 +2296,335 @@ ircd::m::sync::linear_proffer_event_one(data &data)
 	return ret;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// linear stream
+//
+
+// Index of recently retired events by the keys which make them relevant to
+// a user (see event_keys()). A linear-sync covered by the index only visits
+// the events found under the keys of its user rather than every event on the
+// server in the range. The index is fed by a worker tailing the retired
+// sequence rather than the notify hook, so it is complete between its floor
+// and the indexed counter no matter how the events were evaluated; whatever
+// remains of a range beyond the indexed counter is scanned as before.
+
+namespace ircd::m::sync::stream
+{
+	using map_type = std::map<std::string, std::deque<event::idx>, std::less<>>;
+
+	static void push(const string_view &key, const event::idx &);
+	static void index(const m::event &, const event::idx &);
+	static void trim() noexcept;
+	static void worker();
+
+	extern conf::item<size_t> events_max;
+	extern conf::item<size_t> rooms_max;
+	extern map_type map;
+	extern event::idx floor;
+	extern event::idx indexed;
+	extern event::idx swept;
+	extern context worker_context;
+}
+
+decltype(ircd::m::sync::stream::enable)
+ircd::m::sync::stream::enable
+{
+	{ "name",     "ircd.client.sync.linear.stream.enable" },
+	{ "default",  true                                    },
+	{ "help",     "Visit only the user's events during a linear-sync." },
+};
+
+decltype(ircd::m::sync::stream::delta_max)
+ircd::m::sync::stream::delta_max
+{
+	{ "name",     "ircd.client.sync.linear.stream.delta.max" },
+	{ "default",  10240                                      },
+	{ "help",     "Replaces linear.delta.max when the range is indexed." },
+};
+
+decltype(ircd::m::sync::stream::events_max)
+ircd::m::sync::stream::events_max
+{
+	{ "name",     "ircd.client.sync.linear.stream.events.max" },
+	{ "default",  long(131072)                                },
+	{ "help",     "Number of the most recent events kept in the index." },
+};
+
+decltype(ircd::m::sync::stream::rooms_max)
+ircd::m::sync::stream::rooms_max
+{
+	{ "name",     "ircd.client.sync.linear.stream.rooms.max" },
+	{ "default",  long(4096)                                 },
+	{ "help",     "Users with more rooms than this scan every event." },
+};
+
+decltype(ircd::m::sync::stream::map)
+ircd::m::sync::stream::map;
+
+decltype(ircd::m::sync::stream::floor)
+ircd::m::sync::stream::floor;
+
+decltype(ircd::m::sync::stream::indexed)
+ircd::m::sync::stream::indexed;
+
+decltype(ircd::m::sync::stream::swept)
+ircd::m::sync::stream::swept;
+
+decltype(ircd::m::sync::stream::worker_context)
+ircd::m::sync::stream::worker_context
+{
+	"m.sync.stream",
+	256_KiB,
+	&worker,
+	context::POST
+};
+
+void
+ircd::m::sync::stream::fini()
+noexcept
+{
+	worker_context.terminate();
+	worker_context.join();
+	map.clear();
+}
+
+/// The index can satisfy the range if every event from its start has been
+/// retained and the remainder past the indexed counter is no more than
+/// would be scanned by a linear-sync anyway.
+bool
+ircd::m::sync::stream::covers(const m::events::range &range)
+noexcept
+{
+	const size_t tail
+	{
+		range.second > indexed + 1?
+			range.second - indexed - 1:
+			0UL
+	};
+
+	return true
+	&& enable
+	&& range.first <= range.second
+	&& range.first > floor
+	&& tail <= size_t(linear_delta_max)
+	;
+}
+
+/// Visits the events in the range found under the keys of the user in
+/// ascending order, followed by every event past the indexed counter.
+/// Falls back to visiting every event in the range if the user has too
+/// many rooms or the start of the range was trimmed from the index.
+bool
+ircd::m::sync::stream::for_each(data &data,
+                                const m::events::closure &closure)
+{
+	const auto &range
+	{
+		data.range
+	};
+
+	// Events indexed while yielding to the rooms iteration are later than
+	// this and are left for the scan of the tail.
+	const event::idx snapshot
+	{
+		indexed
+	};
+
+	size_t keys(0);
+	std::vector<event::idx> idxs;
+	const auto gather{[&range, &snapshot, &keys, &idxs]
+	(const string_view &key)
+	{
+		const auto it
+		{
+			map.find(key)
+		};
+
+		if(it != end(map))
+		{
+			const auto &queue(it->second);
+			auto jt(std::lower_bound(begin(queue), end(queue), range.first));
+			for(; jt != end(queue) && *jt < range.second && *jt <= snapshot; ++jt)
+				idxs.emplace_back(*jt);
+		}
+
+		return ++keys <= size_t(rooms_max);
+	}};
+
+	// Broadcast events are indexed under the empty key.
+	gather(string_view{});
+	gather(data.user.user_id);
+	gather(data.user_room.room_id);
+	for(const auto &membership : {"join"_sv, "invite"_sv, "leave"_sv})
+		data.user_rooms.for_each(membership, m::user::rooms::closure_bool{[&gather]
+		(const m::room &room, const string_view &)
+		{
+			return gather(room.room_id);
+		}});
+
+	if(keys > size_t(rooms_max) || range.first <= floor)
+		return m::events::for_each(range, closure);
+
+	// An event can be found under more than one key.
+	std::sort(begin(idxs), end(idxs));
+	idxs.erase(std::unique(begin(idxs), end(idxs)), end(idxs));
+
+	event::fetch event
+	{
+		range.fopts? *range.fopts : event::fetch::default_opts
+	};
+
+	for(const auto &event_idx : idxs)
+		if(seek(std::nothrow, event, event_idx))
+			if(!closure(event_idx, event))
+				return false;
+
+	const m::events::range tail
+	{
+		std::max(range.first, snapshot + 1), range.second, range.fopts
+	};
+
+	return tail.first >= tail.second
+		|| m::events::for_each(tail, closure);
+}
+
+void
+ircd::m::sync::stream::worker()
+try
+{
+	floor = indexed = swept = vm::sequence::retired;
+
+	// Typing is the only event where the content is involved in a key; it
+	// is refetched for that rather than selecting the content of every event.
+	static const event::fetch::opts fopts
+	{
+		event::keys::include {"room_id", "type", "state_key"}
+	};
+
+	event::fetch event
+	{
+		fopts
+	};
+
+	while(1)
+	{
+		vm::sequence::dock.wait([]
+		{
+			return vm::sequence::retired > indexed;
+		});
+
+		const event::idx retired
+		{
+			vm::sequence::retired
+		};
+
+		for(event::idx event_idx(indexed + 1); event_idx <= retired; ++event_idx)
+		{
+			if(!seek(std::nothrow, event, event_idx))
+			{
+				indexed = event_idx;
+				continue;
+			}
+
+			if(json::get<"type"_>(event) == "ircd.typing")
+			{
+				const m::event::fetch full
+				{
+					std::nothrow, event_idx
+				};
+
+				if(full.valid)
+					index(full, event_idx);
+			}
+			else index(event, event_idx);
+
+			indexed = event_idx;
+		}
+
+		trim();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "linear stream worker :%s",
+		e.what(),
+	};
+}
+
+void
+ircd::m::sync::stream::index(const m::event &event,
+                             const event::idx &event_idx)
+{
+	string_view keys[3];
+	if(!event_keys(event, keys))
+		return push(string_view{}, event_idx);
+
+	for(const auto &key : keys)
+		if(key)
+			push(key, event_idx);
+}
+
+void
+ircd::m::sync::stream::push(const string_view &key,
+                            const event::idx &event_idx)
+{
+	auto it
+	{
+		map.lower_bound(key)
+	};
+
+	if(it == end(map) || it->first != key)
+		it = map.emplace_hint(it, std::string{key}, std::deque<event::idx>{});
+
+	auto &queue(it->second);
+	while(!queue.empty() && queue.front() <= floor)
+		queue.pop_front();
+
+	// The same event can't be keyed twice under one key; the sequence is
+	// only ever visited in ascending order.
+	if(queue.empty() || queue.back() < event_idx)
+		queue.emplace_back(event_idx);
+}
+
+/// Raises the floor to retain the configured number of events. Queues are
+/// trimmed when they are pushed to; the rest are swept here periodically.
+void
+ircd::m::sync::stream::trim()
+noexcept
+{
+	const event::idx max
+	{
+		std::max(size_t(events_max), 1UL)
+	};
+
+	if(indexed - floor > max)
+		floor = indexed - max;
+
+	if(floor - swept < max / 4)
+		return;
+
+	for(auto it(begin(map)); it != end(map); )
+	{
+		auto &queue(it->second);
+		while(!queue.empty() && queue.front() <= floor)
+			queue.pop_front();
+
+		if(queue.empty())
+			it = map.erase(it);
+		else
+			++it;
+	}
+
+	swept = floor;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // polylog
@@ -1024,6 +2644,10 @@ bool
 ircd::m::sync::polylog_handle(data &data)
 try
 {
+	std::optional<db::database::snapshot::pin> snapshot;
+	if(polylog_snapshot)
+		snapshot.emplace(*dbs::events);
+
 	json::stack::checkpoint checkpoint
 	{
 		*data.out
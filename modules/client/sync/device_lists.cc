@@ -10,6 +10,7 @@
 
 namespace ircd::m::sync
 {
+	static bool device_lists_polylog_members(data &);
 	static bool device_lists_polylog(data &);
 	static bool device_lists_linear(data &);
 
@@ -38,7 +39,7 @@ ircd::m::sync::device_lists_linear(data &data)
 
 	assert(data.event);
 	const m::event &event{*data.event};
-	if(!startswith(json::get<"type"_>(event), "ircd.device"))
+	if(!m::user::devices::changes(event))
 		return false;
 
 	const m::user sender
@@ -84,6 +85,94 @@ ircd::m::sync::device_lists_polylog(data &data)
 	if(!data.range.first)
 		return false;
 
-	//TODO: XXX
-	return false;
+	if(!m::user::devices::changes_complete(data.range.first))
+		return device_lists_polylog_members(data);
+
+	std::set<std::string, std::less<>> users;
+	m::user::devices::for_each_change(data.range.first, [&data, &users]
+	(const auto &event_idx, const auto &user_id)
+	{
+		if(event_idx >= data.range.second)
+			return false;
+
+		users.emplace(user_id);
+		return true;
+	});
+
+	if(users.empty())
+		return false;
+
+	// The membership check yields, so it is done once the stream is left.
+	const m::user::mitsein mitsein
+	{
+		data.user
+	};
+
+	bool ret{false};
+	std::optional<json::stack::array> changed;
+	for(const auto &user_id : users)
+	{
+		if(!mitsein.has(m::user::id(user_id), "join"))
+			continue;
+
+		if(!changed)
+			changed.emplace(*data.out, "changed");
+
+		changed->append(string_view{user_id});
+		ret = true;
+	}
+
+	return ret;
+}
+
+/// When the stream of changes doesn't reach back to the since token, the
+/// user room of every co-member is searched for a device event in the range
+/// instead. This visits everyone the user shares a room with, so it is only
+/// taken for tokens older than anything the stream has kept.
+bool
+ircd::m::sync::device_lists_polylog_members(data &data)
+{
+	const m::user::mitsein mitsein
+	{
+		data.user
+	};
+
+	std::optional<json::stack::array> changed;
+	mitsein.for_each("join", [&data, &changed]
+	(const m::user &user)
+	{
+		const m::user::room user_room
+		{
+			user
+		};
+
+		const m::room::type events
+		{
+			user_room, "ircd.device.", { -1UL, -1L }, true
+		};
+
+		bool found {false};
+		events.for_each([&data, &found]
+		(const string_view &type, const uint64_t &depth, const event::idx &event_idx)
+		{
+			if(event_idx < data.range.first || event_idx >= data.range.second)
+				return true;
+
+			m::event event;
+			json::get<"type"_>(event) = type;
+			found = m::user::devices::changes(event);
+			return !found;
+		});
+
+		if(!found)
+			return true;
+
+		if(!changed)
+			changed.emplace(*data.out, "changed");
+
+		changed->append(user.user_id);
+		return true;
+	});
+
+	return bool(changed);
 }
@@ -46,20 +46,11 @@ ircd::m::sync::device_one_time_keys_count_linear(data &data)
 	if(!data.event || !data.event->event_id)
 		return false;
 
-	if(!startswith(json::get<"type"_>(*data.event), "ircd.device.one_time_key"))
-		return false;
-
-	if(json::get<"state_key"_>(*data.event) != data.device_id)
-		return false;
-
+	// One-time keys are not events; their counts are read from the column
+	// for any event to the user's room.
 	if(json::get<"room_id"_>(*data.event) != data.user_room)
 		return false;
 
-	const json::object &one_time_keys
-	{
-		json::get<"content"_>(*data.event)
-	};
-
 	json::stack::object object
 	{
 		*data.out, "device_one_time_keys_count"
@@ -13,6 +13,7 @@ namespace ircd::m::sync
 	static bool presence_polylog(data &);
 	static bool presence_linear(data &);
 
+	extern conf::item<size_t> presence_changed_max;
 	extern item presence;
 }
 
@@ -30,6 +31,16 @@ ircd::m::sync::presence
 	presence_linear,
 };
 
+/// An incremental sync takes the users whose presence changed in its range
+/// from the in-memory table and tests each against the mitsein; beyond this
+/// many it iterates the mitsein instead.
+decltype(ircd::m::sync::presence_changed_max)
+ircd::m::sync::presence_changed_max
+{
+	{ "name",     "ircd.client.sync.presence.changed.max" },
+	{ "default",  512L                                    },
+};
+
 bool
 ircd::m::sync::presence_linear(data &data)
 {
@@ -162,33 +173,75 @@ ircd::m::sync::presence_polylog(data &data)
 		};
 	}};
 
-	// Setup for concurrentization.
+	// Setup for concurrentization. Whether a user is sent is decided from
+	// the in-memory presence table; content is only fetched for those.
 	static const size_t fibers(64);
 	sync::pool.min(fibers);
 	ctx::concurrent<std::string> concurrent
 	{
 		sync::pool, [&data, &append_event](std::string user_id)
 		{
-			const event::idx event_idx
-			{
-				m::presence::get(std::nothrow, m::user::id{user_id})
-			};
+			m::presence::cell cell;
+			if(!m::presence::get(std::nothrow, m::user::id{user_id}, cell))
+				return;
+
+			if(!apropos(data, cell.event_idx))
+				return;
 
-			if(!apropos(data, event_idx))
+			if(data.range.first == 0 && cell.offline() && !cell.status_msg)
 				return;
 
-			m::get(std::nothrow, event_idx, "content", append_event);
+			m::get(std::nothrow, cell.event_idx, "content", append_event);
 		}
 	};
 
-	// Iterate all of the users visible to our user in joined rooms.
-	const m::user::mitsein mitsein{data.user};
-	mitsein.for_each("join", [&concurrent]
-	(const m::user &user)
+	const m::user::mitsein mitsein
+	{
+		data.user
+	};
+
+	// For an incremental sync the table has every user whose presence
+	// changed since the token (when the token is above its floor); these
+	// are usually far fewer than the users visible to our user.
+	std::vector<std::string> changed;
+	bool use_changed
 	{
-		concurrent(std::string(user.user_id));
-		return true;
-	});
+		!data.phased
+		&& data.range.first > 0
+		&& m::presence::complete(data.range.first)
+	};
+
+	if(use_changed)
+		m::presence::for_each(data.range.first, [&data, &changed, &use_changed]
+		(const m::user::id &user_id, const m::presence::cell &cell)
+		{
+			if(cell.event_idx >= data.range.second)
+				return false;
+
+			if(changed.size() >= size_t(presence_changed_max))
+				return use_changed = false;
+
+			changed.emplace_back(user_id);
+			return true;
+		});
+
+	if(use_changed)
+		for(auto &user_id : changed)
+		{
+			if(!mitsein.has(m::user::id(user_id), "join"))
+				continue;
+
+			concurrent(std::move(user_id));
+		}
+
+	// Iterate all of the users visible to our user in joined rooms.
+	if(!use_changed)
+		mitsein.for_each("join", [&concurrent]
+		(const m::user &user)
+		{
+			concurrent(std::string(user.user_id));
+			return true;
+		});
 
 	const ctx::uninterruptible ui;
 	concurrent.wait();
@@ -13,12 +13,15 @@ namespace ircd::m::sync
 	static bool should_ignore(const data &);
 
 	static bool _rooms_polylog_room(data &, const m::room &);
+	static bool _rooms_polylog_concurrent(data &, json::stack::object &);
 	static bool _rooms_polylog(data &, const string_view &membership, int64_t &phase);
 	static bool rooms_polylog(data &);
 
 	static bool _rooms_linear(data &, const string_view &membership);
 	static bool rooms_linear(data &);
 
+	extern conf::item<size_t> polylog_concurrency;
+	extern conf::item<size_t> polylog_buffer_size;
 	extern item rooms;
 }
 
@@ -38,6 +41,22 @@ ircd::m::sync::rooms
 	}
 };
 
+decltype(ircd::m::sync::polylog_concurrency)
+ircd::m::sync::polylog_concurrency
+{
+	{ "name",     "ircd.client.sync.rooms.polylog.concurrency" },
+	{ "default",  16L                                          },
+	{ "help",     "Rooms in flight at once for a non-phased polylog sync." },
+};
+
+decltype(ircd::m::sync::polylog_buffer_size)
+ircd::m::sync::polylog_buffer_size
+{
+	{ "name",     "ircd.client.sync.rooms.polylog.buffer_size" },
+	{ "default",  long(256_KiB)                                },
+	{ "help",     "Room output larger than this is redone sequentially." },
+};
+
 bool
 ircd::m::sync::rooms_linear(data &data)
 {
@@ -174,6 +193,11 @@ ircd::m::sync::_rooms_polylog(data &data,
 		*data.out, membership
 	};
 
+	// The phased sync stops after the first room with output, and prefetch
+	// only initiates reads; neither benefits from the fan-out.
+	if(!data.phased && !data.prefetch && size_t(polylog_concurrency) > 1)
+		return _rooms_polylog_concurrent(data, object);
+
 	bool ret{false};
 	const user::rooms::closure_bool closure{[&data, &ret, &phase]
 	(const m::room &room, const string_view &membership_)
@@ -228,6 +252,121 @@ ircd::m::sync::_rooms_polylog(data &data,
 	return ret;
 }
 
+/// Each room is composed by a worker on the sync::pool into a private buffer
+/// with its own fork of the sync::data, overlapping the database latency of
+/// many rooms. A completed room is spliced into the membership object as
+/// soon as it's ready; the order of rooms in the response is insignificant.
+/// A room which overflowed its buffer is redone on the main output after
+/// the others finish.
+bool
+ircd::m::sync::_rooms_polylog_concurrent(data &data,
+                                         json::stack::object &object)
+{
+	const size_t max
+	{
+		polylog_concurrency
+	};
+
+	// Room handlers fan out on this pool as well (i.e. rooms.state), so it
+	// must have workers beyond those occupied by rooms or they deadlock.
+	sync::pool.min(max * 2);
+
+	bool ret{false};
+	ctx::mutex mutex;
+	const ctx::prof::lock::label mutex_label
+	{
+		&mutex, "client.sync.rooms"
+	};
+
+	std::vector<std::string> overflow;
+	ctx::concurrent<std::string> concurrent
+	{
+		sync::pool, [&data, &object, &ret, &mutex, &overflow]
+		(std::string room_id)
+		{
+			const m::room room
+			{
+				m::room::id{room_id}
+			};
+
+			const unique_mutable_buffer buf
+			{
+				size_t(polylog_buffer_size)
+			};
+
+			json::stack out
+			{
+				buf
+			};
+
+			sync::data fork
+			{
+				data, out
+			};
+
+			bool composed{false};
+			{
+				json::stack::object top
+				{
+					out
+				};
+
+				composed = _rooms_polylog_room(fork, room);
+			}
+
+			const std::lock_guard lock{mutex};
+			if(unlikely(out.failed()))
+			{
+				overflow.emplace_back(std::move(room_id));
+				return;
+			}
+
+			if(!composed)
+				return;
+
+			for(const auto &[key, val] : json::object{out.completed()})
+				json::stack::member
+				{
+					object, key, json::object{val}
+				};
+
+			ret = true;
+		}
+	};
+
+	data.user_rooms.for_each(data.membership, user::rooms::closure_bool{[&concurrent, &max]
+	(const m::room &room, const string_view &)
+	{
+		concurrent.d.wait([&concurrent, &max]
+		{
+			return concurrent.snd - concurrent.fin < max;
+		});
+
+		concurrent(std::string(room.room_id));
+		return true;
+	}});
+
+	{
+		const ctx::uninterruptible ui;
+		concurrent.wait();
+	}
+
+	if(concurrent.eptr)
+		std::rethrow_exception(concurrent.eptr);
+
+	for(const auto &room_id : overflow)
+	{
+		const m::room room
+		{
+			m::room::id{room_id}
+		};
+
+		ret |= _rooms_polylog_room(data, room);
+	}
+
+	return ret;
+}
+
 bool
 ircd::m::sync::_rooms_polylog_room(data &data,
                                    const m::room &room)
@@ -12,7 +12,9 @@ namespace ircd::m::sync
 {
 	static bool room_state_append(data &, json::stack::array &, const m::event &, const m::event::idx &, const bool &query_prev);
 
-	static bool room_state_phased_member_events(data &, json::stack::array &);
+	static bool room_state_member_events(data &, json::stack::array &);
+	static bool room_state_lazyload_sending(const data &, const event::idx &);
+	static bool room_state_lazyload(const data &);
 	static bool room_state_phased_events(data &);
 	static bool room_state_phased_prefetch(data &);
 	static bool room_state_polylog_events(data &);
@@ -21,6 +23,7 @@ namespace ircd::m::sync
 	static bool room_state_polylog(data &);
 	static bool room_invite_state_polylog(data &);
 
+	static bool room_state_linear_lazyload(data &);
 	static bool room_state_linear_events(data &);
 	static bool room_invite_state_linear(data &);
 	static bool room_state_linear(data &);
@@ -29,6 +32,9 @@ namespace ircd::m::sync
 	extern conf::item<size_t> member_scan_max;
 	extern conf::item<bool> lazyload_members_enable;
 	extern conf::item<bool> crazyload_historical_members;
+	extern conf::item<size_t> lazyload_sent_max;
+	extern conf::item<size_t> lazyload_devices_max;
+	extern std::map<std::string, std::set<event::idx>, std::less<>> lazyload_sent;
 
 	extern item room_invite_state;
 	extern item room_state;
@@ -95,7 +101,9 @@ ircd::m::sync::room_state_linear_events(data &data)
 
 	assert(data.event);
 	if(!json::get<"state_key"_>(*data.event))
-		return false;
+		return room_state_lazyload(data)?
+			room_state_linear_lazyload(data):
+			false;
 
 	const bool is_own_membership
 	{
@@ -227,9 +235,75 @@ ircd::m::sync::room_state_linear_events(data &data)
 	}
 
 	ret |= room_state_append(data, array, *data.event, data.event_idx, true);
+
+	// Remember the member was sent so it is not sent again for its timeline.
+	if(ret && json::get<"type"_>(*data.event) == "m.room.member")
+		if(room_state_lazyload(data))
+			room_state_lazyload_sending(data, data.event_idx);
+
 	return ret;
 }
 
+/// Under lazy-loading the membership of the sender of a timeline event is
+/// sent along with it, unless it was already sent to this device.
+bool
+ircd::m::sync::room_state_linear_lazyload(data &data)
+{
+	if(data.membership != "join")
+		return false;
+
+	const auto &sender
+	{
+		json::get<"sender"_>(*data.event)
+	};
+
+	const auto member_idx
+	{
+		data.room->get(std::nothrow, "m.room.member", sender)
+	};
+
+	if(!member_idx)
+		return false;
+
+	if(!room_state_lazyload_sending(data, member_idx))
+		return false;
+
+	const event::fetch event
+	{
+		std::nothrow, member_idx
+	};
+
+	if(!event.valid)
+		return false;
+
+	json::stack::object rooms
+	{
+		*data.out, "rooms"
+	};
+
+	json::stack::object membership_
+	{
+		*data.out, data.membership
+	};
+
+	json::stack::object room_
+	{
+		*data.out, data.room->room_id
+	};
+
+	json::stack::object state
+	{
+		*data.out, "state"
+	};
+
+	json::stack::array array
+	{
+		*data.out, "events"
+	};
+
+	return room_state_append(data, array, event, member_idx, false);
+}
+
 bool
 ircd::m::sync::room_state_polylog(data &data)
 {
@@ -300,6 +374,23 @@ ircd::m::sync::crazyload_historical_members
 	{ "default",      false                                             },
 };
 
+decltype(ircd::m::sync::lazyload_sent_max)
+ircd::m::sync::lazyload_sent_max
+{
+	{ "name",         "ircd.client.sync.rooms.state.members.lazyload.sent.max" },
+	{ "default",      8192L                                                    },
+};
+
+decltype(ircd::m::sync::lazyload_devices_max)
+ircd::m::sync::lazyload_devices_max
+{
+	{ "name",         "ircd.client.sync.rooms.state.members.lazyload.devices.max" },
+	{ "default",      4096L                                                       },
+};
+
+decltype(ircd::m::sync::lazyload_sent)
+ircd::m::sync::lazyload_sent;
+
 bool
 ircd::m::sync::room_state_polylog_prefetch(data &data)
 {
@@ -311,6 +402,11 @@ ircd::m::sync::room_state_polylog_events(data &data)
 {
 	bool ret{false};
 	ctx::mutex mutex;
+	const ctx::prof::lock::label mutex_label
+	{
+		&mutex, "client.sync.rooms.state.polylog"
+	};
+
 	json::stack::array array
 	{
 		*data.out, "events"
@@ -352,16 +448,6 @@ ircd::m::sync::room_state_polylog_events(data &data)
 		}
 	};
 
-	const auto &room_filter
-	{
-		json::get<"room"_>(data.filter)
-	};
-
-	const auto &state_filter
-	{
-		json::get<"state"_>(room_filter)
-	};
-
 	const room::state state
 	{
 		*data.room
@@ -369,8 +455,7 @@ ircd::m::sync::room_state_polylog_events(data &data)
 
 	const auto &lazyload_members
 	{
-		lazyload_members_enable
-		&& json::get<"lazy_load_members"_>(state_filter)
+		room_state_lazyload(data)
 	};
 
 	const bool full_state_reflow
@@ -385,7 +470,7 @@ ircd::m::sync::room_state_polylog_events(data &data)
 		&& !full_state_reflow
 	};
 
-	state.for_each([&data, &concurrent, &lazyload_members]
+	const room::state::closure_bool each{[&data, &concurrent, &lazyload_members]
 	(const string_view &type, const string_view &state_key, const event::idx &event_idx)
 	{
 		// Conditions to skip state when not forcing full_state
@@ -410,10 +495,43 @@ ircd::m::sync::room_state_polylog_events(data &data)
 		this_ctx::interruption_point();
 		concurrent(event_idx);
 		return true;
-	});
+	}};
+
+	// The member cells of a large room aren't even read when lazy-loading;
+	// only those of the senders in the timeline are found with point lookups.
+	const bool lazyload
+	{
+		lazyload_members && !data.args->full_state
+	};
+
+	if(lazyload)
+		state.for_each_except("m.room.member", each);
+	else
+		state.for_each(each);
+
+	{
+		const ctx::uninterruptible::nothrow ui;
+		concurrent.wait();
+	}
+
+	if(lazyload)
+	{
+		const auto own_idx
+		{
+			state.get(std::nothrow, "m.room.member", data.user.user_id)
+		};
+
+		const event::fetch event
+		{
+			std::nothrow, own_idx
+		};
+
+		if(event.valid && apropos(data, own_idx))
+			ret |= room_state_append(data, array, event, own_idx, false);
+
+		ret |= room_state_member_events(data, array);
+	}
 
-	const ctx::uninterruptible::nothrow ui;
-	concurrent.wait();
 	return ret;
 }
 
@@ -466,6 +584,11 @@ ircd::m::sync::room_state_phased_events(data &data)
 {
 	bool ret{false};
 	ctx::mutex mutex;
+	const ctx::prof::lock::label mutex_label
+	{
+		&mutex, "client.sync.rooms.state.phased"
+	};
+
 	json::stack::array array
 	{
 		*data.out, "events"
@@ -547,13 +670,13 @@ ircd::m::sync::room_state_phased_events(data &data)
 	}
 
 	if(data.membership == "join")
-		ret |= room_state_phased_member_events(data, array);
+		ret |= room_state_member_events(data, array);
 
 	return ret;
 }
 
 bool
-ircd::m::sync::room_state_phased_member_events(data &data,
+ircd::m::sync::room_state_member_events(data &data,
                                                json::stack::array &array)
 {
 	// The number of recent room events we'll seek senders for.
@@ -579,6 +702,9 @@ ircd::m::sync::room_state_phased_member_events(data &data,
 	for(; it && i < count; --it, ++i)
 	{
 		event_idx[i] = it.event_idx();
+		if(!data.phased && event_idx[i] < data.range.first)
+			break;
+
 		prefetched += m::prefetch(event_idx[i], "sender");
 	}
 
@@ -610,6 +736,9 @@ ircd::m::sync::room_state_phased_member_events(data &data,
 	std::for_each(begin(event_idx), end, [&data, &array, &ret, &event]
 	(const event::idx &sender_idx)
 	{
+		if(!sender_idx || !room_state_lazyload_sending(data, sender_idx))
+			return;
+
 		if(!seek(std::nothrow, event, sender_idx))
 			return;
 
@@ -635,3 +764,81 @@ ircd::m::sync::room_state_append(data &data,
 	opts.query_prev_state = query_prev;
 	return m::event::append(events, event, opts);
 }
+
+bool
+ircd::m::sync::room_state_lazyload(const data &data)
+{
+	const auto &room_filter
+	{
+		json::get<"room"_>(data.filter)
+	};
+
+	const auto &state_filter
+	{
+		json::get<"state"_>(room_filter)
+	};
+
+	return lazyload_members_enable
+	&& json::get<"lazy_load_members"_>(state_filter);
+}
+
+/// Tracks the member events sent to each device while lazy-loading so they
+/// are not sent again with every timeline. Returns true if the member event
+/// should be sent. An initial sync sends everything it needs regardless. The
+/// tracking is bounded: when a device has been sent too many members its set
+/// is reset and they will be sent once more as needed.
+bool
+ircd::m::sync::room_state_lazyload_sending(const data &data,
+                                           const event::idx &member_idx)
+{
+	const auto &room_filter
+	{
+		json::get<"room"_>(data.filter)
+	};
+
+	const auto &state_filter
+	{
+		json::get<"state"_>(room_filter)
+	};
+
+	if(json::get<"include_redundant_members"_>(state_filter))
+		return true;
+
+	const bool initial
+	{
+		data.phased || data.range.first == 0
+	};
+
+	const string_view parts[]
+	{
+		data.user.user_id, " ", data.device_id,
+	};
+
+	std::string key;
+	for(const auto &part : parts)
+		key.append(ircd::data(part), ircd::size(part));
+
+	auto it
+	{
+		lazyload_sent.lower_bound(key)
+	};
+
+	if(it == end(lazyload_sent) || it->first != key)
+	{
+		if(lazyload_sent.size() >= size_t(lazyload_devices_max))
+			lazyload_sent.erase(begin(lazyload_sent));
+
+		it = lazyload_sent.emplace_hint(it, std::move(key), std::set<event::idx>{});
+	}
+
+	auto &sent(it->second);
+	if(sent.size() >= size_t(lazyload_sent_max))
+		sent.clear();
+
+	const bool inserted
+	{
+		sent.emplace(member_idx).second
+	};
+
+	return inserted || initial;
+}
@@ -97,40 +97,55 @@ ircd::m::sync::room_summary_append_heroes(data &data)
 		*data.out, "m.heroes"
 	};
 
-	static const auto count{6}, bufsz{48}, limit{12};
+	static const auto count{5}, bufsz{256};
 	std::array<char[bufsz], count> buf;
 	std::array<string_view, count> last;
-	size_t ret(0), i(0);
-	m::room::events it
-	{
-		*data.room
-	};
+	size_t ret(0);
 
 	const auto already{[&last, &ret]
-	(const string_view &sender) -> bool
+	(const string_view &user_id) -> bool
 	{
-		return std::any_of(begin(last), begin(last)+ret, [&sender]
+		return std::any_of(begin(last), begin(last)+ret, [&user_id]
 		(const auto &last)
 		{
-			return startswith(last, sender);
+			return last == user_id;
 		});
 	}};
 
-	for(; it && ret < count && i < limit; --it, ++i)
+	const auto append{[&]
+	(const m::user::id &user_id) -> bool
 	{
-		const auto &event_idx(it.event_idx());
-		m::get(std::nothrow, event_idx, "sender", [&]
-		(const auto &sender)
-		{
-			if(already(sender))
-				return;
+		if(user_id == data.user.user_id || already(user_id))
+			return true;
 
-			m_heroes.append(sender);
-			last.at(ret) = strlcpy(buf.at(ret), sender);
-			++ret;
-		});
+		m_heroes.append(user_id);
+		last.at(ret) = strlcpy(buf.at(ret), user_id);
+		return ++ret < count;
+	}};
+
+	// The leading members are precomputed by the room_heroes index; the
+	// members are iterated only when that list runs short of the room.
+	const bool more
+	{
+		m::dbs::room_heroes_for_each(data.room->room_id, append)
+	};
+
+	const m::room::members members
+	{
+		*data.room
+	};
+
+	const size_t members_count
+	{
+		more?
+			members.count("join") + members.count("invite"):
+			0UL
 	};
 
+	if(more && ret + 1 < members_count)
+		members.for_each("join", append)
+		&& members.for_each("invite", append);
+
 	return ret;
 }
 
@@ -155,22 +170,18 @@ ircd::m::sync::room_summary_append_counts(data &data)
 		}
 	};
 
-	// TODO: XXX
-	// Invited member count is omitted for now. We don't yet enjoy an
-	// optimized query for the invited member count like we do with the
-	// joined member count.
-	const long invited_members_count
+	const auto invited_members_count
 	{
-		0UL
+		members.count("invite")
 	};
 
-//	json::stack::member
-//	{
-//		*data.out, "m.invited_member_count", json::value
-//		{
-//			long(members.count("invite"))
-//		}
-//	};
+	json::stack::member
+	{
+		*data.out, "m.invited_member_count", json::value
+		{
+			long(invited_members_count)
+		}
+	};
 
 	return joined_members_count || invited_members_count;
 }
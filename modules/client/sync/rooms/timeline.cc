@@ -10,7 +10,7 @@
 
 namespace ircd::m::sync
 {
-	static bool _room_timeline_append(data &, json::stack::array &, const m::event::idx &, const m::event &);
+	static bool _room_timeline_append(data &, json::stack::array &, const m::event::idx &, const m::event &, const bool &cache = false);
 	static event::id::buf _room_timeline_polylog_events(data &, const m::room &, bool &, bool &);
 	static bool room_timeline_polylog(data &);
 
@@ -209,7 +209,8 @@ ircd::m::sync::room_timeline_linear(data &data)
 		*data.out, "events"
 	};
 
-	return _room_timeline_append(data, array, data.event_idx, *data.event);
+	// Shared with every other linear and longpoll sync of the same event.
+	return _room_timeline_append(data, array, data.event_idx, *data.event, true);
 }
 
 bool
@@ -366,7 +367,8 @@ bool
 ircd::m::sync::_room_timeline_append(data &data,
                                      json::stack::array &events,
                                      const m::event::idx &event_idx,
-                                     const m::event &event)
+                                     const m::event &event,
+                                     const bool &cache)
 {
 	m::event::append::opts opts;
 	opts.event_idx = &event_idx;
@@ -374,5 +376,7 @@ ircd::m::sync::_room_timeline_append(data &data,
 	opts.user_id = &data.user.user_id;
 	opts.user_room = &data.user_room;
 	opts.room_depth = &data.room_depth;
+	opts.compiled_filter = data.filters? &data.filters->timeline: nullptr;
+	opts.cache = cache;
 	return m::event::append(events, event, opts);
 }
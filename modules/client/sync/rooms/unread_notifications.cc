@@ -10,6 +10,7 @@
 
 namespace ircd::m::sync
 {
+	static bool _unread_counts(data &, const room &, long (&)[2]);
 	static long _notification_count(const room &, const event::idx &a, const event::idx &b);
 	static long _highlight_count(const room &, const user &u, const event::idx &a, const event::idx &b);
 	static bool room_unread_notifications_polylog(data &);
@@ -141,18 +142,20 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 		std::max(data.range.second, data.event_idx + 1)
 	};
 
-	const auto notification_count
+	long counts[2] {0L, 0L};
+	if(!_unread_counts(data, room, counts) && start_idx && !is_self_read)
 	{
-		start_idx && !is_self_read?
-			_notification_count(room, start_idx, upper_bound):
-			0L
-	};
+		counts[0] = _notification_count(room, start_idx, upper_bound);
+		counts[1] = counts[0]?
+			_highlight_count(room, data.user, start_idx, upper_bound):
+			0L;
+	}
 
 	json::stack::member
 	{
 		*data.out, "notification_count", json::value
 		{
-			notification_count
+			counts[0]
 		}
 	};
 
@@ -160,9 +163,7 @@ ircd::m::sync::room_unread_notifications_linear(data &data)
 	{
 		*data.out, "highlight_count", json::value
 		{
-			notification_count?
-				_highlight_count(room, data.user, start_idx, upper_bound):
-				0L
+			counts[1]
 		}
 	};
 
@@ -199,16 +200,20 @@ ircd::m::sync::room_unread_notifications_polylog(data &data)
 	if(!apropos(data, start_idx))
 		return false;
 
-	const auto notification_count
+	long counts[2] {0L, 0L};
+	if(!_unread_counts(data, room, counts))
 	{
-		_notification_count(room, start_idx, data.range.second)
-	};
+		counts[0] = _notification_count(room, start_idx, data.range.second);
+		counts[1] = counts[0]?
+			_highlight_count(room, data.user, start_idx, data.range.second):
+			0L;
+	}
 
 	json::stack::member
 	{
 		*data.out, "notification_count", json::value
 		{
-			notification_count
+			counts[0]
 		}
 	};
 
@@ -216,15 +221,33 @@ ircd::m::sync::room_unread_notifications_polylog(data &data)
 	{
 		*data.out, "highlight_count", json::value
 		{
-			notification_count?
-				_highlight_count(room, data.user, start_idx, data.range.second):
-				0L
+			counts[1]
 		}
 	};
 
 	return true;
 }
 
+/// Counters maintained by the room_unread index. These are only used once
+/// a read receipt has reset them; until then they reflect notifications
+/// since the index was created rather than since the last receipt.
+bool
+ircd::m::sync::_unread_counts(data &data,
+                              const room &room,
+                              long (&ret)[2])
+{
+	dbs::room_unread_vector counts;
+	if(!dbs::room_unread_get(counts, data.user_room.room_id, room.room_id))
+		return false;
+
+	if(!counts[dbs::ROOM_UNREAD_RESET])
+		return false;
+
+	ret[0] = std::max(counts[dbs::ROOM_UNREAD_NOTIFICATIONS], 0L);
+	ret[1] = std::max(counts[dbs::ROOM_UNREAD_HIGHLIGHTS], 0L);
+	return true;
+}
+
 long
 ircd::m::sync::_notification_count(const room &room,
                                    const event::idx &a,
@@ -11,9 +11,14 @@
 namespace ircd::m::sync
 {
 	static void _to_device_append(data &, const json::object &, json::stack::array &);
+	static bool _to_device_deliver(data &, json::stack::array &);
+	static void _to_device_ack(data &);
 	static bool to_device_polylog(data &);
 	static bool to_device_linear(data &);
 
+	extern conf::item<size_t> to_device_limit;
+	// device key => (last position delivered, since of the delivery)
+	extern std::map<std::string, std::pair<dbs::device_inbox_pos, event::idx>, std::less<>> to_device_delivered;
 	extern item to_device;
 }
 
@@ -31,6 +36,23 @@ ircd::m::sync::to_device
 	to_device_linear
 };
 
+/// Messages delivered to a device in one response at most; the rest remain
+/// queued for the next.
+decltype(ircd::m::sync::to_device_limit)
+ircd::m::sync::to_device_limit
+{
+	{ "name",     "ircd.client.sync.to_device.limit" },
+	{ "default",  100L                               },
+};
+
+/// The last message delivered to each device. A message is only deleted
+/// from the queue once delivered and the device syncs from beyond both the
+/// message and the since token of the delivery; a retry of the delivering
+/// request receives it again. After a restart what's queued is delivered
+/// again before it can be deleted.
+decltype(ircd::m::sync::to_device_delivered)
+ircd::m::sync::to_device_delivered;
+
 bool
 ircd::m::sync::to_device_linear(data &data)
 {
@@ -45,14 +67,10 @@ ircd::m::sync::to_device_linear(data &data)
 	if(json::get<"type"_>(event) != "ircd.to_device")
 		return false;
 
-	const json::object &content
-	{
-		json::get<"content"_>(event)
-	};
-
+	// The event only notifies; the messages are in the queue of the device.
 	const json::string &device_id
 	{
-		content.at("device_id")
+		json::get<"content"_>(event).get("device_id")
 	};
 
 	if(device_id != "*" && device_id != data.device_id)
@@ -68,8 +86,7 @@ ircd::m::sync::to_device_linear(data &data)
 		to_device, "events"
 	};
 
-	_to_device_append(data, content, array);
-	return true;
+	return _to_device_deliver(data, array);
 }
 
 bool
@@ -80,37 +97,89 @@ ircd::m::sync::to_device_polylog(data &data)
 		*data.out, "events"
 	};
 
-	m::room::type events
+	return _to_device_deliver(data, array);
+}
+
+/// What was delivered is deleted first when the device has synced beyond
+/// it; what remains is delivered in order of position up to the limit.
+/// Messages queued at or beyond the end of the range wait for the next.
+bool
+ircd::m::sync::_to_device_deliver(data &data,
+                                  json::stack::array &array)
+{
+	if(!data.device_id)
+		return false;
+
+	_to_device_ack(data);
+
+	size_t count(0);
+	dbs::device_inbox_pos last {0, 0};
+	dbs::device_inbox_for_each(data.user.user_id, data.device_id, [&data, &array, &count, &last]
+	(const dbs::device_inbox_pos &pos, const json::object &message)
 	{
-		data.user_room, "ircd.to_device",
-		{
-			-1UL, data.range.first
-		}
+		if(pos.first >= data.range.second)
+			return false;
+
+		_to_device_append(data, message, array);
+		last = pos;
+		return ++count < size_t(to_device_limit);
+	});
+
+	if(!count)
+		return false;
+
+	char buf[dbs::DEVICE_INBOX_KEY_MAX_SIZE];
+	const string_view key
+	{
+		dbs::device_inbox_key(buf, data.user.user_id, data.device_id, {0, 0})
 	};
 
-	bool ret{false};
-	events.for_each([&data, &array, &ret]
-	(const string_view &type, const uint64_t &depth, const event::idx &event_idx)
+	auto it
 	{
-		m::get(std::nothrow, event_idx, "content", [&data, &array, &ret]
-		(const json::object &content)
-		{
-			const json::string &device_id
-			{
-				content.at("device_id")
-			};
+		to_device_delivered.lower_bound(key)
+	};
+
+	if(it == end(to_device_delivered) || it->first != key)
+		it = to_device_delivered.emplace_hint(it, key, std::make_pair(last, data.range.first));
 
-			if(device_id != "*" && device_id != data.device_id)
-				return;
+	auto &[through, since] {it->second};
+	since = through < last? data.range.first: since;
+	through = std::max(through, last);
+	return true;
+}
 
-			_to_device_append(data, content, array);
-			ret = true;
-		});
+void
+ircd::m::sync::_to_device_ack(data &data)
+{
+	if(data.phased || !data.range.first)
+		return;
 
-		return true;
-	});
+	char buf[dbs::DEVICE_INBOX_KEY_MAX_SIZE];
+	const string_view key
+	{
+		dbs::device_inbox_key(buf, data.user.user_id, data.device_id, {0, 0})
+	};
+
+	const auto it
+	{
+		to_device_delivered.find(key)
+	};
+
+	if(it == end(to_device_delivered))
+		return;
+
+	// The device has not yet synced beyond the last delivery; it's still
+	// owed everything queued, perhaps after a lost response.
+	const auto [through, since]
+	{
+		it->second
+	};
+
+	if(through.first >= data.range.first || since >= data.range.first)
+		return;
 
-	return ret;
+	to_device_delivered.erase(it);
+	dbs::device_inbox_del(data.user.user_id, data.device_id, through);
 }
 
 void
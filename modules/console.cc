@@ -978,6 +978,7 @@ console_cmd__fs__dev(opt &out, const string_view &line)
 	<< std::setw(6) << std::right << "NR_REQ" << ' '
 	<< std::setw(6) << std::right << "DEPTH" << ' '
 	<< std::setw(5) << std::right << "MERGE" << ' '
+	<< std::setw(4) << std::right << "NUMA" << ' '
 	<< std::setw(5) << std::right << "OPTSZ" << ' '
 	<< std::setw(5) << std::right << "MINSZ" << ' '
 	<< std::setw(5) << std::right << "LOGSZ" << ' '
@@ -1004,6 +1005,7 @@ console_cmd__fs__dev(opt &out, const string_view &line)
 		<< std::setw(6) << std::right << dev.nr_requests << ' '
 		<< std::setw(6) << std::right << dev.queue_depth << ' '
 		<< std::setw(5) << std::right << (dev.merges? 'Y' : 'N') << ' '
+		<< std::setw(4) << std::right << dev.numa_node << ' '
 		<< std::setw(5) << std::right << dev.optimal_io << ' '
 		<< std::setw(5) << std::right << dev.minimum_io << ' '
 		<< std::setw(5) << std::right << dev.logical_block << ' '
@@ -1332,6 +1334,32 @@ console_cmd__mem__get(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__mem__arena(opt &out, const string_view &line)
+{
+	allocator::je::arena::refresh();
+
+	out
+	<< std::left << std::setw(8) << "NAME" << " "
+	<< std::right << std::setw(5) << "ID" << " "
+	<< std::right << std::setw(12) << "ALLOCATED" << " "
+	<< std::right << std::setw(12) << "ACTIVE" << " "
+	<< std::right << std::setw(12) << "RESIDENT" << " "
+	<< std::endl;
+
+	char pbuf[3][48];
+	for(const auto *const arena : allocator::je::arena::list)
+		out
+		<< std::left << std::setw(8) << arena->name << " "
+		<< std::right << std::setw(5) << arena->id << " "
+		<< std::right << std::setw(12) << pretty(pbuf[0], iec(arena->allocated), 1) << " "
+		<< std::right << std::setw(12) << pretty(pbuf[1], iec(arena->active), 1) << " "
+		<< std::right << std::setw(12) << pretty(pbuf[2], iec(arena->resident), 1) << " "
+		<< std::endl;
+
+	return true;
+}
+
 //
 // vg
 //
@@ -1509,24 +1537,530 @@ console_cmd__prof__vg__stop(opt &out, const string_view &line)
 }
 
 bool
-console_cmd__prof__vg__reset(opt &out, const string_view &line)
+console_cmd__prof__vg__reset(opt &out, const string_view &line)
+{
+	prof::vg::reset();
+	return true;
+}
+
+bool
+console_cmd__prof__vg__toggle(opt &out, const string_view &line)
+{
+	prof::vg::toggle();
+	return true;
+}
+
+bool
+console_cmd__prof__vg__dump(opt &out, const string_view &line)
+{
+	char reason[128];
+	prof::vg::dump(data(ircd::strlcpy(reason, line)));
+	return true;
+}
+
+bool
+console_cmd__prof__sampler(opt &out, const string_view &line)
+{
+	out
+	<< (prof::sampler::active? "running" : "stopped")
+	<< " samples:" << prof::sampler::samples
+	<< " lost:" << prof::sampler::lost
+	<< std::endl;
+	return true;
+}
+
+bool
+console_cmd__prof__sampler__start(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"freq"
+	}};
+
+	prof::sampler::start(param.at<uint32_t>("freq", 0U));
+	out << "started" << std::endl;
+	return true;
+}
+
+bool
+console_cmd__prof__sampler__stop(opt &out, const string_view &line)
+{
+	prof::sampler::stop();
+	return console_cmd__prof__sampler(out, line);
+}
+
+bool
+console_cmd__prof__sampler__clear(opt &out, const string_view &line)
+{
+	prof::sampler::clear();
+	return true;
+}
+
+/// Folded stacks of the samples for flame graph tools; written to the file
+/// if given, otherwise to the console.
+bool
+console_cmd__prof__sampler__folded(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"path"
+	}};
+
+	const string_view &path
+	{
+		param["path"]
+	};
+
+	std::string str;
+	size_t stacks(0);
+	prof::sampler::for_each([&str, &stacks]
+	(const string_view &stack, const uint64_t &count)
+	{
+		str.append(stack);
+		str.append(" ");
+		str.append(lex_cast(count));
+		str.append("\n");
+		++stacks;
+		return true;
+	});
+
+	if(!path)
+	{
+		out << str;
+		return true;
+	}
+
+	fs::overwrite(path, const_buffer{str});
+	out
+	<< "wrote " << stacks << " stacks"
+	<< " (" << size(str) << " bytes) to " << path
+	<< std::endl;
+	return true;
+}
+
+//
+// bench
+//
+
+/// Representative event for the json benchmarks; constant so results are
+/// comparable between builds.
+static const string_view
+bench_event_json
+{R"({"auth_events":["$Bup8vJxteAnPpyoIR8gwQjqvtga0k9CA6d9zR9qPRzg","$ZdNAIBzaRkW9iIlqV7r8wVEFcByBVQaT8Cz4pbHVx2Y","$ZOBkZ7vx2lsmw5rdrPB6npfYwPYBAhzk_LpdpQsd8qQ"],"content":{"body":"The quick brown fox jumps over the lazy dog.","msgtype":"m.text"},"depth":123456,"hashes":{"sha256":"V5LRqTtGCB3BSJPwuL5VZ1yJSivwis7a2I0RN1KE2uo"},"origin":"matrix.example.org","origin_server_ts":1600000000000,"prev_events":["$aT3cxMoRgF7ZxHg35a8KZ0FeEq0CVNHvLusRbTSfLtM"],"room_id":"!benchmark:matrix.example.org","sender":"@bench:matrix.example.org","signatures":{"matrix.example.org":{"ed25519:auto":"ZVo9FvBYPUZ4xFAZa8MNi9qySYYFTZu7DrT4cApY8JhQUoyPdrPodWCDZaknEJqQdezQ8bWw0b2Vtpo+q7WrBQ"}},"type":"m.room.message"})"};
+
+/// Runs the closure for the iterations; the closure returns the number of
+/// operations it performed. Reports the cycles and time per operation.
+template<class closure>
+static bool
+bench(opt &out,
+      const string_view &name,
+      const size_t &iterations,
+      closure&& func)
+{
+	size_t ops(0);
+	const ircd::timer timer;
+	const uint64_t started
+	{
+		prof::cycles()
+	};
+
+	for(size_t i(0); i < iterations; ++i)
+		ops += func(i);
+
+	const uint64_t cycles
+	{
+		prof::cycles() - started
+	};
+
+	const auto elapsed
+	{
+		timer.at<nanoseconds>()
+	};
+
+	out
+	<< std::left << std::setw(24) << name
+	<< " " << std::right << std::setw(10) << ops << " ops"
+	<< " " << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+	<< (ops? cycles / double(ops) : 0.0) << " cycles/op"
+	<< " " << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+	<< (ops? elapsed.count() / double(ops) : 0.0) << " ns/op"
+	<< std::endl;
+	return true;
+}
+
+bool
+console_cmd__bench__json__parse(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	return bench(out, "json parse", param.at<size_t>("iterations", 100000UL), []
+	(const size_t &i)
+	{
+		const json::object object
+		{
+			bench_event_json
+		};
+
+		size_t ret(0);
+		for(const auto &member : object)
+			ret += !empty(member.second);
+
+		return ret > 0;
+	});
+}
+
+bool
+console_cmd__bench__json__tuple(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	return bench(out, "json tuple", param.at<size_t>("iterations", 100000UL), []
+	(const size_t &i)
+	{
+		const m::event event
+		{
+			json::object{bench_event_json}
+		};
+
+		return json::get<"depth"_>(event) > 0;
+	});
+}
+
+bool
+console_cmd__bench__json__stack(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	const m::event event
+	{
+		json::object{bench_event_json}
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		16_KiB
+	};
+
+	return bench(out, "json stack", param.at<size_t>("iterations", 100000UL), [&event, &buf]
+	(const size_t &i)
+	{
+		json::stack out{buf};
+		{
+			json::stack::object top{out};
+			json::stack::member{top, "event_id", "$Bup8vJxteAnPpyoIR8gwQjqvtga0k9CA6d9zR9qPRzg"};
+			json::stack::member{top, "depth", json::value{long(i)}};
+			json::stack::member{top, "event", event};
+		}
+
+		return !empty(out.completed());
+	});
+}
+
+bool
+console_cmd__bench__event__id__hash(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	const m::event::id event_id
+	{
+		"$Bup8vJxteAnPpyoIR8gwQjqvtga0k9CA6d9zR9qPRzg"
+	};
+
+	size_t sum(0);
+	bench(out, "event id hash", param.at<size_t>("iterations", 1000000UL), [&event_id, &sum]
+	(const size_t &i)
+	{
+		sum += ircd::hash(event_id);
+		return true;
+	});
+
+	bench(out, "event id std::hash", param.at<size_t>("iterations", 1000000UL), [&event_id, &sum]
+	(const size_t &i)
+	{
+		sum += std::hash<std::string_view>{}(event_id);
+		return true;
+	});
+
+	bench(out, "event id valid", param.at<size_t>("iterations", 1000000UL), [&event_id]
+	(const size_t &i)
+	{
+		return valid(m::id::EVENT, event_id);
+	});
+
+	out << "(" << sum << ")" << std::endl;
+	return true;
+}
+
+bool
+console_cmd__bench__event__verify(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"event_id", "iterations"
+	}};
+
+	const m::event::id::buf event_id
+	{
+		param["event_id"] && param["event_id"] != "-"?
+			m::event::id::buf{param["event_id"]}:
+			m::event_id(m::vm::sequence::retired)
+	};
+
+	const m::event::fetch event
+	{
+		event_id
+	};
+
+	// Fetch the key once outside the loop; the benchmark is of the math.
+	m::verify(event);
+	return bench(out, "event verify", param.at<size_t>("iterations", 1000UL), [&event]
+	(const size_t &i)
+	{
+		return m::verify(event);
+	});
+}
+
+/// Hashes a batch of copies of the benchmark event on the host and then by
+/// sha256::batch(), which takes a batch of ircd.cl.sha256.batch.min or more
+/// to the device when OpenCL is available.
+bool
+console_cmd__bench__sha256(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"count", "iterations"
+	}};
+
+	const size_t count
+	{
+		param.at<size_t>("count", 4096UL)
+	};
+
+	const std::vector<const_buffer> in
+	(
+		count, const_buffer{bench_event_json}
+	);
+
+	const unique_mutable_buffer host
+	{
+		count * sha256::digest_size
+	};
+
+	const unique_mutable_buffer batch
+	{
+		count * sha256::digest_size
+	};
+
+	bench(out, "sha256 host", param.at<size_t>("iterations", 10UL), [&in, &host]
+	(const size_t &i)
+	{
+		for(size_t j(0); j < in.size(); ++j)
+			sha256
+			{
+				mutable_buffer{data(host) + j * sha256::digest_size, sha256::digest_size}, in[j]
+			};
+
+		return in.size();
+	});
+
+	bench(out, "sha256 batch", param.at<size_t>("iterations", 10UL), [&in, &batch]
+	(const size_t &i)
+	{
+		sha256::batch(batch, in);
+		return in.size();
+	});
+
+	if(memcmp(data(host), data(batch), size(host)) != 0)
+		throw error
+		{
+			"Batch digests differ from the host."
+		};
+
+	return true;
+}
+
+bool
+console_cmd__bench__db__read(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	const m::event::idx max
+	{
+		m::vm::sequence::retired
+	};
+
+	if(!max)
+		throw error
+		{
+			"No events to read."
+		};
+
+	// The event_idx are visited in a fixed order scattered over the whole
+	// range so the results are repeatable but not sequential.
+	return bench(out, "db read event_json", param.at<size_t>("iterations", 10000UL), [&max]
+	(const size_t &i)
+	{
+		const m::event::idx event_idx
+		{
+			1 + (i * 2654435761UL) % max
+		};
+
+		return m::dbs::event_json(byte_view<string_view>(event_idx), std::nothrow, [](const string_view &)
+		{
+		});
+	});
+}
+
+bool
+console_cmd__bench__db__iter(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	auto it
+	{
+		m::dbs::event_json.begin()
+	};
+
+	return bench(out, "db iter event_json", param.at<size_t>("iterations", 100000UL), [&it]
+	(const size_t &i)
+	{
+		if(!it)
+			return false;
+
+		const bool ret
+		{
+			!empty(it->second)
+		};
+
+		++it;
+		return ret;
+	});
+}
+
+bool
+console_cmd__bench__room__events(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"room_id", "iterations", "fetch"
+	}};
+
+	const auto &room_id
+	{
+		m::room_id(param.at("room_id"))
+	};
+
+	const bool fetch
+	{
+		param["fetch"] == "fetch"
+	};
+
+	const m::room room
+	{
+		room_id
+	};
+
+	m::room::events it
+	{
+		room
+	};
+
+	return bench(out, fetch? "room events fetch": "room events", param.at<size_t>("iterations", 10000UL), [&it, &fetch]
+	(const size_t &i)
+	{
+		if(!it)
+			return false;
+
+		const bool ret
+		{
+			fetch?
+				bool(it->event_id):
+				bool(it.event_idx())
+		};
+
+		--it;
+		return ret;
+	});
+}
+
+bool
+console_cmd__bench__ctx__switch(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	return bench(out, "ctx yield", param.at<size_t>("iterations", 10000UL), []
+	(const size_t &i)
+	{
+		ctx::yield();
+		return true;
+	});
+}
+
+bool
+console_cmd__bench__ctx__spawn(opt &out, const string_view &line)
 {
-	prof::vg::reset();
-	return true;
-}
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
 
-bool
-console_cmd__prof__vg__toggle(opt &out, const string_view &line)
-{
-	prof::vg::toggle();
-	return true;
+	return bench(out, "ctx spawn join", param.at<size_t>("iterations", 1000UL), []
+	(const size_t &i)
+	{
+		context context
+		{
+			"bench", 64_KiB, context::POST, []
+			{
+			}
+		};
+
+		context.join();
+		return true;
+	});
 }
 
 bool
-console_cmd__prof__vg__dump(opt &out, const string_view &line)
+console_cmd__bench(opt &out, const string_view &line)
 {
-	char reason[128];
-	prof::vg::dump(data(ircd::strlcpy(reason, line)));
+	const params param{line, " ",
+	{
+		"room_id"
+	}};
+
+	console_cmd__bench__json__parse(out, {});
+	console_cmd__bench__json__tuple(out, {});
+	console_cmd__bench__json__stack(out, {});
+	console_cmd__bench__event__id__hash(out, {});
+	console_cmd__bench__event__verify(out, {});
+	console_cmd__bench__sha256(out, {});
+	console_cmd__bench__db__read(out, {});
+	console_cmd__bench__db__iter(out, {});
+	console_cmd__bench__ctx__switch(out, {});
+	console_cmd__bench__ctx__spawn(out, {});
+	if(param["room_id"])
+		console_cmd__bench__room__events(out, param["room_id"]);
+
 	return true;
 }
 
@@ -1599,6 +2133,9 @@ console_cmd__stats(opt &out, const string_view &line)
 		param[0] == "-a"? param[1]: param[0]
 	};
 
+	// Arena statistics are sampled on demand.
+	allocator::je::arena::refresh();
+
 	for(const auto &item : stats::items)
 	{
 		if(prefix && !startswith(item->name, prefix))
@@ -2818,6 +3355,85 @@ console_cmd__ctx__prof(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__ctx__prof__lock(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"name", "limit"
+	}};
+
+	const string_view name_filter
+	{
+		param["name"] != "*"? param["name"]: string_view{}
+	};
+
+	const auto limit
+	{
+		param.at<size_t>("limit", 32UL)
+	};
+
+	if(!ctx::prof::lock::enable)
+		out << "Lock profiling is disabled; see ircd.ctx.prof.lock.enable" << std::endl;
+
+	std::vector<const ctx::prof::lock::point *> points;
+	ctx::prof::lock::for_each([&](const auto &point)
+	{
+		if(!name_filter || startswith(point.name, name_filter))
+			points.emplace_back(&point);
+
+		return true;
+	});
+
+	std::sort(begin(points), end(points), []
+	(const auto *const &a, const auto *const &b)
+	{
+		return a->total > b->total;
+	});
+
+	out
+	<< std::left << std::setw(32) << "LOCK" << " "
+	<< std::right << std::setw(10) << "WAITS" << " "
+	<< std::right << std::setw(8) << "TIMEOUT" << " "
+	<< std::right << std::setw(10) << "TOTAL" << " "
+	<< std::right << std::setw(10) << "MEAN" << " "
+	<< std::right << std::setw(10) << "MAX" << " "
+	<< std::left << std::setw(24) << "MAX HOLDER" << " "
+	<< std::left << std::setw(24) << "MAX WAITER" << " "
+	<< std::left << "HOLDERS"
+	<< std::endl;
+
+	for(size_t i(0); i < points.size() && i < limit; ++i)
+	{
+		const auto &point(*points[i]);
+		char pbuf[3][32];
+		out
+		<< std::left << std::setw(32) << trunc(point.name, 32) << " "
+		<< std::right << std::setw(10) << point.waits << " "
+		<< std::right << std::setw(8) << point.timeouts << " "
+		<< std::right << std::setw(10) << pretty(pbuf[0], point.total, 1) << " "
+		<< std::right << std::setw(10) << pretty(pbuf[1], point.total / std::max(point.waits, 1UL), 1) << " "
+		<< std::right << std::setw(10) << pretty(pbuf[2], point.max, 1) << " "
+		<< std::left << std::setw(24) << trunc(point.max_holder, 24) << " "
+		<< std::left << std::setw(24) << trunc(point.max_waiter, 24) << " ";
+
+		for(const auto &[holder, count] : point.holders)
+			out << holder << ":" << count << " ";
+
+		out << std::endl;
+	}
+
+	return true;
+}
+
+bool
+console_cmd__ctx__prof__lock__clear(opt &out, const string_view &line)
+{
+	ctx::prof::lock::clear();
+	out << "cleared." << std::endl;
+	return true;
+}
+
 bool
 console_cmd__ctx__term(opt &out, const string_view &line)
 {
@@ -2873,6 +3489,21 @@ console_cmd__ctx__list(opt &out, const string_view &line)
 	    << std::setw(6)
 	    << "PCT"
 	    << " "
+	    << std::setw(9)
+	    << "DB READS"
+	    << " "
+	    << std::setw(12)
+	    << "DB BYTES"
+	    << " "
+	    << std::setw(12)
+	    << "NET IN"
+	    << " "
+	    << std::setw(12)
+	    << "NET OUT"
+	    << " "
+	    << std::setw(10)
+	    << "ALLOCS"
+	    << " "
 	    << std::setw(25)
 	    << "STACK"
 	    << " "
@@ -2930,6 +3561,31 @@ console_cmd__ctx__list(opt &out, const string_view &line)
 		    << "%";
 
 		thread_local char pbuf[32];
+		const auto &profile
+		{
+			ctx::prof::get(ctx)
+		};
+
+		const auto ticks{[&profile](const ctx::prof::event &event)
+		{
+			return profile.event.at(uint8_t(event));
+		}};
+
+		out << " "
+		    << std::setw(9) << std::right << ticks(ctx::prof::event::DB_READS);
+
+		out << " "
+		    << std::setw(12) << std::right << pretty(pbuf, iec(ticks(ctx::prof::event::DB_BYTES)), 1);
+
+		out << " "
+		    << std::setw(12) << std::right << pretty(pbuf, iec(ticks(ctx::prof::event::NET_READ)), 1);
+
+		out << " "
+		    << std::setw(12) << std::right << pretty(pbuf, iec(ticks(ctx::prof::event::NET_WRITE)), 1);
+
+		out << " "
+		    << std::setw(10) << std::right << ticks(ctx::prof::event::ALLOCS);
+
 		out << " "
 		    << std::setw(25) << std::right << pretty(pbuf, iec(ctx::stack::get(ctx).at));
 
@@ -3132,11 +3788,14 @@ try
 	const auto before_dbseq{sequence(database)};
 	const auto before_retired{m::vm::sequence::retired};
 
-	refresh(database);
+	if(dbname == "events")
+		m::vm::sequence::refresh();
+	else
+		refresh(database);
 
 	m::event::id::buf event_id;
 	if(dbname == "events")
-		m::vm::sequence::retired = m::vm::sequence::get(event_id);
+		m::vm::sequence::get(event_id);
 
 	out
 	<< dbname << " refreshed from "
@@ -3677,6 +4336,75 @@ console_cmd__db__perf__level(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__db__trace(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"column", "ctx"
+	}};
+
+	const string_view column_filter
+	{
+		param["column"] != "*"? param["column"]: string_view{}
+	};
+
+	const string_view ctx_filter
+	{
+		param["ctx"]
+	};
+
+	if(!db::trace::enable)
+		out << "Tracing is disabled; see ircd.db.trace.enable" << std::endl;
+
+	out
+	<< std::left << std::setw(40) << "COLUMN" << " "
+	<< std::left << std::setw(8) << "OP" << " "
+	<< std::left << std::setw(24) << "CTX" << " "
+	<< std::right << std::setw(10) << "COUNT" << " "
+	<< std::right << std::setw(10) << "P50" << " "
+	<< std::right << std::setw(10) << "P99" << " "
+	<< std::right << std::setw(10) << "MAX" << " "
+	<< std::right << std::setw(10) << "MEMTABLE" << " "
+	<< std::right << std::setw(10) << "CACHE" << " "
+	<< std::right << std::setw(10) << "DISK" << " "
+	<< std::endl;
+
+	db::trace::for_each([&](const auto &point)
+	{
+		if(column_filter && !startswith(point.column, column_filter))
+			return true;
+
+		if(ctx_filter && !startswith(point.ctx, ctx_filter))
+			return true;
+
+		char pbuf[3][32];
+		out
+		<< std::left << std::setw(40) << point.column << " "
+		<< std::left << std::setw(8) << point.op << " "
+		<< std::left << std::setw(24) << point.ctx << " "
+		<< std::right << std::setw(10) << point.count << " "
+		<< std::right << std::setw(10) << pretty(pbuf[0], point.percentile(0.50), 1) << " "
+		<< std::right << std::setw(10) << pretty(pbuf[1], point.percentile(0.99), 1) << " "
+		<< std::right << std::setw(10) << pretty(pbuf[2], point.max, 1) << " "
+		<< std::right << std::setw(10) << point.memtable << " "
+		<< std::right << std::setw(10) << point.cache << " "
+		<< std::right << std::setw(10) << point.disk << " "
+		<< std::endl;
+		return true;
+	});
+
+	return true;
+}
+
+bool
+console_cmd__db__trace__clear(opt &out, const string_view &line)
+{
+	db::trace::clear();
+	out << "cleared." << std::endl;
+	return true;
+}
+
 bool
 console_cmd__db__prop(opt &out, const string_view &line)
 try
@@ -4090,6 +4818,90 @@ catch(const std::out_of_range &e)
 	return true;
 }
 
+bool
+console_cmd__db__cache__meta(opt &out, const string_view &line)
+try
+{
+	const params param{line, " ",
+	{
+		"dbname"
+	}};
+
+	const auto dbname
+	{
+		param.at(0)
+	};
+
+	auto &database
+	{
+		db::database::get(dbname)
+	};
+
+	out << std::left
+	    << std::setw(10) << "BLOCK"
+	    << std::right
+	    << " "
+	    << std::setw(11) << "HITS"
+	    << " "
+	    << std::setw(10) << "MISSES"
+	    << " "
+	    << std::setw(9) << "HIT%"
+	    << "  "
+	    << std::setw(26) << "INSERT TOTAL"
+	    << " "
+	    << std::endl;
+
+	const auto output{[&out, &database]
+	(const string_view &type)
+	{
+		thread_local char buf[3][64];
+		const auto hits
+		{
+			db::ticker(database, string_view(fmt::sprintf{buf[0], "rocksdb.block.cache.%s.hit", type}))
+		};
+
+		const auto misses
+		{
+			db::ticker(database, string_view(fmt::sprintf{buf[1], "rocksdb.block.cache.%s.miss", type}))
+		};
+
+		const auto inserts_bytes
+		{
+			db::ticker(database, string_view(fmt::sprintf{buf[2], "rocksdb.block.cache.%s.bytes.insert", type}))
+		};
+
+		const auto hit_pct
+		{
+			(misses + hits) > 0? (double(hits) / double(hits + misses)) : 0.0L
+		};
+
+		out << std::left
+		    << std::setw(10) << type
+		    << std::right
+		    << " "
+		    << std::setw(11) << hits
+		    << " "
+		    << std::setw(10) << misses
+		    << " "
+		    << std::setw(8) << std::right << std::fixed << std::setprecision(2) << (hit_pct * 100)
+		    << '%'
+		    << "  "
+		    << std::setw(26) << std::right << pretty(iec(inserts_bytes))
+		    << " "
+		    << std::endl;
+	}};
+
+	output("index");
+	output("filter");
+	output("data");
+	return true;
+}
+catch(const std::out_of_range &e)
+{
+	out << "No open database by that name" << std::endl;
+	return true;
+}
+
 bool
 console_cmd__db__cache__clear(opt &out, const string_view &line)
 try
@@ -5161,6 +5973,37 @@ catch(const std::out_of_range &e)
 	return true;
 }
 
+bool
+console_cmd__db__backup(opt &out, const string_view &line)
+try
+{
+	const params param{line, " ",
+	{
+		"dbname", "dir"
+	}};
+
+	auto &database
+	{
+		db::database::get(param.at("dbname"))
+	};
+
+	const auto seqnum
+	{
+		backup(database, param.at("dir"))
+	};
+
+	out << "Backup " << name(database)
+	    << " at sequence " << seqnum << " complete."
+	    << std::endl;
+
+	return true;
+}
+catch(const std::out_of_range &e)
+{
+	out << "No open database by that name" << std::endl;
+	return true;
+}
+
 bool
 console_cmd__db__check(opt &out, const string_view &line)
 try
@@ -6809,6 +7652,7 @@ console_cmd__resource(opt &out, const string_view &line)
 		    << (m.opts->flags & resource::method::RATE_LIMITED? " RATE_LIMITED" : "")
 		    << (m.opts->flags & resource::method::VERIFY_ORIGIN? " VERIFY_ORIGIN" : "")
 		    << (m.opts->flags & resource::method::CONTENT_DISCRETION? " CONTENT_DISCRETION" : "")
+		    << (m.opts->flags & resource::method::SHEDDABLE? " SHEDDABLE" : "")
 		    << std::endl;
 
 		return true;
@@ -7869,26 +8713,72 @@ console_cmd__events__refs(opt &out, const string_view &line)
 }
 
 bool
-console_cmd__events__dump(opt &out, const string_view &line)
+console_cmd__events__dump(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"filename"
+	}};
+
+	const auto filename
+	{
+		param.at(0)
+	};
+
+	m::events::dump__file(filename);
+	return true;
+}
+
+bool
+console_cmd__events__dump__jsonl(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"prefix", "start", "stop", "parts"
+	}};
+
+	const m::events::range range
+	{
+		param.at<m::event::idx>("start", 0UL),
+		param.at<m::event::idx>("stop", -1UL),
+	};
+
+	const auto count
+	{
+		m::events::dump__jsonl(param.at("prefix"), range, param.at<size_t>("parts", 0UL))
+	};
+
+	out << "dumped " << count << " events" << std::endl;
+	return true;
+}
+
+bool
+console_cmd__events__load__jsonl(opt &out, const string_view &line)
 {
 	const params param{line, " ",
 	{
 		"filename"
 	}};
 
-	const auto filename
+	const auto count
 	{
-		param.at(0)
+		m::events::load__jsonl(param.at("filename"))
 	};
 
-	m::events::dump__file(filename);
+	out << "loaded " << count << " events" << std::endl;
 	return true;
 }
 
 bool
 console_cmd__events__rebuild(opt &out, const string_view &line)
 {
-	m::events::rebuild();
+	const m::events::rebuild rebuild;
+	out << "resumed from " << rebuild.resumed
+	    << " events " << rebuild.visited
+	    << " indexed " << rebuild.indexed
+	    << " commits " << rebuild.commits
+	    << std::endl;
+
 	return true;
 }
 
@@ -8293,6 +9183,7 @@ console_cmd__event__erase(opt &out, const string_view &line)
 	opts.event_idx = index(event);
 	m::dbs::write(txn, event, opts);
 	txn();
+	m::event::fetch::invalidate(opts.event_idx);
 
 	out << "erased " << txn.size() << " cells"
 	    << " for " << event_id << std::endl;
@@ -8666,7 +9557,7 @@ console_cmd__eval__file(opt &out, const string_view &line)
 {
 	const params param{line, " ",
 	{
-		"path", "limit"
+		"path", "limit", "bulk"
 	}};
 
 	const auto path
@@ -8679,6 +9570,11 @@ console_cmd__eval__file(opt &out, const string_view &line)
 		param.at<size_t>("limit", -1UL)
 	};
 
+	const bool bulk
+	{
+		param["bulk"] == "bulk"
+	};
+
 	fs::fd::opts file_opts(std::ios::in);
 	const fs::fd file
 	{
@@ -8698,8 +9594,11 @@ console_cmd__eval__file(opt &out, const string_view &line)
 	};
 
 	m::vm::opts vm_opts;
-	vm_opts.infolog_accept = true;
+	vm_opts.infolog_accept = !bulk;
 	vm_opts.limit = limit;
+	vm_opts.bulk = bulk;
+	vm_opts.notify_clients = !bulk;
+	vm_opts.notify_servers = !bulk;
 	m::vm::eval
 	{
 		events, vm_opts
@@ -10455,6 +11354,54 @@ console_cmd__room__state__history(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__room__state__resolve(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"room_id", "event_id"
+	}};
+
+	const auto &room_id
+	{
+		m::room_id(param.at("room_id"))
+	};
+
+	std::vector<m::event::id> event_ids;
+	tokens(tokens_after(line, ' ', 0), ' ', [&event_ids]
+	(const string_view &event_id)
+	{
+		event_ids.emplace_back(event_id);
+	});
+
+	const m::room::state::resolve resolve
+	{
+		room_id, event_ids
+	};
+
+	for(const auto &[cell, event_idx] : resolve.state)
+	{
+		const m::event::fetch event
+		{
+			std::nothrow, event_idx
+		};
+
+		if(!event.valid)
+			continue;
+
+		m::pretty_stateline(out, event, event_idx);
+	}
+
+	out
+	<< std::endl
+	<< "conflicted:       " << resolve.conflicted << std::endl
+	<< "auth difference:  " << resolve.auth_difference << std::endl
+	<< "rejected:         " << resolve.rejected << std::endl
+	;
+
+	return true;
+}
+
 bool
 console_cmd__room__state__space(opt &out, const string_view &line)
 {
@@ -16186,6 +17133,423 @@ console_cmd__fed__version(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// load
+//
+
+/// Report of the latencies of one kind of request made by a load generator.
+static void
+load_report(opt &out,
+            const string_view &name,
+            std::vector<microseconds> &latency,
+            const size_t &errors,
+            const nanoseconds &elapsed)
+{
+	std::sort(begin(latency), end(latency));
+	const auto pct{[&latency](const double &p)
+	{
+		return latency.empty()?
+			0L:
+			latency.at(std::min(latency.size() - 1, size_t(p * latency.size()))).count();
+	}};
+
+	const auto secs
+	{
+		duration_cast<duration<double>>(elapsed).count()
+	};
+
+	out
+	<< std::left << std::setw(8) << name
+	<< " ok:" << latency.size()
+	<< " err:" << errors
+	<< " rate:" << std::fixed << std::setprecision(2)
+	<< (secs > 0.0? latency.size() / secs : 0.0) << "/s"
+	<< " p50:" << pct(0.50) << "us"
+	<< " p90:" << pct(0.90) << "us"
+	<< " p99:" << pct(0.99) << "us"
+	<< " max:" << pct(1.00) << "us"
+	<< std::endl;
+}
+
+/// Transactions of new events in the room sent to the remote by this
+/// server over federation. The events are created by the local user as
+/// usual except they are not sent by the federation sender, so the only
+/// copies the remote receives are in these transactions.
+bool
+console_cmd__load__fed(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"remote", "room_id", "user_id", "txns", "pdus", "concurrency"
+	}};
+
+	const string_view remote
+	{
+		param.at("remote")
+	};
+
+	const auto room_id
+	{
+		m::room_id(param.at("room_id"))
+	};
+
+	const m::user::id user_id
+	{
+		param.at("user_id")
+	};
+
+	const size_t txns
+	{
+		param.at("txns", 100UL)
+	};
+
+	const size_t pdus_max
+	{
+		std::clamp(param.at("pdus", 10UL), 1UL, 50UL)
+	};
+
+	const size_t concurrency
+	{
+		std::max(param.at("concurrency", 4UL), 1UL)
+	};
+
+	if(!my(user_id))
+		throw error
+		{
+			"The sender must be a local user joined to the room."
+		};
+
+	m::vm::copts copts;
+	copts.notify_servers = false;
+	const m::room room
+	{
+		room_id, &copts
+	};
+
+	size_t next(0), errors(0), pdu_errors(0);
+	std::vector<microseconds> latency;
+	latency.reserve(txns);
+
+	const auto worker{[&]
+	{
+		const unique_buffer<mutable_buffer> buf
+		{
+			16_KiB
+		};
+
+		while(next < txns) try
+		{
+			const auto i(next++);
+			std::vector<std::string> source(pdus_max);
+			std::vector<json::value> pdus(pdus_max);
+			for(size_t j(0); j < pdus_max; ++j)
+			{
+				char body[64];
+				const auto event_id
+				{
+					m::message(room, user_id, fmt::sprintf
+					{
+						body, "load %zu:%zu", i, j
+					})
+				};
+
+				source[j] = json::strung(m::event::fetch{event_id});
+				pdus[j] = json::object{source[j]};
+			}
+
+			const std::string txn
+			{
+				m::txn::create(pdus)
+			};
+
+			char idbuf[128];
+			const auto txnid
+			{
+				m::txn::create_id(idbuf, txn)
+			};
+
+			m::fed::send::opts opts;
+			opts.remote = remote;
+			const ircd::timer timer;
+			m::fed::send request
+			{
+				txnid, const_buffer{txn}, buf, std::move(opts)
+			};
+
+			request.wait(seconds(60));
+			request.get();
+			latency.emplace_back(timer.at<microseconds>());
+
+			const m::fed::send::response response
+			{
+				json::object{request}
+			};
+
+			response.for_each_pdu([&pdu_errors]
+			(const m::event::id &event_id, const json::object &error)
+			{
+				pdu_errors += !empty(error);
+			});
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			++errors;
+			log::derror
+			{
+				"load fed %s :%s", remote, e.what()
+			};
+		}
+	}};
+
+	const ircd::timer timer;
+	std::vector<context> workers(concurrency);
+	for(auto &context : workers)
+		context = ircd::context
+		{
+			"load.fed", 512_KiB, ircd::context::POST, worker
+		};
+
+	for(auto &context : workers)
+		context.join();
+
+	load_report(out, "send", latency, errors, timer.at<nanoseconds>());
+	out << "pdu errors:" << pdu_errors << std::endl;
+	return true;
+}
+
+/// Request of the client API of the remote with the access token; the
+/// response content is returned in the buffer.
+static http::code
+load_client_request(const net::hostport &remote,
+                    const string_view &access_token,
+                    const string_view &method,
+                    const string_view &path,
+                    const string_view &content,
+                    const mutable_buffer &buf,
+                    string_view &response)
+{
+	char authbuf[512];
+	const http::header headers[]
+	{
+		{ "Authorization", fmt::sprintf
+		{
+			authbuf, "Bearer %s", access_token
+		}},
+	};
+
+	window_buffer wb{buf};
+	http::request
+	{
+		wb,
+		host(remote),
+		method,
+		path,
+		size(content),
+		content? "application/json; charset=utf-8"_sv : string_view{},
+		headers,
+	};
+
+	server::out out;
+	out.head = wb.completed();
+	out.content = content;
+
+	server::in in;
+	in.head = wb.remains();
+	in.content = in.head;
+
+	server::request request
+	{
+		remote, std::move(out), std::move(in)
+	};
+
+	const auto code
+	{
+		request.get(seconds(90))
+	};
+
+	response = request.in.content;
+	return code;
+}
+
+/// Clients each sending messages into the room through the client API of
+/// the remote while long-polling /sync; the sync latency is the time for
+/// each poll to return with new events.
+bool
+console_cmd__load__client(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"remote", "access_token", "room_id", "clients", "messages"
+	}};
+
+	const net::hostport remote
+	{
+		param.at("remote")
+	};
+
+	const string_view access_token
+	{
+		param.at("access_token")
+	};
+
+	const auto room_id
+	{
+		m::room_id(param.at("room_id"))
+	};
+
+	const size_t clients
+	{
+		std::max(param.at("clients", 8UL), 1UL)
+	};
+
+	const size_t messages
+	{
+		param.at("messages", 100UL)
+	};
+
+	char room_id_buf[768];
+	const string_view room_id_encoded
+	{
+		url::encode(room_id_buf, room_id)
+	};
+
+	size_t send_errors(0), sync_errors(0);
+	std::vector<microseconds> send_latency, sync_latency;
+	send_latency.reserve(clients * messages);
+
+	const auto sender{[&](const size_t &client)
+	{
+		const unique_buffer<mutable_buffer> buf
+		{
+			64_KiB
+		};
+
+		for(size_t i(0); i < messages; ++i) try
+		{
+			char pathbuf[1024], contentbuf[128], bodybuf[64];
+			const string_view path{fmt::sprintf
+			{
+				pathbuf, "/_matrix/client/r0/rooms/%s/send/m.room.message/load.%lu.%zu.%zu",
+				room_id_encoded,
+				ircd::time(),
+				client,
+				i,
+			}};
+
+			const json::object content{json::stringify(mutable_buffer{contentbuf}, json::members
+			{
+				{ "msgtype",  "m.text"                                           },
+				{ "body",     fmt::sprintf{bodybuf, "load %zu:%zu", client, i} },
+			})};
+
+			string_view response;
+			const ircd::timer timer;
+			load_client_request(remote, access_token, "PUT", path, content, buf, response);
+			send_latency.emplace_back(timer.at<microseconds>());
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			++send_errors;
+			log::derror
+			{
+				"load client send :%s", e.what()
+			};
+		}
+	}};
+
+	const auto syncer{[&]
+	{
+		const unique_buffer<mutable_buffer> buf
+		{
+			1_MiB
+		};
+
+		char since[256] {0};
+		while(1) try
+		{
+			char pathbuf[512];
+			const string_view path{fmt::sprintf
+			{
+				pathbuf, "/_matrix/client/r0/sync?timeout=30000&filter=%s%s%s",
+				"%7B%22room%22%3A%7B%22timeline%22%3A%7B%22limit%22%3A1%7D%7D%7D",
+				since[0]? "&since="_sv : string_view{},
+				string_view{since},
+			}};
+
+			string_view response;
+			const ircd::timer timer;
+			load_client_request(remote, access_token, "GET", path, {}, buf, response);
+			if(since[0])
+				sync_latency.emplace_back(timer.at<microseconds>());
+
+			const json::string next_batch
+			{
+				json::object{response}["next_batch"]
+			};
+
+			strlcpy(since, next_batch);
+		}
+		catch(const ctx::interrupted &)
+		{
+			return;
+		}
+		catch(const std::exception &e)
+		{
+			++sync_errors;
+			log::derror
+			{
+				"load client sync :%s", e.what()
+			};
+
+			ctx::sleep(seconds(1));
+		}
+	}};
+
+	const ircd::timer timer;
+	std::vector<context> senders(clients), syncers(clients);
+	for(size_t i(0); i < clients; ++i)
+	{
+		syncers[i] = ircd::context
+		{
+			"load.sync", 512_KiB, ircd::context::POST, syncer
+		};
+
+		senders[i] = ircd::context
+		{
+			"load.send", 512_KiB, ircd::context::POST, [&sender, i]
+			{
+				sender(i);
+			}
+		};
+	}
+
+	for(auto &context : senders)
+		context.join();
+
+	const auto elapsed
+	{
+		timer.at<nanoseconds>()
+	};
+
+	for(auto &context : syncers)
+	{
+		context.interrupt();
+		context.join();
+	}
+
+	load_report(out, "send", send_latency, send_errors, elapsed);
+	load_report(out, "sync", sync_latency, sync_errors, elapsed);
+	return true;
+}
+
 //
 // file
 //
@@ -16563,6 +17927,7 @@ console_cmd__fetch(opt &out, const string_view &line)
 		<< std::left << "S:" << request.started << " "
 		<< std::left << "A:" << request.attempted.size() << " "
 		<< std::left << "E:" << bool(request.eptr) << " "
+		<< std::left << "H:" << trunc(request.hedge_origin, 32) << " "
 		<< std::left << "F:" << request.finished << " "
 		<< std::endl
 		;
@@ -29,6 +29,11 @@ backfill_resource
 static size_t
 calc_limit(const m::resource::request &request);
 
+static size_t
+backfill_seeds(const vector_view<m::event::idx> &out,
+               const m::resource::request &request,
+               const m::room::id &room_id);
+
 m::resource::response
 get__backfill(client &client,
               const m::resource::request &request);
@@ -63,6 +68,13 @@ backfill_flush_hiwat
 	{ "default",  16384L                                 },
 };
 
+conf::item<size_t>
+backfill_fetch_batch
+{
+	{ "name",     "ircd.federation.backfill.fetch.batch" },
+	{ "default",  64L                                    },
+};
+
 m::resource::response
 get__backfill(client &client,
               const m::resource::request &request)
@@ -84,13 +96,6 @@ get__backfill(client &client,
 			"You are not permitted by the room's server access control list."
 		};
 
-	m::event::id::buf event_id
-	{
-		request.query["v"]?
-			url::decode(event_id, request.query.at("v")):
-			m::head(room_id)
-	};
-
 	const bool ids_only
 	{
 		request.query.get<bool>("pdu_ids", false)
@@ -101,9 +106,20 @@ get__backfill(client &client,
 		calc_limit(request)
 	};
 
-	m::room::events it
+	m::event::idx seed[16];
+	const size_t seeds
+	{
+		backfill_seeds(seed, request, room_id)
+	};
+
+	const size_t batch_max
+	{
+		std::clamp(size_t(backfill_fetch_batch), 1UL, 512UL)
+	};
+
+	const m::visibility visibility
 	{
-		room_id, event_id
+		room_id, request.node_id
 	};
 
 	m::resource::response::chunked response
@@ -122,22 +138,107 @@ get__backfill(client &client,
 		top, ids_only? "pdu_ids": "pdus"
 	};
 
+	// The walk proceeds from the greatest event_idx in the frontier, which
+	// is the order the server came to know the events; the prev_events of a
+	// page join the frontier once the page is fetched. Every event taken
+	// from the frontier counts toward the limit, visible or not.
+	std::set<m::event::idx> seen(seed, seed + seeds);
+	std::priority_queue<m::event::idx> frontier(seed, seed + seeds);
+
+	std::vector<m::event::idx> page_idx;
+	std::vector<m::event::id::buf> page_id(batch_max);
+	std::vector<db::column> column;
+	std::vector<string_view> key;
+	std::vector<m::event::id> prev_id;
+	std::vector<m::event::idx> prev_idx;
+	std::vector<std::pair<size_t, size_t>> json_pos;
+	std::string buf;
+
 	size_t count{0};
-	for(; it && count < limit; ++count, --it)
+	while(!frontier.empty() && count < limit)
 	{
-		const m::event &event
+		page_idx.clear();
+		while(!frontier.empty() && page_idx.size() < std::min(batch_max, limit - count))
 		{
-			*it
-		};
+			page_idx.emplace_back(frontier.top());
+			frontier.pop();
+		}
+
+		count += page_idx.size();
+		column.assign(page_idx.size(), m::dbs::event_json);
+		key.clear();
+		for(const auto &event_idx : page_idx)
+			key.emplace_back(byte_view<string_view>(event_idx));
+
+		// The JSON is copied out of the database so the client socket can be
+		// flushed while it's kept; it is spliced into the response verbatim.
+		buf.clear();
+		json_pos.assign(page_idx.size(), {0, 0});
+		db::read(column, key, [&buf, &json_pos]
+		(const size_t &i, const string_view &val, const bool &found)
+		{
+			json_pos.at(i) = {buf.size(), found? size(val): 0};
+			buf.append(begin(val), begin(val) + json_pos[i].second);
+		});
+
+		const vector_view<m::event::id::buf> event_id
+		(
+			page_id.data(), page_idx.size()
+		);
+
+		m::event_id(std::nothrow, event_id, page_idx);
+
+		prev_id.clear();
+		for(size_t i(0); i < page_idx.size(); ++i) try
+		{
+			const json::object source
+			{
+				string_view{buf.data() + json_pos[i].first, json_pos[i].second}
+			};
+
+			if(!source || !event_id[i])
+				continue;
 
-		assert(event.event_id);
-		if(!visible(event, request.node_id))
-			continue;
+			const m::event event
+			{
+				source, event_id[i]
+			};
 
-		if(ids_only)
-			pdus.append(event.event_id);
-		else
-			pdus.append(event);
+			if(json::get<"room_id"_>(event) != room_id)
+				continue;
+
+			const m::event::prev prev
+			{
+				event
+			};
+
+			for(size_t j(0); j < prev.prev_events_count(); ++j)
+				prev_id.emplace_back(prev.prev_event(j));
+
+			if(!visibility(event))
+				continue;
+
+			if(ids_only)
+				pdus.append(event.event_id);
+			else
+				pdus.append(source);
+		}
+		catch(const std::exception &e)
+		{
+			log::derror
+			{
+				m::log, "Backfill of %s at idx:%lu :%s",
+				string_view{room_id},
+				page_idx[i],
+				e.what(),
+			};
+		}
+
+		prev_idx.assign(prev_id.size(), 0);
+		m::index(prev_idx, prev_id);
+		for(const auto &event_idx : prev_idx)
+			if(event_idx && seen.emplace(event_idx).second)
+				frontier.emplace(event_idx);
 	}
 
 	return std::move(response);
@@ -161,3 +262,50 @@ calc_limit(const m::resource::request &request)
 
 	return std::min(ret, size_t(backfill_limit_max));
 }
+
+static size_t
+backfill_seeds(const vector_view<m::event::idx> &out,
+               const m::resource::request &request,
+               const m::room::id &room_id)
+{
+	if(!request.query.has("v"))
+	{
+		out.at(0) = m::head_idx(std::nothrow, room_id);
+		return out[0] != 0;
+	}
+
+	const size_t count
+	{
+		std::min(request.query.count("v"), out.size())
+	};
+
+	string_view v[16];
+	const unique_mutable_buffer v_buf
+	{
+		m::event::id::MAX_SIZE * count
+	};
+
+	const auto event_id
+	{
+		request.query.array(v_buf, "v", v)
+	};
+
+	m::event::id id[16];
+	for(size_t i(0); i < event_id.size(); ++i)
+		id[i] = m::event::id{event_id[i]};
+
+	const vector_view<const m::event::id> ids
+	(
+		id, event_id.size()
+	);
+
+	std::fill(begin(out), end(out), 0);
+	m::index(out, ids);
+
+	size_t ret(0);
+	for(size_t i(0); i < ids.size(); ++i)
+		if(out[i])
+			out[ret++] = out[i];
+
+	return ret;
+}
@@ -43,7 +43,8 @@ get_method
 {
 	publicrooms_resource, "GET", handle_get,
 	{
-		get_method.VERIFY_ORIGIN
+		get_method.VERIFY_ORIGIN |
+		get_method.SHEDDABLE
 	}
 };
 
@@ -52,7 +53,8 @@ post_method
 {
 	publicrooms_resource, "POST", handle_get,
 	{
-		post_method.VERIFY_ORIGIN
+		post_method.VERIFY_ORIGIN |
+		post_method.SHEDDABLE
 	}
 };
 
@@ -40,6 +40,39 @@ eval_max_per_node
 	{ "default",  4L                                       },
 };
 
+static ctx::pool::opts
+eval_pool_opts
+{
+	1_MiB,                 // stack sz (same as client contexts)
+	0,                     // pool sz
+	-1,                    // queue max hard
+	0,                     // queue max soft
+	true,                  // queue max blocking
+	false,                 // queue max warning
+	0,                     // ionice
+	int8_t(ctx::sched::FEDERATION),
+	8,                     // ctxs max (see: eval_rooms_max)
+	0ms,                   // grow latency
+};
+
+conf::item<size_t>
+eval_rooms_max
+{
+	{
+		{ "name",     "ircd.federation.send.eval.rooms.max" },
+		{ "default",  8L                                     },
+	}, []
+	{
+		eval_pool_opts.ctxs_max = size_t(eval_rooms_max);
+	}
+};
+
+static ctx::pool
+eval_pool
+{
+	"fed.send", eval_pool_opts
+};
+
 conf::item<bool>
 fetch_state
 {
@@ -80,6 +113,57 @@ handle_edu(client &client,
 	};
 }
 
+static void
+handle_room(const m::vm::opts &opts,
+            std::vector<m::event> &events,
+            json::stack::object &out_pdus,
+            ctx::mutex &mutex)
+{
+	// Each room's results are stacked privately and appended to the response
+	// as a whole afterward; vm::output() may yield on a flush in the middle
+	// of an entry, so rooms can't share the response stack while evaluating.
+	const unique_mutable_buffer buf
+	{
+		events.size() * 2_KiB
+	};
+
+	json::stack out
+	{
+		buf
+	};
+
+	{
+		json::stack::object results
+		{
+			out
+		};
+
+		auto vmopts(opts);
+		vmopts.out = &results;
+		if(likely(!vmopts.ordered))
+			std::sort(begin(events), end(events));
+
+		m::vm::eval eval
+		{
+			vector_view<const m::event>(events), vmopts
+		};
+	}
+
+	const std::lock_guard lock
+	{
+		mutex
+	};
+
+	for(const auto &[event_id, result] : json::object(out.completed()))
+		json::stack::member
+		{
+			out_pdus, event_id, json::value
+			{
+				result, json::OBJECT
+			}
+		};
+}
+
 static void
 handle_pdus(client &client,
             const m::resource::request::object<m::txn> &request,
@@ -102,9 +186,44 @@ handle_pdus(client &client,
 	vmopts.phase.set(m::vm::phase::FETCH_PREV, bool(fetch_prev));
 	vmopts.phase.set(m::vm::phase::FETCH_STATE, bool(fetch_state));
 	vmopts.fetch_prev_wait_count = -1;
-	m::vm::eval eval
+
+	// Partition the PDU's by room. Rooms are independent of each other; the
+	// dependency ordering only matters within a room, so each room's events
+	// are evaluated as one group and the groups run concurrently. This way
+	// a room stuck fetching its prev_events doesn't hold up the rest of the
+	// txn. Sequence numbers are still retired in order by the vm.
+	std::map<string_view, std::vector<m::event>, std::less<>> rooms;
+	for(const json::object pdu : pdus)
+		rooms[json::string(pdu["room_id"])].emplace_back(pdu);
+
+	if(likely(rooms.size() <= 1 || size_t(eval_rooms_max) <= 1))
+	{
+		m::vm::eval eval
+		{
+			pdus, vmopts
+		};
+
+		return;
+	}
+
+	std::vector<std::vector<m::event>> groups;
+	groups.reserve(rooms.size());
+	for(auto &[room_id, events] : rooms)
+		groups.emplace_back(std::move(events));
+
+	ctx::mutex mutex;
+	const ctx::prof::lock::label mutex_label
 	{
-		pdus, vmopts
+		&mutex, "federation.send.pdus"
+	};
+
+	ctx::concurrent_for_each<std::vector<m::event>>
+	{
+		eval_pool, groups, [&vmopts, &out_pdus, &mutex]
+		(auto &events)
+		{
+			handle_room(vmopts, events, out_pdus, mutex);
+		}
 	};
 }
 
@@ -180,6 +299,13 @@ handle_put(client &client,
 			"txn_id path parameter required"
 		};
 
+	// The client pool runs its contexts in the interactive class; ingest of
+	// a transaction is scheduled behind the requests of our own clients.
+	const ctx::priority priority
+	{
+		ctx::sched::FEDERATION
+	};
+
 	char txn_id_buf[128];
 	const auto txn_id
 	{
@@ -221,9 +347,12 @@ handle_put(client &client,
 			txn_id
 		};
 
+	// A txn being evaluated may have an eval for each of its rooms; evals
+	// are counted per distinct txn so that limit still applies per txn.
 	size_t evals{0};
 	bool txn_in_progress{false};
-	m::vm::eval::for_each([&txn_id, &request, &evals, &txn_in_progress]
+	std::vector<string_view> txns;
+	m::vm::eval::for_each([&txn_id, &request, &evals, &txn_in_progress, &txns]
 	(const auto &eval)
 	{
 		assert(eval.opts);
@@ -238,7 +367,16 @@ handle_put(client &client,
 			eval.opts->txn_id == txn_id
 		};
 
-		evals += match_node;
+		const bool counted
+		{
+			eval.opts->txn_id &&
+			std::find(begin(txns), end(txns), eval.opts->txn_id) != end(txns)
+		};
+
+		if(match_node && !counted && eval.opts->txn_id)
+			txns.emplace_back(eval.opts->txn_id);
+
+		evals += match_node && !counted;
 		txn_in_progress |= match_txn;
 		return evals < size_t(eval_max_per_node);
 	});
@@ -255,6 +393,15 @@ handle_put(client &client,
 			client, http::ACCEPTED
 		};
 
+	// Refuse the transaction up front while the database is stalling writes;
+	// the origin retries later instead of occupying contexts blocked in the
+	// commit path.
+	if(m::dbs::stalled())
+		return m::resource::response
+		{
+			client, http::TOO_MANY_REQUESTS
+		};
+
 	char chunk[1536];
 	m::resource::response::chunked response
 	{
@@ -18,6 +18,10 @@ send_join__response(client &,
                     const m::room::auth::chain &,
                     json::stack::object &out);
 
+static bool
+send_join__auth_chain(const vector_view<const m::event::idx> &,
+                      const m::event::closure_idx_bool &);
+
 static m::resource::response
 put__send_join(client &,
                const m::resource::request &);
@@ -57,6 +61,20 @@ send_join_resource_v2
 	}
 };
 
+conf::item<size_t>
+send_join_flush_hiwat
+{
+	{ "name",     "ircd.federation.send_join.flush.hiwat" },
+	{ "default",  16384L                                  },
+};
+
+conf::item<bool>
+send_join_omit_members_enable
+{
+	{ "name",     "ircd.federation.send_join.omit_members.enable" },
+	{ "default",  true                                            },
+};
+
 m::resource::method
 method_put
 {
@@ -176,7 +194,7 @@ put__send_join(client &client,
 
 	json::stack out
 	{
-		response.buf, response.flusher()
+		response.buf, response.flusher(), size_t(send_join_flush_hiwat)
 	};
 
 	if(v1)
@@ -223,6 +241,79 @@ send_join__response(client &client,
 		data, "origin", my_host()
 	};
 
+	// MSC3706 partial state: the membership of the room is omitted from the
+	// state except for the joining user and the room's heroes; the auth_chain
+	// is then only that of the state actually sent.
+	const bool omit_members
+	{
+		bool(send_join_omit_members_enable)
+		&& request.query.get<bool>("omit_members", false)
+	};
+
+	std::vector<m::event::idx> state_idx;
+	if(omit_members)
+	{
+		const m::room::id &room_id
+		{
+			at<"room_id"_>(event)
+		};
+
+		std::set<std::string, std::less<>> members
+		{
+			std::string{at<"state_key"_>(event)}
+		};
+
+		m::dbs::room_heroes_for_each(room_id, [&members]
+		(const m::user::id &user_id)
+		{
+			members.emplace(user_id);
+			return true;
+		});
+
+		state.for_each([&state_idx, &members]
+		(const string_view &type, const string_view &state_key, const m::event::idx &event_idx)
+		{
+			if(type != "m.room.member" || members.count(state_key))
+				state_idx.emplace_back(event_idx);
+
+			return true;
+		});
+
+		json::stack::member
+		{
+			data, "members_omitted", json::value{true}
+		};
+
+		json::stack::array servers_in_room
+		{
+			data, "servers_in_room"
+		};
+
+		const m::room::origins origins
+		{
+			room_id
+		};
+
+		origins.for_each(m::room::origins::closure_bool{[&servers_in_room]
+		(const string_view &origin)
+		{
+			servers_in_room.append(origin);
+			return true;
+		}});
+	}
+
+	const auto auth_chain_for_each{[&omit_members, &state_idx, &auth_chain]
+	(const m::event::closure_idx_bool &closure)
+	{
+		return !omit_members?
+			auth_chain.for_each(closure):
+			send_join__auth_chain(state_idx, closure);
+	}};
+
+	// One fetch buffer is reused for every event written to the stream;
+	// the response is flushed as it is built by the json::stack.
+	m::event::fetch fetch;
+
 	// auth_chain
 	if(request.query.get<bool>("auth_chain", true))
 	{
@@ -231,19 +322,14 @@ send_join__response(client &client,
 			data, "auth_chain"
 		};
 
-		auth_chain.for_each(m::event::closure_idx_bool{[&auth_chain_a]
+		auth_chain_for_each([&auth_chain_a, &fetch]
 		(const m::event::idx &event_idx)
 		{
-			const m::event::fetch event
-			{
-				std::nothrow, event_idx
-			};
-
-			if(event.valid)
-				auth_chain_a.append(event);
+			if(seek(std::nothrow, fetch, event_idx))
+				auth_chain_a.append(fetch);
 
 			return true;
-		}});
+		});
 	}
 
 	// auth_chain_ids (non-spec)
@@ -254,21 +340,32 @@ send_join__response(client &client,
 			data, "auth_chain_ids"
 		};
 
-		auth_chain.for_each(m::event::closure_idx_bool{[&auth_chain_a]
+		auth_chain_for_each([&auth_chain_a]
 		(const m::event::idx &event_idx)
 		{
-			const auto &event_id
+			m::event_id(std::nothrow, event_idx, [&auth_chain_a]
+			(const m::event::id &event_id)
 			{
-				m::event_id(std::nothrow, event_idx)
-			};
-
-			if(event_id)
 				auth_chain_a.append(event_id);
+			});
 
 			return true;
-		}});
+		});
 	}
 
+	const auto state_for_each{[&omit_members, &state_idx, &state]
+	(const m::event::closure_idx_bool &closure)
+	{
+		if(!omit_members)
+			return state.for_each(closure);
+
+		for(const auto &event_idx : state_idx)
+			if(!closure(event_idx))
+				return false;
+
+		return true;
+	}};
+
 	// state
 	if(request.query.get<bool>("state", true))
 	{
@@ -277,10 +374,13 @@ send_join__response(client &client,
 			data, "state"
 		};
 
-		state.for_each([&state_a]
-		(const m::event &event)
+		state_for_each([&state_a, &fetch]
+		(const m::event::idx &event_idx)
 		{
-			state_a.append(event);
+			if(seek(std::nothrow, fetch, event_idx))
+				state_a.append(fetch);
+
+			return true;
 		});
 	}
 
@@ -292,11 +392,59 @@ send_join__response(client &client,
 			data, "state_ids"
 		};
 
-		state.for_each(m::event::id::closure{[&state_ids]
-		(const m::event::id &event_id)
+		state_for_each([&state_ids]
+		(const m::event::idx &event_idx)
 		{
-			state_ids.append(event_id);
+			m::event_id(std::nothrow, event_idx, [&state_ids]
+			(const m::event::id &event_id)
+			{
+				state_ids.append(event_id);
+			});
+
 			return true;
-		}});
+		});
 	}
 }
+
+/// The union of the auth chains of several events, each event iterated once
+/// in ascending index. The union is computed from the chain cover when it is
+/// available for all of the events.
+bool
+send_join__auth_chain(const vector_view<const m::event::idx> &events,
+                      const m::event::closure_idx_bool &closure)
+{
+	std::vector<m::event::idx> ae;
+	m::dbs::event_chain_cover cover, un;
+	bool covered(bool(m::room::auth::chain::cover));
+	for(size_t i(0); i < events.size() && covered; ++i)
+		if((covered = m::dbs::event_chain_auth(cover, events[i])))
+			m::dbs::event_chain_merge(un, cover);
+
+	if(covered)
+		m::dbs::event_chain_for_each(un, {}, [&ae]
+		(const m::event::idx &event_idx)
+		{
+			ae.emplace_back(event_idx);
+			return true;
+		});
+	else
+		for(const auto &event_idx : events)
+			m::room::auth::chain{event_idx}.for_each([&ae]
+			(const m::event::idx &event_idx)
+			{
+				ae.emplace_back(event_idx);
+				return true;
+			});
+
+	std::sort(begin(ae), end(ae));
+	const auto end
+	{
+		std::unique(std::begin(ae), std::end(ae))
+	};
+
+	for(auto it(std::begin(ae)); it != end; ++it)
+		if(!closure(*it))
+			return false;
+
+	return true;
+}
@@ -14,6 +14,9 @@ struct unit;
 struct txndata;
 struct txn;
 struct node;
+struct presence_update;
+
+extern conf::item<size_t> txn_bufsz;
 
 struct unit
 :std::enable_shared_from_this<unit>
@@ -22,6 +25,8 @@ struct unit
 
 	enum type type;
 	std::string s;
+	m::event::idx event_idx {0};
+	std::string key;
 
 	unit(std::string s, const enum type &type);
 	unit(const m::event &event);
@@ -32,35 +37,42 @@ struct txndata
 	std::string content;
 	string_view txnid;
 	char txnidbuf[64];
+	server::pooled_buffer buf;
 
-	txndata(std::string content)
+	txndata(std::string content, const const_buffer &hash, const size_t &bufsz)
 	:content{std::move(content)}
-	,txnid{m::txn::create_id(txnidbuf, this->content)}
+	,txnid{b58::encode(txnidbuf, hash)}
+	,buf{bufsz}
 	{}
 };
 
-struct alignas(32_KiB) txn
+struct txn
 :txndata
 ,m::fed::send
 {
 	struct node *node;
 	steady_point timeout;
-	char buf[31_KiB];
+	m::event::idx pdu_first {0};
+	m::event::idx pdu_last {0};
+	bool catchup {false};
 
 	txn(struct node &node,
 	    std::string content,
+	    const const_buffer &hash,
 	    m::fed::send::opts opts)
-	:txndata{std::move(content)}
+	:txndata{std::move(content), hash, size_t(txn_bufsz)}
 	,send{this->txnid, string_view{this->content}, this->buf, std::move(opts)}
 	,node{&node}
 	,timeout{now<steady_point>()} //TODO: conf
 	{}
 };
 
-static_assert
-(
-	sizeof(struct txn) == 32_KiB
-);
+struct presence_update
+{
+	std::string s;
+	uint64_t seq {0};
+	bool priority {false};
+};
 
 struct node
 {
@@ -69,8 +81,24 @@ struct node
 	string_view remote;
 	m::node::room room;
 	server::request::opts sopts;
-	txn *curtxn {nullptr};
+	size_t inflight {0};
+
+	// Catch-up mode: while nonzero, the PDUs for this remote are not queued;
+	// they are read back from the database after this index instead.
+	m::event::idx catchup {0};
+	m::event::idx catchup_seen {0};
+	steady_point catchup_retry;
+
+	// Presence for this remote held by user_id until the presence worker
+	// batches it into an EDU; see presence_flush().
+	std::map<std::string, presence_update, std::less<>> presence;
+
+	size_t presence_flush(const size_t &max);
+	void catchup_save() const;
+	void catchup_enter(const m::event::idx &);
+	bool catchup_flush();
 
+	void flush_txn();
 	bool flush();
 	void push(std::shared_ptr<unit>);
 
@@ -91,13 +119,31 @@ static void recv();
 static void recv_worker();
 ctx::dock recv_action;
 
+static void send_presence(const m::event &, const m::user::id &user_id);
 static void send_from_user(const m::event &, const m::user::id &user_id);
 static void send_to_user(const m::event &, const m::user::id &user_id);
 static void send_to_room(const m::event &, const m::room::id &room_id);
 static void send(const m::event &);
 static void send_worker();
+static void presence_worker();
 
+static std::string txn_create(const mutable_buffer &hash, const vector_view<const string_view> &pdus, const vector_view<const string_view> &edus);
 static void handle_notify(const m::event &, m::vm::eval &);
+static void handle_prelink(const m::event &, m::vm::eval &);
+static void catchup_resume();
+
+extern conf::item<size_t> queue_max;
+extern conf::item<size_t> txns_max;
+extern conf::item<size_t> txn_pdus_max;
+extern conf::item<size_t> txn_edus_max;
+extern conf::item<size_t> catchup_pdus_max;
+extern conf::item<size_t> catchup_scan_max;
+extern conf::item<seconds> catchup_retry;
+extern conf::item<size_t> prelink_max;
+extern conf::item<seconds> prelink_interval;
+extern conf::item<seconds> presence_interval;
+extern conf::item<size_t> presence_budget;
+extern conf::item<size_t> presence_pending_max;
 
 context
 sender
@@ -111,6 +157,12 @@ receiver
 	"m.fedsnd.R", 1_MiB, &recv_worker, context::POST,
 };
 
+context
+presencer
+{
+	"m.fedsnd.P", 256_KiB, &presence_worker, context::POST,
+};
+
 mapi::header
 IRCD_MODULE
 {
@@ -119,11 +171,207 @@ IRCD_MODULE
 	{
 		sender.terminate();
 		receiver.terminate();
+		presencer.terminate();
 		sender.join();
 		receiver.join();
+		presencer.join();
 	}
 };
 
+/// Units queued for a remote beyond this count put it into catch-up mode.
+conf::item<size_t>
+queue_max
+{
+	{ "name",     "ircd.federation.sender.queue.max" },
+	{ "default",  512L                               },
+};
+
+/// Transactions in flight to a remote at once. The spec expects one.
+conf::item<size_t>
+txns_max
+{
+	{ "name",     "ircd.federation.sender.txns.max" },
+	{ "default",  1L                                },
+};
+
+/// HTTP heads of each transaction; drawn from the server buffer pool and
+/// returned to it when the transaction completes.
+conf::item<size_t>
+txn_bufsz
+{
+	{ "name",     "ircd.federation.sender.txn.bufsz" },
+	{ "default",  long(32_KiB)                       },
+};
+
+conf::item<size_t>
+txn_pdus_max
+{
+	{ "name",     "ircd.federation.sender.txn.pdus.max" },
+	{ "default",  50L                                   },
+};
+
+conf::item<size_t>
+txn_edus_max
+{
+	{ "name",     "ircd.federation.sender.txn.edus.max" },
+	{ "default",  100L                                  },
+};
+
+conf::item<size_t>
+catchup_pdus_max
+{
+	{ "name",     "ircd.federation.sender.catchup.pdus.max" },
+	{ "default",  50L                                       },
+};
+
+/// Events read from the database for one catch-up transaction whether or
+/// not they are for the remote.
+conf::item<size_t>
+catchup_scan_max
+{
+	{ "name",     "ircd.federation.sender.catchup.scan.max" },
+	{ "default",  16384L                                    },
+};
+
+conf::item<seconds>
+catchup_retry
+{
+	{ "name",     "ircd.federation.sender.catchup.retry" },
+	{ "default",  30L                                    },
+};
+
+/// Servers of a room to link with ahead of need when a remote event arrives
+/// in it; zero to disable.
+conf::item<size_t>
+prelink_max
+{
+	{ "name",     "ircd.federation.sender.prelink.max" },
+	{ "default",  4L                                   },
+};
+
+conf::item<seconds>
+prelink_interval
+{
+	{ "name",     "ircd.federation.sender.prelink.interval" },
+	{ "default",  60L                                       },
+};
+
+/// Presence held for a remote is sent in one batch each interval.
+conf::item<seconds>
+presence_interval
+{
+	{ "name",     "ircd.federation.sender.presence.interval" },
+	{ "default",  5L                                         },
+};
+
+/// Presence updates sent to a remote per second; the batch of an interval
+/// holds at most this many for each second of it. Changes of state are sent
+/// first; the refreshes of last_active_ago wait for the next interval.
+conf::item<size_t>
+presence_budget
+{
+	{ "name",     "ircd.federation.sender.presence.budget" },
+	{ "default",  20L                                      },
+};
+
+/// Presence updates held for a remote beyond this count are dropped unless
+/// they change the state of the user.
+conf::item<size_t>
+presence_pending_max
+{
+	{ "name",     "ircd.federation.sender.presence.pending.max" },
+	{ "default",  8192L                                         },
+};
+
+std::map<std::string, steady_point, std::less<>>
+prelinked;
+
+m::hookfn<m::vm::eval &>
+notified_prelink
+{
+	handle_prelink,
+	{
+		{ "_site",  "vm.notify" },
+	}
+};
+
+/// Activity in a room from a remote is a prediction of our own traffic to
+/// the room. Servers of the room we have previously contacted, but whose
+/// links have since closed, are linked again here so the next transaction
+/// or fetch doesn't pay for resolution, connection and handshake.
+void
+handle_prelink(const m::event &event,
+               m::vm::eval &eval)
+try
+{
+	if(my(event) || !prelink_max)
+		return;
+
+	const m::room::id &room_id
+	{
+		json::get<"room_id"_>(event)
+	};
+
+	if(!room_id)
+		return;
+
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	auto it
+	{
+		prelinked.lower_bound(room_id)
+	};
+
+	if(it != end(prelinked) && it->first == room_id)
+	{
+		if(it->second > now)
+			return;
+
+		it->second = now + seconds(prelink_interval);
+	}
+	else
+	{
+		if(prelinked.size() >= 4096)
+			for(auto pit(begin(prelinked)); pit != end(prelinked); )
+				pit = pit->second <= now? prelinked.erase(pit): std::next(pit);
+
+		prelinked.emplace(room_id, now + seconds(prelink_interval));
+	}
+
+	size_t linked(0), scanned(0);
+	const m::room::origins origins
+	{
+		room_id
+	};
+
+	origins.for_each(m::room::origins::closure_bool{[&]
+	(const string_view &origin)
+	{
+		if(my_host(origin) || origin == json::get<"origin"_>(event))
+			return true;
+
+		if(m::fed::exists(origin) && !m::fed::linked(origin) && !m::fed::errant(origin))
+			linked += m::fed::prelink(origin);
+
+		return linked < prelink_max && ++scanned < prelink_max * 16;
+	}});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		m::log, "Federation sender prelink handler :%s",
+		e.what()
+	};
+}
+
 std::deque<std::pair<std::string, m::event::id::buf>>
 notified_queue;
 
@@ -178,6 +426,7 @@ void
 __attribute__((noreturn))
 send_worker()
 {
+	catchup_resume();
 	while(1) try
 	{
 		notified_dock.wait([]
@@ -254,6 +503,10 @@ send(const m::event &event)
 			return send_to_user(event, m::user::id(target));
 	}
 
+	// presence is batched for every remote server from the user's rooms.
+	if(type == "m.presence" && valid(m::id::USER, sender))
+		return send_presence(event, m::user::id{sender});
+
 	// target is every remote server from every room a user is joined to.
 	if(valid(m::id::USER, sender))
 		return send_from_user(event, m::user::id{sender});
@@ -411,40 +664,486 @@ send_from_user(const m::event &event,
 	});
 }
 
+/// Last state sent for each of our users; an update which differs is a
+/// change of state rather than a refresh of last_active_ago.
+std::map<std::string, std::string, std::less<>>
+presence_state;
+
+uint64_t
+presence_seq;
+
+/// EDU path for presence. Rather than an EDU to each server for every update,
+/// the update is held by the node of each server, replacing any older one of
+/// the user; the presence worker sends what's held in batches.
+void
+send_presence(const m::event &event,
+              const m::user::id &user_id)
+{
+	const json::array &push
+	{
+		json::get<"content"_>(event).get("push")
+	};
+
+	for(const json::object edu : push)
+	{
+		if(json::string(edu["user_id"]) != user_id)
+			continue;
+
+		char state_buf[64];
+		const string_view state
+		{
+			fmt::sprintf
+			{
+				state_buf, "%s %s",
+				json::string(edu["presence"]),
+				edu.get<bool>("currently_active", false)? "active"_sv: "inactive"_sv,
+			}
+		};
+
+		auto it
+		{
+			presence_state.lower_bound(user_id)
+		};
+
+		if(it == end(presence_state) || it->first != user_id)
+			it = presence_state.emplace_hint(it, user_id, std::string{});
+
+		const bool priority
+		{
+			it->second != state
+		};
+
+		it->second = state;
+		const m::user::servers servers
+		{
+			user_id
+		};
+
+		servers.for_each("join", [&user_id, &edu, &priority]
+		(const string_view &origin)
+		{
+			if(my_host(origin))
+				return true;
+
+			if(m::fed::errant(origin))
+				return true;
+
+			auto it
+			{
+				nodes.lower_bound(origin)
+			};
+
+			if(it == end(nodes) || it->first != origin)
+				it = nodes.emplace_hint(it, origin, origin);
+
+			auto &presence
+			{
+				it->second.presence
+			};
+
+			// The held update keeps its place; only its content is newer.
+			auto pit
+			{
+				presence.lower_bound(user_id)
+			};
+
+			if(pit != end(presence) && pit->first == user_id)
+			{
+				pit->second.s = std::string{edu};
+				pit->second.priority |= priority;
+				return true;
+			}
+
+			if(presence.size() >= size_t(presence_pending_max) && !priority)
+				return true;
+
+			presence.emplace_hint(pit, user_id, presence_update
+			{
+				std::string{edu}, ++presence_seq, priority
+			});
+
+			return true;
+		});
+	}
+}
+
+void
+__attribute__((noreturn))
+presence_worker()
+{
+	while(1) try
+	{
+		ctx::sleep(seconds(presence_interval));
+
+		const size_t max
+		{
+			std::max(size_t(presence_budget) * size_t(seconds(presence_interval).count()), 1UL)
+		};
+
+		// Flushing a node may yield; the map is searched again for each.
+		std::vector<std::string> remotes;
+		for(const auto &[remote, node] : nodes)
+			if(!node.presence.empty())
+				remotes.emplace_back(remote);
+
+		for(const auto &remote : remotes)
+		{
+			const auto it
+			{
+				nodes.find(remote)
+			};
+
+			if(it == end(nodes))
+				continue;
+
+			auto &node(it->second);
+			if(node.presence_flush(max))
+				node.flush();
+		}
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			"presence worker: %s", e.what()
+		};
+	}
+}
+
+/// Moves up to max of the held presence updates into one m.presence EDU on
+/// the queue. Changes of state go first, then refreshes; each oldest first.
+/// Returns the number of updates taken.
+size_t
+node::presence_flush(const size_t &max)
+{
+	std::vector<decltype(presence)::iterator> sel;
+	sel.reserve(presence.size());
+	for(auto it(begin(presence)); it != end(presence); ++it)
+		sel.emplace_back(it);
+
+	const size_t count
+	{
+		std::min(max, sel.size())
+	};
+
+	if(!count)
+		return 0;
+
+	std::partial_sort(begin(sel), begin(sel) + count, end(sel), []
+	(const auto &a, const auto &b)
+	{
+		return a->second.priority != b->second.priority?
+			a->second.priority:
+			a->second.seq < b->second.seq;
+	});
+
+	static const string_view prefix
+	{
+		R"({"content":{"push":[)"
+	};
+
+	static const string_view suffix
+	{
+		R"(]},"edu_type":"m.presence"})"
+	};
+
+	size_t len(size(prefix) + size(suffix));
+	for(auto it(begin(sel)); it != begin(sel) + count; ++it)
+		len += size((*it)->second.s) + 1;
+
+	std::string s;
+	s.reserve(len);
+	s.append(prefix);
+	for(auto it(begin(sel)); it != begin(sel) + count; ++it)
+	{
+		if(it != begin(sel))
+			s.push_back(',');
+
+		s.append((*it)->second.s);
+		presence.erase(*it);
+	}
+
+	s.append(suffix);
+	push(std::make_shared<struct unit>(std::move(s), unit::EDU));
+	return count;
+}
+
 void
 node::push(std::shared_ptr<unit> su)
 {
+	// The PDU will be found by the catch-up; it is noted so the catch-up
+	// doesn't end before reaching it.
+	if(catchup && su->type == unit::PDU)
+	{
+		catchup_seen = std::max(catchup_seen, su->event_idx);
+		return;
+	}
+
+	if(q.size() >= size_t(queue_max))
+	{
+		m::event::idx first(0);
+		for(const auto &unit : q)
+			if(unit->type == unit::PDU && unit->event_idx)
+			{
+				first = unit->event_idx;
+				break;
+			}
+
+		if(!first && su->type == unit::PDU)
+			first = su->event_idx;
+
+		// The queued PDUs are dropped; the catch-up starts before the first.
+		if(first)
+			q.erase(std::remove_if(begin(q), end(q), [](const auto &unit)
+			{
+				return unit->type == unit::PDU;
+			}), end(q));
+
+		// Nothing can be recovered for an EDU; the oldest is dropped.
+		if(q.size() >= size_t(queue_max))
+			q.pop_front();
+
+		if(first)
+			catchup_enter(first - 1);
+
+		if(catchup && su->type == unit::PDU)
+		{
+			catchup_seen = std::max(catchup_seen, su->event_idx);
+			return;
+		}
+	}
+
+	// A queued EDU superseded by this one is replaced in its position.
+	if(su->type == unit::EDU && !su->key.empty())
+		for(auto it(rbegin(q)); it != rend(q); ++it)
+			if((*it)->type == unit::EDU && (*it)->key == su->key)
+			{
+				*it = std::move(su);
+				return;
+			}
+
 	q.emplace_back(std::move(su));
 }
 
+void
+node::catchup_enter(const m::event::idx &cursor)
+{
+	if(catchup)
+		return;
+
+	catchup = std::max(cursor, 1UL);
+	catchup_seen = 0;
+	log::notice
+	{
+		m::log, "Federation sender to '%s' catching up after event_idx:%lu",
+		remote,
+		catchup,
+	};
+
+	catchup_save();
+}
+
+/// Persist the cursor to the node's room so the catch-up resumes after a
+/// restart. A zero cursor records that the remote has caught up.
+void
+node::catchup_save()
+const try
+{
+	if(!exists(room.room_id))
+		create(room, m::me());
+
+	send(room, m::me(), "ircd.federation.sender.catchup", "", json::members
+	{
+		{ "remote",     remote        },
+		{ "event_idx",  long(catchup) },
+	});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "Federation sender to '%s' failed to save catch-up cursor %lu :%s",
+		remote,
+		catchup,
+		e.what(),
+	};
+}
+
+/// Read the PDUs after the cursor for this remote out of the database into
+/// a transaction. When nothing is left the remote leaves catch-up mode and
+/// the queue resumes.
+bool
+node::catchup_flush()
+{
+	assert(catchup);
+	assert(!inflight);
+	if(now<steady_point>() < catchup_retry)
+		return true;
+
+	// Each window of the scan is bounded; the cursor is advanced over a
+	// window which had nothing for the remote.
+	std::vector<std::string> pdus;
+	m::event::idx last(catchup);
+	while(pdus.empty())
+	{
+		const auto end
+		{
+			std::max(m::vm::sequence::retired, catchup_seen)
+		};
+
+		if(last >= end)
+			break;
+
+		const m::events::range range
+		{
+			last + 1, end + 1
+		};
+
+		size_t scanned(0);
+		m::events::for_each(range, [this, &pdus, &last, &scanned]
+		(const m::event::idx &event_idx, const m::event &event)
+		{
+			if(scanned++ >= size_t(catchup_scan_max))
+				return false;
+
+			last = event_idx;
+			if(!event.event_id || !my(event))
+				return true;
+
+			if(json::get<"depth"_>(event) == json::undefined_number)
+				return true;
+
+			if(!valid(m::id::ROOM, json::get<"room_id"_>(event)))
+				return true;
+
+			const m::room::origins origins
+			{
+				m::room::id{json::get<"room_id"_>(event)}
+			};
+
+			if(!origins.has(remote))
+				return true;
+
+			pdus.emplace_back(json::strung{event});
+			return pdus.size() < size_t(catchup_pdus_max);
+		});
+
+		// The whole range was scanned; indexes with no event are passed too.
+		if(pdus.empty() && scanned <= size_t(catchup_scan_max))
+			last = end;
+
+		if(pdus.empty())
+			catchup = last;
+	}
+
+	if(pdus.empty())
+	{
+		log::notice
+		{
+			m::log, "Federation sender to '%s' caught up at event_idx:%lu",
+			remote,
+			last,
+		};
+
+		catchup = 0;
+		catchup_seen = 0;
+		catchup_save();
+		return flush();
+	}
+
+	std::vector<string_view> units(begin(pdus), end(pdus));
+	m::fed::send::opts opts;
+	opts.remote = remote;
+	opts.dynamic = false;
+	opts.sopts = &sopts;
+
+	char hash[crh::sha256::digest_size];
+	std::string content
+	{
+		txn_create(hash, units, {})
+	};
+
+	txns.emplace_back(*this, std::move(content), hash, std::move(opts));
+	auto &txn(txns.back());
+	txn.catchup = true;
+	txn.pdu_first = catchup + 1;
+	txn.pdu_last = last;
+	++inflight;
+	log::debug
+	{
+		m::log, "sending catch-up txn %s pdus:%zu to '%s' event_idx:%lu:%lu",
+		txn.txnid,
+		pdus.size(),
+		this->remote,
+		txn.pdu_first,
+		txn.pdu_last,
+	};
+
+	recv_action.notify_one();
+	return true;
+}
+
 bool
 node::flush()
 try
 {
-	if(q.empty())
-		return true;
+	if(catchup)
+		return !inflight? catchup_flush(): true;
 
-	if(curtxn)
-		return true;
+	while(!q.empty() && inflight < size_t(txns_max))
+		flush_txn();
 
-	size_t pdus{0}, edus{0};
-	for(const auto &unit : q) switch(unit->type)
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::error
 	{
-		case unit::PDU:   ++pdus;  break;
-		case unit::EDU:   ++edus;  break;
-		default:                   break;
+		"flush error to %s :%s", remote, e.what()
+	};
+
+	return false;
+}
+
+/// Creates one transaction from the front of the queue, taking no more units
+/// than the spec limits of a transaction; the rest remain queued.
+void
+node::flush_txn()
+{
+	size_t pdus{0}, edus{0}, taken{0};
+	for(const auto &unit : q)
+	{
+		if(pdus >= size_t(txn_pdus_max) && edus >= size_t(txn_edus_max))
+			break;
+
+		if(unit->type == unit::PDU && pdus >= size_t(txn_pdus_max))
+			break;
+
+		if(unit->type == unit::EDU && edus >= size_t(txn_edus_max))
+			break;
+
+		pdus += unit->type == unit::PDU;
+		edus += unit->type == unit::EDU;
+		++taken;
 	}
 
 	size_t pc(0), ec(0);
-	std::vector<json::value> units(pdus + edus);
-	for(const auto &unit : q) switch(unit->type)
+	m::event::idx pdu_first(0), pdu_last(0);
+	std::vector<string_view> units(pdus + edus);
+	for(auto it(begin(q)); it != begin(q) + taken; ++it) switch((*it)->type)
 	{
 		case unit::PDU:
-			units.at(pc++) = string_view{unit->s};
+			units.at(pc++) = (*it)->s;
+			pdu_first = pdu_first?: (*it)->event_idx;
+			pdu_last = std::max(pdu_last, (*it)->event_idx);
 			break;
 
 		case unit::EDU:
-			units.at(pdus + ec++) = string_view{unit->s};
+			units.at(pdus + ec++) = (*it)->s;
 			break;
 
 		default:
@@ -456,45 +1155,112 @@ try
 	opts.dynamic = false;
 	opts.sopts = &sopts;
 
-	const vector_view<const json::value> pduv
+	const vector_view<const string_view> pduv
 	{
 		units.data(), units.data() + pc
 	};
 
-	const vector_view<const json::value> eduv
+	const vector_view<const string_view> eduv
 	{
 		units.data() + pdus, units.data() + pdus + ec
 	};
 
+	char hash[crh::sha256::digest_size];
 	std::string content
 	{
-		m::txn::create(pduv, eduv)
+		txn_create(hash, pduv, eduv)
 	};
 
-	txns.emplace_back(*this, std::move(content), std::move(opts));
+	txns.emplace_back(*this, std::move(content), hash, std::move(opts));
 	const unwind_nominal_assertion na;
-	curtxn = &txns.back();
-	q.clear();
+	auto &txn(txns.back());
+	txn.pdu_first = pdu_first;
+	txn.pdu_last = pdu_last;
+	q.erase(begin(q), begin(q) + taken);
+	++inflight;
 	log::debug
 	{
-		m::log, "sending txn %s pdus:%zu edus:%zu to '%s'",
-		curtxn->txnid,
+		m::log, "sending txn %s pdus:%zu edus:%zu to '%s' queued:%zu inflight:%zu",
+		txn.txnid,
 		pdus,
 		edus,
 		this->remote,
+		q.size(),
+		inflight,
 	};
 
 	recv_action.notify_one();
-	return true;
 }
-catch(const std::exception &e)
+
+/// Assembles the transaction body directly from the preserialized units; the
+/// units are copied once into a buffer of the exact size. The transaction id
+/// is hashed from the same pieces as they are appended.
+std::string
+txn_create(const mutable_buffer &hash,
+           const vector_view<const string_view> &pdus,
+           const vector_view<const string_view> &edus)
 {
-	log::error
+	char tsbuf[32];
+	const string_view ts
 	{
-		"flush error to %s :%s", remote, e.what()
+		lex_cast(ircd::time<milliseconds>(), tsbuf)
 	};
 
-	return false;
+	const string_view origin
+	{
+		my_host()
+	};
+
+	const auto units_size{[](const auto &units)
+	{
+		return std::accumulate(begin(units), end(units), size_t(units.size()), []
+		(const size_t &ret, const string_view &unit)
+		{
+			return ret + size(unit);
+		});
+	}};
+
+	std::string ret;
+	ret.reserve
+	(
+		64 + size(origin) + size(ts) + units_size(pdus) + units_size(edus)
+	);
+
+	crh::sha256 sha;
+	const auto append{[&ret, &sha]
+	(const string_view &piece)
+	{
+		ret.append(data(piece), size(piece));
+		sha.update(piece);
+	}};
+
+	const auto append_units{[&append]
+	(const string_view &key, const auto &units)
+	{
+		append(key);
+		for(size_t i(0); i < units.size(); ++i)
+		{
+			append(i? ","_sv: "["_sv);
+			append(units[i]);
+		}
+
+		append("]"_sv);
+	}};
+
+	append(R"({"origin":")"_sv);
+	append(origin);
+	append(R"(","origin_server_ts":)"_sv);
+	append(ts);
+	if(!pdus.empty())
+		append_units(R"(,"pdus":)"_sv, pdus);
+
+	if(!edus.empty())
+		append_units(R"(,"edus":)"_sv, edus);
+
+	append("}"_sv);
+	sha.finalize(hash);
+	assert(json::valid(ret, std::nothrow));
+	return ret;
 }
 
 void
@@ -548,10 +1314,33 @@ try
 		recv_handle(txn, node)
 	};
 
-	node.curtxn = nullptr;
+	const bool catchup(txn.catchup);
+	const auto pdu_first(txn.pdu_first), pdu_last(txn.pdu_last);
+	assert(node.inflight > 0);
+	--node.inflight;
 	txns.erase(it);
 
-	if(!ret)
+	// A failed catch-up is retried from the same cursor after a while, or
+	// not before the remote's backoff in ircd::server expires. The PDUs of
+	// a failed transaction are recovered by entering catch-up.
+	if(!ret && catchup)
+	{
+		const auto backoff
+		{
+			duration_cast<seconds>(m::fed::backoff(node.remote) - now<system_point>())
+		};
+
+		node.catchup_retry = now<steady_point>() + std::max(backoff, seconds(catchup_retry));
+	}
+	else if(!ret && pdu_first)
+		node.catchup_enter(pdu_first - 1);
+	else if(catchup)
+	{
+		node.catchup = pdu_last;
+		node.catchup_save();
+	}
+
+	if(!ret && !node.catchup)
 		return;
 
 	node.flush();
@@ -671,6 +1460,82 @@ recv_timeout(txn &txn,
 	cancel(txn);
 }
 
+/// Remotes which were catching up when the server went down continue
+/// from the cursor saved in their node room.
+void
+catchup_resume()
+try
+{
+	m::events::type::for_each_in("ircd.federation.sender.catchup", [](const auto &type, const auto &event_idx)
+	{
+		const m::event::fetch event
+		{
+			std::nothrow, event_idx
+		};
+
+		if(!event.valid)
+			return true;
+
+		const m::room room
+		{
+			at<"room_id"_>(event)
+		};
+
+		if(room.get(std::nothrow, type, "") != event_idx)
+			return true;
+
+		const json::object &content
+		{
+			json::get<"content"_>(event)
+		};
+
+		const json::string &remote
+		{
+			content["remote"]
+		};
+
+		const m::event::idx cursor
+		{
+			content.get<m::event::idx>("event_idx", 0UL)
+		};
+
+		if(!cursor || !remote || my_host(remote))
+			return true;
+
+		auto it
+		{
+			nodes.lower_bound(remote)
+		};
+
+		if(it == end(nodes) || it->first != remote)
+			it = nodes.emplace_hint(it, remote, remote);
+
+		auto &node(it->second);
+		node.catchup = cursor;
+		log::info
+		{
+			m::log, "Federation sender to '%s' resuming catch-up after event_idx:%lu",
+			node.remote,
+			node.catchup,
+		};
+
+		node.flush();
+		return true;
+	});
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "Federation sender failed to resume catch-up :%s",
+		e.what(),
+	};
+}
+
 void
 remove_node(const node &node)
 {
@@ -711,6 +1576,32 @@ unit::unit(const m::event &event)
 			return {};
 	}
 }()}
+,event_idx
+{
+	type == PDU?
+		m::index(std::nothrow, event.event_id):
+		0UL
+}
+,key{[this, &event]
+() -> std::string
+{
+	if(this->type != EDU)
+		return {};
+
+	// EDUs of these types only convey the latest state for the sender in
+	// the room; they are coalesced in a queue.
+	const auto &type(json::get<"type"_>(event));
+	if(type != "m.typing" && type != "m.presence" && type != "m.receipt")
+		return {};
+
+	return fmt::snstringf
+	{
+		512, "%s %s %s",
+		type,
+		json::get<"room_id"_>(event),
+		json::get<"sender"_>(event),
+	};
+}()}
 {
 }
 
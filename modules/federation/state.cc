@@ -16,6 +16,20 @@ IRCD_MODULE
 	"federation state"
 };
 
+struct state_snapshot;
+
+static std::shared_ptr<const state_snapshot>
+state_snapshot_get(const m::room &,
+                   const m::event::idx &head_idx);
+
+static void
+append_idx(json::stack::array &,
+           const std::vector<m::event::idx> &);
+
+static void
+append_ids(json::stack::array &,
+           const std::vector<m::event::idx> &);
+
 static m::resource::response
 get__state(client &client,
            const m::resource::request &request);
@@ -65,6 +79,44 @@ state_flush_hiwat
 	{ "default",  16384L                              },
 };
 
+conf::item<size_t>
+state_cache_max
+{
+	{ "name",     "ircd.federation.state.cache.max" },
+	{ "default",  64L                               },
+	{ "description",
+
+	R"(
+	Number of (room, event) snapshots of the state and auth chain held for
+	the /state and /state_ids of past events. The state of the room at an
+	event never changes, so these are only ever evicted, never invalidated.
+	)"}
+};
+
+conf::item<size_t>
+state_fetch_batch
+{
+	{ "name",     "ircd.federation.state.fetch.batch" },
+	{ "default",  64L                                 },
+};
+
+/// The event_idx of the state of the room at an event and of its auth chain.
+/// Responses share the snapshot by reference; an eviction does not affect a
+/// response still being streamed.
+struct state_snapshot
+{
+	std::vector<m::event::idx> state;
+	std::vector<m::event::idx> auth;
+	mutable uint64_t used {0};
+};
+
+/// Snapshots keyed by room_id and event_id.
+static std::map<std::string, std::shared_ptr<const state_snapshot>, std::less<>>
+state_cache;
+
+static uint64_t
+state_cache_clock;
+
 m::resource::response
 get__state(client &client,
            const m::resource::request &request)
@@ -107,16 +159,9 @@ get__state(client &client,
 		has(request.head.path, "state_ids")
 	};
 
-	const m::room::state state
-	{
-		room
-	};
-
-	const m::room::auth::chain ac
+	const auto snapshot
 	{
-		event_id?
-			m::index(event_id):
-			m::head_idx(room)
+		state_snapshot_get(room, event_id? m::index(event_id): m::head_idx(room))
 	};
 
 	m::resource::response::chunked response
@@ -150,11 +195,7 @@ get__state(client &client,
 			top, "pdus"
 		};
 
-		state.for_each([&pdus]
-		(const m::event &event)
-		{
-			pdus.append(event);
-		});
+		append_idx(pdus, snapshot->state);
 	}
 
 	// auth_chain sent in response by default when /state/ is the path or
@@ -166,15 +207,7 @@ get__state(client &client,
 			top, "auth_chain"
 		};
 
-		m::event::fetch event;
-		ac.for_each([&auth_chain, &event]
-		(const m::event::idx &event_idx)
-		{
-			if(seek(std::nothrow, event, event_idx))
-				auth_chain.append(event);
-
-			return true;
-		});
+		append_idx(auth_chain, snapshot->auth);
 	}
 
 	// auth_chain_ids sent in response by default when /state_ids/ is given or
@@ -186,17 +219,7 @@ get__state(client &client,
 			top, "auth_chain_ids"
 		};
 
-		ac.for_each([&auth_chain_ids]
-		(const m::event::idx &event_idx)
-		{
-			m::event_id(std::nothrow, event_idx, [&auth_chain_ids]
-			(const auto &event_id)
-			{
-				auth_chain_ids.append(event_id);
-			});
-
-			return true;
-		});
+		append_ids(auth_chain_ids, snapshot->auth);
 	}
 
 	// pdu_ids sent in response by default when /state_ids/ is given or toggled
@@ -208,13 +231,158 @@ get__state(client &client,
 			top, "pdu_ids"
 		};
 
-		state.for_each(m::event::id::closure{[&pdu_ids]
-		(const m::event::id &event_id)
-		{
-			pdu_ids.append(event_id);
-			return true;
-		}});
+		append_ids(pdu_ids, snapshot->state);
 	}
 
 	return std::move(response);
 }
+
+void
+append_ids(json::stack::array &out,
+           const std::vector<m::event::idx> &event_idx)
+{
+	const size_t batch_max
+	{
+		std::max(size_t(state_fetch_batch), 1UL)
+	};
+
+	std::vector<m::event::id::buf> buf(batch_max);
+	for(size_t i(0); i < event_idx.size(); i += batch_max)
+	{
+		const size_t num
+		{
+			std::min(event_idx.size() - i, batch_max)
+		};
+
+		const vector_view<m::event::id::buf> ids
+		(
+			buf.data(), num
+		);
+
+		m::event_id(std::nothrow, ids, vector_view<const m::event::idx>
+		(
+			event_idx.data() + i, num
+		));
+
+		for(const auto &event_id : ids)
+			if(event_id)
+				out.append(event_id);
+	}
+}
+
+void
+append_idx(json::stack::array &out,
+           const std::vector<m::event::idx> &event_idx)
+{
+	const size_t batch_max
+	{
+		std::max(size_t(state_fetch_batch), 1UL)
+	};
+
+	std::string buf;
+	std::vector<m::event> event(batch_max);
+	for(size_t i(0); i < event_idx.size(); i += batch_max)
+	{
+		const size_t num
+		{
+			std::min(event_idx.size() - i, batch_max)
+		};
+
+		const vector_view<m::event> events
+		(
+			event.data(), num
+		);
+
+		m::seek(std::nothrow, events, vector_view<const m::event::idx>
+		(
+			event_idx.data() + i, num
+		), buf);
+
+		for(const auto &event : events)
+			if(event.event_id)
+				out.append(event);
+	}
+}
+
+/// The snapshot of the room at the event is cached when an event_id was
+/// given by the request; the state at the head is collected every time.
+std::shared_ptr<const state_snapshot>
+state_snapshot_get(const m::room &room,
+                   const m::event::idx &head_idx)
+{
+	std::string key;
+	if(room.event_id)
+	{
+		key.reserve(size(room.room_id) + size(room.event_id));
+		key.append(room.room_id);
+		key.append(room.event_id);
+
+		const auto it
+		{
+			state_cache.find(key)
+		};
+
+		if(it != end(state_cache))
+		{
+			it->second->used = ++state_cache_clock;
+			return it->second;
+		}
+	}
+
+	auto snapshot
+	{
+		std::make_shared<state_snapshot>()
+	};
+
+	const m::room::state state
+	{
+		room
+	};
+
+	snapshot->state.reserve(state.count());
+	state.for_each(m::event::closure_idx{[&snapshot]
+	(const m::event::idx &event_idx)
+	{
+		snapshot->state.emplace_back(event_idx);
+	}});
+
+	const m::room::auth::chain ac
+	{
+		head_idx
+	};
+
+	ac.for_each([&snapshot]
+	(const m::event::idx &event_idx)
+	{
+		snapshot->auth.emplace_back(event_idx);
+		return true;
+	});
+
+	if(!room.event_id || !state_cache_max)
+		return snapshot;
+
+	// Evict the least recently used; the collection above yielded, so the
+	// cache is only examined now.
+	while(state_cache.size() >= size_t(state_cache_max))
+	{
+		const auto it
+		{
+			std::min_element(begin(state_cache), end(state_cache), []
+			(const auto &a, const auto &b)
+			{
+				return a.second->used < b.second->used;
+			})
+		};
+
+		state_cache.erase(it);
+	}
+
+	snapshot->used = ++state_cache_clock;
+	auto &ret
+	{
+		state_cache[std::move(key)]
+	};
+
+	ret = std::move(snapshot);
+	return ret;
+}
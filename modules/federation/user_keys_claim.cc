@@ -67,38 +67,27 @@ post__user_keys_claim(client &client,
 		top, "one_time_keys"
 	};
 
-	for(const auto &[user_id, devices] : one_time_keys)
+	for(const auto &[user_id_, devices] : one_time_keys)
 	{
-		const m::user::room user_room
+		const m::user::id user_id
 		{
-			user_id
+			user_id_
 		};
 
+		// Keys are only claimed from our own users' devices.
+		if(!my(user_id))
+			continue;
+
 		json::stack::object response_user
 		{
 			response_keys, user_id
 		};
 
-		for(const auto &[device_id_, algorithm_] : json::object(devices))
+		for(const auto &[device_id, algorithm_] : json::object(devices))
 		{
-			const json::string &algorithm{algorithm_};
-			const json::string &device_id{device_id_};
-			const auto match{[&device_id]
-			(const string_view &state_key)
-			{
-				return state_key == device_id;
-			}};
-
-			char buf[m::event::TYPE_MAX_SIZE];
-			const string_view type{fmt::sprintf
-			{
-				buf, "ircd.device.one_time_key|%s",
-				algorithm
-			}};
-
-			const m::room::type events
+			const json::string &algorithm
 			{
-				user_room, type, { -1UL, -1L }, true
+				algorithm_
 			};
 
 			json::stack::object response_device
@@ -106,30 +95,22 @@ post__user_keys_claim(client &client,
 				response_user, device_id
 			};
 
-			events.for_each([&response_device, &match]
-			(const string_view &type, const auto &, const m::event::idx &event_idx)
+			m::dbs::device_one_time_key_pop(user_id, device_id, algorithm, [&response_device]
+			(const string_view &algorithm, const string_view &name, const string_view &key)
 			{
-				if(!m::query(std::nothrow, event_idx, "state_key", match))
-					return true;
-
-				m::get(std::nothrow, event_idx, "content", [&response_device, type]
-				(const json::object &content)
+				char buf[256];
+				const string_view ident{fmt::sprintf
 				{
-					const auto algorithm
-					{
-						split(type, '|').second
-					};
+					buf, "%s:%s", algorithm, name
+				}};
 
-					json::stack::member
+				json::stack::member
+				{
+					response_device, ident, json::value
 					{
-						response_device, algorithm, json::object
-						{
-							content[""] // device quirk
-						}
-					};
-				});
-
-				return false;
+						key
+					}
+				};
 			});
 		}
 	}
@@ -10,9 +10,16 @@
 
 namespace ircd::m::bridge
 {
-	static size_t make_txn(const config &, json::stack &, events::range &);
-	static event::idx worker_handle(const config &, const net::hostport &, const events::range &, window_buffer);
-	static void worker_loop(const config &, const rfc3986::uri &, const mutable_buffer &);
+	struct matcher;
+	struct txn;
+
+	// room_id => -1 internal, 0 not picked, 1 picked
+	using picked_rooms = std::map<std::string, int8_t, std::less<>>;
+
+	static size_t make_txn(const config &, const matcher &, json::stack &, events::range &);
+	static bool worker_wait(const config &, txn &);
+	static event::idx worker_send(const config &, const matcher &, const net::hostport &, const events::range &, txn &);
+	static void worker_loop(const config &, const matcher &, const rfc3986::uri &);
 	static void worker(std::string event, std::string event_id);
 	static void handle_event(const event &, vm::eval &);
 	static void fini();
@@ -20,11 +27,53 @@ namespace ircd::m::bridge
 
 	extern conf::item<bool> enable;
 	extern conf::item<seconds> timeout;
+	extern conf::item<size_t> txns_max;
+	extern conf::item<size_t> txn_events_max;
+	extern conf::item<size_t> txn_buffer_size;
 	extern ctx::dock worker_dock;
 	extern std::vector<context> worker_context;
 	extern hookfn<vm::eval &> notify_hook;
 }
 
+/// The namespaces of a configuration compiled once for its worker. Each
+/// expression keeps the length of its literal lead, so most candidates are
+/// rejected by comparing a prefix rather than evaluating the expression.
+struct ircd::m::bridge::matcher
+{
+	struct expr
+	{
+		std::string s;
+		size_t prefix {0};
+		bool literal {false};
+
+		bool operator()(const string_view &) const noexcept;
+
+		expr(const json::string &);
+	};
+
+	using exprs = std::vector<expr>;
+
+	exprs users, rooms, aliases;
+
+	static bool match(const exprs &, const string_view &) noexcept;
+
+	matcher(const config &);
+};
+
+/// One transaction to the bridge; it remains until the response is received.
+struct ircd::m::bridge::txn
+{
+	unique_mutable_buffer buf;
+	events::range range {0, 0};
+	size_t count {0};
+	server::request::opts sopts;
+	server::request req;
+
+	txn()
+	:buf{size_t(txn_buffer_size)}
+	{}
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
@@ -47,6 +96,32 @@ ircd::m::bridge::timeout
 	{ "default",   10L                          },
 };
 
+/// Transactions to one bridge in flight at once. The bridge receives them in
+/// order of their events, but a later one may be received before an earlier
+/// one is answered.
+decltype(ircd::m::bridge::txns_max)
+ircd::m::bridge::txns_max
+{
+	{ "name",      "ircd.m.bridge.txns.max"  },
+	{ "default",   4L                        },
+};
+
+/// Events in one transaction at most; more events are spread over the
+/// transactions in flight.
+decltype(ircd::m::bridge::txn_events_max)
+ircd::m::bridge::txn_events_max
+{
+	{ "name",      "ircd.m.bridge.txn.events.max"  },
+	{ "default",   512L                            },
+};
+
+decltype(ircd::m::bridge::txn_buffer_size)
+ircd::m::bridge::txn_buffer_size
+{
+	{ "name",      "ircd.m.bridge.txn.buffer.size"  },
+	{ "default",   long(event::MAX_SIZE * 8)        },
+};
+
 decltype(ircd::m::bridge::worker_dock)
 ircd::m::bridge::worker_dock;
 
@@ -155,9 +230,9 @@ try
 		at<"url"_>(config)
 	};
 
-	const unique_mutable_buffer buf
+	const bridge::matcher matcher
 	{
-		event::MAX_SIZE * 8
+		config
 	};
 
 	log::notice
@@ -183,7 +258,7 @@ try
 			server::errmsg(uri.remote),
 		};
 
-	worker_loop(config, uri, buf);
+	worker_loop(config, matcher, uri);
 }
 catch(const ctx::interrupted &)
 {
@@ -200,8 +275,8 @@ catch(const std::exception &e)
 
 void
 ircd::m::bridge::worker_loop(const config &config,
-                             const rfc3986::uri &uri,
-                             const mutable_buffer &buf)
+                             const matcher &matcher,
+                             const rfc3986::uri &uri)
 try
 {
 	const net::hostport target
@@ -209,15 +284,19 @@ try
 		uri.remote
 	};
 
-	auto since {vm::sequence::retired}; do
-    {
-		worker_dock.wait([&since]
-		{
-			return since < vm::sequence::retired;
-		});
+	// Transactions are answered in the order sent; the oldest is awaited
+	// while the others remain in flight.
+	std::list<txn> txns;
+	auto since {vm::sequence::retired + 1}; do
+	{
+		if(txns.empty())
+			worker_dock.wait([&since]
+			{
+				return since <= vm::sequence::retired;
+			});
 
 		// Wait here if the bridge is down.
-		while(unlikely(server::errant(target)))
+		while(unlikely(txns.empty() && server::errant(target)))
 		{
 			log::error
 			{
@@ -231,21 +310,45 @@ try
 			continue;
 		}
 
-		const events::range range
+		while(txns.size() < size_t(txns_max) && since <= vm::sequence::retired)
 		{
-			since, vm::sequence::retired + 1
-		};
+			const events::range range
+			{
+				since, vm::sequence::retired + 1
+			};
+
+			auto &txn(txns.emplace_back());
+			since = worker_send(config, matcher, target, range, txn);
+			assert(since >= range.first);
+			assert(since <= range.second);
 
-		since = worker_handle(config, target, range, buf);
-		assert(since >= range.first);
-		assert(since <= range.second);
+			if(!txn.count)
+				txns.pop_back();
+
+			// Prevent spin for retrying the same range on handled exception.
+			if(unlikely(since == range.first))
+				break;
+		}
 
-		// Prevent spin for retrying the same range on handled exception.
-		if(unlikely(since == range.first))
+		if(txns.empty())
 		{
-			sleep(15s);
+			if(unlikely(since <= vm::sequence::retired))
+				sleep(15s);
+
+			continue;
+		}
+
+		if(worker_wait(config, txns.front()))
+		{
+			txns.pop_front();
 			continue;
 		}
+
+		// On failure everything from the failed transaction is sent again;
+		// the remaining are cancelled by their destruction.
+		since = txns.front().range.first;
+		txns.clear();
+		sleep(15s);
 	}
 	while(run::level == run::level::RUN);
 }
@@ -262,16 +365,25 @@ catch(const std::exception &e)
 	};
 }
 
+/// Composes a transaction of the picked events starting at the front of the
+/// range and sends it without waiting for the response. Returns the first
+/// index after the transaction; the front of the range on error.
 ircd::m::event::idx
-ircd::m::bridge::worker_handle(const config &config,
-                               const net::hostport &target,
-                               const events::range &range_,
-                               window_buffer buf)
+ircd::m::bridge::worker_send(const config &config,
+                             const matcher &matcher,
+                             const net::hostport &target,
+                             const events::range &range_,
+                             txn &txn)
 try
 {
 	size_t count {0};
 	auto range {range_};
-	buf([&config, &count, &range]
+	window_buffer buf
+	{
+		txn.buf
+	};
+
+	buf([&config, &matcher, &count, &range]
 	(const mutable_buffer &buf)
 	{
 		json::stack out
@@ -279,7 +391,7 @@ try
 			buf
 		};
 
-		count += make_txn(config, out, range);
+		count += make_txn(config, matcher, out, range);
 		return out.completed();
 	});
 
@@ -339,33 +451,58 @@ try
 	in.content = in.head;
 
 	// Send to bridge
-	server::request::opts sopts;
-	server::request req
+	txn.req = server::request
+	{
+		target, std::move(out), std::move(in), &txn.sopts
+	};
+
+	txn.range = range;
+	txn.count = count;
+	return range.second + 1;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
 	{
-		target, std::move(out), std::move(in), &sopts
+		log, "worker send range:%lu:%lu :%s",
+		range_.first,
+		range_.second,
+		e.what(),
 	};
 
-	// Recv response
+	txn.count = 0;
+	return range_.first;
+}
+
+/// Receives the response to the transaction; false if it has to be sent
+/// again.
+bool
+ircd::m::bridge::worker_wait(const config &config,
+                             txn &txn)
+try
+{
 	const auto code
 	{
-		req.get(seconds(timeout))
+		txn.req.get(seconds(timeout))
 	};
 
 	log::logf
 	{
 		log, log::level::DEBUG,
-		"[%s] %u txn:%lu:%lu (%lu:%lu) events:%zu :%s",
+		"[%s] %u txn:%lu:%lu events:%zu :%s",
 		json::get<"id"_>(config),
 		uint(code),
-		range.first,
-		range.second,
-		range_.first,
-		range_.second,
-		count,
+		txn.range.first,
+		txn.range.second,
+		txn.count,
 		http::status(code),
 	};
 
-	return range.second + 1;
+	return true;
 }
 catch(const ctx::interrupted &)
 {
@@ -375,28 +512,30 @@ catch(const std::exception &e)
 {
 	log::error
 	{
-		log, "worker handle range:%lu:%lu :%s",
-		range_.first,
-		range_.second,
+		log, "worker txn:%lu:%lu :%s",
+		txn.range.first,
+		txn.range.second,
 		e.what(),
 	};
 
-	return range_.first;
+	return false;
 }
 
 namespace ircd::m::bridge
 {
-	static bool pick_alias(const config &, const event::idx &, const event &, const json::array &, const m::room::alias &);
-	static bool pick_alias(const config &, const event::idx &, const event &, const room &, const json::array &);
-	static bool pick_room(const config &, const event::idx &, const event &, const room &, const json::array &);
-	static bool pick_user(const config &, const event::idx &, const event &, const json::array &, const m::user::id &);
-	static bool pick_user(const config &, const event::idx &, const event &, const room &, const json::array &);
-	static bool pick(const config &, const event::idx &, const event &);
+	static bool pick_alias(const config &, const event::idx &, const event &, const matcher::exprs &, const m::room::alias &);
+	static bool pick_alias(const config &, const event::idx &, const event &, const room &, const matcher::exprs &);
+	static bool pick_room(const config &, const event::idx &, const event &, const room &, const matcher::exprs &);
+	static bool pick_members(const config &, const event::idx &, const event &, const room &, const matcher::exprs &);
+	static bool pick_user(const config &, const event::idx &, const event &, const matcher::exprs &, const m::user::id &);
+	static bool pick_user(const config &, const event::idx &, const event &, const matcher::exprs &);
+	static bool pick(const config &, const matcher &, picked_rooms &, const event::idx &, const event &);
 	static bool append(const config &, json::stack::array &, events::range &, size_t &, const event::idx &, const event &);
 }
 
 size_t
 ircd::m::bridge::make_txn(const config &config,
+                          const matcher &matcher,
                           json::stack &out,
                           events::range &range)
 {
@@ -411,10 +550,11 @@ ircd::m::bridge::make_txn(const config &config,
 	};
 
 	size_t count {0};
+	picked_rooms rooms;
 	m::events::for_each(m::events::range{range}, [&]
 	(const event::idx &event_idx, const event &event)
 	{
-		if(!pick(config, event_idx, event))
+		if(!pick(config, matcher, rooms, event_idx, event))
 			return true;
 
 		if(!append(config, events, range, count, event_idx, event))
@@ -464,11 +604,16 @@ ircd::m::bridge::append(const config &config,
 		events.s->remaining() > event::MAX_SIZE + 16_KiB
 	};
 
-	return sufficient_buffer;
+	return sufficient_buffer && count < size_t(txn_events_max);
 }
 
+/// The interest of the bridge in a room (by its members, id or aliases) is
+/// found once for the transaction; it's found again after any state event
+/// in the room, which might have changed it.
 bool
 ircd::m::bridge::pick(const config &config,
+                      const matcher &matcher,
+                      picked_rooms &rooms,
                       const event::idx &event_idx,
                       const event &event)
 {
@@ -477,27 +622,52 @@ ircd::m::bridge::pick(const config &config,
 		json::get<"room_id"_>(event)
 	};
 
-	if(internal(room))
+	auto it
+	{
+		rooms.lower_bound(room.room_id)
+	};
+
+	const bool cached
+	{
+		it != end(rooms) && it->first == room.room_id
+	};
+
+	if(!cached && internal(room))
+	{
+		rooms.emplace_hint(it, room.room_id, -1);
 		return false;
+	}
 
-	const bridge::namespaces &namespaces
+	if(cached && it->second != 0)
+		return it->second > 0;
+
+	if(pick_user(config, event_idx, event, matcher.users))
+		return true;
+
+	if(cached && !defined(json::get<"state_key"_>(event)))
+		return false;
+
+	const bool ret
 	{
-		json::get<"namespaces"_>(config)
+		false
+		|| pick_members(config, event_idx, event, room, matcher.users)
+		|| pick_room(config, event_idx, event, room, matcher.rooms)
+		|| pick_alias(config, event_idx, event, room, matcher.aliases)
 	};
 
-	return false
-	|| pick_user(config, event_idx, event, room, json::get<"users"_>(namespaces))
-	|| pick_room(config, event_idx, event, room, json::get<"rooms"_>(namespaces))
-	|| pick_alias(config, event_idx, event, room, json::get<"aliases"_>(namespaces))
-	;
+	if(cached)
+		it->second = ret;
+	else
+		rooms.emplace_hint(it, room.room_id, ret);
+
+	return ret;
 }
 
 bool
 ircd::m::bridge::pick_user(const config &config,
                            const event::idx &event_idx,
                            const event &event,
-                           const room &room,
-                           const json::array &namespaces)
+                           const matcher::exprs &namespaces)
 {
 	const m::user::id &sender
 	{
@@ -521,6 +691,16 @@ ircd::m::bridge::pick_user(const config &config,
 			return true;
 	}
 
+	return false;
+}
+
+bool
+ircd::m::bridge::pick_members(const config &config,
+                              const event::idx &event_idx,
+                              const event &event,
+                              const room &room,
+                              const matcher::exprs &namespaces)
+{
 	const room::members members
 	{
 		room
@@ -539,26 +719,10 @@ bool
 ircd::m::bridge::pick_user(const config &config,
                            const event::idx &event_idx,
                            const event &event,
-                           const json::array &namespaces,
+                           const matcher::exprs &namespaces,
                            const user::id &user_id)
 {
-	for(const json::object object : namespaces)
-	{
-		const bridge::namespace_ ns
-		{
-			object
-		};
-
-		const globular_imatch match
-		{
-			json::get<"regex"_>(ns)
-		};
-
-		if(match(user_id))
-			return true;
-	}
-
-	return false;
+	return matcher::match(namespaces, user_id);
 }
 
 bool
@@ -566,25 +730,9 @@ ircd::m::bridge::pick_room(const config &config,
                            const event::idx &event_idx,
                            const event &event,
                            const room &room,
-                           const json::array &namespaces)
+                           const matcher::exprs &namespaces)
 {
-	for(const json::object object : namespaces)
-	{
-		const bridge::namespace_ ns
-		{
-			object
-		};
-
-		const globular_imatch match
-		{
-			json::get<"regex"_>(ns)
-		};
-
-		if(match(room.room_id))
-			return true;
-	}
-
-	return false;
+	return matcher::match(namespaces, room.room_id);
 }
 
 bool
@@ -592,7 +740,7 @@ ircd::m::bridge::pick_alias(const config &config,
                             const event::idx &event_idx,
                             const event &event,
                             const room &room,
-                            const json::array &namespaces)
+                            const matcher::exprs &namespaces)
 {
 	const m::room::aliases aliases
 	{
@@ -611,24 +759,90 @@ bool
 ircd::m::bridge::pick_alias(const config &config,
                             const event::idx &event_idx,
                             const event &event,
-                            const json::array &namespaces,
+                            const matcher::exprs &namespaces,
                             const m::room::alias &room_alias)
 {
-	for(const json::object object : namespaces)
+	return matcher::match(namespaces, room_alias);
+}
+
+//
+// matcher
+//
+
+ircd::m::bridge::matcher::matcher(const config &config)
+{
+	const bridge::namespaces &namespaces
 	{
-		const bridge::namespace_ ns
-		{
-			object
-		};
+		json::get<"namespaces"_>(config)
+	};
 
-		const globular_imatch match
+	const auto compile{[]
+	(exprs &out, const json::array &namespaces)
+	{
+		for(const json::object object : namespaces)
 		{
-			json::get<"regex"_>(ns)
-		};
+			const bridge::namespace_ ns
+			{
+				object
+			};
 
-		if(match(room_alias))
-			return true;
-	}
+			if(json::get<"regex"_>(ns))
+				out.emplace_back(json::get<"regex"_>(ns));
+		}
+	}};
 
-	return false;
+	compile(users, json::get<"users"_>(namespaces));
+	compile(rooms, json::get<"rooms"_>(namespaces));
+	compile(aliases, json::get<"aliases"_>(namespaces));
+}
+
+bool
+ircd::m::bridge::matcher::match(const exprs &exprs,
+                                const string_view &input)
+noexcept
+{
+	return std::any_of(begin(exprs), end(exprs), [&input]
+	(const auto &expr)
+	{
+		return expr(input);
+	});
+}
+
+ircd::m::bridge::matcher::expr::expr(const json::string &s)
+:s
+{
+	s
+}
+,prefix
+{
+	std::min(this->s.find_first_of("*?"), this->s.size())
+}
+,literal
+{
+	prefix == this->s.size()
+}
+{
+}
+
+bool
+ircd::m::bridge::matcher::expr::operator()(const string_view &input)
+const noexcept
+{
+	const string_view lead
+	{
+		this->s.data(), prefix
+	};
+
+	if(size(input) < prefix || !iequals(lead, input.substr(0, prefix)))
+		return false;
+
+	if(literal)
+		return size(input) == prefix;
+
+	const globular_imatch match
+	{
+		this->s
+	};
+
+	return match(input);
 }
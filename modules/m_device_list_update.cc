@@ -14,10 +14,19 @@ static void
 handle_edu_m_device_list_update(const m::event &,
                                 m::vm::eval &);
 
+static void
+handle_device_change_note(const m::event &,
+                          m::vm::eval &);
+
 mapi::header
 IRCD_MODULE
 {
-	"Matrix Device List Update"
+	"Matrix Device List Update", nullptr, []
+	{
+		// Changes are no longer noted once this hook is unloaded, so the
+		// stream can't claim to have them.
+		m::user::devices::clear();
+	}
 };
 
 m::hookfn<m::vm::eval &>
@@ -89,3 +98,46 @@ catch(const std::exception &e)
 		e.what(),
 	};
 }
+
+/// This hook appends every device list change committed to a user's room,
+/// local or from the federation, to the change stream read by sync and
+/// /keys/changes (see m::user::devices::note()).
+const m::hookfn<m::vm::eval &>
+_device_change_note
+{
+	handle_device_change_note,
+	{
+		{ "_site",   "vm.notify"  },
+	}
+};
+
+void
+handle_device_change_note(const m::event &event,
+                          m::vm::eval &eval)
+try
+{
+	if(!eval.sequence)
+		return;
+
+	if(!m::user::devices::changes(event))
+		return;
+
+	const m::user::id &user_id
+	{
+		json::get<"sender"_>(event)
+	};
+
+	if(!m::user::room::is(json::get<"room_id"_>(event), user_id))
+		return;
+
+	m::user::devices::note(event, eval.sequence);
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "Device list change note for %s :%s",
+		string_view{json::get<"sender"_>(event)},
+		e.what(),
+	};
+}
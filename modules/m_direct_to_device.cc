@@ -16,13 +16,20 @@ IRCD_MODULE
 	"Matrix Direct To Device"
 };
 
-static void
+static size_t
 handle_m_direct_to_device(m::vm::eval &,
+                          db::txn &,
                           const m::direct_to_device &,
                           const m::user::id &user_id,
                           const string_view &device_id,
                           const json::object &message);
 
+static void
+handle_m_direct_to_device_user(m::vm::eval &,
+                               const m::direct_to_device &,
+                               const m::user::id &user_id,
+                               const json::object &device_messages);
+
 static void
 handle_edu_m_direct_to_device(const m::event &,
                               m::vm::eval &);
@@ -79,8 +86,7 @@ try
 			user_messages.second
 		};
 
-		for(const auto &[device_id, message_body] : device_messages)
-			handle_m_direct_to_device(eval, edu, user_id, device_id, message_body);
+		handle_m_direct_to_device_user(eval, edu, user_id, device_messages);
 	}
 }
 catch(const std::exception &e)
@@ -93,14 +99,33 @@ catch(const std::exception &e)
 	};
 }
 
+/// The messages to the devices of the user are queued in one transaction;
+/// a single ircd.to_device event in the user's room then notifies the
+/// devices, carrying none of the messages.
 static void
-handle_m_direct_to_device(m::vm::eval &eval,
-                          const m::direct_to_device &edu,
-                          const m::user::id &user_id,
-                          const string_view &device_id,
-                          const json::object &message)
+handle_m_direct_to_device_user(m::vm::eval &eval,
+                               const m::direct_to_device &edu,
+                               const m::user::id &user_id,
+                               const json::object &device_messages)
 try
 {
+	db::txn txn
+	{
+		*m::dbs::events
+	};
+
+	size_t count(0);
+	string_view device_id;
+	for(const auto &[device_id_, message_body] : device_messages)
+	{
+		count += handle_m_direct_to_device(eval, txn, edu, user_id, device_id_, message_body);
+		device_id = !device_id || device_id == device_id_? device_id_: "*"_sv;
+	}
+
+	if(!count)
+		return;
+
+	txn();
 	const m::user::room user_room
 	{
 		user_id
@@ -111,29 +136,76 @@ try
 		{ "sender",    at<"sender"_>(edu) },
 		{ "type",      at<"type"_>(edu)   },
 		{ "device_id", device_id          },
-		{ "content",   message            },
+		{ "count",     long(count)        },
 	});
-
-	log::logf
-	{
-		m::log, log::level::DEBUG,
-		"%s sent '%s' to %s device '%s' (%zu bytes)",
-		at<"sender"_>(edu),
-		at<"type"_>(edu),
-		string_view{user_id},
-		device_id,
-		size(string_view{message})
-	};
+}
+catch(const ctx::interrupted &)
+{
+	throw;
 }
 catch(const std::exception &e)
 {
 	log::derror
 	{
-		m::log, "m.direct_to_device %s to %s device of %s from %s :%s ",
+		m::log, "m.direct_to_device %s to %s from %s :%s ",
 		at<"type"_>(edu),
-		device_id,
 		string_view{user_id},
 		at<"sender"_>(edu),
 		e.what()
 	};
 }
+
+/// Queues the message for the device, or for each of the devices of the
+/// user for the wildcard. Returns the number of messages queued.
+static size_t
+handle_m_direct_to_device(m::vm::eval &eval,
+                          db::txn &txn,
+                          const m::direct_to_device &edu,
+                          const m::user::id &user_id,
+                          const string_view &device_id,
+                          const json::object &message)
+{
+	const json::strung queued
+	{
+		json::members
+		{
+			{ "sender",   at<"sender"_>(edu) },
+			{ "type",     at<"type"_>(edu)   },
+			{ "content",  message            },
+		}
+	};
+
+	size_t ret(0);
+	const m::user::devices devices
+	{
+		user_id
+	};
+
+	if(device_id == "*")
+		devices.for_each([&txn, &user_id, &queued, &ret]
+		(const auto &, const string_view &device_id)
+		{
+			m::dbs::device_inbox_put(txn, user_id, device_id, json::object{queued});
+			++ret;
+			return true;
+		});
+	else if(devices.has(device_id))
+	{
+		m::dbs::device_inbox_put(txn, user_id, device_id, json::object{queued});
+		++ret;
+	}
+
+	log::logf
+	{
+		m::log, log::level::DEBUG,
+		"%s sent '%s' to %s device '%s' (%zu bytes) queued:%zu",
+		at<"sender"_>(edu),
+		at<"type"_>(edu),
+		string_view{user_id},
+		device_id,
+		size(string_view{message}),
+		ret,
+	};
+
+	return ret;
+}
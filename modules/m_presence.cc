@@ -11,13 +11,19 @@
 using namespace ircd;
 
 static void handle_ircd_presence(const m::event &, m::vm::eval &);
+static void handle_ircd_presence_note(const m::event &, m::vm::eval &);
 static void handle_edu_m_presence_object(const m::event &, const m::presence &edu);
 static void handle_edu_m_presence(const m::event &, m::vm::eval &);
 
 mapi::header
 IRCD_MODULE
 {
-	"Matrix Presence"
+	"Matrix Presence", nullptr, []
+	{
+		// Changes are no longer noted once this hook is unloaded, so the
+		// in-memory table can't claim to have them.
+		m::presence::clear();
+	}
 };
 
 /// Coarse enabler for incoming federation presence events. If this is
@@ -337,3 +343,44 @@ catch(const std::exception &e)
 		e.what(),
 	};
 }
+
+/// This hook keeps the in-memory presence table (see m::presence::note())
+/// current with every ircd.presence committed to a user's room, local or
+/// from the federation.
+const m::hookfn<m::vm::eval &>
+_ircd_presence_note
+{
+	handle_ircd_presence_note,
+	{
+		{ "_site",   "vm.notify"      },
+		{ "type",    "ircd.presence"  },
+	}
+};
+
+void
+handle_ircd_presence_note(const m::event &event,
+                          m::vm::eval &eval)
+try
+{
+	if(!eval.sequence)
+		return;
+
+	const m::user::id &user_id
+	{
+		json::get<"sender"_>(event)
+	};
+
+	if(!m::user::room::is(json::get<"room_id"_>(event), user_id))
+		return;
+
+	m::presence::note(event, eval.sequence);
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		presence_log, "Presence note for %s :%s",
+		string_view{json::get<"sender"_>(event)},
+		e.what(),
+	};
+}
@@ -10,12 +10,12 @@
 
 namespace ircd::m::push
 {
-	static void execute(const event &, vm::eval &, const user::id &, const path &, const rule &, const event::idx &);
-	static bool matching(const event &, vm::eval &, const user::id &, const path &, const rule &);
-	static bool handle_kind(const event &, vm::eval &, const user::id &, const path &);
-	static void handle_rules(const event &, vm::eval &, const user::id &, const string_view &scope);
+	static void execute(const event &, vm::eval &, const user::id &, const program::rule &);
+	static void handle_rules(const event &, vm::eval &, program::memo &, const user::id &);
 	static void handle_event(const m::event &, vm::eval &);
+	static void handle_program(const m::event &, vm::eval &);
 	extern hookfn<vm::eval &> hook_event;
+	extern hookfn<vm::eval &> hook_program;
 }
 
 ircd::mapi::header
@@ -33,6 +33,40 @@ ircd::m::push::hook_event
 	}
 };
 
+/// Compiled rules are discarded when the user's room receives a push rule
+/// or a profile change.
+decltype(ircd::m::push::hook_program)
+ircd::m::push::hook_program
+{
+	handle_program,
+	{
+		{ "_site", "vm.effect" },
+	}
+};
+
+void
+ircd::m::push::handle_program(const m::event &event,
+                              vm::eval &eval)
+{
+	const auto &type
+	{
+		at<"type"_>(event)
+	};
+
+	if(!startswith(type, rule::type_prefix) && type != "ircd.profile")
+		return;
+
+	const m::user::id &sender
+	{
+		at<"sender"_>(event)
+	};
+
+	if(!my(sender) || !m::user::room::is(at<"room_id"_>(event), sender))
+		return;
+
+	program::invalidate(sender);
+}
+
 void
 ircd::m::push::handle_event(const m::event &event,
                             vm::eval &eval)
@@ -56,7 +90,21 @@ try
 		room_id
 	};
 
-	members.for_each("join", my_host(), [&event, &eval]
+	// The content is indexed once here rather than parsed again by every
+	// condition of every rule of every local member of the room.
+	const json::object::index content
+	{
+		json::get<"content"_>(event)
+	};
+
+	// Values of the event which conditions test (keys, the member count,
+	// the sender's permission) are computed once for all members.
+	program::memo memo
+	{
+		event, &content
+	};
+
+	members.for_each("join", my_host(), [&event, &eval, &memo]
 	(const user::id &user_id, const event::idx &membership_event_idx)
 	{
 		// r0.6.0-13.13.15 Homeservers MUST NOT notify the Push Gateway for
@@ -64,7 +112,7 @@ try
 		if(user_id == at<"sender"_>(event))
 			return true;
 
-		handle_rules(event, eval, user_id, "global");
+		handle_rules(event, eval, memo, user_id);
 		return true;
 	});
 }
@@ -85,83 +133,22 @@ catch(const std::exception &e)
 void
 ircd::m::push::handle_rules(const event &event,
                             vm::eval &eval,
-                            const user::id &user_id,
-                            const string_view &scope)
-{
-	const push::path path[]
-	{
-		{ scope, "override",   string_view{}         },
-		{ scope, "content",    string_view{}         },
-		{ scope, "room",       at<"room_id"_>(event) },
-		{ scope, "sender",     at<"sender"_>(event)  },
-		{ scope, "underride",  string_view{}         },
-	};
-
-	for(const auto &p : path)
-		if(!handle_kind(event, eval, user_id, p))
-			break;
-}
-
-bool
-ircd::m::push::handle_kind(const event &event,
-                           vm::eval &eval,
-                           const user::id &user_id,
-                           const path &path)
-{
-	const user::pushrules pushrules
-	{
-		user_id
-	};
-
-	return pushrules.for_each(path, [&event, &eval, &user_id]
-	(const auto &event_idx, const auto &path, const auto &rule)
-	{
-		if(matching(event, eval, user_id, path, rule))
-		{
-			execute(event, eval, user_id, path, rule, event_idx);
-			return false; // false to break due to match
-		}
-		else return true;
-	});
-}
-
-bool
-ircd::m::push::matching(const event &event,
-                        vm::eval &eval,
-                        const user::id &user_id,
-                        const path &path,
-                        const rule &rule)
+                            program::memo &memo,
+                            const user::id &user_id)
 try
 {
-	const auto &[scope, kind, ruleid]
+	const auto compiled
 	{
-		path
+		program::get(user_id)
 	};
 
-	if(!json::get<"enabled"_>(rule))
-		return false;
-
-	push::match::opts opts;
-	opts.user_id = user_id;
-	const push::match match
+	const auto *const rule
 	{
-		event, rule, opts
+		(*compiled)(memo)
 	};
 
-	#if 0
-	log::debug
-	{
-		log, "event %s rule { %s, %s, %s } for %s %s",
-		string_view{event.event_id},
-		scope,
-		kind,
-		ruleid,
-		string_view{user_id},
-		bool(match)? "MATCH"_sv : string_view{}
-	};
-	#endif
-
-	return bool(match);
+	if(rule)
+		execute(event, eval, user_id, *rule);
 }
 catch(const ctx::interrupted &)
 {
@@ -169,63 +156,41 @@ catch(const ctx::interrupted &)
 }
 catch(const std::exception &e)
 {
-	const auto &[scope, kind, ruleid]
-	{
-		path
-	};
-
 	log::error
 	{
-		log, "Push rule matching in %s for %s at { %s, %s, %s } :%s",
+		log, "Push rules in %s for %s :%s",
 		string_view{event.event_id},
 		string_view{user_id},
-		scope,
-		kind,
-		ruleid,
 		e.what(),
 	};
-
-	return false;
 }
 
 void
 ircd::m::push::execute(const event &event,
                        vm::eval &eval,
                        const user::id &user_id,
-                       const path &path,
-                       const rule &rule,
-                       const event::idx &rule_idx)
+                       const program::rule &rule)
 try
 {
-	const auto &[scope, kind, ruleid]
-	{
-		path
-	};
-
-	const json::array &actions
-	{
-		json::get<"actions"_>(rule)
-	};
-
 	log::debug
 	{
 		log, "event %s action { %s, %s, %s } for %s :%s",
 		string_view{event.event_id},
-		scope,
-		kind,
-		ruleid,
+		string_view{rule.scope},
+		string_view{rule.kind},
+		string_view{rule.rule_id},
 		string_view{user_id},
-		string_view{json::get<"actions"_>(rule)},
+		string_view{rule.actions},
 	};
 
 	// action is dont_notify or undefined etc
-	if(!notifying(rule))
+	if(!rule.notify)
 		return;
 
 	user::notifications::opts opts;
 	opts.room_id = eval.room_id;
 	opts.only =
-		highlighting(rule)?
+		rule.highlight?
 			"highlight"_sv:
 			string_view{};
 
@@ -243,7 +208,7 @@ try
 	send(user_room, at<"sender"_>(event), type, json::members
 	{
 		{ "event_idx",  long(eval.sequence)  },
-		{ "rule_idx",   long(rule_idx)       },
+		{ "rule_idx",   long(rule.rule_idx)  },
 		{ "user_id",    user_id              },
 	});
 }
@@ -253,19 +218,14 @@ catch(const ctx::interrupted &)
 }
 catch(const std::exception &e)
 {
-	const auto &[scope, kind, ruleid]
-	{
-		path
-	};
-
 	log::error
 	{
 		log, "Push rule action in %s for %s at { %s, %s, %s } :%s",
 		string_view{event.event_id},
 		string_view{user_id},
-		scope,
-		kind,
-		ruleid,
+		string_view{rule.scope},
+		string_view{rule.kind},
+		string_view{rule.rule_id},
 		e.what(),
 	};
 }
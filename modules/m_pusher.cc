@@ -15,15 +15,20 @@ namespace ircd::m::push
 	static long count_unread(const user &, const room &, const event::idx &);
 	static long count_unread(const user &, const event::idx &);
 
-	static void make_content_devices(json::stack::array &, const pusher &, const event::idx &);
+	using pushers_view = vector_view<const std::pair<event::idx, pusher>>;
+
+	static void make_content_device(json::stack::array &, const pusher &, const event::idx &);
+	static void make_content_devices(json::stack::array &, const pushers_view &);
 	static void make_content_counts(json::stack::object &, const user &, const event::idx &);
-	static void make_content(json::stack::object &, const user &, const room &, const event &, const event::idx &, const pusher &, const event::idx &);
+	static void make_content(json::stack::object &, const user &, const room &, const event &, const event::idx &, const pushers_view &);
 
-	static bool notify_email(const user &, const room &, const event::fetch &, const pusher &, const event::idx &pusher_idx);
-	static bool notify_http(const user &, const room &, const event::fetch &, const pusher &, const event::idx &pusher_idx);
-	static bool notify(const user &, const room &, const event::fetch &, const pusher &, const event::idx &pusher_idx);
+	static bool notify_email(const user &, const room &, const event::fetch &, const pushers_view &);
+	static bool notify_http(const user &, const room &, const event::fetch &, const pushers_view &);
+	static bool notify(const user &, const room &, const event::fetch &, const pushers_view &);
 	static void handle_event(const event &, vm::eval &);
 
+	static void drop_oldest(const string_view &remote);
+	static void expire();
 	static bool complete(request &);
 	static void worker();
 	static void fini();
@@ -97,6 +102,9 @@ try
 		if(request::list.empty() && ctx::termination(worker_context))
 			break;
 
+		// Cancel anything overdue; it completes below like any other.
+		expire();
+
 		auto next
 		{
 			ctx::when_any(begin(request::list), end(request::list), []
@@ -148,6 +156,72 @@ catch(const std::exception &e)
 	};
 }
 
+void
+ircd::m::push::expire()
+{
+	const std::lock_guard lock
+	{
+		request::mutex
+	};
+
+	const auto timeout
+	{
+		now<steady_point>() - seconds(request::timeout)
+	};
+
+	for(auto *const &req : request::list)
+	{
+		if(!req->req || req->canceled || req->started > timeout)
+			continue;
+
+		log::dwarning
+		{
+			log, "Request id:%lu to %s `%s' timed out.",
+			req->id,
+			req->url.remote,
+			req->url.path,
+		};
+
+		req->canceled = true;
+		server::cancel(req->req);
+	}
+}
+
+/// Bound the requests pending to one gateway. Requests to the same remote
+/// are queued by ircd::server onto that peer's kept-alive links; when the
+/// gateway falls behind, the oldest notification is the least useful, so
+/// it is canceled to make room for the one about to be started.
+void
+ircd::m::push::drop_oldest(const string_view &remote)
+{
+	size_t count(0);
+	request *oldest(nullptr);
+	for(auto *const &req : request::list)
+	{
+		if(!req->req || req->canceled || req->url.remote != remote)
+			continue;
+
+		if(!oldest || req->id < oldest->id)
+			oldest = req;
+
+		++count;
+	}
+
+	if(!oldest || count < size_t(request::gateway_max))
+		return;
+
+	log::dwarning
+	{
+		log, "Request id:%lu to %s dropped with %zu pending to the gateway.",
+		oldest->id,
+		remote,
+		count,
+	};
+
+	oldest->canceled = true;
+	server::cancel(oldest->req);
+}
+
 bool
 ircd::m::push::complete(request &req)
 try
@@ -168,9 +242,10 @@ try
 	log::logf
 	{
 		log, level,
-		"Request id:%lu [%u] notified %s `%s'",
+		"Request id:%lu [%u] notified %zu devices at %s `%s'",
 		req.id,
 		uint(req.code),
+		req.devices,
 		req.url.remote,
 		req.url.path,
 	};
@@ -179,6 +254,10 @@ try
 }
 catch(const std::exception &e)
 {
+	// Dropped or timed out; already logged when canceled.
+	if(req.canceled)
+		return true;
+
 	log::error
 	{
 		log, "Request id:%lu [---] notifying %s `%s' :%s",
@@ -250,24 +329,81 @@ try
 		json::get<"content"_>(event).at<event::idx>("event_idx")
 	};
 
-	// Note the subject event data is not fetched yet. If the user
-	// has any pushers it's fetched on the first and reused subsequently.
-	m::event::fetch push_event;
 	const m::user::pushers pushers
 	{
 		user
 	};
 
-	pushers.for_each([&user, &room, &event_idx, &push_event]
+	// Pushers are copied out of the iteration so those sharing a gateway
+	// can be coalesced into one notification listing each of the devices.
+	std::vector<std::pair<event::idx, std::string>> pushers_json;
+	pushers.for_each([&pushers_json]
 	(const event::idx &pusher_idx, const string_view &pushkey, const push::pusher &pusher)
 	{
-		// If the subject event data hasn't been fetched yet, do it here.
-		if(!push_event.valid)
-			m::seek(push_event, event_idx);
+		pushers_json.emplace_back(pusher_idx, json::strung(pusher));
+		return true;
+	});
+
+	if(pushers_json.empty())
+		return;
+
+	std::vector<std::pair<event::idx, push::pusher>> group;
+	group.reserve(pushers_json.size());
+	for(const auto &[pusher_idx, pusher_json] : pushers_json)
+		group.emplace_back(pusher_idx, json::object{pusher_json});
+
+	static const auto gateway{[](const push::pusher &pusher)
+	{
+		const json::object data
+		{
+			json::get<"data"_>(pusher)
+		};
 
-		assert(push_event.valid);
-		return notify(user, room, push_event, pusher, pusher_idx);
+		return std::make_tuple
+		(
+			json::string(json::get<"kind"_>(pusher)),
+			json::string(data["url"]),
+			json::string(data["format"])
+		);
+	}};
+
+	// Adjacent pushers to the same gateway form each request.
+	std::stable_sort(begin(group), end(group), []
+	(const auto &a, const auto &b)
+	{
+		return gateway(a.second) < gateway(b.second);
 	});
+
+	const m::event::fetch push_event
+	{
+		event_idx
+	};
+
+	const size_t devices_max
+	{
+		std::max(size_t(request::devices_max), 1UL)
+	};
+
+	for(auto it(begin(group)); it != end(group); )
+	{
+		auto end_(std::next(it));
+		while(end_ != end(group) && size_t(std::distance(it, end_)) < devices_max)
+		{
+			if(gateway(it->second) != gateway(end_->second))
+				break;
+
+			++end_;
+		}
+
+		const pushers_view batch
+		{
+			group.data() + std::distance(begin(group), it),
+			group.data() + std::distance(begin(group), end_),
+		};
+
+		notify(user, room, push_event, batch);
+		it = end_;
+	}
 }
 catch(const ctx::interrupted &)
 {
@@ -287,20 +423,20 @@ bool
 ircd::m::push::notify(const m::user &user,
                       const m::room &room,
                       const m::event::fetch &event,
-                      const pusher &pusher,
-                      const m::event::idx &pusher_idx)
+                      const pushers_view &pushers)
 try
 {
+	assert(!pushers.empty());
 	const json::string &kind
 	{
-		json::get<"kind"_>(pusher)
+		json::get<"kind"_>(pushers[0].second)
 	};
 
 	if(kind == "http")
-		return notify_http(user, room, event, pusher, pusher_idx);
+		return notify_http(user, room, event, pushers);
 
 	if(kind == "email")
-		return notify_email(user, room, event, pusher, pusher_idx);
+		return notify_email(user, room, event, pushers);
 
 	return true;
 }
@@ -312,8 +448,9 @@ catch(const std::exception &e)
 {
 	log::error
 	{
-		log, "Notify to pusher:%lu by %s in %s for %s :%s",
-		pusher_idx,
+		log, "Notify to pusher:%lu (%zu devices) by %s in %s for %s :%s",
+		pushers[0].first,
+		pushers.size(),
 		string_view{user.user_id},
 		string_view{room.room_id},
 		string_view{event.event_id},
@@ -327,9 +464,13 @@ bool
 ircd::m::push::notify_http(const m::user &user,
                            const m::room &room,
                            const m::event::fetch &event,
-                           const pusher &pusher,
-                           const m::event::idx &pusher_idx)
+                           const pushers_view &pushers)
 {
+	const auto &pusher
+	{
+		pushers[0].second
+	};
+
 	const std::lock_guard lock
 	{
 		request::mutex
@@ -343,6 +484,7 @@ ircd::m::push::notify_http(const m::user &user,
 	window_buffer wb{req->buf};
 	mutable_buffer buf{req->buf};
 	req->event_idx = event.event_idx;
+	req->devices = pushers.size();
 
 	// Target URL copied to request and verified on assignment
 	wb([&req, &pusher](const mutable_buffer &buf)
@@ -369,7 +511,7 @@ ircd::m::push::notify_http(const m::user &user,
 		json::stack out{buf};
 		{
 			json::stack::object top{out};
-			make_content(top, user, room, event, event.event_idx, pusher, pusher_idx);
+			make_content(top, user, room, event, event.event_idx, pushers);
 		}
 
 		req->content = out.completed();
@@ -405,6 +547,9 @@ ircd::m::push::notify_http(const m::user &user,
 	in.head = buf;
 	in.content = in.head;
 
+	// Make room at the gateway before queueing another request to it.
+	drop_oldest(req->url.remote);
+
 	// Start request
 	static server::request::opts sopts;
 	sopts.http_exceptions = false;
@@ -416,9 +561,10 @@ ircd::m::push::notify_http(const m::user &user,
 
 	log::debug
 	{
-		log, "Request id:%lu to pusher[%s...] by %s in %s for %s",
+		log, "Request id:%lu to pusher[%s...] +%zu by %s in %s for %s",
 		req->id,
 		trunc(json::get<"pushkey"_>(pusher), 16),
+		pushers.size() - 1,
 		string_view{user.user_id},
 		string_view{room.room_id},
 		string_view{event.event_id},
@@ -433,8 +579,7 @@ bool
 ircd::m::push::notify_email(const m::user &user,
                             const m::room &room,
                             const m::event::fetch &event,
-                            const pusher &pusher,
-                            const m::event::idx &pusher_idx)
+                            const pushers_view &pushers)
 {
 	return true;
 }
@@ -445,9 +590,13 @@ ircd::m::push::make_content(json::stack::object &top,
                             const m::room &room,
                             const m::event &event,
                             const event::idx &event_idx,
-                            const pusher &pusher,
-                            const m::event::idx &pusher_idx)
+                            const pushers_view &pushers)
 {
+	const auto &pusher
+	{
+		pushers[0].second
+	};
+
 	const m::user sender
 	{
 		json::get<"sender"_>(event)
@@ -504,7 +653,7 @@ ircd::m::push::make_content(json::stack::object &top,
 			note, "devices"
 		};
 
-		make_content_devices(devices, pusher, pusher_idx);
+		make_content_devices(devices, pushers);
 	}
 
 	// Counts
@@ -553,8 +702,16 @@ ircd::m::push::make_content(json::stack::object &top,
 
 void
 ircd::m::push::make_content_devices(json::stack::array &devices,
-                                    const pusher &pusher,
-                                    const m::event::idx &pusher_idx)
+                                    const pushers_view &pushers)
+{
+	for(const auto &[pusher_idx, pusher] : pushers)
+		make_content_device(devices, pusher, pusher_idx);
+}
+
+void
+ircd::m::push::make_content_device(json::stack::array &devices,
+                                   const pusher &pusher,
+                                   const m::event::idx &pusher_idx)
 {
 	json::stack::object device
 	{
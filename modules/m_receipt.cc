@@ -10,6 +10,16 @@
 
 using namespace ircd;
 
+using pending_receipts = std::map<std::string, std::pair<std::string, time_t>, std::less<>>;
+static void broadcast_receipts(const m::room::id &, const pending_receipts &);
+static void flush_receipts();
+static void broadcast_worker();
+static void fini();
+extern conf::item<milliseconds> broadcast_window;
+extern std::map<std::string, pending_receipts, std::less<>> broadcasts;
+extern ctx::dock broadcast_dock;
+extern context broadcast_context;
+
 static void handle_ircd_read(const m::event &, m::vm::eval &);
 extern m::hookfn<m::vm::eval &> _ircd_read_eval;
 
@@ -26,9 +36,17 @@ extern m::hookfn<m::vm::eval &> _m_receipt_eval;
 mapi::header
 IRCD_MODULE
 {
-	"Matrix Receipts"
+	"Matrix Receipts",
+	nullptr,
+	fini,
 };
 
+void
+fini()
+{
+	broadcast_context.terminate();
+}
+
 //
 // EDU handler.
 //
@@ -363,35 +381,188 @@ try
 		at<"content"_>(event).get<time_t>("ts", 0)
 	};
 
-	const json::value event_ids[]
+	if(!milliseconds(broadcast_window).count())
 	{
-		{ event_id }
+		const pending_receipts receipt
+		{
+			{ std::string(user.user_id), { std::string(event_id), ms } }
+		};
+
+		broadcast_receipts(room_id, receipt);
+		return;
+	}
+
+	// Queue for the next broadcast of the room; a later receipt from the
+	// same user replaces an earlier one still pending.
+	auto &room_receipts
+	{
+		broadcasts[std::string(room_id)]
+	};
+
+	room_receipts[std::string(user.user_id)] =
+	{
+		std::string(event_id), ms
+	};
+
+	broadcast_dock.notify_one();
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::receipt::log, "ircd.read hook on %s for federation broadcast :%s",
+		string_view{event.event_id},
+		e.what(),
 	};
+}
+
+//
+// Broadcast window
+//
+
+decltype(broadcast_window)
+broadcast_window
+{
+	{ "name",     "ircd.m.receipt.broadcast.window" },
+	{ "default",  200L                              },
+	{ "description",
+
+	R"(
+	Receipts by local users are held for this many milliseconds and then
+	broadcast with one m.receipt edu for each room listing only the latest
+	receipt of each user. Zero broadcasts every receipt immediately.
+	)"},
+};
 
-	const json::members m_read
+decltype(broadcasts)
+broadcasts;
+
+decltype(broadcast_dock)
+broadcast_dock;
+
+decltype(broadcast_context)
+broadcast_context
+{
+	"m.receipt",
+	256_KiB,
+	context::WAIT_JOIN,
+	broadcast_worker,
+};
+
+void
+broadcast_worker()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	while(1)
 	{
-		{ "data",
+		broadcast_dock.wait([]
 		{
-			{ "ts", ms }
-		}},
-		{ "event_ids",
+			return !broadcasts.empty();
+		});
+
+		ctx::sleep(milliseconds(broadcast_window));
+		flush_receipts();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		m::receipt::log, "Broadcast worker fatal :%s",
+		e.what(),
+	};
+}
+
+void
+flush_receipts()
+{
+	auto flush
+	{
+		std::move(broadcasts)
+	};
+
+	broadcasts.clear();
+	for(const auto &[room_id, receipts] : flush) try
+	{
+		broadcast_receipts(m::room::id{room_id}, receipts);
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
 		{
-			event_ids, 1
-		}},
+			m::receipt::log, "Broadcast of %zu receipts in %s :%s",
+			receipts.size(),
+			string_view{room_id},
+			e.what(),
+		};
+	}
+}
+
+void
+broadcast_receipts(const m::room::id &room_id,
+                   const pending_receipts &receipts)
+{
+	const unique_mutable_buffer buf
+	{
+		receipts.size() * 1_KiB + 64
 	};
 
-	json::iov edu_event, content;
-	const json::iov::push push[]
+	json::stack out{buf};
 	{
-		{ edu_event, { "type",     "m.receipt" } },
-		{ edu_event, { "room_id",  room_id     } },
-		{ content,   { room_id,
+		json::stack::object top{out};
+		json::stack::object m_read
+		{
+			top, "m.read"
+		};
+
+		for(const auto &[user_id, receipt] : receipts)
 		{
-			{ "m.read",
+			const auto &[event_id, ms]
+			{
+				receipt
+			};
+
+			json::stack::object user
+			{
+				m_read, user_id
+			};
+
 			{
-				{ user.user_id, m_read }
-			}}
-		}}}
+				json::stack::object data
+				{
+					user, "data"
+				};
+
+				json::stack::member
+				{
+					data, "ts", json::value{ms}
+				};
+			}
+
+			json::stack::array event_ids
+			{
+				user, "event_ids"
+			};
+
+			event_ids.append(event_id);
+		}
+	}
+
+	json::iov edu_event, content;
+	const json::iov::push push[]
+	{
+		{ edu_event, { "type",     "m.receipt"                   } },
+		{ edu_event, { "room_id",  room_id                       } },
+		{ content,   { room_id,    json::object{out.completed()} } },
 	};
 
 	// EDU options
@@ -409,12 +580,3 @@ try
 		edu_event, content, opts
 	};
 }
-catch(const std::exception &e)
-{
-	log::error
-	{
-		m::receipt::log, "ircd.read hook on %s for federation broadcast :%s",
-		string_view{event.event_id},
-		e.what(),
-	};
-}
@@ -96,6 +96,10 @@ try
 	if(likely(m::exists(event_id)))
 		return;
 
+	// Another eval or fetch may already be acquiring it.
+	if(m::fetch::wait(event_id, seconds(fetch_timeout)))
+		return;
+
 	log::dwarning
 	{
 		log, "%s in %s by %s relates to missing %s; fetching...",
@@ -272,7 +272,7 @@ ircd::m::auth_room_member_invite(const m::event &event,
 	// allow.
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		data.auth_power? *data.auth_power : m::event{}, *data.auth_create, data.auth_power_idx
 	};
 
 	if(power(at<"sender"_>(event), "invite"))
@@ -348,7 +348,7 @@ ircd::m::auth_room_member_leave(const m::event &event,
 
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		data.auth_power? *data.auth_power : m::event{}, *data.auth_create, data.auth_power_idx
 	};
 
 	if(!data.auth_member_target)
@@ -422,7 +422,7 @@ ircd::m::auth_room_member_ban(const m::event &event,
 
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		data.auth_power? *data.auth_power : m::event{}, *data.auth_create, data.auth_power_idx
 	};
 
 	// ii. If the sender's power level is greater than or equal to the
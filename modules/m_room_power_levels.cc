@@ -135,7 +135,7 @@ ircd::m::auth_room_power_levels(const m::event &event,
 
 	const m::room::power old_power
 	{
-		*data.auth_power, *data.auth_create
+		*data.auth_power, *data.auth_create, data.auth_power_idx
 	};
 
 	const m::room::power new_power
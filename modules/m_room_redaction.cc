@@ -47,7 +47,7 @@ ircd::m::auth_room_redaction(const m::event &event,
 	const m::event::prev prev{event};
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		data.auth_power? *data.auth_power : m::event{}, *data.auth_create, data.auth_power_idx
 	};
 
 	// a. If the sender's power level is greater than or equal to the
@@ -169,6 +169,10 @@ try
 	if(likely(m::exists(redacts)))
 		return;
 
+	// Another eval or fetch may already be acquiring it.
+	if(m::fetch::wait(redacts, seconds(redaction_fetch_timeout)))
+		return;
+
 	log::dwarning
 	{
 		log, "%s in %s by %s redacts missing %s; fetching...",
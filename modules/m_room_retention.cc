@@ -0,0 +1,189 @@
+// The Construct
+//
+// Copyright (C) The Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2020 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::m::retention
+{
+	static int64_t max_lifetime(const event::idx &);
+	static size_t purge_room(const room::id &, const event::idx &);
+	static void worker();
+	static void fini();
+	static void init();
+
+	extern conf::item<bool> enable;
+	extern conf::item<seconds> interval;
+	extern conf::item<milliseconds> lifetime_min;
+	extern context worker_context;
+}
+
+ircd::mapi::header
+IRCD_MODULE
+{
+	"Matrix m.room.retention",
+	ircd::m::retention::init,
+	ircd::m::retention::fini,
+};
+
+decltype(ircd::m::retention::enable)
+ircd::m::retention::enable
+{
+	{ "name",      "ircd.m.room.retention.enable"  },
+	{ "default",   false                           },
+};
+
+/// Time between passes over the rooms with a retention policy.
+decltype(ircd::m::retention::interval)
+ircd::m::retention::interval
+{
+	{ "name",      "ircd.m.room.retention.interval"  },
+	{ "default",   3600L                             },
+};
+
+/// Lifetimes in a policy shorter than this are raised to it.
+decltype(ircd::m::retention::lifetime_min)
+ircd::m::retention::lifetime_min
+{
+	{ "name",      "ircd.m.room.retention.max_lifetime.min"  },
+	{ "default",   long(86400 * 1000L)                       },
+};
+
+decltype(ircd::m::retention::worker_context)
+ircd::m::retention::worker_context;
+
+void
+ircd::m::retention::init()
+{
+	if(!enable)
+		return;
+
+	worker_context = context
+	{
+		"m.retention",
+		256_KiB,
+		&worker,
+		context::POST,
+	};
+}
+
+void
+ircd::m::retention::fini()
+{
+	if(!worker_context)
+		return;
+
+	worker_context.terminate();
+	worker_context.join();
+}
+
+void
+ircd::m::retention::worker()
+try
+{
+	while(1)
+	{
+		ctx::sleep(seconds(interval));
+
+		// The purges yield; the rooms are collected from the type index first.
+		std::vector<std::pair<std::string, event::idx>> policies;
+		events::type::for_each_in("m.room.retention", [&policies]
+		(const string_view &, const event::idx &event_idx)
+		{
+			m::get(std::nothrow, event_idx, "room_id", [&policies, &event_idx]
+			(const string_view &room_id)
+			{
+				policies.emplace_back(room_id, event_idx);
+			});
+
+			return true;
+		});
+
+		for(const auto &[room_id, event_idx] : policies)
+			purge_room(room_id, event_idx);
+	}
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "Room retention worker :%s",
+		e.what(),
+	};
+}
+
+size_t
+ircd::m::retention::purge_room(const room::id &room_id,
+                               const event::idx &event_idx)
+try
+{
+	const m::room room
+	{
+		room_id
+	};
+
+	// Only the present policy of the room applies.
+	if(room::state{room}.get(std::nothrow, "m.room.retention", "") != event_idx)
+		return 0;
+
+	const int64_t lifetime
+	{
+		max_lifetime(event_idx)
+	};
+
+	if(lifetime <= 0)
+		return 0;
+
+	const int64_t before_ts
+	{
+		ircd::time<milliseconds>() - std::max(lifetime, milliseconds(lifetime_min).count())
+	};
+
+	const size_t ret
+	{
+		room::purge(room, before_ts)
+	};
+
+	if(ret)
+		log::info
+		{
+			m::log, "Retention purged %zu events in %s older than %ld",
+			ret,
+			string_view{room_id},
+			before_ts,
+		};
+
+	return ret;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		m::log, "Retention purge of %s :%s",
+		string_view{room_id},
+		e.what(),
+	};
+
+	return 0;
+}
+
+int64_t
+ircd::m::retention::max_lifetime(const event::idx &event_idx)
+{
+	int64_t ret {0};
+	m::get(std::nothrow, event_idx, "content", [&ret]
+	(const json::object &content)
+	{
+		ret = content.get<int64_t>("max_lifetime", 0L);
+	});
+
+	return ret;
+}
@@ -45,7 +45,7 @@ ircd::m::auth_room_third_party_invite(const event &event,
 
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		data.auth_power? *data.auth_power : m::event{}, *data.auth_create, data.auth_power_idx
 	};
 
 	// a. Allow if and only if sender's current power level is greater
@@ -39,10 +39,19 @@ get__download_local(client &client,
                     const string_view &file,
                     const m::room &room);
 
+static std::optional<pair<size_t>>
+parse_range(const m::resource::request &request,
+            const size_t &file_size);
+
 static m::resource::response
 get__download(client &client,
               const m::resource::request &request)
 {
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::media
+	};
+
 	if(request.parv.size() < 2)
 		throw http::error
 		{
@@ -73,6 +82,80 @@ get__download(client &client,
 		request.query.get<bool>("allow_remote", true)
 	};
 
+	// While another request is fetching the remote file it is streamed to
+	// this client as it arrives rather than after it's stored.
+	const m::room::id::buf remote_room_id
+	{
+		!my_host(server) && !request.head.range?
+			m::media::file::room_id({server, file}):
+			m::room::id::buf{}
+	};
+
+	if(remote_room_id && !exists(remote_room_id))
+	{
+		// Fetching remote media is optional work under load.
+		if(resource::method::shedding())
+			resource::method::shed();
+
+		static const auto &addl_headers
+		{
+			"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
+		};
+
+		bool head_sent {false};
+		size_t expect(0), sent(0);
+		const auto head{[&client, &head_sent, &expect]
+		(const string_view &content_type, const size_t &length)
+		{
+			m::resource::response
+			{
+				client,
+				http::OK,
+				content_type,
+				length,
+				addl_headers,
+			};
+
+			head_sent = true;
+			expect = length;
+		}};
+
+		const auto content{[&client, &sent]
+		(const const_buffer &piece)
+		{
+			sent += client.write_all(piece);
+		}};
+
+		try
+		{
+			if(m::media::stream(remote_room_id, head, content))
+				return {};
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			if(!head_sent)
+				throw;
+
+			log::derror
+			{
+				m::media::log, "Streaming %s/%s failed at %zu of %zu bytes :%s",
+				server,
+				file,
+				sent,
+				expect,
+				e.what(),
+			};
+
+			// Have to kill client here after failing content length expectation.
+			client.close(net::dc::RST, net::close_ignore);
+			return {};
+		}
+	}
+
 	const m::room::id::buf room_id
 	{
 		m::media::file::download({server, file}, user_id)
@@ -127,48 +210,201 @@ get__download_local(client &client,
 		};
 	});
 
-	static const auto &addl_headers
+	const auto range
+	{
+		parse_range(request, file_size)
+	};
+
+	const bool partial
+	{
+		bool(range)
+	};
+
+	const pair<size_t> span
+	{
+		range?
+			*range:
+			pair<size_t>{0, file_size}
+	};
+
+	char content_range_buf[96];
+	const string_view content_range
+	{
+		!partial?
+			string_view{}:
+		span.first < span.second?
+			string_view{fmt::sprintf
+			{
+				content_range_buf, "Content-Range: bytes %zu-%zu/%zu\r\n",
+				span.first,
+				span.second - 1,
+				file_size,
+			}}:
+			string_view{fmt::sprintf
+			{
+				content_range_buf, "Content-Range: bytes */%zu\r\n",
+				file_size,
+			}}
+	};
+
+	char headers_buf[256];
+	const string_view addl_headers{fmt::sprintf
+	{
+		headers_buf, "%s%s%s",
+		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv,
+		"Accept-Ranges: bytes\r\n"_sv,
+		content_range,
+	}};
+
+	if(partial && span.first >= span.second)
+		return m::resource::response
+		{
+			client,
+			http::RANGE_NOT_SATISFIABLE,
+			content_type,
+			0UL,
+			addl_headers,
+		};
+
+	const auto code
 	{
-		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
+		partial?
+			http::PARTIAL_CONTENT:
+			http::OK
 	};
 
-	// Send HTTP head to client
-	m::resource::response
+	const size_t length
 	{
-		client,
-		http::OK,
-		content_type,
-		file_size,
-		addl_headers,
+		span.second - span.first
 	};
 
+	// The HTTP head is sent with the first block; the blocks are written
+	// directly out of the database without copying.
+	bool head_sent {false};
 	size_t sent{0}, read
 	{
-		m::media::file::read(room, [&client, &sent]
+		m::media::file::read(room, span, [&]
 		(const string_view &block)
 		{
-			sent += write_all(*client.sock, block);
+			if(likely(head_sent))
+			{
+				sent += client.write_all(block);
+				return;
+			}
+
+			m::resource::response
+			{
+				client,
+				code,
+				content_type,
+				length,
+				addl_headers,
+				block,
+			};
+
+			head_sent = true;
+			sent += size(block);
 		})
 	};
 
-	if(unlikely(read != file_size))
+	if(!head_sent)
+		m::resource::response
+		{
+			client,
+			code,
+			content_type,
+			length,
+			addl_headers,
+		};
+
+	if(unlikely(read != length))
 		log::error
 		{
 			m::media::log, "File %s/%s [%s] size mismatch: expected %zu got %zu",
 			server,
 			file,
 			string_view{room.room_id},
-			file_size,
+			length,
 			read
 		};
 
 	// Have to kill client here after failing content length expectation.
-	if(unlikely(read != file_size))
+	if(unlikely(read != length))
 		client.close(net::dc::RST, net::close_ignore);
 
 	return {};
 }
 
+/// Interprets a single "bytes=" range of the request against the file. No
+/// value is returned when the whole file should be sent: there's no Range,
+/// it has a unit or form we don't serve (e.g. multiple ranges), or there's
+/// an If-Range, whose validator can't be ours since we send none. An empty
+/// span is returned when the range is unsatisfiable.
+std::optional<ircd::pair<size_t>>
+parse_range(const m::resource::request &request,
+            const size_t &file_size)
+{
+	const auto &range
+	{
+		request.head.range
+	};
+
+	if(!range || request.head.if_range)
+		return {};
+
+	if(!startswith(range, "bytes="))
+		return {};
+
+	const auto spec
+	{
+		strip(lstrip(range, "bytes="), ' ')
+	};
+
+	if(has(spec, ','))
+		return {};
+
+	const auto &[first, last]
+	{
+		split(spec, '-')
+	};
+
+	if(!first && !last)
+		return {};
+
+	if((first && !lex_castable<size_t>(first)) || (last && !lex_castable<size_t>(last)))
+		return {};
+
+	// Suffix form: the final `last` bytes.
+	if(!first)
+	{
+		const auto suffix
+		{
+			std::min(lex_cast<size_t>(last), file_size)
+		};
+
+		return suffix?
+			pair<size_t>{file_size - suffix, file_size}:
+			pair<size_t>{0, 0};
+	}
+
+	const auto start
+	{
+		lex_cast<size_t>(first)
+	};
+
+	const auto stop
+	{
+		last?
+			std::min(lex_cast<size_t>(last) + 1, file_size):
+			file_size
+	};
+
+	if(start >= file_size || start >= stop)
+		return pair<size_t>{0, 0};
+
+	return pair<size_t>{start, stop};
+}
+
 static m::resource::method
 method_get
 {
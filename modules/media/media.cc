@@ -100,12 +100,208 @@ ircd::m::media::blocks_descriptor
 	60s * 60 * 24 * 42,
 };
 
+// Thumbnails column
+decltype(ircd::m::media::thumbnails_descriptor)
+ircd::m::media::thumbnails_descriptor
+{
+	// name
+	"thumbnails",
+
+	// explain
+	R"(
+	Key-value store of generated thumbnails. The key is the plaintext
+	"server/mediaid method WxH" of the original file with the snapped
+	dimensions; the value is the binary result of the thumbnailer, which
+	has the same content type as the original.
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+
+	bool(blocks_cache_enable)? -1 : 0,
+
+	bool(blocks_cache_comp_enable)? -1 : 0,
+
+	// bloom_bits
+	10,
+
+	// expect hit
+	false,
+
+	// block_size
+	32_KiB,
+
+	// meta block size
+	512,
+
+	// compression
+	{}, // no compression
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target file size
+	{
+		256_MiB, // base
+		1L,      // multiplier
+	},
+
+	// max bytes for each level
+	{},
+
+	// compaction_period
+	60s * 60 * 24 * 42,
+};
+
+// Refs column
+decltype(ircd::m::media::refs_descriptor)
+ircd::m::media::refs_descriptor
+{
+	// name
+	"refs",
+
+	// explain
+	R"(
+	Reference count of each block in the blocks column, keyed by the same
+	sha256-b58 hash. The value is the number of ircd.file.block events
+	naming the block across all files. Blocks stored before this column
+	existed are pinned with a count of -1 when first referenced again.
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(uint64_t)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+
+	// cache size
+	-1,
+
+	// cache size for compressed assets
+	0,
+
+	// bloom_bits
+	10,
+
+	// expect hit
+	true,
+
+	// block_size
+	4_KiB,
+
+	// meta block size
+	512,
+
+	// compression
+	{}, // no compression
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target file size
+	{
+		64_MiB,  // base
+		1L,      // multiplier
+	},
+
+	// max bytes for each level
+	{},
+
+	// compaction_period
+	60s * 60 * 24 * 42,
+};
+
+// Usage column
+decltype(ircd::m::media::usage_descriptor)
+ircd::m::media::usage_descriptor
+{
+	// name
+	"usage",
+
+	// explain
+	R"(
+	Media storage usage of each uploading user. The key is the user_id and
+	the value is two uint64 counters: the bytes of all files
+	uploaded, and the bytes of the blocks which were new to the server when
+	uploaded; the latter is charged against the quota.
+	)",
+
+	// typing
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	{},      // options
+	{},      // comparaor
+	{},      // prefix transform
+	false,   // drop column
+
+	// cache size
+	0,
+
+	// cache size for compressed assets
+	0,
+
+	// bloom_bits
+	10,
+
+	// expect hit
+	false,
+
+	// block_size
+	4_KiB,
+
+	// meta block size
+	512,
+
+	// compression
+	{}, // no compression
+
+	// compactor
+	{},
+
+	// compaction priority algorithm
+	"kOldestSmallestSeqFirst"s,
+
+	// target file size
+	{
+		64_MiB,  // base
+		1L,      // multiplier
+	},
+
+	// max bytes for each level
+	{},
+
+	// compaction_period
+	60s * 60 * 24 * 42,
+};
+
 decltype(ircd::m::media::description)
 ircd::m::media::description
 {
 	{ "default" }, // requirement of RocksDB
 
 	blocks_descriptor,
+	thumbnails_descriptor,
+	refs_descriptor,
+	usage_descriptor,
 };
 
 decltype(ircd::m::media::blocks_cache_size)
@@ -160,9 +356,32 @@ ircd::m::media::database;
 decltype(ircd::m::media::blocks)
 ircd::m::media::blocks;
 
+decltype(ircd::m::media::thumbnails)
+ircd::m::media::thumbnails;
+
+decltype(ircd::m::media::refs)
+ircd::m::media::refs;
+
+decltype(ircd::m::media::usage)
+ircd::m::media::usage;
+
+decltype(ircd::m::media::refs_mutex)
+ircd::m::media::refs_mutex;
+
+decltype(ircd::m::media::quota)
+ircd::m::media::quota
+{
+	{ "name",     "ircd.media.quota" },
+	{ "default",  0L                 },
+	{ "help",     "Bytes of new blocks each user may upload; 0 is unlimited." },
+};
+
 decltype(ircd::m::media::downloading)
 ircd::m::media::downloading;
 
+decltype(ircd::m::media::download_failed)
+ircd::m::media::download_failed;
+
 decltype(ircd::m::media::downloading_dock)
 ircd::m::media::downloading_dock;
 
@@ -176,6 +395,9 @@ ircd::m::media::init()
 	static const std::string dbopts;
 	database = std::make_shared<db::database>("media", dbopts, description);
 	blocks = db::column{*database, "blocks"};
+	thumbnails = db::column{*database, "thumbnails"};
+	refs = db::column{*database, "refs"};
+	usage = db::column{*database, "usage"};
 
 	// The conf setter callbacks must be manually executed after
 	// the database was just loaded to set the cache size.
@@ -226,25 +448,57 @@ ircd::m::media::file::download(const mxc &mxc,
                                string_view remote)
 try
 {
-	auto iit
+	// Another context is already fetching this file; wait for it to be
+	// stored. Clients can instead stream it from the fetch; see stream().
+	if(const auto it{downloading.find(room_id)}; it != end(downloading))
 	{
-		downloading.emplace(room_id)
-	};
+		const std::shared_ptr<fetch> fetch
+		{
+			it->second
+		};
 
-	if(!iit.second)
-	{
 		downloading_dock.wait([&room_id]
 		{
 			return !downloading.count(room_id);
 		});
 
+		if(fetch->eptr)
+			std::rethrow_exception(fetch->eptr);
+
 		return room_id;
 	}
 
-	const unwind uw{[&iit]
+	if(const auto it{download_failed.find(room_id)}; it != end(download_failed))
+	{
+		if(it->second > now<steady_point>())
+			throw m::error
+			{
+				http::NOT_FOUND, "M_NOT_FOUND",
+				"Fetching '%s/%s' failed recently; not retrying yet.",
+				mxc.server,
+				mxc.mediaid,
+			};
+
+		download_failed.erase(it);
+	}
+
+	const auto fetch
+	{
+		std::make_shared<media::fetch>()
+	};
+
+	fetch->room_id = room_id;
+	const auto iit
+	{
+		downloading.emplace(fetch->room_id, fetch)
+	};
+
+	assert(iit.second);
+	const unwind uw{[&iit, &fetch]
 	{
 		downloading.erase(iit.first);
 		downloading_dock.notify_all();
+		fetch->dock.notify_all();
 	}};
 
 	if(exists(room_id))
@@ -258,9 +512,26 @@ try
 		16_KiB
 	};
 
-	const auto pair
+	// Publish the content received so far to any contexts streaming it.
+	const auto progress{[&fetch]
+	(const http::response::head &head, const const_buffer &received)
+	{
+		if(http::status(head.status) != http::OK || !head.content_length)
+			return;
+
+		if(!fetch->content_length)
+		{
+			fetch->content_length = head.content_length;
+			fetch->content_type = head.content_type;
+		}
+
+		fetch->received = received;
+		fetch->dock.notify_all();
+	}};
+
+	auto pair
 	{
-		download(buf, mxc, remote)
+		fetch_remote(buf, mxc, remote, *fetch, progress)
 	};
 
 	const auto &head
@@ -268,9 +539,16 @@ try
 		pair.first
 	};
 
+	fetch->buf = std::move(pair.second);
+	fetch->received = fetch->buf;
+	fetch->content_length = size(fetch->buf);
+	fetch->content_type = head.content_type;
+	fetch->done = true;
+	fetch->dock.notify_all();
+
 	const const_buffer &content
 	{
-		pair.second
+		fetch->buf
 	};
 
 	char mime_type_buf[64];
@@ -297,7 +575,7 @@ try
 	create(room, user_id, "file");
 	const unwind_exceptional purge{[&room]
 	{
-		m::room::purge(room);
+		file::purge(room);
 	}};
 
 	const size_t written
@@ -327,6 +605,160 @@ ircd::m::media::download_timeout
 	{ "default",  30L                           },
 };
 
+decltype(ircd::m::media::download_failed_ttl)
+ircd::m::media::download_failed_ttl
+{
+	{ "name",     "ircd.media.download.failed.ttl" },
+	{ "default",  300L                             },
+	{ "help",     "Seconds a failed remote fetch is not retried." },
+};
+
+/// Performs the remote request for the leading context. A failure is shared
+/// with any waiters and, unless the context was interrupted, remembered for
+/// download.failed.ttl so every client asking for the same broken file
+/// doesn't cause another fetch.
+std::pair
+<
+	ircd::http::response::head,
+	ircd::unique_buffer<ircd::mutable_buffer>
+>
+ircd::m::media::fetch_remote(const mutable_buffer &buf,
+                             const mxc &mxc,
+                             const string_view &remote,
+                             fetch &fetch,
+                             const file::progress &progress)
+try
+{
+	// The received view is into the request, gone once this throws.
+	const unwind_exceptional clear{[&fetch]
+	{
+		fetch.received = {};
+		fetch.dock.notify_all();
+	}};
+
+	auto ret
+	{
+		file::download(buf, mxc, remote, nullptr, progress)
+	};
+
+	if(!ret.second)
+		throw m::error
+		{
+			http::NOT_FOUND, "M_NOT_FOUND",
+			"Server '%s' did not provide media for '%s/%s'",
+			remote,
+			mxc.server,
+			mxc.mediaid,
+		};
+
+	return ret;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const ctx::terminated &)
+{
+	throw;
+}
+catch(...)
+{
+	fetch.eptr = std::current_exception();
+	download_failed[std::string(fetch.room_id)] = now<steady_point>() + seconds(download_failed_ttl);
+	throw;
+}
+
+/// Streams a file to the closures as it arrives from a remote while another
+/// context fetches it; the content is copied out of the pending request in
+/// each step since it vanishes if the fetch fails. Returns false without
+/// calling anything if the file isn't being fetched (or the fetch ended
+/// before anything was received); the caller reads it from storage then.
+/// Once the head was sent a failure is thrown after a partial body.
+bool
+ircd::m::media::stream(const m::room::id &room_id,
+                       const stream_head &head,
+                       const file::closure &closure)
+{
+	const auto it
+	{
+		downloading.find(room_id)
+	};
+
+	if(it == end(downloading))
+		return false;
+
+	const std::shared_ptr<media::fetch> fetch
+	{
+		it->second
+	};
+
+	fetch->dock.wait([&fetch, &room_id]
+	{
+		return fetch->content_length || fetch->eptr || !downloading.count(room_id);
+	});
+
+	if(fetch->eptr)
+		std::rethrow_exception(fetch->eptr);
+
+	if(!fetch->content_length)
+		return false;
+
+	head(fetch->content_type, fetch->content_length);
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		64_KiB
+	};
+
+	size_t sent(0);
+	while(sent < fetch->content_length)
+	{
+		fetch->dock.wait([&fetch, &sent]
+		{
+			return false
+			|| size(fetch->received) > sent
+			|| fetch->eptr
+			|| fetch->done
+			|| !downloading.count(room_id);
+		});
+
+		if(fetch->eptr)
+			std::rethrow_exception(fetch->eptr);
+
+		if(unlikely(size(fetch->received) <= sent))
+			throw m::NOT_FOUND
+			{
+				"Fetch of %s ended at %zu of %zu bytes",
+				string_view{room_id},
+				sent,
+				fetch->content_length,
+			};
+
+		const const_buffer remain
+		{
+			data(fetch->received) + sent, size(fetch->received) - sent
+		};
+
+		// Owned by the fetch once done; no copy is needed.
+		if(fetch->done)
+		{
+			closure(remain);
+			sent += size(remain);
+			continue;
+		}
+
+		const const_buffer piece
+		{
+			data(buf), copy(buf, remain)
+		};
+
+		closure(piece);
+		sent += size(piece);
+	}
+
+	return true;
+}
+
 std::pair
 <
 	ircd::http::response::head,
@@ -336,7 +768,8 @@ IRCD_MODULE_EXPORT
 ircd::m::media::file::download(const mutable_buffer &buf_,
                                const mxc &mxc,
                                string_view remote,
-                               server::request::opts *const opts)
+                               server::request::opts *const opts,
+                               const progress &progress)
 {
 	assert(remote || !my_host(mxc.server));
 	assert(!remote || !my_host(remote));
@@ -353,12 +786,25 @@ ircd::m::media::file::download(const mutable_buffer &buf_,
 	};
 	consume(buf, size(json::get<"uri"_>(fedopts.request)));
 
+	// The head is parsed for each call, after which its views into our
+	// buffer remain valid for the callee.
+	fed::request *request {nullptr};
+	if(progress)
+		fedopts.in.progress = [&request, &progress]
+		(const const_buffer &, const const_buffer &received)
+		{
+			assert(request);
+			progress(server::in::gethead(*request), received);
+		};
+
 	//TODO: --- This should use the progress callback to build blocks
 	fed::request remote_request
 	{
 		buf, std::move(fedopts)
 	};
 
+	request = &remote_request;
+
 	if(!remote_request.wait(seconds(download_timeout), std::nothrow))
 		throw m::error
 		{
@@ -432,6 +878,19 @@ size_t
 IRCD_MODULE_EXPORT
 ircd::m::media::file::read(const m::room &room,
                            const closure &closure)
+{
+	return read(room, {0, -1UL}, closure);
+}
+
+/// Reads the bytes of the file in the half-open range [first, second).
+/// Blocks entirely outside the range are skipped by the size in their event
+/// without being fetched or prefetched; blocks straddling an end are trimmed
+/// before reaching the closure. Returns the number of bytes given to it.
+size_t
+IRCD_MODULE_EXPORT
+ircd::m::media::file::read(const m::room &room,
+                           const pair<size_t> &range,
+                           const closure &closure)
 {
 	static const event::fetch::opts fopts
 	{
@@ -444,7 +903,7 @@ ircd::m::media::file::read(const m::room &room,
 		room, 1, &fopts
 	};
 
-	if(!it)
+	if(!it || range.first >= range.second)
 		return ret;
 
 	size_t events_fetched(0), events_prefetched(0);
@@ -453,15 +912,15 @@ ircd::m::media::file::read(const m::room &room,
 		room, 1, &fopts
 	};
 
-	size_t blocks_fetched(0), blocks_prefetched(0);
+	size_t blocks_fetched(0), blocks_prefetched(0), prefetch_pos(0);
 	room::events bpf
 	{
 		room, 1, &fopts
 	};
 
-	for(; it; ++it)
+	for(size_t pos(0); it && pos < range.second; ++it)
 	{
-		for(; bpf && blocks_prefetched < blocks_fetched + blocks_prefetch; ++bpf)
+		for(; bpf && prefetch_pos < range.second && blocks_prefetched < blocks_fetched + blocks_prefetch; ++bpf)
 		{
 			for(; epf && events_prefetched < events_fetched + events_prefetch; ++epf)
 				events_prefetched += epf.prefetch();
@@ -475,6 +934,15 @@ ircd::m::media::file::read(const m::room &room,
 			if(at<"type"_>(event) != "ircd.file.block")
 				continue;
 
+			const auto &block_size
+			{
+				at<"content"_>(event).get<size_t>("size")
+			};
+
+			prefetch_pos += block_size;
+			if(prefetch_pos <= range.first)
+				continue;
+
 			const json::string &hash
 			{
 				at<"content"_>(event).at("hash")
@@ -483,10 +951,6 @@ ircd::m::media::file::read(const m::room &room,
 			blocks_prefetched += block::prefetch(hash);
 		}
 
-		if(!blocks_fetched)
-			ctx::yield();
-
-		++blocks_fetched;
 		const m::event &event
 		{
 			*it
@@ -495,14 +959,27 @@ ircd::m::media::file::read(const m::room &room,
 		if(at<"type"_>(event) != "ircd.file.block")
 			continue;
 
-		const json::string &hash
+		const auto &block_size
 		{
-			at<"content"_>(event).at("hash")
+			at<"content"_>(event).get<size_t>("size")
 		};
 
-		const auto &block_size
+		const size_t block_pos
 		{
-			at<"content"_>(event).get<size_t>("size")
+			pos
+		};
+
+		pos += block_size;
+		if(pos <= range.first)
+			continue;
+
+		if(!blocks_fetched)
+			ctx::yield();
+
+		++blocks_fetched;
+		const json::string &hash
+		{
+			at<"content"_>(event).at("hash")
 		};
 
 		const auto handle{[&](const const_buffer &block)
@@ -520,7 +997,13 @@ ircd::m::media::file::read(const m::room &room,
 				};
 
 			assert(size(block) == block_size);
-			ret += size(block);
+			const const_buffer part
+			{
+				data(block) + (std::max(range.first, block_pos) - block_pos),
+				data(block) + (std::min(range.second, pos) - block_pos),
+			};
+
+			ret += size(part);
 
 			#if 0
 			log::debug
@@ -537,7 +1020,7 @@ ircd::m::media::file::read(const m::room &room,
 			};
 			#endif
 
-			closure(block);
+			closure(part);
 		}};
 
 		if(unlikely(!block::get(hash, handle)))
@@ -554,6 +1037,41 @@ ircd::m::media::file::read(const m::room &room,
 	return ret;
 }
 
+/// Releases the file's references to its blocks, deleting those no other
+/// file references, then purges the file room. Returns the number of blocks
+/// deleted.
+size_t
+IRCD_MODULE_EXPORT
+ircd::m::media::file::purge(const m::room &room)
+{
+	static const event::fetch::opts fopts
+	{
+		event::keys::include { "content", "type" }
+	};
+
+	size_t ret(0);
+	for(room::events it{room, 1, &fopts}; it; ++it)
+	{
+		const m::event &event
+		{
+			*it
+		};
+
+		if(at<"type"_>(event) != "ircd.file.block")
+			continue;
+
+		const json::string &hash
+		{
+			at<"content"_>(event).at("hash")
+		};
+
+		ret += block::unref(hash);
+	}
+
+	m::room::purge(room);
+	return ret;
+}
+
 //
 // media::file
 //
@@ -606,12 +1124,41 @@ ircd::m::media::block::set(const m::room &room,
 		b58::encode_size(sha256::digest_size)
 	};
 
+	const sha256::buf digest
+	{
+		sha256{block}
+	};
+
 	char b58buf[bufsz];
-	const auto hash
+	const string_view hash
 	{
-		set(mutable_buffer{b58buf}, block)
+		b58::encode(b58buf, digest)
 	};
 
+	// Identical blocks share the key; the block is only written for its
+	// first reference and every other reference only counts.
+	{
+		const std::lock_guard lock
+		{
+			refs_mutex
+		};
+
+		const uint64_t count
+		{
+			block::refs(hash)
+		};
+
+		if(!count && db::has(blocks, hash))
+			db::write(media::refs, hash, byte_view<string_view>(uint64_t(-1)));
+		else if(!count)
+		{
+			set(hash, block);
+			db::write(media::refs, hash, byte_view<string_view>(uint64_t(1)));
+		}
+		else if(count != uint64_t(-1))
+			db::write(media::refs, hash, byte_view<string_view>(count + 1));
+	}
+
 	return send(room, user_id, "ircd.file.block", json::members
 	{
 		{ "size",  long(size(block))  },
@@ -670,6 +1217,140 @@ ircd::m::media::block::prefetch(const string_view &b58hash)
 	return db::prefetch(blocks, b58hash);
 }
 
+uint64_t
+IRCD_MODULE_EXPORT
+ircd::m::media::block::refs(const string_view &b58hash)
+{
+	uint64_t ret(0);
+	media::refs(b58hash, std::nothrow, [&ret]
+	(const string_view &value)
+	{
+		ret = byte_view<uint64_t>(value);
+	});
+
+	return ret;
+}
+
+/// Drops one reference to the block; the block itself is deleted with its
+/// last reference. Pinned blocks are never deleted. Returns true if the
+/// block was deleted.
+bool
+IRCD_MODULE_EXPORT
+ircd::m::media::block::unref(const string_view &b58hash)
+{
+	const std::lock_guard lock
+	{
+		refs_mutex
+	};
+
+	const uint64_t count
+	{
+		refs(b58hash)
+	};
+
+	if(!count || count == uint64_t(-1))
+		return false;
+
+	if(count > 1)
+	{
+		db::write(media::refs, b58hash, byte_view<string_view>(count - 1));
+		return false;
+	}
+
+	db::del(blocks, b58hash);
+	db::del(media::refs, b58hash);
+	return true;
+}
+
+//
+// media::usage
+//
+
+std::pair<size_t, size_t>
+ircd::m::media::get_usage(const m::user::id &user_id)
+{
+	std::pair<size_t, size_t> ret {0, 0};
+	usage(user_id, std::nothrow, [&ret]
+	(const string_view &value)
+	{
+		uint64_t counter[2] {0, 0};
+		copy(mutable_buffer(reinterpret_cast<char *>(counter), sizeof(counter)), value);
+		ret = { counter[0], counter[1] };
+	});
+
+	return ret;
+}
+
+void
+ircd::m::media::add_usage(const m::user::id &user_id,
+                          const size_t &logical,
+                          const size_t &physical)
+{
+	const std::lock_guard lock
+	{
+		refs_mutex
+	};
+
+	const auto prior
+	{
+		get_usage(user_id)
+	};
+
+	const uint64_t counter[2]
+	{
+		prior.first + logical,
+		prior.second + physical,
+	};
+
+	db::write(usage, user_id, const_buffer
+	{
+		reinterpret_cast<const char *>(counter), sizeof(counter)
+	});
+}
+
+/// Bytes of the content which would be new to the server: the sum of its
+/// blocks not already stored under any file. This is what an upload of the
+/// content is charged.
+size_t
+ircd::m::media::charge(const const_buffer &content)
+{
+	static constexpr const auto bufsz
+	{
+		b58::encode_size(sha256::digest_size)
+	};
+
+	std::set<std::string, std::less<>> seen;
+	size_t ret(0);
+	for(size_t off(0); off < size(content); off += 32_KiB)
+	{
+		const const_buffer block
+		{
+			data(content) + off, std::min(size(content) - off, size_t(32_KiB))
+		};
+
+		const sha256::buf digest
+		{
+			sha256{block}
+		};
+
+		char b58buf[bufsz];
+		const string_view hash
+		{
+			b58::encode(b58buf, digest)
+		};
+
+		if(!seen.emplace(hash).second)
+			continue;
+
+		if(block::refs(hash) || db::has(blocks, hash))
+			continue;
+
+		ret += size(block);
+	}
+
+	return ret;
+}
+
 //
 // media::mxc
 //
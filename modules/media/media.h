@@ -11,6 +11,9 @@
 namespace ircd::m::media
 {
 	struct magick;
+	struct fetch;
+
+	using stream_head = std::function<void (const string_view &content_type, const size_t &length)>;
 
 	static void init();
 	static void fini();
@@ -23,15 +26,50 @@ namespace ircd::m::media
 	extern conf::item<size_t> blocks_prefetch;
 	extern conf::item<size_t> events_prefetch;
 	extern const db::descriptor blocks_descriptor;
+	extern const db::descriptor thumbnails_descriptor;
+	extern const db::descriptor refs_descriptor;
+	extern const db::descriptor usage_descriptor;
 	extern const db::description description;
 	extern std::shared_ptr<db::database> database;
 	extern db::column blocks;
+	extern db::column thumbnails;
+	extern db::column refs;
+	extern db::column usage;
+	extern ctx::mutex refs_mutex;
+	extern conf::item<size_t> quota;
+
+	std::pair<size_t, size_t> get_usage(const m::user::id &);
+	void add_usage(const m::user::id &, const size_t &logical, const size_t &physical);
+	size_t charge(const const_buffer &content);
 
 	extern conf::item<seconds> download_timeout;
-	extern std::set<m::room::id> downloading;
+	extern conf::item<seconds> download_failed_ttl;
+	extern std::map<m::room::id, std::shared_ptr<fetch>, std::less<>> downloading;
+	extern std::map<std::string, steady_point, std::less<>> download_failed;
 	extern ctx::dock downloading_dock;
+
+	bool stream(const m::room::id &, const stream_head &, const file::closure &);
+
+	std::pair<http::response::head, unique_buffer<mutable_buffer>>
+	fetch_remote(const mutable_buffer &, const mxc &, const string_view &remote, fetch &, const file::progress &);
 }
 
+/// State of a remote file being fetched, shared by the context fetching it
+/// with every context streaming it to a client in the meantime. Until done
+/// the received bytes are a view into the pending request which vanishes if
+/// it fails; once done they are owned here.
+struct ircd::m::media::fetch
+{
+	m::room::id::buf room_id;
+	std::string content_type;
+	size_t content_length {0};
+	const_buffer received;
+	unique_buffer<mutable_buffer> buf;
+	std::exception_ptr eptr;
+	bool done {false};
+	ctx::dock dock;
+};
+
 namespace ircd::m::media::thumbnail
 {
 	extern conf::item<bool> enable;
@@ -43,4 +81,17 @@ namespace ircd::m::media::thumbnail
 	extern conf::item<size_t> height_max;
 	extern conf::item<std::string> mime_whitelist;
 	extern conf::item<std::string> mime_blacklist;
+	extern conf::item<bool> cache_enable;
+	extern conf::item<bool> pregen_enable;
+	extern conf::item<std::string> sizes;
+
+	using closure = std::function<void (const const_buffer &)>;
+
+	bool supported() noexcept;
+	bool permitted(const string_view &mime_type) noexcept;
+	pair<size_t> snap(const string_view &method, const pair<size_t> &);
+	string_view key(const mutable_buffer &, const mxc &, const string_view &method, const pair<size_t> &);
+	bool get(const mxc &, const string_view &method, const pair<size_t> &, const closure &);
+	void generate(const mxc &, const const_buffer &, const string_view &method, const pair<size_t> &, const closure &);
+	size_t pregen(const mxc &, const const_buffer &, const string_view &content_type);
 }
@@ -76,6 +76,30 @@ ircd::m::media::thumbnail::mime_blacklist
 	{ "default",  ""                                      },
 };
 
+decltype(ircd::m::media::thumbnail::cache_enable)
+ircd::m::media::thumbnail::cache_enable
+{
+	{ "name",     "ircd.m.media.thumbnail.cache.enable" },
+	{ "default",  true                                  },
+};
+
+decltype(ircd::m::media::thumbnail::pregen_enable)
+ircd::m::media::thumbnail::pregen_enable
+{
+	{ "name",     "ircd.m.media.thumbnail.pregen.enable" },
+	{ "default",  true                                   },
+};
+
+/// Standard thumbnail sizes as method:WxH. Requests are snapped up to the
+/// smallest of these covering them so the cache holds few variants of each
+/// file; these are also generated for local uploads ahead of any request.
+decltype(ircd::m::media::thumbnail::sizes)
+ircd::m::media::thumbnail::sizes
+{
+	{ "name",     "ircd.m.media.thumbnail.sizes" },
+	{ "default",  "crop:32x32 crop:96x96 scale:320x240 scale:640x480 scale:800x600" },
+};
+
 m::resource
 thumbnail_resource__legacy
 {
@@ -106,6 +130,11 @@ m::resource::response
 get__thumbnail(client &client,
                const m::resource::request &request)
 {
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::media
+	};
+
 	if(request.parv.size() < 1)
 		throw m::NEED_MORE_PARAMS
 		{
@@ -132,6 +161,11 @@ get__thumbnail(client &client,
 			m::me()
 	};
 
+	// Fetching remote media is optional work under load.
+	if(!my_host(mxc.server) && resource::method::shedding())
+		if(!exists(m::media::file::room_id(mxc)))
+			resource::method::shed();
+
 	if(!m::media::thumbnail::enable_remote)
 	{
 		const m::room::id::buf room_id
@@ -245,6 +279,47 @@ get__thumbnail_local(client &client,
 		};
 	});
 
+	const bool supported
+	{
+		m::media::thumbnail::supported()
+	};
+
+	const bool valid_args
+	{
+		// Both dimension parameters given in query string
+		(dimension.first && dimension.second)
+
+		// Known thumbnailing method in query string
+		&& (method == "scale" || method == "crop")
+	};
+
+	static const auto &addl_headers
+	{
+		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
+	};
+
+	const auto respond{[&client, &content_type]
+	(const const_buffer &buf)
+	{
+		m::resource::response
+		{
+			client, buf, content_type, http::OK, addl_headers
+		};
+	}};
+
+	// Entries only exist for files which passed the checks below, so a hit
+	// is answered without reading the original at all.
+	const pair<size_t> snapped
+	{
+		supported && valid_args?
+			snap(method, dimension):
+			dimension
+	};
+
+	if(supported && valid_args)
+		if(m::media::thumbnail::get(mxc, method, snapped, respond))
+			return {}; // responded from closure.
+
 	const unique_buffer<mutable_buffer> buf
 	{
 		file_size
@@ -279,28 +354,6 @@ get__thumbnail_local(client &client,
 		split(content_type, ';').first
 	};
 
-	const bool supported
-	{
-		// Available in build
-		#ifdef IRCD_USE_MAGICK
-			(true)
-		#else
-			(false)
-		#endif
-
-		// Enabled by configuration
-		&& enable
-	};
-
-	const bool permitted
-	{
-		// If there's a blacklist, mime type must not in the blacklist.
-		(!mime_blacklist || !has(mime_blacklist, mime_type))
-
-		// If there's a whitelist, mime type must be in the whitelist.
-		&& (!mime_whitelist || has(mime_whitelist, mime_type))
-	};
-
 	const bool animated
 	{
 		// Administrator's fuse to disable animation detection.
@@ -310,28 +363,19 @@ get__thumbnail_local(client &client,
 		&& supported
 
 		// If the type is not permitted don't bother checking for animation.
-		&& permitted
+		&& permitted(mime_type)
 
 		// Case for APNG; do not permit them to be thumbnailed
 		&& (has(mime_type, "image/png") && png::is_animated(buf))
 	};
 
-	const bool valid_args
-	{
-		// Both dimension parameters given in query string
-		(dimension.first && dimension.second)
-
-		// Known thumbnailing method in query string
-		&& (method == "scale" || method == "crop")
-	};
-
 	const bool fallback // Reasons to just send the original image
 	{
 		// Thumbnailer support not enabled or available
 		!supported
 
 		// Access denied for this operation
-		|| !permitted
+		|| !permitted(mime_type)
 
 		// Bypassed to prevent loss of animation
 		|| animated
@@ -349,43 +393,275 @@ get__thumbnail_local(client &client,
 			string_view{room.room_id},
 			content_type,
 			file_size,
-			!permitted?
+			!permitted(mime_type)?
 				"Not permitted":
 			!valid_args?
 				"Invalid arguments":
+			animated?
+				"Animated":
 				"Unknown reason",
 		};
 
-	static const auto &addl_headers
-	{
-		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
-	};
-
 	if(fallback)
 		return m::resource::response
 		{
 			client, buf, content_type, http::OK, addl_headers
 		};
 
-	const auto closure{[&client, &content_type]
-	(const const_buffer &buf)
+	try
 	{
-		m::resource::response
+		generate(mxc, buf, method, snapped, respond);
+	}
+	catch(const magick::busy &e)
+	{
+		log::dwarning
+		{
+			"Not thumbnailing %s/%s [%s] '%s' bytes:%zu :Overloaded :%s",
+			mxc.server,
+			mxc.mediaid,
+			string_view{room.room_id},
+			content_type,
+			file_size,
+			e.what(),
+		};
+
+		// Shed to the original; the next request may find the cache.
+		return m::resource::response
 		{
 			client, buf, content_type, http::OK, addl_headers
 		};
+	}
+
+	return {}; // responded from closure.
+}
+
+//
+// thumbnail
+//
+
+bool
+ircd::m::media::thumbnail::supported()
+noexcept
+{
+	return true
+
+	// Available in build
+	#ifdef IRCD_USE_MAGICK
+		&& (true)
+	#else
+		&& (false)
+	#endif
+
+	// Enabled by configuration
+	&& enable;
+}
+
+bool
+ircd::m::media::thumbnail::permitted(const string_view &mime_type)
+noexcept
+{
+	return true
+
+	// If there's a blacklist, mime type must not in the blacklist.
+	&& (!mime_blacklist || !has(mime_blacklist, mime_type))
+
+	// If there's a whitelist, mime type must be in the whitelist.
+	&& (!mime_whitelist || has(mime_whitelist, mime_type));
+}
+
+/// Rounds the requested dimensions up to the smallest standard size with
+/// the same method which covers them. Requests larger than every standard
+/// size are rounded up to a multiple of 32 instead.
+ircd::pair<size_t>
+ircd::m::media::thumbnail::snap(const string_view &method,
+                                const pair<size_t> &dimension)
+{
+	pair<size_t> ret {0, 0};
+	tokens(sizes, ' ', [&method, &dimension, &ret]
+	(const string_view &token)
+	{
+		const auto &[_method, _dimension]
+		{
+			split(token, ':')
+		};
+
+		const auto &[width, height]
+		{
+			split(_dimension, 'x')
+		};
+
+		const pair<size_t> size
+		{
+			lex_cast<size_t>(width), lex_cast<size_t>(height)
+		};
+
+		const bool covers
+		{
+			_method == method
+			&& size.first >= dimension.first
+			&& size.second >= dimension.second
+		};
+
+		const bool smaller
+		{
+			!ret.first || size.first * size.second < ret.first * ret.second
+		};
+
+		if(covers && smaller)
+			ret = size;
+
+		return true;
+	});
+
+	if(ret.first)
+		return ret;
+
+	const auto round{[](const size_t &val, const size_t &max)
+	{
+		return std::min(((val + 31) / 32) * 32, max);
+	}};
+
+	return
+	{
+		round(dimension.first, width_max),
+		round(dimension.second, height_max),
+	};
+}
+
+ircd::string_view
+ircd::m::media::thumbnail::key(const mutable_buffer &buf,
+                               const mxc &mxc,
+                               const string_view &method,
+                               const pair<size_t> &dimension)
+{
+	return fmt::sprintf
+	{
+		buf, "%s/%s %s %zux%zu",
+		mxc.server,
+		mxc.mediaid,
+		method,
+		dimension.first,
+		dimension.second,
+	};
+}
+
+bool
+ircd::m::media::thumbnail::get(const mxc &mxc,
+                               const string_view &method,
+                               const pair<size_t> &dimension,
+                               const closure &closure)
+{
+	if(!cache_enable || !thumbnails)
+		return false;
+
+	char buf[512];
+	const string_view key
+	{
+		thumbnail::key(buf, mxc, method, dimension)
+	};
+
+	const db::gopts opts;
+	return thumbnails(key, std::nothrow, closure, opts);
+}
+
+/// Runs the thumbnailer on the original file; the result is stored under
+/// its key before being passed to the closure.
+void
+ircd::m::media::thumbnail::generate(const mxc &mxc,
+                                    const const_buffer &file,
+                                    const string_view &method,
+                                    const pair<size_t> &dimension,
+                                    const closure &closure)
+{
+	const auto store{[&mxc, &method, &dimension, &closure]
+	(const const_buffer &result)
+	{
+		if(cache_enable && thumbnails)
+		{
+			char buf[512];
+			const string_view key
+			{
+				thumbnail::key(buf, mxc, method, dimension)
+			};
+
+			db::write(thumbnails, key, result);
+		}
+
+		closure(result);
 	}};
 
 	if(method == "crop")
-		magick::thumbcrop
+		ircd::magick::thumbcrop
 		{
-			buf, dimension, closure
+			file, dimension, store
 		};
 	else
-		magick::thumbnail
+		ircd::magick::thumbnail
 		{
-			buf, dimension, closure
+			file, dimension, store
 		};
+}
 
-	return {}; // responded from closure.
+/// Generates and stores every standard size for a newly uploaded file so
+/// the first requests are served from the cache. Returns the count made.
+size_t
+ircd::m::media::thumbnail::pregen(const mxc &mxc,
+                                  const const_buffer &file,
+                                  const string_view &content_type)
+{
+	const auto mime_type
+	{
+		split(content_type, ';').first
+	};
+
+	const bool eligible
+	{
+		pregen_enable
+		&& cache_enable
+		&& supported()
+		&& permitted(mime_type)
+		&& !(has(mime_type, "image/png") && png::is_animated(file))
+	};
+
+	if(!eligible)
+		return 0;
+
+	size_t ret(0);
+	tokens(sizes, ' ', [&mxc, &file, &ret]
+	(const string_view &token)
+	{
+		const auto &[method, _dimension]
+		{
+			split(token, ':')
+		};
+
+		const auto &[width, height]
+		{
+			split(_dimension, 'x')
+		};
+
+		const pair<size_t> dimension
+		{
+			lex_cast<size_t>(width), lex_cast<size_t>(height)
+		};
+
+		// Pregeneration yields to requests when the thumbnailer is loaded;
+		// the remaining sizes are made on demand instead.
+		try
+		{
+			generate(mxc, file, method, dimension, [&ret]
+			(const const_buffer &)
+			{
+				++ret;
+			});
+		}
+		catch(const ircd::magick::busy &)
+		{
+			return false;
+		}
+
+		return true;
+	});
+
+	return ret;
 }
@@ -34,6 +34,11 @@ m::resource::response
 post__upload(client &client,
              const m::resource::request &request)
 {
+	const allocator::je::arena::scope arena
+	{
+		allocator::je::arena::media
+	};
+
 	const auto &content_type
 	{
 		request.head.content_type
@@ -71,22 +76,46 @@ post__upload(client &client,
 		room_id, &vmopts
 	};
 
-	create(room, request.user_id, "file");
-
 	const unique_buffer<mutable_buffer> buf
 	{
 		request.head.content_length
 	};
 
 	copy(buf, request.content);
-	client.content_consumed += read_all(*client.sock, buf + client.content_consumed);
+	if(client.content_consumed < request.head.content_length)
+		client.content_consumed += read_all(*client.sock, buf + client.content_consumed);
 	assert(client.content_consumed == request.head.content_length);
 
+	// Only blocks new to the server are charged; re-uploading a file which
+	// is already stored costs nothing against the quota.
+	const size_t charged
+	{
+		m::media::charge(buf)
+	};
+
+	const auto used
+	{
+		m::media::get_usage(request.user_id)
+	};
+
+	if(m::media::quota && used.second + charged > size_t(m::media::quota))
+		throw m::error
+		{
+			http::PAYLOAD_TOO_LARGE, "M_TOO_LARGE",
+			"Upload of %zu new bytes exceeds the media quota; %zu of %zu used.",
+			charged,
+			used.second,
+			size_t(m::media::quota),
+		};
+
+	create(room, request.user_id, "file");
 	const size_t written
 	{
 		m::media::file::write(room, request.user_id, buf, content_type)
 	};
 
+	m::media::add_usage(request.user_id, written, charged);
+
 	char uribuf[256];
 	const string_view content_uri
 	{
@@ -103,13 +132,46 @@ post__upload(client &client,
 		filename,
 	};
 
-	return m::resource::response
+	m::resource::response
 	{
 		client, http::CREATED, json::members
 		{
 			{ "content_uri", content_uri }
 		}
 	};
+
+	// The client has its uri; the standard thumbnail sizes are generated now
+	// while the file is still in memory rather than on the first request.
+	if(m::media::thumbnail::pregen_enable) try
+	{
+		const size_t generated
+		{
+			m::media::thumbnail::pregen(mxc, buf, content_type)
+		};
+
+		log::debug
+		{
+			m::media::log, "%s generated %zu thumbnails for `%s'",
+			request.user_id,
+			generated,
+			content_uri,
+		};
+	}
+	catch(const ctx::interrupted &)
+	{
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::derror
+		{
+			m::media::log, "Thumbnail pregeneration for `%s' :%s",
+			content_uri,
+			e.what(),
+		};
+	}
+
+	return {}; // already responded
 }
 
 static const struct m::resource::method::opts
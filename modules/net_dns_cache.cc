@@ -10,17 +10,42 @@
 
 namespace ircd::net::dns::cache
 {
-	static void handle(const m::event &, m::vm::eval &);
+	struct entry;
+	using entries = std::map<std::string, entry, std::less<>>;
+
+	static string_view make_key(const mutable_buffer &, const string_view &type, const string_view &state_key);
+	static bool all_expired(const json::array &rrs, const time_t &ts);
+	static void store(const string_view &type, const string_view &state_key, const json::object &content, const time_t &ts, const bool &write);
+	static entry find(const string_view &type, const string_view &state_key);
+	static bool persist(const string_view &key, const std::string &content);
+	static size_t flush();
+	static void sweep();
+	static void writer();
 
 	static bool put(const string_view &type, const string_view &state_key, const records &rrs);
 	static bool put(const string_view &type, const string_view &state_key, const uint &code, const string_view &msg);
 
+	extern conf::item<size_t> memory_max;
+	extern conf::item<seconds> persist_interval;
 	extern const m::room::id::buf dns_room_id;
-	extern m::hookfn<m::vm::eval &> hook;
+	extern entries memory;
+	extern size_t dirty;
+	extern ctx::dock writer_dock;
+	extern ctx::context writer_context;
 
 	static void init(), fini();
 }
 
+/// Answer held in memory. This is the primary tier of the cache; the room
+/// is only written behind it so answers survive a restart, and only read
+/// when an answer isn't in memory (i.e. the first lookup after a restart).
+struct ircd::net::dns::cache::entry
+{
+	std::shared_ptr<const std::string> content;
+	time_t ts {0};
+	bool dirty {false};
+};
+
 ircd::mapi::header
 IRCD_MODULE
 {
@@ -29,20 +54,39 @@ IRCD_MODULE
 	ircd::net::dns::cache::fini,
 };
 
+decltype(ircd::net::dns::cache::memory_max)
+ircd::net::dns::cache::memory_max
+{
+	{ "name",     "ircd.net.dns.cache.memory.max" },
+	{ "default",  65536L                          },
+};
+
+decltype(ircd::net::dns::cache::persist_interval)
+ircd::net::dns::cache::persist_interval
+{
+	{ "name",     "ircd.net.dns.cache.persist.interval" },
+	{ "default",  15L                                   },
+};
+
 decltype(ircd::net::dns::cache::dns_room_id)
 ircd::net::dns::cache::dns_room_id
 {
 	"dns", m::my_host()
 };
 
-decltype(ircd::net::dns::cache::hook)
-ircd::net::dns::cache::hook
+decltype(ircd::net::dns::cache::memory)
+ircd::net::dns::cache::memory;
+
+decltype(ircd::net::dns::cache::dirty)
+ircd::net::dns::cache::dirty;
+
+decltype(ircd::net::dns::cache::writer_dock)
+ircd::net::dns::cache::writer_dock;
+
+decltype(ircd::net::dns::cache::writer_context)
+ircd::net::dns::cache::writer_context
 {
-	ircd::net::dns::cache::handle,
-	{
-		{ "_site",    "vm.effect"              },
-		{ "room_id",  string_view{dns_room_id} },
-	}
+	"dns.cache", 512_KiB, context::POST, writer
 };
 
 void
@@ -69,6 +113,11 @@ ircd::net::dns::cache::fini()
 	{
 		return waiting.empty();
 	});
+
+	// Persist whatever the writer hasn't gotten to yet.
+	writer_context.terminate();
+	writer_context.join();
+	flush();
 }
 
 bool
@@ -166,15 +215,8 @@ try
 	rr0.~object();
 	array.~array();
 	content.~object();
-	const m::room room
-	{
-		dns_room_id
-	};
-
-	if(unlikely(!exists(room)))
-		create(room, m::me(), "internal");
-
-	send(room, m::me(), type, state_key, json::object(out.completed()));
+	store(type, state_key, json::object(out.completed()), ircd::time(), true);
+	waiter::call(rfc1035::qtype.at(lstrip(type, "ircd.dns.rrs.")), state_key, json::object(out.completed()).get(""));
 	return true;
 }
 catch(const http::error &e)
@@ -294,15 +336,8 @@ try
 
 	array.~array();
 	content.~object();
-	const m::room room
-	{
-		dns_room_id
-	};
-
-	if(unlikely(!exists(room)))
-		create(room, m::me(), "internal");
-
-	send(room, m::me(), type, state_key, json::object{out.completed()});
+	store(type, state_key, json::object(out.completed()), ircd::time(), true);
+	waiter::call(rfc1035::qtype.at(lstrip(type, "ircd.dns.rrs.")), state_key, json::object(out.completed()).get(""));
 	return true;
 }
 catch(const http::error &e)
@@ -372,46 +407,30 @@ ircd::net::dns::cache::get(const hostport &hp,
 			host(hp)
 	};
 
-	const m::room::state state
+	// The entry is copied out; the content is held by reference for the
+	// duration of the closure even if the answer is replaced meanwhile.
+	const entry entry
 	{
-		dns_room_id
+		find(type, state_key)
 	};
 
-	const m::event::idx &event_idx
-	{
-		state.get(std::nothrow, type, state_key)
-	};
-
-	if(!event_idx)
-		return false;
-
-	time_t origin_server_ts;
-	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
+	if(!entry.content)
 		return false;
 
-	bool ret{false};
-	const time_t ts{origin_server_ts / 1000L};
-	m::get(std::nothrow, event_idx, "content", [&hp, &closure, &ret, &ts]
-	(const json::object &content)
+	const json::array &rrs
 	{
-		const json::array &rrs
-		{
-			content.get("")
-		};
+		json::object(*entry.content).get("")
+	};
 
-		// If all records are expired then skip; otherwise since this closure
-		// expects a single array we reveal both expired and valid records.
-		ret = !std::all_of(begin(rrs), end(rrs), [&ts]
-		(const json::object &rr)
-		{
-			return expired(rr, ts);
-		});
+	// If all records are expired then skip; otherwise since this closure
+	// expects a single array we reveal both expired and valid records.
+	if(all_expired(rrs, entry.ts))
+		return false;
 
-		if(ret && closure)
-			closure(hp, rrs);
-	});
+	if(closure)
+		closure(hp, rrs);
 
-	return ret;
+	return true;
 }
 
 bool
@@ -434,39 +453,24 @@ ircd::net::dns::cache::for_each(const hostport &hp,
 			host(hp)
 	};
 
-	const m::room::state state
+	const entry entry
 	{
-		dns_room_id
+		find(type, state_key)
 	};
 
-	const m::event::idx &event_idx
-	{
-		state.get(std::nothrow, type, state_key)
-	};
-
-	if(!event_idx)
-		return false;
-
-	time_t origin_server_ts;
-	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
+	if(!entry.content)
 		return false;
 
-	bool ret{true};
-	const time_t ts{origin_server_ts / 1000L};
-	m::get(std::nothrow, event_idx, "content", [&state_key, &closure, &ret, &ts]
-	(const json::object &content)
+	for(const json::object rr : json::array(json::object(*entry.content).get("")))
 	{
-		for(const json::object rr : json::array(content.get("")))
-		{
-			if(expired(rr, ts))
-				continue;
+		if(dns::expired(rr, entry.ts))
+			continue;
 
-			if(!(ret = closure(state_key, rr)))
-				break;
-		}
-	});
+		if(!closure(state_key, rr))
+			return false;
+	}
 
-	return ret;
+	return true;
 }
 
 bool
@@ -480,14 +484,41 @@ ircd::net::dns::cache::for_each(const string_view &type,
 		make_type(type_buf, type)
 	};
 
+	char prefix_buf[64];
+	const string_view prefix
+	{
+		make_key(prefix_buf, full_type, {})
+	};
+
+	// Answers in memory are visited first from a snapshot, since the closure
+	// may yield and the cache may change meanwhile.
+	std::vector<std::pair<std::string, entry>> answers;
+	for(auto it(memory.lower_bound(prefix)); it != end(memory) && startswith(it->first, prefix); ++it)
+		answers.emplace_back(lstrip(it->first, prefix), it->second);
+
+	for(const auto &[state_key, entry] : answers)
+		for(const json::object rr : json::array(json::object(*entry.content).get("")))
+		{
+			if(dns::expired(rr, entry.ts))
+				continue;
+
+			if(!closure(state_key, rr))
+				return false;
+		}
+
+	// Answers only in the room (i.e. from before a restart) follow.
 	const m::room::state state
 	{
 		dns_room_id
 	};
 
-	return state.for_each(full_type, [&closure]
+	return state.for_each(full_type, [&full_type, &closure]
 	(const string_view &, const string_view &state_key, const m::event::idx &event_idx)
 	{
+		char key_buf[rfc1035::NAME_BUFSIZE * 2 + 64];
+		if(memory.count(make_key(key_buf, full_type, state_key)))
+			return true;
+
 		time_t origin_server_ts;
 		if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
 			return true;
@@ -499,7 +530,7 @@ ircd::net::dns::cache::for_each(const string_view &type,
 		{
 			for(const json::object rr : json::array(content.get("")))
 			{
-				if(expired(rr, ts))
+				if(dns::expired(rr, ts))
 					continue;
 
 				if(!(ret = closure(state_key, rr)))
@@ -511,36 +542,275 @@ ircd::net::dns::cache::for_each(const string_view &type,
 	});
 }
 
+//
+// memory tier
+//
+
+/// Find the answer in memory; on a miss the room is consulted and a hit
+/// there is brought into memory.
+ircd::net::dns::cache::entry
+ircd::net::dns::cache::find(const string_view &type,
+                            const string_view &state_key)
+{
+	char key_buf[rfc1035::NAME_BUFSIZE * 2 + 64];
+	const string_view key
+	{
+		make_key(key_buf, type, state_key)
+	};
+
+	const auto it
+	{
+		memory.find(key)
+	};
+
+	if(it != end(memory))
+		return it->second;
+
+	const m::room::state state
+	{
+		dns_room_id
+	};
+
+	const m::event::idx &event_idx
+	{
+		state.get(std::nothrow, type, state_key)
+	};
+
+	if(!event_idx)
+		return {};
+
+	time_t origin_server_ts;
+	if(!m::get<time_t>(event_idx, "origin_server_ts", origin_server_ts))
+		return {};
+
+	const time_t ts{origin_server_ts / 1000L};
+	m::get(std::nothrow, event_idx, "content", [&type, &state_key, &ts]
+	(const json::object &content)
+	{
+		store(type, state_key, content, ts, false);
+	});
+
+	const auto jt
+	{
+		memory.find(make_key(key_buf, type, state_key))
+	};
+
+	return jt != end(memory)?
+		jt->second:
+		entry{};
+}
+
+/// Set the answer in memory. A fresh answer is marked for the writer to
+/// persist to the room. An answer loaded from the room never replaces one
+/// which arrived while it was being loaded.
 void
-ircd::net::dns::cache::handle(const m::event &event,
-                              m::vm::eval &eval)
-try
+ircd::net::dns::cache::store(const string_view &type,
+                             const string_view &state_key,
+                             const json::object &content,
+                             const time_t &ts,
+                             const bool &write)
 {
-	const string_view &type
+	if(unlikely(memory.size() >= size_t(memory_max)))
+		sweep();
+
+	char key_buf[rfc1035::NAME_BUFSIZE * 2 + 64];
+	const string_view key
 	{
-		json::get<"type"_>(event)
+		make_key(key_buf, type, state_key)
 	};
 
-	if(!startswith(type, "ircd.dns.rrs."))
+	auto it
+	{
+		memory.lower_bound(key)
+	};
+
+	if(it == end(memory) || it->first != key)
+		it = memory.emplace_hint(it, std::string(key), entry{});
+	else if(!write)
 		return;
 
-	const string_view &state_key
+	auto &entry(it->second);
+	entry.content = std::make_shared<const std::string>(content);
+	entry.ts = ts;
+	if(!write || entry.dirty)
+		return;
+
+	entry.dirty = true;
+	++dirty;
+	writer_dock.notify_one();
+}
+
+/// Drop expired answers from memory once it reaches the configured size;
+/// if that isn't enough, persisted answers are dropped until it is. These
+/// are brought back from the room on their next lookup.
+void
+ircd::net::dns::cache::sweep()
+{
+	const size_t before
 	{
-		json::get<"state_key"_>(event)
+		memory.size()
 	};
 
-	const json::array &rrs
+	for(auto it(begin(memory)); it != end(memory);)
+		if(!it->second.dirty && all_expired(json::object(*it->second.content).get(""), it->second.ts))
+			it = memory.erase(it);
+		else
+			++it;
+
+	for(auto it(begin(memory)); it != end(memory) && memory.size() >= size_t(memory_max);)
+		if(!it->second.dirty)
+			it = memory.erase(it);
+		else
+			++it;
+
+	log::debug
+	{
+		log, "cache swept %zu of %zu answers from memory.",
+		before - memory.size(),
+		before,
+	};
+}
+
+/// Persist all fresh answers to the room.
+size_t
+ircd::net::dns::cache::flush()
+{
+	std::vector<std::string> keys;
+	keys.reserve(dirty);
+	for(const auto &[key, entry] : memory)
+		if(entry.dirty)
+			keys.emplace_back(key);
+
+	size_t ret(0);
+	for(const auto &key : keys)
+	{
+		const auto it
+		{
+			memory.find(key)
+		};
+
+		if(it == end(memory) || !it->second.dirty)
+			continue;
+
+		// The content is referenced here; the entry may be replaced while
+		// this yields, in which case it's marked again for the next flush.
+		const auto content
+		{
+			it->second.content
+		};
+
+		it->second.dirty = false;
+		assert(dirty > 0);
+		--dirty;
+		ret += persist(key, *content);
+	}
+
+	if(ret)
+		log::debug
+		{
+			log, "cache persisted %zu of %zu answers to %s",
+			ret,
+			keys.size(),
+			string_view{dns_room_id},
+		};
+
+	return ret;
+}
+
+bool
+ircd::net::dns::cache::persist(const string_view &key,
+                               const std::string &content)
+try
+{
+	const auto &[type, state_key]
+	{
+		split(key, ' ')
+	};
+
+	// Answers are local records; see vm::record_copts.
+	const m::room room
+	{
+		dns_room_id, &m::vm::record_copts
+	};
+
+	if(unlikely(!exists(room)))
+		create(dns_room_id, m::me(), "internal");
+
+	send(room, m::me(), type, state_key, json::object(content));
+	return true;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
 	{
-		json::get<"content"_>(event).get("")
+		log, "cache persist (%s) :%s",
+		key,
+		e.what(),
 	};
 
-	waiter::call(rfc1035::qtype.at(lstrip(type, "ircd.dns.rrs.")), state_key, rrs);
+	return false;
+}
+
+/// Write-behind for the room. Fresh answers are collected for an interval
+/// and then persisted together.
+void
+ircd::net::dns::cache::writer()
+try
+{
+	run::barrier<ctx::interrupted>{};
+	while(1)
+	{
+		writer_dock.wait([]
+		{
+			return dirty > 0;
+		});
+
+		ctx::sleep(seconds(persist_interval));
+		flush();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const ctx::terminated &)
+{
+	return;
 }
 catch(const std::exception &e)
 {
 	log::critical
 	{
-		log, "handle_cached() :%s", e.what()
+		log, "cache writer :%s",
+		e.what(),
+	};
+}
+
+bool
+ircd::net::dns::cache::all_expired(const json::array &rrs,
+                                   const time_t &ts)
+{
+	return std::all_of(begin(rrs), end(rrs), [&ts]
+	(const json::object &rr)
+	{
+		return dns::expired(rr, ts);
+	});
+}
+
+ircd::string_view
+ircd::net::dns::cache::make_key(const mutable_buffer &out,
+                                const string_view &type,
+                                const string_view &state_key)
+{
+	return fmt::sprintf
+	{
+		out, "%s %s",
+		type,
+		state_key,
 	};
 }
 
@@ -10,8 +10,15 @@
 
 namespace ircd::stats
 {
+	static string_view metric_name(const mutable_buffer &, const string_view &);
+	static string_view metric_labels(const mutable_buffer &, const json::object &);
+	static void metrics_histograms(resource::response::chunked &);
+	static void metrics_items(resource::response::chunked &);
+	static resource::response get_metrics(client &, const resource::request &);
 	static resource::response get_stats(client &, const resource::request &);
 
+	extern resource::method metrics_method_get;
+	extern resource metrics_resource;
 	extern resource::method method_get;
 	extern resource stats_resource;
 }
@@ -76,3 +83,236 @@ ircd::stats::get_stats(client &client,
 
 	return std::move(response);
 }
+
+//
+// OpenMetrics
+//
+
+decltype(ircd::stats::metrics_resource)
+ircd::stats::metrics_resource
+{
+	"/metrics",
+	{
+		"OpenMetrics exposition of the items and histograms"
+	}
+};
+
+decltype(ircd::stats::metrics_method_get)
+ircd::stats::metrics_method_get
+{
+	metrics_resource, "GET", get_metrics
+};
+
+ircd::resource::response
+ircd::stats::get_metrics(client &client,
+                         const resource::request &request)
+{
+	resource::response::chunked response
+	{
+		client, http::OK, "application/openmetrics-text; version=1.0.0; charset=utf-8"
+	};
+
+	metrics_items(response);
+	metrics_histograms(response);
+	response.write("# EOF\n"_sv);
+	return std::move(response);
+}
+
+/// Items are given without a type because the collection doesn't
+/// distinguish counters from gauges.
+void
+ircd::stats::metrics_items(resource::response::chunked &response)
+{
+	for(const auto &item : items)
+	{
+		char buf[512], name[128], val[64];
+		const string_view _name
+		{
+			metric_name(name, item->name)
+		};
+
+		const string_view desc
+		{
+			(*item)["desc"]
+		};
+
+		const string_view line
+		{
+			desc?
+				fmt::sprintf
+				{
+					buf, "# TYPE %s unknown\n# HELP %s %s\n%s %s\n",
+					_name,
+					_name,
+					json::string(desc),
+					_name,
+					string(val, *item),
+				}:
+				fmt::sprintf
+				{
+					buf, "# TYPE %s unknown\n%s %s\n",
+					_name,
+					_name,
+					string(val, *item),
+				}
+		};
+
+		response.write(line);
+	}
+}
+
+/// Histograms sharing a name are given together as one family with their
+/// labels; bucket bounds and sums are in seconds.
+void
+ircd::stats::metrics_histograms(resource::response::chunked &response)
+{
+	std::vector<const histogram *> sorted
+	{
+		begin(histograms), end(histograms)
+	};
+
+	std::stable_sort(begin(sorted), end(sorted), []
+	(const auto *const a, const auto *const b)
+	{
+		return a->name < b->name;
+	});
+
+	string_view family;
+	for(const auto *const h : sorted)
+	{
+		char buf[768], name[128], labels[384];
+		const string_view _name
+		{
+			metric_name(name, h->name)
+		};
+
+		if(h->name != family)
+		{
+			family = h->name;
+			response.write(fmt::sprintf
+			{
+				buf, "# TYPE %s histogram\n",
+				_name,
+			});
+		}
+
+		const string_view _labels
+		{
+			metric_labels(labels, h->labels)
+		};
+
+		uint64_t cumulative(0);
+		for(size_t i(0); i < h->BUCKETS; ++i)
+		{
+			cumulative += h->bucket[i];
+			const bool inf
+			{
+				i == h->BUCKETS - 1
+			};
+
+			response.write(inf?
+				fmt::sprintf
+				{
+					buf, "%s_bucket{%s%sle=\"+Inf\"} %lu\n",
+					_name,
+					_labels,
+					_labels? ","_sv: string_view{},
+					cumulative,
+				}:
+				fmt::sprintf
+				{
+					buf, "%s_bucket{%s%sle=\"%.6lf\"} %lu\n",
+					_name,
+					_labels,
+					_labels? ","_sv: string_view{},
+					double(1UL << i) / 1000000.0,
+					cumulative,
+				});
+		}
+
+		response.write(fmt::sprintf
+		{
+			buf, "%s_sum{%s} %.9lf\n%s_count{%s} %lu\n",
+			_name,
+			_labels,
+			duration_cast<std::chrono::duration<double>>(h->sum).count(),
+			_name,
+			_labels,
+			h->count,
+		});
+	}
+}
+
+/// Label values are quoted; the quotes and backslashes within them are
+/// escaped.
+ircd::string_view
+ircd::stats::metric_labels(const mutable_buffer &buf,
+                           const json::object &labels)
+{
+	window_buffer wb{buf};
+	for(const auto &[key, val] : labels)
+	{
+		const json::string _val
+		{
+			val
+		};
+
+		wb([&wb](const mutable_buffer &buf)
+		{
+			return copy(buf, wb.consumed()? ","_sv: string_view{});
+		});
+
+		wb([&key](const mutable_buffer &buf)
+		{
+			return copy(buf, key);
+		});
+
+		wb([](const mutable_buffer &buf)
+		{
+			return copy(buf, "=\""_sv);
+		});
+
+		for(const char &c : _val)
+			wb([&c](const mutable_buffer &buf)
+			{
+				const bool esc(c == '"' || c == '\\');
+				if(size(buf) < 1 + esc)
+					return 0UL;
+
+				size_t i(0);
+				if(esc)
+					buf[i++] = '\\';
+
+				buf[i++] = c;
+				return i;
+			});
+
+		wb([](const mutable_buffer &buf)
+		{
+			return copy(buf, "\""_sv);
+		});
+	}
+
+	return wb.completed();
+}
+
+/// Characters not valid in a metric name are replaced with underscores.
+ircd::string_view
+ircd::stats::metric_name(const mutable_buffer &buf,
+                         const string_view &name)
+{
+	const size_t len
+	{
+		std::min(size(name), size(buf))
+	};
+
+	for(size_t i(0); i < len; ++i)
+		buf[i] = std::isalnum(name[i]) || name[i] == '_' || name[i] == ':'?
+			name[i]:
+			'_';
+
+	return string_view
+	{
+		data(buf), len
+	};
+}
@@ -8,9 +8,24 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_ZLIB_H
+#include <RB_INC_ZSTD_H
+
 using namespace ircd;
 
+/// Pre-loaded representations of a file; the compressed variants are empty
+/// when they would not be smaller than the identity.
+struct asset
+{
+	std::string content_type;
+	std::string etag;
+	std::string identity;
+	std::string gzip;
+	std::string zstd;
+};
+
 std::map<std::string, std::string, iless> files;
+std::map<std::string, asset, iless> assets;
 
 static string_view
 content_type(const mutable_buffer &out, const string_view &filename, const string_view &content);
@@ -21,6 +36,27 @@ get_root(client &client, const resource::request &request);
 resource::response
 non_get_root(client &client, const resource::request &request);
 
+static string_view
+cache_control(const string_view &path);
+
+static bool
+accepts(const resource::request &request, const string_view &coding);
+
+static resource::response
+get_asset(client &client, const resource::request &request, const string_view &path, const asset &asset);
+
+static std::string
+compress_gzip(const string_view &content);
+
+static std::string
+compress_zstd(const string_view &content);
+
+static bool
+compressible(const string_view &content_type);
+
+static void
+init_assets();
+
 static void
 init_files();
 
@@ -87,6 +123,27 @@ root_cache_control_immutable
 	{ "default",    true                                    },
 };
 
+conf::item<bool>
+root_cache_enable
+{
+	{ "name",       "ircd.web.root.cache.enable" },
+	{ "default",    true                         },
+};
+
+conf::item<size_t>
+root_cache_file_max
+{
+	{ "name",       "ircd.web.root.cache.file_max" },
+	{ "default",    long(8_MiB)                    },
+};
+
+conf::item<size_t>
+root_cache_max
+{
+	{ "name",       "ircd.web.root.cache.max" },
+	{ "default",    long(128_MiB)             },
+};
+
 void
 init_files()
 {
@@ -151,6 +208,81 @@ init_files()
 		files.size(),
 		path,
 	};
+
+	if(root_cache_enable)
+		init_assets();
+}
+
+/// Reads the files into memory once with their ETag and compressed variants
+/// so requests are served from one write without touching the filesystem.
+/// Files exceeding the limits are streamed from disk as before.
+void
+init_assets()
+{
+	size_t total(0), identity(0);
+	for(const auto &[relative, absolute] : files)
+	{
+		if(!fs::is_reg(absolute))
+			continue;
+
+		const fs::fd fd
+		{
+			absolute
+		};
+
+		const size_t file_size
+		{
+			size(fd)
+		};
+
+		if(file_size > size_t(root_cache_file_max))
+			continue;
+
+		if(total + file_size > size_t(root_cache_max))
+			continue;
+
+		asset asset;
+		asset.identity = fs::read(fd);
+		if(unlikely(size(asset.identity) != file_size))
+			continue;
+
+		char content_type_buf[64];
+		asset.content_type = content_type(content_type_buf, absolute, asset.identity);
+
+		// The ETag is strong; it's derived from the content so it remains
+		// stable across restarts and between instances serving the same root.
+		const crh::sha256::buf hash
+		{
+			crh::sha256{asset.identity}
+		};
+
+		char etag_buf[32];
+		asset.etag = b64::encode_unpadded<b64::urlsafe>(etag_buf, const_buffer{data(hash), 16});
+
+		if(compressible(asset.content_type))
+		{
+			asset.gzip = compress_gzip(asset.identity);
+			if(size(asset.gzip) >= file_size)
+				asset.gzip.clear();
+
+			asset.zstd = compress_zstd(asset.identity);
+			if(size(asset.zstd) >= file_size)
+				asset.zstd.clear();
+		}
+
+		total += file_size + size(asset.gzip) + size(asset.zstd);
+		identity += file_size;
+		assets.emplace(relative, std::move(asset));
+	}
+
+	log::info
+	{
+		"Web root cached %zu of %zu resources; %zu KiB of files in %zu KiB with encodings.",
+		assets.size(),
+		files.size(),
+		identity / 1024,
+		total / 1024,
+	};
 }
 
 /// This handler exists because the root resource on path "/" catches
@@ -220,6 +352,14 @@ try
 			client, http::NOT_FOUND
 		};
 
+	const auto ait
+	{
+		assets.find(path)
+	};
+
+	if(ait != end(assets))
+		return get_asset(client, request, path, ait->second);
+
 	const auto &file_name
 	{
 		it->second
@@ -245,29 +385,9 @@ try
 		fs::read(fd, buffer)
 	};
 
-	static const string_view &cache_control_immutable
-	{
-		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
-	};
-
-	// Responses from this handler are assumed to be static content by
-	// default. Developers or applications with mutable static content
-	// can disable the header at runtime with this conf item.
 	const string_view &addl_headers
 	{
-		// Don't add this header for index.html otherwise firefox makes really
-		// aggressive assumptions on page-load which are fantastic right until
-		// you upgrade Riot and then all hell breaks loose as your client
-		// straddles between two versions at the same time.
-		path == "index.html"?
-			string_view{}:
-
-		// Add header if conf item allows
-		root_cache_control_immutable?
-			cache_control_immutable:
-
-		// Else don't add header
-			string_view{}
+		cache_control(path)
 	};
 
 	char content_type_buf[64];
@@ -320,6 +440,203 @@ catch(const fs::error &e)
 	};
 }
 
+resource::response
+get_asset(client &client,
+          const resource::request &request,
+          const string_view &path,
+          const asset &asset)
+{
+	const auto &[encoding, content]
+	{
+		!empty(asset.zstd) && accepts(request, "zstd")?
+			std::make_pair("zstd"_sv, string_view{asset.zstd}):
+
+		!empty(asset.gzip) && accepts(request, "gzip")?
+			std::make_pair("gzip"_sv, string_view{asset.gzip}):
+
+			std::make_pair(string_view{}, string_view{asset.identity})
+	};
+
+	// Each encoding is a different representation so it gets its own tag.
+	char etag_buf[64];
+	const string_view etag
+	{
+		fmt::sprintf
+		{
+			etag_buf, "\"%s%s%s\"",
+			asset.etag,
+			!empty(encoding)? "-"_sv: string_view{},
+			encoding,
+		}
+	};
+
+	// If-None-Match uses the weak comparison; a W/ prefix is disregarded.
+	bool match {false};
+	tokens(request.head.if_none_match, ',', [&match, &etag]
+	(const string_view &token) -> bool
+	{
+		const auto &tag
+		{
+			lstrip(strip(token), "W/"_sv)
+		};
+
+		match |= tag == etag || tag == "*";
+		return !match;
+	});
+
+	char headers_buf[256];
+	const string_view headers
+	{
+		fmt::sprintf
+		{
+			headers_buf, "ETag: %s\r\nVary: Accept-Encoding\r\n%s%s%s%s",
+			etag,
+			!empty(encoding)? "Content-Encoding: "_sv: string_view{},
+			encoding,
+			!empty(encoding)? "\r\n"_sv: string_view{},
+			cache_control(path),
+		}
+	};
+
+	if(match)
+		return resource::response
+		{
+			client, http::NOT_MODIFIED, string_view{}, 0UL, headers
+		};
+
+	return resource::response
+	{
+		client,
+		http::OK,
+		asset.content_type,
+		size(content),
+		headers,
+		content,
+	};
+}
+
+/// Responses from this handler are assumed to be static content by default.
+/// Developers or applications with mutable static content can disable the
+/// header at runtime with the conf item.
+string_view
+cache_control(const string_view &path)
+{
+	static const string_view &cache_control_immutable
+	{
+		"Cache-Control: public, max-age=31536000, immutable\r\n"_sv
+	};
+
+	// Don't add this header for index.html otherwise firefox makes really
+	// aggressive assumptions on page-load which are fantastic right until
+	// you upgrade Riot and then all hell breaks loose as your client
+	// straddles between two versions at the same time.
+	if(path == "index.html")
+		return {};
+
+	// Add header if conf item allows
+	if(root_cache_control_immutable)
+		return cache_control_immutable;
+
+	// Else don't add header
+	return {};
+}
+
+/// Whether the request's Accept-Encoding offers the coding; refused with q=0.
+bool
+accepts(const resource::request &request,
+        const string_view &coding)
+{
+	bool ret {false};
+	tokens(request.head.accept_encoding, ',', [&ret, &coding]
+	(const string_view &token) -> bool
+	{
+		const auto &[name, params]
+		{
+			split(token, ';')
+		};
+
+		const auto &[param, qvalue]
+		{
+			split(strip(params), '=')
+		};
+
+		const bool refused
+		{
+			strip(param) == "q" && lex_castable<float>(strip(qvalue)) &&
+			lex_cast<float>(strip(qvalue)) <= 0.0f
+		};
+
+		ret |= iequals(strip(name), coding) && !refused;
+		return !ret;
+	});
+
+	return ret;
+}
+
+/// Already-compressed formats (images, woff, ogg) are not worth another pass.
+bool
+compressible(const string_view &content_type)
+{
+	return startswith(content_type, "text/")
+	|| startswith(content_type, "application/javascript")
+	|| startswith(content_type, "application/json")
+	|| startswith(content_type, "application/wasm")
+	|| startswith(content_type, "application/vnd.ms-fontobject")
+	|| startswith(content_type, "application/font-sfnt")
+	|| startswith(content_type, "image/svg+xml")
+	|| startswith(content_type, "image/x-icon");
+}
+
+/// The variants are made once at load so the highest levels are affordable.
+std::string
+compress_gzip(const string_view &content)
+{
+	#ifdef HAVE_ZLIB_H
+	z_stream z {};
+	// windowBits of 15 + 16 selects the gzip wrapper rather than zlib's.
+	if(deflateInit2(&z, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		return {};
+
+	const unwind deflate_end{[&z]
+	{
+		deflateEnd(&z);
+	}};
+
+	std::string ret(deflateBound(&z, size(content)), char{});
+	z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(content)));
+	z.avail_in = size(content);
+	z.next_out = reinterpret_cast<Bytef *>(ret.data());
+	z.avail_out = size(ret);
+	if(deflate(&z, Z_FINISH) != Z_STREAM_END)
+		return {};
+
+	ret.resize(z.total_out);
+	return ret;
+	#else
+	return {};
+	#endif
+}
+
+std::string
+compress_zstd(const string_view &content)
+{
+	#ifdef HAVE_ZSTD_H
+	std::string ret(ZSTD_compressBound(size(content)), char{});
+	const auto len
+	{
+		ZSTD_compress(ret.data(), size(ret), data(content), size(content), 19)
+	};
+
+	if(ZSTD_isError(len))
+		return {};
+
+	ret.resize(len);
+	return ret;
+	#else
+	return {};
+	#endif
+}
+
 string_view
 content_type(const mutable_buffer &out,
              const string_view &filename,